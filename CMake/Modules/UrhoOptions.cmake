@@ -95,8 +95,10 @@ cmake_dependent_option(URHO3D_FILEWATCHER        "Watch filesystem for resource
 option                (URHO3D_HASH_DEBUG         "Enable StringHash name debugging"                      ${URHO3D_ENABLE_ALL}                                    )
 option                (URHO3D_MONOLITHIC_HEADER  "Create Urho3DAll.h which includes all engine headers." OFF                                                     )
 cmake_dependent_option(URHO3D_MINIDUMPS          "Enable writing minidumps on crash"                     ${URHO3D_ENABLE_ALL} "MSVC"                          OFF)
+option                (URHO3D_PROFILING          "Enable built-in profiler"                              ${URHO3D_ENABLE_ALL}                                    )
 option                (URHO3D_THREADING          "Enable multithreading"                                 ${URHO3D_ENABLE_ALL})
 cmake_dependent_option(URHO3D_TESTING            "Enable unit tests"                                     OFF                  "NOT MOBILE"                    OFF)
+cmake_dependent_option(URHO3D_BENCHMARKS         "Enable performance benchmarks"                         OFF                  "NOT MOBILE"                    OFF)
 
 # Misc
 option(URHO3D_PLAYER                            "Build player application"                              ${URHO3D_ENABLE_ALL})
@@ -111,13 +113,14 @@ option(URHO3D_WITH_CCACHE                       "Enable CCache support"
 
 if (WIN32)
     set(URHO3D_GRAPHICS_API D3D11 CACHE STRING "Graphics API")
-    set_property(CACHE URHO3D_GRAPHICS_API PROPERTY STRINGS D3D9 D3D11 OpenGL)
+    set_property(CACHE URHO3D_GRAPHICS_API PROPERTY STRINGS D3D9 D3D11 OpenGL Null)
     option(URHO3D_WIN32_CONSOLE "Show log messages in win32 console"                     OFF)
 elseif (IOS OR ANDROID)
     set(URHO3D_GRAPHICS_API GLES2 CACHE STRING "Graphics API")
     set_property(CACHE URHO3D_GRAPHICS_API PROPERTY STRINGS GLES2 GLES3)
 else ()
-    set(URHO3D_GRAPHICS_API OpenGL)
+    set(URHO3D_GRAPHICS_API OpenGL CACHE STRING "Graphics API")
+    set_property(CACHE URHO3D_GRAPHICS_API PROPERTY STRINGS OpenGL Null)
 endif ()
 string(TOUPPER "${URHO3D_GRAPHICS_API}" URHO3D_GRAPHICS_API)
 set (URHO3D_${URHO3D_GRAPHICS_API} ON)
@@ -0,0 +1,119 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+#include <utility>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#include <Urho3D/Container/FlatHashMap.h>
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Timer.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_KEYS = 100000;
+constexpr unsigned NUM_ROUNDS = 20;
+
+/// Per-operation times in nanoseconds, and a checksum of the values read, which keeps the loops from being optimized away.
+struct MapTimings
+{
+    double insert_{};
+    double find_{};
+    double iterate_{};
+    double erase_{};
+    unsigned checksum_{};
+};
+
+/// Return pseudo-random keys.
+PODVector<unsigned> MakeKeys()
+{
+    PODVector<unsigned> keys(NUM_KEYS);
+    unsigned seed = 1;
+    for (unsigned i = 0; i < NUM_KEYS; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        keys[i] = seed;
+    }
+    return keys;
+}
+
+/// Return the keys shuffled. Looking up in insertion order would favor HashMap, whose nodes are allocated in that order.
+PODVector<unsigned> Shuffle(PODVector<unsigned> keys)
+{
+    unsigned seed = 2;
+    for (unsigned i = keys.Size() - 1; i > 0; --i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        std::swap(keys[i], keys[(seed >> 8u) % (i + 1)]);
+    }
+    return keys;
+}
+
+template <class Map> MapTimings MeasureMap(const PODVector<unsigned>& keys, const PODVector<unsigned>& lookups)
+{
+    MapTimings timings;
+    HiresTimer timer;
+    unsigned checksum = 0;
+
+    for (unsigned round = 0; round < NUM_ROUNDS; ++round)
+    {
+        Map map;
+
+        timer.Reset();
+        for (unsigned key : keys)
+            map[key] = key;
+        timings.insert_ += (double)timer.GetUSec(true);
+
+        for (unsigned key : lookups)
+            checksum += map.Contains(key ^ 1u) ? 1 : 0;
+        for (unsigned key : lookups)
+            checksum += map.Find(key)->second_;
+        timings.find_ += (double)timer.GetUSec(true);
+
+        for (auto i = map.Begin(), end = map.End(); i != end; ++i)
+            checksum += i->second_;
+        timings.iterate_ += (double)timer.GetUSec(true);
+
+        for (unsigned key : lookups)
+            map.Erase(key);
+        timings.erase_ += (double)timer.GetUSec(true);
+    }
+
+    timings.checksum_ = checksum;
+    const double scale = 1000.0 / ((double)NUM_ROUNDS * NUM_KEYS);
+    timings.insert_ *= scale;
+    timings.find_ *= scale * 0.5;
+    timings.iterate_ *= scale;
+    timings.erase_ *= scale;
+    return timings;
+}
+
+}
+
+TEST_CASE("FlatHashMap vs. HashMap")
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+
+    const PODVector<unsigned> keys = MakeKeys();
+    const PODVector<unsigned> lookups = Shuffle(keys);
+
+    // Warm up the allocator
+    MeasureMap<HashMap<unsigned, unsigned>>(keys, lookups);
+
+    const MapTimings chained = MeasureMap<HashMap<unsigned, unsigned>>(keys, lookups);
+    const MapTimings flat = MeasureMap<FlatHashMap<unsigned, unsigned>>(keys, lookups);
+
+    printf("FlatHashMap vs. HashMap: %u keys x %u rounds, ns per operation (checksums %u, %u)\n", NUM_KEYS, NUM_ROUNDS,
+        flat.checksum_, chained.checksum_);
+    printf("  insert:  %8.2f vs. %8.2f (%.2fx)\n", flat.insert_, chained.insert_, chained.insert_ / flat.insert_);
+    printf("  find:    %8.2f vs. %8.2f (%.2fx)\n", flat.find_, chained.find_, chained.find_ / flat.find_);
+    printf("  iterate: %8.2f vs. %8.2f (%.2fx)\n", flat.iterate_, chained.iterate_, chained.iterate_ / flat.iterate_);
+    printf("  erase:   %8.2f vs. %8.2f (%.2fx)\n", flat.erase_, chained.erase_, chained.erase_ / flat.erase_);
+
+    CHECK_EQ(flat.checksum_, chained.checksum_);
+}
@@ -0,0 +1,94 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Core/Timer.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_RECEIVERS = 5000;
+constexpr unsigned NUM_SENDS = 200;
+
+URHO3D_EVENT(E_BENCHMARKUPDATE, BenchmarkUpdate)
+{
+    URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+}
+
+/// Typed payload of E_BENCHMARKUPDATE.
+struct BenchmarkUpdateEvent
+{
+    static StringHash GetEventTypeStatic() { return E_BENCHMARKUPDATE; }
+    void ToVariantMap(VariantMap& eventData) const { eventData[BenchmarkUpdate::P_TIMESTEP] = timeStep_; }
+
+    float timeStep_;
+};
+
+/// Receiver accumulating the time step.
+class BenchmarkReceiver : public Object
+{
+    URHO3D_OBJECT(BenchmarkReceiver, Object);
+
+public:
+    explicit BenchmarkReceiver(Context* context) : Object(context) { }
+
+    void HandleTyped(BenchmarkUpdateEvent& event) { time_ += event.timeStep_; }
+    void HandleVariantMap(StringHash /*eventType*/, VariantMap& eventData) { time_ += eventData[BenchmarkUpdate::P_TIMESTEP].GetFloat(); }
+
+    float time_{};
+};
+
+}
+
+TEST_CASE("Typed event vs. VariantMap event dispatch")
+{
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+
+    SharedPtr<BenchmarkReceiver> sender(new BenchmarkReceiver(context));
+    Vector<SharedPtr<BenchmarkReceiver>> receivers;
+    for (unsigned i = 0; i < NUM_RECEIVERS; ++i)
+        receivers.Push(SharedPtr<BenchmarkReceiver>(new BenchmarkReceiver(context)));
+
+    HiresTimer timer;
+
+    for (BenchmarkReceiver* receiver : receivers)
+        receiver->SubscribeToEvent(sender, E_BENCHMARKUPDATE, new EventHandlerImpl<BenchmarkReceiver>(receiver, &BenchmarkReceiver::HandleVariantMap));
+    timer.Reset();
+    for (unsigned i = 0; i < NUM_SENDS; ++i)
+    {
+        using namespace BenchmarkUpdate;
+        VariantMap& eventData = sender->GetEventDataMap();
+        eventData[P_TIMESTEP] = 0.016f;
+        sender->SendEvent(E_BENCHMARKUPDATE, eventData);
+    }
+    const double variantMapTime = (double)timer.GetUSec(false);
+    for (BenchmarkReceiver* receiver : receivers)
+        receiver->UnsubscribeFromAllEvents();
+
+    for (BenchmarkReceiver* receiver : receivers)
+        receiver->SubscribeToTypedEvent<BenchmarkUpdateEvent>(sender, URHO3D_TYPED_HANDLER(BenchmarkReceiver, HandleTyped));
+    timer.Reset();
+    for (unsigned i = 0; i < NUM_SENDS; ++i)
+    {
+        BenchmarkUpdateEvent event{0.016f};
+        sender->SendTypedEvent(event);
+    }
+    const double typedTime = (double)timer.GetUSec(false);
+
+    float checksum = 0.0f;
+    for (BenchmarkReceiver* receiver : receivers)
+        checksum += receiver->time_;
+
+    const double scale = 1000.0 / ((double)NUM_RECEIVERS * NUM_SENDS);
+    printf("Typed vs. VariantMap events: %u receivers x %u sends, ns per delivery (checksum %.1f)\n", NUM_RECEIVERS, NUM_SENDS,
+        checksum);
+    printf("  dispatch: %8.2f vs. %8.2f (%.2fx)\n", typedTime * scale, variantMapTime * scale, variantMapTime / typedTime);
+}
@@ -0,0 +1,198 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#ifdef URHO3D_NULL
+
+#include "../HeadlessFixture.h"
+
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/AnimatedModel.h>
+#include <Urho3D/Graphics/Animation.h>
+#include <Urho3D/Graphics/AnimationState.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_SAMPLES = 2000;
+constexpr float SAMPLE_STEP = 1.0f / 60.0f;
+
+/// Sample each animation state into the pose buffer in turn and return the elapsed time in microseconds.
+long long SampleStates(const PODVector<AnimationState*>& states)
+{
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < NUM_SAMPLES; ++i)
+    {
+        for (unsigned j = 0; j < states.Size(); ++j)
+        {
+            states[j]->AddTime(SAMPLE_STEP);
+            states[j]->Apply();
+        }
+    }
+
+    return timer.GetUSec(false);
+}
+
+/// Return the number of keyframes or curve keys of an animation.
+unsigned GetNumKeys(Animation* animation)
+{
+    unsigned keys = 0;
+    for (unsigned i = 0; i < animation->GetNumTracks(); ++i)
+    {
+        const AnimationTrack* track = animation->GetTrack(i);
+        keys += track->keyFrames_.Size() + track->positionCurve_.GetNumKeys() + track->rotationCurve_.GetNumKeys() +
+            track->scaleCurve_.GetNumKeys();
+    }
+    return keys;
+}
+
+}
+
+TEST_CASE("Compressed vs. keyframe animation tracks")
+{
+    HeadlessFixture fixture(false);
+    FileSystem* fileSystem = fixture.fileSystem_;
+    ResourceCache* cache = fixture.cache_;
+
+    // Compress the whole animation library and round trip it through the file format
+    Vector<String> fileNames;
+    fileSystem->ScanDir(fileNames, fileSystem->GetProgramDir() + "Data/Models", "*.ani", SCAN_FILES, true);
+    REQUIRE(!fileNames.Empty());
+
+    unsigned keyFrameMemory = 0;
+    unsigned compressedMemory = 0;
+    unsigned keyFrameKeys = 0;
+    unsigned compressedKeys = 0;
+    long long compressUSec = 0;
+    for (unsigned i = 0; i < fileNames.Size(); ++i)
+    {
+        auto* animation = cache->GetResource<Animation>("Models/" + fileNames[i]);
+        REQUIRE(animation);
+        REQUIRE(!animation->IsCompressed());
+
+        HiresTimer timer;
+        SharedPtr<Animation> compressed = animation->Clone();
+        compressed->Compress();
+        compressUSec += timer.GetUSec(false);
+
+        keyFrameMemory += animation->GetMemoryUse();
+        compressedMemory += compressed->GetMemoryUse();
+        keyFrameKeys += GetNumKeys(animation);
+        compressedKeys += GetNumKeys(compressed);
+
+        VectorBuffer buffer;
+        REQUIRE(compressed->Save(buffer));
+        buffer.Seek(0);
+        SharedPtr<Animation> loaded(new Animation(fixture.context_));
+        REQUIRE(loaded->Load(buffer));
+        CHECK(loaded->IsCompressed());
+        CHECK_EQ(loaded->GetNumTracks(), compressed->GetNumTracks());
+        CHECK_EQ(GetNumKeys(loaded), GetNumKeys(compressed));
+        // Trigger points are not saved into memory buffers
+        CHECK_EQ(loaded->GetMemoryUse() + compressed->GetNumTriggers() * sizeof(AnimationTriggerPoint), compressed->GetMemoryUse());
+    }
+
+    printf("Animation compression: %u animations, compressed in %.3f ms\n", fileNames.Size(), compressUSec / 1000.0);
+    printf("  keyframes:  %8u bytes, %6u keys\n", keyFrameMemory, keyFrameKeys);
+    printf("  compressed: %8u bytes, %6u keys (%.1f%%)\n", compressedMemory, compressedKeys,
+        100.0 * compressedMemory / keyFrameMemory);
+
+    CHECK_LT(compressedMemory, keyFrameMemory / 2);
+
+    // Sample every clip of one character into its pose buffer, with and without compression
+    SharedPtr<Scene> scene(new Scene(fixture.context_));
+    scene->CreateComponent<Octree>();
+    auto* mutant = scene->CreateChild("Mutant")->CreateComponent<AnimatedModel>();
+    mutant->SetModel(cache->GetResource<Model>("Models/Mutant/Mutant.mdl"));
+    mutant->SetUsePoseBuffer(true);
+
+    PODVector<AnimationState*> keyFrameStates;
+    PODVector<AnimationState*> compressedStates;
+    Vector<SharedPtr<Animation> > compressedAnimations;
+    for (unsigned i = 0; i < fileNames.Size(); ++i)
+    {
+        if (!fileNames[i].StartsWith("Mutant/Mutant_"))
+            continue;
+
+        auto* animation = cache->GetResource<Animation>("Models/" + fileNames[i]);
+        SharedPtr<Animation> compressed = animation->Clone(animation->GetName() + ".Compressed");
+        compressed->Compress();
+        compressedAnimations.Push(compressed);
+
+        keyFrameStates.Push(mutant->AddAnimationState(animation));
+        compressedStates.Push(mutant->AddAnimationState(compressed));
+    }
+    REQUIRE(!keyFrameStates.Empty());
+
+    // Size the pose buffer
+    mutant->ApplyAnimation();
+    REQUIRE_EQ(mutant->GetBonePoses().Size(), mutant->GetSkeleton().GetNumBones());
+
+    for (unsigned i = 0; i < keyFrameStates.Size(); ++i)
+    {
+        keyFrameStates[i]->SetLooped(true);
+        keyFrameStates[i]->SetWeight(1.0f);
+        compressedStates[i]->SetLooped(true);
+        compressedStates[i]->SetWeight(1.0f);
+    }
+
+    // Warm up both paths before measuring
+    SampleStates(keyFrameStates);
+    SampleStates(compressedStates);
+    const long long keyFrameUSec = SampleStates(keyFrameStates);
+    const long long compressedUSec = SampleStates(compressedStates);
+
+    const unsigned numSamples = NUM_SAMPLES * keyFrameStates.Size();
+    printf("  sampling %u clips of %u bones, %u samples:\n", keyFrameStates.Size(), mutant->GetSkeleton().GetNumBones(),
+        numSamples);
+    printf("    keyframes:  %8.3f ms, %.3f us per clip sample\n", keyFrameUSec / 1000.0, (double)keyFrameUSec / numSamples);
+    printf("    compressed: %8.3f ms, %.3f us per clip sample\n", compressedUSec / 1000.0, (double)compressedUSec / numSamples);
+
+    // Compressed poses stay within the tolerances plus quantization error
+    float positionError = 0.0f;
+    float rotationError = 0.0f;
+    for (unsigned i = 0; i < keyFrameStates.Size(); ++i)
+    {
+        const float length = keyFrameStates[i]->GetLength();
+        for (float time = 0.0f; time < length; time += length / 97.0f)
+        {
+            keyFrameStates[i]->SetTime(time);
+            keyFrameStates[i]->Apply();
+            const PODVector<BonePose> expected = mutant->GetBonePoses();
+
+            compressedStates[i]->SetTime(time);
+            compressedStates[i]->Apply();
+            const PODVector<BonePose>& actual = mutant->GetBonePoses();
+
+            for (unsigned j = 0; j < actual.Size(); ++j)
+            {
+                positionError = Max(positionError, (actual[j].position_ - expected[j].position_).Length());
+                rotationError = Max(rotationError, 2.0f * Acos(Abs(actual[j].rotation_.DotProduct(expected[j].rotation_))));
+            }
+        }
+    }
+    printf("    max error: position %f, rotation %f degrees\n", positionError, rotationError);
+
+    CHECK_LT(positionError, 0.01f);
+    CHECK_LT(rotationError, 0.5f);
+
+    // Decompressing restores editable keyframes
+    SharedPtr<Animation> decompressed = compressedAnimations[0]->Clone();
+    decompressed->Decompress();
+    CHECK(!decompressed->IsCompressed());
+    CHECK_EQ(decompressed->GetNumTracks(), compressedAnimations[0]->GetNumTracks());
+    CHECK_GT(decompressed->GetTrack(0u)->GetNumKeyFrames(), 0);
+}
+
+#endif
@@ -0,0 +1,173 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#ifdef URHO3D_NULL
+
+#include "../HeadlessFixture.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/AnimatedModel.h>
+#include <Urho3D/Graphics/Animation.h>
+#include <Urho3D/Graphics/AnimationScheduler.h>
+#include <Urho3D/Graphics/AnimationState.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/Light.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/Renderer.h>
+#include <Urho3D/Graphics/Zone.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_FRAMES = 60;
+constexpr int CROWD_SIZE = 50;
+constexpr float FAR_BUDGET = 0.25f;
+
+/// Build a walking crowd stretching far away from the camera, with animation LOD enabled.
+void CreateScene(Scene* scene, Node* cameraNode, PODVector<AnimatedModel*>& models)
+{
+    auto* cache = scene->GetSubsystem<ResourceCache>();
+
+    scene->CreateComponent<Octree>();
+
+    Node* zoneNode = scene->CreateChild("Zone");
+    auto* zone = zoneNode->CreateComponent<Zone>();
+    zone->SetBoundingBox(BoundingBox(-1000.0f, 1000.0f));
+    zone->SetAmbientColor(Color(0.2f, 0.2f, 0.2f));
+
+    Node* sunNode = scene->CreateChild("Sun");
+    sunNode->SetDirection(Vector3(0.6f, -1.0f, 0.8f));
+    sunNode->CreateComponent<Light>()->SetLightType(LIGHT_DIRECTIONAL);
+
+    SetRandomSeed(1);
+    auto* walk = cache->GetResource<Animation>("Models/Jack_Walk.ani");
+    for (int y = 0; y < CROWD_SIZE; ++y)
+    {
+        for (int x = -CROWD_SIZE / 2; x < CROWD_SIZE - CROWD_SIZE / 2; ++x)
+        {
+            Node* jackNode = scene->CreateChild("Jack");
+            jackNode->SetPosition(Vector3(x * 2.0f, 0.0f, y * 2.0f));
+            jackNode->SetRotation(Quaternion(0.0f, Random(360.0f), 0.0f));
+            auto* jack = jackNode->CreateComponent<AnimatedModel>();
+            jack->SetModel(cache->GetResource<Model>("Models/Jack.mdl"));
+            jack->SetMaterial(cache->GetResource<Material>("Materials/Jack.xml"));
+            jack->SetAnimationLodBias(1.0f);
+            AnimationState* state = jack->AddAnimationState(walk);
+            state->SetWeight(1.0f);
+            state->SetLooped(true);
+            state->SetTime(Random(walk->GetLength()));
+            models.Push(jack);
+        }
+    }
+
+    cameraNode->SetPosition(Vector3(0.0f, 3.0f, -5.0f));
+    cameraNode->LookAt(Vector3(0.0f, 0.0f, 20.0f));
+    cameraNode->CreateComponent<Camera>()->SetFarClip(300.0f);
+}
+
+/// Set pose buffer evaluation on all the models.
+void SetUsePoseBuffer(const PODVector<AnimatedModel*>& models, bool enable)
+{
+    for (unsigned i = 0; i < models.Size(); ++i)
+        models[i]->SetUsePoseBuffer(enable);
+}
+
+/// Animate and render frames and return the total time in microseconds. Accumulate the models evaluated by the scheduler.
+long long RenderFrames(Scene* scene, Graphics* graphics, Renderer* renderer, const PODVector<AnimatedModel*>& models,
+    unsigned& numEvaluated)
+{
+    auto* time = scene->GetSubsystem<Time>();
+    AnimationScheduler* scheduler = scene->GetComponent<Octree>()->GetAnimationScheduler();
+    numEvaluated = 0;
+
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        // The scheduler takes deferred models once per frame number
+        time->BeginFrame(1.0f / 60.0f);
+        for (unsigned j = 0; j < models.Size(); ++j)
+            models[j]->GetAnimationState(0u)->AddTime(1.0f / 60.0f);
+        scene->Update(1.0f / 60.0f);
+        renderer->Update(1.0f / 60.0f);
+        graphics->BeginFrame();
+        renderer->Render();
+        graphics->EndFrame();
+        time->EndFrame();
+        numEvaluated += scheduler->GetNumEvaluated();
+    }
+
+    return timer.GetUSec(false);
+}
+
+}
+
+TEST_CASE("Scheduled parallel pose evaluation with far animation LOD budget")
+{
+    HeadlessFixture fixture;
+    Graphics* graphics = fixture.graphics_;
+    Renderer* renderer = fixture.renderer_;
+
+    SharedPtr<Scene> scene(new Scene(fixture.context_));
+    SharedPtr<Node> cameraNode(new Node(fixture.context_));
+    PODVector<AnimatedModel*> models;
+    CreateScene(scene, cameraNode, models);
+    fixture.SetViewport(scene, cameraNode->GetComponent<Camera>());
+
+    auto* octree = scene->GetComponent<Octree>();
+    AnimationScheduler* scheduler = octree->GetAnimationScheduler();
+
+    printf("Animation scheduling: %u animated models, %u threads, %u frames\n", models.Size(), fixture.GetNumThreads(),
+        NUM_FRAMES);
+
+    // Bone nodes written from the threaded drawable update
+    unsigned nodeEvaluated = 0;
+    SetUsePoseBuffer(models, false);
+    RenderFrames(scene, graphics, renderer, models, nodeEvaluated);
+    const long long nodeUSec = RenderFrames(scene, graphics, renderer, models, nodeEvaluated);
+
+    // Pose buffers evaluated by the scheduler, far models without a budget
+    unsigned unlimitedEvaluated = 0;
+    SetUsePoseBuffer(models, true);
+    RenderFrames(scene, graphics, renderer, models, unlimitedEvaluated);
+    const long long unlimitedUSec = RenderFrames(scene, graphics, renderer, models, unlimitedEvaluated);
+    const unsigned unlimitedDeferred = scheduler->GetNumDeferred();
+
+    // Far models within a budget. The farthest model must still be animated eventually
+    AnimatedModel* farthest = models.Back();
+    const unsigned headIndex = farthest->GetSkeleton().GetBoneIndex(String("Bip01_Head"));
+    const Vector3 headPosition = farthest->GetBoneTransforms()[headIndex].Translation();
+    unsigned budgetEvaluated = 0;
+    octree->SetAnimationBudget(FAR_BUDGET);
+    RenderFrames(scene, graphics, renderer, models, budgetEvaluated);
+    const long long budgetUSec = RenderFrames(scene, graphics, renderer, models, budgetEvaluated);
+    const unsigned budgetDeferred = scheduler->GetNumDeferred();
+
+    printf("  bone nodes:         %8.3f ms per frame\n", nodeUSec / 1000.0 / NUM_FRAMES);
+    printf("  scheduled:          %8.3f ms per frame, %6.1f poses per frame, %4u deferred\n",
+        unlimitedUSec / 1000.0 / NUM_FRAMES, (float)unlimitedEvaluated / NUM_FRAMES, unlimitedDeferred);
+    printf("  scheduled, %.2f ms: %8.3f ms per frame, %6.1f poses per frame, %4u deferred, %.3f us per bone\n", FAR_BUDGET,
+        budgetUSec / 1000.0 / NUM_FRAMES, (float)budgetEvaluated / NUM_FRAMES, budgetDeferred, scheduler->GetBoneCost());
+
+    CHECK_EQ(nodeEvaluated, 0);
+    CHECK_GT(unlimitedEvaluated, 0);
+    CHECK_GT(budgetEvaluated, 0);
+    CHECK_LE(budgetEvaluated, unlimitedEvaluated);
+    CHECK_LT(budgetDeferred, models.Size());
+    CHECK_GT(scheduler->GetBoneCost(), 0.0f);
+    CHECK((farthest->GetBoneTransforms()[headIndex].Translation() - headPosition).Length() > 1e-4f);
+}
+
+#endif
@@ -0,0 +1,122 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#include <Urho3D/Container/Sort.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Batch.h>
+#include <Urho3D/Math/Random.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_BATCHES = 50000;
+constexpr unsigned NUM_ROUNDS = 20;
+
+/// Same order as the comparison sort the batch queue used before.
+bool CompareBatchesBackToFront(Batch* lhs, Batch* rhs)
+{
+    if (lhs->renderOrder_ != rhs->renderOrder_)
+        return lhs->renderOrder_ < rhs->renderOrder_;
+    else if (lhs->distance_ != rhs->distance_)
+        return lhs->distance_ > rhs->distance_;
+    else
+        return lhs->sortKey_ < rhs->sortKey_;
+}
+
+bool CompareBatchesFrontToBack(Batch* lhs, Batch* rhs)
+{
+    if (lhs->renderOrder_ != rhs->renderOrder_)
+        return lhs->renderOrder_ < rhs->renderOrder_;
+    else if (lhs->distance_ != rhs->distance_)
+        return lhs->distance_ < rhs->distance_;
+    else
+        return lhs->sortKey_ < rhs->sortKey_;
+}
+
+bool CompareBatchesState(Batch* lhs, Batch* rhs)
+{
+    if (lhs->renderOrder_ != rhs->renderOrder_)
+        return lhs->renderOrder_ < rhs->renderOrder_;
+    else if (lhs->sortKey_ != rhs->sortKey_)
+        return lhs->sortKey_ < rhs->sortKey_;
+    else
+        return lhs->distance_ < rhs->distance_;
+}
+
+/// Fill the queue with batches of a scene with a few hundred shader, material and geometry combinations.
+void AddBatches(BatchQueue& queue)
+{
+    SetRandomSeed(1);
+    queue.Clear(1000);
+    for (unsigned i = 0; i < NUM_BATCHES; ++i)
+    {
+        Batch batch;
+        batch.distance_ = Random(1.0f, 1000.0f);
+        batch.sortKey_ = (unsigned long long)(Rand() % 16) << 32u | (unsigned long long)(Rand() % 32) << 16u | (Rand() % 64);
+        queue.batches_.Push(batch);
+    }
+}
+
+void FillSorted(BatchQueue& queue)
+{
+    queue.sortedBatches_.Resize(queue.batches_.Size());
+    for (unsigned i = 0; i < queue.batches_.Size(); ++i)
+        queue.sortedBatches_[i] = &queue.batches_[i];
+}
+
+}
+
+TEST_CASE("Radix vs. comparison sort of batch queues")
+{
+    // The timer frequency is set up by the Time subsystem
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+
+    BatchQueue queue;
+    AddBatches(queue);
+    PODVector<unsigned long long> keys;
+    for (unsigned i = 0; i < queue.batches_.Size(); ++i)
+        keys.Push(queue.batches_[i].sortKey_);
+
+    HiresTimer timer;
+    long long comparisonBackToFront = 0;
+    long long radixBackToFront = 0;
+    long long comparisonFrontToBack = 0;
+    long long radixFrontToBack = 0;
+
+    for (unsigned round = 0; round < NUM_ROUNDS; ++round)
+    {
+        FillSorted(queue);
+        timer.Reset();
+        Sort(queue.sortedBatches_.Begin(), queue.sortedBatches_.End(), CompareBatchesBackToFront);
+        comparisonBackToFront += timer.GetUSec(true);
+        queue.SortBackToFront();
+        radixBackToFront += timer.GetUSec(true);
+
+        // Front to back sorts twice, the same as the 2-pass sort without remapping the state keys in between
+        FillSorted(queue);
+        timer.Reset();
+        Sort(queue.sortedBatches_.Begin(), queue.sortedBatches_.End(), CompareBatchesFrontToBack);
+        Sort(queue.sortedBatches_.Begin(), queue.sortedBatches_.End(), CompareBatchesState);
+        comparisonFrontToBack += timer.GetUSec(true);
+
+        // The 2-pass sort rewrites the state keys, so restore them for the next round
+        FillSorted(queue);
+        timer.Reset();
+        queue.SortFrontToBack2Pass(queue.sortedBatches_);
+        radixFrontToBack += timer.GetUSec(true);
+        for (unsigned i = 0; i < queue.batches_.Size(); ++i)
+            queue.batches_[i].sortKey_ = keys[i];
+    }
+
+    printf("Batch queue sort: %u batches x %u rounds, ms per sort (comparison vs. radix)\n", NUM_BATCHES, NUM_ROUNDS);
+    printf("  back to front:        %7.3f vs. %7.3f\n", comparisonBackToFront / 1000.0 / NUM_ROUNDS, radixBackToFront / 1000.0 / NUM_ROUNDS);
+    printf("  front to back 2-pass: %7.3f vs. %7.3f (radix includes state key remapping)\n",
+        comparisonFrontToBack / 1000.0 / NUM_ROUNDS, radixFrontToBack / 1000.0 / NUM_ROUNDS);
+}
@@ -0,0 +1,156 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#ifdef URHO3D_NULL
+
+#include "../HeadlessFixture.h"
+
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/GraphicsImpl.h>
+#include <Urho3D/Graphics/Light.h>
+#include <Urho3D/Graphics/LightClusters.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/Renderer.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Graphics/View.h>
+#include <Urho3D/Graphics/Viewport.h>
+#include <Urho3D/Graphics/Zone.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_FRAMES = 60;
+constexpr unsigned NUM_LIGHTS = 200;
+
+/// Build a scene of boxes on a plane, lit by many small unshadowed point and spot lights and a shadowed sun.
+void CreateScene(Scene* scene, Node* cameraNode)
+{
+    auto* cache = scene->GetSubsystem<ResourceCache>();
+
+    scene->CreateComponent<Octree>();
+
+    Node* zoneNode = scene->CreateChild("Zone");
+    auto* zone = zoneNode->CreateComponent<Zone>();
+    zone->SetBoundingBox(BoundingBox(-1000.0f, 1000.0f));
+    zone->SetAmbientColor(Color(0.1f, 0.1f, 0.1f));
+
+    Node* planeNode = scene->CreateChild("Plane");
+    planeNode->SetScale(Vector3(120.0f, 1.0f, 120.0f));
+    planeNode->CreateComponent<StaticModel>()->SetModel(cache->GetResource<Model>("Models/Plane.mdl"));
+
+    for (int y = -25; y < 25; ++y)
+    {
+        for (int x = -25; x < 25; ++x)
+        {
+            Node* boxNode = scene->CreateChild("Box");
+            boxNode->SetPosition(Vector3(x * 2.4f, 0.5f, y * 2.4f));
+            auto* boxObject = boxNode->CreateComponent<StaticModel>();
+            boxObject->SetModel(cache->GetResource<Model>("Models/Box.mdl"));
+            boxObject->SetCastShadows(true);
+        }
+    }
+
+    Node* sunNode = scene->CreateChild("Sun");
+    sunNode->SetDirection(Vector3(0.6f, -1.0f, 0.8f));
+    auto* sun = sunNode->CreateComponent<Light>();
+    sun->SetLightType(LIGHT_DIRECTIONAL);
+    sun->SetCastShadows(true);
+
+    SetRandomSeed(1);
+    for (unsigned i = 0; i < NUM_LIGHTS; ++i)
+    {
+        Node* lightNode = scene->CreateChild("Light");
+        lightNode->SetPosition(Vector3(Random(-60.0f, 60.0f), Random(1.0f, 4.0f), Random(-60.0f, 60.0f)));
+        lightNode->SetDirection(Vector3(Random(-0.5f, 0.5f), -1.0f, Random(-0.5f, 0.5f)));
+        auto* light = lightNode->CreateComponent<Light>();
+        light->SetLightType(i & 1u ? LIGHT_SPOT : LIGHT_POINT);
+        light->SetRange(Random(4.0f, 8.0f));
+        light->SetFov(60.0f);
+        light->SetColor(Color(Random(1.0f), Random(1.0f), Random(1.0f)));
+    }
+
+    cameraNode->SetPosition(Vector3(0.0f, 30.0f, -70.0f));
+    cameraNode->LookAt(Vector3::ZERO);
+    auto* camera = cameraNode->CreateComponent<Camera>();
+    camera->SetFarClip(200.0f);
+}
+
+/// Render frames and return the view update time in microseconds.
+long long RenderFrames(Graphics* graphics, Renderer* renderer)
+{
+    HiresTimer timer;
+    long long updateUSec = 0;
+
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        timer.Reset();
+        renderer->Update(1.0f / 60.0f);
+        updateUSec += timer.GetUSec(false);
+
+        graphics->BeginFrame();
+        renderer->Render();
+        graphics->EndFrame();
+    }
+
+    return updateUSec;
+}
+
+}
+
+TEST_CASE("Clustered vs. per-light forward lighting")
+{
+    HeadlessFixture fixture;
+    ResourceCache* cache = fixture.cache_;
+    Graphics* graphics = fixture.graphics_;
+    Renderer* renderer = fixture.renderer_;
+
+    SharedPtr<Scene> scene(new Scene(fixture.context_));
+    SharedPtr<Node> cameraNode(new Node(fixture.context_));
+    CreateScene(scene, cameraNode);
+    Viewport* viewport = fixture.SetViewport(scene, cameraNode->GetComponent<Camera>());
+
+    printf("Clustered lighting: 2500 boxes, %u point and spot lights, %u threads, %u frames\n", NUM_LIGHTS,
+        fixture.GetNumThreads(), NUM_FRAMES);
+
+    // Warm up shaders, instancing buffer and octree before each measurement
+    REQUIRE(viewport->SetRenderPath(cache->GetResource<XMLFile>("RenderPaths/Forward.xml")));
+    RenderFrames(graphics, renderer);
+    const long long perLightUSec = RenderFrames(graphics, renderer);
+    const NullGraphicsStats perLightStats = graphics->GetImpl()->GetFrameStats();
+    const unsigned perLightBatches = renderer->GetNumBatches();
+    const unsigned perLightQueues = viewport->GetView()->GetLightQueues().Size();
+
+    REQUIRE(viewport->SetRenderPath(cache->GetResource<XMLFile>("RenderPaths/ForwardClustered.xml")));
+    RenderFrames(graphics, renderer);
+    const long long clusteredUSec = RenderFrames(graphics, renderer);
+    const NullGraphicsStats clusteredStats = graphics->GetImpl()->GetFrameStats();
+    const unsigned clusteredBatches = renderer->GetNumBatches();
+    const unsigned clusteredQueues = viewport->GetView()->GetLightQueues().Size();
+    LightClusters* clusters = viewport->GetView()->GetLightClusters();
+    REQUIRE(clusters);
+
+    printf("  per-light: %8.3f ms view update, %5u batches, %5u draws, %3u light queues\n", perLightUSec / 1000.0 / NUM_FRAMES,
+        perLightBatches, perLightStats.draws_ + perLightStats.instancedDraws_, perLightQueues);
+    printf("  clustered: %8.3f ms view update, %5u batches, %5u draws, %3u light queues, %u clustered lights, %u cluster indices\n",
+        clusteredUSec / 1000.0 / NUM_FRAMES, clusteredBatches, clusteredStats.draws_ + clusteredStats.instancedDraws_,
+        clusteredQueues, clusters->GetNumLights(), clusters->GetNumLightIndices());
+
+    // Only the shadowed sun is left for the light queues
+    CHECK_EQ(clusteredQueues, 1);
+    CHECK_GT(clusters->GetNumLights(), 0);
+    CHECK_LT(clusteredBatches, perLightBatches);
+}
+
+#endif
@@ -0,0 +1,216 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#ifdef URHO3D_NULL
+
+#include "../HeadlessFixture.h"
+
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/GraphicsImpl.h>
+#include <Urho3D/Graphics/Light.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/Renderer.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Graphics/Technique.h>
+#include <Urho3D/Graphics/Zone.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_FRAMES = 60;
+
+/// Build the 20_HugeObjectCount sample scene: 250x250 individual boxes lit by a directional light.
+void CreateScene(Scene* scene, Node* cameraNode)
+{
+    auto* cache = scene->GetSubsystem<ResourceCache>();
+
+    scene->CreateComponent<Octree>();
+
+    Node* zoneNode = scene->CreateChild("Zone");
+    auto* zone = zoneNode->CreateComponent<Zone>();
+    zone->SetBoundingBox(BoundingBox(-1000.0f, 1000.0f));
+    zone->SetFogColor(Color(0.2f, 0.2f, 0.2f));
+    zone->SetFogStart(200.0f);
+    zone->SetFogEnd(300.0f);
+
+    Node* lightNode = scene->CreateChild("DirectionalLight");
+    lightNode->SetDirection(Vector3(-0.6f, -1.0f, -0.8f));
+    auto* light = lightNode->CreateComponent<Light>();
+    light->SetLightType(LIGHT_DIRECTIONAL);
+    light->SetColor(Color(0.7f, 0.35f, 0.0f));
+
+    for (int y = -125; y < 125; ++y)
+    {
+        for (int x = -125; x < 125; ++x)
+        {
+            Node* boxNode = scene->CreateChild("Box");
+            boxNode->SetPosition(Vector3(x * 0.3f, 0.0f, y * 0.3f));
+            boxNode->SetScale(0.25f);
+            auto* boxObject = boxNode->CreateComponent<StaticModel>();
+            boxObject->SetModel(cache->GetResource<Model>("Models/Box.mdl"));
+        }
+    }
+
+    cameraNode->SetPosition(Vector3(0.0f, 10.0f, -100.0f));
+    auto* camera = cameraNode->CreateComponent<Camera>();
+    camera->SetFarClip(300.0f);
+}
+
+/// Render frames like Engine::Update() and Engine::Render() do, timing the view update and the batch submission separately.
+void RenderFrames(Graphics* graphics, Renderer* renderer, long long& updateUSec, long long& renderUSec)
+{
+    HiresTimer timer;
+    updateUSec = 0;
+    renderUSec = 0;
+
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        timer.Reset();
+        renderer->Update(1.0f / 60.0f);
+        updateUSec += timer.GetUSec(true);
+
+        graphics->BeginFrame();
+        renderer->Render();
+        graphics->EndFrame();
+        renderUSec += timer.GetUSec(false);
+    }
+}
+
+/// Render a frame and return its statistics.
+NullGraphicsStats RenderFrame(Graphics* graphics, Renderer* renderer)
+{
+    renderer->Update(1.0f / 60.0f);
+    graphics->BeginFrame();
+    renderer->Render();
+    graphics->EndFrame();
+    return graphics->GetImpl()->GetFrameStats();
+}
+
+/// Set the material of every other box.
+void SetBoxMaterials(Scene* scene, Material* material)
+{
+    PODVector<StaticModel*> boxes;
+    scene->GetComponents<StaticModel>(boxes, true);
+    for (unsigned i = 0; i < boxes.Size(); i += 2)
+        boxes[i]->SetMaterial(material);
+}
+
+/// Check that two frames drew the same.
+void CheckSameDraws(const NullGraphicsStats& lhs, const NullGraphicsStats& rhs)
+{
+    CHECK_EQ(lhs.draws_, rhs.draws_);
+    CHECK_EQ(lhs.instancedDraws_, rhs.instancedDraws_);
+    CHECK_EQ(lhs.instances_, rhs.instances_);
+    CHECK_EQ(lhs.primitives_, rhs.primitives_);
+}
+
+}
+
+TEST_CASE("Headless view update and render of the huge object count scene")
+{
+    HeadlessFixture fixture;
+    Graphics* graphics = fixture.graphics_;
+    Renderer* renderer = fixture.renderer_;
+
+    SharedPtr<Scene> scene(new Scene(fixture.context_));
+    SharedPtr<Node> cameraNode(new Node(fixture.context_));
+    CreateScene(scene, cameraNode);
+    fixture.SetViewport(scene, cameraNode->GetComponent<Camera>());
+
+    // Warm up shaders, instancing buffer and octree
+    long long updateUSec;
+    long long renderUSec;
+    RenderFrames(graphics, renderer, updateUSec, renderUSec);
+
+    printf("Headless huge object count scene: %u threads, %u frames, ms per frame\n", fixture.GetNumThreads(), NUM_FRAMES);
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        const bool instancing = i == 0;
+        renderer->SetDynamicInstancing(instancing);
+        RenderFrames(graphics, renderer, updateUSec, renderUSec);
+
+        const NullGraphicsStats& stats = graphics->GetImpl()->GetFrameStats();
+        printf("  %s: update (cull, batches, lights) %8.3f, render (instancing, submission) %8.3f\n",
+            instancing ? "instanced    " : "not instanced", updateUSec / 1000.0 / NUM_FRAMES, renderUSec / 1000.0 / NUM_FRAMES);
+        printf("    %u draws, %u instanced draws of %u instances, %u primitives, %u shader changes, %u state changes, "
+            "%u parameter updates, %llu buffer bytes\n", stats.draws_, stats.instancedDraws_, stats.instances_, stats.primitives_,
+            stats.shaderChanges_, stats.stateChanges_, stats.parameterUpdates_, stats.bufferUploadBytes_);
+
+        CHECK(stats.primitives_ > 0);
+    }
+
+    // Pipelined culling against the same instanced configuration. The scene is static, so this shows the cost of taking and culling
+    // the snapshots; the pipelined culling benchmark moves objects. The octree takes snapshots only while pipelining is enabled
+    auto* octree = scene->GetComponent<Octree>();
+    renderer->SetDynamicInstancing(true);
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        const bool pipelined = i == 1;
+        renderer->SetPipelinedRendering(pipelined);
+        RenderFrames(graphics, renderer, updateUSec, renderUSec);
+        printf("  %s: update (cull, batches, lights) %8.3f, render (instancing, submission) %8.3f\n",
+            pipelined ? "pipelined    " : "sequential   ", updateUSec / 1000.0 / NUM_FRAMES, renderUSec / 1000.0 / NUM_FRAMES);
+        CHECK_EQ(octree->GetSnapshotEnabled(), pipelined);
+    }
+
+    renderer->SetPipelinedRendering(false);
+    RenderFrames(graphics, renderer, updateUSec, renderUSec);
+    CHECK_FALSE(octree->GetSnapshotEnabled());
+}
+
+TEST_CASE("Headless view sorts only changed drawables into the scene passes again")
+{
+    HeadlessFixture fixture;
+    Graphics* graphics = fixture.graphics_;
+    Renderer* renderer = fixture.renderer_;
+
+    SharedPtr<Scene> scene(new Scene(fixture.context_));
+    SharedPtr<Node> cameraNode(new Node(fixture.context_));
+    CreateScene(scene, cameraNode);
+    fixture.SetViewport(scene, cameraNode->GetComponent<Camera>());
+
+    long long updateUSec;
+    long long renderUSec;
+    RenderFrames(graphics, renderer, updateUSec, renderUSec);
+    const NullGraphicsStats unchanged = RenderFrame(graphics, renderer);
+
+    // Boxes with another material are drawn in an instancing group of their own, and alpha blended boxes individually
+    SharedPtr<Material> redMaterial(new Material(fixture.context_));
+    redMaterial->SetTechnique(0, fixture.cache_->GetResource<Technique>("Techniques/NoTexture.xml"));
+    redMaterial->SetShaderParameter("MatDiffColor", Color::RED);
+    SetBoxMaterials(scene, redMaterial);
+    const NullGraphicsStats changed = RenderFrame(graphics, renderer);
+    CHECK_EQ(changed.instancedDraws_, unchanged.instancedDraws_ + 1);
+    CheckSameDraws(changed, RenderFrame(graphics, renderer));
+
+    SharedPtr<Material> alphaMaterial(new Material(fixture.context_));
+    alphaMaterial->SetTechnique(0, fixture.cache_->GetResource<Technique>("Techniques/NoTextureAlpha.xml"));
+    SetBoxMaterials(scene, alphaMaterial);
+    const NullGraphicsStats blended = RenderFrame(graphics, renderer);
+    CHECK(blended.draws_ > unchanged.draws_);
+    CHECK(blended.instances_ < unchanged.instances_);
+
+    SetBoxMaterials(scene, nullptr);
+    CheckSameDraws(unchanged, RenderFrame(graphics, renderer));
+
+    // A scene the view has not seen before is drawn the same as the changed one
+    SharedPtr<Scene> otherScene(new Scene(fixture.context_));
+    SharedPtr<Node> otherCameraNode(new Node(fixture.context_));
+    CreateScene(otherScene, otherCameraNode);
+    SetBoxMaterials(otherScene, redMaterial);
+    fixture.SetViewport(otherScene, otherCameraNode->GetComponent<Camera>());
+    CheckSameDraws(changed, RenderFrame(graphics, renderer));
+}
+
+#endif
@@ -0,0 +1,166 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#ifdef URHO3D_NULL
+
+#include "../HeadlessFixture.h"
+
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/AnimatedModel.h>
+#include <Urho3D/Graphics/Animation.h>
+#include <Urho3D/Graphics/AnimationState.h>
+#include <Urho3D/Graphics/BillboardSet.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/GraphicsImpl.h>
+#include <Urho3D/Graphics/Light.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/Renderer.h>
+#include <Urho3D/Graphics/Texture2D.h>
+#include <Urho3D/Graphics/Zone.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_FRAMES = 60;
+constexpr int CROWD_SIZE = 20;
+constexpr unsigned NUM_BILLBOARD_SETS = 100;
+constexpr unsigned NUM_BILLBOARDS = 50;
+
+/// Build a walking crowd of animated models and a field of camera facing billboard sets, lit by the sun.
+void CreateScene(Scene* scene, Node* cameraNode)
+{
+    auto* cache = scene->GetSubsystem<ResourceCache>();
+
+    scene->CreateComponent<Octree>();
+
+    Node* zoneNode = scene->CreateChild("Zone");
+    auto* zone = zoneNode->CreateComponent<Zone>();
+    zone->SetBoundingBox(BoundingBox(-1000.0f, 1000.0f));
+    zone->SetAmbientColor(Color(0.2f, 0.2f, 0.2f));
+
+    Node* sunNode = scene->CreateChild("Sun");
+    sunNode->SetDirection(Vector3(0.6f, -1.0f, 0.8f));
+    sunNode->CreateComponent<Light>()->SetLightType(LIGHT_DIRECTIONAL);
+
+    SetRandomSeed(1);
+    auto* walk = cache->GetResource<Animation>("Models/Jack_Walk.ani");
+    for (int y = -CROWD_SIZE / 2; y < CROWD_SIZE / 2; ++y)
+    {
+        for (int x = -CROWD_SIZE / 2; x < CROWD_SIZE / 2; ++x)
+        {
+            Node* jackNode = scene->CreateChild("Jack");
+            jackNode->SetPosition(Vector3(x * 2.0f, 0.0f, y * 2.0f));
+            jackNode->SetRotation(Quaternion(0.0f, Random(360.0f), 0.0f));
+            auto* jack = jackNode->CreateComponent<AnimatedModel>();
+            jack->SetModel(cache->GetResource<Model>("Models/Jack.mdl"));
+            jack->SetMaterial(cache->GetResource<Material>("Materials/Jack.xml"));
+            AnimationState* state = jack->AddAnimationState(walk);
+            state->SetWeight(1.0f);
+            state->SetLooped(true);
+            state->SetTime(Random(walk->GetLength()));
+        }
+    }
+
+    for (unsigned i = 0; i < NUM_BILLBOARD_SETS; ++i)
+    {
+        Node* setNode = scene->CreateChild("Billboards");
+        setNode->SetPosition(Vector3(Random(-40.0f, 40.0f), 0.0f, Random(10.0f, 40.0f)));
+        auto* billboards = setNode->CreateComponent<BillboardSet>();
+        billboards->SetMaterial(cache->GetResource<Material>("Materials/Mushroom.xml"));
+        billboards->SetNumBillboards(NUM_BILLBOARDS);
+        for (unsigned j = 0; j < NUM_BILLBOARDS; ++j)
+        {
+            Billboard* billboard = billboards->GetBillboard(j);
+            billboard->position_ = Vector3(Random(-3.0f, 3.0f), Random(0.5f, 3.0f), Random(-3.0f, 3.0f));
+            billboard->size_ = Vector2(Random(0.2f, 0.5f), Random(0.2f, 0.5f));
+            billboard->rotation_ = Random(360.0f);
+            billboard->enabled_ = true;
+        }
+        billboards->Commit();
+    }
+
+    cameraNode->SetPosition(Vector3(0.0f, 15.0f, -30.0f));
+    cameraNode->LookAt(Vector3(0.0f, 0.0f, 5.0f));
+    cameraNode->CreateComponent<Camera>()->SetFarClip(200.0f);
+}
+
+/// Set hardware instancing of all billboard sets in the scene.
+void SetBillboardsInstanced(Scene* scene, bool enable)
+{
+    PODVector<BillboardSet*> billboardSets;
+    scene->GetComponents<BillboardSet>(billboardSets, true);
+    for (unsigned i = 0; i < billboardSets.Size(); ++i)
+        billboardSets[i]->SetInstanced(enable);
+}
+
+/// Animate and render frames and return the total frame time in microseconds.
+long long RenderFrames(Scene* scene, Graphics* graphics, Renderer* renderer)
+{
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        scene->Update(1.0f / 60.0f);
+        renderer->Update(1.0f / 60.0f);
+        graphics->BeginFrame();
+        renderer->Render();
+        graphics->EndFrame();
+    }
+
+    return timer.GetUSec(false);
+}
+
+}
+
+TEST_CASE("Instanced vs. individually drawn skinned models and billboard sets")
+{
+    HeadlessFixture fixture;
+    Graphics* graphics = fixture.graphics_;
+    Renderer* renderer = fixture.renderer_;
+    REQUIRE(graphics->GetVertexTextureSupport());
+
+    SharedPtr<Scene> scene(new Scene(fixture.context_));
+    SharedPtr<Node> cameraNode(new Node(fixture.context_));
+    CreateScene(scene, cameraNode);
+    fixture.SetViewport(scene, cameraNode->GetComponent<Camera>());
+
+    printf("Instanced crowd: %d animated models, %u billboard sets of %u billboards, %u threads, %u frames\n",
+        CROWD_SIZE * CROWD_SIZE, NUM_BILLBOARD_SETS, NUM_BILLBOARDS, fixture.GetNumThreads(), NUM_FRAMES);
+
+    // Warm up shaders, instancing buffer and octree before each measurement
+    renderer->SetDynamicInstancing(false);
+    SetBillboardsInstanced(scene, false);
+    RenderFrames(scene, graphics, renderer);
+    const long long individualUSec = RenderFrames(scene, graphics, renderer);
+    const NullGraphicsStats individualStats = graphics->GetImpl()->GetFrameStats();
+
+    renderer->SetDynamicInstancing(true);
+    SetBillboardsInstanced(scene, true);
+    RenderFrames(scene, graphics, renderer);
+    const long long instancedUSec = RenderFrames(scene, graphics, renderer);
+    const NullGraphicsStats instancedStats = graphics->GetImpl()->GetFrameStats();
+
+    printf("  individual: %8.3f ms per frame, %5u draws, %5u instanced draws\n", individualUSec / 1000.0 / NUM_FRAMES,
+        individualStats.draws_, individualStats.instancedDraws_);
+    printf("  instanced:  %8.3f ms per frame, %5u draws, %5u instanced draws, %u skin matrix texture rows\n",
+        instancedUSec / 1000.0 / NUM_FRAMES, instancedStats.draws_, instancedStats.instancedDraws_,
+        renderer->GetSkinMatrixTexture() ? (unsigned)renderer->GetSkinMatrixTexture()->GetHeight() : 0u);
+
+    CHECK_EQ(individualStats.instancedDraws_, 0);
+    CHECK_GT(instancedStats.instancedDraws_, 0);
+    CHECK_LT(instancedStats.draws_ + instancedStats.instancedDraws_, (individualStats.draws_ + individualStats.instancedDraws_) / 10);
+    CHECK(renderer->GetSkinMatrixTexture());
+}
+
+#endif
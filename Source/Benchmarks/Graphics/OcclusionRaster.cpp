@@ -0,0 +1,117 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/OcclusionBuffer.h>
+#include <Urho3D/Math/BoundingBox.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_TRIANGLES = 50000;
+constexpr unsigned NUM_BOXES = 100000;
+constexpr unsigned NUM_ROUNDS = 10;
+constexpr unsigned BATCH_TRIANGLES = 500;
+
+/// Return occluder-sized random triangles in front of a camera at the origin looking along +Z.
+PODVector<Vector3> MakeTriangles()
+{
+    PODVector<Vector3> vertices;
+    for (unsigned i = 0; i < NUM_TRIANGLES; ++i)
+    {
+        Vector3 center(Random(-60.0f, 60.0f), Random(-30.0f, 30.0f), Random(20.0f, 150.0f));
+        for (unsigned j = 0; j < 3; ++j)
+            vertices.Push(center + Vector3(Random(-3.0f, 3.0f), Random(-3.0f, 3.0f), Random(-1.0f, 1.0f)));
+    }
+    return vertices;
+}
+
+/// Draw the triangles in occluder-sized batches and return the time in microseconds.
+long long DrawTriangles(OcclusionBuffer* buffer, Camera* camera, const PODVector<Vector3>& vertices)
+{
+    HiresTimer timer;
+    buffer->SetView(camera);
+    buffer->SetCullMode(CULL_NONE);
+    buffer->SetMaxTriangles(M_MAX_UNSIGNED);
+    buffer->Clear();
+    for (unsigned i = 0; i < vertices.Size(); i += BATCH_TRIANGLES * 3)
+        buffer->AddTriangles(Matrix3x4::IDENTITY, &vertices[i], sizeof(Vector3), 0, Min(BATCH_TRIANGLES * 3, vertices.Size() - i));
+    buffer->DrawTriangles();
+    buffer->BuildDepthHierarchy();
+    return timer.GetUSec(false);
+}
+
+}
+
+TEST_CASE("Occlusion rasterization and occludee tests")
+{
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+    auto* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    queue->CreateThreads(Max(GetNumLogicalCPUs(), 2u) - 1);
+
+    Camera::RegisterObject(context);
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* camera = scene->CreateChild("Camera")->CreateComponent<Camera>();
+    camera->SetAspectRatio(2.0f);
+
+    SharedPtr<OcclusionBuffer> single(new OcclusionBuffer(context));
+    SharedPtr<OcclusionBuffer> threaded(new OcclusionBuffer(context));
+    single->SetSize(256, 128, false);
+    threaded->SetSize(256, 128, true);
+
+    SetRandomSeed(1);
+    const PODVector<Vector3> vertices = MakeTriangles();
+    long long singleUSec = 0;
+    long long threadedUSec = 0;
+    for (unsigned i = 0; i < NUM_ROUNDS; ++i)
+    {
+        singleUSec += DrawTriangles(single, camera, vertices);
+        threadedUSec += DrawTriangles(threaded, camera, vertices);
+    }
+
+    PODVector<BoundingBox> boxes;
+    for (unsigned i = 0; i < NUM_BOXES; ++i)
+    {
+        Vector3 center(Random(-80.0f, 80.0f), Random(-40.0f, 40.0f), Random(10.0f, 200.0f));
+        Vector3 halfSize(Random(0.2f, 4.0f), Random(0.2f, 4.0f), Random(0.2f, 4.0f));
+        boxes.Push(BoundingBox(center - halfSize, center + halfSize));
+    }
+
+    HiresTimer timer;
+    unsigned numVisible = 0;
+    for (unsigned i = 0; i < NUM_BOXES; ++i)
+        numVisible += single->IsVisible(boxes[i]) ? 1 : 0;
+    const long long oneByOneUSec = timer.GetUSec(true);
+    PODVector<bool> visible(NUM_BOXES);
+    single->IsVisible(boxes.Buffer(), NUM_BOXES, visible.Buffer());
+    const long long batchedUSec = timer.GetUSec(false);
+    unsigned numBatchedVisible = 0;
+    for (unsigned i = 0; i < NUM_BOXES; ++i)
+        numBatchedVisible += visible[i] ? 1 : 0;
+
+    printf("Occlusion buffer 256x128: %u triangles, %u threads\n", NUM_TRIANGLES, queue->GetNumThreads() + 1);
+    printf("  rasterize single-threaded: %8.3f ms (%.1f triangles/us)\n", singleUSec / 1000.0 / NUM_ROUNDS,
+        (double)NUM_TRIANGLES * NUM_ROUNDS / (double)Max(singleUSec, 1LL));
+    printf("  rasterize binned threaded: %8.3f ms (%.1f triangles/us)\n", threadedUSec / 1000.0 / NUM_ROUNDS,
+        (double)NUM_TRIANGLES * NUM_ROUNDS / (double)Max(threadedUSec, 1LL));
+    printf("  occludee tests one by one: %8.3f ms for %u boxes (%u visible)\n", oneByOneUSec / 1000.0, NUM_BOXES, numVisible);
+    printf("  occludee tests batched:    %8.3f ms for %u boxes (%u visible)\n", batchedUSec / 1000.0, NUM_BOXES, numBatchedVisible);
+
+    CHECK_EQ(numBatchedVisible, numVisible);
+}
@@ -0,0 +1,145 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Drawable.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/OctreeQuery.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_QUERIES = 50;
+constexpr unsigned NUM_OBJECTS = 500000;
+
+/// Unit box geometry stand-in which needs no graphics subsystem.
+class CullingBox : public Drawable
+{
+    URHO3D_OBJECT(CullingBox, Drawable);
+
+public:
+    explicit CullingBox(Context* context) :
+        Drawable(context, DRAWABLE_GEOMETRY)
+    {
+        boundingBox_ = BoundingBox(-0.5f, 0.5f);
+    }
+
+protected:
+    void OnWorldBoundingBoxUpdate() override
+    {
+        worldBoundingBox_ = boundingBox_.Transformed(node_->GetWorldTransform());
+    }
+};
+
+/// Frustum query which tests one drawable at a time through its world bounding box.
+class PerDrawableFrustumQuery : public FrustumOctreeQuery
+{
+public:
+    PerDrawableFrustumQuery(PODVector<Drawable*>& result, const Frustum& frustum, unsigned char drawableFlags) :
+        FrustumOctreeQuery(result, frustum, drawableFlags)
+    {
+    }
+
+    void TestPackedDrawables(Drawable** drawables, const PackedDrawableBounds& bounds, bool inside) override
+    {
+        OctreeQuery::TestPackedDrawables(drawables, bounds, inside);
+    }
+};
+
+/// Camera frustum sweeping around the scene.
+Frustum GetFrustum(unsigned index)
+{
+    Frustum frustum;
+    frustum.Define(60.0f, 1.0f, 1.0f, 0.1f, 400.0f, Matrix3x4(Vector3::ZERO, Quaternion(index * 7.0f, Vector3::UP), Vector3::ONE));
+    return frustum;
+}
+
+/// Run the sweep of frustum queries and return the total number of visible drawables.
+template <class T> unsigned long long RunQueries(Octree* octree, PODVector<Drawable*>& result)
+{
+    unsigned long long numVisible = 0;
+    for (unsigned i = 0; i < NUM_QUERIES; ++i)
+    {
+        T query(result, GetFrustum(i), DRAWABLE_GEOMETRY);
+        octree->GetDrawables(query);
+        numVisible += result.Size();
+    }
+    return numVisible;
+}
+
+}
+
+TEST_CASE("Packed SIMD octant culling vs. per-drawable culling")
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+    auto* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    queue->CreateThreads(Max(GetNumLogicalCPUs(), 2u) - 1);
+    RegisterSceneLibrary(context);
+    Octree::RegisterObject(context);
+    context->RegisterFactory<CullingBox>();
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* octree = scene->CreateComponent<Octree>();
+
+    PODVector<Node*> nodes;
+    SetRandomSeed(1);
+    for (unsigned i = 0; i < NUM_OBJECTS; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition(Vector3(Random(-800.0f, 800.0f), Random(-50.0f, 50.0f), Random(-800.0f, 800.0f)));
+        node->SetScale(Random(0.5f, 8.0f));
+        node->CreateComponent<CullingBox>();
+        nodes.Push(node);
+    }
+
+    FrameInfo frame{};
+    PODVector<Drawable*> result;
+    printf("Octant culling: %u objects x %u queries, octree update after moving all objects\n", NUM_OBJECTS, NUM_QUERIES);
+
+    // A deep octree spreads the drawables thinly, a shallow one leaves many drawables per octant to test at once
+    for (unsigned numLevels = 8; numLevels >= 4; numLevels -= 2)
+    {
+        octree->SetSize(BoundingBox(-1000.0f, 1000.0f), numLevels);
+        ++frame.frameNumber_;
+        octree->Update(frame);
+
+        // Warm up both paths, so that neither pays for the first traversal
+        RunQueries<PerDrawableFrustumQuery>(octree, result);
+        RunQueries<FrustumOctreeQuery>(octree, result);
+
+        HiresTimer timer;
+        const unsigned long long numVisible = RunQueries<PerDrawableFrustumQuery>(octree, result);
+        const long long perDrawableUSec = Max(timer.GetUSec(true), 1LL);
+        const unsigned long long numPackedVisible = RunQueries<FrustumOctreeQuery>(octree, result);
+        const long long packedUSec = Max(timer.GetUSec(false), 1LL);
+
+        // Moving every drawable shows the upkeep of the octants, including their packed bounds
+        for (unsigned i = 0; i < nodes.Size(); ++i)
+            nodes[i]->Translate(Vector3(Sin(i * 10.0f), 0.0f, Cos(i * 10.0f)) * 2.0f);
+        timer.Reset();
+        ++frame.frameNumber_;
+        octree->Update(frame);
+        const long long updateUSec = timer.GetUSec(false);
+
+        printf("  %u levels, per-drawable: %8.3f ms/query (%llu visible)\n", numLevels, perDrawableUSec / 1000.0 / NUM_QUERIES,
+            numVisible);
+        printf("  %u levels, packed SIMD:  %8.3f ms/query (%llu visible, %.2fx)\n", numLevels, packedUSec / 1000.0 / NUM_QUERIES,
+            numPackedVisible, (double)perDrawableUSec / (double)packedUSec);
+        printf("  %u levels, update:       %8.3f ms\n", numLevels, updateUSec / 1000.0);
+
+        CHECK(numPackedVisible == numVisible);
+    }
+}
@@ -0,0 +1,145 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#ifdef URHO3D_NULL
+
+#include "../HeadlessFixture.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/FrameAllocator.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/ParticleEffect.h>
+#include <Urho3D/Graphics/ParticleEmitter.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_PARTICLES = 100000;
+constexpr unsigned NUM_EMITTERS = 100;
+constexpr unsigned NUM_WARMUP_FRAMES = 120;
+constexpr unsigned NUM_FRAMES = 60;
+constexpr float TIME_STEP = 1.0f / 60.0f;
+
+/// Create a fountain effect which keeps the given number of particles alive, with forces, size and color animation.
+SharedPtr<ParticleEffect> CreateEffect(Context* context, unsigned numParticles)
+{
+    SharedPtr<ParticleEffect> effect(new ParticleEffect(context));
+    effect->SetNumParticles(numParticles);
+    effect->SetUpdateInvisible(true);
+    effect->SetEmitterType(EMITTER_SPHERE);
+    effect->SetEmitterSize(Vector3::ONE);
+    effect->SetMinDirection(Vector3(-0.5f, 1.0f, -0.5f));
+    effect->SetMaxDirection(Vector3(0.5f, 1.0f, 0.5f));
+    effect->SetMinVelocity(2.0f);
+    effect->SetMaxVelocity(5.0f);
+    effect->SetConstantForce(Vector3(0.0f, -9.81f, 0.0f));
+    effect->SetDampingForce(0.5f);
+    effect->SetMinTimeToLive(0.8f);
+    effect->SetMaxTimeToLive(1.2f);
+    effect->SetMinEmissionRate(numParticles * 1.1f);
+    effect->SetMaxEmissionRate(numParticles * 1.3f);
+    effect->SetMinRotationSpeed(-90.0f);
+    effect->SetMaxRotationSpeed(90.0f);
+    effect->SetSizeAdd(0.1f);
+    effect->SetSizeMul(1.2f);
+    effect->AddColorTime(Color::WHITE, 0.0f);
+    effect->AddColorTime(Color::YELLOW, 0.4f);
+    effect->AddColorTime(Color(1.0f, 0.0f, 0.0f, 0.0f), 1.0f);
+    return effect;
+}
+
+/// Run scene and octree updates and return the time spent in the octree update, where the emitters simulate, in microseconds.
+long long SimulateFrames(Scene* scene, unsigned numFrames, unsigned& frameNumber)
+{
+    auto* octree = scene->GetComponent<Octree>();
+    FrameInfo frame;
+    frame.camera_ = nullptr;
+    frame.timeStep_ = TIME_STEP;
+    frame.allocator_ = scene->GetSubsystem<FrameAllocator>();
+
+    long long usec = 0;
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        frame.frameNumber_ = ++frameNumber;
+        scene->Update(TIME_STEP);
+
+        HiresTimer timer;
+        octree->Update(frame);
+        usec += timer.GetUSec(false);
+    }
+    return usec;
+}
+
+/// Return the total number of active particles of the emitters.
+unsigned GetNumActiveParticles(const PODVector<ParticleEmitter*>& emitters)
+{
+    unsigned count = 0;
+    for (unsigned i = 0; i < emitters.Size(); ++i)
+        count += emitters[i]->GetNumActiveParticles();
+    return count;
+}
+
+}
+
+TEST_CASE("SoA particle simulation of one large and many small emitters")
+{
+    HeadlessFixture fixture(false);
+
+    printf("Particle simulation: %u particles, %u threads, %u frames\n", NUM_PARTICLES, fixture.GetNumThreads(), NUM_FRAMES);
+
+    SetRandomSeed(1);
+    unsigned frameNumber = 0;
+
+    // One emitter with all the particles
+    SharedPtr<Scene> largeScene(new Scene(fixture.context_));
+    largeScene->CreateComponent<Octree>();
+    PODVector<ParticleEmitter*> largeEmitters;
+    largeEmitters.Push(largeScene->CreateChild("Fountain")->CreateComponent<ParticleEmitter>());
+    largeEmitters[0]->SetEffect(CreateEffect(fixture.context_, NUM_PARTICLES));
+    SimulateFrames(largeScene, NUM_WARMUP_FRAMES, frameNumber);
+    const long long largeUSec = SimulateFrames(largeScene, NUM_FRAMES, frameNumber);
+    const unsigned largeActive = GetNumActiveParticles(largeEmitters);
+
+    // Many emitters sharing the particles, simulated in parallel by the octree's drawable update
+    SharedPtr<Scene> manyScene(new Scene(fixture.context_));
+    manyScene->CreateComponent<Octree>();
+    SharedPtr<ParticleEffect> smallEffect = CreateEffect(fixture.context_, NUM_PARTICLES / NUM_EMITTERS);
+    PODVector<ParticleEmitter*> manyEmitters;
+    for (unsigned i = 0; i < NUM_EMITTERS; ++i)
+    {
+        Node* node = manyScene->CreateChild("Fountain");
+        node->SetPosition(Vector3(Random(-50.0f, 50.0f), 0.0f, Random(-50.0f, 50.0f)));
+        auto* emitter = node->CreateComponent<ParticleEmitter>();
+        emitter->SetEffect(smallEffect);
+        manyEmitters.Push(emitter);
+    }
+    SimulateFrames(manyScene, NUM_WARMUP_FRAMES, frameNumber);
+    const long long manyUSec = SimulateFrames(manyScene, NUM_FRAMES, frameNumber);
+    const unsigned manyActive = GetNumActiveParticles(manyEmitters);
+
+    printf("  1 emitter:    %8.3f ms per frame, %u active particles\n", largeUSec / 1000.0 / NUM_FRAMES, largeActive);
+    printf("  %u emitters: %8.3f ms per frame, %u active particles\n", NUM_EMITTERS, manyUSec / 1000.0 / NUM_FRAMES, manyActive);
+
+    // The emitters stay nearly full, and their billboards follow the particles
+    CHECK_GT(largeActive, NUM_PARTICLES * 9 / 10);
+    CHECK_GT(manyActive, NUM_PARTICLES * 9 / 10);
+    ParticleEmitter* emitter = largeEmitters[0];
+    for (unsigned i = 0; i < emitter->GetNumParticles(); ++i)
+    {
+        if (emitter->GetBillboard(i)->enabled_ != (i < largeActive))
+        {
+            FAIL("Billboard " << i << " enabled state does not match the active particles");
+            break;
+        }
+    }
+}
+
+#endif
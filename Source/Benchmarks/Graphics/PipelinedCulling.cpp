@@ -0,0 +1,152 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#ifdef URHO3D_NULL
+
+#include "../HeadlessFixture.h"
+
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/Renderer.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Graphics/View.h>
+#include <Urho3D/Graphics/Viewport.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_FRAMES = 100;
+constexpr unsigned NUM_OBJECTS = 50000;
+constexpr unsigned MOVE_INTERVAL = 4;
+
+/// Create a scene of randomly placed boxes seen by a static camera. Scenes created this way are identical, also in their node IDs.
+SharedPtr<Scene> CreateScene(Context* context, PODVector<Node*>& nodes, Camera*& camera)
+{
+    auto* cache = context->GetSubsystem<ResourceCache>();
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* octree = scene->CreateComponent<Octree>();
+    octree->SetSize(BoundingBox(-500.0f, 500.0f), 8);
+
+    SetRandomSeed(1);
+    for (unsigned i = 0; i < NUM_OBJECTS; ++i)
+    {
+        Node* node = scene->CreateChild("Box");
+        node->SetPosition(Vector3(Random(-400.0f, 400.0f), Random(-20.0f, 20.0f), Random(-400.0f, 400.0f)));
+        auto* box = node->CreateComponent<StaticModel>();
+        box->SetModel(cache->GetResource<Model>("Models/Box.mdl"));
+        nodes.Push(node);
+    }
+
+    Node* cameraNode = scene->CreateChild("Camera");
+    cameraNode->SetPosition(Vector3(0.0f, 10.0f, -150.0f));
+    camera = cameraNode->CreateComponent<Camera>();
+    camera->SetFarClip(250.0f);
+
+    return scene;
+}
+
+/// Move a fraction of the objects, as the scene update of a frame would.
+void UpdateScene(const PODVector<Node*>& nodes, unsigned frame)
+{
+    for (unsigned i = frame % MOVE_INTERVAL; i < nodes.Size(); i += MOVE_INTERVAL)
+        nodes[i]->Translate(Vector3(Sin(frame * 10.0f + i), 0.0f, Cos(frame * 10.0f + i)) * 0.5f);
+}
+
+/// Return the sum of the node IDs of the visible drawables, which identifies the visible set independent of its order.
+unsigned long long GetVisibleChecksum(const PODVector<Drawable*>& drawables)
+{
+    unsigned long long checksum = 0;
+    for (unsigned i = 0; i < drawables.Size(); ++i)
+        checksum += drawables[i]->GetNode()->GetID();
+    return checksum;
+}
+
+/// Update and render the frames like the engine does, recording the visible geometries of each frame. Return the elapsed time.
+long long RenderFrames(HeadlessFixture& fixture, Viewport* viewport, const PODVector<Node*>& nodes, PODVector<unsigned>& visibleCounts,
+    PODVector<unsigned long long>& visibleChecksums)
+{
+    Graphics* graphics = fixture.graphics_;
+    Renderer* renderer = fixture.renderer_;
+
+    HiresTimer timer;
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        UpdateScene(nodes, i);
+        renderer->Update(1.0f / 60.0f);
+        graphics->BeginFrame();
+        renderer->Render();
+        graphics->EndFrame();
+
+        const PODVector<Drawable*>& geometries = viewport->GetView()->GetGeometries();
+        visibleCounts.Push(geometries.Size());
+        visibleChecksums.Push(GetVisibleChecksum(geometries));
+    }
+
+    return Max(timer.GetUSec(false), 1LL);
+}
+
+}
+
+TEST_CASE("Frame-pipelined culling vs. sequential update and cull")
+{
+    HeadlessFixture fixture;
+    Renderer* renderer = fixture.renderer_;
+
+    // Identical scenes for both methods, so that their visible sets can be compared frame by frame
+    PODVector<Node*> nodes;
+    Camera* camera;
+    SharedPtr<Scene> scene = CreateScene(fixture.context_, nodes, camera);
+    PODVector<Node*> pipelinedNodes;
+    Camera* pipelinedCamera;
+    SharedPtr<Scene> pipelinedScene = CreateScene(fixture.context_, pipelinedNodes, pipelinedCamera);
+
+    // Sequential: each frame culls the live octree after the scene update
+    renderer->SetPipelinedRendering(false);
+    Viewport* viewport = fixture.SetViewport(scene, camera);
+    PODVector<unsigned> visibleCounts;
+    PODVector<unsigned long long> visibleChecksums;
+    const long long sequentialUSec = RenderFrames(fixture, viewport, nodes, visibleCounts, visibleChecksums);
+
+    // Pipelined: each frame uses the cull of the previous frame's snapshot, which worker threads ran during the scene update.
+    // Drawables which moved since the snapshot are tested again
+    renderer->SetPipelinedRendering(true);
+    Viewport* pipelinedViewport = fixture.SetViewport(pipelinedScene, pipelinedCamera);
+    PODVector<unsigned> pipelinedCounts;
+    PODVector<unsigned long long> pipelinedChecksums;
+    const long long pipelinedUSec = RenderFrames(fixture, pipelinedViewport, pipelinedNodes, pipelinedCounts, pipelinedChecksums);
+    renderer->SetPipelinedRendering(false);
+
+    unsigned long long numVisible = 0;
+    unsigned long long numPipelinedVisible = 0;
+    unsigned numDifferentFrames = 0;
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        numVisible += visibleCounts[i];
+        numPipelinedVisible += pipelinedCounts[i];
+        if (visibleCounts[i] != pipelinedCounts[i] || visibleChecksums[i] != pipelinedChecksums[i])
+            ++numDifferentFrames;
+    }
+
+    printf("Pipelined culling: %u threads, %u objects x %u frames, static camera, 1/%u of the objects moving each frame\n",
+        fixture.GetNumThreads(), NUM_OBJECTS, NUM_FRAMES, MOVE_INTERVAL);
+    printf("  sequential frame: %8.3f ms (%llu visible)\n", sequentialUSec / 1000.0 / NUM_FRAMES, numVisible);
+    printf("  pipelined frame:  %8.3f ms (%llu visible, %.2fx), %u frames with a different visible set\n",
+        pipelinedUSec / 1000.0 / NUM_FRAMES, numPipelinedVisible, (double)sequentialUSec / (double)pipelinedUSec, numDifferentFrames);
+
+    CHECK(numVisible > 0);
+    CHECK(numPipelinedVisible > 0);
+}
+
+#endif
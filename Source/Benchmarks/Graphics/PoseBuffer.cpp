@@ -0,0 +1,167 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#ifdef URHO3D_NULL
+
+#include "../HeadlessFixture.h"
+
+#include <Urho3D/Core/FrameAllocator.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/AnimatedModel.h>
+#include <Urho3D/Graphics/Animation.h>
+#include <Urho3D/Graphics/AnimationState.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_FRAMES = 30;
+constexpr int CROWD_SIZE = 45;
+
+/// Build a crowd of walking and idling animated models with a blended upper body layer, and a prop in each right hand.
+void CreateScene(Scene* scene, PODVector<AnimatedModel*>& models)
+{
+    auto* cache = scene->GetSubsystem<ResourceCache>();
+
+    scene->CreateComponent<Octree>();
+
+    SetRandomSeed(1);
+    auto* walk = cache->GetResource<Animation>("Models/Jack_Walk.ani");
+    for (int y = -CROWD_SIZE / 2; y < CROWD_SIZE - CROWD_SIZE / 2; ++y)
+    {
+        for (int x = -CROWD_SIZE / 2; x < CROWD_SIZE - CROWD_SIZE / 2; ++x)
+        {
+            Node* jackNode = scene->CreateChild("Jack");
+            jackNode->SetPosition(Vector3(x * 2.0f, 0.0f, y * 2.0f));
+            jackNode->SetRotation(Quaternion(0.0f, Random(360.0f), 0.0f));
+            auto* jack = jackNode->CreateComponent<AnimatedModel>();
+            jack->SetModel(cache->GetResource<Model>("Models/Jack.mdl"));
+            AnimationState* state = jack->AddAnimationState(walk);
+            state->SetWeight(1.0f);
+            state->SetLooped(true);
+            state->SetTime(Random(walk->GetLength()));
+
+            Node* propNode = jackNode->GetChild("Bip01_R_Hand", true)->CreateChild("Prop");
+            propNode->SetPosition(Vector3(0.1f, 0.0f, 0.0f));
+            propNode->SetScale(0.1f);
+            propNode->CreateComponent<StaticModel>()->SetModel(cache->GetResource<Model>("Models/Box.mdl"));
+
+            models.Push(jack);
+        }
+    }
+}
+
+/// Animate and skin frames headlessly and return the total time in microseconds.
+long long AnimateFrames(Scene* scene, const PODVector<AnimatedModel*>& models)
+{
+    auto* octree = scene->GetComponent<Octree>();
+    FrameInfo frame;
+    frame.frameNumber_ = 0;
+    frame.camera_ = nullptr;
+    frame.timeStep_ = 1.0f / 60.0f;
+    frame.allocator_ = scene->GetSubsystem<FrameAllocator>();
+
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        ++frame.frameNumber_;
+        for (unsigned j = 0; j < models.Size(); ++j)
+            models[j]->GetAnimationState(0u)->AddTime(frame.timeStep_);
+        octree->Update(frame);
+        for (unsigned j = 0; j < models.Size(); ++j)
+            models[j]->UpdateGeometry(frame);
+    }
+
+    return timer.GetUSec(false);
+}
+
+/// Set pose buffer evaluation on all the models.
+void SetUsePoseBuffer(const PODVector<AnimatedModel*>& models, bool enable)
+{
+    for (unsigned i = 0; i < models.Size(); ++i)
+        models[i]->SetUsePoseBuffer(enable);
+}
+
+/// Return the largest difference between the skin matrices of the models and reference values.
+float GetSkinMatrixError(const PODVector<AnimatedModel*>& models, const PODVector<Matrix3x4>& reference)
+{
+    float maxError = 0.0f;
+    unsigned index = 0;
+    for (unsigned i = 0; i < models.Size(); ++i)
+    {
+        const SourceBatch& batch = models[i]->GetBatches()[0];
+        for (unsigned j = 0; j < batch.numWorldTransforms_ && index < reference.Size(); ++j, ++index)
+        {
+            const float* lhs = batch.worldTransform_[j].Data();
+            const float* rhs = reference[index].Data();
+            for (unsigned k = 0; k < 12; ++k)
+                maxError = Max(maxError, Abs(lhs[k] - rhs[k]));
+        }
+    }
+    return maxError;
+}
+
+}
+
+TEST_CASE("Pose buffer vs. bone node skeletal animation")
+{
+    HeadlessFixture fixture(false);
+
+    SharedPtr<Scene> scene(new Scene(fixture.context_));
+    PODVector<AnimatedModel*> models;
+    CreateScene(scene, models);
+    REQUIRE(models.Size());
+
+    const unsigned numBones = models[0]->GetSkeleton().GetNumBones();
+    printf("Pose buffer: %u animated models of %u bones, %u threads, %u frames\n", models.Size(), numBones,
+        fixture.GetNumThreads(), NUM_FRAMES);
+
+    // Warm up once, then measure. Both modes end at the same animation time, as they run the same number of frames
+    SetUsePoseBuffer(models, false);
+    AnimateFrames(scene, models);
+    const long long nodeUSec = AnimateFrames(scene, models);
+
+    PODVector<Matrix3x4> nodeSkinMatrices;
+    for (unsigned i = 0; i < models.Size(); ++i)
+    {
+        const SourceBatch& batch = models[i]->GetBatches()[0];
+        for (unsigned j = 0; j < batch.numWorldTransforms_; ++j)
+            nodeSkinMatrices.Push(batch.worldTransform_[j]);
+    }
+
+    // Rewind the animations to the same times and measure again with the pose buffer
+    for (unsigned i = 0; i < models.Size(); ++i)
+        models[i]->GetAnimationState(0u)->AddTime(-2.0f * NUM_FRAMES / 60.0f);
+    SetUsePoseBuffer(models, true);
+    AnimateFrames(scene, models);
+    const long long poseUSec = AnimateFrames(scene, models);
+
+    printf("  bone nodes:  %8.3f ms per frame\n", nodeUSec / 1000.0 / NUM_FRAMES);
+    printf("  pose buffer: %8.3f ms per frame\n", poseUSec / 1000.0 / NUM_FRAMES);
+
+    // Same skinning result, and the attachments still follow their bones
+    CHECK_LT(GetSkinMatrixError(models, nodeSkinMatrices), 1e-3f);
+    AnimatedModel* jack = models[0];
+    const unsigned handIndex = jack->GetSkeleton().GetBoneIndex(String("Bip01_R_Hand"));
+    const Vector3 handPosition = jack->GetNode()->GetWorldTransform() * jack->GetBoneTransforms()[handIndex].Translation();
+    CHECK((jack->GetSkeleton().GetBone(handIndex)->node_->GetWorldPosition() - handPosition).Length() < 1e-3f);
+
+    // Bones without attachments are only written on demand
+    Node* headNode = jack->GetSkeleton().GetBone("Bip01_Head")->node_;
+    const unsigned headIndex = jack->GetSkeleton().GetBoneIndex(String("Bip01_Head"));
+    jack->SyncBoneNodes();
+    CHECK((headNode->GetPosition() - jack->GetBonePoses()[headIndex].position_).Length() < 1e-5f);
+}
+
+#endif
@@ -0,0 +1,159 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#ifdef URHO3D_NULL
+
+#include "../HeadlessFixture.h"
+
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/GraphicsImpl.h>
+#include <Urho3D/Graphics/Light.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/Renderer.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Graphics/Zone.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_FRAMES = 60;
+
+/// Build a static scene of boxes on a plane, shadowed by a directional, four spot and two point lights.
+void CreateScene(Scene* scene, Node* cameraNode)
+{
+    auto* cache = scene->GetSubsystem<ResourceCache>();
+
+    scene->CreateComponent<Octree>();
+
+    Node* zoneNode = scene->CreateChild("Zone");
+    auto* zone = zoneNode->CreateComponent<Zone>();
+    zone->SetBoundingBox(BoundingBox(-1000.0f, 1000.0f));
+    zone->SetAmbientColor(Color(0.1f, 0.1f, 0.1f));
+
+    Node* planeNode = scene->CreateChild("Plane");
+    planeNode->SetScale(Vector3(120.0f, 1.0f, 120.0f));
+    planeNode->CreateComponent<StaticModel>()->SetModel(cache->GetResource<Model>("Models/Plane.mdl"));
+
+    for (int y = -50; y < 50; ++y)
+    {
+        for (int x = -50; x < 50; ++x)
+        {
+            Node* boxNode = scene->CreateChild(x == 0 && y == 0 ? "CenterBox" : "Box");
+            boxNode->SetPosition(Vector3(x * 1.2f, 0.5f, y * 1.2f));
+            auto* boxObject = boxNode->CreateComponent<StaticModel>();
+            boxObject->SetModel(cache->GetResource<Model>("Models/Box.mdl"));
+            boxObject->SetCastShadows(true);
+        }
+    }
+
+    Node* sunNode = scene->CreateChild("Sun");
+    sunNode->SetDirection(Vector3(0.6f, -1.0f, 0.8f));
+    auto* sun = sunNode->CreateComponent<Light>();
+    sun->SetLightType(LIGHT_DIRECTIONAL);
+    sun->SetCastShadows(true);
+    sun->SetShadowCascade(CascadeParameters(10.0f, 25.0f, 50.0f, 100.0f, 0.8f));
+
+    for (unsigned i = 0; i < 6; ++i)
+    {
+        Node* lightNode = scene->CreateChild("Light");
+        lightNode->SetPosition(Vector3(i * 15.0f - 37.5f, 8.0f, i & 1 ? 10.0f : -10.0f));
+        lightNode->SetDirection(Vector3(0.2f, -1.0f, 0.1f));
+        auto* light = lightNode->CreateComponent<Light>();
+        light->SetLightType(i < 4 ? LIGHT_SPOT : LIGHT_POINT);
+        light->SetRange(20.0f);
+        light->SetFov(60.0f);
+        light->SetCastShadows(true);
+    }
+
+    cameraNode->SetPosition(Vector3(0.0f, 20.0f, -60.0f));
+    cameraNode->LookAt(Vector3::ZERO);
+    auto* camera = cameraNode->CreateComponent<Camera>();
+    camera->SetFarClip(150.0f);
+}
+
+/// Render frames, optionally turning the camera a little each frame, and return the view update time in microseconds.
+long long RenderFrames(Graphics* graphics, Renderer* renderer, Node* cameraNode, bool moveCamera)
+{
+    HiresTimer timer;
+    long long updateUSec = 0;
+
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        if (moveCamera)
+            cameraNode->Yaw(0.1f);
+
+        timer.Reset();
+        renderer->Update(1.0f / 60.0f);
+        updateUSec += timer.GetUSec(false);
+
+        graphics->BeginFrame();
+        renderer->Render();
+        graphics->EndFrame();
+    }
+
+    return updateUSec;
+}
+
+}
+
+TEST_CASE("Shadow caster caching in a static scene")
+{
+    HeadlessFixture fixture;
+    Graphics* graphics = fixture.graphics_;
+    Renderer* renderer = fixture.renderer_;
+
+    SharedPtr<Scene> scene(new Scene(fixture.context_));
+    SharedPtr<Node> cameraNode(new Node(fixture.context_));
+    CreateScene(scene, cameraNode);
+    fixture.SetViewport(scene, cameraNode->GetComponent<Camera>());
+
+    // Warm up shaders, instancing buffer and octree
+    RenderFrames(graphics, renderer, cameraNode, false);
+
+    printf("Shadow caster caching: 10000 boxes, 7 shadowed lights, %u threads, %u frames, ms of view update per frame\n",
+        fixture.GetNumThreads(), NUM_FRAMES);
+
+    renderer->SetShadowCasterCaching(false);
+    const long long uncachedUSec = RenderFrames(graphics, renderer, cameraNode, false);
+    const NullGraphicsStats uncachedStats = graphics->GetImpl()->GetFrameStats();
+    renderer->SetShadowCasterCaching(true);
+    const long long cachedUSec = RenderFrames(graphics, renderer, cameraNode, false);
+    const NullGraphicsStats cachedStats = graphics->GetImpl()->GetFrameStats();
+    printf("  static camera:  uncached %8.3f, cached %8.3f\n", uncachedUSec / 1000.0 / NUM_FRAMES, cachedUSec / 1000.0 / NUM_FRAMES);
+
+    // The cached shadow casters must render exactly the same
+    CHECK_EQ(cachedStats.draws_, uncachedStats.draws_);
+    CHECK_EQ(cachedStats.primitives_, uncachedStats.primitives_);
+    CHECK(cachedStats.primitives_ > 0);
+
+    // A moved box invalidates the lights it is close to, which then render as before
+    scene->GetChild("CenterBox")->Translate(Vector3(0.0f, 2.0f, 0.0f));
+    RenderFrames(graphics, renderer, cameraNode, false);
+    const NullGraphicsStats movedCachedStats = graphics->GetImpl()->GetFrameStats();
+    renderer->SetShadowCasterCaching(false);
+    RenderFrames(graphics, renderer, cameraNode, false);
+    const NullGraphicsStats movedStats = graphics->GetImpl()->GetFrameStats();
+    CHECK_EQ(movedCachedStats.draws_, movedStats.draws_);
+    CHECK_EQ(movedCachedStats.primitives_, movedStats.primitives_);
+
+    // With a moving camera only the point and spot light volume queries are reused, unless cascades are culled in turn
+    const long long movingUSec = RenderFrames(graphics, renderer, cameraNode, true);
+    renderer->SetShadowCasterCaching(true);
+    const long long movingCachedUSec = RenderFrames(graphics, renderer, cameraNode, true);
+    renderer->SetRoundRobinCascades(true);
+    const long long roundRobinUSec = RenderFrames(graphics, renderer, cameraNode, true);
+    printf("  moving camera:  uncached %8.3f, cached %8.3f, cached with round-robin cascades %8.3f\n",
+        movingUSec / 1000.0 / NUM_FRAMES, movingCachedUSec / 1000.0 / NUM_FRAMES, roundRobinUSec / 1000.0 / NUM_FRAMES);
+}
+
+#endif
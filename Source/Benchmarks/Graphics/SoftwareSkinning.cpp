@@ -0,0 +1,289 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#ifdef URHO3D_NULL
+
+#include "../HeadlessFixture.h"
+
+#include <Urho3D/Core/FrameAllocator.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/AnimatedModel.h>
+#include <Urho3D/Graphics/Animation.h>
+#include <Urho3D/Graphics/AnimationState.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/OctreeQuery.h>
+#include <Urho3D/Graphics/SoftwareSkinning.h>
+#include <Urho3D/Graphics/VertexBuffer.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_FRAMES = 20;
+constexpr int CROWD_SIZE = 20;
+constexpr unsigned NUM_RAYS = 1000;
+
+/// Build a crowd of walking animated models.
+void CreateScene(Scene* scene, PODVector<AnimatedModel*>& models)
+{
+    auto* cache = scene->GetSubsystem<ResourceCache>();
+
+    scene->CreateComponent<Octree>();
+
+    SetRandomSeed(1);
+    auto* walk = cache->GetResource<Animation>("Models/Jack_Walk.ani");
+    for (int y = -CROWD_SIZE / 2; y < CROWD_SIZE - CROWD_SIZE / 2; ++y)
+    {
+        for (int x = -CROWD_SIZE / 2; x < CROWD_SIZE - CROWD_SIZE / 2; ++x)
+        {
+            Node* jackNode = scene->CreateChild("Jack");
+            jackNode->SetPosition(Vector3(x * 2.0f, 0.0f, y * 2.0f));
+            jackNode->SetRotation(Quaternion(0.0f, Random(360.0f), 0.0f));
+            auto* jack = jackNode->CreateComponent<AnimatedModel>();
+            jack->SetModel(cache->GetResource<Model>("Models/Jack.mdl"));
+            jack->SetUsePoseBuffer(true);
+            AnimationState* state = jack->AddAnimationState(walk);
+            state->SetWeight(1.0f);
+            state->SetLooped(true);
+            state->SetTime(Random(walk->GetLength()));
+            models.Push(jack);
+        }
+    }
+}
+
+/// Advance the animations and update the octree headlessly.
+void AnimateFrame(Octree* octree, const PODVector<AnimatedModel*>& models, unsigned frameNumber)
+{
+    FrameInfo frame;
+    frame.frameNumber_ = frameNumber;
+    frame.camera_ = nullptr;
+    frame.timeStep_ = 1.0f / 60.0f;
+    frame.allocator_ = octree->GetSubsystem<FrameAllocator>();
+
+    for (unsigned i = 0; i < models.Size(); ++i)
+        models[i]->GetAnimationState(0u)->AddTime(frame.timeStep_);
+    octree->Update(frame);
+}
+
+/// Vertex range of a skinned geometry with its skin matrix palette.
+struct SkinJob
+{
+    /// Positions.
+    const unsigned char* positionData_;
+    /// Blend weights.
+    const unsigned char* blendWeightData_;
+    /// Blend indices.
+    const unsigned char* blendIndexData_;
+    /// Vertex stride.
+    unsigned stride_;
+    /// Number of vertices.
+    unsigned count_;
+    /// Offset of the first vertex in the output.
+    unsigned outputOffset_;
+    /// Skin matrices indexed by the blend indices.
+    PODVector<Matrix3x4> palette_;
+};
+
+/// Collect the skinned geometries of the models, with palettes built from the current pose. Return the total vertex count.
+unsigned CreateSkinJobs(const PODVector<AnimatedModel*>& models, Vector<SkinJob>& jobs)
+{
+    unsigned numVertices = 0;
+    for (unsigned i = 0; i < models.Size(); ++i)
+    {
+        AnimatedModel* model = models[i];
+        const Vector<Bone>& bones = model->GetSkeleton().GetBones();
+        const Matrix3x4& worldTransform = model->GetNode()->GetWorldTransform();
+        PODVector<Matrix3x4> skinMatrices(bones.Size());
+        for (unsigned j = 0; j < bones.Size(); ++j)
+            skinMatrices[j] = worldTransform * model->GetBoneTransforms()[j] * bones[j].offsetMatrix_;
+
+        for (unsigned j = 0; j < model->GetNumGeometries(); ++j)
+        {
+            Geometry* geometry = model->GetLodGeometry(j, 0);
+            VertexBuffer* vb = geometry->GetVertexBuffer(0);
+            const unsigned start = geometry->GetVertexStart();
+
+            SkinJob job;
+            job.stride_ = vb->GetVertexSize();
+            job.positionData_ = vb->GetShadowData() + start * job.stride_;
+            job.blendWeightData_ = job.positionData_ + vb->GetElementOffset(SEM_BLENDWEIGHTS);
+            job.blendIndexData_ = job.positionData_ + vb->GetElementOffset(SEM_BLENDINDICES);
+            job.count_ = geometry->GetVertexCount();
+            job.outputOffset_ = numVertices;
+
+            const PODVector<unsigned>& boneMapping = j < model->GetGeometryBoneMappings().Size() ?
+                model->GetGeometryBoneMappings()[j] : PODVector<unsigned>();
+            if (boneMapping.Empty())
+                job.palette_ = skinMatrices;
+            else
+            {
+                for (unsigned k = 0; k < boneMapping.Size(); ++k)
+                    job.palette_.Push(skinMatrices[boneMapping[k]]);
+            }
+
+            jobs.Push(job);
+            numVertices += job.count_;
+        }
+    }
+    return numVertices;
+}
+
+/// Skin vertices by transforming the position with each influencing matrix separately, one scalar float at a time.
+void SkinScalar(const SkinJob& job, Vector3* dest)
+{
+    for (unsigned i = 0; i < job.count_; ++i)
+    {
+        const auto* position = (const float*)(job.positionData_ + i * job.stride_);
+        const auto* weights = (const float*)(job.blendWeightData_ + i * job.stride_);
+        const unsigned char* indices = job.blendIndexData_ + i * job.stride_;
+        Vector3 skinned = Vector3::ZERO;
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            if (weights[j] != 0.0f)
+                skinned += weights[j] * (job.palette_[indices[j]] * Vector3(position));
+        }
+        dest[i] = skinned;
+    }
+}
+
+/// Skin vertices with the SIMD kernel.
+void SkinSimd(const SkinJob& job, Vector3* dest)
+{
+    SkinPositions(job.positionData_, job.stride_, job.blendWeightData_, job.blendIndexData_, job.stride_, job.palette_.Buffer(),
+        job.palette_.Size(), job.count_, dest);
+}
+
+/// Cast rays down at random points of the crowd. Return the time in microseconds and count the hits.
+long long CastRays(Octree* octree, unsigned& numHits)
+{
+    SetRandomSeed(2);
+    PODVector<RayQueryResult> results;
+    numHits = 0;
+
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < NUM_RAYS; ++i)
+    {
+        const Vector3 target(Random(-CROWD_SIZE, CROWD_SIZE), Random(0.0f, 1.8f), Random(-CROWD_SIZE, CROWD_SIZE));
+        const Vector3 origin = target + Vector3(Random(-1.0f, 1.0f), 2.0f, Random(-1.0f, 1.0f)) * 5.0f;
+        RayOctreeQuery query(results, Ray(origin, target - origin), RAY_TRIANGLE, 100.0f, DRAWABLE_GEOMETRY);
+        octree->RaycastSingle(query);
+        if (!results.Empty())
+            ++numHits;
+    }
+
+    return timer.GetUSec(false);
+}
+
+}
+
+TEST_CASE("SIMD CPU skinning and skinned raycasts")
+{
+    HeadlessFixture fixture(false);
+    WorkQueue* queue = fixture.queue_;
+
+    SharedPtr<Scene> scene(new Scene(fixture.context_));
+    PODVector<AnimatedModel*> models;
+    CreateScene(scene, models);
+    auto* octree = scene->GetComponent<Octree>();
+    AnimateFrame(octree, models, 1);
+
+    Vector<SkinJob> jobs;
+    const unsigned numVertices = CreateSkinJobs(models, jobs);
+    PODVector<Vector3> scalarPositions(numVertices);
+    PODVector<Vector3> simdPositions(numVertices);
+
+    printf("Software skinning: %u animated models, %u vertices, %u threads, %u frames\n", models.Size(), numVertices,
+        fixture.GetNumThreads(), NUM_FRAMES);
+
+    HiresTimer timer;
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        for (unsigned j = 0; j < jobs.Size(); ++j)
+            SkinScalar(jobs[j], &scalarPositions[jobs[j].outputOffset_]);
+    }
+    const long long scalarUSec = timer.GetUSec(true);
+
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        for (unsigned j = 0; j < jobs.Size(); ++j)
+            SkinSimd(jobs[j], &simdPositions[jobs[j].outputOffset_]);
+    }
+    const long long simdUSec = timer.GetUSec(true);
+
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        queue->ParallelFor(jobs.Size(), 0, [&jobs, &simdPositions](unsigned begin, unsigned end, unsigned /*threadIndex*/)
+        {
+            for (unsigned j = begin; j < end; ++j)
+                SkinSimd(jobs[j], &simdPositions[jobs[j].outputOffset_]);
+        });
+    }
+    const long long parallelUSec = timer.GetUSec(true);
+
+    float maxError = 0.0f;
+    for (unsigned i = 0; i < numVertices; ++i)
+        maxError = Max(maxError, (scalarPositions[i] - simdPositions[i]).Length());
+
+    // Skinned positions of the models themselves, animated and skinned in parallel every frame
+    long long modelUSec = 0;
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        AnimateFrame(octree, models, i + 2);
+        timer.Reset();
+        AnimatedModel** modelBuffer = models.Buffer();
+        queue->ParallelFor(models.Size(), 0, [modelBuffer](unsigned begin, unsigned end, unsigned /*threadIndex*/)
+        {
+            for (unsigned j = begin; j < end; ++j)
+                modelBuffer[j]->UpdateSkinnedPositions();
+        });
+        modelUSec += timer.GetUSec(false);
+    }
+
+    unsigned numOutside = 0;
+    for (unsigned i = 0; i < models.Size(); ++i)
+    {
+        BoundingBox bounds = models[i]->GetWorldBoundingBox();
+        bounds.Merge(bounds.min_ - Vector3::ONE * 0.1f);
+        bounds.Merge(bounds.max_ + Vector3::ONE * 0.1f);
+        for (unsigned j = 0; j < models[i]->GetNumGeometries(); ++j)
+        {
+            const PODVector<Vector3>& positions = models[i]->GetSkinnedPositions(j);
+            for (unsigned k = 0; k < positions.Size(); ++k)
+                numOutside += bounds.IsInside(positions[k]) == OUTSIDE;
+        }
+    }
+
+    // Triangle raycasts against bone hitboxes, then against the skinned triangles
+    unsigned boneHits = 0;
+    unsigned skinnedHits = 0;
+    const long long boneRayUSec = CastRays(octree, boneHits);
+    for (unsigned i = 0; i < models.Size(); ++i)
+        models[i]->SetSkinnedRaycast(true);
+    const long long skinnedRayUSec = CastRays(octree, skinnedHits);
+
+    printf("  scalar:           %8.3f ms per frame\n", scalarUSec / 1000.0 / NUM_FRAMES);
+    printf("  SIMD:             %8.3f ms per frame, max difference %g\n", simdUSec / 1000.0 / NUM_FRAMES, maxError);
+    printf("  SIMD, parallel:   %8.3f ms per frame\n", parallelUSec / 1000.0 / NUM_FRAMES);
+    printf("  models, parallel: %8.3f ms per frame\n", modelUSec / 1000.0 / NUM_FRAMES);
+    printf("  raycasts vs. bone hitboxes:      %8.3f us per ray, %u hits of %u\n", (double)boneRayUSec / NUM_RAYS, boneHits, NUM_RAYS);
+    printf("  raycasts vs. skinned triangles:  %8.3f us per ray, %u hits of %u\n", (double)skinnedRayUSec / NUM_RAYS, skinnedHits,
+        NUM_RAYS);
+
+    CHECK_LT(maxError, 1e-3f);
+    CHECK_LT(simdUSec, scalarUSec);
+    CHECK_EQ(numOutside, 0);
+    CHECK_GT(skinnedHits, 0);
+}
+
+#endif
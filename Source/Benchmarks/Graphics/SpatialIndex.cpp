@@ -0,0 +1,138 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Drawable.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/OctreeQuery.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_FRAMES = 50;
+constexpr unsigned NUM_OBJECTS = 200000;
+constexpr unsigned MOVE_INTERVAL = 2;
+
+/// Unit box geometry stand-in which needs no graphics subsystem.
+class MovingBox : public Drawable
+{
+    URHO3D_OBJECT(MovingBox, Drawable);
+
+public:
+    explicit MovingBox(Context* context) :
+        Drawable(context, DRAWABLE_GEOMETRY)
+    {
+        boundingBox_ = BoundingBox(-0.5f, 0.5f);
+    }
+
+protected:
+    void OnWorldBoundingBoxUpdate() override
+    {
+        worldBoundingBox_ = boundingBox_.Transformed(node_->GetWorldTransform());
+    }
+};
+
+/// Camera frustum sweeping around the scene.
+Frustum GetFrustum(unsigned frameNumber)
+{
+    Frustum frustum;
+    frustum.Define(60.0f, 1.0f, 1.0f, 0.1f, 300.0f, Matrix3x4(Vector3::ZERO, Quaternion(frameNumber * 3.0f, Vector3::UP), Vector3::ONE));
+    return frustum;
+}
+
+}
+
+TEST_CASE("AABB tree vs. octree spatial index with many moving drawables")
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+    auto* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    queue->CreateThreads(Max(GetNumLogicalCPUs(), 2u) - 1);
+    RegisterSceneLibrary(context);
+    Octree::RegisterObject(context);
+    context->RegisterFactory<MovingBox>();
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* octree = scene->CreateComponent<Octree>();
+    octree->SetSize(BoundingBox(-1000.0f, 1000.0f), 8);
+
+    PODVector<Node*> nodes;
+    PODVector<Vector3> positions;
+    SetRandomSeed(1);
+    for (unsigned i = 0; i < NUM_OBJECTS; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition(Vector3(Random(-900.0f, 900.0f), Random(-20.0f, 20.0f), Random(-900.0f, 900.0f)));
+        node->CreateComponent<MovingBox>();
+        nodes.Push(node);
+        positions.Push(node->GetPosition());
+    }
+
+    FrameInfo frame{};
+    PODVector<Drawable*> result;
+    printf("Spatial index: %u threads, %u objects (1/%u moving) x %u frames\n", queue->GetNumThreads() + 1, NUM_OBJECTS,
+        MOVE_INTERVAL, NUM_FRAMES);
+
+    const SpatialIndex indices[] = {SPATIAL_INDEX_OCTREE, SPATIAL_INDEX_AABB_TREE};
+    const char* names[] = {"octree  ", "AABB tree"};
+    unsigned long long numVisible[2] = {};
+    PODVector<unsigned> visibleCounts[2];
+    PODVector<unsigned long long> visibleChecksums[2];
+    for (unsigned index = 0; index < 2; ++index)
+    {
+        // Start both passes from the same scene state, so that their visible sets can be compared frame by frame
+        for (unsigned i = 0; i < nodes.Size(); ++i)
+            nodes[i]->SetPosition(positions[i]);
+        octree->SetSpatialIndex(indices[index]);
+        ++frame.frameNumber_;
+        octree->Update(frame);
+
+        long long updateUSec = 0;
+        long long cullUSec = 0;
+        HiresTimer timer;
+        for (unsigned i = 0; i < NUM_FRAMES; ++i)
+        {
+            // Small moves, as a crowd or traffic would make each frame
+            ++frame.frameNumber_;
+            for (unsigned j = i % MOVE_INTERVAL; j < nodes.Size(); j += MOVE_INTERVAL)
+                nodes[j]->Translate(Vector3(Sin(i * 10.0f + j), 0.0f, Cos(i * 10.0f + j)) * 0.05f);
+            timer.Reset();
+            octree->Update(frame);
+            updateUSec += timer.GetUSec(true);
+
+            FrustumOctreeQuery query(result, GetFrustum(i), DRAWABLE_GEOMETRY);
+            octree->GetDrawables(query);
+            cullUSec += timer.GetUSec(false);
+
+            // The sum of node IDs identifies the visible set independent of its order
+            unsigned long long checksum = 0;
+            for (unsigned j = 0; j < result.Size(); ++j)
+                checksum += result[j]->GetNode()->GetID();
+            numVisible[index] += result.Size();
+            visibleCounts[index].Push(result.Size());
+            visibleChecksums[index].Push(checksum);
+        }
+
+        printf("  %s: update %8.3f ms/frame, cull %8.3f ms/frame (%llu visible)\n", names[index],
+            updateUSec / 1000.0 / NUM_FRAMES, cullUSec / 1000.0 / NUM_FRAMES, numVisible[index]);
+    }
+
+    CHECK(numVisible[0] > 0);
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        CHECK_EQ(visibleCounts[0][i], visibleCounts[1][i]);
+        CHECK_EQ(visibleChecksums[0][i], visibleChecksums[1][i]);
+    }
+}
@@ -0,0 +1,210 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#ifdef URHO3D_NULL
+
+#include "../HeadlessFixture.h"
+
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/GraphicsImpl.h>
+#include <Urho3D/Graphics/Light.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/OctreeQuery.h>
+#include <Urho3D/Graphics/Renderer.h>
+#include <Urho3D/Graphics/StaticBatch.h>
+#include <Urho3D/Graphics/StaticBatcher.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Graphics/Zone.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_FRAMES = 60;
+constexpr int LEVEL_SIZE = 40;
+
+const char* modelNames[] =
+{
+    "Models/Box.mdl",
+    "Models/Cone.mdl",
+    "Models/Cylinder.mdl",
+    "Models/Pyramid.mdl",
+    "Models/Sphere.mdl",
+    "Models/Torus.mdl"
+};
+
+const char* materialNames[] =
+{
+    "Materials/Stone.xml",
+    "Materials/StoneTiled.xml"
+};
+
+/// Build dense level art of distinct static models under a batcher node, lit by the sun.
+Node* CreateScene(Scene* scene, Node* cameraNode)
+{
+    auto* cache = scene->GetSubsystem<ResourceCache>();
+
+    scene->CreateComponent<Octree>();
+
+    Node* zoneNode = scene->CreateChild("Zone");
+    auto* zone = zoneNode->CreateComponent<Zone>();
+    zone->SetBoundingBox(BoundingBox(-1000.0f, 1000.0f));
+    zone->SetAmbientColor(Color(0.2f, 0.2f, 0.2f));
+
+    Node* sunNode = scene->CreateChild("Sun");
+    sunNode->SetDirection(Vector3(0.6f, -1.0f, 0.8f));
+    sunNode->CreateComponent<Light>()->SetLightType(LIGHT_DIRECTIONAL);
+
+    SetRandomSeed(1);
+    Node* levelNode = scene->CreateChild("Level");
+    for (int y = -LEVEL_SIZE / 2; y < LEVEL_SIZE / 2; ++y)
+    {
+        for (int x = -LEVEL_SIZE / 2; x < LEVEL_SIZE / 2; ++x)
+        {
+            // Vary the scale, including mirroring, so that each placement is a distinct mesh after baking
+            Node* propNode = levelNode->CreateChild("Prop");
+            propNode->SetPosition(Vector3(x * 2.0f, 0.0f, y * 2.0f));
+            propNode->SetRotation(Quaternion(Random(360.0f), Random(360.0f), 0.0f));
+            propNode->SetScale(Vector3(Random(0.5f, 1.5f) * (Rand() & 1 ? 1.0f : -1.0f), Random(0.5f, 1.5f), Random(0.5f, 1.5f)));
+            auto* prop = propNode->CreateComponent<StaticModel>();
+            prop->SetModel(cache->GetResource<Model>(modelNames[Rand() % 6]));
+            prop->SetMaterial(cache->GetResource<Material>(materialNames[Rand() % 2]));
+            prop->SetCastShadows(true);
+        }
+    }
+
+    cameraNode->SetPosition(Vector3(0.0f, 25.0f, -45.0f));
+    cameraNode->LookAt(Vector3(0.0f, 0.0f, 0.0f));
+    cameraNode->CreateComponent<Camera>()->SetFarClip(200.0f);
+
+    return levelNode;
+}
+
+/// Render frames and return the total frame time in microseconds.
+long long RenderFrames(Scene* scene, Graphics* graphics, Renderer* renderer)
+{
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        scene->Update(1.0f / 60.0f);
+        renderer->Update(1.0f / 60.0f);
+        graphics->BeginFrame();
+        renderer->Render();
+        graphics->EndFrame();
+    }
+
+    return timer.GetUSec(false);
+}
+
+/// Return the node of the closest triangle hit straight down onto a point of the level.
+Node* RaycastDown(Scene* scene, const Vector3& point)
+{
+    PODVector<RayQueryResult> results;
+    RayOctreeQuery query(results, Ray(point + Vector3(0.0f, 50.0f, 0.0f), Vector3::DOWN), RAY_TRIANGLE, 100.0f, DRAWABLE_GEOMETRY);
+    scene->GetComponent<Octree>()->RaycastSingle(query);
+    return results.Size() ? results[0].node_ : nullptr;
+}
+
+}
+
+TEST_CASE("Static batched vs. individually drawn level geometry")
+{
+    HeadlessFixture fixture;
+    Graphics* graphics = fixture.graphics_;
+    Renderer* renderer = fixture.renderer_;
+
+    SharedPtr<Scene> scene(new Scene(fixture.context_));
+    SharedPtr<Node> cameraNode(new Node(fixture.context_));
+    Node* levelNode = CreateScene(scene, cameraNode);
+    fixture.SetViewport(scene, cameraNode->GetComponent<Camera>());
+
+    printf("Static batching: %d static models, %u threads, %u frames\n", LEVEL_SIZE * LEVEL_SIZE,
+        fixture.GetNumThreads(), NUM_FRAMES);
+
+    // Pick a point on top of a prop to raycast before and after batching
+    Node* targetNode = levelNode->GetChildren()[LEVEL_SIZE * LEVEL_SIZE / 2 + LEVEL_SIZE / 2];
+    Node* individualHit = RaycastDown(scene, targetNode->GetWorldPosition());
+
+    // Warm up shaders, instancing buffer and octree before each measurement
+    renderer->SetDynamicInstancing(false);
+    RenderFrames(scene, graphics, renderer);
+    const long long individualUSec = RenderFrames(scene, graphics, renderer);
+    const NullGraphicsStats individualStats = graphics->GetImpl()->GetFrameStats();
+
+    renderer->SetDynamicInstancing(true);
+    RenderFrames(scene, graphics, renderer);
+    const long long instancedUSec = RenderFrames(scene, graphics, renderer);
+    const NullGraphicsStats instancedStats = graphics->GetImpl()->GetFrameStats();
+
+    auto* batcher = levelNode->CreateComponent<StaticBatcher>();
+    HiresTimer buildTimer;
+    const unsigned numBatches = batcher->Build();
+    const long long buildUSec = buildTimer.GetUSec(false);
+
+    unsigned batchVertices = 0;
+    for (unsigned i = 0; i < numBatches; ++i)
+        batchVertices += batcher->GetBatch(i)->GetGeometry()->GetVertexCount();
+    unsigned sourceVertices = 0;
+    PODVector<StaticModel*> models;
+    levelNode->GetComponents<StaticModel>(models, true);
+    for (unsigned i = 0; i < models.Size(); ++i)
+    {
+        for (unsigned j = 0; j < models[i]->GetNumGeometries(); ++j)
+            sourceVertices += models[i]->GetLodGeometry(j, 0)->GetVertexCount();
+    }
+
+    RenderFrames(scene, graphics, renderer);
+    const long long batchedUSec = RenderFrames(scene, graphics, renderer);
+    const NullGraphicsStats batchedStats = graphics->GetImpl()->GetFrameStats();
+    Node* batchedHit = RaycastDown(scene, targetNode->GetWorldPosition());
+
+    printf("  individual: %8.3f ms per frame, %5u draws, %5u instanced draws\n", individualUSec / 1000.0 / NUM_FRAMES,
+        individualStats.draws_, individualStats.instancedDraws_);
+    printf("  instanced:  %8.3f ms per frame, %5u draws, %5u instanced draws\n", instancedUSec / 1000.0 / NUM_FRAMES,
+        instancedStats.draws_, instancedStats.instancedDraws_);
+    printf("  batched:    %8.3f ms per frame, %5u draws, %5u instanced draws, %u batches built in %.3f ms\n",
+        batchedUSec / 1000.0 / NUM_FRAMES, batchedStats.draws_, batchedStats.instancedDraws_, numBatches, buildUSec / 1000.0);
+
+    CHECK_EQ(batcher->GetNumSources(), LEVEL_SIZE * LEVEL_SIZE);
+    CHECK_EQ(batchVertices, sourceVertices);
+    CHECK_LT(batchedStats.draws_ + batchedStats.instancedDraws_, individualStats.draws_ / 10);
+
+    // Raycasts still report the original nodes, which stay out of the octree while batched
+    CHECK(individualHit);
+    CHECK_EQ(batchedHit, individualHit);
+    CHECK_FALSE(models[0]->GetOctant());
+
+    // Batches are not saved, but built again on load
+    VectorBuffer sceneData;
+    REQUIRE(scene->Save(sceneData));
+    sceneData.Seek(0);
+    SharedPtr<Scene> loadedScene(new Scene(fixture.context_));
+    REQUIRE(loadedScene->Load(sceneData));
+    auto* loadedBatcher = loadedScene->GetComponent<StaticBatcher>(true);
+    REQUIRE(loadedBatcher);
+    CHECK_EQ(loadedBatcher->GetNumBatches(), numBatches);
+    CHECK_EQ(loadedBatcher->GetNumSources(), LEVEL_SIZE * LEVEL_SIZE);
+
+    // Clearing restores the originals
+    batcher->Clear();
+    CHECK(models[0]->GetOctant());
+    CHECK_EQ(levelNode->GetNumChildren(), LEVEL_SIZE * LEVEL_SIZE);
+    RenderFrames(scene, graphics, renderer);
+    CHECK_EQ(graphics->GetImpl()->GetFrameStats().instancedDraws_, instancedStats.instancedDraws_);
+}
+
+#endif
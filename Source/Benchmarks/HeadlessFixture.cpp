@@ -0,0 +1,61 @@
+#include <doctest/doctest_fwd.h>
+
+#include "HeadlessFixture.h"
+
+#ifdef URHO3D_NULL
+
+#include <Urho3D/Core/FrameAllocator.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/Renderer.h>
+#include <Urho3D/Graphics/Viewport.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+HeadlessFixture::HeadlessFixture(bool renderer)
+{
+    Thread::SetMainThread();
+    context_ = new Context();
+    context_->RegisterSubsystem(new Time(context_));
+    queue_ = new WorkQueue(context_);
+    context_->RegisterSubsystem(queue_);
+    queue_->CreateThreads(Max(GetNumLogicalCPUs(), 2u) - 1);
+    context_->RegisterSubsystem(new FrameAllocator(context_));
+    fileSystem_ = new FileSystem(context_);
+    context_->RegisterSubsystem(fileSystem_);
+    cache_ = new ResourceCache(context_);
+    context_->RegisterSubsystem(cache_);
+    cache_->AddResourceDir(fileSystem_->GetProgramDir() + "CoreData");
+    cache_->AddResourceDir(fileSystem_->GetProgramDir() + "Data");
+    RegisterSceneLibrary(context_);
+
+    graphics_ = new Graphics(context_);
+    context_->RegisterSubsystem(graphics_);
+    if (renderer)
+    {
+        renderer_ = new Renderer(context_);
+        context_->RegisterSubsystem(renderer_);
+        REQUIRE(graphics_->SetMode(1280, 720));
+    }
+}
+
+Viewport* HeadlessFixture::SetViewport(Scene* scene, Camera* camera)
+{
+    REQUIRE(renderer_);
+    auto* viewport = new Viewport(context_, scene, camera);
+    renderer_->SetViewport(0, viewport);
+    return viewport;
+}
+
+unsigned HeadlessFixture::GetNumThreads() const
+{
+    return queue_->GetNumThreads() + 1;
+}
+
+#endif
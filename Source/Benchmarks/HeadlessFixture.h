@@ -0,0 +1,46 @@
+#pragma once
+
+#ifdef URHO3D_NULL
+
+#include <Urho3D/Core/Context.h>
+
+namespace Urho3D
+{
+
+class Camera;
+class FileSystem;
+class Graphics;
+class Renderer;
+class ResourceCache;
+class Scene;
+class Viewport;
+class WorkQueue;
+
+}
+
+/// Engine subsystems for benchmarks on the null graphics backend: time, a work queue with worker threads for the other logical CPUs, frame allocator, file system, resource cache with the CoreData and Data directories, the scene library and graphics. With a renderer the 1280x720 mode is also set.
+struct HeadlessFixture
+{
+    /// Construct the subsystems, optionally with a renderer.
+    explicit HeadlessFixture(bool renderer = true);
+
+    /// Render the scene through the camera in the first viewport and return the viewport.
+    Urho3D::Viewport* SetViewport(Urho3D::Scene* scene, Urho3D::Camera* camera);
+    /// Return number of threads including the main thread.
+    unsigned GetNumThreads() const;
+
+    /// Execution context.
+    Urho3D::SharedPtr<Urho3D::Context> context_;
+    /// Work queue.
+    Urho3D::WorkQueue* queue_{};
+    /// File system.
+    Urho3D::FileSystem* fileSystem_{};
+    /// Resource cache.
+    Urho3D::ResourceCache* cache_{};
+    /// Graphics.
+    Urho3D::Graphics* graphics_{};
+    /// Renderer, if constructed with one.
+    Urho3D::Renderer* renderer_{};
+};
+
+#endif
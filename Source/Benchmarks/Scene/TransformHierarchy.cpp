@@ -0,0 +1,95 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace
+{
+
+constexpr unsigned NUM_ROOTS = 1000;
+constexpr unsigned NUM_CHILDREN = 10;
+constexpr unsigned NUM_GRANDCHILDREN = 9;
+constexpr unsigned NUM_FRAMES = 20;
+
+/// Build 1000 roots with 10 children and 90 grandchildren each, 101k nodes in total.
+void BuildHierarchy(Scene* scene, PODVector<Node*>& roots, PODVector<Node*>& nodes)
+{
+    for (unsigned i = 0; i < NUM_ROOTS; ++i)
+    {
+        Node* root = scene->CreateChild();
+        root->SetPosition(Vector3((float)i, 0.0f, 0.0f));
+        roots.Push(root);
+        nodes.Push(root);
+        for (unsigned j = 0; j < NUM_CHILDREN; ++j)
+        {
+            Node* child = root->CreateChild();
+            child->SetPosition(Vector3(0.0f, (float)j, 0.0f));
+            nodes.Push(child);
+            for (unsigned k = 0; k < NUM_GRANDCHILDREN; ++k)
+            {
+                Node* grandChild = child->CreateChild();
+                grandChild->SetPosition(Vector3(0.0f, 0.0f, (float)k));
+                nodes.Push(grandChild);
+            }
+        }
+    }
+}
+
+/// Move every root, then read every world position as the octree and renderer would. Return elapsed microseconds.
+long long RunFrames(Scene* scene, const PODVector<Node*>& roots, const PODVector<Node*>& nodes, float& checksum)
+{
+    HiresTimer timer;
+    for (unsigned frame = 0; frame < NUM_FRAMES; ++frame)
+    {
+        for (Node* root : roots)
+            root->Rotate(Quaternion(1.0f, Vector3::UP));
+        scene->UpdateTransformHierarchy();
+        for (Node* node : nodes)
+            checksum += node->GetWorldPosition().x_;
+    }
+    return timer.GetUSec(false);
+}
+
+}
+
+TEST_CASE("Transform hierarchy vs. per-node world transforms")
+{
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+    auto* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    queue->CreateThreads(Max(GetNumLogicalCPUs(), 2u) - 1);
+
+    SharedPtr<Scene> legacyScene(new Scene(context));
+    PODVector<Node*> legacyRoots;
+    PODVector<Node*> legacyNodes;
+    BuildHierarchy(legacyScene, legacyRoots, legacyNodes);
+
+    SharedPtr<Scene> scene(new Scene(context));
+    PODVector<Node*> roots;
+    PODVector<Node*> nodes;
+    BuildHierarchy(scene, roots, nodes);
+    scene->SetTransformHierarchyEnabled(true);
+    scene->UpdateTransformHierarchy();
+
+    float legacyChecksum = 0.0f;
+    float checksum = 0.0f;
+    const double legacyTime = (double)RunFrames(legacyScene, legacyRoots, legacyNodes, legacyChecksum);
+    const double time = (double)RunFrames(scene, roots, nodes, checksum);
+
+    const double scale = 1.0 / (1000.0 * NUM_FRAMES);
+    printf("Transform hierarchy vs. per-node transforms: %u nodes, ms per frame (checksums %.1f, %.1f)\n", nodes.Size(),
+        checksum, legacyChecksum);
+    printf("  mark dirty + update + read: %8.3f vs. %8.3f (%.2fx)\n", time * scale, legacyTime * scale, legacyTime / time);
+}
@@ -123,6 +123,7 @@ void Player::Setup()
             "-nosound     Disable sound output\n"
             "-noip        Disable sound mixing interpolation\n"
             "-touch       Touch emulation on desktop platform\n"
+            "-trace <file> Stream profiler timelines to a file in Chrome trace format\n"
             #endif
         );
     }
@@ -0,0 +1,149 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <unordered_map>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#include <Urho3D/Container/FlatHashMap.h>
+#include <Urho3D/Container/FlatHashSet.h>
+#include <Urho3D/Container/Str.h>
+
+TEST_CASE("FlatHashMap")
+{
+    using namespace Urho3D;
+
+    FlatHashMap<int, String> map;
+    CHECK(map.Empty());
+    CHECK(map.Find(1) == map.End());
+    CHECK(map.Begin() == map.End());
+
+    map[1] = "one";
+    map.Insert(MakePair(2, String("two")));
+    bool exists = true;
+    map.Insert(MakePair(3, String("three")), exists);
+    CHECK_FALSE(exists);
+    map.Insert(MakePair(3, String("drei")), exists);
+    CHECK(exists);
+
+    CHECK_EQ(map.Size(), 3);
+    CHECK_EQ(map[3], "drei");
+    CHECK(map.Contains(2));
+    CHECK_FALSE(map.Contains(4));
+
+    String value;
+    CHECK(map.TryGetValue(1, value));
+    CHECK_EQ(value, "one");
+    CHECK_FALSE(map.TryGetValue(4, value));
+
+    const FlatHashMap<int, String>& constMap = map;
+    REQUIRE(constMap[2]);
+    CHECK_EQ(*constMap[2], "two");
+    CHECK_FALSE(constMap[4]);
+
+    CHECK(map.Erase(2));
+    CHECK_FALSE(map.Erase(2));
+    CHECK_EQ(map.Size(), 2);
+
+    // Copy and move
+    FlatHashMap<int, String> copy = map;
+    CHECK(copy == map);
+    copy[5] = "five";
+    CHECK(copy != map);
+    FlatHashMap<int, String> moved = std::move(copy);
+    CHECK_EQ(moved.Size(), 3);
+
+    map.Clear();
+    CHECK(map.Empty());
+    CHECK(map.Begin() == map.End());
+}
+
+TEST_CASE("FlatHashMap matches std::unordered_map")
+{
+    using namespace Urho3D;
+
+    FlatHashMap<unsigned, unsigned> map;
+    std::unordered_map<unsigned, unsigned> reference;
+
+    // Insert and erase enough to cycle through growth and tombstone reclamation
+    unsigned seed = 1;
+    for (unsigned i = 0; i < 20000; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        const unsigned key = (seed >> 8u) % 2000;
+        if (seed & 1u)
+        {
+            map[key] = i;
+            reference[key] = i;
+        }
+        else
+        {
+            CHECK_EQ(map.Erase(key), reference.erase(key) != 0);
+        }
+    }
+
+    CHECK_EQ(map.Size(), reference.size());
+    unsigned count = 0;
+    for (auto i = map.Begin(); i != map.End(); ++i, ++count)
+    {
+        auto j = reference.find(i->first_);
+        REQUIRE(j != reference.end());
+        CHECK_EQ(i->second_, j->second);
+    }
+    CHECK_EQ(count, map.Size());
+}
+
+TEST_CASE("FlatHashMap erase while iterating")
+{
+    using namespace Urho3D;
+
+    FlatHashMap<unsigned, unsigned> map;
+    map.Reserve(1000);
+    const unsigned capacity = map.Capacity();
+    for (unsigned i = 0; i < 1000; ++i)
+        map[i] = i;
+    CHECK_EQ(map.Capacity(), capacity);
+
+    // Erasing leaves other values in place
+    for (auto i = map.Begin(); i != map.End();)
+    {
+        if (i->first_ % 2)
+            i = map.Erase(i);
+        else
+            ++i;
+    }
+
+    CHECK_EQ(map.Size(), 500);
+    for (unsigned i = 0; i < 1000; ++i)
+        CHECK_EQ(map.Contains(i), i % 2 == 0);
+}
+
+TEST_CASE("FlatHashSet")
+{
+    using namespace Urho3D;
+
+    FlatHashSet<String> set{"a", "b", "c"};
+    CHECK_EQ(set.Size(), 3);
+
+    bool exists = true;
+    set.Insert("d", exists);
+    CHECK_FALSE(exists);
+    set.Insert("a", exists);
+    CHECK(exists);
+    CHECK_EQ(set.Size(), 4);
+
+    CHECK(set.Contains("b"));
+    CHECK(set.Erase("b"));
+    CHECK_FALSE(set.Contains("b"));
+    CHECK(set.Find("b") == set.End());
+
+    unsigned count = 0;
+    for (const String& key : set)
+    {
+        CHECK(set.Contains(key));
+        ++count;
+    }
+    CHECK_EQ(count, 3);
+
+    FlatHashSet<String> copy = set;
+    CHECK(copy == set);
+}
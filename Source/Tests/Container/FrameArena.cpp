@@ -0,0 +1,108 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdint>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#include <Urho3D/Container/FrameArena.h>
+#include <Urho3D/Container/FramePODVector.h>
+
+TEST_CASE("FrameArena")
+{
+    using namespace Urho3D;
+
+    FrameArena arena(1024);
+    CHECK_EQ(arena.GetNumBlocks(), 0);
+
+    void* a = arena.Allocate(3, 1);
+    void* b = arena.Allocate(16, 16);
+    CHECK_EQ((uintptr_t)b % 16, 0);
+    CHECK(b > a);
+
+    // Only the last allocation can be resized in place
+    CHECK(arena.Reallocate(b, 16, 64));
+    CHECK_FALSE(arena.Reallocate(a, 3, 8));
+
+    // Spill over several blocks during a frame
+    for (unsigned i = 0; i < 10; ++i)
+        arena.Allocate(500);
+    CHECK_GT(arena.GetNumBlocks(), 1);
+    const unsigned peak = arena.GetUsedBytes();
+
+    // Reset merges the blocks, so that the same frame again needs no more heap allocations
+    arena.Reset();
+    CHECK_EQ(arena.GetNumBlocks(), 1);
+    CHECK_EQ(arena.GetUsedBytes(), 0);
+    CHECK_GE(arena.GetCapacity(), peak);
+    const unsigned numBlockAllocations = arena.GetNumBlockAllocations();
+    arena.Allocate(3, 1);
+    arena.Allocate(64, 16);
+    for (unsigned i = 0; i < 10; ++i)
+        arena.Allocate(500);
+    arena.Reset();
+    CHECK_EQ(arena.GetNumBlockAllocations(), numBlockAllocations);
+    CHECK_GE(arena.GetPeakBytes(), peak);
+}
+
+TEST_CASE("FrameArenaScope")
+{
+    using namespace Urho3D;
+
+    FrameArena arena(1024);
+    arena.Allocate(100);
+    const unsigned used = arena.GetUsedBytes();
+
+    {
+        FrameArenaScope scope(&arena);
+        arena.Allocate(100);
+        // Includes the alignment padding before the allocation
+        const unsigned scopeUsed = arena.GetUsedBytes();
+        CHECK_GE(scopeUsed, used + 100);
+        {
+            FrameArenaScope inner(&arena);
+            for (unsigned i = 0; i < 10; ++i)
+                arena.Allocate(500);
+        }
+        CHECK_EQ(arena.GetUsedBytes(), scopeUsed);
+    }
+
+    CHECK_EQ(arena.GetUsedBytes(), used);
+}
+
+TEST_CASE("FramePODVector")
+{
+    using namespace Urho3D;
+
+    FrameArena arena(256);
+
+    FramePODVector<int> vector(&arena);
+    for (int i = 0; i < 1000; ++i)
+        vector.Push(i);
+    CHECK_EQ(vector.Size(), 1000);
+    int sum = 0;
+    for (int value : vector)
+        sum += value;
+    CHECK_EQ(sum, 999 * 1000 / 2);
+    CHECK_GE(arena.GetUsedBytes(), 1000 * sizeof(int));
+
+    // Copies do not depend on the arena
+    FramePODVector<int> copy(vector);
+    CHECK_EQ(copy.GetArena(), nullptr);
+    CHECK_EQ(copy.Size(), 1000);
+    CHECK_EQ(copy[999], 999);
+
+    // Reuse after the arena has been reset
+    arena.Reset();
+    vector.Reset(&arena);
+    CHECK(vector.Empty());
+    vector.Resize(10);
+    vector[9] = 9;
+    CHECK_EQ(vector.Back(), 9);
+
+    // Heap fallback
+    FramePODVector<int> heap;
+    heap.Push(copy.Buffer(), copy.Size());
+    CHECK_EQ(heap.Size(), 1000);
+    heap.Pop();
+    CHECK_EQ(heap.Back(), 998);
+}
@@ -0,0 +1,48 @@
+#include <doctest/doctest_fwd.h>
+
+#include <Urho3D/Container/RadixSort.h>
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Math/MathDefs.h>
+#include <Urho3D/Math/Random.h>
+
+TEST_CASE("Radix sort orders keys and keeps equal keys in order")
+{
+    using namespace Urho3D;
+
+    SetRandomSeed(1);
+    const unsigned count = 10000;
+    PODVector<RadixSortItem<unsigned> > items(count);
+    PODVector<RadixSortItem<unsigned> > temp(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        // Few distinct high bytes and many duplicates, so that some passes are skipped and stability matters
+        items[i].key_ = (unsigned long long)Rand() % 4u << 40u | (unsigned long long)(Rand() % 500);
+        items[i].value_ = i;
+    }
+
+    RadixSort(items.Buffer(), temp.Buffer(), count);
+    for (unsigned i = 1; i < count; ++i)
+    {
+        REQUIRE(items[i - 1].key_ <= items[i].key_);
+        if (items[i - 1].key_ == items[i].key_)
+            REQUIRE(items[i - 1].value_ < items[i].value_);
+    }
+
+    // Sorting by fewer bytes only looks at the low bytes
+    for (unsigned i = 0; i < count; ++i)
+        items[i].key_ = (unsigned long long)(count - i) | 0xff00000000ull * (i & 1u);
+    RadixSort(items.Buffer(), temp.Buffer(), count, 4);
+    for (unsigned i = 1; i < count; ++i)
+        REQUIRE((items[i - 1].key_ & 0xffffffffu) < (items[i].key_ & 0xffffffffu));
+}
+
+TEST_CASE("Radix sort keys of floats sort like the floats")
+{
+    using namespace Urho3D;
+
+    const float values[] = { -1000.0f, -1.5f, -1.0f, -0.0f, 0.0f, 1.0e-20f, 0.5f, 1.0f, 2.0f, 1.0e20f, M_INFINITY };
+    for (unsigned i = 1; i < sizeof values / sizeof values[0]; ++i)
+        CHECK(FloatToRadixKey(values[i - 1]) <= FloatToRadixKey(values[i]));
+    CHECK(FloatToRadixKey(-1.0f) < FloatToRadixKey(-0.5f));
+    CHECK(FloatToRadixKey(0.25f) < FloatToRadixKey(0.5f));
+}
@@ -0,0 +1,225 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/List.h>
+#include <Urho3D/Core/ConcurrentAllocator.h>
+
+namespace
+{
+
+/// Test payload which records its owner.
+struct Payload
+{
+    unsigned owner_{};
+    unsigned value_{};
+};
+
+}
+
+TEST_CASE("ConcurrentAllocator single thread")
+{
+    using namespace Urho3D;
+
+    ConcurrentAllocator<Payload> allocator;
+    CHECK_EQ(allocator.GetNodeSize() % alignof(std::max_align_t), 0);
+
+    std::vector<Payload*> objects;
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        Payload* object = allocator.Reserve();
+        CHECK_EQ(object->value_, 0);
+        object->value_ = i;
+        objects.push_back(object);
+    }
+
+    ConcurrentAllocatorStats stats = allocator.GetStats();
+    CHECK_EQ(stats.liveNodes_, 1000);
+    CHECK_GE(stats.peakNodes_, 1000);
+    CHECK_GE(stats.capacity_, 1000);
+    CHECK_EQ(stats.numThreads_, 1);
+
+    for (unsigned i = 0; i < objects.size(); ++i)
+    {
+        CHECK_EQ(objects[i]->value_, i);
+        allocator.Free(objects[i]);
+    }
+
+    stats = allocator.GetStats();
+    CHECK_EQ(stats.liveNodes_, 0);
+
+    // Freed nodes are reused without growing
+    const unsigned numBlocks = stats.numBlocks_;
+    for (unsigned i = 0; i < 1000; ++i)
+        objects[i] = allocator.Reserve();
+    for (Payload* object : objects)
+        allocator.Free(object);
+    CHECK_EQ(allocator.GetStats().numBlocks_, numBlocks);
+}
+
+TEST_CASE("ConcurrentAllocator multiple threads with cross-thread free")
+{
+    using namespace Urho3D;
+
+    static const unsigned NUM_THREADS = 4;
+    static const unsigned NUM_ROUNDS = 50;
+    static const unsigned NUM_OBJECTS = 300;
+
+    ConcurrentAllocator<Payload> allocator;
+    // Each thread hands its objects to the next one, which validates and frees them
+    std::vector<std::vector<Payload*>> handoff(NUM_THREADS);
+    std::vector<std::atomic<bool>> ready(NUM_THREADS);
+    std::atomic<unsigned> errors{};
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < NUM_THREADS; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (unsigned round = 0; round < NUM_ROUNDS; ++round)
+            {
+                std::vector<Payload*> own;
+                for (unsigned i = 0; i < NUM_OBJECTS; ++i)
+                {
+                    Payload* object = allocator.Reserve();
+                    object->owner_ = t;
+                    object->value_ = round * NUM_OBJECTS + i;
+                    own.push_back(object);
+                }
+
+                // Wait until the previous batch has been taken, then publish
+                while (ready[t].load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                handoff[t].swap(own);
+                ready[t].store(true, std::memory_order_release);
+
+                // Free the batch published by the previous thread
+                const unsigned source = (t + NUM_THREADS - 1) % NUM_THREADS;
+                while (!ready[source].load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                std::vector<Payload*> received;
+                received.swap(handoff[source]);
+                ready[source].store(false, std::memory_order_release);
+
+                for (unsigned i = 0; i < received.size(); ++i)
+                {
+                    if (received[i]->owner_ != source || received[i]->value_ != round * NUM_OBJECTS + i)
+                        ++errors;
+                    allocator.Free(received[i]);
+                }
+            }
+        });
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    CHECK_EQ(errors.load(), 0);
+    const ConcurrentAllocatorStats stats = allocator.GetStats();
+    CHECK_EQ(stats.liveNodes_, 0);
+    // The threads have exited and returned their magazines
+    CHECK_EQ(stats.numThreads_, 0);
+    CHECK_GE(stats.peakNodes_, NUM_OBJECTS);
+    // Nodes circulate through the depot instead of growing without bound
+    CHECK_LT(stats.capacity_, NUM_THREADS * NUM_OBJECTS * 4);
+}
+
+TEST_CASE("ConcurrentAllocator reclaims the magazines of exited threads")
+{
+    using namespace Urho3D;
+
+    static const unsigned NUM_THREADS = 32;
+    static const unsigned NUM_OBJECTS = 100;
+
+    ConcurrentAllocator<Payload> allocator;
+    std::vector<Payload*> leftover;
+    for (unsigned t = 0; t < NUM_THREADS; ++t)
+    {
+        // Each thread leaves nodes cached in its magazines, and one node reserved
+        std::thread thread([&]()
+        {
+            std::vector<Payload*> objects;
+            for (unsigned i = 0; i < NUM_OBJECTS; ++i)
+                objects.push_back(allocator.Reserve());
+            for (unsigned i = 1; i < objects.size(); ++i)
+                allocator.Free(objects[i]);
+            leftover.push_back(objects[0]);
+        });
+        thread.join();
+    }
+
+    ConcurrentAllocatorStats stats = allocator.GetStats();
+    CHECK_EQ(stats.numThreads_, 0);
+    CHECK_EQ(stats.liveNodes_, NUM_THREADS);
+    // Without reclaiming, every exited thread would strand its cached nodes and the pool would keep growing
+    CHECK_LT(stats.capacity_, NUM_THREADS + ConcurrentAllocatorBase::MAGAZINE_SIZE * 8);
+
+    for (Payload* object : leftover)
+        allocator.Free(object);
+    CHECK_EQ(allocator.GetStats().liveNodes_, 0);
+}
+
+TEST_CASE("ConcurrentAllocator backs HashMap and List nodes across threads")
+{
+    using namespace Urho3D;
+
+    static const unsigned NUM_THREADS = 4;
+    static const unsigned NUM_ELEMENTS = 500;
+
+    ConcurrentAllocator<HashMap<unsigned, unsigned>::Node> mapNodes;
+    ConcurrentAllocator<List<unsigned>::Node> listNodes;
+    std::vector<HashMap<unsigned, unsigned>> maps(NUM_THREADS);
+    std::vector<List<unsigned>> lists(NUM_THREADS);
+    for (unsigned t = 0; t < NUM_THREADS; ++t)
+    {
+        CHECK(maps[t].SetNodeAllocator(&mapNodes));
+        CHECK(lists[t].SetNodeAllocator(&listNodes));
+    }
+
+    // Each thread fills and partly erases its own containers from the shared pools
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < NUM_THREADS; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (unsigned i = 0; i < NUM_ELEMENTS; ++i)
+            {
+                maps[t][i] = t * NUM_ELEMENTS + i;
+                lists[t].Push(t * NUM_ELEMENTS + i);
+            }
+            for (unsigned i = 0; i < NUM_ELEMENTS; i += 2)
+            {
+                maps[t].Erase(i);
+                lists[t].PopFront();
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    CHECK_EQ(mapNodes.GetStats().liveNodes_, NUM_THREADS * NUM_ELEMENTS / 2);
+    CHECK_EQ(listNodes.GetStats().liveNodes_, NUM_THREADS * NUM_ELEMENTS / 2);
+    for (unsigned t = 0; t < NUM_THREADS; ++t)
+    {
+        CHECK_FALSE(maps[t].SetNodeAllocator(nullptr));
+        CHECK_EQ(maps[t].Size(), NUM_ELEMENTS / 2);
+        CHECK_EQ(lists[t].Size(), NUM_ELEMENTS / 2);
+        CHECK_EQ(maps[t][1], t * NUM_ELEMENTS + 1);
+        CHECK_EQ(lists[t].Front(), t * NUM_ELEMENTS + NUM_ELEMENTS / 2);
+    }
+
+    // Moving keeps the nodes with their allocator, and the main thread frees nodes reserved by the workers
+    HashMap<unsigned, unsigned> moved(std::move(maps[0]));
+    CHECK_EQ(moved.Size(), NUM_ELEMENTS / 2);
+    moved.Clear();
+    maps.clear();
+    lists.clear();
+    CHECK_EQ(mapNodes.GetStats().liveNodes_, 0);
+    CHECK_EQ(listNodes.GetStats().liveNodes_, 0);
+}
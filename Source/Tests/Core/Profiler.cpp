@@ -0,0 +1,96 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstring>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/IO/VectorBuffer.h>
+
+namespace
+{
+
+/// Profile a nested block pair from a worker thread.
+void ProfiledWork(const Urho3D::WorkItem* item, unsigned /*threadIndex*/)
+{
+    auto* profiler = reinterpret_cast<Urho3D::Profiler*>(item->aux_);
+    profiler->BeginBlock("WorkerOuter");
+    profiler->BeginBlock("WorkerInner");
+    profiler->EndBlock();
+    profiler->EndBlock();
+}
+
+}
+
+TEST_CASE("Profiler records per-thread timelines")
+{
+    using namespace Urho3D;
+
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+    auto* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    queue->CreateThreads(2);
+    auto* profiler = new Profiler(context);
+    context->RegisterSubsystem(profiler);
+
+    profiler->BeginFrame();
+    profiler->BeginBlock("MainBlock");
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->workFunction_ = ProfiledWork;
+        item->aux_ = profiler;
+        item->priority_ = M_MAX_UNSIGNED;
+        queue->AddWorkItem(item);
+    }
+    queue->Complete(M_MAX_UNSIGNED);
+    profiler->EndBlock();
+    profiler->EndFrame();
+
+    const PODVector<ProfilerTimelineEvent>& timeline = profiler->GetTimeline();
+    unsigned numMain = 0, numOuter = 0, numInner = 0;
+    for (unsigned i = 0; i < timeline.Size(); ++i)
+    {
+        const ProfilerTimelineEvent& event = timeline[i];
+        CHECK(event.end_ >= event.begin_);
+        CHECK(event.threadIndex_ < profiler->GetNumThreads());
+        if (!strcmp(event.name_, "MainBlock"))
+        {
+            ++numMain;
+            CHECK_EQ(event.threadIndex_, 0);
+            CHECK_EQ(event.depth_, 1);
+        }
+        else if (!strcmp(event.name_, "WorkerOuter"))
+            ++numOuter;
+        else if (!strcmp(event.name_, "WorkerInner"))
+        {
+            ++numInner;
+            // The main thread may take items too, nesting them inside its own open blocks
+            CHECK_EQ(event.depth_, event.threadIndex_ ? 1 : 3);
+        }
+    }
+    CHECK_EQ(numMain, 1);
+    CHECK_EQ(numOuter, 16);
+    CHECK_EQ(numInner, 16);
+
+    VectorBuffer trace;
+    profiler->SaveTrace(trace);
+    String json(reinterpret_cast<const char*>(trace.GetData()), trace.GetSize());
+    CHECK(json.StartsWith("{\"traceEvents\":["));
+    CHECK(json.Contains("\"name\":\"WorkerInner\",\"ph\":\"X\""));
+    CHECK(json.Contains("\"args\":{\"name\":\"Main thread\"}"));
+
+    // Blocks left open span into the next frame
+    profiler->BeginFrame();
+    profiler->BeginBlock("Spanning");
+    profiler->EndFrame();
+    profiler->BeginFrame();
+    profiler->EndBlock();
+    profiler->EndFrame();
+    CHECK_EQ(profiler->GetTimeline().Size(), 2);
+}
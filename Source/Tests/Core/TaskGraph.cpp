@@ -0,0 +1,120 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <atomic>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/TaskGraph.h>
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+
+namespace
+{
+
+/// Record the finishing order of a task into the shared counter.
+void RecordOrderWork(const Urho3D::WorkItem* item, unsigned /*threadIndex*/)
+{
+    auto* counter = reinterpret_cast<std::atomic<unsigned>*>(item->aux_);
+    *reinterpret_cast<unsigned*>(item->start_) = counter->fetch_add(1) + 1;
+}
+
+/// Flag the task started, then give the main thread time to pause the queue before counting it.
+void StartedCountWork(const Urho3D::WorkItem* item, unsigned /*threadIndex*/)
+{
+    reinterpret_cast<std::atomic<bool>*>(item->start_)->store(true);
+    Urho3D::Time::Sleep(10);
+    reinterpret_cast<std::atomic<unsigned>*>(item->aux_)->fetch_add(1);
+}
+
+/// Count a finished task into the shared counter.
+void CountWork(const Urho3D::WorkItem* item, unsigned /*threadIndex*/)
+{
+    reinterpret_cast<std::atomic<unsigned>*>(item->aux_)->fetch_add(1);
+}
+
+}
+
+TEST_CASE("WorkQueue ParallelFor and TaskGraph")
+{
+    using namespace Urho3D;
+
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    auto* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    queue->CreateThreads(3);
+
+    SUBCASE("ParallelFor visits every element once")
+    {
+        PODVector<unsigned> visits(10000);
+        for (unsigned i = 0; i < visits.Size(); ++i)
+            visits[i] = 0;
+
+        queue->ParallelFor(visits.Size(), 7, [&visits](unsigned begin, unsigned end, unsigned threadIndex)
+        {
+            CHECK(threadIndex <= 3);
+            for (unsigned i = begin; i < end; ++i)
+                ++visits[i];
+        });
+
+        unsigned wrong = 0;
+        for (unsigned i = 0; i < visits.Size(); ++i)
+            wrong += visits[i] != 1;
+        CHECK_EQ(wrong, 0);
+    }
+
+    SUBCASE("TaskGraph respects dependencies")
+    {
+        TaskGraph graph(queue);
+        std::atomic<unsigned> counter{};
+        unsigned order[4]{};
+
+        // Diamond: 0 -> (1, 2) -> 3
+        unsigned a = graph.AddTask(RecordOrderWork, &order[0], nullptr, &counter);
+        unsigned b = graph.AddTask(RecordOrderWork, &order[1], nullptr, &counter);
+        unsigned c = graph.AddTask(RecordOrderWork, &order[2], nullptr, &counter);
+        unsigned d = graph.AddTask(RecordOrderWork, &order[3], nullptr, &counter);
+        graph.AddDependency(b, a);
+        graph.AddDependency(c, a);
+        graph.AddDependency(d, b);
+        graph.AddDependency(d, c);
+
+        for (unsigned run = 0; run < 100; ++run)
+        {
+            counter = 0;
+            graph.Run();
+            CHECK_EQ(order[0], 1);
+            CHECK_EQ(order[3], 4);
+        }
+
+        CHECK_FALSE(graph.IsRunning());
+        CHECK_EQ(graph.GetNumTasks(), 4);
+    }
+
+    SUBCASE("TaskGraph overflowing the deques while the queue is paused")
+    {
+        static const unsigned NUM_DEPENDENTS = 10000;
+
+        // A worker thread's root readies more dependents than fit in its deque, while the main thread holds the queue paused
+        TaskGraph graph(queue);
+        std::atomic<unsigned> counter{};
+        std::atomic<bool> started{};
+        unsigned root = graph.AddTask(StartedCountWork, &started, nullptr, &counter);
+        for (unsigned i = 0; i < NUM_DEPENDENTS; ++i)
+            graph.AddDependency(graph.AddTask(CountWork, nullptr, nullptr, &counter), root);
+
+        for (unsigned run = 0; run < 10; ++run)
+        {
+            counter = 0;
+            started = false;
+            graph.Start();
+            while (!started)
+                ;
+            queue->Pause();
+            graph.Wait();
+            CHECK_EQ(counter.load(), NUM_DEPENDENTS + 1);
+        }
+    }
+}
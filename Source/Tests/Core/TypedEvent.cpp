@@ -0,0 +1,296 @@
+#include <doctest/doctest_fwd.h>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Thread.h>
+
+namespace
+{
+
+URHO3D_EVENT(E_TESTTYPED, TestTyped)
+{
+    URHO3D_PARAM(P_VALUE, Value);                  // int
+}
+
+/// Typed payload of E_TESTTYPED.
+struct TestTypedEvent
+{
+    static Urho3D::StringHash GetEventTypeStatic() { return E_TESTTYPED; }
+    void ToVariantMap(Urho3D::VariantMap& eventData) const
+    {
+        eventData[TestTyped::P_VALUE] = value_;
+        ++numFills_;
+    }
+
+    int value_;
+    /// Number of VariantMap parameter fills so far.
+    static int numFills_;
+};
+
+int TestTypedEvent::numFills_ = 0;
+
+/// Object receiving typed and VariantMap events.
+class TestReceiver : public Urho3D::Object
+{
+    URHO3D_OBJECT(TestReceiver, Urho3D::Object);
+
+public:
+    explicit TestReceiver(Urho3D::Context* context) : Urho3D::Object(context) { }
+
+    void HandleTyped(TestTypedEvent& event)
+    {
+        if (order_)
+            order_->Push(this);
+        sum_ += event.value_;
+        ++numCalls_;
+        if (unsubscribeInHandler_)
+            UnsubscribeFromTypedEvent<TestTypedEvent>();
+    }
+
+    void HandleVariantMap(Urho3D::StringHash /*eventType*/, Urho3D::VariantMap& eventData)
+    {
+        if (order_)
+            order_->Push(this);
+        sum_ += eventData[TestTyped::P_VALUE].GetInt();
+        ++numCalls_;
+    }
+
+    int sum_{};
+    int numCalls_{};
+    bool unsubscribeInHandler_{};
+    Urho3D::PODVector<TestReceiver*>* order_{};
+};
+
+}
+
+TEST_CASE("Typed events dispatch and bridge to VariantMap handlers")
+{
+    using namespace Urho3D;
+
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+
+    SharedPtr<TestReceiver> sender(new TestReceiver(context));
+    SharedPtr<TestReceiver> otherSender(new TestReceiver(context));
+    SharedPtr<TestReceiver> any(new TestReceiver(context));
+    SharedPtr<TestReceiver> specific(new TestReceiver(context));
+    SharedPtr<TestReceiver> legacy(new TestReceiver(context));
+
+    any->SubscribeToTypedEvent<TestTypedEvent>(URHO3D_TYPED_HANDLER(TestReceiver, HandleTyped));
+    specific->SubscribeToTypedEvent<TestTypedEvent>(sender, URHO3D_TYPED_HANDLER(TestReceiver, HandleTyped));
+    legacy->SubscribeToEvent(E_TESTTYPED, new EventHandlerImpl<TestReceiver>(legacy, &TestReceiver::HandleVariantMap));
+    CHECK(any->HasSubscribedToTypedEvent<TestTypedEvent>());
+    CHECK(specific->HasSubscribedToTypedEvent<TestTypedEvent>(sender));
+    CHECK_FALSE(specific->HasSubscribedToTypedEvent<TestTypedEvent>(otherSender));
+
+    TestTypedEvent event{3};
+    sender->SendTypedEvent(event);
+    CHECK_EQ(any->sum_, 3);
+    CHECK_EQ(specific->sum_, 3);
+    CHECK_EQ(legacy->sum_, 3);
+
+    // The specific subscriber ignores other senders
+    event.value_ = 5;
+    otherSender->SendTypedEvent(event);
+    CHECK_EQ(any->sum_, 8);
+    CHECK_EQ(specific->sum_, 3);
+    CHECK_EQ(legacy->sum_, 8);
+
+    // Unsubscribing during send leaves the others intact
+    any->unsubscribeInHandler_ = true;
+    sender->SendTypedEvent(event);
+    CHECK_FALSE(any->HasSubscribedToTypedEvent<TestTypedEvent>());
+    sender->SendTypedEvent(event);
+    CHECK_EQ(any->numCalls_, 3);
+    CHECK_EQ(specific->numCalls_, 3);
+
+    // Destroying the sender removes subscriptions filtered on it
+    sender.Reset();
+    TypedEventChannel* channel = context->GetTypedEventChannel(GetTypedEventIndex<TestTypedEvent>());
+    REQUIRE(channel);
+    CHECK(channel->Empty());
+
+    // Destroying a receiver removes its subscription
+    any->SubscribeToTypedEvent<TestTypedEvent>(URHO3D_TYPED_HANDLER(TestReceiver, HandleTyped));
+    CHECK_FALSE(channel->Empty());
+    any.Reset();
+    CHECK(channel->Empty());
+}
+
+TEST_CASE("Typed event subscriptions are kept per sender")
+{
+    using namespace Urho3D;
+
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+
+    SharedPtr<TestReceiver> first(new TestReceiver(context));
+    SharedPtr<TestReceiver> second(new TestReceiver(context));
+    SharedPtr<TestReceiver> receiver(new TestReceiver(context));
+
+    // Subscribing to a second sender does not replace the first, and subscribing again does not duplicate
+    receiver->SubscribeToTypedEvent<TestTypedEvent>(first, URHO3D_TYPED_HANDLER(TestReceiver, HandleTyped));
+    receiver->SubscribeToTypedEvent<TestTypedEvent>(second, URHO3D_TYPED_HANDLER(TestReceiver, HandleTyped));
+    receiver->SubscribeToTypedEvent<TestTypedEvent>(second, URHO3D_TYPED_HANDLER(TestReceiver, HandleTyped));
+    CHECK(receiver->HasSubscribedToTypedEvent<TestTypedEvent>(first));
+    CHECK(receiver->HasSubscribedToTypedEvent<TestTypedEvent>(second));
+
+    TestTypedEvent event{1};
+    first->SendTypedEvent(event);
+    second->SendTypedEvent(event);
+    CHECK_EQ(receiver->numCalls_, 2);
+
+    // Unsubscribing from one sender keeps the other
+    receiver->UnsubscribeFromTypedEvent<TestTypedEvent>(first);
+    CHECK_FALSE(receiver->HasSubscribedToTypedEvent<TestTypedEvent>(first));
+    CHECK(receiver->HasSubscribedToTypedEvent<TestTypedEvent>(second));
+    first->SendTypedEvent(event);
+    second->SendTypedEvent(event);
+    CHECK_EQ(receiver->numCalls_, 3);
+
+    // Destroying one sender keeps the subscription to the other
+    receiver->SubscribeToTypedEvent<TestTypedEvent>(first, URHO3D_TYPED_HANDLER(TestReceiver, HandleTyped));
+    first.Reset();
+    CHECK(receiver->HasSubscribedToTypedEvent<TestTypedEvent>(second));
+    second->SendTypedEvent(event);
+    CHECK_EQ(receiver->numCalls_, 4);
+
+    // Unsubscribing without a sender removes all
+    receiver->SubscribeToTypedEvent<TestTypedEvent>(URHO3D_TYPED_HANDLER(TestReceiver, HandleTyped));
+    receiver->UnsubscribeFromTypedEvent<TestTypedEvent>();
+    CHECK_FALSE(receiver->HasSubscribedToTypedEvent<TestTypedEvent>());
+}
+
+TEST_CASE("Unsubscribing from all events except some handles typed events")
+{
+    using namespace Urho3D;
+
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+
+    SharedPtr<TestReceiver> sender(new TestReceiver(context));
+    SharedPtr<TestReceiver> receiver(new TestReceiver(context));
+    receiver->SubscribeToTypedEvent<TestTypedEvent>(URHO3D_TYPED_HANDLER(TestReceiver, HandleTyped));
+    receiver->SubscribeToTypedEvent<TestTypedEvent>(sender, URHO3D_TYPED_HANDLER(TestReceiver, HandleTyped));
+
+    // Excepted event types and script-only removal keep typed subscriptions
+    PODVector<StringHash> exceptions;
+    exceptions.Push(E_TESTTYPED);
+    receiver->UnsubscribeFromAllEventsExcept(exceptions, false);
+    CHECK(receiver->HasSubscribedToTypedEvent<TestTypedEvent>(sender));
+    receiver->UnsubscribeFromAllEventsExcept(PODVector<StringHash>(), true);
+    CHECK(receiver->HasSubscribedToTypedEvent<TestTypedEvent>(sender));
+
+    receiver->UnsubscribeFromAllEventsExcept(PODVector<StringHash>(), false);
+    CHECK_FALSE(receiver->HasSubscribedToTypedEvent<TestTypedEvent>());
+    TestTypedEvent event{1};
+    sender->SendTypedEvent(event);
+    CHECK_EQ(receiver->numCalls_, 0);
+}
+
+TEST_CASE("Typed events reach the subscribers of the sender first, then of any sender, then VariantMap subscribers")
+{
+    using namespace Urho3D;
+
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+
+    SharedPtr<TestReceiver> sender(new TestReceiver(context));
+    SharedPtr<TestReceiver> legacy(new TestReceiver(context));
+    SharedPtr<TestReceiver> any(new TestReceiver(context));
+    SharedPtr<TestReceiver> both(new TestReceiver(context));
+    SharedPtr<TestReceiver> specific(new TestReceiver(context));
+
+    PODVector<TestReceiver*> order;
+    legacy->order_ = any->order_ = both->order_ = specific->order_ = &order;
+
+    // Subscribe in the opposite order of delivery
+    legacy->SubscribeToEvent(E_TESTTYPED, new EventHandlerImpl<TestReceiver>(legacy, &TestReceiver::HandleVariantMap));
+    any->SubscribeToTypedEvent<TestTypedEvent>(URHO3D_TYPED_HANDLER(TestReceiver, HandleTyped));
+    both->SubscribeToTypedEvent<TestTypedEvent>(URHO3D_TYPED_HANDLER(TestReceiver, HandleTyped));
+    both->SubscribeToTypedEvent<TestTypedEvent>(sender, URHO3D_TYPED_HANDLER(TestReceiver, HandleTyped));
+    specific->SubscribeToTypedEvent<TestTypedEvent>(sender, URHO3D_TYPED_HANDLER(TestReceiver, HandleTyped));
+
+    // A receiver subscribed to the sender and to any sender gets the event once
+    TestTypedEvent event{1};
+    sender->SendTypedEvent(event);
+    REQUIRE_EQ(order.Size(), 4);
+    CHECK_EQ(order[0], both.Get());
+    CHECK_EQ(order[1], specific.Get());
+    CHECK_EQ(order[2], any.Get());
+    CHECK_EQ(order[3], legacy.Get());
+}
+
+TEST_CASE("Typed event subscribers are removed individually and keep their order")
+{
+    using namespace Urho3D;
+
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+
+    SharedPtr<TestReceiver> sender(new TestReceiver(context));
+    Vector<SharedPtr<TestReceiver> > receivers;
+    PODVector<TestReceiver*> order;
+    for (unsigned i = 0; i < 100; ++i)
+    {
+        SharedPtr<TestReceiver> receiver(new TestReceiver(context));
+        receiver->order_ = &order;
+        receiver->SubscribeToTypedEvent<TestTypedEvent>(sender, URHO3D_TYPED_HANDLER(TestReceiver, HandleTyped));
+        receivers.Push(receiver);
+    }
+
+    TypedEventChannel* channel = context->GetTypedEventChannel(GetTypedEventIndex<TestTypedEvent>());
+    REQUIRE(channel);
+    TypedEventSubscriberGroup* group = channel->GetSubscribers(sender);
+    REQUIRE(group);
+    CHECK_EQ(group->GetNumSubscribers(), 100);
+
+    // Keep every third receiver. The holes are compacted once they make up half of the subscribers
+    for (unsigned i = 0; i < receivers.Size(); ++i)
+    {
+        if (i % 3)
+            receivers[i].Reset();
+    }
+    CHECK_EQ(group->GetNumSubscribers(), 34);
+    CHECK(group->subscribers_.Size() < 100);
+
+    TestTypedEvent event{1};
+    sender->SendTypedEvent(event);
+    PODVector<TestReceiver*> expected;
+    for (unsigned i = 0; i < receivers.Size(); ++i)
+    {
+        if (receivers[i])
+            expected.Push(receivers[i]);
+    }
+    CHECK(order == expected);
+
+    // Destroying the sender drops its subscribers, and the receivers forget it
+    sender.Reset();
+    CHECK(channel->Empty());
+    CHECK_FALSE(receivers[0]->HasSubscribedToTypedEvent<TestTypedEvent>());
+}
+
+TEST_CASE("VariantMap parameters are filled from a payload only if there are VariantMap subscribers")
+{
+    using namespace Urho3D;
+
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+
+    SharedPtr<TestReceiver> sender(new TestReceiver(context));
+    SharedPtr<TestReceiver> typed(new TestReceiver(context));
+    typed->SubscribeToTypedEvent<TestTypedEvent>(URHO3D_TYPED_HANDLER(TestReceiver, HandleTyped));
+
+    TestTypedEvent::numFills_ = 0;
+    TestTypedEvent event{2};
+    sender->SendTypedEvent(event);
+    sender->SendEventFromPayload(E_TESTTYPED, event);
+    CHECK_EQ(typed->sum_, 2);
+    CHECK_EQ(TestTypedEvent::numFills_, 0);
+
+    SharedPtr<TestReceiver> legacy(new TestReceiver(context));
+    legacy->SubscribeToEvent(sender, E_TESTTYPED, new EventHandlerImpl<TestReceiver>(legacy, &TestReceiver::HandleVariantMap));
+    sender->SendEventFromPayload(E_TESTTYPED, event);
+    CHECK_EQ(TestTypedEvent::numFills_, 1);
+    CHECK_EQ(legacy->sum_, 2);
+    CHECK_EQ(typed->sum_, 2);
+}
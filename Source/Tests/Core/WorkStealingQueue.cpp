@@ -0,0 +1,80 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <atomic>
+#include <thread>
+#include <vector>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#include <Urho3D/Core/WorkStealingQueue.h>
+
+TEST_CASE("WorkStealingQueue")
+{
+    using namespace Urho3D;
+
+    WorkStealingQueue<unsigned, 16> queue;
+    unsigned value = 0;
+
+    // Owner end is LIFO, steal end is FIFO
+    CHECK(queue.Empty());
+    CHECK(queue.Push(1));
+    CHECK(queue.Push(2));
+    CHECK(queue.Push(3));
+    CHECK_EQ(queue.Size(), 3);
+    CHECK(queue.Pop(value));
+    CHECK_EQ(value, 3);
+    CHECK(queue.Steal(value));
+    CHECK_EQ(value, 1);
+    CHECK(queue.Pop(value));
+    CHECK_EQ(value, 2);
+    CHECK_FALSE(queue.Pop(value));
+    CHECK_FALSE(queue.Steal(value));
+
+    // Bounded capacity
+    for (unsigned i = 0; i < 16; ++i)
+        CHECK(queue.Push(i));
+    CHECK_FALSE(queue.Push(16));
+}
+
+TEST_CASE("WorkStealingQueue concurrent steal")
+{
+    using namespace Urho3D;
+
+    constexpr unsigned NUM_VALUES = 100000;
+    WorkStealingQueue<unsigned, 1024> queue;
+    std::atomic<unsigned long long> sum{};
+    std::atomic<bool> done{};
+
+    std::vector<std::thread> thieves;
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        thieves.emplace_back([&]()
+        {
+            unsigned value;
+            while (!done || !queue.Empty())
+            {
+                if (queue.Steal(value))
+                    sum += value;
+            }
+        });
+    }
+
+    // Every value must be consumed exactly once, either by the owner or by a thief
+    unsigned value;
+    for (unsigned i = 1; i <= NUM_VALUES; ++i)
+    {
+        while (!queue.Push(i))
+        {
+            if (queue.Pop(value))
+                sum += value;
+        }
+    }
+    while (queue.Pop(value))
+        sum += value;
+
+    done = true;
+    for (std::thread& thief : thieves)
+        thief.join();
+
+    CHECK_EQ(sum.load(), (unsigned long long)NUM_VALUES * (NUM_VALUES + 1) / 2);
+}
@@ -0,0 +1,301 @@
+#include <doctest/doctest_fwd.h>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Graphics/Animation.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Resource/ResourceCache.h>
+
+namespace
+{
+
+using namespace Urho3D;
+
+constexpr float POSITION_TOLERANCE = 0.001f;
+constexpr float ROTATION_TOLERANCE = 0.05f;
+constexpr float SCALE_TOLERANCE = 0.001f;
+constexpr unsigned NUM_KEYS = 61;
+constexpr float KEY_INTERVAL = 1.0f / 30.0f;
+
+/// Return angle between rotations in degrees, ignoring the sign of the quaternion. Uses the chord length, as the arc cosine of a dot product near one is not precise enough for small angles.
+float GetAngle(const Quaternion& lhs, const Quaternion& rhs)
+{
+    const Quaternion a = lhs.Normalized();
+    Quaternion b = rhs.Normalized();
+    if (a.DotProduct(b) < 0.0f)
+        b = -b;
+    const Quaternion delta = a - b;
+    return 4.0f * Asin(Min(0.5f * sqrtf(delta.LengthSquared()), 1.0f));
+}
+
+/// Return the summed memory use of the tracks.
+unsigned GetTracksMemoryUse(const Animation* animation)
+{
+    unsigned memoryUse = 0;
+    const HashMap<StringHash, AnimationTrack>& tracks = animation->GetTracks();
+    for (HashMap<StringHash, AnimationTrack>::ConstIterator i = tracks.Begin(); i != tracks.End(); ++i)
+        memoryUse += i->second_.GetMemoryUse();
+    return memoryUse;
+}
+
+/// Return the keyframe track interpolated at time, as animation playback does.
+AnimationKeyFrame SampleKeyFrames(const AnimationTrack& track, float time)
+{
+    unsigned index = 0;
+    track.GetKeyFrameIndex(time, index);
+    const AnimationKeyFrame& key = track.keyFrames_[index];
+    if (index + 1 >= track.keyFrames_.Size())
+        return key;
+
+    const AnimationKeyFrame& nextKey = track.keyFrames_[index + 1];
+    const float t = (time - key.time_) / (nextKey.time_ - key.time_);
+    AnimationKeyFrame result;
+    result.time_ = time;
+    result.position_ = key.position_.Lerp(nextKey.position_, t);
+    result.rotation_ = key.rotation_.Slerp(nextKey.rotation_, t);
+    result.scale_ = key.scale_.Lerp(nextKey.scale_, t);
+    return result;
+}
+
+/// Create a track with smooth motion on all channels, some of it linear so that keys can be dropped.
+void CreateMotionTrack(Animation* animation, const String& name, float phase)
+{
+    AnimationTrack* track = animation->CreateTrack(name);
+    track->channelMask_ = CHANNEL_POSITION | CHANNEL_ROTATION | CHANNEL_SCALE;
+    for (unsigned i = 0; i < NUM_KEYS; ++i)
+    {
+        const float time = i * KEY_INTERVAL;
+        AnimationKeyFrame key;
+        key.time_ = time;
+        key.position_ = Vector3(Sin(time * 180.0f + phase), time * 0.5f, Cos(time * 90.0f) * 2.0f);
+        key.rotation_ = Quaternion(time * 120.0f + phase, Vector3(1.0f, 2.0f, 0.5f).Normalized()) * Quaternion(Sin(time * 360.0f) * 30.0f, Vector3::UP);
+        key.scale_ = Vector3::ONE * (1.0f + 0.2f * Sin(time * 270.0f));
+        track->AddKeyFrame(key);
+    }
+}
+
+/// Create an animation with moving tracks and a still track.
+SharedPtr<Animation> CreateAnimation(Context* context)
+{
+    SharedPtr<Animation> animation(new Animation(context));
+    animation->SetAnimationName("Test");
+    animation->SetLength((NUM_KEYS - 1) * KEY_INTERVAL);
+    CreateMotionTrack(animation, "Root", 0.0f);
+    CreateMotionTrack(animation, "Arm", 45.0f);
+
+    AnimationTrack* still = animation->CreateTrack("Still");
+    still->channelMask_ = CHANNEL_POSITION | CHANNEL_ROTATION;
+    for (unsigned i = 0; i < NUM_KEYS; ++i)
+    {
+        AnimationKeyFrame key;
+        key.time_ = i * KEY_INTERVAL;
+        key.position_ = Vector3(0.25f, -1.5f, 3.0f) + Vector3::ONE * (i % 2 ? 0.0001f : 0.0f);
+        key.rotation_ = Quaternion(30.0f, Vector3::RIGHT);
+        still->AddKeyFrame(key);
+    }
+    return animation;
+}
+
+/// Compress a single rotation key and return it decoded.
+Quaternion RoundTripRotation(const Quaternion& rotation)
+{
+    AnimationTrack track;
+    track.channelMask_ = CHANNEL_ROTATION;
+    AnimationKeyFrame key;
+    key.rotation_ = rotation;
+    track.AddKeyFrame(key);
+    track.Compress(POSITION_TOLERANCE, ROTATION_TOLERANCE, SCALE_TOLERANCE);
+    REQUIRE(track.IsCompressed());
+    REQUIRE_EQ(track.rotationCurve_.GetNumKeys(), 1);
+    return track.rotationCurve_.GetQuaternion(0);
+}
+
+}
+
+TEST_CASE("Smallest-three rotation encoding round trips each omitted component and sign")
+{
+    // Quantization error of a component is half a step over the 2 * sqrt(0.5) range, plus the reconstructed largest one
+    const float componentError = 1e-4f;
+
+    for (unsigned largest = 0; largest < 4; ++largest)
+    {
+        for (float sign : {1.0f, -1.0f})
+        {
+            float data[4] = { 0.3f, -0.4f, 0.2f, -0.1f };
+            data[largest] = 0.8f * sign;
+            const Quaternion rotation = Quaternion(data[0], data[1], data[2], data[3]).Normalized();
+
+            const Quaternion decoded = RoundTripRotation(rotation);
+            CHECK(Abs(decoded.LengthSquared() - 1.0f) < 1e-4f);
+
+            // The omitted component is reconstructed as positive, so the decoded quaternion has the opposite sign for a negative one
+            const Quaternion expected = rotation.Data()[largest] < 0.0f ? -rotation : rotation;
+            for (unsigned i = 0; i < 4; ++i)
+                CHECK(Abs(decoded.Data()[i] - expected.Data()[i]) < componentError);
+            CHECK(GetAngle(decoded, rotation) < 0.02f);
+        }
+    }
+
+    // Identity, and two equally large components where the others reach the end of the quantization range
+    const Quaternion edgeCases[] = {
+        Quaternion::IDENTITY,
+        Quaternion(0.0f, 0.0f, 0.0f, -1.0f),
+        Quaternion(0.70710678f, 0.0f, -0.70710678f, 0.0f),
+        Quaternion(0.5f, -0.5f, 0.5f, -0.5f),
+    };
+    for (const Quaternion& rotation : edgeCases)
+        CHECK(GetAngle(RoundTripRotation(rotation), rotation) < 0.02f);
+}
+
+TEST_CASE("Animation compression collapses constant channels to one key")
+{
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Animation> animation = CreateAnimation(context);
+    animation->Compress(POSITION_TOLERANCE, ROTATION_TOLERANCE, SCALE_TOLERANCE);
+    REQUIRE(animation->IsCompressed());
+
+    // Position noise below the tolerance is dropped, and the single key keeps the first value exactly
+    AnimationTrack* still = animation->GetTrack(String("Still"));
+    REQUIRE(still);
+    CHECK(still->IsCompressed());
+    CHECK(still->keyFrames_.Empty());
+    CHECK_EQ(still->positionCurve_.GetNumKeys(), 1);
+    CHECK_EQ(still->rotationCurve_.GetNumKeys(), 1);
+    CHECK_EQ(still->scaleCurve_.GetNumKeys(), 0);
+    CHECK_EQ(still->positionCurve_.GetVector3(0), Vector3(0.25f, -1.5f, 3.0f));
+    CHECK(GetAngle(still->rotationCurve_.GetQuaternion(0), Quaternion(30.0f, Vector3::RIGHT)) < 0.02f);
+
+    unsigned index = 0;
+    CHECK_EQ(still->positionCurve_.SampleVector3(1.3f, animation->GetLength(), true, index), Vector3(0.25f, -1.5f, 3.0f));
+
+    // Moving channels keep more keys, but the linear position axis lets some be dropped
+    AnimationTrack* root = animation->GetTrack(String("Root"));
+    REQUIRE(root);
+    CHECK_GT(root->positionCurve_.GetNumKeys(), 1);
+    CHECK_LT(root->positionCurve_.GetNumKeys(), NUM_KEYS);
+    CHECK_GT(root->rotationCurve_.GetNumKeys(), 1);
+    CHECK_GT(root->scaleCurve_.GetNumKeys(), 1);
+}
+
+TEST_CASE("Compressed animation samples within the tolerances of the keyframes")
+{
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Animation> original = CreateAnimation(context);
+    SharedPtr<Animation> compressed = original->Clone();
+    compressed->Compress(POSITION_TOLERANCE, ROTATION_TOLERANCE, SCALE_TOLERANCE);
+    CHECK_LT(GetTracksMemoryUse(compressed), GetTracksMemoryUse(original));
+
+    // Dropped keys are reproduced within tolerance of the quantized values, which differ by less than a quantization step
+    const float vectorSlack = 1e-4f;
+    const float rotationSlack = 0.02f;
+
+    for (const char* name : {"Root", "Arm", "Still"})
+    {
+        const AnimationTrack* track = original->GetTrack(String(name));
+        const AnimationTrack* curves = compressed->GetTrack(String(name));
+        REQUIRE(track);
+        REQUIRE(curves);
+        REQUIRE(curves->IsCompressed());
+
+        // Sample at the keys and halfway between them, with the curve cursors moving forward as in playback
+        unsigned positionIndex = 0;
+        unsigned rotationIndex = 0;
+        unsigned scaleIndex = 0;
+        float maxPositionError = 0.0f;
+        float maxRotationError = 0.0f;
+        float maxScaleError = 0.0f;
+        for (unsigned i = 0; i < (NUM_KEYS - 1) * 2; ++i)
+        {
+            const float time = i * KEY_INTERVAL * 0.5f;
+            const AnimationKeyFrame expected = SampleKeyFrames(*track, time);
+            const float length = compressed->GetLength();
+
+            maxPositionError = Max(maxPositionError,
+                (curves->positionCurve_.SampleVector3(time, length, false, positionIndex) - expected.position_).Length());
+            maxRotationError = Max(maxRotationError,
+                GetAngle(curves->rotationCurve_.SampleQuaternion(time, length, false, rotationIndex), expected.rotation_));
+            if (track->channelMask_ & CHANNEL_SCALE)
+            {
+                maxScaleError = Max(maxScaleError,
+                    (curves->scaleCurve_.SampleVector3(time, length, false, scaleIndex) - expected.scale_).Length());
+            }
+        }
+
+        INFO(name);
+        CHECK(maxPositionError <= POSITION_TOLERANCE + vectorSlack);
+        CHECK(maxRotationError <= ROTATION_TOLERANCE + rotationSlack);
+        CHECK(maxScaleError <= SCALE_TOLERANCE + vectorSlack);
+    }
+
+    // Decompressing places keyframes at the kept key times, where they match the curves
+    SharedPtr<Animation> decompressed = compressed->Clone();
+    decompressed->Decompress();
+    CHECK_FALSE(decompressed->IsCompressed());
+    const AnimationTrack* curves = compressed->GetTrack(String("Root"));
+    const AnimationTrack* track = decompressed->GetTrack(String("Root"));
+    REQUIRE(track);
+    CHECK_FALSE(track->IsCompressed());
+    CHECK_GE(track->GetNumKeyFrames(), curves->rotationCurve_.GetNumKeys());
+    CHECK_LE(track->GetNumKeyFrames(), NUM_KEYS);
+    for (unsigned i = 0; i < track->GetNumKeyFrames(); ++i)
+    {
+        const AnimationKeyFrame& key = track->keyFrames_[i];
+        unsigned index = 0;
+        CHECK((curves->positionCurve_.SampleVector3(key.time_, 0.0f, false, index) - key.position_).Length() < 1e-5f);
+        index = 0;
+        CHECK(GetAngle(curves->rotationCurve_.SampleQuaternion(key.time_, 0.0f, false, index), key.rotation_) < 0.01f);
+    }
+}
+
+TEST_CASE("Compressed animation saves and loads unchanged")
+{
+    SharedPtr<Context> context(new Context());
+    // Loading looks for trigger files through the resource cache
+    context->RegisterSubsystem(new FileSystem(context));
+    context->RegisterSubsystem(new ResourceCache(context));
+    SharedPtr<Animation> compressed = CreateAnimation(context);
+    compressed->Compress(POSITION_TOLERANCE, ROTATION_TOLERANCE, SCALE_TOLERANCE);
+
+    VectorBuffer buffer;
+    REQUIRE(compressed->Save(buffer));
+    buffer.Seek(0);
+    CHECK_EQ(buffer.ReadFileID(), "UANC");
+    buffer.Seek(0);
+
+    SharedPtr<Animation> loaded(new Animation(context));
+    REQUIRE(loaded->Load(buffer));
+    CHECK(loaded->IsCompressed());
+    CHECK_EQ(loaded->GetAnimationName(), compressed->GetAnimationName());
+    CHECK_EQ(loaded->GetLength(), compressed->GetLength());
+    REQUIRE_EQ(loaded->GetNumTracks(), compressed->GetNumTracks());
+    CHECK_EQ(loaded->GetMemoryUse(), compressed->GetMemoryUse());
+
+    for (const char* name : {"Root", "Arm", "Still"})
+    {
+        const AnimationTrack* expected = compressed->GetTrack(String(name));
+        const AnimationTrack* track = loaded->GetTrack(String(name));
+        REQUIRE(track);
+        INFO(name);
+        CHECK(track->IsCompressed());
+        CHECK_EQ(track->channelMask_, expected->channelMask_);
+
+        const AnimationCurve* loadedCurves[] = { &track->positionCurve_, &track->rotationCurve_, &track->scaleCurve_ };
+        const AnimationCurve* expectedCurves[] = { &expected->positionCurve_, &expected->rotationCurve_, &expected->scaleCurve_ };
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            CHECK(loadedCurves[i]->times_ == expectedCurves[i]->times_);
+            CHECK(loadedCurves[i]->values_ == expectedCurves[i]->values_);
+        }
+        CHECK_EQ(track->positionCurve_.min_, expected->positionCurve_.min_);
+        CHECK_EQ(track->positionCurve_.step_, expected->positionCurve_.step_);
+        CHECK_EQ(track->scaleCurve_.min_, expected->scaleCurve_.min_);
+        CHECK_EQ(track->scaleCurve_.step_, expected->scaleCurve_.step_);
+    }
+
+    // An uncompressed animation keeps its keyframe format
+    SharedPtr<Animation> keyFrames = CreateAnimation(context);
+    VectorBuffer keyFrameBuffer;
+    REQUIRE(keyFrames->Save(keyFrameBuffer));
+    keyFrameBuffer.Seek(0);
+    CHECK_EQ(keyFrameBuffer.ReadFileID(), "UANI");
+}
@@ -0,0 +1,259 @@
+#include <doctest/doctest_fwd.h>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/AnimatedModel.h>
+#include <Urho3D/Graphics/Animation.h>
+#include <Urho3D/Graphics/AnimationScheduler.h>
+#include <Urho3D/Graphics/AnimationState.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+using namespace Urho3D;
+
+constexpr unsigned NUM_BONES = 3;
+constexpr float TIME_STEP = 0.05f;
+
+/// Create a skinned model with a chain of bones and an empty geometry.
+SharedPtr<Model> CreateModel(Context* context)
+{
+    SharedPtr<Model> model(new Model(context));
+    model->SetNumGeometries(1);
+    model->SetNumGeometryLodLevels(0, 1);
+    model->SetGeometry(0, 0, new Geometry(context));
+    model->SetBoundingBox(BoundingBox(-1.0f, 1.0f));
+
+    Skeleton skeleton;
+    for (unsigned i = 0; i < NUM_BONES; ++i)
+    {
+        Bone bone;
+        bone.name_ = "Bone" + String(i);
+        bone.nameHash_ = bone.name_;
+        bone.parentIndex_ = i ? i - 1 : 0;
+        bone.initialPosition_ = Vector3(0.0f, i ? 0.5f : 0.0f, 0.0f);
+        skeleton.GetModifiableBones().Push(bone);
+    }
+    skeleton.SetRootBoneIndex(0);
+    model->SetSkeleton(skeleton);
+    return model;
+}
+
+/// Create an animation moving the root bone at constant speed, so that every evaluation at a new time gives a new pose.
+SharedPtr<Animation> CreateAnimation(Context* context)
+{
+    SharedPtr<Animation> animation(new Animation(context));
+    animation->SetAnimationName("Move");
+    animation->SetLength(100.0f);
+    AnimationTrack* track = animation->CreateTrack("Bone0");
+    track->channelMask_ = CHANNEL_POSITION;
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        AnimationKeyFrame key;
+        key.time_ = i * 100.0f;
+        key.position_ = Vector3(i * 100.0f, 0.0f, 0.0f);
+        track->AddKeyFrame(key);
+    }
+    return animation;
+}
+
+/// Scene with pose buffer animated models.
+struct SchedulerScene
+{
+    SchedulerScene(Context* context, unsigned count) :
+        scene_(new Scene(context)),
+        model_(CreateModel(context)),
+        animation_(CreateAnimation(context))
+    {
+        scene_->CreateComponent<Octree>();
+        for (unsigned i = 0; i < count; ++i)
+        {
+            auto* model = scene_->CreateChild()->CreateComponent<AnimatedModel>();
+            model->SetModel(model_);
+            model->SetUsePoseBuffer(true);
+            AnimationState* state = model->AddAnimationState(animation_);
+            state->SetWeight(1.0f);
+            models_.Push(WeakPtr<AnimatedModel>(model));
+        }
+    }
+
+    /// Advance the animations of all models.
+    void AddTime()
+    {
+        for (unsigned i = 0; i < models_.Size(); ++i)
+        {
+            if (models_[i])
+                models_[i]->GetAnimationState(0u)->AddTime(TIME_STEP);
+        }
+    }
+
+    /// Return root bone position of a model from its pose buffer, or a negative value if not evaluated yet.
+    float GetPosePosition(unsigned index) const
+    {
+        const PODVector<BonePose>& poses = models_[index]->GetBonePoses();
+        return poses.Empty() ? -1.0f : poses[0].position_.x_;
+    }
+
+    /// Queue all models for the next update.
+    void Queue(AnimationScheduler& scheduler, bool far)
+    {
+        scheduler.Reserve(models_.Size());
+        for (unsigned i = 0; i < models_.Size(); ++i)
+        {
+            if (models_[i])
+                CHECK(scheduler.Queue(models_[i], far));
+        }
+    }
+
+    SharedPtr<Scene> scene_;
+    SharedPtr<Model> model_;
+    SharedPtr<Animation> animation_;
+    Vector<WeakPtr<AnimatedModel> > models_;
+};
+
+/// Create the execution context with worker threads and the scene and graphics libraries.
+SharedPtr<Context> CreateContext()
+{
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    auto* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    queue->CreateThreads(2);
+    RegisterSceneLibrary(context);
+    RegisterGraphicsLibrary(context);
+    return context;
+}
+
+}
+
+TEST_CASE("Animation scheduler evaluates each queued model once per frame")
+{
+    SharedPtr<Context> context = CreateContext();
+    auto* queue = context->GetSubsystem<WorkQueue>();
+    SchedulerScene scene(context, 40);
+    AnimationScheduler scheduler;
+
+    FrameInfo frame;
+    frame.frameNumber_ = 1;
+    scene.AddTime();
+
+    // Queued twice, but still evaluated once
+    scene.Queue(scheduler, false);
+    scene.Queue(scheduler, false);
+    scheduler.Update(frame, queue);
+    CHECK_EQ(scheduler.GetNumEvaluated(), 40);
+    CHECK_FALSE(scheduler.HasQueued());
+    for (unsigned i = 0; i < 40; ++i)
+        CHECK(Abs(scene.GetPosePosition(i) - TIME_STEP) < 1e-4f);
+
+    // Models which are up to date are not evaluated again within the frame
+    scene.Queue(scheduler, false);
+    scheduler.Update(frame, queue);
+    CHECK_EQ(scheduler.GetNumEvaluated(), 40);
+
+    // Refused beyond the reserved room
+    scheduler.Reserve(1);
+    CHECK(scheduler.Queue(scene.models_[0], false));
+    CHECK_FALSE(scheduler.Queue(scene.models_[1], false));
+
+    ++frame.frameNumber_;
+    scene.AddTime();
+    scheduler.Update(frame, queue);
+    CHECK_EQ(scheduler.GetNumEvaluated(), 1);
+    CHECK(Abs(scene.GetPosePosition(0) - 2.0f * TIME_STEP) < 1e-4f);
+    CHECK(Abs(scene.GetPosePosition(1) - TIME_STEP) < 1e-4f);
+}
+
+TEST_CASE("Animation scheduler drains deferred models in order within the budget")
+{
+    SharedPtr<Context> context = CreateContext();
+    auto* queue = context->GetSubsystem<WorkQueue>();
+    SchedulerScene scene(context, 6);
+    AnimationScheduler scheduler;
+    FrameInfo frame;
+    frame.frameNumber_ = 0;
+
+    // Measure the bone cost first, until then the budget can not be applied
+    for (unsigned i = 0; i < 100 && scheduler.GetBoneCost() <= 0.0f; ++i)
+    {
+        ++frame.frameNumber_;
+        scene.AddTime();
+        scene.Queue(scheduler, false);
+        scheduler.Update(frame, queue);
+    }
+    REQUIRE(scheduler.GetBoneCost() > 0.0f);
+
+    // A budget too small for any model still takes one model per frame, the oldest first
+    scheduler.SetFarBudget(1e-9f);
+    scene.AddTime();
+    scene.Queue(scheduler, true);
+    CHECK_EQ(scheduler.GetNumDeferred(), 0);
+
+    PODVector<float> positions;
+    for (unsigned i = 0; i < scene.models_.Size(); ++i)
+        positions.Push(scene.GetPosePosition(i));
+
+    for (unsigned i = 0; i < scene.models_.Size(); ++i)
+    {
+        ++frame.frameNumber_;
+        scheduler.Update(frame, queue);
+        CHECK_EQ(scheduler.GetNumEvaluated(), 1);
+        CHECK_EQ(scheduler.GetNumDeferred(), scene.models_.Size() - 1 - i);
+        for (unsigned j = 0; j < scene.models_.Size(); ++j)
+        {
+            INFO("frame " << i << " model " << j);
+            CHECK_EQ(scene.GetPosePosition(j) != positions[j], j <= i);
+        }
+
+        // Only once per frame
+        scheduler.Update(frame, queue);
+        CHECK_EQ(scheduler.GetNumEvaluated(), 1);
+    }
+
+    // Without a budget all deferred models are taken at once
+    scheduler.SetFarBudget(0.0f);
+    scene.AddTime();
+    scene.Queue(scheduler, true);
+    ++frame.frameNumber_;
+    scheduler.Update(frame, queue);
+    CHECK_EQ(scheduler.GetNumEvaluated(), scene.models_.Size());
+    CHECK_EQ(scheduler.GetNumDeferred(), 0);
+}
+
+TEST_CASE("Animation scheduler skips destroyed and removed deferred models")
+{
+    SharedPtr<Context> context = CreateContext();
+    auto* queue = context->GetSubsystem<WorkQueue>();
+    SchedulerScene scene(context, 4);
+    AnimationScheduler scheduler;
+    FrameInfo frame;
+    frame.frameNumber_ = 1;
+
+    // Deferred models are taken once per frame, so queueing after the frame's first update keeps them waiting
+    scheduler.Update(frame, queue);
+    scene.AddTime();
+    scene.Queue(scheduler, true);
+    scheduler.Update(frame, queue);
+    CHECK_EQ(scheduler.GetNumEvaluated(), 0);
+    CHECK_EQ(scheduler.GetNumDeferred(), 4);
+
+    // Destroy one model and remove another from the octree while they wait
+    scene.models_[1]->GetNode()->Remove();
+    CHECK_FALSE(scene.models_[1]);
+    scene.models_[2]->SetEnabled(false);
+    CHECK_FALSE(scene.models_[2]->GetOctant());
+
+    ++frame.frameNumber_;
+    scheduler.Update(frame, queue);
+    CHECK_EQ(scheduler.GetNumEvaluated(), 2);
+    CHECK_EQ(scheduler.GetNumDeferred(), 0);
+    CHECK(Abs(scene.GetPosePosition(0) - TIME_STEP) < 1e-4f);
+    CHECK_LT(scene.GetPosePosition(2), 0.0f);
+    CHECK(Abs(scene.GetPosePosition(3) - TIME_STEP) < 1e-4f);
+}
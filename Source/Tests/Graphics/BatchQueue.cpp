@@ -0,0 +1,202 @@
+#include <doctest/doctest_fwd.h>
+
+#include <Urho3D/Graphics/Batch.h>
+#include <Urho3D/Math/Random.h>
+
+namespace
+{
+
+using namespace Urho3D;
+
+/// Return a key which refers to fake geometry and material, as the queue only compares and hashes the pointers.
+BatchGroupKey MakeKey(unsigned geometry, unsigned material)
+{
+    Batch batch;
+    batch.geometry_ = reinterpret_cast<Geometry*>((size_t)geometry * 64);
+    batch.material_ = reinterpret_cast<Material*>((size_t)material * 64);
+    return BatchGroupKey(batch);
+}
+
+/// Fill the queue with enough random batches to be radix sorted.
+void AddRandomBatches(BatchQueue& queue)
+{
+    SetRandomSeed(1);
+    queue.Clear(1000);
+    for (unsigned i = 0; i < 5000; ++i)
+    {
+        Batch batch;
+        batch.renderOrder_ = (unsigned char)(Rand() % 3 * 64);
+        batch.distance_ = (float)(Rand() % 1000) * 0.25f;
+        // Same layout as Batch::CalculateSortKey(): shaders in the high, material and geometry in the low 32 bits
+        batch.sortKey_ = (unsigned long long)(Rand() % 8) << 32u | (unsigned long long)(Rand() % 4) << 16u | (Rand() % 4);
+        queue.batches_.Push(batch);
+    }
+}
+
+}
+
+TEST_CASE("BatchQueue sorts batches back to front")
+{
+    BatchQueue queue;
+    AddRandomBatches(queue);
+    queue.SortBackToFront();
+
+    const PODVector<Batch*>& sorted = queue.sortedBatches_;
+    REQUIRE_EQ(sorted.Size(), queue.batches_.Size());
+    for (unsigned i = 1; i < sorted.Size(); ++i)
+    {
+        const Batch* lhs = sorted[i - 1];
+        const Batch* rhs = sorted[i];
+        REQUIRE(lhs->renderOrder_ <= rhs->renderOrder_);
+        if (lhs->renderOrder_ == rhs->renderOrder_)
+        {
+            REQUIRE(lhs->distance_ >= rhs->distance_);
+            if (lhs->distance_ == rhs->distance_)
+                REQUIRE(lhs->sortKey_ <= rhs->sortKey_);
+        }
+    }
+}
+
+TEST_CASE("BatchQueue sorts batches by state and then front to back")
+{
+    BatchQueue queue;
+    AddRandomBatches(queue);
+    PODVector<unsigned long long> originalKeys;
+    for (unsigned i = 0; i < queue.batches_.Size(); ++i)
+        originalKeys.Push(queue.batches_[i].sortKey_);
+
+    // The batches are given an instancing group too, whose instances are sorted as well
+    BatchGroup& group = queue.GetGroup(MakeKey(1, 1));
+    for (unsigned i = 0; i < 500; ++i)
+        group.instances_.Push(InstanceData(nullptr, nullptr, (float)(Rand() % 100)));
+
+    queue.SortFrontToBack();
+
+    // Sort keys are remapped, but batches which had the same state still do, and are front to back among themselves
+    const PODVector<Batch*>& sorted = queue.sortedBatches_;
+    REQUIRE_EQ(sorted.Size(), queue.batches_.Size());
+    for (unsigned i = 1; i < sorted.Size(); ++i)
+    {
+        const Batch* lhs = sorted[i - 1];
+        const Batch* rhs = sorted[i];
+        REQUIRE(lhs->renderOrder_ <= rhs->renderOrder_);
+        if (lhs->renderOrder_ == rhs->renderOrder_)
+        {
+            REQUIRE(lhs->sortKey_ <= rhs->sortKey_);
+            if (lhs->sortKey_ == rhs->sortKey_)
+            {
+                REQUIRE_EQ(originalKeys[lhs - queue.batches_.Buffer()], originalKeys[rhs - queue.batches_.Buffer()]);
+                REQUIRE(lhs->distance_ <= rhs->distance_);
+            }
+        }
+    }
+
+    for (unsigned i = 1; i < group.instances_.Size(); ++i)
+        REQUIRE(group.instances_[i - 1].distance_ <= group.instances_[i].distance_);
+    CHECK_EQ(group.distance_, group.instances_[0].distance_);
+}
+
+TEST_CASE("BatchQueue keeps groups between frames")
+{
+    BatchQueue queue;
+    queue.Clear(1000);
+
+    // First frame creates the groups
+    for (unsigned i = 0; i < 100; ++i)
+    {
+        BatchGroup& group = queue.GetGroup(MakeKey(i % 10, 0));
+        CHECK_EQ(group.instances_.Empty(), i < 10);
+        group.instances_.Push(InstanceData());
+    }
+    queue.RemoveEmptyGroups();
+    REQUIRE_EQ(queue.batchGroups_.Size(), 10);
+    BatchGroup* kept = &queue.GetGroup(MakeKey(3, 0));
+    CHECK_EQ(kept->instances_.Size(), 10);
+
+    // Next frame finds the same groups emptied but with their memory
+    queue.ClearInstances(1000);
+    CHECK_EQ(queue.batchGroups_.Size(), 10);
+    CHECK_FALSE(queue.IsEmpty());
+    BatchGroup& group = queue.GetGroup(MakeKey(3, 0));
+    CHECK_EQ(&group, kept);
+    CHECK(group.instances_.Empty());
+    CHECK_GE(group.instances_.Capacity(), 10);
+    group.instances_.Push(InstanceData());
+
+    // A changed key goes to a new group, and the groups which received nothing are dropped
+    queue.GetGroup(MakeKey(3, 1)).instances_.Push(InstanceData());
+    queue.GetGroup(MakeKey(3, 1)).instances_.Push(InstanceData());
+    queue.RemoveEmptyGroups();
+    CHECK_EQ(queue.batchGroups_.Size(), 2);
+    CHECK_EQ(queue.GetGroup(MakeKey(3, 0)).instances_.Size(), 1);
+    CHECK_EQ(queue.GetGroup(MakeKey(3, 1)).instances_.Size(), 2);
+
+    // Nothing left to draw once a frame adds no instances at all
+    queue.ClearInstances(1000);
+    queue.RemoveEmptyGroups();
+    CHECK(queue.IsEmpty());
+}
+
+TEST_CASE("BatchQueue writes skinned and billboard instances")
+{
+    BatchQueue queue;
+    queue.Clear(1000);
+
+    // Two skinned models of three bones become one instance each, whose skin matrices go to the skin matrix texture
+    Matrix3x4 skinMatrices[2][3];
+    BatchGroup& skinnedGroup = queue.GetGroup(MakeKey(1, 1));
+    skinnedGroup.geometryType_ = GEOM_SKINNED_INSTANCED;
+    skinnedGroup.numWorldTransforms_ = 3;
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        for (unsigned j = 0; j < 3; ++j)
+            skinMatrices[i][j] = Matrix3x4(Vector3((float)i, (float)j, 0.0f), Quaternion::IDENTITY, 1.0f);
+
+        Batch batch;
+        batch.geometryType_ = GEOM_SKINNED_INSTANCED;
+        batch.worldTransform_ = skinMatrices[i];
+        batch.numWorldTransforms_ = 3;
+        skinnedGroup.AddTransforms(batch);
+    }
+    REQUIRE_EQ(skinnedGroup.instances_.Size(), 2);
+
+    // Below the instancing limit the group is drawn one model at a time and writes nothing
+    Matrix3x4 unusedTransform;
+    BatchGroup& staticGroup = queue.GetGroup(MakeKey(2, 1));
+    staticGroup.geometryType_ = GEOM_SKINNED;
+    staticGroup.instances_.Push(InstanceData(&unusedTransform, nullptr, 0.0f));
+
+    // Billboards are instanced even when drawn back to front outside a group
+    Matrix3x4 billboards[4];
+    for (unsigned i = 0; i < 4; ++i)
+        billboards[i].m00_ = (float)(i + 1);
+    Batch billboardBatch;
+    billboardBatch.geometryType_ = GEOM_BILLBOARD_INSTANCED;
+    billboardBatch.worldTransform_ = billboards;
+    billboardBatch.numWorldTransforms_ = 4;
+    queue.batches_.Push(billboardBatch);
+
+    REQUIRE_EQ(queue.GetNumInstances(), 6);
+    Matrix3x4 instanceData[6];
+    PODVector<Matrix3x4> textureData;
+    unsigned freeIndex = 0;
+    queue.SetInstancingData(instanceData, sizeof(Matrix3x4), freeIndex, textureData);
+
+    CHECK_EQ(freeIndex, 6);
+    CHECK_EQ(skinnedGroup.startIndex_, 0);
+    CHECK_EQ(staticGroup.startIndex_, M_MAX_UNSIGNED);
+    CHECK_EQ(queue.batches_[0].startIndex_, 2);
+
+    // Skinned instances refer to their first texel, three per matrix
+    REQUIRE_EQ(textureData.Size(), 6);
+    CHECK_EQ(instanceData[0].m00_, 0.0f);
+    CHECK_EQ(instanceData[1].m00_, 9.0f);
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        for (unsigned j = 0; j < 3; ++j)
+            CHECK(textureData[i * 3 + j] == skinMatrices[i][j]);
+    }
+
+    for (unsigned i = 0; i < 4; ++i)
+        CHECK(instanceData[2 + i] == billboards[i]);
+}
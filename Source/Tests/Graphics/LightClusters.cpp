@@ -0,0 +1,137 @@
+#include <doctest/doctest_fwd.h>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Light.h>
+#include <Urho3D/Graphics/LightClusters.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+using namespace Urho3D;
+
+/// Create random point and spot lights in front of a camera at the origin looking along +Z, some behind it or crossing its near plane.
+PODVector<Light*> CreateLights(Scene* scene, unsigned count)
+{
+    PODVector<Light*> lights;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        Node* lightNode = scene->CreateChild("Light");
+        lightNode->SetPosition(Vector3(Random(-40.0f, 40.0f), Random(-20.0f, 20.0f), Random(-5.0f, 80.0f)));
+        lightNode->SetDirection(Vector3(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f)));
+        auto* light = lightNode->CreateComponent<Light>();
+        light->SetLightType(i & 1u ? LIGHT_SPOT : LIGHT_POINT);
+        light->SetRange(Random(1.0f, 10.0f));
+        light->SetFov(Random(20.0f, 90.0f));
+        lights.Push(light);
+    }
+    return lights;
+}
+
+bool IsLit(Light* light, const Vector3& position)
+{
+    if (light->GetLightType() == LIGHT_SPOT)
+        return light->GetFrustum().IsInside(position) != OUTSIDE;
+    return (position - light->GetNode()->GetWorldPosition()).Length() < light->GetRange();
+}
+
+}
+
+TEST_CASE("Light clusters list every light which reaches a position")
+{
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    auto* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    queue->CreateThreads(3);
+
+    Camera::RegisterObject(context);
+    Light::RegisterObject(context);
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* camera = scene->CreateChild("Camera")->CreateComponent<Camera>();
+    camera->SetAspectRatio(16.0f / 9.0f);
+    camera->SetFarClip(100.0f);
+
+    SetRandomSeed(1);
+    const PODVector<Light*> lights = CreateLights(scene, 150);
+    SharedPtr<LightClusters> clusters(new LightClusters(context));
+    clusters->Build(camera, lights);
+
+    // Lights entirely behind the camera are left out, the rest keep their order
+    REQUIRE(clusters->GetNumLights() > 0);
+    REQUIRE(clusters->GetNumLights() < lights.Size());
+    for (unsigned i = 1; i < clusters->GetNumLights(); ++i)
+        REQUIRE(lights.IndexOf(clusters->GetLight(i - 1)) < lights.IndexOf(clusters->GetLight(i)));
+
+    unsigned numTested = 0;
+    unsigned numLit = 0;
+    for (unsigned i = 0; i < 5000; ++i)
+    {
+        const Vector3 position(Random(-50.0f, 50.0f), Random(-30.0f, 30.0f), Random(0.0f, 90.0f));
+        const unsigned cluster = clusters->GetCluster(position);
+        if (cluster == M_MAX_UNSIGNED)
+            continue;
+        ++numTested;
+
+        const unsigned numClusterLights = clusters->GetNumClusterLights(cluster);
+        REQUIRE(numClusterLights < MAX_LIGHTS_PER_CLUSTER);
+        for (unsigned j = 0; j < lights.Size(); ++j)
+        {
+            if (!IsLit(lights[j], position))
+                continue;
+            ++numLit;
+
+            bool found = false;
+            for (unsigned k = 0; k < numClusterLights; ++k)
+                found |= clusters->GetLight(clusters->GetClusterLight(cluster, k)) == lights[j];
+            REQUIRE(found);
+        }
+    }
+
+    CHECK_GT(numTested, 1000);
+    CHECK_GT(numLit, 100);
+
+    // All light indices fit the cluster texture
+    unsigned numLightIndices = 0;
+    for (unsigned i = 0; i < NUM_CLUSTERS; ++i)
+        numLightIndices += clusters->GetNumClusterLights(i);
+    CHECK_EQ(clusters->GetNumLightIndices(), numLightIndices);
+}
+
+TEST_CASE("Light clusters take at most the maximum number of lights")
+{
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new WorkQueue(context));
+
+    Camera::RegisterObject(context);
+    Light::RegisterObject(context);
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* camera = scene->CreateChild("Camera")->CreateComponent<Camera>();
+
+    PODVector<Light*> lights;
+    for (unsigned i = 0; i < MAX_CLUSTERED_LIGHTS + 10; ++i)
+    {
+        Node* lightNode = scene->CreateChild("Light");
+        lightNode->SetPosition(Vector3(0.0f, 0.0f, 10.0f + i * 0.1f));
+        auto* light = lightNode->CreateComponent<Light>();
+        light->SetLightType(LIGHT_POINT);
+        light->SetRange(1.0f);
+        lights.Push(light);
+    }
+
+    SharedPtr<LightClusters> clusters(new LightClusters(context));
+    clusters->Build(camera, lights);
+    CHECK_EQ(clusters->GetNumLights(), MAX_CLUSTERED_LIGHTS);
+    CHECK_EQ(clusters->GetLight(MAX_CLUSTERED_LIGHTS - 1), lights[MAX_CLUSTERED_LIGHTS - 1]);
+
+    // Full clusters keep the first lights
+    const unsigned cluster = clusters->GetCluster(Vector3(0.0f, 0.0f, 10.0f));
+    REQUIRE(cluster != M_MAX_UNSIGNED);
+    CHECK_EQ(clusters->GetNumClusterLights(cluster), MAX_LIGHTS_PER_CLUSTER);
+    CHECK_EQ(clusters->GetClusterLight(cluster, 0), 0);
+}
@@ -0,0 +1,138 @@
+#include <doctest/doctest_fwd.h>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/OcclusionBuffer.h>
+#include <Urho3D/Math/BoundingBox.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+using namespace Urho3D;
+
+constexpr int BUFFER_WIDTH = 64;
+constexpr int BUFFER_HEIGHT = 48;
+
+/// Return random triangles in front of a camera at the origin looking along +Z, some of them crossing the view edges.
+PODVector<Vector3> MakeTriangles(unsigned count)
+{
+    PODVector<Vector3> vertices;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        Vector3 center(Random(-12.0f, 12.0f), Random(-9.0f, 9.0f), Random(8.0f, 30.0f));
+        for (unsigned j = 0; j < 3; ++j)
+            vertices.Push(center + Vector3(Random(-4.0f, 4.0f), Random(-4.0f, 4.0f), Random(-2.0f, 2.0f)));
+    }
+    return vertices;
+}
+
+void DrawTriangles(OcclusionBuffer* buffer, Camera* camera, const PODVector<Vector3>& vertices)
+{
+    buffer->SetView(camera);
+    buffer->SetCullMode(CULL_NONE);
+    buffer->SetMaxTriangles(M_MAX_UNSIGNED);
+    buffer->Clear();
+
+    // Submit in a few batches, so that threads set up triangles concurrently
+    const unsigned batchSize = 30;
+    for (unsigned i = 0; i < vertices.Size(); i += batchSize)
+        buffer->AddTriangles(Matrix3x4::IDENTITY, &vertices[i], sizeof(Vector3), 0, Min(batchSize, vertices.Size() - i));
+    buffer->DrawTriangles();
+    buffer->BuildDepthHierarchy();
+}
+
+}
+
+TEST_CASE("Threaded occlusion rendering matches single-threaded rendering")
+{
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    auto* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    queue->CreateThreads(3);
+
+    Camera::RegisterObject(context);
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* camera = scene->CreateChild("Camera")->CreateComponent<Camera>();
+    camera->SetAspectRatio((float)BUFFER_WIDTH / BUFFER_HEIGHT);
+
+    SharedPtr<OcclusionBuffer> single(new OcclusionBuffer(context));
+    SharedPtr<OcclusionBuffer> threaded(new OcclusionBuffer(context));
+    REQUIRE(single->SetSize(BUFFER_WIDTH, BUFFER_HEIGHT, false));
+    REQUIRE(threaded->SetSize(BUFFER_WIDTH, BUFFER_HEIGHT, true));
+    CHECK_FALSE(single->IsThreaded());
+    CHECK(threaded->IsThreaded());
+
+    SetRandomSeed(1);
+    const PODVector<Vector3> vertices = MakeTriangles(600);
+    DrawTriangles(single, camera, vertices);
+    DrawTriangles(threaded, camera, vertices);
+    CHECK_EQ(single->GetNumTriangles(), threaded->GetNumTriangles());
+
+    // Rasterizing in bands steps the edges exactly as rasterizing whole triangles, so the depth must be the same
+    unsigned numDifferent = 0;
+    unsigned numCovered = 0;
+    for (int i = 0; i < BUFFER_WIDTH * BUFFER_HEIGHT; ++i)
+    {
+        if (single->GetBuffer()[i] != threaded->GetBuffer()[i])
+            ++numDifferent;
+        if (single->GetBuffer()[i] < (int)OCCLUSION_Z_SCALE)
+            ++numCovered;
+    }
+    CHECK_EQ(numDifferent, 0);
+    CHECK_GT(numCovered, BUFFER_WIDTH * BUFFER_HEIGHT / 2);
+}
+
+TEST_CASE("Batched occludee tests match one box at a time")
+{
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new WorkQueue(context));
+
+    Camera::RegisterObject(context);
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* camera = scene->CreateChild("Camera")->CreateComponent<Camera>();
+    camera->SetAspectRatio((float)BUFFER_WIDTH / BUFFER_HEIGHT);
+
+    // A wall 10 units away hides the left half of the view
+    SharedPtr<OcclusionBuffer> buffer(new OcclusionBuffer(context));
+    REQUIRE(buffer->SetSize(BUFFER_WIDTH, BUFFER_HEIGHT, false));
+    PODVector<Vector3> wall;
+    wall.Push(Vector3(-50.0f, -50.0f, 10.0f));
+    wall.Push(Vector3(-50.0f, 50.0f, 10.0f));
+    wall.Push(Vector3(-1.0f, 50.0f, 10.0f));
+    wall.Push(Vector3(-50.0f, -50.0f, 10.0f));
+    wall.Push(Vector3(-1.0f, 50.0f, 10.0f));
+    wall.Push(Vector3(-1.0f, -50.0f, 10.0f));
+    DrawTriangles(buffer, camera, wall);
+
+    CHECK_FALSE(buffer->IsVisible(BoundingBox(Vector3(-6.0f, -1.0f, 20.0f), Vector3(-4.0f, 1.0f, 22.0f))));
+    CHECK(buffer->IsVisible(BoundingBox(Vector3(-6.0f, -1.0f, 5.0f), Vector3(-4.0f, 1.0f, 7.0f))));
+    CHECK(buffer->IsVisible(BoundingBox(Vector3(4.0f, -1.0f, 20.0f), Vector3(6.0f, 1.0f, 22.0f))));
+
+    SetRandomSeed(2);
+    PODVector<BoundingBox> boxes;
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        Vector3 center(Random(-30.0f, 30.0f), Random(-20.0f, 20.0f), Random(-5.0f, 40.0f));
+        Vector3 halfSize(Random(0.1f, 3.0f), Random(0.1f, 3.0f), Random(0.1f, 3.0f));
+        boxes.Push(BoundingBox(center - halfSize, center + halfSize));
+    }
+
+    PODVector<bool> visible(boxes.Size());
+    buffer->IsVisible(boxes.Buffer(), boxes.Size(), visible.Buffer());
+    unsigned numOccluded = 0;
+    for (unsigned i = 0; i < boxes.Size(); ++i)
+    {
+        REQUIRE_EQ(visible[i], buffer->IsVisible(boxes[i]));
+        if (!visible[i])
+            ++numOccluded;
+    }
+    CHECK_GT(numOccluded, 0);
+    CHECK_LT(numOccluded, boxes.Size());
+}
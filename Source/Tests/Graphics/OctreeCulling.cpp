@@ -0,0 +1,423 @@
+#include <doctest/doctest_fwd.h>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Drawable.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/OctreeQuery.h>
+#include <Urho3D/Graphics/OctreeSnapshot.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+using namespace Urho3D;
+
+/// Box drawable of random size which needs no graphics subsystem.
+class TestBox : public Drawable
+{
+    URHO3D_OBJECT(TestBox, Drawable);
+
+public:
+    explicit TestBox(Context* context) :
+        Drawable(context, DRAWABLE_GEOMETRY)
+    {
+        boundingBox_ = BoundingBox(-0.5f, 0.5f);
+    }
+
+    /// Change the local bounding box without moving the node.
+    void SetSize(float size)
+    {
+        boundingBox_ = BoundingBox(-0.5f * size, 0.5f * size);
+        OnMarkedDirty(node_);
+    }
+
+protected:
+    void OnWorldBoundingBoxUpdate() override
+    {
+        worldBoundingBox_ = boundingBox_.Transformed(node_->GetWorldTransform());
+    }
+};
+
+/// Frustum query which tests the drawables one at a time, as before packed bounds.
+class ReferenceFrustumQuery : public FrustumOctreeQuery
+{
+public:
+    ReferenceFrustumQuery(PODVector<Drawable*>& result, const Frustum& frustum, unsigned viewMask) :
+        FrustumOctreeQuery(result, frustum, DRAWABLE_GEOMETRY, viewMask)
+    {
+    }
+
+    void TestPackedDrawables(Drawable** drawables, const PackedDrawableBounds& bounds, bool inside) override
+    {
+        OctreeQuery::TestPackedDrawables(drawables, bounds, inside);
+    }
+};
+
+bool CompareDrawablePointers(Drawable* lhs, Drawable* rhs)
+{
+    return lhs < rhs;
+}
+
+/// Return drawables inside several frusta, sorted.
+void GetFrustumResults(Octree* octree, PODVector<Drawable*>& result)
+{
+    result.Clear();
+    PODVector<Drawable*> queryResult;
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        Frustum frustum;
+        frustum.Define(60.0f, 1.0f, 1.0f, 0.1f, 80.0f, Matrix3x4(Vector3::ZERO, Quaternion(i * 45.0f, Vector3::UP), Vector3::ONE));
+        FrustumOctreeQuery query(queryResult, frustum, DRAWABLE_GEOMETRY);
+        octree->GetDrawables(query);
+        result.Push(queryResult);
+    }
+
+    Sort(result.Begin(), result.End(), CompareDrawablePointers);
+}
+
+/// Return drawables hit by rays through both raycast functions, sorted.
+void GetRaycastResults(Octree* octree, PODVector<Drawable*>& result, PODVector<Drawable*>& singleResult)
+{
+    result.Clear();
+    singleResult.Clear();
+    PODVector<RayQueryResult> rayResult;
+
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        Ray ray(Vector3(0.0f, 0.0f, 0.0f), Quaternion(i * 22.5f, Vector3::UP) * Vector3::FORWARD);
+        RayOctreeQuery query(rayResult, ray, RAY_AABB, 150.0f, DRAWABLE_GEOMETRY);
+        octree->Raycast(query);
+        for (unsigned j = 0; j < rayResult.Size(); ++j)
+            result.Push(rayResult[j].drawable_);
+        octree->RaycastSingle(query);
+        if (rayResult.Size())
+            singleResult.Push(rayResult[0].drawable_);
+    }
+
+    Sort(result.Begin(), result.End(), CompareDrawablePointers);
+}
+
+/// Cull with several frusta through the packed and reference paths and compare the results.
+void CompareQueries(Octree* octree)
+{
+    PODVector<Drawable*> result;
+    PODVector<Drawable*> reference;
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        Frustum frustum;
+        frustum.Define(60.0f, 1.0f, 1.0f, 0.1f, 80.0f, Matrix3x4(Vector3(0.0f, 0.0f, i * 5.0f - 20.0f),
+            Quaternion(i * 45.0f, Vector3::UP), Vector3::ONE));
+        const unsigned viewMask = i & 1 ? DEFAULT_VIEWMASK : 1;
+
+        FrustumOctreeQuery query(result, frustum, DRAWABLE_GEOMETRY, viewMask);
+        octree->GetDrawables(query);
+        ReferenceFrustumQuery referenceQuery(reference, frustum, viewMask);
+        octree->GetDrawables(referenceQuery);
+
+        Sort(result.Begin(), result.End(), CompareDrawablePointers);
+        Sort(reference.Begin(), reference.End(), CompareDrawablePointers);
+        REQUIRE_EQ(result.Size(), reference.Size());
+        CHECK(result == reference);
+    }
+}
+
+}
+
+TEST_CASE("Packed octant bounds cull the same drawables as per-drawable tests")
+{
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new WorkQueue(context));
+    RegisterSceneLibrary(context);
+    Octree::RegisterObject(context);
+    context->RegisterFactory<TestBox>();
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* octree = scene->CreateComponent<Octree>();
+    octree->SetSize(BoundingBox(-100.0f, 100.0f), 6);
+
+    PODVector<Node*> nodes;
+    PODVector<TestBox*> boxes;
+    SetRandomSeed(1);
+    for (unsigned i = 0; i < 3000; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition(Vector3(Random(-120.0f, 120.0f), Random(-20.0f, 20.0f), Random(-120.0f, 120.0f)));
+        auto* box = node->CreateComponent<TestBox>();
+        box->SetSize(Random(0.1f, 40.0f));
+        box->SetViewMask(Random(2) ? 1 : 2);
+        nodes.Push(node);
+        boxes.Push(box);
+    }
+
+    FrameInfo frame;
+    frame.frameNumber_ = 1;
+    octree->Update(frame);
+    CompareQueries(octree);
+
+    // Moved and resized drawables are culled correctly before the octree update reinserts them
+    for (unsigned i = 0; i < nodes.Size(); i += 3)
+        nodes[i]->Translate(Vector3(Random(-30.0f, 30.0f), 0.0f, Random(-30.0f, 30.0f)));
+    for (unsigned i = 1; i < boxes.Size(); i += 7)
+        boxes[i]->SetSize(Random(0.1f, 60.0f));
+    CompareQueries(octree);
+
+    ++frame.frameNumber_;
+    octree->Update(frame);
+    CompareQueries(octree);
+
+    // View mask changes and removals keep the packed copies in step
+    for (unsigned i = 2; i < boxes.Size(); i += 5)
+        boxes[i]->SetViewMask(boxes[i]->GetViewMask() ^ 3);
+    for (unsigned i = nodes.Size() - 1; i < nodes.Size(); i -= 11)
+        nodes[i]->Remove();
+    CompareQueries(octree);
+
+    ++frame.frameNumber_;
+    octree->Update(frame);
+    CompareQueries(octree);
+}
+
+TEST_CASE("Octants keep packed bounds only above the drawable count threshold")
+{
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new WorkQueue(context));
+    RegisterSceneLibrary(context);
+    Octree::RegisterObject(context);
+    context->RegisterFactory<TestBox>();
+
+    // Boxes of at least half the octree size are kept in the root octant
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* octree = scene->CreateComponent<Octree>();
+    octree->SetSize(BoundingBox(-100.0f, 100.0f), 4);
+
+    PODVector<Node*> nodes;
+    SetRandomSeed(1);
+    FrameInfo frame{};
+    for (unsigned i = 0; i < PACKED_BOUNDS_THRESHOLD; ++i)
+    {
+        CHECK_FALSE(octree->HasPackedBounds());
+        Node* node = scene->CreateChild();
+        node->SetPosition(Vector3(Random(-300.0f, 300.0f), Random(-20.0f, 20.0f), Random(-300.0f, 300.0f)));
+        auto* box = node->CreateComponent<TestBox>();
+        box->SetSize(Random(100.0f, 150.0f));
+        box->SetViewMask(Random(2) ? 1 : 2);
+        nodes.Push(node);
+        ++frame.frameNumber_;
+        octree->Update(frame);
+    }
+    CHECK_EQ(octree->GetNumDrawables(), PACKED_BOUNDS_THRESHOLD);
+    CHECK(octree->HasPackedBounds());
+    CompareQueries(octree);
+
+    // Removing drawables keeps the packed bounds down to half of the threshold, then drops them
+    while (nodes.Size() >= PACKED_BOUNDS_THRESHOLD / 2)
+    {
+        CHECK(octree->HasPackedBounds());
+        CompareQueries(octree);
+        nodes.Back()->Remove();
+        nodes.Pop();
+    }
+    CHECK_FALSE(octree->HasPackedBounds());
+    CompareQueries(octree);
+}
+
+TEST_CASE("AABB tree spatial index returns the same drawables as the octree")
+{
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    auto* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    queue->CreateThreads(2);
+    RegisterSceneLibrary(context);
+    Octree::RegisterObject(context);
+    context->RegisterFactory<TestBox>();
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* octree = scene->CreateComponent<Octree>();
+    octree->SetSize(BoundingBox(-100.0f, 100.0f), 6);
+
+    PODVector<Node*> nodes;
+    SetRandomSeed(2);
+    for (unsigned i = 0; i < 2000; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition(Vector3(Random(-120.0f, 120.0f), Random(-20.0f, 20.0f), Random(-120.0f, 120.0f)));
+        auto* box = node->CreateComponent<TestBox>();
+        box->SetSize(Random(0.1f, 10.0f));
+        box->SetOccludee(i % 10 != 0);
+        nodes.Push(node);
+    }
+
+    FrameInfo frame;
+    frame.frameNumber_ = 1;
+    octree->Update(frame);
+
+    PODVector<Drawable*> octreeFrustum;
+    PODVector<Drawable*> treeFrustum;
+    PODVector<Drawable*> octreeRays;
+    PODVector<Drawable*> treeRays;
+    PODVector<Drawable*> octreeSingle;
+    PODVector<Drawable*> treeSingle;
+
+    for (unsigned step = 0; step < 4; ++step)
+    {
+        // Run the same queries with both indices
+        octree->SetSpatialIndex(SPATIAL_INDEX_OCTREE);
+        ++frame.frameNumber_;
+        octree->Update(frame);
+        CHECK_EQ(octree->GetAabbTree().GetNumProxies(), 0);
+        GetFrustumResults(octree, octreeFrustum);
+        GetRaycastResults(octree, octreeRays, octreeSingle);
+
+        octree->SetSpatialIndex(SPATIAL_INDEX_AABB_TREE);
+        ++frame.frameNumber_;
+        octree->Update(frame);
+        CHECK(octree->GetAabbTree().Validate());
+        unsigned numOccludees = 0;
+        for (unsigned i = 0; i < nodes.Size(); ++i)
+            numOccludees += nodes[i]->GetComponent<TestBox>()->IsOccludee() ? 1 : 0;
+        CHECK_EQ(octree->GetAabbTree().GetNumProxies(), numOccludees);
+        GetFrustumResults(octree, treeFrustum);
+        GetRaycastResults(octree, treeRays, treeSingle);
+
+        CHECK_EQ(octree->GetNumDrawables(), nodes.Size());
+        CHECK(octreeFrustum == treeFrustum);
+        CHECK(octreeRays == treeRays);
+        CHECK(octreeSingle == treeSingle);
+
+        // Move some drawables a little and some far, then remove a few, updating the tree in place
+        for (unsigned i = step; i < nodes.Size(); i += 4)
+            nodes[i]->Translate(Vector3(i & 1 ? 0.01f : Random(-40.0f, 40.0f), 0.0f, 0.0f));
+        ++frame.frameNumber_;
+        octree->Update(frame);
+        CHECK(octree->GetAabbTree().Validate());
+        for (unsigned i = 0; i < 10; ++i)
+        {
+            nodes.Back()->Remove();
+            nodes.Pop();
+        }
+    }
+}
+
+TEST_CASE("Octree records where drawables changed during each update")
+{
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new WorkQueue(context));
+    RegisterSceneLibrary(context);
+    Octree::RegisterObject(context);
+    context->RegisterFactory<TestBox>();
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* octree = scene->CreateComponent<Octree>();
+    octree->SetSize(BoundingBox(-100.0f, 100.0f), 6);
+
+    PODVector<Node*> nodes;
+    for (unsigned i = 0; i < 10; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition(Vector3(i * 10.0f - 50.0f, 0.0f, 0.0f));
+        node->CreateComponent<TestBox>();
+        nodes.Push(node);
+    }
+
+    FrameInfo frame;
+    frame.frameNumber_ = 1;
+    octree->Update(frame);
+    const unsigned numUpdates = octree->GetNumUpdates();
+
+    // A static scene changes nothing
+    ++frame.frameNumber_;
+    octree->Update(frame);
+    CHECK_EQ(octree->GetNumUpdates(), numUpdates + 1);
+    CHECK(octree->GetChangedBoxes().Empty());
+    CHECK_FALSE(octree->HasChangeOverflow());
+
+    // A moved drawable changes both where it was and where it went, a removed one where it was
+    nodes[0]->SetPosition(Vector3(-50.0f, 0.0f, 20.0f));
+    nodes[9]->Remove();
+    nodes[5]->GetComponent<TestBox>()->SetCastShadows(true);
+    ++frame.frameNumber_;
+    octree->Update(frame);
+    const PODVector<BoundingBox>& changes = octree->GetChangedBoxes();
+    CHECK(changes.Contains(BoundingBox(Vector3(-50.5f, -0.5f, -0.5f), Vector3(-49.5f, 0.5f, 0.5f))));
+    CHECK(changes.Contains(BoundingBox(Vector3(-50.5f, -0.5f, 19.5f), Vector3(-49.5f, 0.5f, 20.5f))));
+    CHECK(changes.Contains(BoundingBox(Vector3(39.5f, -0.5f, -0.5f), Vector3(40.5f, 0.5f, 0.5f))));
+    CHECK(changes.Contains(BoundingBox(Vector3(-0.5f, -0.5f, -0.5f), Vector3(0.5f, 0.5f, 0.5f))));
+
+    // The changes are only kept for one update
+    ++frame.frameNumber_;
+    octree->Update(frame);
+    CHECK(octree->GetChangedBoxes().Empty());
+
+    // Too many changes are reported as an overflow instead
+    for (unsigned i = 0; i <= MAX_OCTREE_CHANGES; ++i)
+        scene->CreateChild()->CreateComponent<TestBox>();
+    ++frame.frameNumber_;
+    octree->Update(frame);
+    CHECK(octree->HasChangeOverflow());
+    CHECK(octree->GetChangedBoxes().Empty());
+}
+
+TEST_CASE("Snapshot queries test drawables which changed after the snapshot again")
+{
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    auto* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    queue->CreateThreads(2);
+    RegisterSceneLibrary(context);
+    Octree::RegisterObject(context);
+    context->RegisterFactory<TestBox>();
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* octree = scene->CreateComponent<Octree>();
+    octree->SetSize(BoundingBox(-100.0f, 100.0f), 6);
+    octree->SetSnapshotEnabled(true);
+
+    PODVector<Node*> nodes;
+    for (unsigned i = 0; i < 10; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition(Vector3(i * 10.0f - 50.0f, 0.0f, 0.0f));
+        node->CreateComponent<TestBox>();
+        nodes.Push(node);
+    }
+
+    FrameInfo frame;
+    frame.frameNumber_ = 1;
+    octree->Update(frame);
+
+    // Cull the snapshot while the scene advances: drawables move out of and into the view, leave and enter the octree
+    Frustum frustum;
+    frustum.Define(BoundingBox(Vector3(-25.0f, -5.0f, -5.0f), Vector3(25.0f, 5.0f, 5.0f)));
+    SnapshotFrustumQuery snapshotQuery(queue);
+    REQUIRE(snapshotQuery.Start(octree, frustum, DRAWABLE_GEOMETRY, DEFAULT_VIEWMASK));
+
+    nodes[5]->SetPosition(Vector3(0.0f, 0.0f, 50.0f));
+    nodes[9]->SetPosition(Vector3(5.0f, 0.0f, 0.0f));
+    nodes[4]->Remove();
+    Node* addedNode = scene->CreateChild();
+    addedNode->SetPosition(Vector3(15.0f, 0.0f, 0.0f));
+    addedNode->CreateComponent<TestBox>();
+    ++frame.frameNumber_;
+    octree->Update(frame);
+
+    PODVector<Drawable*> result;
+    REQUIRE(snapshotQuery.Finish(octree, result));
+    PODVector<Drawable*> reference;
+    FrustumOctreeQuery query(reference, frustum, DRAWABLE_GEOMETRY);
+    octree->GetDrawables(query);
+
+    Sort(result.Begin(), result.End(), CompareDrawablePointers);
+    Sort(reference.Begin(), reference.End(), CompareDrawablePointers);
+    CHECK_EQ(reference.Size(), 5);
+    CHECK(result == reference);
+}
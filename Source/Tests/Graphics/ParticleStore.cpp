@@ -0,0 +1,109 @@
+#include <doctest/doctest_fwd.h>
+
+#include <Urho3D/Graphics/ParticleStore.h>
+#include <Urho3D/Math/Random.h>
+
+namespace
+{
+
+using namespace Urho3D;
+
+/// Fill all slots with random particles and activate the given number.
+void CreateParticles(ParticleStore& store, unsigned capacity, unsigned numActive)
+{
+    store.Resize(capacity);
+    for (unsigned i = 0; i < capacity; ++i)
+    {
+        store.positionX_[i] = Random(-1.0f, 1.0f);
+        store.positionY_[i] = Random(-1.0f, 1.0f);
+        store.positionZ_[i] = Random(-1.0f, 1.0f);
+        store.velocityX_[i] = i % 17 ? Random(-2.0f, 2.0f) : 0.0f;
+        store.velocityY_[i] = i % 17 ? Random(-2.0f, 2.0f) : 0.0f;
+        store.velocityZ_[i] = i % 17 ? Random(-2.0f, 2.0f) : 0.0f;
+        store.sizeX_[i] = store.sizeY_[i] = 1.0f;
+        store.scale_[i] = Random(0.0f, 0.05f);
+        store.timer_[i] = Random(1.0f);
+        store.timeToLive_[i] = Random(1.0f);
+        store.rotation_[i] = Random(360.0f);
+        store.rotationSpeed_[i] = Random(-90.0f, 90.0f);
+        store.colorIndex_[i] = i;
+        store.texIndex_[i] = i;
+    }
+    store.numActive_ = 0;
+    CHECK_EQ(store.Emit(numActive), numActive);
+}
+
+}
+
+TEST_CASE("Particle store integrates active particles only")
+{
+    SetRandomSeed(1);
+
+    ParticleStore store;
+    CreateParticles(store, 120, 103);
+    const ParticleStore original = store;
+
+    const float timeStep = 0.1f;
+    const Vector3 force(0.0f, -9.81f, 1.0f);
+    const float damping = 0.5f;
+    const Vector3 positionScale(1.0f, 2.0f, 0.5f);
+    store.Integrate(timeStep, force, damping, positionScale, -0.1f, 1.5f);
+
+    for (unsigned i = 0; i < store.GetCapacity(); ++i)
+    {
+        if (i >= store.numActive_)
+        {
+            CHECK_EQ(store.timer_[i], original.timer_[i]);
+            CHECK_EQ(store.positionX_[i], original.positionX_[i]);
+            continue;
+        }
+
+        Vector3 velocity(original.velocityX_[i], original.velocityY_[i], original.velocityZ_[i]);
+        velocity += timeStep * force;
+        velocity += timeStep * (-damping * velocity);
+        const Vector3 position = Vector3(original.positionX_[i], original.positionY_[i], original.positionZ_[i]) +
+            timeStep * velocity * positionScale;
+        const Vector3 direction = velocity.Normalized();
+        const float scale = Max(original.scale_[i] - 0.1f * timeStep, 0.0f) * (timeStep * 0.5f + 1.0f);
+
+        CHECK(Equals(store.timer_[i], original.timer_[i] + timeStep));
+        CHECK((Vector3(store.velocityX_[i], store.velocityY_[i], store.velocityZ_[i]) - velocity).Length() < 1e-5f);
+        CHECK((Vector3(store.positionX_[i], store.positionY_[i], store.positionZ_[i]) - position).Length() < 1e-5f);
+        CHECK((Vector3(store.directionX_[i], store.directionY_[i], store.directionZ_[i]) - direction).Length() < 1e-5f);
+        CHECK(Equals(store.rotation_[i], original.rotation_[i] + timeStep * original.rotationSpeed_[i]));
+        CHECK(Abs(store.scale_[i] - scale) < 1e-6f);
+    }
+}
+
+TEST_CASE("Particle store keeps active particles packed")
+{
+    SetRandomSeed(2);
+
+    ParticleStore store;
+    CreateParticles(store, 100, 90);
+    CHECK_EQ(store.Emit(20), 10);
+    CHECK_EQ(store.numActive_, 100);
+
+    // Every particle which lives on is kept once, identified by its color index
+    const ParticleStore original = store;
+    store.RemoveExpired();
+    unsigned numAlive = 0;
+    for (unsigned i = 0; i < original.numActive_; ++i)
+        numAlive += original.timer_[i] < original.timeToLive_[i];
+    REQUIRE_EQ(store.numActive_, numAlive);
+
+    PODVector<bool> seen(original.GetCapacity(), false);
+    for (unsigned i = 0; i < store.numActive_; ++i)
+    {
+        const unsigned id = store.colorIndex_[i];
+        CHECK_LT(store.timer_[i], store.timeToLive_[i]);
+        CHECK_FALSE(seen[id]);
+        CHECK_EQ(store.timer_[i], original.timer_[id]);
+        CHECK_EQ(store.velocityY_[i], original.velocityY_[id]);
+        CHECK_EQ(store.texIndex_[i], id);
+        seen[id] = true;
+    }
+
+    store.Resize(numAlive / 2);
+    CHECK_EQ(store.numActive_, numAlive / 2);
+}
@@ -0,0 +1,192 @@
+#include <doctest/doctest_fwd.h>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/AnimatedModel.h>
+#include <Urho3D/Graphics/Animation.h>
+#include <Urho3D/Graphics/AnimationState.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+using namespace Urho3D;
+
+/// Bone names, parent indices and bind pose offsets of a small skeleton with two branches.
+const char* BONE_NAMES[] = { "Root", "Spine", "Arm", "Hand", "Leg" };
+const unsigned BONE_PARENTS[] = { 0, 0, 1, 2, 0 };
+const Vector3 BONE_OFFSETS[] = { Vector3(0.0f, 1.0f, 0.0f), Vector3(0.0f, 0.5f, 0.0f), Vector3(0.4f, 0.3f, 0.0f),
+    Vector3(0.5f, 0.0f, 0.0f), Vector3(0.2f, -0.5f, 0.0f) };
+constexpr unsigned NUM_BONES = 5;
+
+/// Create a skinned model with the skeleton and an empty geometry.
+SharedPtr<Model> CreateModel(Context* context)
+{
+    SharedPtr<Model> model(new Model(context));
+    model->SetNumGeometries(1);
+    model->SetNumGeometryLodLevels(0, 1);
+    model->SetGeometry(0, 0, new Geometry(context));
+    model->SetBoundingBox(BoundingBox(-2.0f, 2.0f));
+
+    Skeleton skeleton;
+    Vector<Bone>& bones = skeleton.GetModifiableBones();
+    PODVector<Matrix3x4> bindTransforms;
+    for (unsigned i = 0; i < NUM_BONES; ++i)
+    {
+        Bone bone;
+        bone.name_ = BONE_NAMES[i];
+        bone.nameHash_ = bone.name_;
+        bone.parentIndex_ = BONE_PARENTS[i];
+        bone.initialPosition_ = BONE_OFFSETS[i];
+        bone.initialRotation_ = Quaternion(i * 10.0f, Vector3::FORWARD);
+        bone.initialScale_ = Vector3::ONE;
+        const Matrix3x4 local(bone.initialPosition_, bone.initialRotation_, bone.initialScale_);
+        bindTransforms.Push(i ? bindTransforms[bone.parentIndex_] * local : local);
+        bone.offsetMatrix_ = bindTransforms[i].Inverse();
+        bone.collisionMask_ = BONECOLLISION_SPHERE;
+        bone.radius_ = 0.1f;
+        bones.Push(bone);
+    }
+    skeleton.SetRootBoneIndex(0);
+    model->SetSkeleton(skeleton);
+    return model;
+}
+
+/// Create an animation moving the given bones.
+SharedPtr<Animation> CreateAnimation(Context* context, const String& name, std::initializer_list<unsigned> boneIndices)
+{
+    SharedPtr<Animation> animation(new Animation(context));
+    animation->SetAnimationName(name);
+    animation->SetLength(1.0f);
+    for (unsigned index : boneIndices)
+    {
+        AnimationTrack* track = animation->CreateTrack(BONE_NAMES[index]);
+        track->channelMask_ = CHANNEL_POSITION | CHANNEL_ROTATION | CHANNEL_SCALE;
+        for (unsigned i = 0; i <= 10; ++i)
+        {
+            AnimationKeyFrame key;
+            key.time_ = i * 0.1f;
+            key.position_ = BONE_OFFSETS[index] + Vector3(Sin(i * 36.0f), 0.0f, Cos(i * 36.0f)) * 0.1f;
+            key.rotation_ = Quaternion(i * 30.0f + index * 15.0f, Vector3(1.0f, 1.0f, 0.5f).Normalized());
+            key.scale_ = Vector3::ONE * (1.0f + 0.05f * Sin(i * 72.0f));
+            track->AddKeyFrame(key);
+        }
+    }
+    return animation;
+}
+
+/// Return the largest difference between the elements of two matrices.
+float GetMatrixError(const Matrix3x4& lhs, const Matrix3x4& rhs)
+{
+    float error = 0.0f;
+    for (unsigned i = 0; i < 12; ++i)
+        error = Max(error, Abs(lhs.Data()[i] - rhs.Data()[i]));
+    return error;
+}
+
+/// Scene with one animated model playing a full body and a blended upper body animation, and a prop in the hand.
+struct AnimatedScene
+{
+    AnimatedScene(Context* context, Model* model, Animation* walk, Animation* wave, bool usePoseBuffer) :
+        scene_(new Scene(context))
+    {
+        octree_ = scene_->CreateComponent<Octree>();
+        Node* node = scene_->CreateChild("Model");
+        node->SetPosition(Vector3(1.0f, 0.0f, -2.0f));
+        node->SetRotation(Quaternion(30.0f, Vector3::UP));
+        model_ = node->CreateComponent<AnimatedModel>();
+        model_->SetModel(model);
+        model_->SetUsePoseBuffer(usePoseBuffer);
+
+        AnimationState* walkState = model_->AddAnimationState(walk);
+        walkState->SetWeight(1.0f);
+        walkState->SetLooped(true);
+        AnimationState* waveState = model_->AddAnimationState(wave);
+        waveState->SetStartBone(model_->GetSkeleton().GetBone("Arm"));
+        waveState->SetWeight(0.5f);
+        waveState->SetLayer(1);
+        waveState->SetLooped(true);
+
+        prop_ = node->GetChild("Hand", true)->CreateChild("Prop");
+        prop_->SetPosition(Vector3(0.1f, 0.2f, 0.0f));
+    }
+
+    /// Advance the animations and update the octree and skinning as the renderer does.
+    void Update(FrameInfo& frame)
+    {
+        for (unsigned i = 0; i < model_->GetNumAnimationStates(); ++i)
+            model_->GetAnimationState(i)->AddTime(frame.timeStep_);
+        octree_->Update(frame);
+        model_->UpdateGeometry(frame);
+    }
+
+    /// Return world transform of a bone node.
+    const Matrix3x4& GetBoneNodeTransform(unsigned index) { return model_->GetSkeleton().GetBone(index)->node_->GetWorldTransform(); }
+
+    SharedPtr<Scene> scene_;
+    Octree* octree_;
+    AnimatedModel* model_;
+    Node* prop_;
+};
+
+}
+
+TEST_CASE("Pose buffer evaluation matches bone node animation")
+{
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new WorkQueue(context));
+    RegisterSceneLibrary(context);
+    RegisterGraphicsLibrary(context);
+
+    SharedPtr<Model> model = CreateModel(context);
+    SharedPtr<Animation> walk = CreateAnimation(context, "Walk", {0, 1, 2, 3, 4});
+    SharedPtr<Animation> wave = CreateAnimation(context, "Wave", {2, 3});
+
+    AnimatedScene nodes(context, model, walk, wave, false);
+    AnimatedScene pose(context, model, walk, wave, true);
+    REQUIRE_FALSE(nodes.model_->IsPoseBufferActive());
+    REQUIRE(pose.model_->IsPoseBufferActive());
+
+    FrameInfo frame;
+    frame.frameNumber_ = 0;
+    frame.timeStep_ = 0.07f;
+    for (unsigned i = 0; i < 20; ++i)
+    {
+        ++frame.frameNumber_;
+        nodes.Update(frame);
+        pose.Update(frame);
+        INFO("frame " << i);
+
+        // Same skin matrices
+        const SourceBatch& nodesBatch = nodes.model_->GetBatches()[0];
+        const SourceBatch& poseBatch = pose.model_->GetBatches()[0];
+        REQUIRE_EQ(poseBatch.numWorldTransforms_, NUM_BONES);
+        REQUIRE_EQ(nodesBatch.numWorldTransforms_, NUM_BONES);
+        for (unsigned j = 0; j < NUM_BONES; ++j)
+            CHECK(GetMatrixError(poseBatch.worldTransform_[j], nodesBatch.worldTransform_[j]) < 1e-4f);
+
+        // The attachment and its parent chain are written every update
+        CHECK(GetMatrixError(pose.prop_->GetWorldTransform(), nodes.prop_->GetWorldTransform()) < 1e-4f);
+        for (unsigned index : {0, 1, 2, 3})
+            CHECK(GetMatrixError(pose.GetBoneNodeTransform(index), nodes.GetBoneNodeTransform(index)) < 1e-4f);
+
+        // Bone transforms from the pose buffer agree with the bone nodes
+        const PODVector<Matrix3x4>& boneTransforms = pose.model_->GetBoneTransforms();
+        REQUIRE_EQ(boneTransforms.Size(), NUM_BONES);
+        const Matrix3x4& worldTransform = pose.model_->GetNode()->GetWorldTransform();
+        for (unsigned j = 0; j < NUM_BONES; ++j)
+            CHECK(GetMatrixError(worldTransform * boneTransforms[j], nodes.GetBoneNodeTransform(j)) < 1e-4f);
+    }
+
+    // The leg has no attachments, so its node is only written on request
+    CHECK(GetMatrixError(pose.GetBoneNodeTransform(4), nodes.GetBoneNodeTransform(4)) > 1e-3f);
+    pose.model_->SyncBoneNodes();
+    for (unsigned j = 0; j < NUM_BONES; ++j)
+        CHECK(GetMatrixError(pose.GetBoneNodeTransform(j), nodes.GetBoneNodeTransform(j)) < 1e-4f);
+}
@@ -0,0 +1,130 @@
+#include <doctest/doctest_fwd.h>
+
+#include <Urho3D/Graphics/SoftwareSkinning.h>
+#include <Urho3D/Math/Random.h>
+
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+
+using namespace Urho3D;
+
+/// Interleaved vertex with position, normal, blend weights and blend indices, as laid out by a skinned model.
+struct SkinnedVertex
+{
+    Vector3 position_;
+    Vector3 normal_;
+    float blendWeights_[4];
+    unsigned char blendIndices_[4];
+};
+
+Matrix3x4 RandomMatrix()
+{
+    return Matrix3x4(Vector3(Random(-5.0f, 5.0f), Random(-5.0f, 5.0f), Random(-5.0f, 5.0f)),
+        Quaternion(Random(360.0f), Random(360.0f), Random(360.0f)), Random(0.5f, 2.0f));
+}
+
+}
+
+TEST_CASE("Software skinning matches blending the skin matrices per vertex")
+{
+    SetRandomSeed(1);
+
+    constexpr unsigned numMatrices = 20;
+    PODVector<Matrix3x4> matrices;
+    for (unsigned i = 0; i < numMatrices; ++i)
+        matrices.Push(RandomMatrix());
+
+    PODVector<SkinnedVertex> vertices(101);
+    for (unsigned i = 0; i < vertices.Size(); ++i)
+    {
+        SkinnedVertex& vertex = vertices[i];
+        vertex.position_ = Vector3(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f));
+        vertex.normal_ = Vector3::UP;
+
+        // Some influences unused, and some pointing out of range, which are skipped
+        float total = 0.0f;
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            vertex.blendWeights_[j] = j <= i % 4 ? Random(0.1f, 1.0f) : 0.0f;
+            vertex.blendIndices_[j] = (unsigned char)(i % 13 == 0 && j == 1 ? numMatrices + 5 : Rand() % numMatrices);
+            total += vertex.blendWeights_[j];
+        }
+        for (unsigned j = 0; j < 4; ++j)
+            vertex.blendWeights_[j] /= total;
+    }
+
+    PODVector<Vector3> skinned(vertices.Size());
+    const auto* data = (const unsigned char*)vertices.Buffer();
+    SkinPositions(data + offsetof(SkinnedVertex, position_), sizeof(SkinnedVertex), data + offsetof(SkinnedVertex, blendWeights_),
+        data + offsetof(SkinnedVertex, blendIndices_), sizeof(SkinnedVertex), matrices.Buffer(), matrices.Size(), vertices.Size(),
+        skinned.Buffer());
+
+    for (unsigned i = 0; i < vertices.Size(); ++i)
+    {
+        const SkinnedVertex& vertex = vertices[i];
+        Vector3 expected = Vector3::ZERO;
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            if (vertex.blendWeights_[j] != 0.0f && vertex.blendIndices_[j] < numMatrices)
+                expected += vertex.blendWeights_[j] * (matrices[vertex.blendIndices_[j]] * vertex.position_);
+        }
+        CHECK((skinned[i] - expected).Length() < 1e-4f);
+    }
+}
+
+TEST_CASE("Vertex morphs add to the given elements only")
+{
+    SetRandomSeed(2);
+
+    PODVector<SkinnedVertex> vertices(50);
+    for (unsigned i = 0; i < vertices.Size(); ++i)
+    {
+        vertices[i].position_ = Vector3(Random(1.0f), Random(1.0f), Random(1.0f));
+        vertices[i].normal_ = Vector3(Random(1.0f), Random(1.0f), Random(1.0f));
+        for (unsigned j = 0; j < 4; ++j)
+            vertices[i].blendWeights_[j] = 0.25f;
+    }
+    const PODVector<SkinnedVertex> original = vertices;
+
+    // Morph every third vertex of a range starting at vertex 10, with position and normal deltas
+    constexpr unsigned vertexStart = 10;
+    constexpr float weight = 0.75f;
+    PODVector<unsigned char> morphData;
+    PODVector<unsigned> morphed;
+    for (unsigned i = 0; i < vertices.Size(); i += 3)
+    {
+        const unsigned index = i + vertexStart;
+        const float deltas[6] = {Random(1.0f), Random(1.0f), Random(1.0f), Random(1.0f), Random(1.0f), Random(1.0f)};
+        const unsigned offset = morphData.Size();
+        morphData.Resize(offset + sizeof(unsigned) + sizeof(deltas));
+        memcpy(&morphData[offset], &index, sizeof(unsigned));
+        memcpy(&morphData[offset + sizeof(unsigned)], deltas, sizeof(deltas));
+        morphed.Push(i);
+    }
+
+    const unsigned elementOffsets[] = {offsetof(SkinnedVertex, position_), offsetof(SkinnedVertex, normal_)};
+    ApplyVertexMorph((unsigned char*)vertices.Buffer(), sizeof(SkinnedVertex), vertexStart, morphData.Buffer(), morphed.Size(),
+        elementOffsets, 2, weight);
+
+    const unsigned char* src = morphData.Buffer();
+    unsigned next = 0;
+    for (unsigned i = 0; i < vertices.Size(); ++i)
+    {
+        Vector3 positionDelta = Vector3::ZERO;
+        Vector3 normalDelta = Vector3::ZERO;
+        if (next < morphed.Size() && morphed[next] == i)
+        {
+            const auto* deltas = (const float*)(src + sizeof(unsigned));
+            positionDelta = Vector3(deltas) * weight;
+            normalDelta = Vector3(deltas + 3) * weight;
+            src += sizeof(unsigned) + 6 * sizeof(float);
+            ++next;
+        }
+        CHECK((vertices[i].position_ - (original[i].position_ + positionDelta)).Length() < 1e-6f);
+        CHECK((vertices[i].normal_ - (original[i].normal_ + normalDelta)).Length() < 1e-6f);
+        CHECK_EQ(vertices[i].blendWeights_[0], 0.25f);
+    }
+}
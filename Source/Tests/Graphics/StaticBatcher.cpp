@@ -0,0 +1,241 @@
+#include <doctest/doctest_fwd.h>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/IndexBuffer.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/StaticBatch.h>
+#include <Urho3D/Graphics/StaticBatcher.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Graphics/VertexBuffer.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+using namespace Urho3D;
+
+constexpr unsigned GRID_SIZE = 16;
+constexpr unsigned GRID_VERTICES = (GRID_SIZE + 1) * (GRID_SIZE + 1);
+constexpr unsigned MAX_VERTICES = 1024;
+
+/// Vertex with position and normal.
+struct GridVertex
+{
+    Vector3 position_;
+    Vector3 normal_;
+};
+
+/// Create an upward facing unit grid model with CPU-side vertex and index data.
+SharedPtr<Model> CreateGridModel(Context* context)
+{
+    PODVector<GridVertex> vertices;
+    for (unsigned z = 0; z <= GRID_SIZE; ++z)
+    {
+        for (unsigned x = 0; x <= GRID_SIZE; ++x)
+            vertices.Push({Vector3((float)x / GRID_SIZE - 0.5f, 0.0f, (float)z / GRID_SIZE - 0.5f), Vector3::UP});
+    }
+
+    PODVector<unsigned short> indices;
+    for (unsigned z = 0; z < GRID_SIZE; ++z)
+    {
+        for (unsigned x = 0; x < GRID_SIZE; ++x)
+        {
+            const unsigned short corner = (unsigned short)(z * (GRID_SIZE + 1) + x);
+            const unsigned short quad[] = { corner, (unsigned short)(corner + GRID_SIZE + 1), (unsigned short)(corner + 1),
+                (unsigned short)(corner + 1), (unsigned short)(corner + GRID_SIZE + 1), (unsigned short)(corner + GRID_SIZE + 2) };
+            for (unsigned short index : quad)
+                indices.Push(index);
+        }
+    }
+
+    SharedPtr<VertexBuffer> vertexBuffer(new VertexBuffer(context));
+    vertexBuffer->SetShadowed(true);
+    vertexBuffer->SetSize(vertices.Size(), MASK_POSITION | MASK_NORMAL);
+    vertexBuffer->SetData(vertices.Buffer());
+    SharedPtr<IndexBuffer> indexBuffer(new IndexBuffer(context));
+    indexBuffer->SetShadowed(true);
+    indexBuffer->SetSize(indices.Size(), false);
+    indexBuffer->SetData(indices.Buffer());
+
+    SharedPtr<Geometry> geometry(new Geometry(context));
+    geometry->SetVertexBuffer(0, vertexBuffer);
+    geometry->SetIndexBuffer(indexBuffer);
+    geometry->SetDrawRange(TRIANGLE_LIST, 0, indices.Size());
+
+    SharedPtr<Model> model(new Model(context));
+    model->SetNumGeometries(1);
+    model->SetNumGeometryLodLevels(0, 1);
+    model->SetGeometry(0, 0, geometry);
+    model->SetBoundingBox(BoundingBox(Vector3(-0.5f, 0.0f, -0.5f), Vector3(0.5f, 0.0f, 0.5f)));
+    return model;
+}
+
+/// Return the number of triangles of a batch whose winding disagrees with the vertex normals, unlike the grid's.
+unsigned GetNumFlippedTriangles(StaticBatch* batch)
+{
+    const unsigned char* vertexData;
+    unsigned vertexSize;
+    const unsigned char* indexData;
+    unsigned indexSize;
+    const PODVector<VertexElement>* elements;
+    batch->GetGeometry()->GetRawData(vertexData, vertexSize, indexData, indexSize, elements);
+    REQUIRE(vertexData);
+    REQUIRE(indexData);
+    REQUIRE_EQ(vertexSize, sizeof(GridVertex));
+
+    unsigned numFlipped = 0;
+    const unsigned indexCount = batch->GetGeometry()->GetIndexCount();
+    for (unsigned i = 0; i + 2 < indexCount; i += 3)
+    {
+        const GridVertex* triangle[3];
+        for (unsigned j = 0; j < 3; ++j)
+        {
+            const unsigned index = indexSize == sizeof(unsigned) ? reinterpret_cast<const unsigned*>(indexData)[i + j] :
+                reinterpret_cast<const unsigned short*>(indexData)[i + j];
+            triangle[j] = reinterpret_cast<const GridVertex*>(vertexData + index * vertexSize);
+        }
+        // The grid's triangles are wound so that the cross product of the edges points along the normal
+        const Vector3 faceNormal = (triangle[1]->position_ - triangle[0]->position_).CrossProduct(
+            triangle[2]->position_ - triangle[0]->position_);
+        if (faceNormal.DotProduct(triangle[0]->normal_) < 0.0f)
+            ++numFlipped;
+    }
+    return numFlipped;
+}
+
+/// Return whether all the static models are in the octree, or none of them if not expected to be.
+bool AreInOctree(const PODVector<StaticModel*>& models, bool expected)
+{
+    for (unsigned i = 0; i < models.Size(); ++i)
+    {
+        if ((models[i]->GetOctant() != nullptr) != expected || models[i]->IsBatched() == expected)
+            return false;
+    }
+    return true;
+}
+
+}
+
+TEST_CASE("Static batcher merges, splits and restores static models")
+{
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new WorkQueue(context));
+    // Materials look up their default technique from the resource cache
+    context->RegisterSubsystem(new FileSystem(context));
+    context->RegisterSubsystem(new ResourceCache(context));
+    RegisterSceneLibrary(context);
+    RegisterGraphicsLibrary(context);
+
+    SharedPtr<Model> grid = CreateGridModel(context);
+    SharedPtr<Material> stone(new Material(context));
+    SharedPtr<Material> grass(new Material(context));
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* octree = scene->CreateComponent<Octree>();
+    Node* root = scene->CreateChild("Batched");
+    root->SetPosition(Vector3(0.0f, 1.0f, 0.0f));
+
+    // Five grids of one material, the second one mirrored, and two of another material
+    PODVector<StaticModel*> models;
+    for (unsigned i = 0; i < 7; ++i)
+    {
+        Node* node = root->CreateChild("Grid");
+        node->SetPosition(Vector3(i * 2.0f, 0.0f, 0.0f));
+        node->SetRotation(Quaternion(i * 20.0f, Vector3::UP));
+        if (i == 1)
+            node->SetScale(Vector3(-1.0f, 1.0f, 1.0f));
+        auto* model = node->CreateComponent<StaticModel>();
+        model->SetModel(grid);
+        model->SetMaterial(i < 5 ? stone : grass);
+        models.Push(model);
+    }
+    REQUIRE(AreInOctree(models, true));
+    const unsigned numChildren = root->GetNumChildren();
+
+    auto* batcher = root->CreateComponent<StaticBatcher>();
+    batcher->SetChunkSize(0.0f);
+    batcher->SetMaxVertices(MAX_VERTICES);
+    REQUIRE_EQ(batcher->GetMaxVertices(), MAX_VERTICES);
+
+    SUBCASE("Build groups by material and splits at the vertex limit")
+    {
+        // Three grids fit the limit, so the first material needs two batches
+        CHECK_EQ(batcher->Build(), 3);
+        CHECK_EQ(batcher->GetNumSources(), 7);
+        CHECK(AreInOctree(models, false));
+        CHECK_EQ(root->GetNumChildren(), numChildren + 3);
+
+        unsigned numStone = 0;
+        unsigned numGrass = 0;
+        unsigned numVertices = 0;
+        for (unsigned i = 0; i < batcher->GetNumBatches(); ++i)
+        {
+            StaticBatch* batch = batcher->GetBatch(i);
+            REQUIRE(batch);
+            CHECK(batch->GetOctant());
+            CHECK_LE(batch->GetGeometry()->GetVertexCount(), MAX_VERTICES);
+            CHECK_EQ(batch->GetGeometry()->GetVertexCount(), batch->GetNumSources() * GRID_VERTICES);
+            numVertices += batch->GetGeometry()->GetVertexCount();
+            if (batch->GetMaterial() == stone)
+                numStone += batch->GetNumSources();
+            else if (batch->GetMaterial() == grass)
+                numGrass += batch->GetNumSources();
+
+            // The mirrored grid has its winding flipped to keep facing the same way
+            CHECK_EQ(GetNumFlippedTriangles(batch), 0);
+        }
+        CHECK_EQ(numStone, 5);
+        CHECK_EQ(numGrass, 2);
+        CHECK_EQ(numVertices, 7 * GRID_VERTICES);
+    }
+
+    SUBCASE("Raycasts against batches report the source models")
+    {
+        batcher->Build();
+        FrameInfo frame;
+        frame.frameNumber_ = 1;
+        frame.timeStep_ = 0.0f;
+        frame.camera_ = nullptr;
+        octree->Update(frame);
+
+        for (unsigned i = 0; i < models.Size(); ++i)
+        {
+            PODVector<RayQueryResult> results;
+            const Vector3 target = models[i]->GetNode()->GetWorldPosition() + Vector3(0.1f, 0.0f, 0.2f);
+            RayOctreeQuery query(results, Ray(target + Vector3::UP * 10.0f, Vector3::DOWN), RAY_TRIANGLE, 100.0f);
+            octree->RaycastSingle(query);
+            INFO("grid " << i);
+            REQUIRE_EQ(results.Size(), 1);
+            CHECK_EQ(results[0].drawable_, models[i]);
+            CHECK_EQ(results[0].node_, models[i]->GetNode());
+            CHECK((results[0].position_ - target).Length() < 1e-3f);
+        }
+    }
+
+    SUBCASE("Clear restores the sources")
+    {
+        batcher->Build();
+        batcher->Clear();
+        CHECK_EQ(batcher->GetNumBatches(), 0);
+        CHECK_EQ(batcher->GetNumSources(), 0);
+        CHECK(AreInOctree(models, true));
+        CHECK_EQ(root->GetNumChildren(), numChildren);
+    }
+
+    SUBCASE("Removing the batcher restores the sources")
+    {
+        batcher->Build();
+        root->RemoveComponent(batcher);
+        CHECK(AreInOctree(models, true));
+        CHECK_EQ(root->GetNumChildren(), numChildren);
+    }
+}
@@ -7,6 +7,5 @@ int main(int argc, char** argv) {
 
     int res = context.run(); // run
 
-    if(context.shouldExit())
-        return res;
+    return res;
 }
@@ -0,0 +1,86 @@
+#include <doctest/doctest_fwd.h>
+
+#include <Urho3D/Math/DynamicAabbTree.h>
+#include <Urho3D/Math/Random.h>
+
+namespace
+{
+
+Urho3D::BoundingBox RandomBox()
+{
+    using namespace Urho3D;
+
+    Vector3 center(Random(-100.0f, 100.0f), Random(-100.0f, 100.0f), Random(-100.0f, 100.0f));
+    Vector3 halfSize(Random(0.1f, 5.0f), Random(0.1f, 5.0f), Random(0.1f, 5.0f));
+    return BoundingBox(center - halfSize, center + halfSize);
+}
+
+}
+
+TEST_CASE("Dynamic AABB tree stays valid and finds all overlapping proxies")
+{
+    using namespace Urho3D;
+
+    SetRandomSeed(1);
+    DynamicAabbTree tree;
+    PODVector<unsigned> proxies;
+    PODVector<BoundingBox> boxes;
+
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        boxes.Push(RandomBox());
+        proxies.Push(tree.CreateProxy(boxes.Back(), reinterpret_cast<void*>((size_t)i)));
+    }
+    CHECK(tree.Validate());
+    CHECK_EQ(tree.GetNumProxies(), 1000);
+    // Balanced: far below the 1000 of a degenerate list
+    CHECK(tree.GetHeight() < 30);
+
+    unsigned numReinserted = 0;
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        // Small moves stay within the fattened box, large ones reinsert
+        Vector3 offset = i & 1 ? Vector3(0.01f, 0.0f, 0.0f) : Vector3(Random(-50.0f, 50.0f), 0.0f, 0.0f);
+        boxes[i] = BoundingBox(boxes[i].min_ + offset, boxes[i].max_ + offset);
+        if (tree.MoveProxy(proxies[i], boxes[i]))
+            ++numReinserted;
+        CHECK(tree.Fits(proxies[i], boxes[i]));
+    }
+    CHECK(numReinserted <= 500);
+    CHECK(tree.Validate());
+
+    for (unsigned i = 0; i < 1000; i += 3)
+    {
+        tree.DestroyProxy(proxies[i]);
+        proxies[i] = NULL_AABB_NODE;
+    }
+    CHECK(tree.Validate());
+
+    // Compare a box query against brute force
+    const BoundingBox queryBox(Vector3(-40.0f, -40.0f, -40.0f), Vector3(30.0f, 30.0f, 30.0f));
+    PODVector<bool> found(1000);
+    for (unsigned i = 0; i < found.Size(); ++i)
+        found[i] = false;
+    auto nodeTest = [&queryBox](const BoundingBox& box, bool inside)
+    {
+        return inside ? INSIDE : queryBox.IsInside(box);
+    };
+    auto leafFunc = [&](unsigned proxy, bool inside)
+    {
+        if (inside || queryBox.IsInside(tree.GetFatBox(proxy)) != OUTSIDE)
+            found[(size_t)tree.GetUserData(proxy)] = true;
+    };
+    tree.Traverse(nodeTest, leafFunc);
+
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        if (proxies[i] != NULL_AABB_NODE && queryBox.IsInside(boxes[i]) != OUTSIDE)
+            CHECK(found[i]);
+        if (proxies[i] == NULL_AABB_NODE)
+            CHECK_FALSE(found[i]);
+    }
+
+    tree.Clear();
+    CHECK(tree.Validate());
+    CHECK_EQ(tree.GetNumProxies(), 0);
+}
@@ -0,0 +1,160 @@
+#include <doctest/doctest_fwd.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <atomic>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Drawable.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/OctreeQuery.h>
+#include <Urho3D/Scene/LogicComponent.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+/// Logic component counting its updates.
+class CountingLogic : public Urho3D::LogicComponent
+{
+    URHO3D_OBJECT(CountingLogic, Urho3D::LogicComponent);
+
+public:
+    explicit CountingLogic(Urho3D::Context* context) : Urho3D::LogicComponent(context) { }
+
+    void DelayedStart() override { ++numDelayedStarts_; }
+    void Update(float /*timeStep*/) override
+    {
+        ++numUpdates_;
+        if (removeOnUpdate_)
+            Remove();
+    }
+    void PostUpdate(float /*timeStep*/) override { ++numPostUpdates_; }
+
+    int numDelayedStarts_{};
+    int numUpdates_{};
+    int numPostUpdates_{};
+    bool removeOnUpdate_{};
+};
+
+/// Unit box drawable which needs no graphics subsystem.
+class TestBox : public Urho3D::Drawable
+{
+    URHO3D_OBJECT(TestBox, Urho3D::Drawable);
+
+public:
+    explicit TestBox(Urho3D::Context* context) :
+        Urho3D::Drawable(context, Urho3D::DRAWABLE_GEOMETRY)
+    {
+        boundingBox_ = Urho3D::BoundingBox(-0.5f, 0.5f);
+    }
+
+protected:
+    void OnWorldBoundingBoxUpdate() override
+    {
+        worldBoundingBox_ = boundingBox_.Transformed(node_->GetWorldTransform());
+    }
+};
+
+/// Second logic component type, updated in parallel. Moves its node.
+class ParallelLogic : public Urho3D::LogicComponent
+{
+    URHO3D_OBJECT(ParallelLogic, Urho3D::LogicComponent);
+
+public:
+    explicit ParallelLogic(Urho3D::Context* context) : Urho3D::LogicComponent(context)
+    {
+        SetUpdateEventMask(Urho3D::USE_UPDATE);
+        SetThreadSafeUpdate(true);
+    }
+
+    void Update(float timeStep) override
+    {
+        time_ += timeStep;
+        node_->Translate(Urho3D::Vector3(timeStep, 0.0f, 0.0f));
+    }
+
+    float time_{};
+};
+
+}
+
+TEST_CASE("Scene updates logic components from per-phase lists")
+{
+    using namespace Urho3D;
+
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    auto* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    queue->CreateThreads(2);
+    context->RegisterFactory<CountingLogic>();
+    context->RegisterFactory<ParallelLogic>();
+    context->RegisterFactory<TestBox>();
+    Octree::RegisterObject(context);
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* octree = scene->CreateComponent<Octree>();
+    PODVector<CountingLogic*> counting;
+    PODVector<ParallelLogic*> parallel;
+    PODVector<TestBox*> boxes;
+    for (unsigned i = 0; i < 100; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition(Vector3(0.0f, 0.0f, i * 2.0f));
+        counting.Push(node->CreateComponent<CountingLogic>());
+        parallel.Push(node->CreateComponent<ParallelLogic>());
+        boxes.Push(node->CreateComponent<TestBox>());
+    }
+
+    FrameInfo frame;
+    frame.frameNumber_ = 1;
+    octree->Update(frame);
+
+    CHECK_EQ(scene->GetNumLogicComponents(LOGIC_UPDATE), 200);
+    CHECK_EQ(scene->GetNumLogicComponents(LOGIC_POSTUPDATE), 100);
+
+    scene->Update(0.5f);
+    for (CountingLogic* logic : counting)
+    {
+        CHECK_EQ(logic->numDelayedStarts_, 1);
+        CHECK_EQ(logic->numUpdates_, 1);
+        CHECK_EQ(logic->numPostUpdates_, 1);
+    }
+    for (ParallelLogic* logic : parallel)
+        CHECK_EQ(logic->time_, 0.5f);
+
+    // The moved drawables were queued for the octree update from the worker threads, and are found at their new positions
+    ++frame.frameNumber_;
+    octree->Update(frame);
+    PODVector<Drawable*> found;
+    BoxOctreeQuery query(found, BoundingBox(Vector3(0.25f, -1.0f, -1.0f), Vector3(0.75f, 1.0f, 200.0f)), DRAWABLE_GEOMETRY);
+    octree->GetDrawables(query);
+    CHECK_EQ(found.Size(), boxes.Size());
+    for (TestBox* box : boxes)
+        CHECK_EQ(box->GetWorldBoundingBox().Center().x_, 0.5f);
+
+    // Disabling removes from the lists, removal during update leaves the others running
+    counting[0]->SetEnabled(false);
+    counting[1]->removeOnUpdate_ = true;
+    scene->Update(0.5f);
+    CHECK_EQ(counting[0]->numUpdates_, 1);
+    CHECK_EQ(counting[2]->numUpdates_, 2);
+    CHECK_EQ(counting.Back()->numUpdates_, 2);
+    CHECK_EQ(scene->GetNumLogicComponents(LOGIC_UPDATE), 198);
+    CHECK_EQ(scene->GetNumLogicComponents(LOGIC_POSTUPDATE), 98);
+
+    // Switching the threading mode keeps the component in the lists
+    parallel[0]->SetThreadSafeUpdate(false);
+    scene->Update(0.5f);
+    CHECK_EQ(parallel[0]->time_, 1.5f);
+    CHECK_EQ(parallel.Back()->time_, 1.5f);
+
+    // Removing the nodes empties the lists
+    scene->RemoveAllChildren();
+    CHECK_EQ(scene->GetNumLogicComponents(LOGIC_UPDATE), 0);
+    CHECK_EQ(scene->GetNumLogicComponents(LOGIC_POSTUPDATE), 0);
+    CHECK_EQ(scene->GetNumLogicComponents(LOGIC_FIXEDUPDATE), 0);
+}
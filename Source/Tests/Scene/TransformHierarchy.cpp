@@ -0,0 +1,196 @@
+#include <doctest/doctest_fwd.h>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Component.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+/// Component which updates the transform hierarchy when its node is removed from the scene, while the children of the node
+/// still belong to the scene.
+class RemovalUpdater : public Urho3D::Component
+{
+    URHO3D_OBJECT(RemovalUpdater, Urho3D::Component);
+
+public:
+    explicit RemovalUpdater(Urho3D::Context* context) :
+        Urho3D::Component(context)
+    {
+    }
+
+    /// World transform of the first child, read after the update.
+    Urho3D::Matrix3x4 childWorldTransform_;
+
+protected:
+    void OnSceneSet(Urho3D::Scene* scene) override
+    {
+        if (scene)
+            scene_ = scene;
+        else if (scene_)
+        {
+            scene_->UpdateTransformHierarchy();
+            childWorldTransform_ = node_->GetChild(0u)->GetWorldTransform();
+        }
+    }
+
+private:
+    /// Scene the node belonged to.
+    Urho3D::Scene* scene_{};
+};
+
+/// Build the same random hierarchy under a scene.
+void BuildHierarchy(Urho3D::Scene* scene, Urho3D::PODVector<Urho3D::Node*>& nodes)
+{
+    using namespace Urho3D;
+
+    SetRandomSeed(1);
+    for (unsigned i = 0; i < 500; ++i)
+    {
+        Node* parent = nodes.Empty() || Random(4) == 0 ? scene : nodes[Random((int)nodes.Size())];
+        Node* node = parent->CreateChild();
+        node->SetTransform(Vector3(Random(-10.0f, 10.0f), Random(-10.0f, 10.0f), Random(-10.0f, 10.0f)),
+            Quaternion(Random(360.0f), Random(360.0f), Random(360.0f)), Vector3(Random(0.5f, 2.0f), 1.0f, 1.0f));
+        nodes.Push(node);
+    }
+}
+
+/// Apply the same random moves and reparents.
+void ModifyHierarchy(Urho3D::Scene* scene, Urho3D::PODVector<Urho3D::Node*>& nodes, int seed)
+{
+    using namespace Urho3D;
+
+    SetRandomSeed(seed);
+    for (unsigned i = 0; i < 100; ++i)
+    {
+        Node* node = nodes[Random((int)nodes.Size())];
+        switch (Random(4))
+        {
+        case 0:
+            node->Translate(Vector3(Random(-1.0f, 1.0f), 0.0f, 0.0f));
+            break;
+        case 1:
+            node->Rotate(Quaternion(Random(90.0f), Vector3::UP));
+            break;
+        case 2:
+            node->SetPositionSilent(node->GetPosition() + Vector3::ONE);
+            node->MarkDirty();
+            break;
+        default:
+            {
+                Node* parent = nodes[Random((int)nodes.Size())];
+                if (parent->IsChildOf(node))
+                    parent = scene;
+                node->SetParent(parent);
+            }
+            break;
+        }
+    }
+}
+
+void CompareHierarchies(const Urho3D::PODVector<Urho3D::Node*>& lhs, const Urho3D::PODVector<Urho3D::Node*>& rhs)
+{
+    for (unsigned i = 0; i < lhs.Size(); ++i)
+    {
+        CHECK(lhs[i]->GetWorldTransform().Equals(rhs[i]->GetWorldTransform()));
+        CHECK(lhs[i]->GetWorldRotation().Equals(rhs[i]->GetWorldRotation()));
+    }
+}
+
+}
+
+TEST_CASE("Transform hierarchy matches per-node world transforms")
+{
+    using namespace Urho3D;
+
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    auto* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    queue->CreateThreads(2);
+
+    SharedPtr<Scene> legacyScene(new Scene(context));
+    SharedPtr<Scene> scene(new Scene(context));
+    PODVector<Node*> legacyNodes;
+    PODVector<Node*> nodes;
+    BuildHierarchy(legacyScene, legacyNodes);
+    BuildHierarchy(scene, nodes);
+    scene->SetTransformHierarchyEnabled(true);
+    REQUIRE(scene->GetTransformHierarchy());
+    CHECK_EQ(scene->GetTransformHierarchy()->GetNumNodes(), 500);
+
+    // Lazy reads before the first batched update
+    CompareHierarchies(legacyNodes, nodes);
+
+    for (int frame = 0; frame < 10; ++frame)
+    {
+        ModifyHierarchy(legacyScene, legacyNodes, frame + 2);
+        ModifyHierarchy(scene, nodes, frame + 2);
+        // Alternate lazy reads and batched updates
+        if (frame & 1)
+        {
+            scene->UpdateTransformHierarchy();
+            CHECK_FALSE(scene->GetTransformHierarchy()->HasDirtyTransforms());
+            CHECK_FALSE(scene->GetTransformHierarchy()->IsStructureDirty());
+        }
+        CompareHierarchies(legacyNodes, nodes);
+    }
+
+    // References to world transforms, as kept by batches until rendering, survive slot reallocation and rebuilds
+    const Matrix3x4& worldTransform = nodes[0]->GetWorldTransform();
+    const Matrix3x4 expected = worldTransform;
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        legacyScene->CreateChild();
+        scene->CreateChild();
+    }
+    scene->UpdateTransformHierarchy();
+    CHECK_EQ(&worldTransform, &nodes[0]->GetWorldTransform());
+    CHECK(worldTransform.Equals(expected));
+
+    // Removed nodes keep working without the hierarchy
+    SharedPtr<Node> legacyRemoved(legacyNodes[10]);
+    SharedPtr<Node> removed(nodes[10]);
+    legacyRemoved->Remove();
+    removed->Remove();
+    scene->UpdateTransformHierarchy();
+    CHECK_EQ(scene->GetTransformHierarchy()->GetNumNodes(), legacyScene->GetNumChildren(true));
+    CHECK(removed->GetWorldTransform().Equals(legacyRemoved->GetWorldTransform()));
+    ModifyHierarchy(legacyScene, legacyNodes, 100);
+    ModifyHierarchy(scene, nodes, 100);
+    CompareHierarchies(legacyNodes, nodes);
+
+    // Disabling hands the transforms back to the nodes
+    scene->SetTransformHierarchyEnabled(false);
+    CHECK_FALSE(scene->GetTransformHierarchy());
+    CompareHierarchies(legacyNodes, nodes);
+}
+
+TEST_CASE("Transform hierarchy keeps parents of nodes which can not be reached from the scene")
+{
+    using namespace Urho3D;
+
+    Thread::SetMainThread();
+    SharedPtr<Context> context(new Context());
+    context->RegisterFactory<RemovalUpdater>();
+
+    SharedPtr<Scene> scene(new Scene(context));
+    scene->SetTransformHierarchyEnabled(true);
+    Node* parent = scene->CreateChild();
+    parent->SetTransform(Vector3(1.0f, 2.0f, 3.0f), Quaternion(45.0f, Vector3::UP), Vector3(2.0f, 2.0f, 2.0f));
+    Node* child = parent->CreateChild();
+    child->SetPosition(Vector3(0.0f, 0.0f, 5.0f));
+    auto* updater = parent->CreateComponent<RemovalUpdater>();
+    scene->UpdateTransformHierarchy();
+
+    // The parent leaves the hierarchy before its child does, so the update in between can not reach the child from the scene
+    const Matrix3x4 expected = parent->GetWorldTransform() * child->GetTransform();
+    SharedPtr<Node> removed(parent);
+    parent->Remove();
+    CHECK(updater->childWorldTransform_.Equals(expected));
+    CHECK(child->GetWorldTransform().Equals(expected));
+    CHECK_EQ(scene->GetTransformHierarchy()->GetNumNodes(), 0);
+}
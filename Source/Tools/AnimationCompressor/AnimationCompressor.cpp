@@ -0,0 +1,155 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Graphics/Animation.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Resource/ResourceCache.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+void PrintStatistics(Animation* original, Animation* compressed);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    if (arguments.Size() < 2)
+        ErrorExit("Usage: AnimationCompressor <input ani file> <output ani file> [position tolerance] [rotation tolerance] [scale tolerance]\n"
+                  "Tolerances default to 0.001 units for position and scale and 0.05 degrees for rotation");
+
+    SharedPtr<Context> context(new Context());
+    auto* fileSystem = new FileSystem(context);
+    context->RegisterSubsystem(fileSystem);
+    // Animation loading looks up trigger files through the resource cache
+    context->RegisterSubsystem(new ResourceCache(context));
+
+    String inputFile = arguments[0];
+    String outputFile = arguments[1];
+    if (!IsAbsolutePath(inputFile))
+        inputFile = fileSystem->GetCurrentDir() + inputFile;
+    const float positionTolerance = arguments.Size() > 2 ? ToFloat(arguments[2]) : 0.001f;
+    const float rotationTolerance = arguments.Size() > 3 ? ToFloat(arguments[3]) : 0.05f;
+    const float scaleTolerance = arguments.Size() > 4 ? ToFloat(arguments[4]) : 0.001f;
+
+    SharedPtr<Animation> original(new Animation(context));
+    original->SetName(GetInternalPath(inputFile));
+    if (!original->LoadFile(inputFile))
+        ErrorExit("Could not load animation " + inputFile);
+    if (original->IsCompressed())
+        original->Decompress();
+
+    SharedPtr<Animation> compressed = original->Clone(original->GetName());
+    compressed->Compress(positionTolerance, rotationTolerance, scaleTolerance);
+
+    if (!compressed->SaveFile(outputFile))
+        ErrorExit("Could not save animation " + outputFile);
+
+    PrintStatistics(original, compressed);
+}
+
+void PrintStatistics(Animation* original, Animation* compressed)
+{
+    unsigned keyFrames = 0;
+    unsigned channels = 0;
+    unsigned constantChannels = 0;
+    unsigned keys = 0;
+    float positionError = 0.0f;
+    float rotationError = 0.0f;
+    float scaleError = 0.0f;
+
+    const HashMap<StringHash, AnimationTrack>& tracks = original->GetTracks();
+    for (HashMap<StringHash, AnimationTrack>::ConstIterator i = tracks.Begin(); i != tracks.End(); ++i)
+    {
+        const AnimationTrack& track = i->second_;
+        const AnimationTrack* compressedTrack = compressed->GetTrack(i->first_);
+        if (!compressedTrack || !compressedTrack->IsCompressed())
+            continue;
+
+        keyFrames += track.keyFrames_.Size();
+
+        const AnimationCurve* curves[] = { &compressedTrack->positionCurve_, &compressedTrack->rotationCurve_,
+            &compressedTrack->scaleCurve_ };
+        for (const AnimationCurve* curve : curves)
+        {
+            if (!curve->GetNumKeys())
+                continue;
+            ++channels;
+            keys += curve->GetNumKeys();
+            if (curve->GetNumKeys() == 1)
+                ++constantChannels;
+        }
+
+        // Measure the error at the original keyframes, where dropped keys deviate the most
+        unsigned positionIndex = 0;
+        unsigned rotationIndex = 0;
+        unsigned scaleIndex = 0;
+        for (unsigned j = 0; j < track.keyFrames_.Size(); ++j)
+        {
+            const AnimationKeyFrame& keyFrame = track.keyFrames_[j];
+            if (track.channelMask_ & CHANNEL_POSITION)
+            {
+                const Vector3 position = compressedTrack->positionCurve_.SampleVector3(keyFrame.time_, original->GetLength(), false, positionIndex);
+                positionError = Max(positionError, (position - keyFrame.position_).Length());
+            }
+            if (track.channelMask_ & CHANNEL_ROTATION)
+            {
+                const Quaternion rotation = compressedTrack->rotationCurve_.SampleQuaternion(keyFrame.time_, original->GetLength(), false, rotationIndex);
+                rotationError = Max(rotationError, 2.0f * Acos(Abs(rotation.DotProduct(keyFrame.rotation_.Normalized()))));
+            }
+            if (track.channelMask_ & CHANNEL_SCALE)
+            {
+                const Vector3 scale = compressedTrack->scaleCurve_.SampleVector3(keyFrame.time_, original->GetLength(), false, scaleIndex);
+                scaleError = Max(scaleError, (scale - keyFrame.scale_).Length());
+            }
+        }
+    }
+
+    PrintLine(String("Tracks: ") + String(original->GetNumTracks()) + ", keyframes: " + String(keyFrames) +
+        ", channels: " + String(channels) + " (" + String(constantChannels) + " constant), keys: " + String(keys));
+    PrintLine(String("Memory: ") + String(original->GetMemoryUse()) + " -> " + String(compressed->GetMemoryUse()) +
+        " bytes (" + String(100.0f * compressed->GetMemoryUse() / Max(original->GetMemoryUse(), 1u)) + "%)");
+    PrintLine(String("Max error: position ") + String(positionError) + ", rotation " + String(rotationError) +
+        " degrees, scale " + String(scaleError));
+}
@@ -40,6 +40,7 @@ AllocatorBlock* AllocatorReserveBlock(AllocatorBlock* allocator, unsigned nodeSi
     newBlock->capacity_ = capacity;
     newBlock->free_ = nullptr;
     newBlock->next_ = nullptr;
+    newBlock->nodeAllocator_ = nullptr;
 
     if (!allocator)
         allocator = newBlock;
@@ -31,6 +31,8 @@ namespace Urho3D
 
 struct AllocatorBlock;
 struct AllocatorNode;
+class ConcurrentAllocatorBase;
+template <class T> class ConcurrentAllocator;
 
 /// %Allocator memory block.
 struct AllocatorBlock
@@ -43,6 +45,8 @@ struct AllocatorBlock
     AllocatorNode* free_;
     /// Next allocator block.
     AllocatorBlock* next_;
+    /// Thread-safe allocator for the owning container's element nodes, or null to use the blocks. Only used in the first block.
+    ConcurrentAllocatorBase* nodeAllocator_;
     /// Nodes follow.
 };
 
@@ -62,8 +66,12 @@ URHO3D_API void AllocatorUninitialize(AllocatorBlock* allocator);
 URHO3D_API void* AllocatorReserve(AllocatorBlock* allocator);
 /// Free a node. Does not free any blocks.
 URHO3D_API void AllocatorFree(AllocatorBlock* allocator, void* ptr);
+/// Reserve a node from a thread-safe allocator. Used by node containers which have been given one.
+URHO3D_API void* ConcurrentAllocatorReserve(ConcurrentAllocatorBase* allocator);
+/// Free a node to a thread-safe allocator.
+URHO3D_API void ConcurrentAllocatorFree(ConcurrentAllocatorBase* allocator, void* ptr);
 
-/// %Allocator template class. Allocates objects of a specific class.
+/// %Allocator template class. Allocates objects of a specific class. Not thread-safe; see ConcurrentAllocator for use from worker threads.
 template <class T> class Allocator
 {
 public:
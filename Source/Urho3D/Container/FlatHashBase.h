@@ -0,0 +1,464 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Urho3D.h>
+
+#include "../Container/Hash.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <utility>
+
+// SSE2 is part of the x86-64 baseline, so group probing does not depend on URHO3D_SSE there
+#if defined(URHO3D_SSE) || defined(__SSE2__) || defined(_M_X64)
+#define URHO3D_FLAT_HASH_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Urho3D
+{
+
+/// Control byte of an empty slot.
+static const signed char FLAT_HASH_EMPTY = -128;
+/// Control byte of an erased slot. Probing continues past it.
+static const signed char FLAT_HASH_DELETED = -2;
+
+/// Group of control bytes which are probed at once, using SSE2 when available.
+struct FlatHashGroup
+{
+    /// Number of control bytes in a group.
+    static constexpr unsigned WIDTH = 16;
+
+    /// Load the group starting at the control byte. Does not need to be aligned.
+    explicit FlatHashGroup(const signed char* ctrl)
+    {
+#ifdef URHO3D_FLAT_HASH_SSE2
+        ctrl_ = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+        memcpy(ctrl_, ctrl, WIDTH);
+#endif
+    }
+
+    /// Return a bit mask of the full slots with the given 7-bit hash.
+    unsigned Match(signed char hash) const
+    {
+#ifdef URHO3D_FLAT_HASH_SSE2
+        return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(hash), ctrl_));
+#else
+        unsigned mask = 0;
+        for (unsigned i = 0; i < WIDTH; ++i)
+            mask |= (unsigned)(ctrl_[i] == hash) << i;
+        return mask;
+#endif
+    }
+
+    /// Return a bit mask of the empty slots.
+    unsigned MatchEmpty() const { return Match(FLAT_HASH_EMPTY); }
+
+    /// Return a bit mask of the empty or erased slots.
+    unsigned MatchEmptyOrDeleted() const
+    {
+#ifdef URHO3D_FLAT_HASH_SSE2
+        return (unsigned)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl_));
+#else
+        unsigned mask = 0;
+        for (unsigned i = 0; i < WIDTH; ++i)
+            mask |= (unsigned)(ctrl_[i] < -1) << i;
+        return mask;
+#endif
+    }
+
+    /// Return a bit mask of the full slots.
+    unsigned MatchFull() const
+    {
+#ifdef URHO3D_FLAT_HASH_SSE2
+        return ~(unsigned)_mm_movemask_epi8(ctrl_) & 0xffffu;
+#else
+        unsigned mask = 0;
+        for (unsigned i = 0; i < WIDTH; ++i)
+            mask |= (unsigned)(ctrl_[i] >= 0) << i;
+        return mask;
+#endif
+    }
+
+    /// Return index of the lowest set bit in a non-zero mask.
+    static unsigned LowestBit(unsigned mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (unsigned)index;
+#else
+        return (unsigned)__builtin_ctz(mask);
+#endif
+    }
+
+    /// Control bytes.
+#ifdef URHO3D_FLAT_HASH_SSE2
+    __m128i ctrl_;
+#else
+    signed char ctrl_[WIDTH];
+#endif
+};
+
+/// Scramble a key hash so that the table index and the 7-bit control hash are both well distributed. MakeHash() is the identity for integers and nearly so for pointers.
+inline unsigned FlatHashMix(unsigned hash)
+{
+    hash ^= hash >> 16u;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13u;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16u;
+    return hash;
+}
+
+/// Flat hash table iterator. Skips empty and erased slots.
+template <class T> struct FlatHashIterator
+{
+    /// Construct.
+    FlatHashIterator() = default;
+
+    /// Construct at a slot. Advances to the next full slot.
+    FlatHashIterator(T* slots, const signed char* ctrl, unsigned index, unsigned capacity) :
+        slots_(slots),
+        ctrl_(ctrl),
+        index_(index),
+        capacity_(capacity)
+    {
+        SkipEmpty();
+    }
+
+    /// Construct a const iterator from a non-const iterator.
+    template <class V> FlatHashIterator(const FlatHashIterator<V>& rhs) :  // NOLINT(google-explicit-constructor)
+        slots_(rhs.slots_),
+        ctrl_(rhs.ctrl_),
+        index_(rhs.index_),
+        capacity_(rhs.capacity_)
+    {
+    }
+
+    /// Test for equality with another iterator.
+    template <class V> bool operator ==(const FlatHashIterator<V>& rhs) const { return index_ == rhs.index_ && ctrl_ == rhs.ctrl_; }
+    /// Test for inequality with another iterator.
+    template <class V> bool operator !=(const FlatHashIterator<V>& rhs) const { return !(*this == rhs); }
+
+    /// Preincrement.
+    FlatHashIterator& operator ++()
+    {
+        ++index_;
+        SkipEmpty();
+        return *this;
+    }
+
+    /// Postincrement.
+    FlatHashIterator operator ++(int)
+    {
+        FlatHashIterator it = *this;
+        ++*this;
+        return it;
+    }
+
+    /// Point to the value.
+    T* operator ->() const { return slots_ + index_; }
+    /// Dereference the value.
+    T& operator *() const { return slots_[index_]; }
+
+    /// Advance to the next full slot or the end, a group at a time.
+    void SkipEmpty()
+    {
+        while (index_ < capacity_)
+        {
+            const unsigned match = FlatHashGroup(ctrl_ + index_).MatchFull();
+            if (match)
+            {
+                // The group may run into the cloned bytes past the end
+                index_ += FlatHashGroup::LowestBit(match);
+                if (index_ > capacity_)
+                    index_ = capacity_;
+                return;
+            }
+            index_ += FlatHashGroup::WIDTH;
+        }
+        index_ = capacity_;
+    }
+
+    /// Slots.
+    T* slots_{};
+    /// Control bytes.
+    const signed char* ctrl_{};
+    /// Slot index.
+    unsigned index_{};
+    /// Table capacity.
+    unsigned capacity_{};
+};
+
+/// Open-addressing hash table shared by FlatHashMap and FlatHashSet. Values live in one flat array and are found by probing 16 control bytes at a time, so lookups touch few cache lines and insertions do not allocate per value. Inserting may move values; erasing never does, so erasing while iterating is safe.
+template <class Slot, class Key, class Traits> class FlatHashTable
+{
+    static_assert(alignof(Slot) <= alignof(std::max_align_t), "Over-aligned values are not supported");
+
+public:
+    /// Construct empty.
+    FlatHashTable() = default;
+
+    /// Copy-construct.
+    FlatHashTable(const FlatHashTable& rhs)
+    {
+        Reserve(rhs.size_);
+        for (unsigned i = 0; i < rhs.capacity_; ++i)
+        {
+            if (rhs.ctrl_[i] >= 0)
+                new(slots_ + PrepareInsert(Traits::GetKey(rhs.slots_[i]))) Slot(rhs.slots_[i]);
+        }
+    }
+
+    /// Move-construct.
+    FlatHashTable(FlatHashTable&& rhs) noexcept
+    {
+        Swap(rhs);
+    }
+
+    /// Destruct.
+    ~FlatHashTable()
+    {
+        DestroySlots();
+        delete[] reinterpret_cast<unsigned char*>(ctrl_);
+    }
+
+    /// Assign from another table.
+    FlatHashTable& operator =(const FlatHashTable& rhs)
+    {
+        if (&rhs != this)
+        {
+            FlatHashTable copy(rhs);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    /// Move-assign from another table.
+    FlatHashTable& operator =(FlatHashTable&& rhs) noexcept
+    {
+        Swap(rhs);
+        return *this;
+    }
+
+    /// Swap with another table.
+    void Swap(FlatHashTable& rhs)
+    {
+        std::swap(ctrl_, rhs.ctrl_);
+        std::swap(slots_, rhs.slots_);
+        std::swap(capacity_, rhs.capacity_);
+        std::swap(size_, rhs.size_);
+        std::swap(growthLeft_, rhs.growthLeft_);
+    }
+
+    /// Remove all values. Keeps the allocation.
+    void Clear()
+    {
+        if (!size_ && growthLeft_ == MaxLoad(capacity_))
+            return;
+
+        DestroySlots();
+        if (capacity_)
+            memset(ctrl_, FLAT_HASH_EMPTY, capacity_ + FlatHashGroup::WIDTH - 1);
+        size_ = 0;
+        growthLeft_ = MaxLoad(capacity_);
+    }
+
+    /// Make room for at least the specified number of values without rehashing.
+    void Reserve(unsigned numValues)
+    {
+        if (numValues > size_ + growthLeft_)
+            Resize(CapacityFor(numValues));
+    }
+
+    /// Return number of values.
+    unsigned Size() const { return size_; }
+    /// Return number of slots.
+    unsigned Capacity() const { return capacity_; }
+    /// Return whether has no values.
+    bool Empty() const { return size_ == 0; }
+
+protected:
+    /// Return index of the slot holding the key, or capacity if not found.
+    unsigned FindIndex(const Key& key) const
+    {
+        if (!size_)
+            return capacity_;
+
+        const unsigned hash = FlatHashMix(MakeHash(key));
+        const auto h2 = (signed char)(hash & 0x7fu);
+        const unsigned mask = capacity_ - 1;
+        unsigned pos = (hash >> 7u) & mask;
+
+        for (unsigned step = FlatHashGroup::WIDTH;; step += FlatHashGroup::WIDTH)
+        {
+            FlatHashGroup group(ctrl_ + pos);
+            for (unsigned match = group.Match(h2); match; match &= match - 1)
+            {
+                const unsigned index = (pos + FlatHashGroup::LowestBit(match)) & mask;
+                if (Traits::GetKey(slots_[index]) == key)
+                    return index;
+            }
+            if (group.MatchEmpty())
+                return capacity_;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    /// Find the key, or claim a slot for it. Return the slot index and set the inserted flag. A claimed slot is left unconstructed.
+    unsigned FindOrPrepareInsert(const Key& key, bool& inserted)
+    {
+        const unsigned index = FindIndex(key);
+        inserted = index == capacity_;
+        return inserted ? PrepareInsert(key) : index;
+    }
+
+    /// Claim a slot for a key known not to be in the table. The slot is left unconstructed.
+    unsigned PrepareInsert(const Key& key)
+    {
+        if (!growthLeft_)
+        {
+            // Reclaim erased slots if they make up most of the load, otherwise grow
+            if (capacity_ && size_ <= MaxLoad(capacity_) / 2)
+                Resize(capacity_);
+            else
+                Resize(capacity_ ? capacity_ * 2 : FlatHashGroup::WIDTH);
+        }
+
+        const unsigned hash = FlatHashMix(MakeHash(key));
+        const unsigned index = FindFirstFree(hash);
+        if (ctrl_[index] == FLAT_HASH_EMPTY)
+            --growthLeft_;
+        SetCtrl(index, (signed char)(hash & 0x7fu));
+        ++size_;
+        return index;
+    }
+
+    /// Destroy the value at a slot and mark it erased.
+    void EraseIndex(unsigned index)
+    {
+        slots_[index].~Slot();
+        SetCtrl(index, FLAT_HASH_DELETED);
+        --size_;
+    }
+
+    /// Control bytes: capacity plus a copy of the first group's bytes at the end, so that a group can be loaded at any slot.
+    signed char* ctrl_{};
+    /// Slots.
+    Slot* slots_{};
+    /// Number of slots. Zero or a power of two of at least the group width.
+    unsigned capacity_{};
+    /// Number of values.
+    unsigned size_{};
+    /// Number of empty slots which may still be filled before rehashing.
+    unsigned growthLeft_{};
+
+private:
+    /// Return the maximum number of used slots, 7/8 of the capacity.
+    static unsigned MaxLoad(unsigned capacity) { return capacity - capacity / 8; }
+
+    /// Return the capacity needed for a number of values.
+    static unsigned CapacityFor(unsigned numValues)
+    {
+        unsigned capacity = FlatHashGroup::WIDTH;
+        while (MaxLoad(capacity) < numValues)
+            capacity <<= 1u;
+        return capacity;
+    }
+
+    /// Return the first empty or erased slot in the probe sequence of a hash.
+    unsigned FindFirstFree(unsigned hash) const
+    {
+        const unsigned mask = capacity_ - 1;
+        unsigned pos = (hash >> 7u) & mask;
+
+        for (unsigned step = FlatHashGroup::WIDTH;; step += FlatHashGroup::WIDTH)
+        {
+            const unsigned match = FlatHashGroup(ctrl_ + pos).MatchEmptyOrDeleted();
+            if (match)
+                return (pos + FlatHashGroup::LowestBit(match)) & mask;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    /// Set a control byte and its mirror in the cloned group.
+    void SetCtrl(unsigned index, signed char value)
+    {
+        const unsigned cloned = FlatHashGroup::WIDTH - 1;
+        ctrl_[index] = value;
+        ctrl_[((index - cloned) & (capacity_ - 1)) + cloned] = value;
+    }
+
+    /// Destroy all values.
+    void DestroySlots()
+    {
+        for (unsigned i = 0; i < capacity_; ++i)
+        {
+            if (ctrl_[i] >= 0)
+                slots_[i].~Slot();
+        }
+    }
+
+    /// Move the values to a new allocation. Also drops erased slots.
+    void Resize(unsigned newCapacity)
+    {
+        signed char* oldCtrl = ctrl_;
+        Slot* oldSlots = slots_;
+        const unsigned oldCapacity = capacity_;
+
+        // Control bytes and slots in one allocation. Slots start at a maximally aligned offset
+        const unsigned ctrlBytes = newCapacity + FlatHashGroup::WIDTH - 1;
+        const unsigned slotOffset = (ctrlBytes + alignof(std::max_align_t) - 1) & ~(unsigned)(alignof(std::max_align_t) - 1);
+        auto* block = new unsigned char[slotOffset + newCapacity * sizeof(Slot)];
+        ctrl_ = reinterpret_cast<signed char*>(block);
+        slots_ = reinterpret_cast<Slot*>(block + slotOffset);
+        capacity_ = newCapacity;
+        memset(ctrl_, FLAT_HASH_EMPTY, ctrlBytes);
+        growthLeft_ = MaxLoad(newCapacity) - size_;
+
+        for (unsigned i = 0; i < oldCapacity; ++i)
+        {
+            if (oldCtrl[i] >= 0)
+            {
+                Slot& slot = oldSlots[i];
+                const unsigned hash = FlatHashMix(MakeHash(Traits::GetKey(slot)));
+                const unsigned index = FindFirstFree(hash);
+                SetCtrl(index, (signed char)(hash & 0x7fu));
+                new(slots_ + index) Slot(std::move(slot));
+                slot.~Slot();
+            }
+        }
+
+        delete[] reinterpret_cast<unsigned char*>(oldCtrl);
+    }
+};
+
+}
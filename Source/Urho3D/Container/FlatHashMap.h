@@ -0,0 +1,266 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Base/Pair.h"
+#include "../Container/FlatHashBase.h"
+#include "../Container/Vector.h"
+
+#include <initializer_list>
+
+namespace Urho3D
+{
+
+/// Open-addressing hash map with the HashMap interface. Faster to look up, insert and iterate than HashMap, but inserting may move values and invalidates iterators, and iteration order is unspecified.
+template <class T, class U> class FlatHashMap
+{
+public:
+    using KeyType = T;
+    using ValueType = U;
+
+    /// Key-value pair.
+    struct KeyValue
+    {
+        /// Construct with key and value.
+        KeyValue(const T& first, const U& second) :
+            first_(first),
+            second_(second)
+        {
+        }
+
+        /// Construct with key and default value.
+        explicit KeyValue(const T& first) :
+            first_(first),
+            second_()
+        {
+        }
+
+        /// Key. Must not be modified.
+        T first_;
+        /// Value.
+        U second_;
+    };
+
+private:
+    /// Key access for the table.
+    struct Traits
+    {
+        static const T& GetKey(const KeyValue& slot) { return slot.first_; }
+    };
+
+    /// Table type.
+    using Table = FlatHashTable<KeyValue, T, Traits>;
+
+    /// Table implementation.
+    struct Impl : public Table
+    {
+        using Table::FindIndex;
+        using Table::FindOrPrepareInsert;
+        using Table::EraseIndex;
+        using Table::ctrl_;
+        using Table::slots_;
+        using Table::capacity_;
+    };
+
+public:
+    /// Iterator.
+    using Iterator = FlatHashIterator<KeyValue>;
+    /// Const iterator.
+    using ConstIterator = FlatHashIterator<const KeyValue>;
+
+    /// Construct empty.
+    FlatHashMap() = default;
+
+    /// Construct from an initializer list.
+    FlatHashMap(const std::initializer_list<Pair<T, U> >& list)
+    {
+        impl_.Reserve((unsigned)list.size());
+        for (auto it = list.begin(); it != list.end(); ++it)
+            Insert(*it);
+    }
+
+    /// Test for equality with another map.
+    bool operator ==(const FlatHashMap& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            ConstIterator j = rhs.Find(i->first_);
+            if (j == rhs.End() || j->second_ != i->second_)
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another map.
+    bool operator !=(const FlatHashMap& rhs) const { return !(*this == rhs); }
+
+    /// Index the map. Create a new pair if key not found.
+    U& operator [](const T& key)
+    {
+        bool inserted;
+        const unsigned index = impl_.FindOrPrepareInsert(key, inserted);
+        if (inserted)
+            new(impl_.slots_ + index) KeyValue(key);
+        return impl_.slots_[index].second_;
+    }
+
+    /// Index the map. Return null if key is not found, does not create a new pair.
+    U* operator [](const T& key) const
+    {
+        const unsigned index = impl_.FindIndex(key);
+        return index != impl_.capacity_ ? &impl_.slots_[index].second_ : nullptr;
+    }
+
+    /// Insert a pair. Return an iterator to it. If the key exists, its value is replaced.
+    Iterator Insert(const Pair<T, U>& pair)
+    {
+        bool exists;
+        return Insert(pair, exists);
+    }
+
+    /// Insert a pair. Return iterator and set exists flag according to whether the key already existed.
+    Iterator Insert(const Pair<T, U>& pair, bool& exists)
+    {
+        bool inserted;
+        const unsigned index = impl_.FindOrPrepareInsert(pair.first_, inserted);
+        if (inserted)
+            new(impl_.slots_ + index) KeyValue(pair.first_, pair.second_);
+        else
+            impl_.slots_[index].second_ = pair.second_;
+        exists = !inserted;
+        return MakeIterator(index);
+    }
+
+    /// Insert a map.
+    void Insert(const FlatHashMap& map)
+    {
+        for (ConstIterator i = map.Begin(); i != map.End(); ++i)
+            operator [](i->first_) = i->second_;
+    }
+
+    /// Erase a pair by key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        const unsigned index = impl_.FindIndex(key);
+        if (index == impl_.capacity_)
+            return false;
+
+        impl_.EraseIndex(index);
+        return true;
+    }
+
+    /// Erase a pair by iterator. Return iterator to the next pair.
+    Iterator Erase(const Iterator& it)
+    {
+        impl_.EraseIndex(it.index_);
+        return MakeIterator(it.index_ + 1);
+    }
+
+    /// Remove all pairs. Keeps the allocation.
+    void Clear() { impl_.Clear(); }
+
+    /// Make room for at least the specified number of pairs without rehashing.
+    void Reserve(unsigned numPairs) { impl_.Reserve(numPairs); }
+
+    /// Swap with another map.
+    void Swap(FlatHashMap& rhs) { impl_.Swap(rhs.impl_); }
+
+    /// Return iterator to the pair with key, or end iterator if not found.
+    Iterator Find(const T& key) { return MakeIterator(impl_.FindIndex(key)); }
+
+    /// Return const iterator to the pair with key, or end iterator if not found.
+    ConstIterator Find(const T& key) const { return MakeIterator(impl_.FindIndex(key)); }
+
+    /// Return whether contains a pair with key.
+    bool Contains(const T& key) const { return impl_.FindIndex(key) != impl_.capacity_; }
+
+    /// Try to copy value to output. Return true if was found.
+    bool TryGetValue(const T& key, U& out) const
+    {
+        const unsigned index = impl_.FindIndex(key);
+        if (index == impl_.capacity_)
+            return false;
+
+        out = impl_.slots_[index].second_;
+        return true;
+    }
+
+    /// Return all the keys.
+    Vector<T> Keys() const
+    {
+        Vector<T> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->first_);
+        return result;
+    }
+
+    /// Return all the values.
+    Vector<U> Values() const
+    {
+        Vector<U> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->second_);
+        return result;
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return MakeIterator(0); }
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return MakeIterator(0); }
+    /// Return iterator to the end.
+    Iterator End() { return MakeIterator(impl_.capacity_); }
+    /// Return iterator to the end.
+    ConstIterator End() const { return MakeIterator(impl_.capacity_); }
+
+    /// Return number of pairs.
+    unsigned Size() const { return impl_.Size(); }
+    /// Return number of slots.
+    unsigned Capacity() const { return impl_.Capacity(); }
+    /// Return whether map is empty.
+    bool Empty() const { return impl_.Empty(); }
+
+private:
+    /// Return iterator at a slot index.
+    Iterator MakeIterator(unsigned index) { return Iterator(impl_.slots_, impl_.ctrl_, index, impl_.capacity_); }
+    /// Return const iterator at a slot index.
+    ConstIterator MakeIterator(unsigned index) const { return ConstIterator(impl_.slots_, impl_.ctrl_, index, impl_.capacity_); }
+
+    /// Table.
+    Impl impl_;
+};
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::ConstIterator begin(const Urho3D::FlatHashMap<T, U>& v) { return v.Begin(); }
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::ConstIterator end(const Urho3D::FlatHashMap<T, U>& v) { return v.End(); }
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::Iterator begin(Urho3D::FlatHashMap<T, U>& v) { return v.Begin(); }
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::Iterator end(Urho3D::FlatHashMap<T, U>& v) { return v.End(); }
+
+}
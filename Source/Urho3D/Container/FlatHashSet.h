@@ -0,0 +1,185 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/FlatHashBase.h"
+#include "../Container/Vector.h"
+
+#include <initializer_list>
+
+namespace Urho3D
+{
+
+/// Open-addressing hash set with the HashSet interface. Faster to look up, insert and iterate than HashSet, but inserting invalidates iterators, and iteration order is unspecified.
+template <class T> class FlatHashSet
+{
+    /// Key access for the table.
+    struct Traits
+    {
+        static const T& GetKey(const T& slot) { return slot; }
+    };
+
+    /// Table type.
+    using Table = FlatHashTable<T, T, Traits>;
+
+    /// Table implementation.
+    struct Impl : public Table
+    {
+        using Table::FindIndex;
+        using Table::FindOrPrepareInsert;
+        using Table::EraseIndex;
+        using Table::ctrl_;
+        using Table::slots_;
+        using Table::capacity_;
+    };
+
+public:
+    using KeyType = T;
+
+    /// Iterator. Keys must not be modified.
+    using Iterator = FlatHashIterator<const T>;
+    /// Const iterator.
+    using ConstIterator = FlatHashIterator<const T>;
+
+    /// Construct empty.
+    FlatHashSet() = default;
+
+    /// Construct from an initializer list.
+    FlatHashSet(const std::initializer_list<T>& list)
+    {
+        impl_.Reserve((unsigned)list.size());
+        for (auto it = list.begin(); it != list.end(); ++it)
+            Insert(*it);
+    }
+
+    /// Test for equality with another set.
+    bool operator ==(const FlatHashSet& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            if (!rhs.Contains(*i))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another set.
+    bool operator !=(const FlatHashSet& rhs) const { return !(*this == rhs); }
+
+    /// Insert a key. Return an iterator to it.
+    Iterator Insert(const T& key)
+    {
+        bool exists;
+        return Insert(key, exists);
+    }
+
+    /// Insert a key. Return an iterator and set exists flag according to whether the key already existed.
+    Iterator Insert(const T& key, bool& exists)
+    {
+        bool inserted;
+        const unsigned index = impl_.FindOrPrepareInsert(key, inserted);
+        if (inserted)
+            new(impl_.slots_ + index) T(key);
+        exists = !inserted;
+        return MakeIterator(index);
+    }
+
+    /// Insert a set.
+    void Insert(const FlatHashSet& set)
+    {
+        for (ConstIterator i = set.Begin(); i != set.End(); ++i)
+            Insert(*i);
+    }
+
+    /// Erase a key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        const unsigned index = impl_.FindIndex(key);
+        if (index == impl_.capacity_)
+            return false;
+
+        impl_.EraseIndex(index);
+        return true;
+    }
+
+    /// Erase a key by iterator. Return iterator to the next key.
+    Iterator Erase(const Iterator& it)
+    {
+        impl_.EraseIndex(it.index_);
+        return MakeIterator(it.index_ + 1);
+    }
+
+    /// Remove all keys. Keeps the allocation.
+    void Clear() { impl_.Clear(); }
+
+    /// Make room for at least the specified number of keys without rehashing.
+    void Reserve(unsigned numKeys) { impl_.Reserve(numKeys); }
+
+    /// Swap with another set.
+    void Swap(FlatHashSet& rhs) { impl_.Swap(rhs.impl_); }
+
+    /// Return iterator to the key, or end iterator if not found.
+    ConstIterator Find(const T& key) const { return MakeIterator(impl_.FindIndex(key)); }
+
+    /// Return whether contains a key.
+    bool Contains(const T& key) const { return impl_.FindIndex(key) != impl_.capacity_; }
+
+    /// Return all the keys.
+    Vector<T> Keys() const
+    {
+        Vector<T> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(*i);
+        return result;
+    }
+
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return MakeIterator(0); }
+    /// Return iterator to the end.
+    ConstIterator End() const { return MakeIterator(impl_.capacity_); }
+
+    /// Return number of keys.
+    unsigned Size() const { return impl_.Size(); }
+    /// Return number of slots.
+    unsigned Capacity() const { return impl_.Capacity(); }
+    /// Return whether set is empty.
+    bool Empty() const { return impl_.Empty(); }
+
+private:
+    /// Return iterator at a slot index.
+    ConstIterator MakeIterator(unsigned index) const { return ConstIterator(impl_.slots_, impl_.ctrl_, index, impl_.capacity_); }
+
+    /// Table.
+    Impl impl_;
+};
+
+template <class T> typename Urho3D::FlatHashSet<T>::ConstIterator begin(const Urho3D::FlatHashSet<T>& v) { return v.Begin(); }
+
+template <class T> typename Urho3D::FlatHashSet<T>::ConstIterator end(const Urho3D::FlatHashSet<T>& v) { return v.End(); }
+
+}
@@ -0,0 +1,159 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/FrameArena.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+FrameArena::FrameArena(unsigned blockSize) :
+    blockSize_(Max(blockSize, 256U))
+{
+}
+
+FrameArena::~FrameArena()
+{
+    FreeBlocks();
+}
+
+void* FrameArena::Allocate(unsigned size, unsigned alignment)
+{
+    assert(alignment && !(alignment & (alignment - 1)));
+
+    if (!blocks_.Empty())
+    {
+        const Block& block = blocks_[currentBlock_];
+        const size_t address = (size_t)(block.data_ + offset_);
+        const unsigned padding = (unsigned)((alignment - (address & (alignment - 1))) & (alignment - 1));
+        if (offset_ + padding + size <= block.size_)
+        {
+            offset_ += padding;
+            void* ptr = block.data_ + offset_;
+            offset_ += size;
+            return ptr;
+        }
+    }
+
+    NextBlock(size, alignment);
+    return Allocate(size, alignment);
+}
+
+bool FrameArena::Reallocate(void* ptr, unsigned oldSize, unsigned newSize)
+{
+    if (blocks_.Empty() || !ptr)
+        return false;
+
+    const Block& block = blocks_[currentBlock_];
+    auto* bytes = static_cast<unsigned char*>(ptr);
+    // Only the most recent allocation can be resized
+    if (bytes + oldSize != block.data_ + offset_)
+        return false;
+
+    const auto start = (unsigned)(bytes - block.data_);
+    if (start + newSize > block.size_)
+        return false;
+
+    offset_ = start + newSize;
+    return true;
+}
+
+void FrameArena::Reset()
+{
+    peakBytes_ = GetPeakBytes();
+
+    // If the frame spilled into several blocks, replace them with one which holds the peak usage
+    if (blocks_.Size() > 1)
+    {
+        const unsigned capacity = GetCapacity();
+        FreeBlocks();
+        Block block;
+        block.size_ = capacity;
+        block.data_ = new unsigned char[capacity];
+        blocks_.Push(block);
+        ++numBlockAllocations_;
+    }
+
+    currentBlock_ = 0;
+    offset_ = 0;
+    usedBytes_ = 0;
+}
+
+void FrameArena::Rewind(const FrameArenaMarker& marker)
+{
+    assert(marker.block_ <= currentBlock_ && (marker.block_ < currentBlock_ || marker.offset_ <= offset_));
+
+    peakBytes_ = GetPeakBytes();
+    currentBlock_ = marker.block_;
+    offset_ = marker.offset_;
+    usedBytes_ = marker.usedBytes_;
+}
+
+unsigned FrameArena::GetCapacity() const
+{
+    unsigned capacity = 0;
+    for (const Block& block : blocks_)
+        capacity += block.size_;
+    return capacity;
+}
+
+void FrameArena::NextBlock(unsigned size, unsigned alignment)
+{
+    const unsigned required = size + alignment;
+
+    if (!blocks_.Empty())
+    {
+        usedBytes_ += offset_;
+        offset_ = 0;
+
+        // Reuse following blocks if they are large enough
+        while (currentBlock_ + 1 < blocks_.Size())
+        {
+            ++currentBlock_;
+            if (blocks_[currentBlock_].size_ >= required)
+                return;
+        }
+    }
+
+    // Grow geometrically so that a frame needs few blocks
+    Block block;
+    block.size_ = Max(Max(blockSize_, GetCapacity()), required);
+    block.data_ = new unsigned char[block.size_];
+    blocks_.Push(block);
+    currentBlock_ = blocks_.Size() - 1;
+    ++numBlockAllocations_;
+}
+
+void FrameArena::FreeBlocks()
+{
+    for (const Block& block : blocks_)
+        delete[] block.data_;
+    blocks_.Clear();
+    currentBlock_ = 0;
+    offset_ = 0;
+    usedBytes_ = 0;
+}
+
+}
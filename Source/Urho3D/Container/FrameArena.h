@@ -0,0 +1,144 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Math/MathDefs.h"
+
+#include <cstddef>
+
+namespace Urho3D
+{
+
+/// Position in a FrameArena to rewind to.
+struct FrameArenaMarker
+{
+    /// Block index.
+    unsigned block_;
+    /// Offset within the block.
+    unsigned offset_;
+    /// Bytes used in the blocks before.
+    unsigned usedBytes_;
+};
+
+/// Linear bump allocator for transient data that lives until the end of the frame. Not thread-safe: use one arena per thread. Memory is released all at once by Reset(), which also coalesces the blocks, so that once the arena has seen its peak usage further frames allocate nothing from the heap.
+class URHO3D_API FrameArena
+{
+public:
+    /// Construct with the size of the first block.
+    explicit FrameArena(unsigned blockSize = 64 * 1024);
+    /// Destruct. Frees all blocks.
+    ~FrameArena();
+    /// Prevent copy construction.
+    FrameArena(const FrameArena& rhs) = delete;
+    /// Prevent assignment.
+    FrameArena& operator =(const FrameArena& rhs) = delete;
+
+    /// Allocate uninitialized memory. Alignment must be a power of two. Never returns null.
+    void* Allocate(unsigned size, unsigned alignment = alignof(std::max_align_t));
+    /// Try to grow or shrink the most recent allocation in place. Return true on success.
+    bool Reallocate(void* ptr, unsigned oldSize, unsigned newSize);
+    /// Release all allocations. Blocks are kept, or merged into one block if more than one was needed.
+    void Reset();
+    /// Return the current position.
+    FrameArenaMarker GetMarker() const { return {currentBlock_, offset_, usedBytes_}; }
+    /// Release the allocations made after a marker. Markers must be rewound in reverse order, and before the arena is reset.
+    void Rewind(const FrameArenaMarker& marker);
+
+    /// Allocate an uninitialized array.
+    template <class T> T* AllocateArray(unsigned count) { return static_cast<T*>(Allocate(count * (unsigned)sizeof(T), (unsigned)alignof(T))); }
+
+    /// Return bytes allocated since the last reset, including alignment padding.
+    unsigned GetUsedBytes() const { return usedBytes_ + offset_; }
+    /// Return the highest number of bytes used in one frame.
+    unsigned GetPeakBytes() const { return Max(peakBytes_, GetUsedBytes()); }
+    /// Return the total size of the blocks.
+    unsigned GetCapacity() const;
+    /// Return number of blocks.
+    unsigned GetNumBlocks() const { return blocks_.Size(); }
+    /// Return number of heap allocations made for blocks since construction.
+    unsigned GetNumBlockAllocations() const { return numBlockAllocations_; }
+
+private:
+    /// Memory block.
+    struct Block
+    {
+        /// Data.
+        unsigned char* data_;
+        /// Size in bytes.
+        unsigned size_;
+    };
+
+    /// Move to a block which can hold an allocation, creating one if necessary.
+    void NextBlock(unsigned size, unsigned alignment);
+    /// Free all blocks.
+    void FreeBlocks();
+
+    /// Blocks.
+    PODVector<Block> blocks_;
+    /// Index of the block being allocated from.
+    unsigned currentBlock_{};
+    /// Allocation offset within the current block.
+    unsigned offset_{};
+    /// Bytes used in the blocks before the current one.
+    unsigned usedBytes_{};
+    /// Highest usage seen before the last reset or rewind.
+    unsigned peakBytes_{};
+    /// Size of new blocks.
+    unsigned blockSize_;
+    /// Number of block allocations.
+    unsigned numBlockAllocations_{};
+};
+
+/// Rewinds a FrameArena on scope exit, so that nested scratch allocations such as recursive layout updates do not accumulate over the frame. Everything allocated from the arena while the scope is alive is released with it, so allocations inside it must not escape.
+class FrameArenaScope
+{
+public:
+    /// Construct. The arena may be null.
+    explicit FrameArenaScope(FrameArena* arena) :
+        arena_(arena)
+    {
+        if (arena_)
+            marker_ = arena_->GetMarker();
+    }
+
+    /// Destruct. Rewind the arena.
+    ~FrameArenaScope()
+    {
+        if (arena_)
+            arena_->Rewind(marker_);
+    }
+
+    /// Prevent copy construction.
+    FrameArenaScope(const FrameArenaScope& rhs) = delete;
+    /// Prevent assignment.
+    FrameArenaScope& operator =(const FrameArenaScope& rhs) = delete;
+
+private:
+    /// Arena.
+    FrameArena* arena_;
+    /// Position on construction.
+    FrameArenaMarker marker_{};
+};
+
+}
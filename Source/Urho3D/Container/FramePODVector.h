@@ -0,0 +1,249 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/FrameArena.h"
+
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace Urho3D
+{
+
+/// %Vector for POD types which takes its memory from a FrameArena, so that building it does not touch the heap. The contents are valid until the arena is reset, normally at the end of the frame; call Reset() before reusing it in the next frame. Without an arena it falls back to the heap. Copies always use the heap.
+template <class T> class FramePODVector
+{
+    static_assert(std::is_trivially_copyable_v<T>, "FramePODVector requires trivially copyable values");
+
+public:
+    using ValueType = T;
+    using Iterator = T*;
+    using ConstIterator = const T*;
+
+    /// Construct empty, taking memory from an arena, or the heap if null.
+    explicit FramePODVector(FrameArena* arena = nullptr) noexcept :
+        arena_(arena)
+    {
+    }
+
+    /// Copy-construct. The copy uses the heap.
+    FramePODVector(const FramePODVector& rhs)
+    {
+        *this = rhs;
+    }
+
+    /// Move-construct.
+    FramePODVector(FramePODVector&& rhs) noexcept
+    {
+        Swap(rhs);
+    }
+
+    /// Destruct.
+    ~FramePODVector()
+    {
+        FreeHeap();
+    }
+
+    /// Assign from another vector. Keeps the current arena.
+    FramePODVector& operator =(const FramePODVector& rhs)
+    {
+        if (&rhs != this)
+        {
+            Clear();
+            Push(rhs.Buffer(), rhs.size_);
+        }
+        return *this;
+    }
+
+    /// Move-assign from another vector.
+    FramePODVector& operator =(FramePODVector&& rhs) noexcept
+    {
+        Swap(rhs);
+        return *this;
+    }
+
+    /// Drop the contents without freeing them, and take memory from an arena, or the heap if null, from now on. Call before reusing a vector whose arena has been reset.
+    void Reset(FrameArena* arena)
+    {
+        FreeHeap();
+        arena_ = arena;
+        buffer_ = nullptr;
+        size_ = 0;
+        capacity_ = 0;
+    }
+
+    /// Add an element at the end.
+    void Push(const T& value)
+    {
+        if (size_ == capacity_)
+            Grow(size_ + 1);
+        buffer_[size_++] = value;
+    }
+
+    /// Add elements at the end.
+    void Push(const T* values, unsigned count)
+    {
+        if (size_ + count > capacity_)
+            Grow(size_ + count);
+        if (count)
+            memcpy(buffer_ + size_, values, count * sizeof(T));
+        size_ += count;
+    }
+
+    /// Remove the last element.
+    void Pop()
+    {
+        if (size_)
+            --size_;
+    }
+
+    /// Resize the vector. New elements are uninitialized.
+    void Resize(unsigned newSize)
+    {
+        if (newSize > capacity_)
+            Grow(newSize);
+        size_ = newSize;
+    }
+
+    /// Set new capacity.
+    void Reserve(unsigned newCapacity)
+    {
+        if (newCapacity > capacity_)
+            SetCapacity(newCapacity);
+    }
+
+    /// Remove all elements. Keeps the memory.
+    void Clear() { size_ = 0; }
+
+    /// Swap with another vector.
+    void Swap(FramePODVector& rhs) noexcept
+    {
+        std::swap(arena_, rhs.arena_);
+        std::swap(buffer_, rhs.buffer_);
+        std::swap(size_, rhs.size_);
+        std::swap(capacity_, rhs.capacity_);
+    }
+
+    /// Return element at index.
+    T& operator [](unsigned index)
+    {
+        assert(index < size_);
+        return buffer_[index];
+    }
+
+    /// Return const element at index.
+    const T& operator [](unsigned index) const
+    {
+        assert(index < size_);
+        return buffer_[index];
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return buffer_; }
+    /// Return const iterator to the beginning.
+    ConstIterator Begin() const { return buffer_; }
+    /// Return iterator to the end.
+    Iterator End() { return buffer_ + size_; }
+    /// Return const iterator to the end.
+    ConstIterator End() const { return buffer_ + size_; }
+
+    /// Return first element.
+    T& Front() { return (*this)[0]; }
+    /// Return last element.
+    T& Back() { return (*this)[size_ - 1]; }
+
+    /// Return the buffer.
+    T* Buffer() { return buffer_; }
+    /// Return the buffer.
+    const T* Buffer() const { return buffer_; }
+    /// Return number of elements.
+    unsigned Size() const { return size_; }
+    /// Return capacity.
+    unsigned Capacity() const { return capacity_; }
+    /// Return whether vector is empty.
+    bool Empty() const { return size_ == 0; }
+    /// Return the arena, or null if using the heap.
+    FrameArena* GetArena() const { return arena_; }
+
+private:
+    /// Grow to hold at least the given number of elements.
+    void Grow(unsigned minCapacity)
+    {
+        SetCapacity(Max(minCapacity, Max(capacity_ + (capacity_ + 1) / 2, 8U)));
+    }
+
+    /// Reallocate. The old arena memory is abandoned until the arena is reset, unless it can be extended in place.
+    void SetCapacity(unsigned newCapacity)
+    {
+        if (arena_)
+        {
+            if (buffer_ && arena_->Reallocate(buffer_, capacity_ * sizeof(T), newCapacity * sizeof(T)))
+            {
+                capacity_ = newCapacity;
+                return;
+            }
+
+            T* newBuffer = arena_->AllocateArray<T>(newCapacity);
+            if (size_)
+                memcpy(newBuffer, buffer_, size_ * sizeof(T));
+            buffer_ = newBuffer;
+        }
+        else
+        {
+            T* newBuffer = reinterpret_cast<T*>(new unsigned char[newCapacity * sizeof(T)]);
+            if (size_)
+                memcpy(newBuffer, buffer_, size_ * sizeof(T));
+            FreeHeap();
+            buffer_ = newBuffer;
+        }
+
+        capacity_ = newCapacity;
+    }
+
+    /// Free the buffer if it came from the heap.
+    void FreeHeap()
+    {
+        if (!arena_)
+            delete[] reinterpret_cast<unsigned char*>(buffer_);
+    }
+
+    /// Arena, or null to use the heap.
+    FrameArena* arena_{};
+    /// Buffer.
+    T* buffer_{};
+    /// Number of elements.
+    unsigned size_{};
+    /// Buffer capacity.
+    unsigned capacity_{};
+};
+
+template <class T> typename Urho3D::FramePODVector<T>::ConstIterator begin(const Urho3D::FramePODVector<T>& v) { return v.Begin(); }
+
+template <class T> typename Urho3D::FramePODVector<T>::ConstIterator end(const Urho3D::FramePODVector<T>& v) { return v.End(); }
+
+template <class T> typename Urho3D::FramePODVector<T>::Iterator begin(Urho3D::FramePODVector<T>& v) { return v.Begin(); }
+
+template <class T> typename Urho3D::FramePODVector<T>::Iterator end(Urho3D::FramePODVector<T>& v) { return v.End(); }
+
+}
@@ -525,6 +525,15 @@ public:
         return true;
     }
 
+    /// Take the element nodes from a thread-safe allocator, so that several maps filled and destroyed on different threads can share one pool. The map itself is still not thread-safe. Only possible while empty; the allocator must outlive the map.
+    bool SetNodeAllocator(ConcurrentAllocator<Node>* allocator)
+    {
+        if (!allocator_ || !Empty())
+            return false;
+        allocator_->nodeAllocator_ = allocator;
+        return true;
+    }
+
     /// Return iterator to the pair with key, or end iterator if not found.
     Iterator Find(const T& key)
     {
@@ -749,7 +758,8 @@ private:
     /// Reserve a node with specified key and value.
     Node* ReserveNode(const T& key, const U& value)
     {
-        auto* newNode = static_cast<Node*>(AllocatorReserve(allocator_));
+        auto* newNode = static_cast<Node*>(allocator_->nodeAllocator_ ? ConcurrentAllocatorReserve(allocator_->nodeAllocator_) :
+            AllocatorReserve(allocator_));
         new(newNode) Node(key, value);
         return newNode;
     }
@@ -758,7 +768,10 @@ private:
     void FreeNode(Node* node)
     {
         (node)->~Node();
-        AllocatorFree(allocator_, node);
+        if (node != tail_ && allocator_->nodeAllocator_)
+            ConcurrentAllocatorFree(allocator_->nodeAllocator_, node);
+        else
+            AllocatorFree(allocator_, node);
     }
 
     /// Rehash the buckets.
@@ -359,6 +359,15 @@ public:
         }
     }
 
+    /// Take the element nodes from a thread-safe allocator, so that several lists filled and destroyed on different threads can share one pool. The list itself is still not thread-safe. Only possible while empty; the allocator must outlive the list.
+    bool SetNodeAllocator(ConcurrentAllocator<Node>* allocator)
+    {
+        if (!allocator_ || !Empty())
+            return false;
+        allocator_->nodeAllocator_ = allocator;
+        return true;
+    }
+
     /// Resize the list by removing or adding items at the end.
     void Resize(unsigned newSize)
     {
@@ -482,7 +491,8 @@ private:
     /// Reserve a node with initial value.
     Node* ReserveNode(const T& value)
     {
-        auto* newNode = static_cast<Node*>(AllocatorReserve(allocator_));
+        auto* newNode = static_cast<Node*>(allocator_->nodeAllocator_ ? ConcurrentAllocatorReserve(allocator_->nodeAllocator_) :
+            AllocatorReserve(allocator_));
         new(newNode) Node(value);
         return newNode;
     }
@@ -491,7 +501,10 @@ private:
     void FreeNode(Node* node)
     {
         (node)->~Node();
-        AllocatorFree(allocator_, node);
+        if (node != tail_ && allocator_->nodeAllocator_)
+            ConcurrentAllocatorFree(allocator_->nodeAllocator_, node);
+        else
+            AllocatorFree(allocator_, node);
     }
 };
 
@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Maximum number of 8-bit digits in a radix sort key.
+static const unsigned RADIXSORT_MAX_BYTES = 8;
+
+/// Key and value sorted by RadixSort().
+template <class T> struct RadixSortItem
+{
+    /// Sort key.
+    unsigned long long key_;
+    /// Value carried along with the key.
+    T value_;
+};
+
+/// Return an unsigned integer which sorts in the same order as the float.
+inline unsigned FloatToRadixKey(float value)
+{
+    unsigned bits;
+    memcpy(&bits, &value, sizeof bits);
+    // Negative values sort in reverse, so flip all their bits. Flip only the sign of positive values to put them after the negative
+    return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+/// Stable least significant digit first radix sort by the low numBytes bytes of the keys. Temp must have room for count items. Digits which are the same in all keys are skipped. The result is in items.
+template <class T> void RadixSort(RadixSortItem<T>* items, RadixSortItem<T>* temp, unsigned count, unsigned numBytes = RADIXSORT_MAX_BYTES)
+{
+    if (count < 2)
+        return;
+
+    // Count the digits of all passes in one go
+    unsigned counts[RADIXSORT_MAX_BYTES][256];
+    memset(counts, 0, numBytes * sizeof counts[0]);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        unsigned long long key = items[i].key_;
+        for (unsigned j = 0; j < numBytes; ++j, key >>= 8u)
+            ++counts[j][key & 0xffu];
+    }
+
+    RadixSortItem<T>* src = items;
+    RadixSortItem<T>* dest = temp;
+    for (unsigned j = 0; j < numBytes; ++j)
+    {
+        unsigned* digitCounts = counts[j];
+        const unsigned shift = j * 8;
+        if (digitCounts[(src[0].key_ >> shift) & 0xffu] == count)
+            continue;
+
+        // Turn the counts into start offsets, then scatter in order to keep the sort stable
+        unsigned offset = 0;
+        for (unsigned k = 0; k < 256; ++k)
+        {
+            const unsigned digitCount = digitCounts[k];
+            digitCounts[k] = offset;
+            offset += digitCount;
+        }
+        for (unsigned i = 0; i < count; ++i)
+            dest[digitCounts[(src[i].key_ >> shift) & 0xffu]++] = src[i];
+
+        RadixSortItem<T>* swap = src;
+        src = dest;
+        dest = swap;
+    }
+
+    if (src != items)
+        memcpy(items, src, count * sizeof(RadixSortItem<T>));
+}
+
+}
@@ -0,0 +1,312 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/ConcurrentAllocator.h"
+#include "../Math/MathDefs.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Number of allocators remembered per thread.
+static const unsigned NUM_THREAD_LOOKUPS = 8;
+
+/// Thread-local allocator to cache lookup entry.
+struct ConcurrentAllocatorLookup
+{
+    /// Allocator identifier.
+    unsigned long long allocatorId_;
+    /// Cache.
+    void* cache_;
+};
+
+/// Source of allocator identifiers.
+static std::atomic<unsigned long long> nextAllocatorId{1};
+/// Recently used allocators of this thread.
+static thread_local ConcurrentAllocatorLookup threadLookups[NUM_THREAD_LOOKUPS];
+/// Next lookup entry to replace.
+static thread_local unsigned nextThreadLookup = 0;
+/// Variable whose address identifies the thread.
+static thread_local char threadKey;
+/// Whether the thread exit hook has run.
+static thread_local bool threadExited = false;
+
+/// Return the mutex guarding the live allocators.
+static Mutex& GetAllocatorsMutex()
+{
+    static Mutex mutex;
+    return mutex;
+}
+
+/// Return the live allocators, so that exiting threads release their caches only to allocators which still exist.
+static PODVector<ConcurrentAllocatorBase*>& GetAllocators()
+{
+    static PODVector<ConcurrentAllocatorBase*> allocators;
+    return allocators;
+}
+
+/// Thread exit hook which returns the thread's magazines to the allocators it has used.
+struct ConcurrentAllocatorThreadExit
+{
+    /// Destruct on thread exit.
+    ~ConcurrentAllocatorThreadExit()
+    {
+        MutexLock lock(GetAllocatorsMutex());
+        const PODVector<ConcurrentAllocatorBase*>& allocators = GetAllocators();
+        for (unsigned i = 0; i < caches_.Size(); ++i)
+        {
+            // Allocator identifiers are never reused, so a destroyed allocator is not mistaken for a new one at the same address
+            for (unsigned j = 0; j < allocators.Size(); ++j)
+            {
+                if (allocators[j]->id_ == caches_[i].allocatorId_)
+                {
+                    allocators[j]->ReleaseThreadCache(static_cast<ConcurrentAllocatorBase::ThreadCache*>(caches_[i].cache_));
+                    break;
+                }
+            }
+        }
+
+        // Allocations from later thread-local destructors create a new cache instead of using a released one. It stays
+        // with the allocator until destruction
+        for (unsigned i = 0; i < NUM_THREAD_LOOKUPS; ++i)
+            threadLookups[i].allocatorId_ = 0;
+        threadExited = true;
+    }
+
+    /// Caches created by this thread.
+    PODVector<ConcurrentAllocatorLookup> caches_;
+};
+
+/// Thread exit hook, constructed when the thread creates its first cache.
+static thread_local ConcurrentAllocatorThreadExit threadExit;
+
+ConcurrentAllocatorBase::ConcurrentAllocatorBase(unsigned nodeSize) :
+    nodeSize_(Max(nodeSize, (unsigned)sizeof(void*))),
+    id_(nextAllocatorId.fetch_add(1, std::memory_order_relaxed)),
+    freeList_(nullptr),
+    capacity_(0),
+    outstandingNodes_(0),
+    peakNodes_(0),
+    retiredLiveNodes_(0)
+{
+    // Keep nodes aligned like the heap does
+    const unsigned alignment = alignof(std::max_align_t);
+    nodeSize_ = (nodeSize_ + alignment - 1) & ~(alignment - 1);
+
+    MutexLock lock(GetAllocatorsMutex());
+    GetAllocators().Push(this);
+}
+
+ConcurrentAllocatorBase::~ConcurrentAllocatorBase()
+{
+    {
+        MutexLock lock(GetAllocatorsMutex());
+        GetAllocators().Remove(this);
+    }
+
+    for (unsigned i = 0; i < threadCaches_.Size(); ++i)
+        delete threadCaches_[i];
+    for (unsigned i = 0; i < magazines_.Size(); ++i)
+        delete magazines_[i];
+    for (unsigned i = 0; i < blocks_.Size(); ++i)
+        delete[] blocks_[i];
+}
+
+ConcurrentAllocatorStats ConcurrentAllocatorBase::GetStats() const
+{
+    MutexLock lock(depotMutex_);
+
+    ConcurrentAllocatorStats stats{};
+    int liveNodes = retiredLiveNodes_;
+    for (unsigned i = 0; i < threadCaches_.Size(); ++i)
+        liveNodes += threadCaches_[i]->liveNodes_.load(std::memory_order_relaxed);
+    stats.liveNodes_ = (unsigned)Max(liveNodes, 0);
+    stats.peakNodes_ = peakNodes_;
+    stats.numBlocks_ = blocks_.Size();
+    stats.capacity_ = capacity_;
+    stats.numThreads_ = threadCaches_.Size();
+    return stats;
+}
+
+ConcurrentAllocatorBase::ThreadCache* ConcurrentAllocatorBase::LookupThreadCache() const
+{
+    for (unsigned i = 0; i < NUM_THREAD_LOOKUPS; ++i)
+    {
+        if (threadLookups[i].allocatorId_ == id_)
+            return static_cast<ThreadCache*>(threadLookups[i].cache_);
+    }
+    return nullptr;
+}
+
+ConcurrentAllocatorBase::ThreadCache* ConcurrentAllocatorBase::CreateThreadCache()
+{
+    ThreadCache* cache = nullptr;
+
+    {
+        MutexLock lock(depotMutex_);
+
+        // The thread may have used the allocator before and been evicted from the lookup. Caches of exited threads have
+        // been released, so a new thread with a reused thread-local address does not find them
+        for (unsigned i = 0; i < threadCaches_.Size(); ++i)
+        {
+            if (threadCaches_[i]->threadKey_ == &threadKey)
+            {
+                cache = threadCaches_[i];
+                break;
+            }
+        }
+
+        if (!cache)
+        {
+            cache = new ThreadCache();
+            cache->loaded_ = NewMagazine();
+            cache->previous_ = NewMagazine();
+            cache->liveNodes_.store(0, std::memory_order_relaxed);
+            cache->threadKey_ = &threadKey;
+            threadCaches_.Push(cache);
+            if (!threadExited)
+                threadExit.caches_.Push(ConcurrentAllocatorLookup{id_, cache});
+        }
+    }
+
+    ConcurrentAllocatorLookup& lookup = threadLookups[nextThreadLookup];
+    nextThreadLookup = (nextThreadLookup + 1) % NUM_THREAD_LOOKUPS;
+    lookup.allocatorId_ = id_;
+    lookup.cache_ = cache;
+    return cache;
+}
+
+void ConcurrentAllocatorBase::RefillMagazine(ThreadCache* cache)
+{
+    MutexLock lock(depotMutex_);
+
+    Magazine* loaded = cache->loaded_;
+    if (!fullMagazines_.Empty())
+    {
+        emptyMagazines_.Push(loaded);
+        cache->loaded_ = fullMagazines_.Back();
+        fullMagazines_.Pop();
+    }
+    else
+    {
+        // Fill from the free list, growing if necessary
+        while (loaded->count_ < MAGAZINE_SIZE)
+        {
+            if (!freeList_)
+                AllocateBlock();
+            loaded->nodes_[loaded->count_++] = freeList_;
+            freeList_ = *static_cast<void**>(freeList_);
+        }
+    }
+
+    outstandingNodes_ += MAGAZINE_SIZE;
+    peakNodes_ = Max(peakNodes_, outstandingNodes_);
+}
+
+void ConcurrentAllocatorBase::FlushMagazine(ThreadCache* cache)
+{
+    MutexLock lock(depotMutex_);
+
+    fullMagazines_.Push(cache->previous_);
+    outstandingNodes_ -= Min(outstandingNodes_, MAGAZINE_SIZE);
+
+    if (!emptyMagazines_.Empty())
+    {
+        cache->previous_ = emptyMagazines_.Back();
+        emptyMagazines_.Pop();
+    }
+    else
+        cache->previous_ = NewMagazine();
+
+    // The loaded magazine is full: continue with the empty one
+    std::swap(cache->loaded_, cache->previous_);
+}
+
+void ConcurrentAllocatorBase::ReleaseThreadCache(ThreadCache* cache)
+{
+    MutexLock lock(depotMutex_);
+
+    ReleaseMagazine(cache->loaded_);
+    ReleaseMagazine(cache->previous_);
+    retiredLiveNodes_ += cache->liveNodes_.load(std::memory_order_relaxed);
+    threadCaches_.Remove(cache);
+    delete cache;
+}
+
+void ConcurrentAllocatorBase::ReleaseMagazine(Magazine* magazine)
+{
+    outstandingNodes_ -= Min(outstandingNodes_, magazine->count_);
+
+    if (magazine->count_ == MAGAZINE_SIZE)
+    {
+        fullMagazines_.Push(magazine);
+        return;
+    }
+
+    // The depot holds only full and empty magazines, so partial ones go to the free list
+    while (magazine->count_)
+    {
+        void* node = magazine->nodes_[--magazine->count_];
+        *static_cast<void**>(node) = freeList_;
+        freeList_ = node;
+    }
+    emptyMagazines_.Push(magazine);
+}
+
+ConcurrentAllocatorBase::Magazine* ConcurrentAllocatorBase::NewMagazine()
+{
+    auto* magazine = new Magazine();
+    magazine->count_ = 0;
+    magazines_.Push(magazine);
+    return magazine;
+}
+
+void ConcurrentAllocatorBase::AllocateBlock()
+{
+    // Grow by half of the current capacity, like Allocator
+    const unsigned numNodes = Max((capacity_ + 1) >> 1u, MAGAZINE_SIZE * 2);
+    auto* block = new unsigned char[(size_t)numNodes * nodeSize_];
+    blocks_.Push(block);
+    capacity_ += numNodes;
+
+    for (unsigned i = numNodes; i-- > 0;)
+    {
+        void* node = block + (size_t)i * nodeSize_;
+        *static_cast<void**>(node) = freeList_;
+        freeList_ = node;
+    }
+}
+
+void* ConcurrentAllocatorReserve(ConcurrentAllocatorBase* allocator)
+{
+    return allocator->ReserveNode();
+}
+
+void ConcurrentAllocatorFree(ConcurrentAllocatorBase* allocator, void* ptr)
+{
+    allocator->FreeNode(ptr);
+}
+
+}
@@ -0,0 +1,219 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Core/Mutex.h"
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace Urho3D
+{
+
+/// Concurrent allocator statistics.
+struct ConcurrentAllocatorStats
+{
+    /// Nodes currently reserved.
+    unsigned liveNodes_;
+    /// Highest number of nodes handed out to threads, including the nodes cached in their magazines. Tracked when magazines are exchanged with the depot.
+    unsigned peakNodes_;
+    /// Number of memory blocks.
+    unsigned numBlocks_;
+    /// Total number of nodes in all blocks.
+    unsigned capacity_;
+    /// Number of running threads which have used the allocator. Threads return their magazines to the depot on exit.
+    unsigned numThreads_;
+};
+
+/// Thread-safe fixed-size node allocator. Each thread reserves and frees through two private magazines of nodes without locking or atomic read-modify-write operations; only exchanging a whole magazine with the shared depot takes a lock. Nodes may be freed by a different thread than the one which reserved them. Memory is returned to the system only on destruction.
+class URHO3D_API ConcurrentAllocatorBase
+{
+public:
+    /// Number of nodes in a magazine.
+    static constexpr unsigned MAGAZINE_SIZE = 64;
+
+    /// Construct with node size.
+    explicit ConcurrentAllocatorBase(unsigned nodeSize);
+    /// Destruct. All threads must have stopped using the allocator.
+    ~ConcurrentAllocatorBase();
+    /// Prevent copy construction.
+    ConcurrentAllocatorBase(const ConcurrentAllocatorBase& rhs) = delete;
+    /// Prevent assignment.
+    ConcurrentAllocatorBase& operator =(const ConcurrentAllocatorBase& rhs) = delete;
+
+    /// Reserve a node.
+    void* ReserveNode()
+    {
+        ThreadCache* cache = GetThreadCache();
+        Magazine* loaded = cache->loaded_;
+        if (!loaded->count_)
+        {
+            if (cache->previous_->count_)
+                std::swap(cache->loaded_, cache->previous_);
+            else
+                RefillMagazine(cache);
+            loaded = cache->loaded_;
+        }
+        cache->liveNodes_.store(cache->liveNodes_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return loaded->nodes_[--loaded->count_];
+    }
+
+    /// Free a node.
+    void FreeNode(void* ptr)
+    {
+        if (!ptr)
+            return;
+
+        ThreadCache* cache = GetThreadCache();
+        Magazine* loaded = cache->loaded_;
+        if (loaded->count_ == MAGAZINE_SIZE)
+        {
+            if (cache->previous_->count_ < MAGAZINE_SIZE)
+                std::swap(cache->loaded_, cache->previous_);
+            else
+                FlushMagazine(cache);
+            loaded = cache->loaded_;
+        }
+        cache->liveNodes_.store(cache->liveNodes_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        loaded->nodes_[loaded->count_++] = ptr;
+    }
+
+    /// Return statistics. Safe to call from any thread; per-thread counts may be slightly behind.
+    ConcurrentAllocatorStats GetStats() const;
+    /// Return node size.
+    unsigned GetNodeSize() const { return nodeSize_; }
+
+private:
+    /// Fixed-capacity stack of free nodes.
+    struct Magazine
+    {
+        /// Number of nodes.
+        unsigned count_;
+        /// Nodes.
+        void* nodes_[MAGAZINE_SIZE];
+    };
+
+    /// Per-thread magazines.
+    struct ThreadCache
+    {
+        /// Magazine to reserve from and free to.
+        Magazine* loaded_;
+        /// Second magazine, which avoids going to the depot when reserve and free alternate at a magazine boundary.
+        Magazine* previous_;
+        /// Reserved minus freed nodes by this thread. Written only by the owning thread.
+        std::atomic<int> liveNodes_;
+        /// Owning thread identifier.
+        const void* threadKey_;
+    };
+
+    /// Return the calling thread's cache, creating it on first use.
+    ThreadCache* GetThreadCache()
+    {
+        ThreadCache* cache = LookupThreadCache();
+        return cache ? cache : CreateThreadCache();
+    }
+
+    /// Return a cache's magazines to the depot and remove it. Called when its thread exits.
+    void ReleaseThreadCache(ThreadCache* cache);
+    /// Return a magazine's nodes to the depot. Called with the mutex held.
+    void ReleaseMagazine(Magazine* magazine);
+    /// Return the calling thread's cache from the thread-local lookup, or null if not found.
+    ThreadCache* LookupThreadCache() const;
+    /// Create or find the calling thread's cache and remember it in the thread-local lookup.
+    ThreadCache* CreateThreadCache();
+    /// Swap the empty loaded magazine for a full one from the depot, or fill it from the blocks.
+    void RefillMagazine(ThreadCache* cache);
+    /// Swap the full previous magazine for an empty one from the depot, and make it loaded.
+    void FlushMagazine(ThreadCache* cache);
+    /// Allocate an empty magazine. Called with the mutex held.
+    Magazine* NewMagazine();
+    /// Allocate a new block and chain its nodes to the free list. Called with the mutex held.
+    void AllocateBlock();
+
+    /// Node size, at least a pointer.
+    unsigned nodeSize_;
+    /// Unique identifier for thread-local lookups, never reused.
+    unsigned long long id_;
+    /// Mutex for the depot, blocks and thread caches.
+    mutable Mutex depotMutex_;
+    /// Full magazines.
+    PODVector<Magazine*> fullMagazines_;
+    /// Empty magazines.
+    PODVector<Magazine*> emptyMagazines_;
+    /// All magazines, for destruction.
+    PODVector<Magazine*> magazines_;
+    /// Memory blocks.
+    PODVector<unsigned char*> blocks_;
+    /// Free nodes not in any magazine, linked through their first bytes.
+    void* freeList_;
+    /// Total node capacity.
+    unsigned capacity_;
+    /// Nodes handed out to thread caches.
+    unsigned outstandingNodes_;
+    /// Peak of outstanding nodes.
+    unsigned peakNodes_;
+    /// Reserved minus freed nodes by threads which have exited.
+    int retiredLiveNodes_;
+    /// Thread caches.
+    PODVector<ThreadCache*> threadCaches_;
+
+    friend struct ConcurrentAllocatorThreadExit;
+};
+
+/// Thread-safe allocator template class. Allocates objects of a specific class from any thread.
+template <class T> class ConcurrentAllocator : public ConcurrentAllocatorBase
+{
+public:
+    /// Construct.
+    ConcurrentAllocator() :
+        ConcurrentAllocatorBase((unsigned)sizeof(T))
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned types are not supported");
+    }
+
+    /// Reserve and default-construct an object.
+    T* Reserve()
+    {
+        return new(ReserveNode()) T();
+    }
+
+    /// Reserve and copy-construct an object.
+    T* Reserve(const T& object)
+    {
+        return new(ReserveNode()) T(object);
+    }
+
+    /// Destruct and free an object.
+    void Free(T* object)
+    {
+        if (!object)
+            return;
+        object->~T();
+        FreeNode(object);
+    }
+};
+
+}
@@ -403,6 +403,17 @@ AttributeInfo* Context::GetAttribute(StringHash objectType, const char* name)
     return nullptr;
 }
 
+TypedEventChannel* Context::GetOrCreateTypedEventChannel(unsigned index, StringHash eventType)
+{
+    if (typedEventChannels_.Size() <= index)
+        typedEventChannels_.Resize(index + 1);
+
+    UniquePtr<TypedEventChannel>& channel = typedEventChannels_[index];
+    if (!channel)
+        channel.Reset(new TypedEventChannel(eventType));
+    return channel.Get();
+}
+
 void Context::AddEventReceiver(Object* receiver, StringHash eventType)
 {
     SharedPtr<EventReceiverGroup>& group = eventReceivers_[eventType];
@@ -421,10 +432,10 @@ void Context::AddEventReceiver(Object* receiver, Object* sender, StringHash even
 
 void Context::RemoveEventSender(Object* sender)
 {
-    HashMap<Object*, HashMap<StringHash, SharedPtr<EventReceiverGroup> > >::Iterator i = specificEventReceivers_.Find(sender);
+    FlatHashMap<Object*, FlatHashMap<StringHash, SharedPtr<EventReceiverGroup> > >::Iterator i = specificEventReceivers_.Find(sender);
     if (i != specificEventReceivers_.End())
     {
-        for (HashMap<StringHash, SharedPtr<EventReceiverGroup> >::Iterator j = i->second_.Begin(); j != i->second_.End(); ++j)
+        for (FlatHashMap<StringHash, SharedPtr<EventReceiverGroup> >::Iterator j = i->second_.Begin(); j != i->second_.End(); ++j)
         {
             for (PODVector<Object*>::Iterator k = j->second_->receivers_.Begin(); k != j->second_->receivers_.End(); ++k)
             {
@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/CoreEvents.h"
+#include "../Core/FrameAllocator.h"
+#include "../Core/WorkQueue.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+FrameAllocator::FrameAllocator(Context* context) :
+    Object(context)
+{
+    auto* queue = GetSubsystem<WorkQueue>();
+    SetNumArenas(queue ? queue->GetNumThreads() + 1 : 1);
+
+    SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(FrameAllocator, HandleBeginFrame));
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(FrameAllocator, HandleEndFrame));
+}
+
+FrameAllocator::~FrameAllocator() = default;
+
+void FrameAllocator::SetNumArenas(unsigned numArenas)
+{
+    numArenas = Max(numArenas, 1U);
+    if (numArenas == arenas_.Size())
+        return;
+
+    const unsigned oldSize = arenas_.Size();
+    arenas_.Resize(numArenas);
+    for (unsigned i = oldSize; i < numArenas; ++i)
+        arenas_[i] = new FrameArena();
+}
+
+void FrameAllocator::Reset()
+{
+    for (unsigned i = 0; i < arenas_.Size(); ++i)
+        arenas_[i]->Reset();
+}
+
+unsigned FrameAllocator::GetUsedBytes() const
+{
+    unsigned bytes = 0;
+    for (unsigned i = 0; i < arenas_.Size(); ++i)
+        bytes += arenas_[i]->GetUsedBytes();
+    return bytes;
+}
+
+unsigned FrameAllocator::GetCapacity() const
+{
+    unsigned bytes = 0;
+    for (unsigned i = 0; i < arenas_.Size(); ++i)
+        bytes += arenas_[i]->GetCapacity();
+    return bytes;
+}
+
+void FrameAllocator::HandleBeginFrame(StringHash /*eventType*/, VariantMap& /*eventData*/)
+{
+    // Worker threads are created after the subsystems, so follow the work queue
+    auto* queue = GetSubsystem<WorkQueue>();
+    if (queue)
+        SetNumArenas(queue->GetNumThreads() + 1);
+}
+
+void FrameAllocator::HandleEndFrame(StringHash /*eventType*/, VariantMap& /*eventData*/)
+{
+    Reset();
+}
+
+}
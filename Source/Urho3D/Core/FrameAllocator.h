@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/FrameArena.h"
+#include "../Core/Object.h"
+
+namespace Urho3D
+{
+
+/// Per-frame transient memory subsystem. Holds one FrameArena per work queue thread, all reset at the end of the frame.
+class URHO3D_API FrameAllocator : public Object
+{
+    URHO3D_OBJECT(FrameAllocator, Object);
+
+public:
+    /// Construct.
+    explicit FrameAllocator(Context* context);
+    /// Destruct.
+    ~FrameAllocator() override;
+
+    /// Set number of arenas. Adjusted automatically at frame begin to match the work queue threads. Main thread only, while no work uses the arenas.
+    void SetNumArenas(unsigned numArenas);
+    /// Reset all arenas. Called automatically at frame end.
+    void Reset();
+
+    /// Return the arena of a work queue thread index. Index 0 is the main thread. An arena may only be used from its own thread.
+    FrameArena* GetArena(unsigned threadIndex = 0) const
+    {
+        assert(threadIndex < arenas_.Size());
+        return arenas_[threadIndex].Get();
+    }
+
+    /// Return number of arenas.
+    unsigned GetNumArenas() const { return arenas_.Size(); }
+    /// Return bytes allocated this frame in all arenas.
+    unsigned GetUsedBytes() const;
+    /// Return total size of all arenas.
+    unsigned GetCapacity() const;
+
+private:
+    /// Handle frame begin event.
+    void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
+    /// Handle frame end event.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+
+    /// Arenas per thread.
+    Vector<UniquePtr<FrameArena> > arenas_;
+};
+
+}
@@ -85,6 +85,13 @@ Object::~Object()
 {
     UnsubscribeFromAllEvents();
     context_->RemoveEventSender(this);
+
+    for (unsigned i = 0; i < typedEventChannels_.Size(); ++i)
+    {
+        TypedEventChannel* channel = context_->GetTypedEventChannel(typedEventChannels_[i]);
+        if (channel)
+            channel->RemoveObject(this);
+    }
 }
 
 void Object::OnEvent(Object* sender, StringHash eventType, VariantMap& eventData)
@@ -264,6 +271,13 @@ void Object::UnsubscribeFromAllEvents()
         else
             break;
     }
+
+    for (unsigned i = 0; i < typedEventChannels_.Size(); ++i)
+    {
+        TypedEventChannel* channel = context_->GetTypedEventChannel(typedEventChannels_[i]);
+        if (channel)
+            channel->Unsubscribe(this);
+    }
 }
 
 void Object::UnsubscribeFromAllEventsExcept(const PODVector<StringHash>& exceptions, bool onlyUserData)
@@ -289,6 +303,17 @@ void Object::UnsubscribeFromAllEventsExcept(const PODVector<StringHash>& excepti
 
         handler = next;
     }
+
+    // Typed handlers carry no user data
+    if (onlyUserData)
+        return;
+
+    for (unsigned i = 0; i < typedEventChannels_.Size(); ++i)
+    {
+        TypedEventChannel* channel = context_->GetTypedEventChannel(typedEventChannels_[i]);
+        if (channel && !exceptions.Contains(channel->GetEventType()))
+            channel->Unsubscribe(this);
+    }
 }
 
 void Object::SendEvent(StringHash eventType)
@@ -406,6 +431,99 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
     context->EndSendEvent();
 }
 
+void Object::SendTypedEvent(unsigned index, StringHash eventType, void* event, void (*invoke)(TypedEventFunction, Object*, void*),
+    void (*fillEventData)(const void*, VariantMap&))
+{
+    if (!Thread::IsMainThread())
+    {
+        URHO3D_LOGERROR("Sending events is only supported from the main thread");
+        return;
+    }
+
+    if (blockEvents_)
+        return;
+
+    Context* context = context_;
+    TypedEventChannel* channel = context->GetTypedEventChannel(index);
+    if (channel && !channel->Empty())
+    {
+        // Check first the subscribers of this sender, then the subscribers of any sender, like SendEvent() does
+        // Note: groups are held alive with shared ptrs, as they may get removed along with the sender
+        SharedPtr<TypedEventSubscriberGroup> group(channel->GetSubscribers(this));
+        SharedPtr<TypedEventSubscriberGroup> anyGroup(channel->GetSubscribers(nullptr));
+        if (group || anyGroup)
+        {
+#ifdef URHO3D_PROFILING
+            URHO3D_PROFILE_COLOR(SendTypedEvent, URHO3D_PROFILE_EVENT_COLOR);
+
+            const String& eventName = GetEventNameRegister().GetString(eventType);
+            URHO3D_PROFILE_STR(eventName.CString(), eventName.Length());
+#endif
+
+            context->BeginSendEvent(this, eventType);
+            if (group && !SendTypedEventToGroup(group, nullptr, event, invoke))
+            {
+                context->EndSendEvent();
+                return;
+            }
+            if (anyGroup && !SendTypedEventToGroup(anyGroup, group, event, invoke))
+            {
+                context->EndSendEvent();
+                return;
+            }
+            context->EndSendEvent();
+        }
+    }
+
+    // Bridge to VariantMap subscribers
+    SendEventFromPayload(eventType, event, fillEventData);
+}
+
+void Object::SendEventFromPayload(StringHash eventType, const void* event, void (*fillEventData)(const void*, VariantMap&))
+{
+    // The parameters are marshalled only if someone listens
+    Context* context = context_;
+    EventReceiverGroup* group = context->GetEventReceivers(this, eventType);
+    if (!group || group->receivers_.Empty())
+        group = context->GetEventReceivers(eventType);
+    if (group && !group->receivers_.Empty())
+    {
+        VariantMap& eventData = GetEventDataMap();
+        fillEventData(event, eventData);
+        SendEvent(eventType, eventData);
+    }
+}
+
+bool Object::SendTypedEventToGroup(TypedEventSubscriberGroup* group, TypedEventSubscriberGroup* skipGroup, void* event,
+    void (*invoke)(TypedEventFunction, Object*, void*))
+{
+    // Make a weak pointer to self to check for destruction during event handling
+    WeakPtr<Object> self(this);
+    group->BeginSend();
+
+    // Subscribers added during send receive the next event only. Copy each subscriber, as the array may be reallocated by the handler
+    const unsigned numSubscribers = group->subscribers_.Size();
+    for (unsigned i = 0; i < numSubscribers; ++i)
+    {
+        const TypedEventSubscriber subscriber = group->subscribers_[i];
+        // Holes may exist if subscribers were removed. Do not send doubly to the subscribers of this sender
+        if (!subscriber.receiver_ || subscriber.receiver_->blockEvents_ || (skipGroup && skipGroup->Contains(subscriber.receiver_)))
+            continue;
+
+        invoke(subscriber.function_, subscriber.receiver_, event);
+
+        // If self has been destroyed as a result of event handling, exit
+        if (self.Expired())
+        {
+            group->EndSend();
+            return false;
+        }
+    }
+
+    group->EndSend();
+    return true;
+}
+
 VariantMap& Object::GetEventDataMap() const
 {
     return context_->GetEventDataMap();
@@ -520,6 +638,43 @@ EventHandler* Object::FindSpecificEventHandler(Object* sender, StringHash eventT
     return nullptr;
 }
 
+void Object::SubscribeToTypedEvent(unsigned index, StringHash eventType, Object* sender, TypedEventFunction function)
+{
+    if (!function)
+        return;
+
+    TypedEventChannel* channel = context_->GetOrCreateTypedEventChannel(index, eventType);
+    channel->Subscribe(this, sender, function);
+
+    AddTypedEventChannel(index);
+    if (sender)
+        sender->AddTypedEventChannel(index);
+}
+
+void Object::UnsubscribeFromTypedEvent(unsigned index, Object* sender)
+{
+    TypedEventChannel* channel = context_->GetTypedEventChannel(index);
+    if (!channel || !typedEventChannels_.Contains(index))
+        return;
+
+    if (sender)
+        channel->Unsubscribe(this, sender);
+    else
+        channel->Unsubscribe(this);
+}
+
+bool Object::HasSubscribedToTypedEvent(unsigned index, Object* sender) const
+{
+    TypedEventChannel* channel = context_->GetTypedEventChannel(index);
+    return channel && typedEventChannels_.Contains(index) && channel->HasSubscribed(const_cast<Object*>(this), sender);
+}
+
+void Object::AddTypedEventChannel(unsigned index)
+{
+    if (!typedEventChannels_.Contains(index))
+        typedEventChannels_.Push(index);
+}
+
 void Object::RemoveEventSender(Object* sender)
 {
     EventHandler* handler = eventHandlers_.First();
@@ -24,6 +24,7 @@
 
 #include "../Container/LinkedList.h"
 #include "../Core/StringHashRegister.h"
+#include "../Core/TypedEvent.h"
 #include "../Core/Variant.h"
 #include <functional>
 #include <utility>
@@ -144,6 +145,39 @@ public:
         SendEvent(eventType, GetEventDataMap().Populate(args...));
     }
 
+    /// Subscribe to a typed event that can be sent by any sender. Typed events dispatch to contiguous subscriber arrays kept per sender, without VariantMap marshalling. A receiver has at most one handler per typed event and sender; subscribing again replaces it.
+    template <class T> void SubscribeToTypedEvent(void (*handler)(Object*, T&))
+    {
+        SubscribeToTypedEvent(GetTypedEventIndex<T>(), T::GetEventTypeStatic(), nullptr, reinterpret_cast<TypedEventFunction>(handler));
+    }
+    /// Subscribe to a specific sender's typed event.
+    template <class T> void SubscribeToTypedEvent(Object* sender, void (*handler)(Object*, T&))
+    {
+        if (sender)
+            SubscribeToTypedEvent(GetTypedEventIndex<T>(), T::GetEventTypeStatic(), sender, reinterpret_cast<TypedEventFunction>(handler));
+    }
+    /// Unsubscribe from a typed event regardless of sender.
+    template <class T> void UnsubscribeFromTypedEvent() { UnsubscribeFromTypedEvent(GetTypedEventIndex<T>(), nullptr); }
+    /// Unsubscribe from a specific sender's typed event.
+    template <class T> void UnsubscribeFromTypedEvent(Object* sender) { if (sender) UnsubscribeFromTypedEvent(GetTypedEventIndex<T>(), sender); }
+    /// Send a typed event. Typed subscribers of this sender receive it first, then typed subscribers of any sender, like in SendEvent(). VariantMap subscribers of the same event type receive it last, so typed subscribers always run before them regardless of subscription order. The VariantMap parameters are filled only if there are VariantMap subscribers.
+    template <class T> void SendTypedEvent(T& event)
+    {
+        SendTypedEvent(GetTypedEventIndex<T>(), T::GetEventTypeStatic(), &event, &InvokeTypedEventHandler<T>, &FillTypedEventData<T>);
+    }
+    /// Send a VariantMap event with the parameters of a typed payload. The parameters are filled only if the event has subscribers, so events without a typed path of their own skip the marshalling too.
+    template <class T> void SendEventFromPayload(StringHash eventType, const T& event)
+    {
+        SendEventFromPayload(eventType, &event, &FillTypedEventData<T>);
+    }
+    /// Return whether has subscribed to a typed event from any sender.
+    template <class T> bool HasSubscribedToTypedEvent() const { return HasSubscribedToTypedEvent(GetTypedEventIndex<T>(), nullptr); }
+    /// Return whether has subscribed to a specific sender's typed event.
+    template <class T> bool HasSubscribedToTypedEvent(Object* sender) const
+    {
+        return sender && HasSubscribedToTypedEvent(GetTypedEventIndex<T>(), sender);
+    }
+
     /// Return execution context.
     Context* GetContext() const { return context_; }
     /// Return global variable based on key.
@@ -193,9 +227,27 @@ private:
     EventHandler* FindSpecificEventHandler(Object* sender, StringHash eventType, EventHandler** previous = nullptr) const;
     /// Remove event handlers related to a specific sender.
     void RemoveEventSender(Object* sender);
+    /// Subscribe to a typed event by index.
+    void SubscribeToTypedEvent(unsigned index, StringHash eventType, Object* sender, TypedEventFunction function);
+    /// Unsubscribe from a typed event by index. Null sender matches any.
+    void UnsubscribeFromTypedEvent(unsigned index, Object* sender);
+    /// Send a type-erased typed event.
+    void SendTypedEvent(unsigned index, StringHash eventType, void* event, void (*invoke)(TypedEventFunction, Object*, void*),
+        void (*fillEventData)(const void*, VariantMap&));
+    /// Send a VariantMap event with the parameters of a type-erased typed payload if the event has subscribers.
+    void SendEventFromPayload(StringHash eventType, const void* event, void (*fillEventData)(const void*, VariantMap&));
+    /// Send a type-erased typed event to a subscriber group, skipping the receivers in the skip group. Return false if this object was destroyed by a handler.
+    bool SendTypedEventToGroup(TypedEventSubscriberGroup* group, TypedEventSubscriberGroup* skipGroup, void* event,
+        void (*invoke)(TypedEventFunction, Object*, void*));
+    /// Return whether has subscribed to a typed event by index. Null sender matches any.
+    bool HasSubscribedToTypedEvent(unsigned index, Object* sender) const;
+    /// Remember a typed event channel the object takes part in as a receiver or sender.
+    void AddTypedEventChannel(unsigned index);
 
     /// Event handlers. Sender is null for non-specific handlers.
     LinkedList<EventHandler> eventHandlers_;
+    /// Typed event channels the object takes part in as a receiver or sender. Empty for most objects.
+    PODVector<unsigned> typedEventChannels_;
 
     /// Block object from sending and receiving any events.
     bool blockEvents_;
@@ -23,6 +23,8 @@
 #include "../Precompiled.h"
 
 #include "../Core/Profiler.h"
+#include "../IO/File.h"
+#include "../IO/Log.h"
 
 #include <cstdio>
 
@@ -31,17 +33,92 @@
 namespace Urho3D
 {
 
+static const unsigned MAIN_THREAD_RECORDS = 65536;
+static const unsigned WORKER_THREAD_RECORDS = 16384;
+
+static std::atomic<unsigned> nextProfilerID{1};
+
+/// Write a timeline event in Chrome trace event format.
+static void WriteTraceEvent(Serializer& dest, const ProfilerTimelineEvent& event)
+{
+    // Block names are identifiers or resource type names, but keep the output valid JSON regardless
+    char name[128];
+    unsigned length = 0;
+    for (const char* c = event.name_; *c && length < sizeof(name) - 2; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+            name[length++] = '\\';
+        name[length++] = *c;
+    }
+    name[length] = 0;
+
+    char line[256];
+    int size = snprintf(line, sizeof(line), "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%lld,\"dur\":%lld}",
+        name, event.threadIndex_, event.begin_, event.end_ - event.begin_);
+    dest.Write(line, (unsigned)Clamp(size, 0, (int)sizeof(line) - 1));
+}
+
+/// Write a thread name in Chrome trace event format.
+static void WriteTraceThreadName(Serializer& dest, unsigned threadIndex)
+{
+    char line[128];
+    int size;
+    if (!threadIndex)
+        size = snprintf(line, sizeof(line), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"Main thread\"}}");
+    else
+    {
+        size = snprintf(line, sizeof(line), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"Worker thread %u\"}}",
+            threadIndex, threadIndex);
+    }
+    dest.Write(line, (unsigned)Clamp(size, 0, (int)sizeof(line) - 1));
+}
+
+ProfilerThreadBuffer::ProfilerThreadBuffer(ThreadID threadID, unsigned threadIndex, unsigned capacity) :
+    capacity_(NextPowerOfTwo(capacity)),
+    threadID_(threadID),
+    threadIndex_(threadIndex)
+{
+    records_.Resize(capacity_);
+}
+
+void ProfilerThreadBuffer::Read(PODVector<ProfilerTimelineEvent>& timeline)
+{
+    const unsigned head = head_.load(std::memory_order_acquire);
+    unsigned tail = tail_.load(std::memory_order_relaxed);
+
+    for (; tail != head; ++tail)
+    {
+        const ProfilerRecord& record = records_[tail & (capacity_ - 1)];
+        if (record.name_)
+            openBlocks_.Push(record);
+        else if (!openBlocks_.Empty())
+        {
+            const ProfilerRecord& begin = openBlocks_.Back();
+            timeline.Push({begin.name_, begin.time_, record.time_, threadIndex_, openBlocks_.Size() - 1});
+            openBlocks_.Pop();
+        }
+    }
+
+    tail_.store(tail, std::memory_order_release);
+}
+
 Profiler::Profiler(Context* context) :
     Object(context),
     current_(nullptr),
     root_(nullptr),
-    intervalFrames_(0)
+    intervalFrames_(0),
+    id_(nextProfilerID.fetch_add(1, std::memory_order_relaxed))
 {
     current_ = root_ = new ProfilerBlock(nullptr, "RunFrame");
+
+    mainThreadBuffer_ = new ProfilerThreadBuffer(Thread::GetCurrentThreadID(), 0, MAIN_THREAD_RECORDS);
+    threadBuffers_.Push(UniquePtr<ProfilerThreadBuffer>(mainThreadBuffer_));
 }
 
 Profiler::~Profiler()
 {
+    StopTrace();
+
     delete root_;
     root_ = nullptr;
 }
@@ -53,6 +130,7 @@ void Profiler::BeginFrame()
         EndFrame();
 
     root_->Begin();
+    mainThreadBuffer_->Begin(root_->name_, clock_.GetUSec(false));
 }
 
 void Profiler::EndFrame()
@@ -61,6 +139,8 @@ void Profiler::EndFrame()
     ++intervalFrames_;
     root_->EndFrame();
     current_ = root_;
+
+    UpdateTimeline();
 }
 
 void Profiler::BeginInterval()
@@ -69,6 +149,120 @@ void Profiler::BeginInterval()
     intervalFrames_ = 0;
 }
 
+bool Profiler::StartTrace(const String& fileName)
+{
+    StopTrace();
+
+    SharedPtr<File> file(new File(context_));
+    if (!file->Open(fileName, FILE_WRITE))
+        return false;
+
+    // Use the JSON array format, which trace viewers accept without the closing bracket
+    file->Write("[\n", 2);
+    traceFile_ = file;
+    numTracedThreads_ = 0;
+    numTracedEvents_ = 0;
+    URHO3D_LOGINFO("Streaming profiler trace to " + fileName);
+    return true;
+}
+
+void Profiler::StopTrace()
+{
+    if (!traceFile_)
+        return;
+
+    traceFile_->Write("\n]\n", 3);
+    traceFile_->Close();
+    traceFile_.Reset();
+}
+
+void Profiler::SaveTrace(Serializer& dest) const
+{
+    const unsigned numThreads = GetNumThreads();
+
+    dest.Write("{\"traceEvents\":[\n", 17);
+    for (unsigned i = 0; i < numThreads; ++i)
+    {
+        if (i)
+            dest.Write(",\n", 2);
+        WriteTraceThreadName(dest, i);
+    }
+    for (unsigned i = 0; i < timeline_.Size(); ++i)
+    {
+        dest.Write(",\n", 2);
+        WriteTraceEvent(dest, timeline_[i]);
+    }
+    dest.Write("\n]}\n", 4);
+}
+
+unsigned Profiler::GetNumThreads() const
+{
+    MutexLock lock(threadBuffersMutex_);
+    return threadBuffers_.Size();
+}
+
+ProfilerThreadBuffer* Profiler::GetThreadBuffer()
+{
+    // Cache the buffer per thread. The profiler ID guards against the cache pointing to another profiler's buffer
+    static thread_local unsigned cachedID = 0;
+    static thread_local ProfilerThreadBuffer* cachedBuffer = nullptr;
+    if (cachedID == id_)
+        return cachedBuffer;
+
+    MutexLock lock(threadBuffersMutex_);
+
+    ThreadID threadID = Thread::GetCurrentThreadID();
+    ProfilerThreadBuffer* buffer = nullptr;
+    for (Vector<UniquePtr<ProfilerThreadBuffer> >::Iterator i = threadBuffers_.Begin(); i != threadBuffers_.End(); ++i)
+    {
+        if ((*i)->GetThreadID() == threadID)
+        {
+            buffer = i->Get();
+            break;
+        }
+    }
+
+    if (!buffer)
+    {
+        buffer = new ProfilerThreadBuffer(threadID, threadBuffers_.Size(), WORKER_THREAD_RECORDS);
+        threadBuffers_.Push(UniquePtr<ProfilerThreadBuffer>(buffer));
+    }
+
+    cachedID = id_;
+    cachedBuffer = buffer;
+    return buffer;
+}
+
+void Profiler::UpdateTimeline()
+{
+    timeline_.Clear();
+
+    unsigned numThreads;
+    {
+        MutexLock lock(threadBuffersMutex_);
+        numThreads = threadBuffers_.Size();
+        for (Vector<UniquePtr<ProfilerThreadBuffer> >::Iterator i = threadBuffers_.Begin(); i != threadBuffers_.End(); ++i)
+            (*i)->Read(timeline_);
+    }
+
+    if (!traceFile_)
+        return;
+
+    // Name the threads which have appeared since the last frame, then append this frame's blocks
+    for (; numTracedThreads_ < numThreads; ++numTracedThreads_)
+    {
+        if (numTracedEvents_++)
+            traceFile_->Write(",\n", 2);
+        WriteTraceThreadName(*traceFile_, numTracedThreads_);
+    }
+    for (unsigned i = 0; i < timeline_.Size(); ++i)
+    {
+        if (numTracedEvents_++)
+            traceFile_->Write(",\n", 2);
+        WriteTraceEvent(*traceFile_, timeline_[i]);
+    }
+}
+
 const String& Profiler::PrintData(bool showUnused, bool showTotal, unsigned maxDepth) const
 {
     static String output;
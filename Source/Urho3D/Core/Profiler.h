@@ -22,10 +22,14 @@
 
 #pragma once
 
+#include "../Container/Ptr.h"
 #include "../Container/Str.h"
+#include "../Core/Mutex.h"
 #include "../Core/Thread.h"
 #include "../Core/Timer.h"
 
+#include <atomic>
+
 #ifdef URHO3D_TRACY_PROFILING
 #define TRACY_ENABLE 1
 #include "Tracy/Tracy.hpp"
@@ -34,6 +38,9 @@
 namespace Urho3D
 {
 
+class File;
+class Serializer;
+
 /// Profiling data for one block in the profiling tree.
 /// @nobind
 class URHO3D_API ProfilerBlock
@@ -174,6 +181,107 @@ public:
     unsigned totalCount_;
 };
 
+/// Begin or end record of a profiling block in a thread's record buffer.
+/// @nobind
+struct ProfilerRecord
+{
+    /// Block name, or null when ending the innermost open block.
+    const char* name_;
+    /// Microseconds since the profiler was created.
+    long long time_;
+};
+
+/// Finished profiling block on a thread's timeline.
+/// @nobind
+struct ProfilerTimelineEvent
+{
+    /// Block name.
+    const char* name_;
+    /// Begin time in microseconds since the profiler was created.
+    long long begin_;
+    /// End time in microseconds since the profiler was created.
+    long long end_;
+    /// Index of the recording thread. The main thread is 0.
+    unsigned threadIndex_;
+    /// Nesting depth on the thread.
+    unsigned depth_;
+};
+
+/// Lock-free ring buffer of one thread's profiling records. Written only by the owning thread and read only by the main thread at frame end.
+/// @nobind
+class URHO3D_API ProfilerThreadBuffer
+{
+public:
+    /// Construct for a thread.
+    ProfilerThreadBuffer(ThreadID threadID, unsigned threadIndex, unsigned capacity);
+
+    /// Record beginning a block. The name must stay valid until the block has been read at frame end. Owner thread only.
+    void Begin(const char* name, long long time)
+    {
+        // Keep room for the end records of all open blocks, so that a begin is never left without its end
+        const unsigned head = head_.load(std::memory_order_relaxed);
+        if (skipDepth_ || head - tail_.load(std::memory_order_acquire) + openDepth_ + 2 > capacity_)
+        {
+            ++skipDepth_;
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        records_[head & (capacity_ - 1)] = {name, time};
+        head_.store(head + 1, std::memory_order_release);
+        ++openDepth_;
+    }
+
+    /// Record ending the innermost block. Owner thread only.
+    void End(long long time)
+    {
+        if (skipDepth_)
+        {
+            --skipDepth_;
+            return;
+        }
+        if (!openDepth_)
+            return;
+
+        const unsigned head = head_.load(std::memory_order_relaxed);
+        records_[head & (capacity_ - 1)] = {nullptr, time};
+        head_.store(head + 1, std::memory_order_release);
+        --openDepth_;
+    }
+
+    /// Move the finished blocks recorded so far to a timeline. Blocks still open are kept for the next read. Main thread only.
+    void Read(PODVector<ProfilerTimelineEvent>& timeline);
+
+    /// Return owning thread ID.
+    ThreadID GetThreadID() const { return threadID_; }
+    /// Return thread index.
+    unsigned GetThreadIndex() const { return threadIndex_; }
+    /// Return number of blocks dropped because the buffer was full.
+    unsigned GetNumDropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    /// Records. Capacity is a power of two.
+    PODVector<ProfilerRecord> records_;
+    /// Capacity.
+    unsigned capacity_;
+    /// Write position. Advanced by the owning thread.
+    alignas(64) std::atomic<unsigned> head_{};
+    /// Read position. Advanced by the main thread.
+    alignas(64) std::atomic<unsigned> tail_{};
+    /// Number of blocks dropped.
+    std::atomic<unsigned> dropped_{};
+    /// Number of open blocks which have been recorded. Owner thread only.
+    unsigned openDepth_{};
+    /// Number of open blocks which were dropped. Owner thread only.
+    unsigned skipDepth_{};
+    /// Begin records waiting for their end. Main thread only.
+    PODVector<ProfilerRecord> openBlocks_;
+    /// Owning thread ID.
+    ThreadID threadID_;
+    /// Thread index.
+    unsigned threadIndex_;
+};
+
 /// Hierarchical performance profiler subsystem.
 class URHO3D_API Profiler : public Object
 {
@@ -185,23 +293,30 @@ public:
     /// Destruct.
     ~Profiler() override;
 
-    /// Begin timing a profiling block.
+    /// Begin timing a profiling block. In worker threads the block is only recorded to the timeline, and the name must be a string literal or otherwise outlive the frame.
     void BeginBlock(const char* name)
     {
-        // Profiler supports only the main thread currently
         if (!Thread::IsMainThread())
+        {
+            GetThreadBuffer()->Begin(name, clock_.GetUSec(false));
             return;
+        }
 
         current_ = current_->GetChild(name);
         current_->Begin();
+        mainThreadBuffer_->Begin(current_->name_, clock_.GetUSec(false));
     }
 
     /// End timing the current profiling block.
     void EndBlock()
     {
         if (!Thread::IsMainThread())
+        {
+            GetThreadBuffer()->End(clock_.GetUSec(false));
             return;
+        }
 
+        mainThreadBuffer_->End(clock_.GetUSec(false));
         current_->End();
         if (current_->parent_)
             current_ = current_->parent_;
@@ -214,16 +329,33 @@ public:
     /// Begin a new interval.
     void BeginInterval();
 
+    /// Start streaming the per-thread timelines to a file in Chrome trace event format, one frame at a time. The file stays loadable even if the application exits without stopping the trace. Return true if the file was opened.
+    bool StartTrace(const String& fileName);
+    /// Stop streaming and close the trace file.
+    void StopTrace();
+    /// Write the last frame's timelines as a Chrome trace event document.
+    void SaveTrace(Serializer& dest) const;
+
     /// Return profiling data as text output. This method is not thread-safe.
     const String& PrintData(bool showUnused = false, bool showTotal = false, unsigned maxDepth = M_MAX_UNSIGNED) const;
     /// Return the current profiling block.
     const ProfilerBlock* GetCurrentBlock() { return current_; }
     /// Return the root profiling block.
     const ProfilerBlock* GetRootBlock() { return root_; }
+    /// Return blocks finished during the last frame in all threads, ordered by thread.
+    const PODVector<ProfilerTimelineEvent>& GetTimeline() const { return timeline_; }
+    /// Return number of threads which have recorded blocks.
+    unsigned GetNumThreads() const;
+    /// Return whether streaming a trace to a file.
+    bool IsTracing() const { return traceFile_ != nullptr; }
 
 protected:
     /// Return profiling data as text output for a specified profiling block.
     void PrintData(ProfilerBlock* block, String& output, unsigned depth, unsigned maxDepth, bool showUnused, bool showTotal) const;
+    /// Return the calling worker thread's record buffer, creating it on first use.
+    ProfilerThreadBuffer* GetThreadBuffer();
+    /// Read the record buffers of all threads into the timeline, and stream it if tracing.
+    void UpdateTimeline();
 
     /// Current profiling block.
     ProfilerBlock* current_;
@@ -231,6 +363,24 @@ protected:
     ProfilerBlock* root_;
     /// Frames in the current interval.
     unsigned intervalFrames_;
+    /// Clock for timeline records.
+    HiresTimer clock_;
+    /// Unique profiler instance ID for looking up worker thread buffers.
+    unsigned id_;
+    /// Record buffers of all threads which have profiled.
+    Vector<UniquePtr<ProfilerThreadBuffer> > threadBuffers_;
+    /// Main thread record buffer.
+    ProfilerThreadBuffer* mainThreadBuffer_;
+    /// Mutex for creating thread buffers.
+    mutable Mutex threadBuffersMutex_;
+    /// Blocks finished during the last frame.
+    PODVector<ProfilerTimelineEvent> timeline_;
+    /// Trace file being streamed to.
+    SharedPtr<File> traceFile_;
+    /// Number of threads named in the trace file.
+    unsigned numTracedThreads_{};
+    /// Number of events written to the trace file.
+    unsigned numTracedEvents_{};
 };
 
 /// Helper class for automatically beginning and ending a profiling block.
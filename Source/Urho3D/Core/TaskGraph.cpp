@@ -0,0 +1,137 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/TaskGraph.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+TaskGraph::TaskGraph(WorkQueue* queue) :
+    queue_(queue)
+{
+}
+
+TaskGraph::~TaskGraph()
+{
+    if (running_)
+        Wait();
+}
+
+unsigned TaskGraph::AddTask(void (* function)(const WorkItem*, unsigned), void* start, void* end, void* aux)
+{
+    assert(!running_);
+
+    if (numTasks_ == nodes_.Size())
+        nodes_.Push(SharedPtr<TaskGraphNode>(new TaskGraphNode()));
+
+    TaskGraphNode* node = nodes_[numTasks_];
+    node->workFunction_ = RunNode;
+    node->taskFunction_ = function;
+    node->start_ = start;
+    node->end_ = end;
+    node->aux_ = aux;
+    node->priority_ = M_MAX_UNSIGNED;
+    node->completesItself_ = true;
+    node->graph_ = this;
+    node->dependents_.Clear();
+    node->numDependencies_ = 0;
+
+    return numTasks_++;
+}
+
+void TaskGraph::AddDependency(unsigned task, unsigned dependency)
+{
+    assert(!running_);
+    assert(task < numTasks_ && dependency < numTasks_ && task != dependency);
+
+    nodes_[dependency]->dependents_.Push(task);
+    ++nodes_[task]->numDependencies_;
+}
+
+void TaskGraph::Clear()
+{
+    assert(!running_);
+
+    numTasks_ = 0;
+}
+
+void TaskGraph::Start()
+{
+    assert(!running_);
+
+    if (!numTasks_)
+        return;
+
+    running_ = true;
+    remaining_.store(numTasks_, std::memory_order_relaxed);
+    for (unsigned i = 0; i < numTasks_; ++i)
+    {
+        TaskGraphNode* node = nodes_[i];
+        node->completed_ = false;
+        node->pendingDependencies_.store(node->numDependencies_, std::memory_order_relaxed);
+    }
+
+    for (unsigned i = 0; i < numTasks_; ++i)
+    {
+        if (!nodes_[i]->numDependencies_ && !queue_->DistributeItem(nodes_[i]))
+            queue_->PushItem(nodes_[i], 0);
+    }
+
+    queue_->Resume();
+}
+
+void TaskGraph::Wait()
+{
+    if (!running_)
+        return;
+
+    queue_->WaitForCounter(remaining_);
+    running_ = false;
+
+    queue_->PauseIfIdle();
+}
+
+void TaskGraph::RunNode(const WorkItem* item, unsigned threadIndex)
+{
+    auto* node = static_cast<TaskGraphNode*>(const_cast<WorkItem*>(item));
+    TaskGraph* graph = node->graph_;
+
+    node->taskFunction_(node, threadIndex);
+
+    // Dependents which became ready go to this thread's own deque, from where idle threads can steal them
+    for (unsigned i = 0; i < node->dependents_.Size(); ++i)
+    {
+        TaskGraphNode* dependent = graph->nodes_[node->dependents_[i]];
+        if (dependent->pendingDependencies_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            graph->queue_->PushItem(dependent, threadIndex);
+    }
+
+    // Wait() may return and the graph be destroyed as soon as the counter drops, so flag completion first
+    node->completed_.store(true, std::memory_order_relaxed);
+    graph->remaining_.fetch_sub(1, std::memory_order_release);
+}
+
+}
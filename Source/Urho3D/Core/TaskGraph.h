@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../Container/Vector.h"
+#include "../Core/WorkQueue.h"
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+class TaskGraph;
+
+/// %Task graph node: a work item with dependency edges.
+/// @nobind
+struct TaskGraphNode : public WorkItem
+{
+    /// Task function, called with the node and thread index.
+    void (* taskFunction_)(const WorkItem*, unsigned){};
+    /// Owning graph.
+    TaskGraph* graph_{};
+    /// Indices of nodes which depend on this node.
+    PODVector<unsigned> dependents_;
+    /// Number of dependencies.
+    unsigned numDependencies_{};
+    /// Number of dependencies which have not finished yet during a run.
+    std::atomic<unsigned> pendingDependencies_{};
+};
+
+/// Graph of work functions executed through the WorkQueue. A task becomes runnable as soon as all its dependencies have finished, so independent chains of work overlap instead of waiting on a barrier after each phase. Tasks use the WorkItem function signature and start, end and aux pointers. Nodes are reused after Clear() to avoid allocation.
+class URHO3D_API TaskGraph
+{
+public:
+    /// Construct.
+    explicit TaskGraph(WorkQueue* queue);
+    /// Destruct. Wait for a running graph to finish.
+    ~TaskGraph();
+
+    /// Prevent copy construction.
+    TaskGraph(const TaskGraph& rhs) = delete;
+    /// Prevent assignment.
+    TaskGraph& operator =(const TaskGraph& rhs) = delete;
+
+    /// Add a task and return its index.
+    unsigned AddTask(void (* function)(const WorkItem*, unsigned), void* start = nullptr, void* end = nullptr, void* aux = nullptr);
+    /// Make a task run only after another task has finished.
+    void AddDependency(unsigned task, unsigned dependency);
+    /// Remove all tasks. Can not be called while running.
+    void Clear();
+
+    /// Queue the tasks without dependencies and resume worker threads. Can only be called from the main thread.
+    void Start();
+    /// Execute tasks in the main thread until the whole graph has finished.
+    void Wait();
+    /// Start and wait for the graph.
+    void Run()
+    {
+        Start();
+        Wait();
+    }
+
+    /// Return number of tasks.
+    unsigned GetNumTasks() const { return numTasks_; }
+    /// Return whether the graph has been started and not yet waited for.
+    bool IsRunning() const { return running_; }
+
+private:
+    /// Work function of every node: run the task, then queue the dependents which became ready.
+    static void RunNode(const WorkItem* item, unsigned threadIndex);
+
+    /// Work queue.
+    WorkQueue* queue_;
+    /// Nodes. May be more than the number of tasks, as nodes are kept for reuse.
+    Vector<SharedPtr<TaskGraphNode> > nodes_;
+    /// Number of tasks.
+    unsigned numTasks_{};
+    /// Number of tasks which have not finished yet during a run.
+    std::atomic<unsigned> remaining_{};
+    /// Running flag.
+    bool running_{};
+};
+
+}
@@ -0,0 +1,212 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/HashMap.h"
+#include "../Core/Mutex.h"
+#include "../Core/Object.h"
+#include "../Core/TypedEvent.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+void TypedEventSubscriberGroup::EndSend()
+{
+    assert(inSend_ > 0);
+    --inSend_;
+
+    if (inSend_ == 0 && numHoles_ * 2 > subscribers_.Size())
+        Compact();
+}
+
+void TypedEventSubscriberGroup::Add(Object* receiver, TypedEventFunction function)
+{
+    HashMap<Object*, unsigned>::Iterator i = indices_.Find(receiver);
+    if (i != indices_.End())
+    {
+        subscribers_[i->second_].function_ = function;
+        return;
+    }
+
+    indices_[receiver] = subscribers_.Size();
+    subscribers_.Push(TypedEventSubscriber{receiver, function});
+}
+
+bool TypedEventSubscriberGroup::Contains(Object* receiver) const
+{
+    return indices_.Contains(receiver);
+}
+
+bool TypedEventSubscriberGroup::Remove(Object* receiver)
+{
+    HashMap<Object*, unsigned>::Iterator i = indices_.Find(receiver);
+    if (i == indices_.End())
+        return false;
+
+    subscribers_[i->second_].receiver_ = nullptr;
+    indices_.Erase(i);
+    ++numHoles_;
+
+    if (inSend_ == 0 && numHoles_ * 2 > subscribers_.Size())
+        Compact();
+    return true;
+}
+
+void TypedEventSubscriberGroup::Compact()
+{
+    unsigned dest = 0;
+    for (unsigned i = 0; i < subscribers_.Size(); ++i)
+    {
+        const TypedEventSubscriber& subscriber = subscribers_[i];
+        if (!subscriber.receiver_)
+            continue;
+
+        if (dest != i)
+        {
+            subscribers_[dest] = subscriber;
+            indices_[subscriber.receiver_] = dest;
+        }
+        ++dest;
+    }
+
+    subscribers_.Resize(dest);
+    numHoles_ = 0;
+}
+
+TypedEventChannel::TypedEventChannel(StringHash eventType) :
+    eventType_(eventType)
+{
+}
+
+void TypedEventChannel::Subscribe(Object* receiver, Object* sender, TypedEventFunction function)
+{
+    SharedPtr<TypedEventSubscriberGroup>& group = groups_[sender];
+    if (!group)
+        group = new TypedEventSubscriberGroup();
+
+    if (!group->Contains(receiver))
+        receiverSenders_[receiver].Push(sender);
+    group->Add(receiver, function);
+}
+
+void TypedEventChannel::Unsubscribe(Object* receiver, Object* sender)
+{
+    if (!receiver || !sender)
+        return;
+
+    HashMap<Object*, PODVector<Object*> >::Iterator i = receiverSenders_.Find(receiver);
+    if (i == receiverSenders_.End() || !i->second_.Remove(sender))
+        return;
+
+    if (i->second_.Empty())
+        receiverSenders_.Erase(i);
+    RemoveFromGroup(receiver, sender);
+}
+
+void TypedEventChannel::Unsubscribe(Object* receiver)
+{
+    HashMap<Object*, PODVector<Object*> >::Iterator i = receiverSenders_.Find(receiver);
+    if (i == receiverSenders_.End())
+        return;
+
+    // Detach the sender list first, as removing a group does not touch it
+    PODVector<Object*> senders;
+    senders.Swap(i->second_);
+    receiverSenders_.Erase(i);
+    for (PODVector<Object*>::ConstIterator j = senders.Begin(); j != senders.End(); ++j)
+        RemoveFromGroup(receiver, *j);
+}
+
+void TypedEventChannel::RemoveObject(Object* object)
+{
+    Unsubscribe(object);
+
+    // Drop the subscribers of the object as a sender. A send in progress keeps the group alive
+    HashMap<Object*, SharedPtr<TypedEventSubscriberGroup> >::Iterator i = object ? groups_.Find(object) : groups_.End();
+    if (i == groups_.End())
+        return;
+
+    const PODVector<TypedEventSubscriber>& subscribers = i->second_->subscribers_;
+    for (PODVector<TypedEventSubscriber>::ConstIterator j = subscribers.Begin(); j != subscribers.End(); ++j)
+    {
+        if (!j->receiver_)
+            continue;
+
+        HashMap<Object*, PODVector<Object*> >::Iterator k = receiverSenders_.Find(j->receiver_);
+        if (k != receiverSenders_.End())
+        {
+            k->second_.Remove(object);
+            if (k->second_.Empty())
+                receiverSenders_.Erase(k);
+        }
+    }
+
+    groups_.Erase(i);
+}
+
+bool TypedEventChannel::HasSubscribed(Object* receiver, Object* sender) const
+{
+    if (!sender)
+        return receiverSenders_.Contains(receiver);
+
+    TypedEventSubscriberGroup* group = GetSubscribers(sender);
+    return group && group->Contains(receiver);
+}
+
+TypedEventSubscriberGroup* TypedEventChannel::GetSubscribers(Object* sender) const
+{
+    HashMap<Object*, SharedPtr<TypedEventSubscriberGroup> >::ConstIterator i = groups_.Find(sender);
+    return i != groups_.End() ? i->second_.Get() : nullptr;
+}
+
+void TypedEventChannel::RemoveFromGroup(Object* receiver, Object* sender)
+{
+    HashMap<Object*, SharedPtr<TypedEventSubscriberGroup> >::Iterator i = groups_.Find(sender);
+    if (i == groups_.End())
+        return;
+
+    // A group being sent to stays in place, so that subscribers added during the send are not lost
+    TypedEventSubscriberGroup* group = i->second_;
+    group->Remove(receiver);
+    if (group->Empty() && !group->IsSending())
+        groups_.Erase(i);
+}
+
+unsigned GetTypedEventIndex(StringHash eventType)
+{
+    static Mutex indexMutex;
+    static HashMap<StringHash, unsigned> indices;
+
+    MutexLock lock(indexMutex);
+    HashMap<StringHash, unsigned>::ConstIterator i = indices.Find(eventType);
+    if (i != indices.End())
+        return i->second_;
+
+    const unsigned index = indices.Size();
+    indices[eventType] = index;
+    return index;
+}
+
+}
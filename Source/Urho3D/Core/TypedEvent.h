@@ -0,0 +1,150 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Core/Variant.h"
+
+namespace Urho3D
+{
+
+class Object;
+
+/// Type-erased typed event handler function. Cast back to void (*)(Object*, T&) before calling.
+using TypedEventFunction = void (*)();
+
+/// Typed event subscriber.
+struct TypedEventSubscriber
+{
+    /// Receiver. Null for a hole left by removal.
+    Object* receiver_;
+    /// Handler function.
+    TypedEventFunction function_;
+};
+
+/// Typed event subscribers of one sender, or of any sender.
+class URHO3D_API TypedEventSubscriberGroup : public RefCounted
+{
+public:
+    /// Construct.
+    TypedEventSubscriberGroup() :
+        inSend_(0),
+        numHoles_(0)
+    {
+    }
+
+    /// Begin event send. Holes are not compacted during send.
+    void BeginSend() { ++inSend_; }
+    /// End event send. Compact holes if necessary.
+    void EndSend();
+    /// Add the receiver's subscription, or replace its handler if already subscribed.
+    void Add(Object* receiver, TypedEventFunction function);
+    /// Remove the receiver's subscription in constant time by leaving a hole. Holes are compacted once they make up half of the subscribers, keeping the subscription order. Return whether it was subscribed.
+    bool Remove(Object* receiver);
+
+    /// Return whether the receiver has subscribed.
+    bool Contains(Object* receiver) const;
+    /// Return whether there are no subscribers.
+    bool Empty() const { return indices_.Empty(); }
+    /// Return number of subscribers.
+    unsigned GetNumSubscribers() const { return indices_.Size(); }
+    /// Return whether an event is being sent to the subscribers.
+    bool IsSending() const { return inSend_ > 0; }
+
+    /// Subscribers in subscription order. May contain holes.
+    PODVector<TypedEventSubscriber> subscribers_;
+
+private:
+    /// Remove holes and update the indices of the moved subscribers.
+    void Compact();
+
+    /// Subscriber index of each receiver.
+    HashMap<Object*, unsigned> indices_;
+    /// "In send" recursion counter.
+    unsigned inSend_;
+    /// Number of holes.
+    unsigned numHoles_;
+};
+
+/// Subscribers of one typed event, bucketed by sender. Owned by the Context and indexed by GetTypedEventIndex().
+class URHO3D_API TypedEventChannel
+{
+public:
+    /// Construct with event type.
+    explicit TypedEventChannel(StringHash eventType);
+
+    /// Add the receiver's subscription to a sender, or to any sender if null. A receiver has at most one handler per sender; subscribing again replaces it.
+    void Subscribe(Object* receiver, Object* sender, TypedEventFunction function);
+    /// Remove the receiver's subscription to a specific sender.
+    void Unsubscribe(Object* receiver, Object* sender);
+    /// Remove all the receiver's subscriptions regardless of sender.
+    void Unsubscribe(Object* receiver);
+    /// Remove all subscriptions where the object is the receiver or the sender. Called on its destruction.
+    void RemoveObject(Object* object);
+    /// Return whether the receiver has subscribed to a specific sender, or to any sender if null.
+    bool HasSubscribed(Object* receiver, Object* sender) const;
+
+    /// Return event type.
+    StringHash GetEventType() const { return eventType_; }
+    /// Return the subscribers of a specific sender, or of any sender if null. Null if there are none.
+    TypedEventSubscriberGroup* GetSubscribers(Object* sender) const;
+    /// Return whether there are no subscriptions.
+    bool Empty() const { return receiverSenders_.Empty(); }
+
+private:
+    /// Remove the receiver from a sender's subscribers, and the subscribers if they become empty.
+    void RemoveFromGroup(Object* receiver, Object* sender);
+
+    /// Subscriber groups by sender. Null key for the subscribers of any sender.
+    HashMap<Object*, SharedPtr<TypedEventSubscriberGroup> > groups_;
+    /// Senders each receiver has subscribed to, null for any sender.
+    HashMap<Object*, PODVector<Object*> > receiverSenders_;
+    /// Event type.
+    StringHash eventType_;
+};
+
+/// Return the process-wide typed event index of an event type, allocating it on first use.
+URHO3D_API unsigned GetTypedEventIndex(StringHash eventType);
+
+/// Return the typed event index of a payload type. The payload defines static StringHash GetEventTypeStatic() and void ToVariantMap(VariantMap&) const.
+template <class T> unsigned GetTypedEventIndex()
+{
+    static const unsigned index = GetTypedEventIndex(T::GetEventTypeStatic());
+    return index;
+}
+
+/// Invoke a type-erased typed event handler.
+template <class T> void InvokeTypedEventHandler(TypedEventFunction function, Object* receiver, void* event)
+{
+    reinterpret_cast<void (*)(Object*, T&)>(function)(receiver, *static_cast<T*>(event));
+}
+
+/// Fill VariantMap parameters from a typed event payload for VariantMap handlers.
+template <class T> void FillTypedEventData(const void* event, VariantMap& eventData)
+{
+    static_cast<const T*>(event)->ToVariantMap(eventData);
+}
+
+/// Convenience macro to construct a typed event handler that calls a receiver class member function taking the payload by reference.
+#define URHO3D_TYPED_HANDLER(className, function) ([](Urho3D::Object* receiver, auto& event) { static_cast<className*>(receiver)->function(event); })
+
+}
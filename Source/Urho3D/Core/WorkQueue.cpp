@@ -31,6 +31,55 @@
 namespace Urho3D
 {
 
+/// Execute a work item and flag it completed, unless the work function does that itself.
+static inline void ExecuteItem(WorkItem* item, unsigned threadIndex)
+{
+    const bool completesItself = item->completesItself_;
+    item->workFunction_(item, threadIndex);
+    if (!completesItself)
+        item->completed_.store(true, std::memory_order_release);
+}
+
+/// Shared state of one ParallelFor call.
+struct ParallelForTask
+{
+    /// Chunk function.
+    void (* function_)(void*, unsigned, unsigned, unsigned);
+    /// User data passed to the chunk function.
+    void* data_;
+    /// Range size.
+    unsigned count_;
+    /// Chunk size.
+    unsigned grainSize_;
+    /// Start of the next unclaimed chunk.
+    std::atomic<unsigned> next_;
+    /// Number of helper work items which have not finished yet.
+    std::atomic<unsigned> numActive_;
+};
+
+/// Claim and execute chunks of a ParallelFor range until none remain.
+static void RunParallelForChunks(ParallelForTask* task, unsigned threadIndex)
+{
+    for (;;)
+    {
+        const unsigned begin = task->next_.fetch_add(task->grainSize_, std::memory_order_relaxed);
+        if (begin >= task->count_)
+            break;
+
+        task->function_(task->data_, begin, Min(begin + task->grainSize_, task->count_), threadIndex);
+    }
+}
+
+/// Work function of a ParallelFor helper item.
+static void ParallelForWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* task = reinterpret_cast<ParallelForTask*>(item->aux_);
+    RunParallelForChunks(task, threadIndex);
+    // The task lives on the caller's stack: nothing may be touched after the counter drops
+    const_cast<WorkItem*>(item)->completed_.store(true, std::memory_order_relaxed);
+    task->numActive_.fetch_sub(1, std::memory_order_release);
+}
+
 /// Worker thread managed by the work queue.
 class WorkerThread : public Thread, public RefCounted
 {
@@ -75,6 +124,9 @@ WorkQueue::WorkQueue(Context* context) :
     lastSize_(0),
     maxNonThreadedWorkMs_(5)
 {
+    // The main thread always owns the first deque
+    deques_.Push(UniquePtr<WorkStealingQueue<WorkItem*> >(new WorkStealingQueue<WorkItem*>()));
+
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(WorkQueue, HandleBeginFrame));
 }
 
@@ -99,6 +151,13 @@ void WorkQueue::CreateThreads(unsigned numThreads)
     // Start threads in paused mode
     Pause();
 
+    // Create all deques and inboxes before any thread starts, as the threads steal from each other
+    for (unsigned i = 0; i < numThreads; ++i)
+    {
+        deques_.Push(UniquePtr<WorkStealingQueue<WorkItem*> >(new WorkStealingQueue<WorkItem*>()));
+        inboxes_.Push(UniquePtr<WorkStealingQueue<WorkItem*> >(new WorkStealingQueue<WorkItem*>()));
+    }
+
     for (unsigned i = 0; i < numThreads; ++i)
     {
         SharedPtr<WorkerThread> thread(new WorkerThread(this, i + 1));
@@ -114,8 +173,8 @@ SharedPtr<WorkItem> WorkQueue::GetFreeItem()
 {
     if (poolItems_.Size() > 0)
     {
-        SharedPtr<WorkItem> item = poolItems_.Front();
-        poolItems_.PopFront();
+        SharedPtr<WorkItem> item = poolItems_.Back();
+        poolItems_.Pop();
         return item;
     }
     else
@@ -143,6 +202,13 @@ void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item)
     workItems_.Push(item);
     item->completed_ = false;
 
+    // Maximum priority items are spread over the worker threads without locking
+    if (item->priority_ == M_MAX_UNSIGNED && DistributeItem(item.Get()))
+    {
+        Resume();
+        return;
+    }
+
     // Make sure worker threads' list is safe to modify
     if (threads_.Size() && !paused_)
         queueMutex_.Acquire();
@@ -186,7 +252,7 @@ bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
     List<WorkItem*>::Iterator i = queue_.Find(item.Get());
     if (i != queue_.End())
     {
-        List<SharedPtr<WorkItem> >::Iterator j = workItems_.Find(item);
+        Vector<SharedPtr<WorkItem> >::Iterator j = workItems_.Find(item);
         if (j != workItems_.End())
         {
             queue_.Erase(i);
@@ -209,7 +275,7 @@ unsigned WorkQueue::RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items)
         List<WorkItem*>::Iterator j = queue_.Find(i->Get());
         if (j != queue_.End())
         {
-            List<SharedPtr<WorkItem> >::Iterator k = workItems_.Find(*i);
+            Vector<SharedPtr<WorkItem> >::Iterator k = workItems_.Find(*i);
             if (k != workItems_.End())
             {
                 queue_.Erase(j);
@@ -245,6 +311,24 @@ void WorkQueue::Resume()
     }
 }
 
+void WorkQueue::PauseIfIdle()
+{
+    if (threads_.Empty() || !queue_.Empty() || overflow_.load(std::memory_order_relaxed))
+        return;
+
+    for (unsigned i = 0; i < deques_.Size(); ++i)
+    {
+        if (!deques_[i]->Empty())
+            return;
+    }
+    for (unsigned i = 0; i < inboxes_.Size(); ++i)
+    {
+        if (!inboxes_[i]->Empty())
+            return;
+    }
+
+    Pause();
+}
 
 void WorkQueue::Complete(unsigned priority)
 {
@@ -254,55 +338,88 @@ void WorkQueue::Complete(unsigned priority)
     {
         Resume();
 
-        // Take work items also in the main thread until queue empty or no high-priority items anymore
-        while (!queue_.Empty())
-        {
-            queueMutex_.Acquire();
-            if (!queue_.Empty() && queue_.Front()->priority_ >= priority)
-            {
-                WorkItem* item = queue_.Front();
-                queue_.PopFront();
-                queueMutex_.Release();
-                item->workFunction_(item, 0);
-                item->completed_ = true;
-            }
-            else
-            {
-                queueMutex_.Release();
-                break;
-            }
-        }
+        // Take work items also in the main thread until no high-priority items anymore
+        WorkItem* item;
+        while (TakeItem(priority, item))
+            ExecuteItem(item, 0);
 
-        // Wait for threaded work to complete
+        // Wait for threaded work to complete. Keep stealing meanwhile, as the worker threads may still be feeding their deques
         while (!IsCompleted(priority))
         {
+            if (StealItem(0, item))
+                ExecuteItem(item, 0);
         }
 
         // If no work at all remaining, pause worker threads by leaving the mutex locked
-        if (queue_.Empty())
-            Pause();
+        PauseIfIdle();
     }
     else
     {
         // No worker threads: ensure all high-priority items are completed in the main thread
-        while (!queue_.Empty() && queue_.Front()->priority_ >= priority)
-        {
-            WorkItem* item = queue_.Front();
-            queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
-        }
+        WorkItem* item;
+        while (TakeItem(priority, item))
+            ExecuteItem(item, 0);
     }
 
     PurgeCompleted(priority);
     completing_ = false;
 }
 
+void WorkQueue::ParallelFor(unsigned count, unsigned grainSize, void (*function)(void*, unsigned, unsigned, unsigned), void* data)
+{
+    if (!count)
+        return;
+
+    // By default make a few chunks per thread, so that stealing can balance uneven chunk costs
+    const unsigned numThreads = threads_.Size() + 1;
+    if (!grainSize)
+        grainSize = Max(count / (numThreads * 4), 1U);
+
+    const unsigned numChunks = (count + grainSize - 1) / grainSize;
+    const unsigned numHelpers = Min(numChunks - 1, threads_.Size());
+    if (!numHelpers)
+    {
+        function(data, 0, count, 0);
+        return;
+    }
+
+    ParallelForTask task;
+    task.function_ = function;
+    task.data_ = data;
+    task.count_ = count;
+    task.grainSize_ = grainSize;
+    task.next_.store(0, std::memory_order_relaxed);
+    task.numActive_.store(numHelpers, std::memory_order_relaxed);
+
+    while (parallelForItems_.Size() < numHelpers)
+        parallelForItems_.Push(SharedPtr<WorkItem>(new WorkItem()));
+
+    for (unsigned i = 0; i < numHelpers; ++i)
+    {
+        WorkItem* item = parallelForItems_[i];
+        item->workFunction_ = ParallelForWork;
+        item->aux_ = &task;
+        item->priority_ = M_MAX_UNSIGNED;
+        item->completed_ = false;
+        item->completesItself_ = true;
+        if (!DistributeItem(item))
+            PushItem(item, 0);
+    }
+    Resume();
+
+    RunParallelForChunks(&task, 0);
+
+    // Helpers that were not picked up yet finish immediately, but must not outlive the task
+    WaitForCounter(task.numActive_);
+
+    PauseIfIdle();
+}
+
 bool WorkQueue::IsCompleted(unsigned priority) const
 {
-    for (List<SharedPtr<WorkItem> >::ConstIterator i = workItems_.Begin(); i != workItems_.End(); ++i)
+    for (Vector<SharedPtr<WorkItem> >::ConstIterator i = workItems_.Begin(); i != workItems_.End(); ++i)
     {
-        if ((*i)->priority_ >= priority && !(*i)->completed_)
+        if ((*i)->priority_ >= priority && !(*i)->completed_.load(std::memory_order_acquire))
             return false;
     }
 
@@ -318,6 +435,15 @@ void WorkQueue::ProcessItems(unsigned threadIndex)
         if (shutDown_)
             return;
 
+        // Lock-free path first: own deque, then steal from the others
+        WorkItem* item;
+        if (StealItem(threadIndex, item))
+        {
+            wasActive = true;
+            ExecuteItem(item, threadIndex);
+            continue;
+        }
+
         if (pausing_ && !wasActive)
             Time::Sleep(0);
         else
@@ -327,11 +453,10 @@ void WorkQueue::ProcessItems(unsigned threadIndex)
             {
                 wasActive = true;
 
-                WorkItem* item = queue_.Front();
+                item = queue_.Front();
                 queue_.PopFront();
                 queueMutex_.Release();
-                item->workFunction_(item, threadIndex);
-                item->completed_ = true;
+                ExecuteItem(item, threadIndex);
             }
             else
             {
@@ -344,30 +469,153 @@ void WorkQueue::ProcessItems(unsigned threadIndex)
     }
 }
 
+bool WorkQueue::StealItem(unsigned threadIndex, WorkItem*& item)
+{
+    if (deques_[threadIndex]->Pop(item))
+        return true;
+
+    // Then the items submitted to this worker thread
+    if (threadIndex && inboxes_[threadIndex - 1]->Steal(item))
+        return true;
+
+    // Start from the next thread so that thieves spread over the victims
+    const unsigned numDeques = deques_.Size();
+    for (unsigned i = 1; i < numDeques; ++i)
+    {
+        const unsigned victimIndex = (threadIndex + i) % numDeques;
+        WorkStealingQueue<WorkItem*>* victim = deques_[victimIndex].Get();
+        if (!victim->Empty() && victim->Steal(item))
+            return true;
+        if (victimIndex)
+        {
+            victim = inboxes_[victimIndex - 1].Get();
+            if (!victim->Empty() && victim->Steal(item))
+                return true;
+        }
+    }
+
+    return TakeOverflow(threadIndex, item);
+}
+
+bool WorkQueue::TakeItem(unsigned priority, WorkItem*& item)
+{
+    if (StealItem(0, item))
+        return true;
+
+    if (threads_.Empty())
+    {
+        if (queue_.Empty() || queue_.Front()->priority_ < priority)
+            return false;
+
+        item = queue_.Front();
+        queue_.PopFront();
+        return true;
+    }
+
+    MutexLock lock(queueMutex_);
+    if (queue_.Empty() || queue_.Front()->priority_ < priority)
+        return false;
+
+    item = queue_.Front();
+    queue_.PopFront();
+    return true;
+}
+
+void WorkQueue::PushItem(WorkItem* item, unsigned threadIndex)
+{
+    if (deques_[threadIndex]->Push(item))
+        return;
+
+    // Deque full: overflow to the lock-free stack. Locking the queue mutex here would deadlock with a main thread which
+    // has paused the queue while a started task graph is still feeding the deques
+    WorkItem* head = overflow_.load(std::memory_order_relaxed);
+    do
+        item->nextOverflow_ = head;
+    while (!overflow_.compare_exchange_weak(head, item, std::memory_order_release, std::memory_order_relaxed));
+}
+
+bool WorkQueue::TakeOverflow(unsigned threadIndex, WorkItem*& item)
+{
+    if (!overflow_.load(std::memory_order_relaxed))
+        return false;
+
+    // Take the whole stack at once, which avoids the ABA problem of popping single items
+    WorkItem* first = overflow_.exchange(nullptr, std::memory_order_acquire);
+    if (!first)
+        return false;
+
+    // Requeue the rest into the own deque, from where the other threads can steal them
+    WorkItem* next = first->nextOverflow_;
+    while (next)
+    {
+        WorkItem* current = next;
+        next = current->nextOverflow_;
+        PushItem(current, threadIndex);
+    }
+
+    item = first;
+    return true;
+}
+
+bool WorkQueue::DistributeItem(WorkItem* item)
+{
+    const unsigned numInboxes = inboxes_.Size();
+    if (!numInboxes)
+        return deques_[0]->Push(item);
+
+    for (unsigned i = 0; i < numInboxes; ++i)
+    {
+        WorkStealingQueue<WorkItem*>* inbox = inboxes_[nextInbox_].Get();
+        nextInbox_ = (nextInbox_ + 1) % numInboxes;
+        if (inbox->Push(item))
+            return true;
+    }
+
+    return false;
+}
+
+void WorkQueue::WaitForCounter(const std::atomic<unsigned>& counter)
+{
+    WorkItem* item;
+    while (counter.load(std::memory_order_acquire))
+    {
+        if (TakeItem(M_MAX_UNSIGNED, item))
+            ExecuteItem(item, 0);
+    }
+}
+
 void WorkQueue::PurgeCompleted(unsigned priority)
 {
     // Purge completed work items and send completion events. Do not signal items lower than priority threshold,
     // as those may be user submitted and lead to eg. scene manipulation that could happen in the middle of the
     // render update, which is not allowed
-    for (List<SharedPtr<WorkItem> >::Iterator i = workItems_.Begin(); i != workItems_.End();)
+    // Compact the collection in place to keep submission order without node allocations
+    unsigned kept = 0;
+    for (unsigned i = 0; i < workItems_.Size(); ++i)
     {
-        if ((*i)->completed_ && (*i)->priority_ >= priority)
+        SharedPtr<WorkItem>& item = workItems_[i];
+        if (item->completed_ && item->priority_ >= priority)
         {
-            if ((*i)->sendEvent_)
+            if (item->sendEvent_)
             {
                 using namespace WorkItemCompleted;
 
                 VariantMap& eventData = GetEventDataMap();
-                eventData[P_ITEM] = i->Get();
+                eventData[P_ITEM] = item.Get();
                 SendEvent(E_WORKITEMCOMPLETED, eventData);
             }
 
-            ReturnToPool(*i);
-            i = workItems_.Erase(i);
+            ReturnToPool(item);
+            item.Reset();
         }
         else
-            ++i;
+        {
+            if (kept != i)
+                workItems_[kept] = item;
+            ++kept;
+        }
     }
+    workItems_.Resize(kept);
 }
 
 void WorkQueue::PurgePool()
@@ -377,7 +625,7 @@ void WorkQueue::PurgePool()
 
     // Difference tolerance, should be fairly significant to reduce the pool size.
     for (unsigned i = 0; poolItems_.Size() > 0 && difference > tolerance_ && i < (unsigned)difference; i++)
-        poolItems_.PopFront();
+        poolItems_.Pop();
 
     lastSize_ = currentSize;
 }
@@ -406,19 +654,15 @@ void WorkQueue::ReturnToPool(SharedPtr<WorkItem>& item)
 void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
     // If no worker threads, complete low-priority work here
-    if (threads_.Empty() && !queue_.Empty())
+    if (threads_.Empty() && (!queue_.Empty() || !deques_[0]->Empty() || overflow_.load(std::memory_order_relaxed)))
     {
         URHO3D_PROFILE(CompleteWorkNonthreaded);
 
         HiresTimer timer;
 
-        while (!queue_.Empty() && timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000LL)
-        {
-            WorkItem* item = queue_.Front();
-            queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
-        }
+        WorkItem* item;
+        while (timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000LL && TakeItem(0, item))
+            ExecuteItem(item, 0);
     }
 
     // Complete and signal items down to the lowest priority
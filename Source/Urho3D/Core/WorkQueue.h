@@ -25,8 +25,10 @@
 #include "../Container/List.h"
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
+#include "../Core/WorkStealingQueue.h"
 
 #include <atomic>
+#include <type_traits>
 
 namespace Urho3D
 {
@@ -37,6 +39,7 @@ URHO3D_EVENT(E_WORKITEMCOMPLETED, WorkItemCompleted)
     URHO3D_PARAM(P_ITEM, Item);                        // WorkItem ptr
 }
 
+class TaskGraph;
 class WorkerThread;
 
 /// Work queue item.
@@ -60,9 +63,13 @@ public:
     bool sendEvent_{};
     /// Completed flag.
     std::atomic<bool> completed_{};
+    /// Whether the work function sets the completed flag itself before signaling its waiter. The item is not touched after the work function returns, as the waiter may already have destroyed it.
+    bool completesItself_{};
 
 private:
     bool pooled_{};
+    /// Next item in the work queue's overflow stack.
+    WorkItem* nextOverflow_{};
 };
 
 /// Work queue subsystem for multithreading.
@@ -70,6 +77,7 @@ class URHO3D_API WorkQueue : public Object
 {
     URHO3D_OBJECT(WorkQueue, Object);
 
+    friend class TaskGraph;
     friend class WorkerThread;
 
 public:
@@ -82,9 +90,9 @@ public:
     void CreateThreads(unsigned numThreads);
     /// Get pointer to an usable WorkItem from the item pool. Allocate one if no more free items.
     SharedPtr<WorkItem> GetFreeItem();
-    /// Add a work item and resume worker threads.
+    /// Add a work item and resume worker threads. Items with maximum priority are spread over the worker threads' lock-free inboxes, others go to the prioritized queue.
     void AddWorkItem(const SharedPtr<WorkItem>& item);
-    /// Remove a work item before it has started executing. Return true if successfully removed.
+    /// Remove a work item before it has started executing. Return true if successfully removed. Maximum priority items can not be removed once added.
     bool RemoveWorkItem(SharedPtr<WorkItem> item);
     /// Remove a number of work items before they have started executing. Return the number of items successfully removed.
     unsigned RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items);
@@ -95,6 +103,21 @@ public:
     /// Finish all queued work which has at least the specified priority. Main thread will also execute priority work. Pause worker threads if no more work remains.
     void Complete(unsigned priority);
 
+    /// Call function(begin, end, threadIndex) over consecutive chunks of the range [0, count) in parallel. Chunks have at least grainSize elements, or are sized automatically if zero. The main thread participates, and only this range is waited for, not other queued work. Can only be called from the main thread, outside work functions.
+    template <class T> void ParallelFor(unsigned count, unsigned grainSize, T&& function)
+    {
+        using FunctionType = std::remove_reference_t<T>;
+        ParallelFor(count, grainSize, [](void* data, unsigned begin, unsigned end, unsigned threadIndex)
+        {
+            (*static_cast<FunctionType*>(data))(begin, end, threadIndex);
+        }, const_cast<void*>(static_cast<const void*>(&function)));
+    }
+
+    /// Call function(data, begin, end, threadIndex) over consecutive chunks of the range [0, count) in parallel. Can only be called from the main thread, outside work functions.
+    void ParallelFor(unsigned count, unsigned grainSize, void (*function)(void*, unsigned, unsigned, unsigned), void* data);
+    /// Execute work in the main thread until the counter, decremented by work functions, reaches zero.
+    void WaitForCounter(const std::atomic<unsigned>& counter);
+
     /// Set the pool telerance before it starts deleting pool items.
     void SetTolerance(int tolerance) { tolerance_ = tolerance; }
 
@@ -118,6 +141,18 @@ public:
 private:
     /// Process work items until shut down. Called by the worker threads.
     void ProcessItems(unsigned threadIndex);
+    /// Take an item from the thread's own deque, or steal one from the other threads' deques. Return true if an item was taken.
+    bool StealItem(unsigned threadIndex, WorkItem*& item);
+    /// Take an item which has at least the specified priority, first from the deques and then from the prioritized queue. Called by the main thread.
+    bool TakeItem(unsigned priority, WorkItem*& item);
+    /// Queue an item which is not tracked by the main thread item collection into the calling thread's deque, or the overflow stack if full. Never locks, so can be called from work functions while the queue is paused.
+    void PushItem(WorkItem* item, unsigned threadIndex);
+    /// Take the overflow stack, return its first item and queue the rest into the calling thread's deque. Return true if an item was taken.
+    bool TakeOverflow(unsigned threadIndex, WorkItem*& item);
+    /// Queue a maximum priority item into the next worker thread's inbox in round robin order, or into the main thread's deque if there are no worker threads. Return false if full. Called by the main thread.
+    bool DistributeItem(WorkItem* item);
+    /// Pause worker threads if no queued work remains. Work left in the deques, such as a started task graph nobody waits for yet, keeps the threads running.
+    void PauseIfIdle();
     /// Purge completed work items which have at least the specified priority, and send completion events as necessary.
     void PurgeCompleted(unsigned priority);
     /// Purge the pool to reduce allocation where its unneeded.
@@ -129,12 +164,22 @@ private:
 
     /// Worker threads.
     Vector<SharedPtr<WorkerThread> > threads_;
-    /// Work item pool for reuse to cut down on allocation. The bool is a flag for item pooling and whether it is available or not.
-    List<SharedPtr<WorkItem> > poolItems_;
+    /// Work item pool for reuse to cut down on allocation.
+    Vector<SharedPtr<WorkItem> > poolItems_;
     /// Work item collection. Accessed only by the main thread.
-    List<SharedPtr<WorkItem> > workItems_;
-    /// Work item prioritized queue for worker threads. Pointers are guaranteed to be valid (point to workItems).
+    Vector<SharedPtr<WorkItem> > workItems_;
+    /// Per-thread work-stealing deques for maximum priority items. Index 0 is owned by the main thread, the rest by the worker threads. Pointers are guaranteed to be valid (point to workItems).
+    Vector<UniquePtr<WorkStealingQueue<WorkItem*> > > deques_;
+    /// Per-worker thread inboxes for maximum priority items submitted by the main thread, which is the only one pushing to them. The worker takes from its own inbox first, other threads steal from it when idle.
+    Vector<UniquePtr<WorkStealingQueue<WorkItem*> > > inboxes_;
+    /// Inbox which receives the next submitted item.
+    unsigned nextInbox_{};
+    /// Lock-free stack of maximum priority items which did not fit in the deques.
+    std::atomic<WorkItem*> overflow_{};
+    /// Work item prioritized queue for items below maximum priority. Pointers are guaranteed to be valid (point to workItems).
     List<WorkItem*> queue_;
+    /// Work items reused by ParallelFor, one per helping worker thread.
+    Vector<SharedPtr<WorkItem> > parallelForItems_;
     /// Worker queue mutex.
     Mutex queueMutex_;
     /// Shutting down flag.
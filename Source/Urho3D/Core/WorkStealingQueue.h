@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace Urho3D
+{
+
+/// Bounded lock-free work-stealing deque (Chase-Lev). The owning thread pushes and pops at the bottom, any other thread may steal from the top. Holds trivially copyable values such as pointers.
+template <class T, unsigned Capacity = 4096> class WorkStealingQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "WorkStealingQueue capacity must be a power of two");
+
+public:
+    /// Construct empty.
+    WorkStealingQueue() = default;
+    /// Prevent copy construction.
+    WorkStealingQueue(const WorkStealingQueue& rhs) = delete;
+    /// Prevent assignment.
+    WorkStealingQueue& operator =(const WorkStealingQueue& rhs) = delete;
+
+    /// Push a value at the bottom. Owner thread only. Return false if the deque is full.
+    bool Push(T value)
+    {
+        const std::ptrdiff_t bottom = bottom_.load(std::memory_order_relaxed);
+        const std::ptrdiff_t top = top_.load(std::memory_order_acquire);
+        if (bottom - top >= (std::ptrdiff_t)Capacity)
+            return false;
+
+        buffer_[bottom & (Capacity - 1)].store(value, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// Pop a value from the bottom. Owner thread only. Return false if the deque is empty or the last value was stolen.
+    bool Pop(T& value)
+    {
+        const std::ptrdiff_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::ptrdiff_t top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            // Empty
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        value = buffer_[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+        if (top == bottom)
+        {
+            // Last value: race against thieves
+            const bool won = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+
+        return true;
+    }
+
+    /// Steal a value from the top. Any thread. Return false if the deque is empty or another thread won the race.
+    bool Steal(T& value)
+    {
+        std::ptrdiff_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::ptrdiff_t bottom = bottom_.load(std::memory_order_acquire);
+
+        if (top >= bottom)
+            return false;
+
+        value = buffer_[top & (Capacity - 1)].load(std::memory_order_relaxed);
+        return top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    /// Return approximate number of values. May be stale when called from a non-owner thread.
+    unsigned Size() const
+    {
+        const std::ptrdiff_t size = bottom_.load(std::memory_order_relaxed) - top_.load(std::memory_order_relaxed);
+        return size > 0 ? (unsigned)size : 0;
+    }
+
+    /// Return whether appears empty. May be stale when called from a non-owner thread.
+    bool Empty() const { return Size() == 0; }
+
+    /// Return maximum number of values.
+    static constexpr unsigned GetCapacity() { return Capacity; }
+
+private:
+    /// Steal end index. Kept on its own cache line to avoid false sharing with the owner end.
+    alignas(64) std::atomic<std::ptrdiff_t> top_{};
+    /// Owner end index.
+    alignas(64) std::atomic<std::ptrdiff_t> bottom_{};
+    /// Ring buffer storage.
+    alignas(64) std::atomic<T> buffer_[Capacity]{};
+};
+
+}
@@ -26,6 +26,7 @@
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/EventProfiler.h"
+#include "../Core/FrameAllocator.h"
 #include "../Core/ProcessUtils.h"
 #include "../Core/WorkQueue.h"
 #include "../Engine/Console.h"
@@ -121,6 +122,7 @@ Engine::Engine(Context* context) :
     // Create subsystems which do not depend on engine initialization or startup parameters
     context_->RegisterSubsystem(new Time(context_));
     context_->RegisterSubsystem(new WorkQueue(context_));
+    context_->RegisterSubsystem(new FrameAllocator(context_));
 #ifdef URHO3D_PROFILING
     context_->RegisterSubsystem(new Profiler(context_));
 #endif
@@ -275,6 +277,7 @@ bool Engine::Initialize(const VariantMap& parameters)
         renderer->SetTextureQuality((MaterialQuality)GetParameter(parameters, EP_TEXTURE_QUALITY, QUALITY_HIGH).GetInt());
         renderer->SetTextureFilterMode((TextureFilterMode)GetParameter(parameters, EP_TEXTURE_FILTER_MODE, FILTER_TRILINEAR).GetInt());
         renderer->SetTextureAnisotropy(GetParameter(parameters, EP_TEXTURE_ANISOTROPY, 4).GetInt());
+        renderer->SetPipelinedRendering(GetParameter(parameters, EP_PIPELINED_RENDERING, false).GetBool());
 
         if (GetParameter(parameters, EP_SOUND, true).GetBool())
         {
@@ -311,6 +314,10 @@ bool Engine::Initialize(const VariantMap& parameters)
         context_->RegisterSubsystem(new EventProfiler(context_));
         EventProfiler::SetActive(true);
     }
+
+    // Stream the profiler timelines to a file, for example to profile a headless server without an external profiler
+    if (HasParameter(parameters, EP_PROFILER_TRACE))
+        GetSubsystem<Profiler>()->StartTrace(GetParameter(parameters, EP_PROFILER_TRACE).GetString());
 #endif
     frameTimer_.Reset();
 
@@ -632,10 +639,10 @@ void Engine::DumpResources(bool dumpFileName)
         URHO3D_LOGRAW("Used resources:\n");
         for (HashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups.Begin(); i != resourceGroups.End(); ++i)
         {
-            const HashMap<StringHash, SharedPtr<Resource> >& resources = i->second_.resources_;
+            const FlatHashMap<StringHash, SharedPtr<Resource> >& resources = i->second_.resources_;
             if (dumpFileName)
             {
-                for (HashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = resources.Begin(); j != resources.End(); ++j)
+                for (FlatHashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = resources.Begin(); j != resources.End(); ++j)
                     URHO3D_LOGRAW(j->second_->GetName() + "\n");
             }
         }
@@ -950,6 +957,11 @@ VariantMap Engine::ParseParameters(const Vector<String>& arguments)
             }
             else if (argument == "touch")
                 ret[EP_TOUCH_EMULATION] = true;
+            else if (argument == "trace" && !value.Empty())
+            {
+                ret[EP_PROFILER_TRACE] = value;
+                ++i;
+            }
 #ifdef URHO3D_TESTING
             else if (argument == "timeout" && !value.Empty())
             {
@@ -26,16 +26,19 @@
 #include "../Core/Profiler.h"
 #include "../Graphics/AnimatedModel.h"
 #include "../Graphics/Animation.h"
+#include "../Graphics/AnimationScheduler.h"
 #include "../Graphics/AnimationState.h"
 #include "../Graphics/Batch.h"
 #include "../Graphics/Camera.h"
 #include "../Graphics/DebugRenderer.h"
+#include "../Graphics/DecalSet.h"
 #include "../Graphics/DrawableEvents.h"
 #include "../Graphics/Geometry.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/IndexBuffer.h"
 #include "../Graphics/Material.h"
 #include "../Graphics/Octree.h"
+#include "../Graphics/SoftwareSkinning.h"
 #include "../Graphics/VertexBuffer.h"
 #include "../IO/Log.h"
 #include "../Resource/ResourceCache.h"
@@ -67,6 +70,8 @@ static bool CompareAnimationOrder(const SharedPtr<AnimationState>& lhs, const Sh
 
 static const unsigned MAX_ANIMATION_STATES = 256;
 
+static const PODVector<Vector3> noSkinnedPositions;
+
 AnimatedModel::AnimatedModel(Context* context) :
     StaticModel(context),
     animationLodFrameNumber_(0),
@@ -83,7 +88,12 @@ AnimatedModel::AnimatedModel(Context* context) :
     isMaster_(true),
     loading_(false),
     assignBonesPending_(false),
-    forceAnimationUpdate_(false)
+    forceAnimationUpdate_(false),
+    usePoseBuffer_(false),
+    writingBoneNodes_(false),
+    animationScheduled_(false),
+    skinnedRaycast_(false),
+    skinnedPositionsDirty_(true)
 {
 }
 
@@ -115,6 +125,8 @@ void AnimatedModel::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Shadow Distance", GetShadowDistance, SetShadowDistance, float, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("LOD Bias", GetLodBias, SetLodBias, float, 1.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Animation LOD Bias", GetAnimationLodBias, SetAnimationLodBias, float, 1.0f, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Use Pose Buffer", GetUsePoseBuffer, SetUsePoseBuffer, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Skinned Raycast", GetSkinnedRaycast, SetSkinnedRaycast, bool, false, AM_DEFAULT);
     URHO3D_COPY_BASE_ATTRIBUTES(Drawable);
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Bone Animation Enabled", GetBonesEnabledAttr, SetBonesEnabledAttr, VariantVector,
         Variant::emptyVariantVector, AM_FILE | AM_NOEDIT);
@@ -168,6 +180,12 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         return;
     }
 
+    if (skinnedRaycast_)
+    {
+        ProcessSkinnedRayQuery(query, results);
+        return;
+    }
+
     // Check ray hit distance to AABB before proceeding with bone-level tests
     if (query.ray_.HitDistance(GetWorldBoundingBox()) >= query.maxDistance_)
         return;
@@ -188,7 +206,7 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         {
             // Do an initial crude test using the bone's AABB
             const BoundingBox& box = bone.boundingBox_;
-            const Matrix3x4& transform = bone.node_->GetWorldTransform();
+            const Matrix3x4 transform = GetBoneWorldTransform(i);
             distance = query.ray_.HitDistance(box.Transformed(transform));
             if (distance >= query.maxDistance_)
                 continue;
@@ -204,7 +222,7 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         }
         else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
         {
-            boneSphere.center_ = bone.node_->GetWorldPosition();
+            boneSphere.center_ = GetBoneWorldTransform(i).Translation();
             boneSphere.radius_ = bone.radius_;
             distance = query.ray_.HitDistance(boneSphere);
             if (distance >= query.maxDistance_)
@@ -251,7 +269,23 @@ void AnimatedModel::Update(const FrameInfo& frame)
     }
 
     if (animationDirty_ || animationOrderDirty_)
-        UpdateAnimation(frame);
+    {
+        // Pose buffer evaluation is handed over to the octree's animation scheduler, which runs it in parallel after the
+        // drawable update. Far LOD models may be deferred further by its time budget
+        AnimationScheduler* scheduler = octant_ && IsPoseBufferActive() ? octant_->GetRoot()->GetAnimationScheduler() : nullptr;
+        if (scheduler)
+        {
+            if (!animationScheduled_ && AdvanceAnimationLod(frame))
+            {
+                const bool far = animationLodBias_ > 0.0f &&
+                    animationLodDistance_ > animationLodBias_ * frame.timeStep_ * ANIMATION_LOD_BASESCALE;
+                if (!scheduler->Queue(this, far))
+                    ApplyAnimation();
+            }
+        }
+        else
+            UpdateAnimation(frame);
+    }
     else if (boneBoundingBoxDirty_)
         UpdateBoneBoundingBox();
 }
@@ -325,6 +359,8 @@ void AnimatedModel::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
     if (debug && IsEnabledEffective())
     {
         debug->AddBoundingBox(GetWorldBoundingBox(), Color::GREEN, depthTest);
+        // The skeleton is drawn from the bone nodes
+        SyncBoneNodes();
         debug->AddSkeleton(skeleton_, Color(0.75f, 0.75f, 0.75f), depthTest);
     }
 }
@@ -345,6 +381,7 @@ void AnimatedModel::SetModel(Model* model, bool createBones)
         UnsubscribeFromEvent(model_, E_RELOADFINISHED);
 
     model_ = model;
+    skinnedPositionsDirty_ = true;
 
     if (model)
     {
@@ -549,6 +586,85 @@ void AnimatedModel::SetUpdateInvisible(bool enable)
 }
 
 
+void AnimatedModel::SetUsePoseBuffer(bool enable)
+{
+    if (enable == usePoseBuffer_)
+        return;
+
+    // Leave the bone nodes in the last evaluated pose when switching back to node animation
+    SyncBoneNodes();
+    usePoseBuffer_ = enable;
+    MarkAnimationDirty();
+    MarkNetworkUpdate();
+}
+
+void AnimatedModel::SyncBoneNodes()
+{
+    if (IsPoseBufferActive() && pose_.Size() == skeleton_.GetNumBones())
+        WriteBoneNodes(true);
+}
+
+bool AnimatedModel::UpdateSkinnedPositions()
+{
+    if (!node_ || skinMatrices_.Empty())
+        return false;
+
+    if (skinningDirty_)
+        UpdateSkinning();
+    if (!skinnedPositionsDirty_ && skinnedPositions_.Size() == batches_.Size())
+        return true;
+
+    skinnedPositions_.Resize(batches_.Size());
+    for (unsigned i = 0; i < batches_.Size(); ++i)
+    {
+        PODVector<Vector3>& positions = skinnedPositions_[i];
+        positions.Clear();
+
+        Geometry* geometry = GetLodGeometry(i, 0);
+        if (!geometry)
+            continue;
+
+        // For morphed models positions and skinning may be in different buffers. The morphed positions come last
+        const unsigned char* positionData = nullptr;
+        const unsigned char* blendWeightData = nullptr;
+        const unsigned char* blendIndexData = nullptr;
+        unsigned positionStride = 0;
+        unsigned skinningStride = 0;
+        for (unsigned j = 0; j < geometry->GetNumVertexBuffers(); ++j)
+        {
+            VertexBuffer* vb = geometry->GetVertexBuffer(j);
+            const unsigned char* data = vb ? vb->GetShadowData() : nullptr;
+            if (!data)
+                continue;
+
+            if (vb->HasElement(TYPE_VECTOR3, SEM_POSITION))
+            {
+                positionData = data + vb->GetElementOffset(SEM_POSITION);
+                positionStride = vb->GetVertexSize();
+            }
+            if (vb->HasElement(TYPE_VECTOR4, SEM_BLENDWEIGHTS) && vb->HasElement(TYPE_UBYTE4, SEM_BLENDINDICES))
+            {
+                blendWeightData = data + vb->GetElementOffset(SEM_BLENDWEIGHTS);
+                blendIndexData = data + vb->GetElementOffset(SEM_BLENDINDICES);
+                skinningStride = vb->GetVertexSize();
+            }
+        }
+        if (!positionData || !blendWeightData)
+            continue;
+
+        const PODVector<Matrix3x4>& palette = i < geometrySkinMatrices_.Size() && !geometrySkinMatrices_[i].Empty() ?
+            geometrySkinMatrices_[i] : skinMatrices_;
+        const unsigned vertexStart = geometry->GetVertexStart();
+        positions.Resize(geometry->GetVertexCount());
+        SkinPositions(positionData + vertexStart * positionStride, positionStride, blendWeightData + vertexStart * skinningStride,
+            blendIndexData + vertexStart * skinningStride, skinningStride, palette.Buffer(), palette.Size(), positions.Size(),
+            positions.Buffer());
+    }
+
+    skinnedPositionsDirty_ = false;
+    return true;
+}
+
 void AnimatedModel::SetMorphWeight(unsigned index, float weight)
 {
     if (index >= morphs_.Size())
@@ -794,6 +910,7 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
     }
 
     assignBonesPending_ = !createBones;
+    UpdateBoneOrder();
 }
 
 void AnimatedModel::SetModelAttr(const ResourceRef& value)
@@ -894,6 +1011,11 @@ VariantVector AnimatedModel::GetAnimationStatesAttr() const
     return ret;
 }
 
+const PODVector<Vector3>& AnimatedModel::GetSkinnedPositions(unsigned batchIndex) const
+{
+    return batchIndex < skinnedPositions_.Size() ? skinnedPositions_[batchIndex] : noSkinnedPositions;
+}
+
 const PODVector<unsigned char>& AnimatedModel::GetMorphsAttr() const
 {
     attrBuffer_.Clear();
@@ -909,26 +1031,42 @@ void AnimatedModel::UpdateBoneBoundingBox()
     {
         // The bone bounding box is in local space, so need the node's inverse transform
         boneBoundingBox_.Clear();
-        Matrix3x4 inverseNodeTransform = node_->GetWorldTransform().Inverse();
-
         const Vector<Bone>& bones = skeleton_.GetBones();
-        for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End(); ++i)
+
+        // The pose buffer transforms are already relative to the model's node
+        if (IsPoseBufferActive() && boneTransforms_.Size() == bones.Size())
         {
-            Node* boneNode = i->node_;
-            if (!boneNode)
-                continue;
+            for (unsigned i = 0; i < bones.Size(); ++i)
+            {
+                const Bone& bone = bones[i];
+                if (bone.collisionMask_ & BONECOLLISION_BOX)
+                    boneBoundingBox_.Merge(bone.boundingBox_.Transformed(boneTransforms_[i]));
+                else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
+                    boneBoundingBox_.Merge(Sphere(boneTransforms_[i].Translation(), bone.radius_ * 0.5f));
+            }
+        }
+        else
+        {
+            Matrix3x4 inverseNodeTransform = node_->GetWorldTransform().Inverse();
 
-            // Use hitbox if available. If not, use only half of the sphere radius
-            /// \todo The sphere radius should be multiplied with bone scale
-            if (i->collisionMask_ & BONECOLLISION_BOX)
-                boneBoundingBox_.Merge(i->boundingBox_.Transformed(inverseNodeTransform * boneNode->GetWorldTransform()));
-            else if (i->collisionMask_ & BONECOLLISION_SPHERE)
-                boneBoundingBox_.Merge(Sphere(inverseNodeTransform * boneNode->GetWorldPosition(), i->radius_ * 0.5f));
+            for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End(); ++i)
+            {
+                Node* boneNode = i->node_;
+                if (!boneNode)
+                    continue;
+
+                // Use hitbox if available. If not, use only half of the sphere radius
+                /// \todo The sphere radius should be multiplied with bone scale
+                if (i->collisionMask_ & BONECOLLISION_BOX)
+                    boneBoundingBox_.Merge(i->boundingBox_.Transformed(inverseNodeTransform * boneNode->GetWorldTransform()));
+                else if (i->collisionMask_ & BONECOLLISION_SPHERE)
+                    boneBoundingBox_.Merge(Sphere(inverseNodeTransform * boneNode->GetWorldPosition(), i->radius_ * 0.5f));
+            }
         }
     }
 
     boneBoundingBoxDirty_ = false;
-    worldBoundingBoxDirty_ = true;
+    MarkWorldBoundingBoxDirty();
 }
 
 void AnimatedModel::OnNodeSet(Node* node)
@@ -944,6 +1082,10 @@ void AnimatedModel::OnNodeSet(Node* node)
 
 void AnimatedModel::OnMarkedDirty(Node* node)
 {
+    // Bone nodes being written from the pose buffer do not change the skinning or bounds evaluated from it
+    if (writingBoneNodes_)
+        return;
+
     Drawable::OnMarkedDirty(node);
 
     // If the scene node or any of the bone nodes move, mark skinning dirty
@@ -952,7 +1094,13 @@ void AnimatedModel::OnMarkedDirty(Node* node)
         skinningDirty_ = true;
         // Bone bounding box doesn't need to be marked dirty when only the base scene node moves
         if (node != node_)
+        {
             boneBoundingBoxDirty_ = true;
+            // With the pose buffer, a bone node moved from outside (for example a bone with animation disabled) needs
+            // the pose to be evaluated again, as skinning does not read the nodes
+            if (IsPoseBufferActive())
+                MarkAnimationDirty();
+        }
     }
 }
 
@@ -1253,6 +1401,12 @@ void AnimatedModel::SetGeometryBoneMappings()
 }
 
 void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
+{
+    if (AdvanceAnimationLod(frame))
+        ApplyAnimation();
+}
+
+bool AnimatedModel::AdvanceAnimationLod(const FrameInfo& frame)
 {
     // If using animation LOD, accumulate time and see if it is time to update
     if (animationLodBias_ > 0.0f && animationLodDistance_ > 0.0f)
@@ -1264,13 +1418,13 @@ void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
             if (animationLodTimer_ >= animationLodDistance_)
                 animationLodTimer_ = fmodf(animationLodTimer_, animationLodDistance_);
             else
-                return;
+                return false;
         }
         else
             animationLodTimer_ = 0.0f;
     }
 
-    ApplyAnimation();
+    return true;
 }
 
 void AnimatedModel::ApplyAnimation()
@@ -1284,7 +1438,12 @@ void AnimatedModel::ApplyAnimation()
 
     // Reset skeleton, apply all animations, calculate bones' bounding box. Make sure this is only done for the master model
     // (first AnimatedModel in a node)
-    if (isMaster_)
+    if (IsPoseBufferActive())
+    {
+        EvaluatePose();
+        FinishPose();
+    }
+    else if (isMaster_)
     {
         skeleton_.ResetSilent();
         for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
@@ -1300,6 +1459,234 @@ void AnimatedModel::ApplyAnimation()
     animationDirty_ = false;
 }
 
+void AnimatedModel::UpdateBoneOrder()
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    const unsigned numBones = bones.Size();
+
+    // Sort the bones by depth, so that parents are always evaluated before their children
+    PODVector<unsigned> depths(numBones);
+    boneChildCounts_.Resize(numBones);
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        depths[i] = 0;
+        boneChildCounts_[i] = 0;
+    }
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        unsigned parentIndex = bones[i].parentIndex_;
+        if (parentIndex != i && parentIndex < numBones)
+            ++boneChildCounts_[parentIndex];
+
+        unsigned current = i;
+        while (bones[current].parentIndex_ != current && bones[current].parentIndex_ < numBones && depths[i] < numBones)
+        {
+            current = bones[current].parentIndex_;
+            ++depths[i];
+        }
+    }
+
+    boneOrder_.Clear();
+    for (unsigned depth = 0; boneOrder_.Size() < numBones && depth <= numBones; ++depth)
+    {
+        for (unsigned i = 0; i < numBones; ++i)
+        {
+            if (depths[i] == depth)
+                boneOrder_.Push(i);
+        }
+    }
+
+    // The pose is evaluated again on the next animation update
+    pose_.Clear();
+    boneTransforms_.Clear();
+}
+
+void AnimatedModel::EvaluatePose()
+{
+    // Make sure animations are in ascending priority order
+    if (animationOrderDirty_)
+    {
+        Sort(animationStates_.Begin(), animationStates_.End(), CompareAnimationOrder);
+        animationOrderDirty_ = false;
+    }
+
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    const unsigned numBones = bones.Size();
+    pose_.Resize(numBones);
+    boneTransforms_.Resize(numBones);
+
+    // Reset animated bones to the bind pose. Bones with animation disabled are controlled through their nodes
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        const Bone& bone = bones[i];
+        BonePose& pose = pose_[i];
+        if (!bone.animated_ && bone.node_)
+        {
+            pose.position_ = bone.node_->GetPosition();
+            pose.rotation_ = bone.node_->GetRotation();
+            pose.scale_ = bone.node_->GetScale();
+        }
+        else
+        {
+            pose.position_ = bone.initialPosition_;
+            pose.rotation_ = bone.initialRotation_;
+            pose.scale_ = bone.initialScale_;
+        }
+    }
+
+    for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+        (*i)->Apply();
+
+    // Compute the transforms relative to the model's node in one pass. The root bone's parent is the model's node
+    for (unsigned i = 0; i < boneOrder_.Size(); ++i)
+    {
+        unsigned index = boneOrder_[i];
+        const BonePose& pose = pose_[index];
+        unsigned parentIndex = bones[index].parentIndex_;
+        if (parentIndex != index && parentIndex < numBones)
+            boneTransforms_[index] = boneTransforms_[parentIndex] * Matrix3x4(pose.position_, pose.rotation_, pose.scale_);
+        else
+            boneTransforms_[index] = Matrix3x4(pose.position_, pose.rotation_, pose.scale_);
+    }
+
+    UpdateBoneBoundingBox();
+}
+
+void AnimatedModel::FinishPose()
+{
+    // Other animated models and decals in the node skin from the bone nodes, so they need the whole pose
+    bool boneNodesShared = false;
+    const Vector<SharedPtr<Component> >& components = node_->GetComponents();
+    for (unsigned i = 0; i < components.Size(); ++i)
+    {
+        StringHash type = components[i]->GetType();
+        if (components[i] != this && (type == AnimatedModel::GetTypeStatic() || type == DecalSet::GetTypeStatic()))
+        {
+            boneNodesShared = true;
+            break;
+        }
+    }
+    WriteBoneNodes(boneNodesShared);
+
+    skinningDirty_ = true;
+    animationDirty_ = false;
+    MarkForUpdate();
+}
+
+void AnimatedModel::ProcessSkinnedRayQuery(const RayOctreeQuery& query, PODVector<RayQueryResult>& results)
+{
+    if (query.ray_.HitDistance(GetWorldBoundingBox()) >= query.maxDistance_ || !UpdateSkinnedPositions())
+        return;
+
+    float distance = M_INFINITY;
+    Vector3 normal = -query.ray_.direction_;
+    unsigned hitBatch = M_MAX_UNSIGNED;
+
+    for (unsigned i = 0; i < skinnedPositions_.Size(); ++i)
+    {
+        const PODVector<Vector3>& positions = skinnedPositions_[i];
+        Geometry* geometry = GetLodGeometry(i, 0);
+        if (positions.Empty() || geometry->GetPrimitiveType() != TRIANGLE_LIST)
+            continue;
+
+        const unsigned char* vertexData;
+        const unsigned char* indexData;
+        unsigned vertexSize;
+        unsigned indexSize;
+        const PODVector<VertexElement>* elements;
+        geometry->GetRawData(vertexData, vertexSize, indexData, indexSize, elements);
+        if (!indexData)
+            continue;
+
+        const unsigned vertexStart = geometry->GetVertexStart();
+        const unsigned indexEnd = geometry->GetIndexStart() + geometry->GetIndexCount();
+        for (unsigned j = geometry->GetIndexStart(); j + 2 < indexEnd; j += 3)
+        {
+            unsigned indices[3];
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                indices[k] = (indexSize == sizeof(unsigned short) ? ((const unsigned short*)indexData)[j + k] :
+                    ((const unsigned*)indexData)[j + k]) - vertexStart;
+            }
+            if (indices[0] >= positions.Size() || indices[1] >= positions.Size() || indices[2] >= positions.Size())
+                continue;
+
+            Vector3 triangleNormal;
+            const float triangleDistance = query.ray_.HitDistance(positions[indices[0]], positions[indices[1]], positions[indices[2]],
+                &triangleNormal);
+            if (triangleDistance < query.maxDistance_ && triangleDistance < distance)
+            {
+                distance = triangleDistance;
+                normal = triangleNormal;
+                hitBatch = i;
+            }
+        }
+    }
+
+    if (distance < query.maxDistance_)
+    {
+        RayQueryResult result;
+        result.position_ = query.ray_.origin_ + distance * query.ray_.direction_;
+        result.normal_ = normal.Normalized();
+        result.distance_ = distance;
+        result.drawable_ = this;
+        result.node_ = node_;
+        result.subObject_ = hitBatch;
+        results.Push(result);
+    }
+}
+
+void AnimatedModel::WriteBoneNodes(bool all)
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    const unsigned numBones = bones.Size();
+    boneNodeWriteFlags_.Resize(numBones);
+
+    // Write the bones that have attachments, such as components or other child nodes, and their parent chains
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        Node* boneNode = bones[i].node_;
+        boneNodeWriteFlags_[i] = (unsigned char)(boneNode && (all || boneNode->GetNumComponents() ||
+            boneNode->GetNumChildren() > boneChildCounts_[i]));
+    }
+    for (unsigned i = boneOrder_.Size(); i-- > 0;)
+    {
+        unsigned index = boneOrder_[i];
+        unsigned parentIndex = bones[index].parentIndex_;
+        if (boneNodeWriteFlags_[index] && parentIndex != index && parentIndex < numBones)
+            boneNodeWriteFlags_[parentIndex] = 1;
+    }
+
+    bool written = false;
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        if (boneNodeWriteFlags_[i])
+        {
+            const BonePose& pose = pose_[i];
+            bones[i].node_->SetTransformSilent(pose.position_, pose.rotation_, pose.scale_);
+            written = true;
+        }
+    }
+
+    // Mark dirty from the root bone, as the transforms were set silently
+    Bone* rootBone = skeleton_.GetRootBone();
+    if (written && rootBone && rootBone->node_)
+    {
+        writingBoneNodes_ = true;
+        rootBone->node_->MarkDirty();
+        writingBoneNodes_ = false;
+    }
+}
+
+Matrix3x4 AnimatedModel::GetBoneWorldTransform(unsigned index) const
+{
+    if (IsPoseBufferActive() && index < boneTransforms_.Size())
+        return node_->GetWorldTransform() * boneTransforms_[index];
+
+    Node* boneNode = skeleton_.GetBones()[index].node_;
+    return boneNode ? boneNode->GetWorldTransform() : node_->GetWorldTransform();
+}
+
 void AnimatedModel::UpdateSkinning()
 {
     // Note: the model's world transform will be baked in the skin matrices
@@ -1307,8 +1694,23 @@ void AnimatedModel::UpdateSkinning()
     // Use model's world transform in case a bone is missing
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
 
+    // Skin directly from the pose buffer, without reading the bone nodes
+    if (IsPoseBufferActive() && boneTransforms_.Size() == bones.Size())
+    {
+        for (unsigned i = 0; i < bones.Size(); ++i)
+        {
+            skinMatrices_[i] = worldTransform * boneTransforms_[i] * bones[i].offsetMatrix_;
+
+            // Copy the skin matrix to per-geometry matrices as needed
+            if (geometrySkinMatrices_.Size())
+            {
+                for (unsigned j = 0; j < geometrySkinMatrixPtrs_[i].Size(); ++j)
+                    *geometrySkinMatrixPtrs_[i][j] = skinMatrices_[i];
+            }
+        }
+    }
     // Skinning with global matrices only
-    if (!geometrySkinMatrices_.Size())
+    else if (!geometrySkinMatrices_.Size())
     {
         for (unsigned i = 0; i < bones.Size(); ++i)
         {
@@ -1337,6 +1739,7 @@ void AnimatedModel::UpdateSkinning()
     }
 
     skinningDirty_ = false;
+    skinnedPositionsDirty_ = true;
 }
 
 void AnimatedModel::UpdateMorphs()
@@ -1381,53 +1784,24 @@ void AnimatedModel::UpdateMorphs()
     }
 
     morphsDirty_ = false;
+    skinnedPositionsDirty_ = true;
 }
 
 void AnimatedModel::ApplyMorph(VertexBuffer* buffer, void* destVertexData, unsigned morphRangeStart, const VertexBufferMorph& morph,
     float weight)
 {
     const VertexMaskFlags elementMask = morph.elementMask_ & buffer->GetElementMask();
-    unsigned vertexCount = morph.vertexCount_;
-    unsigned normalOffset = buffer->GetElementOffset(SEM_NORMAL);
-    unsigned tangentOffset = buffer->GetElementOffset(SEM_TANGENT);
-    unsigned vertexSize = buffer->GetVertexSize();
-
-    unsigned char* srcData = morph.morphData_;
-    auto* destData = (unsigned char*)destVertexData;
-
-    while (vertexCount--)
-    {
-        unsigned vertexIndex = *((unsigned*)srcData) - morphRangeStart;
-        srcData += sizeof(unsigned);
-
-        if (elementMask & MASK_POSITION)
-        {
-            auto* dest = (float*)(destData + vertexIndex * vertexSize);
-            auto* src = (float*)srcData;
-            dest[0] += src[0] * weight;
-            dest[1] += src[1] * weight;
-            dest[2] += src[2] * weight;
-            srcData += 3 * sizeof(float);
-        }
-        if (elementMask & MASK_NORMAL)
-        {
-            auto* dest = (float*)(destData + vertexIndex * vertexSize + normalOffset);
-            auto* src = (float*)srcData;
-            dest[0] += src[0] * weight;
-            dest[1] += src[1] * weight;
-            dest[2] += src[2] * weight;
-            srcData += 3 * sizeof(float);
-        }
-        if (elementMask & MASK_TANGENT)
-        {
-            auto* dest = (float*)(destData + vertexIndex * vertexSize + tangentOffset);
-            auto* src = (float*)srcData;
-            dest[0] += src[0] * weight;
-            dest[1] += src[1] * weight;
-            dest[2] += src[2] * weight;
-            srcData += 3 * sizeof(float);
-        }
-    }
+    unsigned elementOffsets[3];
+    unsigned numElements = 0;
+    if (elementMask & MASK_POSITION)
+        elementOffsets[numElements++] = buffer->GetElementOffset(SEM_POSITION);
+    if (elementMask & MASK_NORMAL)
+        elementOffsets[numElements++] = buffer->GetElementOffset(SEM_NORMAL);
+    if (elementMask & MASK_TANGENT)
+        elementOffsets[numElements++] = buffer->GetElementOffset(SEM_TANGENT);
+
+    ApplyVertexMorph((unsigned char*)destVertexData, buffer->GetVertexSize(), morphRangeStart, morph.morphData_, morph.vertexCount_,
+        elementOffsets, numElements, weight);
 }
 
 void AnimatedModel::HandleModelReloadFinished(StringHash eventType, VariantMap& eventData)
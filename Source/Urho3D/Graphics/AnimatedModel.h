@@ -37,6 +37,7 @@ class URHO3D_API AnimatedModel : public StaticModel
 {
     URHO3D_OBJECT(AnimatedModel, StaticModel);
 
+    friend class AnimationScheduler;
     friend class AnimationState;
 
 public:
@@ -100,8 +101,18 @@ public:
     void SetMorphWeight(StringHash nameHash, float weight);
     /// Reset all vertex morphs to zero.
     void ResetMorphWeights();
-    /// Apply all animation states to nodes.
+    /// Apply all animation states to nodes, or to the pose buffer if in use.
     void ApplyAnimation();
+    /// Set whether to evaluate animation into a flat pose buffer instead of the bone scene nodes. Bone nodes are then only updated when they have attachments, when another animated model or decal set in the node uses them, or by SyncBoneNodes().
+    /// @property
+    void SetUsePoseBuffer(bool enable);
+    /// Write the current pose buffer to all bone scene nodes. No-op when the pose buffer is not in use.
+    void SyncBoneNodes();
+    /// Set whether triangle level raycasts test the CPU skinned triangles of the most detailed LOD instead of the bone hitboxes. Needs CPU-side vertex and index data.
+    /// @property
+    void SetSkinnedRaycast(bool enable) { skinnedRaycast_ = enable; }
+    /// Skin the vertex positions of the most detailed LOD into world space on the CPU, if out of date. Return true if the model is skinned. May be called from worker threads for different models once the node and bone transforms are up to date.
+    bool UpdateSkinnedPositions();
 
     /// Return skeleton.
     /// @property
@@ -153,6 +164,26 @@ public:
     /// Return whether is the master (first) animated model.
     bool IsMaster() const { return isMaster_; }
 
+    /// Return whether evaluates animation into a pose buffer.
+    /// @property
+    bool GetUsePoseBuffer() const { return usePoseBuffer_; }
+
+    /// Return whether animation is currently evaluated into the pose buffer. Only the master model animates.
+    bool IsPoseBufferActive() const { return usePoseBuffer_ && isMaster_; }
+
+    /// Return bone transforms relative to the parent bone from the pose buffer.
+    const PODVector<BonePose>& GetBonePoses() const { return pose_; }
+
+    /// Return bone transforms relative to the model's scene node from the pose buffer.
+    const PODVector<Matrix3x4>& GetBoneTransforms() const { return boneTransforms_; }
+
+    /// Return whether triangle level raycasts test the CPU skinned triangles.
+    /// @property
+    bool GetSkinnedRaycast() const { return skinnedRaycast_; }
+
+    /// Return world space CPU skinned vertex positions of a batch, starting from the geometry's vertex start. Empty if the geometry has no CPU-side skinning data. Valid after UpdateSkinnedPositions().
+    const PODVector<Vector3>& GetSkinnedPositions(unsigned batchIndex) const;
+
     /// Set model attribute.
     void SetModelAttr(const ResourceRef& value);
     /// Set bones' animation enabled attribute.
@@ -210,6 +241,20 @@ private:
     void CopyMorphVertices(void* destVertexData, void* srcVertexData, unsigned vertexCount, VertexBuffer* destBuffer, VertexBuffer* srcBuffer);
     /// Recalculate animations. Called from Update().
     void UpdateAnimation(const FrameInfo& frame);
+    /// Advance the animation LOD timer. Return true if animation should be recalculated this frame.
+    bool AdvanceAnimationLod(const FrameInfo& frame);
+    /// Compute the parent-first bone order of the pose buffer.
+    void UpdateBoneOrder();
+    /// Evaluate animation states into the pose buffer, compute the bone transforms relative to the model's node in one pass and update the bone bounding box. Does not touch scene nodes, so may be called from worker threads.
+    void EvaluatePose();
+    /// Write the evaluated pose to the bone nodes that need it and mark skinning dirty. Called from the main thread.
+    void FinishPose();
+    /// Process a triangle level raycast against the CPU skinned triangles.
+    void ProcessSkinnedRayQuery(const RayOctreeQuery& query, PODVector<RayQueryResult>& results);
+    /// Write the pose buffer to bone nodes. Either all of them, or only the ones which have attachments and their parents.
+    void WriteBoneNodes(bool all);
+    /// Return world transform of a bone, from the pose buffer if active.
+    Matrix3x4 GetBoneWorldTransform(unsigned index) const;
     /// Recalculate skinning.
     void UpdateSkinning();
     /// Reapply all vertex morphs.
@@ -230,12 +275,24 @@ private:
     Vector<SharedPtr<AnimationState> > animationStates_;
     /// Skinning matrices.
     PODVector<Matrix3x4> skinMatrices_;
+    /// Pose buffer bone transforms relative to the parent bone.
+    PODVector<BonePose> pose_;
+    /// Pose buffer bone transforms relative to the model's scene node.
+    PODVector<Matrix3x4> boneTransforms_;
+    /// Bone indices in parent-first order.
+    PODVector<unsigned> boneOrder_;
+    /// Number of child bones per bone, to detect attachments in bone nodes.
+    PODVector<unsigned> boneChildCounts_;
+    /// Per-bone flags of bone nodes to write, used while writing the pose buffer to nodes.
+    PODVector<unsigned char> boneNodeWriteFlags_;
     /// Mapping of subgeometry bone indices, used if more bones than skinning shader can manage.
     Vector<PODVector<unsigned> > geometryBoneMappings_;
     /// Subgeometry skinning matrices, used if more bones than skinning shader can manage.
     Vector<PODVector<Matrix3x4> > geometrySkinMatrices_;
     /// Subgeometry skinning matrix pointers, if more bones than skinning shader can manage.
     Vector<PODVector<Matrix3x4*> > geometrySkinMatrixPtrs_;
+    /// CPU skinned vertex positions per batch.
+    Vector<PODVector<Vector3> > skinnedPositions_;
     /// Bounding box calculated from bones.
     BoundingBox boneBoundingBox_;
     /// Attribute buffer.
@@ -270,6 +327,16 @@ private:
     bool assignBonesPending_;
     /// Force animation update after becoming visible flag.
     bool forceAnimationUpdate_;
+    /// Pose buffer flag.
+    bool usePoseBuffer_;
+    /// Writing pose buffer to bone nodes flag.
+    bool writingBoneNodes_;
+    /// Pose evaluation held by the octree's animation scheduler flag.
+    bool animationScheduled_;
+    /// Skinned triangle raycast flag.
+    bool skinnedRaycast_;
+    /// CPU skinned vertex positions dirty flag.
+    bool skinnedPositionsDirty_;
 };
 
 }
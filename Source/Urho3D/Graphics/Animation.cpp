@@ -49,6 +49,329 @@ inline bool CompareKeyFrames(AnimationKeyFrame& lhs, AnimationKeyFrame& rhs)
     return lhs.time_ < rhs.time_;
 }
 
+/// Largest magnitude of the three smallest components of a unit quaternion.
+static const float SMALLEST_THREE_RANGE = 0.70710678f;
+/// Quantization steps of a smallest-three quaternion component.
+static const float SMALLEST_THREE_STEPS = 32767.0f;
+/// Quantization steps of a position or scale component.
+static const float VECTOR_STEPS = 65535.0f;
+
+static float VectorDistance(const Vector3& lhs, const Vector3& rhs)
+{
+    return (lhs - rhs).Length();
+}
+
+/// Interpolate rotation keys. Close keys use normalized lerp, which deviates from slerp by less than the quantization error.
+static Quaternion InterpolateRotation(const Quaternion& lhs, const Quaternion& rhs, float t)
+{
+    return Abs(lhs.DotProduct(rhs)) > 0.999f ? lhs.Nlerp(rhs, t, true) : lhs.Slerp(rhs, t);
+}
+
+static float RotationDistance(const Quaternion& lhs, const Quaternion& rhs)
+{
+    return 2.0f * Acos(Abs(lhs.DotProduct(rhs)));
+}
+
+static void EncodeQuaternion(const Quaternion& rotation, unsigned short* dest)
+{
+    const float* data = rotation.Data();
+
+    unsigned largest = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(data[i]) > Abs(data[largest]))
+            largest = i;
+    }
+
+    // Flip the quaternion so that the omitted component is positive and can be reconstructed from the others
+    const float sign = data[largest] < 0.0f ? -1.0f : 1.0f;
+    unsigned j = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        const float value = Clamp(data[i] * sign / SMALLEST_THREE_RANGE * 0.5f + 0.5f, 0.0f, 1.0f);
+        dest[j++] = (unsigned short)RoundToInt(value * SMALLEST_THREE_STEPS);
+    }
+
+    dest[0] |= (largest >> 1u) << 15u;
+    dest[1] |= (largest & 1u) << 15u;
+}
+
+/// Find the keys to interpolate between at time, mirroring keyframe track playback. Return false if only the current key is needed.
+static bool GetCurveInterpolation(const AnimationCurve& curve, float time, float length, bool looped, unsigned& index,
+    unsigned& nextIndex, float& t)
+{
+    const PODVector<float>& times = curve.times_;
+    if (times.Size() < 2)
+    {
+        index = 0;
+        return false;
+    }
+
+    curve.GetKeyIndex(time, index);
+
+    nextIndex = index + 1;
+    if (nextIndex >= times.Size())
+    {
+        if (!looped)
+            return false;
+        nextIndex = 0;
+    }
+
+    float timeInterval = times[nextIndex] - times[index];
+    if (timeInterval < 0.0f)
+        timeInterval += length;
+    t = timeInterval > 0.0f ? (time - times[index]) / timeInterval : 1.0f;
+    return true;
+}
+
+/// Return whether interpolating between the start and end keys reproduces every key in between within tolerance.
+template <class T, class Interpolate, class Distance> static bool SpanFits(const PODVector<float>& times,
+    const PODVector<T>& values, unsigned start, unsigned end, float tolerance, Interpolate interpolate, Distance distance)
+{
+    const float timeInterval = times[end] - times[start];
+    for (unsigned i = start + 1; i < end; ++i)
+    {
+        const float t = timeInterval > 0.0f ? (times[i] - times[start]) / timeInterval : 1.0f;
+        if (distance(interpolate(values[start], values[end], t), values[i]) > tolerance)
+            return false;
+    }
+    return true;
+}
+
+/// Select the keys to keep so that interpolating between them reproduces each dropped key within tolerance. First and last keys are always kept.
+template <class T, class Interpolate, class Distance> static void SelectKeys(const PODVector<float>& times,
+    const PODVector<T>& values, float tolerance, Interpolate interpolate, Distance distance, PODVector<unsigned>& keys)
+{
+    const unsigned numKeys = values.Size();
+
+    keys.Clear();
+    keys.Push(0);
+
+    unsigned start = 0;
+    while (start + 1 < numKeys)
+    {
+        // Grow the span exponentially while it fits, then binary search for the longest fitting span
+        unsigned fit = start + 1;
+        unsigned fail = numKeys;
+        for (unsigned step = 1; fail == numKeys && fit < numKeys - 1; step *= 2)
+        {
+            const unsigned end = Min(fit + step, numKeys - 1);
+            if (SpanFits(times, values, start, end, tolerance, interpolate, distance))
+                fit = end;
+            else
+                fail = end;
+        }
+        while (fail - fit > 1 && fail < numKeys)
+        {
+            const unsigned end = (fit + fail) / 2;
+            if (SpanFits(times, values, start, end, tolerance, interpolate, distance))
+                fit = end;
+            else
+                fail = end;
+        }
+
+        keys.Push(fit);
+        start = fit;
+    }
+}
+
+static void CompressVectorCurve(AnimationCurve& curve, const Vector<AnimationKeyFrame>& keyFrames,
+    Vector3 AnimationKeyFrame::*member, float tolerance)
+{
+    curve = AnimationCurve();
+
+    const unsigned numKeys = keyFrames.Size();
+    const Vector3& first = keyFrames[0].*member;
+    Vector3 min = first;
+    Vector3 max = first;
+    bool constant = true;
+    for (unsigned i = 1; i < numKeys; ++i)
+    {
+        const Vector3& value = keyFrames[i].*member;
+        min = VectorMin(min, value);
+        max = VectorMax(max, value);
+        if (VectorDistance(value, first) > tolerance)
+            constant = false;
+    }
+
+    // Constant channel is stored exactly as a single key
+    if (constant)
+    {
+        curve.times_.Push(keyFrames[0].time_);
+        curve.values_.Resize(3);
+        curve.values_[0] = curve.values_[1] = curve.values_[2] = 0;
+        curve.min_ = first;
+        return;
+    }
+
+    curve.min_ = min;
+    curve.step_ = (max - min) / VECTOR_STEPS;
+
+    // Quantize against the channel bounds, then reduce keys against the decoded values
+    PODVector<float> times(numKeys);
+    PODVector<unsigned short> quantized(numKeys * 3);
+    PODVector<Vector3> decoded(numKeys);
+    for (unsigned i = 0; i < numKeys; ++i)
+    {
+        const Vector3& value = keyFrames[i].*member;
+        times[i] = keyFrames[i].time_;
+        for (unsigned j = 0; j < 3; ++j)
+        {
+            const float step = curve.step_.Data()[j];
+            const float offset = value.Data()[j] - curve.min_.Data()[j];
+            quantized[i * 3 + j] = (unsigned short)(step > 0.0f ? Clamp(RoundToInt(offset / step), 0, 65535) : 0);
+        }
+    }
+    curve.times_ = times;
+    curve.values_ = quantized;
+    for (unsigned i = 0; i < numKeys; ++i)
+        decoded[i] = curve.GetVector3(i);
+
+    PODVector<unsigned> keys;
+    SelectKeys(times, decoded, tolerance, [](const Vector3& lhs, const Vector3& rhs, float t) { return lhs.Lerp(rhs, t); },
+        VectorDistance, keys);
+
+    curve.times_.Resize(keys.Size());
+    curve.values_.Resize(keys.Size() * 3);
+    for (unsigned i = 0; i < keys.Size(); ++i)
+    {
+        curve.times_[i] = times[keys[i]];
+        for (unsigned j = 0; j < 3; ++j)
+            curve.values_[i * 3 + j] = quantized[keys[i] * 3 + j];
+    }
+}
+
+static void CompressRotationCurve(AnimationCurve& curve, const Vector<AnimationKeyFrame>& keyFrames, float tolerance)
+{
+    curve = AnimationCurve();
+
+    const unsigned numKeys = keyFrames.Size();
+    PODVector<float> times(numKeys);
+    PODVector<unsigned short> quantized(numKeys * 3);
+    for (unsigned i = 0; i < numKeys; ++i)
+    {
+        times[i] = keyFrames[i].time_;
+        EncodeQuaternion(keyFrames[i].rotation_.Normalized(), &quantized[i * 3]);
+    }
+    curve.times_ = times;
+    curve.values_ = quantized;
+
+    PODVector<Quaternion> decoded(numKeys);
+    bool constant = true;
+    for (unsigned i = 0; i < numKeys; ++i)
+    {
+        decoded[i] = curve.GetQuaternion(i);
+        if (RotationDistance(decoded[i], decoded[0]) > tolerance)
+            constant = false;
+    }
+
+    PODVector<unsigned> keys;
+    if (constant)
+        keys.Push(0);
+    else
+    {
+        SelectKeys(times, decoded, tolerance, InterpolateRotation, RotationDistance, keys);
+    }
+
+    curve.times_.Resize(keys.Size());
+    curve.values_.Resize(keys.Size() * 3);
+    for (unsigned i = 0; i < keys.Size(); ++i)
+    {
+        curve.times_[i] = times[keys[i]];
+        for (unsigned j = 0; j < 3; ++j)
+            curve.values_[i * 3 + j] = quantized[keys[i] * 3 + j];
+    }
+}
+
+static void ReadCurve(Deserializer& source, AnimationCurve& curve, bool vector)
+{
+    const unsigned numKeys = source.ReadUInt();
+    curve.times_.Resize(numKeys);
+    curve.values_.Resize(numKeys * 3);
+    source.Read(curve.times_.Buffer(), numKeys * sizeof(float));
+    if (vector)
+    {
+        curve.min_ = source.ReadVector3();
+        curve.step_ = source.ReadVector3();
+    }
+    source.Read(curve.values_.Buffer(), numKeys * 3 * sizeof(unsigned short));
+}
+
+static void WriteCurve(Serializer& dest, const AnimationCurve& curve, bool vector)
+{
+    dest.WriteUInt(curve.times_.Size());
+    dest.Write(curve.times_.Buffer(), curve.times_.Size() * sizeof(float));
+    if (vector)
+    {
+        dest.WriteVector3(curve.min_);
+        dest.WriteVector3(curve.step_);
+    }
+    dest.Write(curve.values_.Buffer(), curve.values_.Size() * sizeof(unsigned short));
+}
+
+bool AnimationCurve::GetKeyIndex(float time, unsigned& index) const
+{
+    if (times_.Empty())
+        return false;
+
+    if (time < 0.0f)
+        time = 0.0f;
+
+    if (index >= times_.Size())
+        index = times_.Size() - 1;
+
+    // Check for being too far ahead
+    while (index && time < times_[index])
+        --index;
+
+    // Check for being too far behind
+    while (index < times_.Size() - 1 && time >= times_[index + 1])
+        ++index;
+
+    return true;
+}
+
+Quaternion AnimationCurve::GetQuaternion(unsigned index) const
+{
+    const unsigned short* value = &values_[index * 3];
+    const float a = ((value[0] & 0x7fffu) * (2.0f / SMALLEST_THREE_STEPS) - 1.0f) * SMALLEST_THREE_RANGE;
+    const float b = ((value[1] & 0x7fffu) * (2.0f / SMALLEST_THREE_STEPS) - 1.0f) * SMALLEST_THREE_RANGE;
+    const float c = ((value[2] & 0x7fffu) * (2.0f / SMALLEST_THREE_STEPS) - 1.0f) * SMALLEST_THREE_RANGE;
+    const float largest = sqrtf(Max(1.0f - a * a - b * b - c * c, 0.0f));
+
+    switch ((value[0] >> 14u & 2u) | value[1] >> 15u)
+    {
+    case 0:
+        return Quaternion(largest, a, b, c);
+    case 1:
+        return Quaternion(a, largest, b, c);
+    case 2:
+        return Quaternion(a, b, largest, c);
+    default:
+        return Quaternion(a, b, c, largest);
+    }
+}
+
+Vector3 AnimationCurve::SampleVector3(float time, float length, bool looped, unsigned& index) const
+{
+    unsigned nextIndex;
+    float t;
+    if (!GetCurveInterpolation(*this, time, length, looped, index, nextIndex, t))
+        return GetVector3(index);
+    return GetVector3(index).Lerp(GetVector3(nextIndex), t);
+}
+
+Quaternion AnimationCurve::SampleQuaternion(float time, float length, bool looped, unsigned& index) const
+{
+    unsigned nextIndex;
+    float t;
+    if (!GetCurveInterpolation(*this, time, length, looped, index, nextIndex, t))
+        return GetQuaternion(index);
+    return InterpolateRotation(GetQuaternion(index), GetQuaternion(nextIndex), t);
+}
+
 void AnimationTrack::SetKeyFrame(unsigned index, const AnimationKeyFrame& keyFrame)
 {
     if (index < keyFrames_.Size())
@@ -111,9 +434,73 @@ bool AnimationTrack::GetKeyFrameIndex(float time, unsigned& index) const
     return true;
 }
 
+void AnimationTrack::Compress(float positionTolerance, float rotationTolerance, float scaleTolerance)
+{
+    // A track without keyframes or channels has nothing to sample
+    if (keyFrames_.Empty() || channelMask_ == CHANNEL_NONE)
+        return;
+
+    positionCurve_ = AnimationCurve();
+    rotationCurve_ = AnimationCurve();
+    scaleCurve_ = AnimationCurve();
+
+    if (channelMask_ & CHANNEL_POSITION)
+        CompressVectorCurve(positionCurve_, keyFrames_, &AnimationKeyFrame::position_, positionTolerance);
+    if (channelMask_ & CHANNEL_ROTATION)
+        CompressRotationCurve(rotationCurve_, keyFrames_, rotationTolerance);
+    if (channelMask_ & CHANNEL_SCALE)
+        CompressVectorCurve(scaleCurve_, keyFrames_, &AnimationKeyFrame::scale_, scaleTolerance);
+
+    keyFrames_.Clear();
+    keyFrames_.Compact();
+}
+
+void AnimationTrack::Decompress()
+{
+    if (!IsCompressed())
+        return;
+
+    // Keyframes are placed at the union of the channel key times
+    PODVector<float> times;
+    times.Push(positionCurve_.times_);
+    times.Push(rotationCurve_.times_);
+    times.Push(scaleCurve_.times_);
+    Sort(times.Begin(), times.End());
+
+    unsigned positionIndex = 0;
+    unsigned rotationIndex = 0;
+    unsigned scaleIndex = 0;
+    for (unsigned i = 0; i < times.Size(); ++i)
+    {
+        if (i && times[i] == times[i - 1])
+            continue;
+
+        AnimationKeyFrame keyFrame;
+        keyFrame.time_ = times[i];
+        if (positionCurve_.GetNumKeys())
+            keyFrame.position_ = positionCurve_.SampleVector3(times[i], 0.0f, false, positionIndex);
+        if (rotationCurve_.GetNumKeys())
+            keyFrame.rotation_ = rotationCurve_.SampleQuaternion(times[i], 0.0f, false, rotationIndex);
+        if (scaleCurve_.GetNumKeys())
+            keyFrame.scale_ = scaleCurve_.SampleVector3(times[i], 0.0f, false, scaleIndex);
+        keyFrames_.Push(keyFrame);
+    }
+
+    positionCurve_ = AnimationCurve();
+    rotationCurve_ = AnimationCurve();
+    scaleCurve_ = AnimationCurve();
+}
+
+unsigned AnimationTrack::GetMemoryUse() const
+{
+    return sizeof(AnimationTrack) + keyFrames_.Size() * sizeof(AnimationKeyFrame) + positionCurve_.GetMemoryUse() +
+        rotationCurve_.GetMemoryUse() + scaleCurve_.GetMemoryUse();
+}
+
 Animation::Animation(Context* context) :
     ResourceWithMetadata(context),
-    length_(0.f)
+    length_(0.f),
+    compressed_(false)
 {
 }
 
@@ -129,11 +516,13 @@ bool Animation::BeginLoad(Deserializer& source)
     unsigned memoryUse = sizeof(Animation);
 
     // Check ID
-    if (source.ReadFileID() != "UANI")
+    String fileID = source.ReadFileID();
+    if (fileID != "UANI" && fileID != "UANC")
     {
         URHO3D_LOGERROR(source.GetName() + " is not a valid animation file");
         return false;
     }
+    compressed_ = fileID == "UANC";
 
     // Read name and length
     animationName_ = source.ReadString();
@@ -150,6 +539,19 @@ bool Animation::BeginLoad(Deserializer& source)
         AnimationTrack* newTrack = CreateTrack(source.ReadString());
         newTrack->channelMask_ = AnimationChannelFlags(source.ReadUByte());
 
+        // Compressed tracks store a curve per channel
+        if (compressed_)
+        {
+            if (newTrack->channelMask_ & CHANNEL_POSITION)
+                ReadCurve(source, newTrack->positionCurve_, true);
+            if (newTrack->channelMask_ & CHANNEL_ROTATION)
+                ReadCurve(source, newTrack->rotationCurve_, false);
+            if (newTrack->channelMask_ & CHANNEL_SCALE)
+                ReadCurve(source, newTrack->scaleCurve_, true);
+            memoryUse += newTrack->GetMemoryUse() - sizeof(AnimationTrack);
+            continue;
+        }
+
         unsigned keyFrames = source.ReadUInt();
         newTrack->keyFrames_.Resize(keyFrames);
         memoryUse += keyFrames * sizeof(AnimationKeyFrame);
@@ -229,7 +631,7 @@ bool Animation::BeginLoad(Deserializer& source)
 bool Animation::Save(Serializer& dest) const
 {
     // Write ID, name and length
-    dest.WriteFileID("UANI");
+    dest.WriteFileID(compressed_ ? "UANC" : "UANI");
     dest.WriteString(animationName_);
     dest.WriteFloat(length_);
 
@@ -237,9 +639,33 @@ bool Animation::Save(Serializer& dest) const
     dest.WriteUInt(tracks_.Size());
     for (HashMap<StringHash, AnimationTrack>::ConstIterator i = tracks_.Begin(); i != tracks_.End(); ++i)
     {
-        const AnimationTrack& track = i->second_;
-        dest.WriteString(track.name_);
-        dest.WriteUByte(track.channelMask_);
+        dest.WriteString(i->second_.name_);
+        dest.WriteUByte(i->second_.channelMask_);
+
+        // Tracks that are not in the file format are converted through a copy, keeping every key
+        AnimationTrack converted;
+        const bool convert = compressed_ ? !i->second_.keyFrames_.Empty() : i->second_.IsCompressed();
+        if (convert)
+        {
+            converted = i->second_;
+            if (compressed_)
+                converted.Compress(0.0f, 0.0f, 0.0f);
+            else
+                converted.Decompress();
+        }
+        const AnimationTrack& track = convert ? converted : i->second_;
+
+        if (compressed_)
+        {
+            if (track.channelMask_ & CHANNEL_POSITION)
+                WriteCurve(dest, track.positionCurve_, true);
+            if (track.channelMask_ & CHANNEL_ROTATION)
+                WriteCurve(dest, track.rotationCurve_, false);
+            if (track.channelMask_ & CHANNEL_SCALE)
+                WriteCurve(dest, track.scaleCurve_, true);
+            continue;
+        }
+
         dest.WriteUInt(track.keyFrames_.Size());
 
         // Write keyframes of the track
@@ -380,12 +806,33 @@ SharedPtr<Animation> Animation::Clone(const String& cloneName) const
     ret->length_ = length_;
     ret->tracks_ = tracks_;
     ret->triggers_ = triggers_;
+    ret->compressed_ = compressed_;
     ret->CopyMetadata(*this);
     ret->SetMemoryUse(GetMemoryUse());
 
     return ret;
 }
 
+void Animation::Compress(float positionTolerance, float rotationTolerance, float scaleTolerance)
+{
+    URHO3D_PROFILE(CompressAnimation);
+
+    for (HashMap<StringHash, AnimationTrack>::Iterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+        i->second_.Compress(positionTolerance, rotationTolerance, scaleTolerance);
+
+    compressed_ = true;
+    UpdateMemoryUse();
+}
+
+void Animation::Decompress()
+{
+    for (HashMap<StringHash, AnimationTrack>::Iterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+        i->second_.Decompress();
+
+    compressed_ = false;
+    UpdateMemoryUse();
+}
+
 AnimationTrack* Animation::GetTrack(unsigned index)
 {
     if (index >= GetNumTracks())
@@ -420,4 +867,12 @@ AnimationTriggerPoint* Animation::GetTrigger(unsigned index)
     return index < triggers_.Size() ? &triggers_[index] : nullptr;
 }
 
+void Animation::UpdateMemoryUse()
+{
+    unsigned memoryUse = sizeof(Animation) + triggers_.Size() * sizeof(AnimationTriggerPoint);
+    for (HashMap<StringHash, AnimationTrack>::ConstIterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+        memoryUse += i->second_.GetMemoryUse();
+    SetMemoryUse(memoryUse);
+}
+
 }
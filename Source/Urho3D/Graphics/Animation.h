@@ -62,6 +62,38 @@ struct AnimationKeyFrame
     Vector3 scale_;
 };
 
+/// Compressed keyframe curve of a single animation channel. Key times and quantized values are kept in separate time-sorted arrays.
+struct URHO3D_API AnimationCurve
+{
+    /// Return key index based on time and previous index. Return false if curve is empty.
+    bool GetKeyIndex(float time, unsigned& index) const;
+    /// Return number of keys.
+    unsigned GetNumKeys() const { return times_.Size(); }
+    /// Return decoded position or scale key.
+    Vector3 GetVector3(unsigned index) const
+    {
+        const unsigned short* value = &values_[index * 3];
+        return Vector3(min_.x_ + step_.x_ * value[0], min_.y_ + step_.y_ * value[1], min_.z_ + step_.z_ * value[2]);
+    }
+    /// Return decoded rotation key.
+    Quaternion GetQuaternion(unsigned index) const;
+    /// Sample position or scale at time. Previous key index is used as the search start.
+    Vector3 SampleVector3(float time, float length, bool looped, unsigned& index) const;
+    /// Sample rotation at time. Previous key index is used as the search start. Close keys are interpolated with normalized lerp.
+    Quaternion SampleQuaternion(float time, float length, bool looped, unsigned& index) const;
+    /// Return memory use in bytes.
+    unsigned GetMemoryUse() const { return sizeof(AnimationCurve) + times_.Size() * sizeof(float) + values_.Size() * sizeof(unsigned short); }
+
+    /// Key times in ascending order.
+    PODVector<float> times_;
+    /// Quantized key values, three per key. Rotations are stored as the three smallest components, with the index of the omitted one in the top bits of the first two.
+    PODVector<unsigned short> values_;
+    /// Dequantization offset of position and scale keys.
+    Vector3 min_;
+    /// Dequantization step of position and scale keys.
+    Vector3 step_;
+};
+
 /// Skeletal animation track, stores keyframes of a single bone.
 /// @nocount
 struct URHO3D_API AnimationTrack
@@ -90,6 +122,16 @@ struct URHO3D_API AnimationTrack
     unsigned GetNumKeyFrames() const { return keyFrames_.Size(); }
     /// Return keyframe index based on time and previous index. Return false if animation is empty.
     bool GetKeyFrameIndex(float time, unsigned& index) const;
+    /// Compress keyframes into per-channel curves and release them. Tolerances are in world units for position and scale, and in degrees for rotation.
+    void Compress(float positionTolerance, float rotationTolerance, float scaleTolerance);
+    /// Decode the compressed curves back into keyframes.
+    void Decompress();
+    /// Return whether the track is stored as compressed curves.
+    bool IsCompressed() const { return keyFrames_.Empty() && (positionCurve_.times_.Size() || rotationCurve_.times_.Size() || scaleCurve_.times_.Size()); }
+    /// Return whether the track has no keyframes or curves to sample.
+    bool IsEmpty() const { return keyFrames_.Empty() && !IsCompressed(); }
+    /// Return memory use in bytes.
+    unsigned GetMemoryUse() const;
 
     /// Bone or scene node name.
     String name_;
@@ -97,8 +139,14 @@ struct URHO3D_API AnimationTrack
     StringHash nameHash_;
     /// Bitmask of included data (position, rotation, scale).
     AnimationChannelFlags channelMask_{};
-    /// Keyframes.
+    /// Keyframes. Empty when compressed.
     Vector<AnimationKeyFrame> keyFrames_;
+    /// Compressed position curve.
+    AnimationCurve positionCurve_;
+    /// Compressed rotation curve.
+    AnimationCurve rotationCurve_;
+    /// Compressed scale curve.
+    AnimationCurve scaleCurve_;
 };
 
 /// %Animation trigger point.
@@ -163,6 +211,10 @@ public:
     void SetNumTriggers(unsigned num);
     /// Clone the animation.
     SharedPtr<Animation> Clone(const String& cloneName = String::EMPTY) const;
+    /// Compress all tracks into quantized per-channel curves, dropping constant channels down to one key and keys that interpolation reproduces within the tolerances. Rotation tolerance is in degrees. This is unsafe if the animation is currently used in playback.
+    void Compress(float positionTolerance = 0.001f, float rotationTolerance = 0.05f, float scaleTolerance = 0.001f);
+    /// Decode compressed tracks back into keyframes for editing. This is unsafe if the animation is currently used in playback.
+    void Decompress();
 
     /// Return animation name.
     /// @property
@@ -201,7 +253,14 @@ public:
     /// Return a trigger point by index.
     AnimationTriggerPoint* GetTrigger(unsigned index);
 
+    /// Return whether the tracks are stored as compressed curves.
+    /// @property
+    bool IsCompressed() const { return compressed_; }
+
 private:
+    /// Recalculate memory use from the tracks and triggers.
+    void UpdateMemoryUse();
+
     /// Animation name.
     String animationName_;
     /// Animation name hash.
@@ -212,6 +271,8 @@ private:
     HashMap<StringHash, AnimationTrack> tracks_;
     /// Animation trigger points.
     Vector<AnimationTriggerPoint> triggers_;
+    /// Compressed flag.
+    bool compressed_;
 };
 
 }
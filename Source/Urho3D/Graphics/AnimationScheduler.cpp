@@ -0,0 +1,202 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
+#include "../Graphics/AnimatedModel.h"
+#include "../Graphics/AnimationScheduler.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Chunks per thread of the parallel pose evaluation, so that work stealing can even out the remaining imbalance.
+static const unsigned CHUNKS_PER_THREAD = 4;
+/// Weight of the latest measurement in the bone cost estimate.
+static const float BONE_COST_SMOOTHING = 0.25f;
+
+AnimationScheduler::AnimationScheduler() :
+    numQueued_(0),
+    farBudget_(0.0f),
+    boneCost_(0.0f),
+    numEvaluated_(0),
+    frameNumber_(M_MAX_UNSIGNED)
+{
+}
+
+AnimationScheduler::~AnimationScheduler()
+{
+    for (unsigned i = 0; i < deferred_.Size(); ++i)
+    {
+        if (deferred_[i])
+            deferred_[i]->animationScheduled_ = false;
+    }
+}
+
+void AnimationScheduler::Reserve(unsigned count)
+{
+    const unsigned numQueued = Min(numQueued_.load(std::memory_order_relaxed), queued_.Size());
+    numQueued_.store(numQueued, std::memory_order_relaxed);
+    queued_.Resize(numQueued + count);
+}
+
+bool AnimationScheduler::Queue(AnimatedModel* model, bool far)
+{
+    const unsigned index = numQueued_.fetch_add(1, std::memory_order_relaxed);
+    if (index >= queued_.Size())
+        return false;
+
+    queued_[index].model_ = model;
+    queued_[index].far_ = far;
+    return true;
+}
+
+void AnimationScheduler::Update(const FrameInfo& frame, WorkQueue* queue)
+{
+    if (frame.frameNumber_ != frameNumber_)
+        numEvaluated_ = 0;
+
+    // Far models go to the back of the deferred queue
+    models_.Clear();
+    const unsigned numQueued = Min(numQueued_.load(std::memory_order_relaxed), queued_.Size());
+    for (unsigned i = 0; i < numQueued; ++i)
+    {
+        AnimatedModel* model = queued_[i].model_;
+        if (queued_[i].far_)
+        {
+            model->animationScheduled_ = true;
+            deferred_.Push(WeakPtr<AnimatedModel>(model));
+        }
+        else
+            models_.Push(model);
+    }
+    queued_.Clear();
+    numQueued_.store(0, std::memory_order_relaxed);
+
+    // Take the most overdue far models once per frame, as long as their estimated cost fits the budget. Always take at least
+    // one so that the queue keeps moving
+    if (frame.frameNumber_ != frameNumber_)
+    {
+        frameNumber_ = frame.frameNumber_;
+
+        const float budget = farBudget_ * 1000.0f;
+        float cost = 0.0f;
+        unsigned numTaken = 0;
+        for (; numTaken < deferred_.Size(); ++numTaken)
+        {
+            AnimatedModel* model = deferred_[numTaken];
+            if (!model)
+                continue;
+
+            const float modelCost = boneCost_ * model->GetSkeleton().GetNumBones();
+            if (budget > 0.0f && cost > 0.0f && cost + modelCost > budget)
+                break;
+
+            cost += modelCost;
+            model->animationScheduled_ = false;
+            models_.Push(model);
+        }
+
+        deferred_.Erase(0, numTaken);
+    }
+
+    Evaluate(queue);
+}
+
+void AnimationScheduler::SetFarBudget(float budget)
+{
+    farBudget_ = Max(budget, 0.0f);
+}
+
+void AnimationScheduler::Evaluate(WorkQueue* queue)
+{
+    // Models may have been evaluated from the main thread or removed while deferred. The scheduled flag also guards against
+    // evaluating a model twice in parallel
+    unsigned numModels = 0;
+    for (unsigned i = 0; i < models_.Size(); ++i)
+    {
+        AnimatedModel* model = models_[i];
+        if (!model->animationScheduled_ && model->GetOctant() && model->IsPoseBufferActive() &&
+            (model->animationDirty_ || model->animationOrderDirty_))
+        {
+            model->animationScheduled_ = true;
+            models_[numModels++] = model;
+        }
+    }
+    models_.Resize(numModels);
+    if (models_.Empty())
+        return;
+
+    boneOffsets_.Resize(numModels + 1);
+    boneOffsets_[0] = 0;
+    for (unsigned i = 0; i < numModels; ++i)
+        boneOffsets_[i + 1] = boneOffsets_[i] + Max(models_[i]->GetSkeleton().GetNumBones(), 1u);
+    const unsigned numBones = boneOffsets_.Back();
+
+    HiresTimer timer;
+
+    // Each chunk evaluates the models whose bones start within its share of the total bone count
+    const unsigned numChunks = Min(numModels, (queue->GetNumThreads() + 1) * CHUNKS_PER_THREAD);
+    queue->ParallelFor(numChunks, 1, [this, numChunks, numBones](unsigned begin, unsigned end, unsigned /*threadIndex*/)
+    {
+        const unsigned first = FindModel((unsigned)((unsigned long long)numBones * begin / numChunks));
+        const unsigned last = FindModel((unsigned)((unsigned long long)numBones * end / numChunks));
+        for (unsigned i = first; i < last; ++i)
+            models_[i]->EvaluatePose();
+    });
+
+    const float measuredCost = (float)timer.GetUSec(false) / numBones;
+    boneCost_ = boneCost_ > 0.0f ? Lerp(boneCost_, measuredCost, BONE_COST_SMOOTHING) : measuredCost;
+
+    // Scene nodes are written only from the main thread
+    for (unsigned i = 0; i < numModels; ++i)
+    {
+        models_[i]->FinishPose();
+        models_[i]->animationScheduled_ = false;
+    }
+
+    numEvaluated_ += numModels;
+}
+
+unsigned AnimationScheduler::FindModel(unsigned boneOffset) const
+{
+    unsigned first = 0;
+    unsigned count = models_.Size();
+    while (count)
+    {
+        const unsigned step = count / 2;
+        if (boneOffsets_[first + step] < boneOffset)
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+            count = step;
+    }
+    return first;
+}
+
+}
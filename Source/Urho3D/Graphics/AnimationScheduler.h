@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../Container/Vector.h"
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+class AnimatedModel;
+class WorkQueue;
+struct FrameInfo;
+
+/// Evaluates the pose buffers of animated models in parallel after the octree's drawable update, without touching scene nodes from the worker threads. Work is split by bone count. Models on a far animation LOD are amortized over frames within a time budget, most overdue first.
+class URHO3D_API AnimationScheduler
+{
+public:
+    /// Construct.
+    AnimationScheduler();
+    /// Destruct.
+    ~AnimationScheduler();
+
+    /// Reserve room for models queued by the following drawable updates. Call from the main thread before the updates.
+    void Reserve(unsigned count);
+    /// Queue a model for pose evaluation. Far models may be deferred to later frames. Safe to call from worker threads within the reserved room. Return false if there is no room.
+    bool Queue(AnimatedModel* model, bool far);
+    /// Evaluate the queued poses and, once per frame, the deferred ones that fit the budget. Then write bone nodes from the main thread.
+    void Update(const FrameInfo& frame, WorkQueue* queue);
+    /// Set time budget in milliseconds for evaluating far models per frame. Zero is unlimited.
+    void SetFarBudget(float budget);
+
+    /// Return time budget in milliseconds for evaluating far models per frame.
+    float GetFarBudget() const { return farBudget_; }
+
+    /// Return whether models are queued for the next update.
+    bool HasQueued() const { return numQueued_.load(std::memory_order_relaxed) > 0; }
+
+    /// Return number of models evaluated on the last frame.
+    unsigned GetNumEvaluated() const { return numEvaluated_; }
+
+    /// Return number of far models waiting for evaluation.
+    unsigned GetNumDeferred() const { return deferred_.Size(); }
+
+    /// Return estimated evaluation time per bone in microseconds, measured over all worker threads.
+    float GetBoneCost() const { return boneCost_; }
+
+private:
+    /// Queued model entry.
+    struct QueuedModel
+    {
+        /// Model.
+        AnimatedModel* model_;
+        /// Far animation LOD flag.
+        bool far_;
+    };
+
+    /// Evaluate the selected models in parallel, in chunks of about equal bone count, then finish them in the main thread.
+    void Evaluate(WorkQueue* queue);
+    /// Return index of the first selected model whose bones start at or after the given bone offset.
+    unsigned FindModel(unsigned boneOffset) const;
+
+    /// Models queued by the drawable update.
+    PODVector<QueuedModel> queued_;
+    /// Number of queued models. May exceed the reserved room, in which case the extra models were refused.
+    std::atomic<unsigned> numQueued_;
+    /// Far models waiting for evaluation, oldest first.
+    Vector<WeakPtr<AnimatedModel> > deferred_;
+    /// Models selected for evaluation.
+    PODVector<AnimatedModel*> models_;
+    /// Bone offsets of the selected models, with the total bone count last.
+    PODVector<unsigned> boneOffsets_;
+    /// Time budget for far models in milliseconds.
+    float farBudget_;
+    /// Estimated evaluation time per bone in microseconds.
+    float boneCost_;
+    /// Number of models evaluated on the last frame.
+    unsigned numEvaluated_;
+    /// Frame number deferred models were last taken on.
+    unsigned frameNumber_;
+};
+
+}
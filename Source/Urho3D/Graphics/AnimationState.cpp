@@ -36,8 +36,10 @@ namespace Urho3D
 AnimationStateTrack::AnimationStateTrack() :
     track_(nullptr),
     bone_(nullptr),
+    boneIndex_(M_MAX_UNSIGNED),
     weight_(1.0f),
-    keyFrame_(0)
+    keyFrame_(0),
+    curveKeys_{}
 {
 }
 
@@ -149,6 +151,7 @@ void AnimationState::SetStartBone(Bone* startBone)
         if (trackBone && trackBone->node_)
         {
             stateTrack.bone_ = trackBone;
+            stateTrack.boneIndex_ = skeleton.GetBoneIndex(trackBone);
             stateTrack.node_ = trackBone->node_;
             stateTracks_.Push(stateTrack);
         }
@@ -447,7 +450,12 @@ void AnimationState::Apply()
         return;
 
     if (model_)
-        ApplyToModel();
+    {
+        if (model_->IsPoseBufferActive())
+            ApplyToPose(model_->pose_);
+        else
+            ApplyToModel();
+    }
     else
         ApplyToNodes();
 }
@@ -467,6 +475,22 @@ void AnimationState::ApplyToModel()
     }
 }
 
+void AnimationState::ApplyToPose(PODVector<BonePose>& pose)
+{
+    for (Vector<AnimationStateTrack>::Iterator i = stateTracks_.Begin(); i != stateTracks_.End(); ++i)
+    {
+        AnimationStateTrack& stateTrack = *i;
+        float finalWeight = weight_ * stateTrack.weight_;
+
+        // Do not apply if zero effective weight or the bone has animation disabled
+        if (Equals(finalWeight, 0.0f) || !stateTrack.bone_->animated_ || stateTrack.boneIndex_ >= pose.Size() ||
+            stateTrack.track_->IsEmpty())
+            continue;
+
+        BlendTrack(stateTrack, finalWeight, pose[stateTrack.boneIndex_]);
+    }
+}
+
 void AnimationState::ApplyToNodes()
 {
     // When applying to a node hierarchy, can only use full weight (nothing to blend to)
@@ -479,9 +503,41 @@ void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, b
     const AnimationTrack* track = stateTrack.track_;
     Node* node = stateTrack.node_;
 
-    if (track->keyFrames_.Empty() || !node)
+    if (track->IsEmpty() || !node)
         return;
 
+    BonePose pose;
+    pose.position_ = node->GetPosition();
+    pose.rotation_ = node->GetRotation();
+    pose.scale_ = node->GetScale();
+    BlendTrack(stateTrack, weight, pose);
+
+    const AnimationChannelFlags channelMask = track->channelMask_;
+    if (silent)
+    {
+        if (channelMask & CHANNEL_POSITION)
+            node->SetPositionSilent(pose.position_);
+        if (channelMask & CHANNEL_ROTATION)
+            node->SetRotationSilent(pose.rotation_);
+        if (channelMask & CHANNEL_SCALE)
+            node->SetScaleSilent(pose.scale_);
+    }
+    else
+    {
+        if (channelMask & CHANNEL_POSITION)
+            node->SetPosition(pose.position_);
+        if (channelMask & CHANNEL_ROTATION)
+            node->SetRotation(pose.rotation_);
+        if (channelMask & CHANNEL_SCALE)
+            node->SetScale(pose.scale_);
+    }
+}
+
+void AnimationState::SampleKeyFrames(AnimationStateTrack& stateTrack, Vector3& newPosition, Quaternion& newRotation,
+    Vector3& newScale)
+{
+    const AnimationTrack* track = stateTrack.track_;
+
     unsigned& frame = stateTrack.keyFrame_;
     track->GetKeyFrameIndex(time_, frame);
 
@@ -502,10 +558,6 @@ void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, b
     const AnimationKeyFrame* keyFrame = &track->keyFrames_[frame];
     const AnimationChannelFlags channelMask = track->channelMask_;
 
-    Vector3 newPosition;
-    Quaternion newRotation;
-    Vector3 newScale;
-
     if (interpolate)
     {
         const AnimationKeyFrame* nextKeyFrame = &track->keyFrames_[nextFrame];
@@ -530,25 +582,49 @@ void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, b
         if (channelMask & CHANNEL_SCALE)
             newScale = keyFrame->scale_;
     }
+}
+
+void AnimationState::BlendTrack(AnimationStateTrack& stateTrack, float weight, BonePose& pose)
+{
+    const AnimationTrack* track = stateTrack.track_;
+    const AnimationChannelFlags channelMask = track->channelMask_;
+
+    Vector3 newPosition;
+    Quaternion newRotation;
+    Vector3 newScale;
+
+    if (track->IsCompressed())
+    {
+        // Each channel curve has its own keys and search cursor
+        const float length = animation_->GetLength();
+        if (channelMask & CHANNEL_POSITION)
+            newPosition = track->positionCurve_.SampleVector3(time_, length, looped_, stateTrack.curveKeys_[0]);
+        if (channelMask & CHANNEL_ROTATION)
+            newRotation = track->rotationCurve_.SampleQuaternion(time_, length, looped_, stateTrack.curveKeys_[1]);
+        if (channelMask & CHANNEL_SCALE)
+            newScale = track->scaleCurve_.SampleVector3(time_, length, looped_, stateTrack.curveKeys_[2]);
+    }
+    else
+        SampleKeyFrames(stateTrack, newPosition, newRotation, newScale);
 
     if (blendingMode_ == ABM_ADDITIVE) // not ABM_LERP
     {
         if (channelMask & CHANNEL_POSITION)
         {
             Vector3 delta = newPosition - stateTrack.bone_->initialPosition_;
-            newPosition = node->GetPosition() + delta * weight;
+            newPosition = pose.position_ + delta * weight;
         }
         if (channelMask & CHANNEL_ROTATION)
         {
             Quaternion delta = newRotation * stateTrack.bone_->initialRotation_.Inverse();
-            newRotation = (delta * node->GetRotation()).Normalized();
+            newRotation = (delta * pose.rotation_).Normalized();
             if (!Equals(weight, 1.0f))
-                newRotation = node->GetRotation().Slerp(newRotation, weight);
+                newRotation = pose.rotation_.Slerp(newRotation, weight);
         }
         if (channelMask & CHANNEL_SCALE)
         {
             Vector3 delta = newScale - stateTrack.bone_->initialScale_;
-            newScale = node->GetScale() + delta * weight;
+            newScale = pose.scale_ + delta * weight;
         }
     }
     else
@@ -556,32 +632,20 @@ void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, b
         if (!Equals(weight, 1.0f)) // not full weight
         {
             if (channelMask & CHANNEL_POSITION)
-                newPosition = node->GetPosition().Lerp(newPosition, weight);
+                newPosition = pose.position_.Lerp(newPosition, weight);
             if (channelMask & CHANNEL_ROTATION)
-                newRotation = node->GetRotation().Slerp(newRotation, weight);
+                newRotation = pose.rotation_.Slerp(newRotation, weight);
             if (channelMask & CHANNEL_SCALE)
-                newScale = node->GetScale().Lerp(newScale, weight);
+                newScale = pose.scale_.Lerp(newScale, weight);
         }
     }
 
-    if (silent)
-    {
-        if (channelMask & CHANNEL_POSITION)
-            node->SetPositionSilent(newPosition);
-        if (channelMask & CHANNEL_ROTATION)
-            node->SetRotationSilent(newRotation);
-        if (channelMask & CHANNEL_SCALE)
-            node->SetScaleSilent(newScale);
-    }
-    else
-    {
-        if (channelMask & CHANNEL_POSITION)
-            node->SetPosition(newPosition);
-        if (channelMask & CHANNEL_ROTATION)
-            node->SetRotation(newRotation);
-        if (channelMask & CHANNEL_SCALE)
-            node->SetScale(newScale);
-    }
+    if (channelMask & CHANNEL_POSITION)
+        pose.position_ = newPosition;
+    if (channelMask & CHANNEL_ROTATION)
+        pose.rotation_ = newRotation;
+    if (channelMask & CHANNEL_SCALE)
+        pose.scale_ = newScale;
 }
 
 }
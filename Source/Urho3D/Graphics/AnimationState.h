@@ -37,6 +37,7 @@ class Serializer;
 class Skeleton;
 struct AnimationTrack;
 struct Bone;
+struct BonePose;
 
 /// %Animation blending mode.
 enum AnimationBlendMode
@@ -59,12 +60,16 @@ struct AnimationStateTrack
     const AnimationTrack* track_;
     /// Bone pointer.
     Bone* bone_;
+    /// Bone index in the skeleton.
+    unsigned boneIndex_;
     /// Scene node pointer.
     WeakPtr<Node> node_;
     /// Blending weight.
     float weight_;
     /// Last key frame.
     unsigned keyFrame_;
+    /// Last keys of the compressed position, rotation and scale curves.
+    unsigned curveKeys_[3];
 };
 
 /// %Animation instance.
@@ -168,10 +173,16 @@ public:
 private:
     /// Apply animation to a skeleton. Transform changes are applied silently, so the model needs to dirty its root model afterward.
     void ApplyToModel();
+    /// Apply animation to the model's pose buffer, without touching the bone nodes.
+    void ApplyToPose(PODVector<BonePose>& pose);
     /// Apply animation to a scene node hierarchy.
     void ApplyToNodes();
     /// Apply track.
     void ApplyTrack(AnimationStateTrack& stateTrack, float weight, bool silent);
+    /// Sample uncompressed track keyframes at the current time position.
+    void SampleKeyFrames(AnimationStateTrack& stateTrack, Vector3& newPosition, Quaternion& newRotation, Vector3& newScale);
+    /// Sample track at the current time position and blend it into a bone transform.
+    void BlendTrack(AnimationStateTrack& stateTrack, float weight, BonePose& pose);
 
     /// Animated model (model mode).
     WeakPtr<AnimatedModel> model_;
@@ -26,6 +26,7 @@
 #include "../Graphics/Geometry.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/GraphicsImpl.h"
+#include "../Graphics/LightClusters.h"
 #include "../Graphics/Material.h"
 #include "../Graphics/Renderer.h"
 #include "../Graphics/ShaderVariation.h"
@@ -40,6 +41,11 @@
 namespace Urho3D
 {
 
+inline bool IsInstanced(GeometryType type)
+{
+    return type == GEOM_INSTANCED || type == GEOM_SKINNED_INSTANCED || type == GEOM_BILLBOARD_INSTANCED;
+}
+
 inline bool CompareBatchesState(Batch* lhs, Batch* rhs)
 {
     if (lhs->renderOrder_ != rhs->renderOrder_)
@@ -80,6 +86,61 @@ inline bool CompareBatchGroupOrder(BatchGroup* lhs, BatchGroup* rhs)
     return lhs->renderOrder_ < rhs->renderOrder_;
 }
 
+/// Below this many elements comparison sorting is faster than radix sorting.
+static const unsigned RADIXSORT_THRESHOLD = 64;
+
+/// Return radix sort key for render order and distance.
+inline unsigned long long GetDistanceSortKey(const Batch* batch, bool backToFront)
+{
+    const unsigned distanceKey = FloatToRadixKey(batch->distance_);
+    return (unsigned long long)batch->renderOrder_ << 32u | (backToFront ? ~distanceKey : distanceKey);
+}
+
+/// Radix sort batches by render order and distance, and by state when the distance is equal.
+void RadixSortBatchesByDistance(Batch** batches, unsigned count, bool backToFront, PODVector<RadixSortItem<Batch*> >& items,
+    PODVector<RadixSortItem<Batch*> >& temp)
+{
+    items.Resize(count);
+    temp.Resize(count);
+
+    // Each pass keeps the order of equal keys, so sort by the least significant key first
+    for (unsigned i = 0; i < count; ++i)
+    {
+        items[i].key_ = batches[i]->sortKey_;
+        items[i].value_ = batches[i];
+    }
+    RadixSort(items.Buffer(), temp.Buffer(), count);
+
+    for (unsigned i = 0; i < count; ++i)
+        items[i].key_ = GetDistanceSortKey(items[i].value_, backToFront);
+    RadixSort(items.Buffer(), temp.Buffer(), count, 5);
+
+    for (unsigned i = 0; i < count; ++i)
+        batches[i] = items[i].value_;
+}
+
+/// Radix sort batches by render order and state. Batches with the same state keep their order, which is expected to be front to back.
+void RadixSortBatchesByState(Batch** batches, unsigned count, PODVector<RadixSortItem<Batch*> >& items,
+    PODVector<RadixSortItem<Batch*> >& temp)
+{
+    items.Resize(count);
+    temp.Resize(count);
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        items[i].key_ = batches[i]->sortKey_;
+        items[i].value_ = batches[i];
+    }
+    RadixSort(items.Buffer(), temp.Buffer(), count);
+
+    for (unsigned i = 0; i < count; ++i)
+        items[i].key_ = items[i].value_->renderOrder_;
+    RadixSort(items.Buffer(), temp.Buffer(), count, 1);
+
+    for (unsigned i = 0; i < count; ++i)
+        batches[i] = items[i].value_;
+}
+
 void CalculateShadowMatrix(Matrix4& dest, LightBatchQueue* queue, unsigned split, Renderer* renderer)
 {
     Camera* shadowCamera = queue->shadowSplits_[split].shadowCamera_;
@@ -631,21 +692,78 @@ void Batch::Prepare(View* view, Camera* camera, bool setModelTransform, bool all
             graphics->SetTexture(TU_LIGHTSHAPE, shapeTexture);
         }
     }
+#ifdef DESKTOP_GRAPHICS
+    // Passes which shade the clustered lights use the light ramp unit for the light cluster texture
+    else if (graphics->HasTextureUnit(TU_LIGHTCLUSTERS))
+    {
+        LightClusters* lightClusters = view->GetLightClusters();
+        if (lightClusters)
+            graphics->SetTexture(TU_LIGHTCLUSTERS, lightClusters->GetTexture());
+    }
+#endif
 }
 
 void Batch::Draw(View* view, Camera* camera, bool allowDepthWrite) const
 {
     if (!geometry_->IsEmpty())
     {
+        // Instanced billboards have no geometry of their own, so they are drawn as instances even when not grouped
+        if (geometryType_ == GEOM_BILLBOARD_INSTANCED)
+        {
+            if (startIndex_ != M_MAX_UNSIGNED && view->GetRenderer()->GetInstancingBuffer())
+                DrawInstanced(view, camera, allowDepthWrite, numWorldTransforms_);
+            return;
+        }
+
         Prepare(view, camera, true, allowDepthWrite);
         geometry_->Draw(view->GetGraphics());
     }
 }
 
-void BatchGroup::SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex)
+void Batch::DrawInstanced(View* view, Camera* camera, bool allowDepthWrite, unsigned numInstances) const
+{
+    Graphics* graphics = view->GetGraphics();
+    Renderer* renderer = view->GetRenderer();
+
+    Prepare(view, camera, false, allowDepthWrite);
+
+    // Instanced billboards always face the camera
+    if (geometryType_ == GEOM_BILLBOARD_INSTANCED && graphics->NeedParameterUpdate(SP_OBJECT, camera))
+        graphics->SetShaderParameter(VSP_BILLBOARDROT, camera->GetNode()->GetWorldRotation().RotationMatrix());
+
+#ifdef DESKTOP_GRAPHICS
+    // The skin matrix unit is shared with the depth buffer, so restore the unit's texture after drawing
+    Texture* previousTexture = nullptr;
+    if (geometryType_ == GEOM_SKINNED_INSTANCED)
+    {
+        previousTexture = graphics->GetTexture(TU_SKINMATRICES);
+        graphics->SetTexture(TU_SKINMATRICES, renderer->GetSkinMatrixTexture());
+    }
+#endif
+
+    // Get the geometry vertex buffers, then add the instancing stream buffer
+    // Hack: use a const_cast to avoid dynamic allocation of new temp vectors
+    auto& vertexBuffers = const_cast<Vector<SharedPtr<VertexBuffer> >&>(geometry_->GetVertexBuffers());
+    vertexBuffers.Push(SharedPtr<VertexBuffer>(renderer->GetInstancingBuffer()));
+
+    graphics->SetIndexBuffer(geometry_->GetIndexBuffer());
+    graphics->SetVertexBuffers(vertexBuffers, startIndex_);
+    graphics->DrawInstanced(geometry_->GetPrimitiveType(), geometry_->GetIndexStart(), geometry_->GetIndexCount(),
+        geometry_->GetVertexStart(), geometry_->GetVertexCount(), numInstances);
+
+    // Remove the instancing buffer & element mask now
+    vertexBuffers.Pop();
+
+#ifdef DESKTOP_GRAPHICS
+    if (previousTexture)
+        graphics->SetTexture(TU_SKINMATRICES, previousTexture);
+#endif
+}
+
+void BatchGroup::SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex, PODVector<Matrix3x4>& skinMatrices)
 {
     // Do not use up buffer space if not going to draw as instanced
-    if (geometryType_ != GEOM_INSTANCED)
+    if (!IsInstanced(geometryType_))
         return;
 
     startIndex_ = freeIndex;
@@ -655,7 +773,20 @@ void BatchGroup::SetInstancingData(void* lockedData, unsigned stride, unsigned&
     {
         const InstanceData& instance = instances_[i];
 
-        memcpy(buffer, instance.worldTransform_, sizeof(Matrix3x4));
+        if (geometryType_ == GEOM_SKINNED_INSTANCED)
+        {
+            // Skin matrices already contain the world transform, so only store where they start in the skin matrix texture
+            Matrix3x4 instanceTransform(Matrix3x4::ZERO);
+            instanceTransform.m00_ = (float)(skinMatrices.Size() * 3);
+            memcpy(buffer, &instanceTransform, sizeof(Matrix3x4));
+
+            unsigned first = skinMatrices.Size();
+            skinMatrices.Resize(first + numWorldTransforms_);
+            memcpy(&skinMatrices[first], instance.worldTransform_, numWorldTransforms_ * sizeof(Matrix3x4));
+        }
+        else
+            memcpy(buffer, instance.worldTransform_, sizeof(Matrix3x4));
+
         if (instance.instancingData_)
             memcpy(buffer + sizeof(Matrix3x4), instance.instancingData_, stride - sizeof(Matrix3x4));
 
@@ -674,8 +805,12 @@ void BatchGroup::Draw(View* view, Camera* camera, bool allowDepthWrite) const
     {
         // Draw as individual objects if instancing not supported or could not fill the instancing buffer
         VertexBuffer* instanceBuffer = renderer->GetInstancingBuffer();
-        if (!instanceBuffer || geometryType_ != GEOM_INSTANCED || startIndex_ == M_MAX_UNSIGNED)
+        if (!instanceBuffer || !IsInstanced(geometryType_) || startIndex_ == M_MAX_UNSIGNED)
         {
+            // Instanced billboards can not be drawn individually
+            if (geometryType_ == GEOM_BILLBOARD_INSTANCED)
+                return;
+
             Batch::Prepare(view, camera, false, allowDepthWrite);
 
             graphics->SetIndexBuffer(geometry_->GetIndexBuffer());
@@ -684,30 +819,22 @@ void BatchGroup::Draw(View* view, Camera* camera, bool allowDepthWrite) const
             for (unsigned i = 0; i < instances_.Size(); ++i)
             {
                 if (graphics->NeedParameterUpdate(SP_OBJECT, instances_[i].worldTransform_))
-                    graphics->SetShaderParameter(VSP_MODEL, *instances_[i].worldTransform_);
+                {
+                    if (geometryType_ == GEOM_SKINNED)
+                    {
+                        graphics->SetShaderParameter(VSP_SKINMATRICES, reinterpret_cast<const float*>(instances_[i].worldTransform_),
+                            12 * numWorldTransforms_);
+                    }
+                    else
+                        graphics->SetShaderParameter(VSP_MODEL, *instances_[i].worldTransform_);
+                }
 
                 graphics->Draw(geometry_->GetPrimitiveType(), geometry_->GetIndexStart(), geometry_->GetIndexCount(),
                     geometry_->GetVertexStart(), geometry_->GetVertexCount());
             }
         }
         else
-        {
-            Batch::Prepare(view, camera, false, allowDepthWrite);
-
-            // Get the geometry vertex buffers, then add the instancing stream buffer
-            // Hack: use a const_cast to avoid dynamic allocation of new temp vectors
-            auto& vertexBuffers = const_cast<Vector<SharedPtr<VertexBuffer> >&>(
-                geometry_->GetVertexBuffers());
-            vertexBuffers.Push(SharedPtr<VertexBuffer>(instanceBuffer));
-
-            graphics->SetIndexBuffer(geometry_->GetIndexBuffer());
-            graphics->SetVertexBuffers(vertexBuffers, startIndex_);
-            graphics->DrawInstanced(geometry_->GetPrimitiveType(), geometry_->GetIndexStart(), geometry_->GetIndexCount(),
-                geometry_->GetVertexStart(), geometry_->GetVertexCount(), instances_.Size());
-
-            // Remove the instancing buffer & element mask now
-            vertexBuffers.Pop();
-        }
+            DrawInstanced(view, camera, allowDepthWrite, instances_.Size());
     }
 }
 
@@ -722,9 +849,49 @@ void BatchQueue::Clear(int maxSortedInstances)
     batches_.Clear();
     sortedBatches_.Clear();
     batchGroups_.Clear();
+    lastGroup_ = nullptr;
     maxSortedInstances_ = (unsigned)maxSortedInstances;
 }
 
+void BatchQueue::ClearInstances(int maxSortedInstances)
+{
+    batches_.Clear();
+    sortedBatches_.Clear();
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+        i->second_.instances_.Clear();
+    maxSortedInstances_ = (unsigned)maxSortedInstances;
+}
+
+void BatchQueue::RemoveEmptyGroups()
+{
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End();)
+    {
+        if (i->second_.instances_.Empty())
+        {
+            i = batchGroups_.Erase(i);
+            lastGroup_ = nullptr;
+        }
+        else
+            ++i;
+    }
+}
+
+BatchGroup& BatchQueue::GetGroup(const BatchGroupKey& key)
+{
+    // Consecutive batches often go to the same group, so check the previous one before hashing
+    if (lastGroup_ && key == lastGroupKey_)
+        return *lastGroup_;
+
+    FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Find(key);
+    if (i == batchGroups_.End())
+        i = batchGroups_.Insert(MakePair(key, BatchGroup()));
+
+    // Inserting may have rehashed, so remember only the group just found or created
+    lastGroupKey_ = key;
+    lastGroup_ = &i->second_;
+    return i->second_;
+}
+
 void BatchQueue::SortBackToFront()
 {
     sortedBatches_.Resize(batches_.Size());
@@ -732,15 +899,33 @@ void BatchQueue::SortBackToFront()
     for (unsigned i = 0; i < batches_.Size(); ++i)
         sortedBatches_[i] = &batches_[i];
 
-    Sort(sortedBatches_.Begin(), sortedBatches_.End(), CompareBatchesBackToFront);
+    if (sortedBatches_.Size() < RADIXSORT_THRESHOLD)
+        Sort(sortedBatches_.Begin(), sortedBatches_.End(), CompareBatchesBackToFront);
+    else
+        RadixSortBatchesByDistance(sortedBatches_.Buffer(), sortedBatches_.Size(), true, sortItems_, sortTemp_);
 
     sortedBatchGroups_.Resize(batchGroups_.Size());
 
     unsigned index = 0;
-    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
         sortedBatchGroups_[index++] = &i->second_;
 
-    Sort(sortedBatchGroups_.Begin(), sortedBatchGroups_.End(), CompareBatchGroupOrder);
+    if (sortedBatchGroups_.Size() < RADIXSORT_THRESHOLD)
+        Sort(sortedBatchGroups_.Begin(), sortedBatchGroups_.End(), CompareBatchGroupOrder);
+    else
+    {
+        const unsigned count = sortedBatchGroups_.Size();
+        sortItems_.Resize(count);
+        sortTemp_.Resize(count);
+        for (unsigned i = 0; i < count; ++i)
+        {
+            sortItems_[i].key_ = sortedBatchGroups_[i]->renderOrder_;
+            sortItems_[i].value_ = sortedBatchGroups_[i];
+        }
+        RadixSort(sortItems_.Buffer(), sortTemp_.Buffer(), count, 1);
+        for (unsigned i = 0; i < count; ++i)
+            sortedBatchGroups_[i] = static_cast<BatchGroup*>(sortItems_[i].value_);
+    }
 }
 
 void BatchQueue::SortFrontToBack()
@@ -753,11 +938,11 @@ void BatchQueue::SortFrontToBack()
     SortFrontToBack2Pass(sortedBatches_);
 
     // Sort each group front to back
-    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
     {
         if (i->second_.instances_.Size() <= maxSortedInstances_)
         {
-            Sort(i->second_.instances_.Begin(), i->second_.instances_.End(), CompareInstancesFrontToBack);
+            SortInstancesFrontToBack(i->second_.instances_);
             if (i->second_.instances_.Size())
                 i->second_.distance_ = i->second_.instances_[0].distance_;
         }
@@ -773,7 +958,7 @@ void BatchQueue::SortFrontToBack()
     sortedBatchGroups_.Resize(batchGroups_.Size());
 
     unsigned index = 0;
-    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
         sortedBatchGroups_[index++] = &i->second_;
 
     SortFrontToBack2Pass(reinterpret_cast<PODVector<Batch*>& >(sortedBatchGroups_));
@@ -784,10 +969,20 @@ void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
     // Mobile devices likely use a tiled deferred approach, with which front-to-back sorting is irrelevant. The 2-pass
     // method is also time consuming, so just sort with state having priority
 #ifdef GL_ES_VERSION_2_0
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
+    if (batches.Size() < RADIXSORT_THRESHOLD)
+        Sort(batches.Begin(), batches.End(), CompareBatchesState);
+    else
+    {
+        RadixSortBatchesByDistance(batches.Buffer(), batches.Size(), false, sortItems_, sortTemp_);
+        RadixSortBatchesByState(batches.Buffer(), batches.Size(), sortItems_, sortTemp_);
+    }
 #else
     // For desktop, first sort by distance and remap shader/material/geometry IDs in the sort key
-    Sort(batches.Begin(), batches.End(), CompareBatchesFrontToBack);
+    const bool useRadixSort = batches.Size() >= RADIXSORT_THRESHOLD;
+    if (useRadixSort)
+        RadixSortBatchesByDistance(batches.Buffer(), batches.Size(), false, sortItems_, sortTemp_);
+    else
+        Sort(batches.Begin(), batches.End(), CompareBatchesFrontToBack);
 
     unsigned freeShaderID = 0;
     unsigned short freeMaterialID = 0;
@@ -834,15 +1029,68 @@ void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
     materialRemapping_.Clear();
     geometryRemapping_.Clear();
 
-    // Finally sort again with the rewritten ID's
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
+    // Finally sort again with the rewritten ID's. Radix sort keeps the distance order of batches with the same state
+    if (useRadixSort)
+        RadixSortBatchesByState(batches.Buffer(), batches.Size(), sortItems_, sortTemp_);
+    else
+        Sort(batches.Begin(), batches.End(), CompareBatchesState);
 #endif
 }
 
-void BatchQueue::SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex)
+void BatchQueue::SortInstancesFrontToBack(PODVector<InstanceData>& instances)
+{
+    const unsigned count = instances.Size();
+    if (count < RADIXSORT_THRESHOLD)
+    {
+        Sort(instances.Begin(), instances.End(), CompareInstancesFrontToBack);
+        return;
+    }
+
+    instanceSortItems_.Resize(count);
+    instanceSortTemp_.Resize(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        instanceSortItems_[i].key_ = FloatToRadixKey(instances[i].distance_);
+        instanceSortItems_[i].value_ = instances[i];
+    }
+    RadixSort(instanceSortItems_.Buffer(), instanceSortTemp_.Buffer(), count, 4);
+    for (unsigned i = 0; i < count; ++i)
+        instances[i] = instanceSortItems_[i].value_;
+}
+
+void BatchQueue::SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex, PODVector<Matrix3x4>& skinMatrices)
+{
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+        i->second_.SetInstancingData(lockedData, stride, freeIndex, skinMatrices);
+
+    for (PODVector<Batch>::Iterator i = batches_.Begin(); i != batches_.End(); ++i)
+    {
+        if (i->geometryType_ != GEOM_BILLBOARD_INSTANCED)
+            continue;
+
+        i->startIndex_ = freeIndex;
+        unsigned char* buffer = static_cast<unsigned char*>(lockedData) + freeIndex * stride;
+        for (unsigned j = 0; j < i->numWorldTransforms_; ++j)
+        {
+            memcpy(buffer, &i->worldTransform_[j], sizeof(Matrix3x4));
+            buffer += stride;
+        }
+        freeIndex += i->numWorldTransforms_;
+    }
+}
+
+void BatchQueue::DisableSkinnedInstancing()
 {
-    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
-        i->second_.SetInstancingData(lockedData, stride, freeIndex);
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    {
+        BatchGroup& group = i->second_;
+        if (group.geometryType_ == GEOM_SKINNED_INSTANCED)
+        {
+            group.geometryType_ = GEOM_SKINNED;
+            group.vertexShader_ = group.skinnedVertexShader_;
+            group.startIndex_ = M_MAX_UNSIGNED;
+        }
+    }
 }
 
 void BatchQueue::Draw(View* view, Camera* camera, bool markToStencil, bool usingLightOptimization, bool allowDepthWrite) const
@@ -892,12 +1140,18 @@ unsigned BatchQueue::GetNumInstances() const
 {
     unsigned total = 0;
 
-    for (HashMap<BatchGroupKey, BatchGroup>::ConstIterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::ConstIterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
     {
-        if (i->second_.geometryType_ == GEOM_INSTANCED)
+        if (IsInstanced(i->second_.geometryType_))
             total += i->second_.instances_.Size();
     }
 
+    for (PODVector<Batch>::ConstIterator i = batches_.Begin(); i != batches_.End(); ++i)
+    {
+        if (i->geometryType_ == GEOM_BILLBOARD_INSTANCED)
+            total += i->numWorldTransforms_;
+    }
+
     return total;
 }
 
@@ -22,7 +22,9 @@
 
 #pragma once
 
+#include "../Container/FlatHashMap.h"
 #include "../Container/Ptr.h"
+#include "../Container/RadixSort.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/Material.h"
 #include "../Math/MathDefs.h"
@@ -73,6 +75,8 @@ struct Batch
     void Prepare(View* view, Camera* camera, bool setModelTransform, bool allowDepthWrite) const;
     /// Prepare and draw.
     void Draw(View* view, Camera* camera, bool allowDepthWrite) const;
+    /// Prepare and draw instances from the instancing buffer, starting from the instance stream start index.
+    void DrawInstanced(View* view, Camera* camera, bool allowDepthWrite, unsigned numInstances) const;
 
     /// State sorting key.
     unsigned long long sortKey_{};
@@ -106,6 +110,8 @@ struct Batch
     ShaderVariation* pixelShader_{};
     /// %Geometry type.
     GeometryType geometryType_{};
+    /// Instance stream start index, or M_MAX_UNSIGNED if transforms not pre-set.
+    unsigned startIndex_{M_MAX_UNSIGNED};
 };
 
 /// Data for one geometry instance.
@@ -134,28 +140,32 @@ struct InstanceData
 struct BatchGroup : public Batch
 {
     /// Construct with defaults.
-    BatchGroup() :
-        startIndex_(M_MAX_UNSIGNED)
-    {
-    }
+    BatchGroup() = default;
 
     /// Construct from a batch.
     explicit BatchGroup(const Batch& batch) :
-        Batch(batch),
-        startIndex_(M_MAX_UNSIGNED)
+        Batch(batch)
     {
+        startIndex_ = M_MAX_UNSIGNED;
     }
 
     /// Destruct.
     ~BatchGroup() = default;
 
-    /// Add world transform(s) from a batch.
+    /// Add world transform(s) from a batch. A skinned batch adds one instance, which refers to all of its skin matrices.
     void AddTransforms(const Batch& batch)
     {
         InstanceData newInstance;
         newInstance.distance_ = batch.distance_;
         newInstance.instancingData_ = batch.instancingData_;
 
+        if (batch.geometryType_ == GEOM_SKINNED_INSTANCED)
+        {
+            newInstance.worldTransform_ = batch.worldTransform_;
+            instances_.Push(newInstance);
+            return;
+        }
+
         for (unsigned i = 0; i < batch.numWorldTransforms_; ++i)
         {
             newInstance.worldTransform_ = &batch.worldTransform_[i];
@@ -163,15 +173,15 @@ struct BatchGroup : public Batch
         }
     }
 
-    /// Pre-set the instance data. Buffer must be big enough to hold all data.
-    void SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex);
+    /// Pre-set the instance data. Buffer must be big enough to hold all data. Skin matrices of skinned instances are appended to the skin matrix vector.
+    void SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex, PODVector<Matrix3x4>& skinMatrices);
     /// Prepare and draw.
     void Draw(View* view, Camera* camera, bool allowDepthWrite) const;
 
     /// Instance data.
     PODVector<InstanceData> instances_;
-    /// Instance stream start index, or M_MAX_UNSIGNED if transforms not pre-set.
-    unsigned startIndex_;
+    /// Vertex shader for drawing skinned instances individually, in case the skin matrix texture can not be used.
+    ShaderVariation* skinnedVertexShader_{};
 };
 
 /// Instanced draw call grouping key.
@@ -228,14 +238,24 @@ struct BatchQueue
 public:
     /// Clear for new frame by clearing all groups and batches.
     void Clear(int maxSortedInstances);
+    /// Clear for new frame by clearing batches and the instances of groups. Keeps the groups and their memory for reuse; call RemoveEmptyGroups() once the queue has been filled.
+    void ClearInstances(int maxSortedInstances);
+    /// Remove groups which received no instances since the last clear.
+    void RemoveEmptyGroups();
+    /// Return the group for a key, creating it if necessary. A group without instances must be set up from the first batch added to it. Pointers to groups stay valid until a group is created or removed.
+    BatchGroup& GetGroup(const BatchGroupKey& key);
     /// Sort non-instanced draw calls back to front.
     void SortBackToFront();
     /// Sort instanced and non-instanced draw calls front to back.
     void SortFrontToBack();
     /// Sort batches front to back while also maintaining state sorting.
     void SortFrontToBack2Pass(PODVector<Batch*>& batches);
-    /// Pre-set instance data of all groups. The vertex buffer must be big enough to hold all data.
-    void SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex);
+    /// Sort instances of a group front to back.
+    void SortInstancesFrontToBack(PODVector<InstanceData>& instances);
+    /// Pre-set instance data of all groups and instanced billboard batches. The vertex buffer must be big enough to hold all data.
+    void SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex, PODVector<Matrix3x4>& skinMatrices);
+    /// Switch instanced skinned groups to drawing their instances individually.
+    void DisableSkinnedInstancing();
     /// Draw.
     void Draw(View* view, Camera* camera, bool markToStencil, bool usingLightOptimization, bool allowDepthWrite) const;
     /// Return the combined amount of instances.
@@ -245,13 +265,21 @@ public:
     bool IsEmpty() const { return batches_.Empty() && batchGroups_.Empty(); }
 
     /// Instanced draw calls.
-    HashMap<BatchGroupKey, BatchGroup> batchGroups_;
+    FlatHashMap<BatchGroupKey, BatchGroup> batchGroups_;
     /// Shader remapping table for 2-pass state and distance sort.
     HashMap<unsigned, unsigned> shaderRemapping_;
     /// Material remapping table for 2-pass state and distance sort.
     HashMap<unsigned short, unsigned short> materialRemapping_;
     /// Geometry remapping table for 2-pass state and distance sort.
     HashMap<unsigned short, unsigned short> geometryRemapping_;
+    /// Radix sort keys for batches and groups.
+    PODVector<RadixSortItem<Batch*> > sortItems_;
+    /// Radix sort scratch buffer for batches and groups.
+    PODVector<RadixSortItem<Batch*> > sortTemp_;
+    /// Radix sort keys for group instances.
+    PODVector<RadixSortItem<InstanceData> > instanceSortItems_;
+    /// Radix sort scratch buffer for group instances.
+    PODVector<RadixSortItem<InstanceData> > instanceSortTemp_;
 
     /// Unsorted non-instanced draw calls.
     PODVector<Batch> batches_;
@@ -271,6 +299,10 @@ public:
     StringHash vsExtraDefinesHash_;
     /// Hash for pixel shader extra defines.
     StringHash psExtraDefinesHash_;
+    /// Key of the most recently returned group.
+    BatchGroupKey lastGroupKey_{};
+    /// Most recently returned group, or null if it may have been moved or erased since.
+    BatchGroup* lastGroup_{};
 };
 
 /// Queue for shadow map draw calls.
@@ -295,6 +327,8 @@ struct LightBatchQueue
     Light* light_;
     /// Light negative flag.
     bool negative_;
+    /// Light is also shaded from the light clusters, so only materials which do not read the clusters get lit batches.
+    bool clustered_;
     /// Shadow map depth texture.
     Texture2D* shadowMap_;
     /// Lit geometry draw calls, base (replace blend mode).
@@ -31,6 +31,7 @@
 #include "../Graphics/Graphics.h"
 #include "../Graphics/IndexBuffer.h"
 #include "../Graphics/OctreeQuery.h"
+#include "../Graphics/Renderer.h"
 #include "../Graphics/VertexBuffer.h"
 #include "../IO/MemoryBuffer.h"
 #include "../Resource/ResourceCache.h"
@@ -74,6 +75,12 @@ inline bool CompareBillboards(Billboard* lhs, Billboard* rhs)
     return lhs->sortDistance_ > rhs->sortDistance_;
 }
 
+/// Pack two color channels with 12 bits each into a float, which holds them exactly.
+inline float PackColorChannels(float high, float low)
+{
+    return (float)((unsigned)(Clamp(high, 0.0f, 1.0f) * 4095.0f + 0.5f) * 4096 + (unsigned)(Clamp(low, 0.0f, 1.0f) * 4095.0f + 0.5f));
+}
+
 BillboardSet::BillboardSet(Context* context) :
     Drawable(context, DRAWABLE_GEOMETRY),
     animationLodBias_(1.0f),
@@ -84,6 +91,7 @@ BillboardSet::BillboardSet(Context* context) :
     fixedScreenSize_(false),
     faceCameraMode_(FC_ROTATE_XYZ),
     minAngle_(0.0f),
+    instanced_(false),
     geometry_(new Geometry(context)),
     vertexBuffer_(new VertexBuffer(context_)),
     indexBuffer_(new IndexBuffer(context_)),
@@ -91,6 +99,8 @@ BillboardSet::BillboardSet(Context* context) :
     bufferDirty_(true),
     forceUpdate_(false),
     geometryTypeUpdate_(false),
+    instanceDataDirty_(true),
+    drawInstanced_(false),
     sortThisFrame_(false),
     hasOrthoCamera_(false),
     sortFrameNumber_(0),
@@ -125,6 +135,7 @@ void BillboardSet::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Draw Distance", GetDrawDistance, SetDrawDistance, float, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Shadow Distance", GetShadowDistance, SetShadowDistance, float, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Animation LOD Bias", GetAnimationLodBias, SetAnimationLodBias, float, 1.0f, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Hardware Instancing", IsInstanced, SetInstanced, bool, false, AM_DEFAULT);
     URHO3D_COPY_BASE_ATTRIBUTES(Drawable);
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Billboards", GetBillboardsAttr, SetBillboardsAttr, VariantVector, Variant::emptyVariantVector, AM_FILE)
         .SetMetadata(AttributeMetadata::P_VECTOR_STRUCT_ELEMENTS, billboardsStructureElementNames);
@@ -214,6 +225,26 @@ void BillboardSet::UpdateBatches(const FrameInfo& frame)
         lodDistance_ = 0.0f;
 
     batches_[0].distance_ = distance_;
+
+    // Draw each billboard as an instance of a shared quad when the billboards are view-independent
+    auto* renderer = GetSubsystem<Renderer>();
+    drawInstanced_ = instanced_ && faceCameraMode_ == FC_ROTATE_XYZ && !sorted_ && !fixedScreenSize_ && renderer &&
+        renderer->GetBillboardGeometry() && renderer->GetInstancingBuffer();
+    if (drawInstanced_)
+    {
+        if (instanceDataDirty_)
+            UpdateInstanceData();
+
+        batches_[0].geometry_ = renderer->GetBillboardGeometry();
+        batches_[0].geometryType_ = GEOM_BILLBOARD_INSTANCED;
+        batches_[0].worldTransform_ = instanceData_.Buffer();
+        batches_[0].numWorldTransforms_ = instanceData_.Size();
+        return;
+    }
+
+    batches_[0].geometry_ = geometry_;
+    batches_[0].geometryType_ = faceCameraMode_ == FC_DIRECTION ? GEOM_DIRBILLBOARD : GEOM_BILLBOARD;
+    batches_[0].worldTransform_ = &transforms_[0];
     batches_[0].numWorldTransforms_ = 2;
     // Billboard positioning
     transforms_[0] = relative_ ? node_->GetWorldTransform() : Matrix3x4::IDENTITY;
@@ -224,6 +255,9 @@ void BillboardSet::UpdateBatches(const FrameInfo& frame)
 
 void BillboardSet::UpdateGeometry(const FrameInfo& frame)
 {
+    if (drawInstanced_)
+        return;
+
     // If rendering from multiple views and fixed screen size is in use, re-update scale factors before each render
     if (fixedScreenSize_ && viewCameras_.Size() > 1)
         CalculateFixedScreenSize(frame);
@@ -244,6 +278,9 @@ void BillboardSet::UpdateGeometry(const FrameInfo& frame)
 
 UpdateGeometryType BillboardSet::GetUpdateGeometryType()
 {
+    if (drawInstanced_)
+        return UPDATE_NONE;
+
     // If using camera facing, always need some kind of geometry update, in case the billboard set is rendered from several views
     if (bufferDirty_ || bufferSizeDirty_ || vertexBuffer_->IsDataLost() || indexBuffer_->IsDataLost() || sortThisFrame_ ||
         faceCameraMode_ != FC_NONE || fixedScreenSize_)
@@ -343,6 +380,12 @@ void BillboardSet::SetAnimationLodBias(float bias)
     MarkNetworkUpdate();
 }
 
+void BillboardSet::SetInstanced(bool enable)
+{
+    instanced_ = enable;
+    Commit();
+}
+
 void BillboardSet::Commit()
 {
     MarkPositionsDirty();
@@ -468,6 +511,12 @@ const PODVector<unsigned char>& BillboardSet::GetNetBillboardsAttr() const
     return attrBuffer_.GetBuffer();
 }
 
+void BillboardSet::OnMarkedDirty(Node* node)
+{
+    Drawable::OnMarkedDirty(node);
+    instanceDataDirty_ = true;
+}
+
 void BillboardSet::OnWorldBoundingBoxUpdate()
 {
     unsigned enabledBillboards = 0;
@@ -764,10 +813,44 @@ void BillboardSet::UpdateVertexBuffer(const FrameInfo& frame)
     vertexBuffer_->ClearDataLost();
 }
 
+void BillboardSet::UpdateInstanceData()
+{
+    const Matrix3x4& worldTransform = node_->GetWorldTransform();
+    Matrix3x4 billboardTransform = relative_ ? worldTransform : Matrix3x4::IDENTITY;
+    Vector3 billboardScale = scaled_ ? worldTransform.Scale() : Vector3::ONE;
+
+    instanceData_.Clear();
+    for (unsigned i = 0; i < billboards_.Size(); ++i)
+    {
+        const Billboard& billboard = billboards_[i];
+        if (!billboard.enabled_)
+            continue;
+
+        Vector3 position = billboardTransform * billboard.position_;
+        Matrix3x4 data;
+        data.m00_ = position.x_;
+        data.m01_ = position.y_;
+        data.m02_ = position.z_;
+        data.m03_ = PackColorChannels(billboard.color_.r_, billboard.color_.g_);
+        data.m10_ = billboard.size_.x_ * billboardScale.x_;
+        data.m11_ = billboard.size_.y_ * billboardScale.y_;
+        data.m12_ = billboard.rotation_ * M_DEGTORAD;
+        data.m13_ = PackColorChannels(billboard.color_.b_, billboard.color_.a_);
+        data.m20_ = billboard.uv_.min_.x_;
+        data.m21_ = billboard.uv_.min_.y_;
+        data.m22_ = billboard.uv_.max_.x_;
+        data.m23_ = billboard.uv_.max_.y_;
+        instanceData_.Push(data);
+    }
+
+    instanceDataDirty_ = false;
+}
+
 void BillboardSet::MarkPositionsDirty()
 {
     Drawable::OnMarkedDirty(node_);
     bufferDirty_ = true;
+    instanceDataDirty_ = true;
 }
 
 void BillboardSet::CalculateFixedScreenSize(const FrameInfo& frame)
@@ -810,7 +893,7 @@ void BillboardSet::CalculateFixedScreenSize(const FrameInfo& frame)
     {
         bufferDirty_ = true;
         forceUpdate_ = true;
-        worldBoundingBoxDirty_ = true;
+        MarkWorldBoundingBoxDirty();
     }
 }
 
@@ -108,6 +108,9 @@ public:
     /// Set animation LOD bias.
     /// @property
     void SetAnimationLodBias(float bias);
+    /// Set whether billboards are drawn with hardware instancing, which combines billboard sets using the same material into one draw call. Only used with the default camera facing mode, without sorting and fixed screen size. Requires a shader which supports billboard instancing. Default false.
+    /// @property
+    void SetInstanced(bool enable);
     /// Mark for bounding box and vertex buffer update. Call after modifying the billboards.
     void Commit();
 
@@ -154,6 +157,10 @@ public:
     /// @property
     float GetAnimationLodBias() const { return animationLodBias_; }
 
+    /// Return whether billboards are drawn with hardware instancing when possible.
+    /// @property
+    bool IsInstanced() const { return instanced_; }
+
     /// Set material attribute.
     void SetMaterialAttr(const ResourceRef& value);
     /// Set billboards attribute.
@@ -168,6 +175,8 @@ public:
     const PODVector<unsigned char>& GetNetBillboardsAttr() const;
 
 protected:
+    /// Handle node transform being dirtied.
+    void OnMarkedDirty(Node* node) override;
     /// Recalculate the world-space bounding box.
     void OnWorldBoundingBoxUpdate() override;
     /// Mark billboard vertex buffer to need an update.
@@ -191,6 +200,8 @@ protected:
     FaceCameraMode faceCameraMode_;
     /// Minimal angle between billboard normal and look-at direction.
     float minAngle_;
+    /// Hardware instancing flag.
+    bool instanced_;
 
 private:
     /// Resize billboard vertex and index buffers.
@@ -199,6 +210,8 @@ private:
     void UpdateVertexBuffer(const FrameInfo& frame);
     /// Calculate billboard scale factors in fixed screen size mode.
     void CalculateFixedScreenSize(const FrameInfo& frame);
+    /// Rewrite per-billboard instance data.
+    void UpdateInstanceData();
 
     /// Geometry.
     SharedPtr<Geometry> geometry_;
@@ -208,6 +221,8 @@ private:
     SharedPtr<IndexBuffer> indexBuffer_;
     /// Transform matrices for position and billboard orientation.
     Matrix3x4 transforms_[2];
+    /// Per-billboard instance data when drawing instanced: world position and red & green color, size, rotation and blue & alpha color, UV coordinates.
+    PODVector<Matrix3x4> instanceData_;
     /// Buffers need resize flag.
     bool bufferSizeDirty_;
     /// Vertex buffer needs rewrite flag.
@@ -216,6 +231,10 @@ private:
     bool forceUpdate_;
     /// Update billboard geometry type.
     bool geometryTypeUpdate_;
+    /// Instance data needs rewrite flag.
+    bool instanceDataDirty_;
+    /// Whether is drawn instanced on the current frame.
+    bool drawInstanced_;
     /// Sorting flag. Triggers a vertex buffer rewrite for each view this billboard set is rendered from.
     bool sortThisFrame_;
     /// Whether was last rendered from an ortho camera.
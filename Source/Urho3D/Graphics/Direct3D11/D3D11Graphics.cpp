@@ -2262,6 +2262,7 @@ void Graphics::CheckFeatureSupport()
     deferredSupport_ = true;
     hardwareShadowSupport_ = true;
     instancingSupport_ = true;
+    vertexTextureSupport_ = true;
     shadowMapFormat_ = DXGI_FORMAT_R16_TYPELESS;
     hiresShadowMapFormat_ = DXGI_FORMAT_R32_TYPELESS;
     dummyColorFormat_ = DXGI_FORMAT_UNKNOWN;
@@ -2623,6 +2624,8 @@ void Graphics::SetTextureUnitMappings()
     textureUnits_["VolumeMap"] = TU_VOLUMEMAP;
     textureUnits_["ZoneCubeMap"] = TU_ZONE;
     textureUnits_["ZoneVolumeMap"] = TU_ZONE;
+    textureUnits_["ClusterMap"] = TU_LIGHTCLUSTERS;
+    textureUnits_["SkinMap"] = TU_SKINMATRICES;
 }
 
 }
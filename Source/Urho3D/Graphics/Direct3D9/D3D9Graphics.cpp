@@ -2608,6 +2608,8 @@ void Graphics::SetTextureUnitMappings()
     textureUnits_["VolumeMap"] = TU_VOLUMEMAP;
     textureUnits_["ZoneCubeMap"] = TU_ZONE;
     textureUnits_["ZoneVolumeMap"] = TU_ZONE;
+    textureUnits_["ClusterMap"] = TU_LIGHTCLUSTERS;
+    textureUnits_["SkinMap"] = TU_SKINMATRICES;
 }
 
 }
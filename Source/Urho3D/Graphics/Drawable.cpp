@@ -64,9 +64,13 @@ Drawable::Drawable(Context* context, unsigned char drawableFlags) :
     castShadows_(false),
     occluder_(false),
     occludee_(true),
+    batched_(false),
     updateQueued_(false),
     zoneDirty_(false),
     octant_(nullptr),
+    octantIndex_(0),
+    aabbTreeProxy_(M_MAX_UNSIGNED),
+    snapshotIndex_(M_MAX_UNSIGNED),
     zone_(nullptr),
     viewMask_(DEFAULT_VIEWMASK),
     lightMask_(DEFAULT_LIGHTMASK),
@@ -99,7 +103,7 @@ Drawable::~Drawable()
 void Drawable::RegisterObject(Context* context)
 {
     URHO3D_ATTRIBUTE("Max Lights", int, maxLights_, 0, AM_DEFAULT);
-    URHO3D_ATTRIBUTE("View Mask", int, viewMask_, DEFAULT_VIEWMASK, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("View Mask", GetViewMask, SetViewMask, unsigned, DEFAULT_VIEWMASK, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Light Mask", int, lightMask_, DEFAULT_LIGHTMASK, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Shadow Mask", int, shadowMask_, DEFAULT_SHADOWMASK, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Zone Mask", GetZoneMask, SetZoneMask, unsigned, DEFAULT_ZONEMASK, AM_DEFAULT);
@@ -172,13 +176,21 @@ void Drawable::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
 
 void Drawable::SetDrawDistance(float distance)
 {
-    drawDistance_ = distance;
+    if (distance != drawDistance_)
+    {
+        drawDistance_ = distance;
+        MarkForUpdate();
+    }
     MarkNetworkUpdate();
 }
 
 void Drawable::SetShadowDistance(float distance)
 {
-    shadowDistance_ = distance;
+    if (distance != shadowDistance_)
+    {
+        shadowDistance_ = distance;
+        MarkForUpdate();
+    }
     MarkNetworkUpdate();
 }
 
@@ -190,7 +202,14 @@ void Drawable::SetLodBias(float bias)
 
 void Drawable::SetViewMask(unsigned mask)
 {
-    viewMask_ = mask;
+    if (mask != viewMask_)
+    {
+        viewMask_ = mask;
+        if (octant_)
+            octant_->UpdateDrawableViewMask(this);
+        // Let the octree know so that cached query results are refreshed
+        MarkForUpdate();
+    }
     MarkNetworkUpdate();
 }
 
@@ -202,7 +221,11 @@ void Drawable::SetLightMask(unsigned mask)
 
 void Drawable::SetShadowMask(unsigned mask)
 {
-    shadowMask_ = mask;
+    if (mask != shadowMask_)
+    {
+        shadowMask_ = mask;
+        MarkForUpdate();
+    }
     MarkNetworkUpdate();
 }
 
@@ -222,7 +245,12 @@ void Drawable::SetMaxLights(unsigned num)
 
 void Drawable::SetCastShadows(bool enable)
 {
-    castShadows_ = enable;
+    if (enable != castShadows_)
+    {
+        castShadows_ = enable;
+        // Let the octree know so that cached shadow casters are culled again
+        MarkForUpdate();
+    }
     MarkNetworkUpdate();
 }
 
@@ -250,12 +278,26 @@ void Drawable::MarkForUpdate()
         octant_->GetRoot()->QueueUpdate(this);
 }
 
+void Drawable::SetBatched(bool enable)
+{
+    if (enable == batched_)
+        return;
+
+    batched_ = enable;
+    if (batched_)
+        RemoveFromOctree();
+    else if (!octant_)
+        AddToOctree();
+}
+
 const BoundingBox& Drawable::GetWorldBoundingBox()
 {
     if (worldBoundingBoxDirty_)
     {
         OnWorldBoundingBoxUpdate();
         worldBoundingBoxDirty_ = false;
+        if (octant_)
+            octant_->UpdateDrawableBounds(this);
     }
 
     return worldBoundingBox_;
@@ -373,7 +415,7 @@ void Drawable::OnSceneSet(Scene* scene)
 
 void Drawable::OnMarkedDirty(Node* node)
 {
-    worldBoundingBoxDirty_ = true;
+    MarkWorldBoundingBoxDirty();
     if (!updateQueued_ && octant_)
         octant_->GetRoot()->QueueUpdate(this);
 
@@ -382,10 +424,17 @@ void Drawable::OnMarkedDirty(Node* node)
         zoneDirty_ = true;
 }
 
+void Drawable::MarkWorldBoundingBoxDirty()
+{
+    worldBoundingBoxDirty_ = true;
+    if (octant_)
+        octant_->InvalidateDrawableBounds(this);
+}
+
 void Drawable::AddToOctree()
 {
-    // Do not add to octree when disabled
-    if (!IsEnabledEffective())
+    // Do not add to octree when disabled, or when a static batch renders the geometry instead
+    if (!IsEnabledEffective() || batched_)
         return;
 
     Scene* scene = GetScene();
@@ -393,7 +442,11 @@ void Drawable::AddToOctree()
     {
         auto* octree = scene->GetComponent<Octree>();
         if (octree)
+        {
             octree->InsertDrawable(this);
+            octree->MarkChanged(worldBoundingBox_);
+            octree->AddToSnapshots(this);
+        }
         else
             URHO3D_LOGERROR("No Octree component in scene, drawable will not render");
     }
@@ -415,6 +468,8 @@ void Drawable::RemoveFromOctree()
         // Perform subclass specific deinitialization if necessary
         OnRemoveFromOctree();
 
+        octree->RemoveFromSnapshots(this);
+        octree->MarkChanged(worldBoundingBox_);
         octant_->RemoveDrawable(this);
     }
 }
@@ -46,6 +46,7 @@ static const float ANIMATION_LOD_BASESCALE = 2500.0f;
 
 class Camera;
 class File;
+class FrameAllocator;
 class Geometry;
 class Light;
 class Material;
@@ -75,6 +76,8 @@ struct FrameInfo
     IntVector2 viewSize_;
     /// Camera being used.
     Camera* camera_;
+    /// Per-thread transient memory which is valid until the end of the frame. May be null.
+    FrameAllocator* allocator_{};
 };
 
 /// Source data for a 3D geometry draw call.
@@ -113,7 +116,7 @@ class URHO3D_API Drawable : public Component
 
     friend class Octant;
     friend class Octree;
-    friend void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex);
+    friend void UpdateDrawablesWork(const FrameInfo& frame, Drawable** start, Drawable** end);
 
 public:
     /// Construct.
@@ -184,6 +187,8 @@ public:
     void SetOccludee(bool enable);
     /// Mark for update and octree reinsertion. Update is automatically queued when the drawable's scene node moves or changes scale.
     void MarkForUpdate();
+    /// Set whether geometry has been merged into a static batch. A batched drawable is kept out of the octree, while the batch forwards raycasts to it. Not serialized.
+    void SetBatched(bool enable);
 
     /// Return local space bounding box. May not be applicable or properly updated on all drawables.
     /// @property
@@ -240,6 +245,9 @@ public:
     /// @property
     bool IsOccludee() const { return occludee_; }
 
+    /// Return whether geometry has been merged into a static batch.
+    bool IsBatched() const { return batched_; }
+
     /// Return whether is in view this frame from any viewport camera. Excludes shadow map cameras.
     /// @property
     bool IsInView() const;
@@ -298,6 +306,9 @@ public:
     /// Return whether has a base pass.
     bool HasBasePass(unsigned batchIndex) const { return (basePassFlags_ & (1u << batchIndex)) != 0; }
 
+    /// Return base pass flags, bit per batch.
+    unsigned GetBasePassFlags() const { return basePassFlags_; }
+
     /// Return per-pixel lights.
     const PODVector<Light*>& GetLights() const { return lights_; }
 
@@ -351,6 +362,8 @@ protected:
 
     /// Move into another octree octant.
     void SetOctant(Octant* octant) { octant_ = octant; }
+    /// Mark the world-space bounding box for recalculation. Also marks the octant's packed copy of it out of date.
+    void MarkWorldBoundingBoxDirty();
 
     /// World-space bounding box.
     BoundingBox worldBoundingBox_;
@@ -368,12 +381,20 @@ protected:
     bool occluder_;
     /// Occludee flag.
     bool occludee_;
+    /// Merged into a static batch flag.
+    bool batched_;
     /// Octree update queued flag.
     bool updateQueued_;
     /// Zone inconclusive or dirtied flag.
     bool zoneDirty_;
     /// Octree octant.
     Octant* octant_;
+    /// Index in the octant's drawable list.
+    unsigned octantIndex_;
+    /// Proxy in the octree's AABB tree, or M_MAX_UNSIGNED if none.
+    unsigned aabbTreeProxy_;
+    /// Slot in the octree's snapshot table, or M_MAX_UNSIGNED if none.
+    unsigned snapshotIndex_;
     /// Current zone.
     Zone* zone_;
     /// View mask.
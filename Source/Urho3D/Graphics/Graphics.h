@@ -448,6 +448,10 @@ public:
     /// @property
     bool GetInstancingSupport() const { return instancingSupport_; }
 
+    /// Return whether vertex shaders can fetch texels, which instanced skinning requires.
+    /// @property
+    bool GetVertexTextureSupport() const { return vertexTextureSupport_; }
+
     /// Return whether light pre-pass rendering is supported.
     /// @property
     bool GetLightPrepassSupport() const { return lightPrepassSupport_; }
@@ -806,6 +810,8 @@ private:
     bool hardwareShadowSupport_{};
     /// Instancing support flag.
     bool instancingSupport_{};
+    /// Vertex texture fetch support flag.
+    bool vertexTextureSupport_{};
     /// sRGB conversion on read support flag.
     bool sRGBSupport_{};
     /// sRGB conversion on write support flag.
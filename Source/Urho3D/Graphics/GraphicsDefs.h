@@ -61,9 +61,11 @@ enum GeometryType
     GEOM_DIRBILLBOARD = 4,
     GEOM_TRAIL_FACE_CAMERA = 5,
     GEOM_TRAIL_BONE = 6,
-    MAX_GEOMETRYTYPES = 7,
+    GEOM_SKINNED_INSTANCED = 7,
+    GEOM_BILLBOARD_INSTANCED = 8,
+    MAX_GEOMETRYTYPES = 9,
     // This is not a real geometry type for VS, but used to mark objects that do not desire to be instanced
-    GEOM_STATIC_NOINSTANCING = 7,
+    GEOM_STATIC_NOINSTANCING = 9,
 };
 
 /// Blending mode.
@@ -332,11 +334,13 @@ enum TextureUnit
     TU_CUSTOM1 = 6,
     TU_CUSTOM2 = 7,
     TU_LIGHTRAMP = 8,
+    TU_LIGHTCLUSTERS = 8,
     TU_LIGHTSHAPE = 9,
     TU_SHADOWMAP = 10,
     TU_FACESELECT = 11,
     TU_INDIRECTION = 12,
     TU_DEPTHBUFFER = 13,
+    TU_SKINMATRICES = 13,
     TU_LIGHTBUFFER = 14,
     TU_ZONE = 15,
     MAX_MATERIAL_TEXTURE_UNITS = 8,
@@ -401,6 +405,7 @@ extern URHO3D_API const StringHash VSP_SKINMATRICES;
 extern URHO3D_API const StringHash VSP_VERTEXLIGHTS;
 extern URHO3D_API const StringHash PSP_AMBIENTCOLOR;
 extern URHO3D_API const StringHash PSP_CAMERAPOS;
+extern URHO3D_API const StringHash PSP_CLUSTERPARAMS;
 extern URHO3D_API const StringHash PSP_DELTATIME;
 extern URHO3D_API const StringHash PSP_DEPTHRECONSTRUCT;
 extern URHO3D_API const StringHash PSP_ELAPSEDTIME;
@@ -0,0 +1,275 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
+#include "../Graphics/Camera.h"
+#include "../Graphics/Graphics.h"
+#include "../Graphics/Light.h"
+#include "../Graphics/LightClusters.h"
+#include "../Graphics/Texture2D.h"
+#include "../IO/Log.h"
+#include "../Math/Sphere.h"
+#include "../Scene/Node.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned NUM_CLUSTER_TILES = CLUSTER_TILES_X * CLUSTER_TILES_Y;
+
+static unsigned GetTile(float ndc, unsigned numTiles)
+{
+    return (unsigned)Clamp((int)floorf((ndc * 0.5f + 0.5f) * numTiles), 0, (int)numTiles - 1);
+}
+
+LightClusters::LightClusters(Context* context) :
+    Object(context)
+{
+}
+
+LightClusters::~LightClusters() = default;
+
+void LightClusters::Build(Camera* camera, const PODVector<Light*>& lights)
+{
+    URHO3D_PROFILE(BuildLightClusters);
+
+    view_ = camera->GetView();
+    projection_ = camera->GetProjection();
+    nearClip_ = camera->GetNearClip();
+    farClip_ = Max(camera->GetFarClip(), nearClip_ * 2.0f);
+    flipVertical_ = camera->GetFlipVertical();
+    sliceScale_ = (float)CLUSTER_SLICES / Ln(farClip_ / nearClip_);
+    sliceBias_ = -Ln(nearClip_) * sliceScale_;
+
+    lights_.Clear();
+    lightBounds_.Clear();
+    for (unsigned i = 0; i < lights.Size() && lights_.Size() < MAX_CLUSTERED_LIGHTS; ++i)
+    {
+        LightBounds bounds = GetLightBounds(lights[i]);
+        if (bounds.minSlice_ <= bounds.maxSlice_)
+        {
+            lights_.Push(lights[i]);
+            lightBounds_.Push(bounds);
+        }
+    }
+
+    clusterLights_.Resize(NUM_CLUSTERS * MAX_LIGHTS_PER_CLUSTER);
+    clusterCounts_.Resize(NUM_CLUSTERS);
+    auto* queue = GetSubsystem<WorkQueue>();
+    if (queue && lights_.Size())
+    {
+        queue->ParallelFor(CLUSTER_SLICES, 1, [this](unsigned begin, unsigned end, unsigned /*threadIndex*/)
+        {
+            AssignSlices(begin, end);
+        });
+    }
+    else
+        AssignSlices(0, CLUSTER_SLICES);
+
+    // Light data goes to the first row, followed by the cluster headers and then the light indices of each cluster in turn
+    textureData_.Resize(CLUSTER_TEXTURE_WIDTH * CLUSTER_TEXTURE_HEIGHT);
+    for (unsigned i = 0; i < lights_.Size(); ++i)
+    {
+        Light* light = lights_[i];
+        Node* lightNode = light->GetNode();
+        Vector4* dest = &textureData_[i * CLUSTER_LIGHT_TEXELS];
+
+        float cutoff, invCutoff;
+        if (light->GetLightType() == LIGHT_SPOT)
+        {
+            cutoff = Cos(light->GetFov() * 0.5f);
+            invCutoff = 1.0f / (1.0f - cutoff);
+        }
+        else
+        {
+            cutoff = -2.0f;
+            invCutoff = 1.0f;
+        }
+
+        float fade = 1.0f;
+        float fadeEnd = light->GetDrawDistance();
+        float fadeStart = light->GetFadeDistance();
+        if (fadeEnd > 0.0f && fadeStart > 0.0f && fadeStart < fadeEnd)
+            fade = Min(1.0f - (light->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 1.0f);
+
+        Color color = light->GetEffectiveColor() * fade;
+        dest[0] = Vector4(color.r_, color.g_, color.b_, 1.0f / Max(light->GetRange(), M_EPSILON));
+        dest[1] = Vector4(-lightNode->GetWorldDirection(), cutoff);
+        dest[2] = Vector4(lightNode->GetWorldPosition(), invCutoff);
+        dest[3] = Vector4(light->GetEffectiveSpecularIntensity() * fade, 0.0f, 0.0f, 0.0f);
+    }
+
+    // If the light indices do not fit the texture, the last clusters are left with fewer or no lights
+    const unsigned maxLightIndices = CLUSTER_TEXTURE_WIDTH * CLUSTER_TEXTURE_HEIGHT - CLUSTER_INDEX_START;
+    numLightIndices_ = 0;
+    for (unsigned i = 0; i < NUM_CLUSTERS; ++i)
+    {
+        unsigned count = Min((unsigned)clusterCounts_[i], maxLightIndices - numLightIndices_);
+        unsigned start = CLUSTER_INDEX_START + numLightIndices_;
+        textureData_[CLUSTER_HEADER_START + i] = Vector4((float)start, (float)count, 0.0f, 0.0f);
+
+        const unsigned short* lightIndices = &clusterLights_[i * MAX_LIGHTS_PER_CLUSTER];
+        for (unsigned j = 0; j < count; ++j)
+            textureData_[start + j].x_ = (float)lightIndices[j];
+        numLightIndices_ += count;
+    }
+
+    numRows_ = (CLUSTER_INDEX_START + numLightIndices_ + CLUSTER_TEXTURE_WIDTH - 1) / CLUSTER_TEXTURE_WIDTH;
+}
+
+void LightClusters::UpdateTexture()
+{
+    if (!texture_)
+    {
+        texture_ = new Texture2D(context_);
+        texture_->SetNumLevels(1);
+        texture_->SetFilterMode(FILTER_NEAREST);
+        if (!texture_->SetSize(CLUSTER_TEXTURE_WIDTH, CLUSTER_TEXTURE_HEIGHT, Graphics::GetRGBAFloat32Format(), TEXTURE_DYNAMIC))
+        {
+            URHO3D_LOGERROR("Failed to create light cluster texture");
+            texture_.Reset();
+            return;
+        }
+    }
+
+    if (numRows_)
+        texture_->SetData(0, 0, 0, CLUSTER_TEXTURE_WIDTH, numRows_, textureData_.Buffer());
+}
+
+unsigned LightClusters::GetCluster(const Vector3& worldPos) const
+{
+    Vector3 viewPos = view_ * worldPos;
+    if (viewPos.z_ < nearClip_ || viewPos.z_ > farClip_)
+        return M_MAX_UNSIGNED;
+
+    Vector3 ndc = projection_ * viewPos;
+    if (Abs(ndc.x_) > 1.0f || Abs(ndc.y_) > 1.0f)
+        return M_MAX_UNSIGNED;
+
+    return (GetSlice(viewPos.z_) * CLUSTER_TILES_Y + GetTile(ndc.y_, CLUSTER_TILES_Y)) * CLUSTER_TILES_X +
+        GetTile(ndc.x_, CLUSTER_TILES_X);
+}
+
+unsigned LightClusters::GetNumClusterLights(unsigned cluster) const
+{
+    return cluster < clusterCounts_.Size() ? clusterCounts_[cluster] : 0;
+}
+
+unsigned LightClusters::GetClusterLight(unsigned cluster, unsigned index) const
+{
+    return index < GetNumClusterLights(cluster) ? clusterLights_[cluster * MAX_LIGHTS_PER_CLUSTER + index] : M_MAX_UNSIGNED;
+}
+
+Vector4 LightClusters::GetShaderParameter(bool flipVertical) const
+{
+    // Shaders find the tile as floor(ndc.xy * param.xy + abs(param.xy)), which maps a flipped Y coordinate back when negative
+    float halfTilesY = CLUSTER_TILES_Y * 0.5f;
+    return Vector4(CLUSTER_TILES_X * 0.5f, flipVertical != flipVertical_ ? -halfTilesY : halfTilesY, sliceScale_, sliceBias_);
+}
+
+void LightClusters::AssignSlices(unsigned begin, unsigned end)
+{
+    for (unsigned slice = begin; slice < end; ++slice)
+    {
+        unsigned char* counts = &clusterCounts_[slice * NUM_CLUSTER_TILES];
+        unsigned short* clusterLights = &clusterLights_[slice * NUM_CLUSTER_TILES * MAX_LIGHTS_PER_CLUSTER];
+        memset(counts, 0, NUM_CLUSTER_TILES);
+
+        // Lights are in priority order, so the least important ones are left out of full clusters
+        for (unsigned i = 0; i < lightBounds_.Size(); ++i)
+        {
+            const LightBounds& bounds = lightBounds_[i];
+            if (slice < bounds.minSlice_ || slice > bounds.maxSlice_)
+                continue;
+
+            for (unsigned y = bounds.minY_; y <= bounds.maxY_; ++y)
+            {
+                for (unsigned x = bounds.minX_; x <= bounds.maxX_; ++x)
+                {
+                    unsigned tile = y * CLUSTER_TILES_X + x;
+                    if (counts[tile] < MAX_LIGHTS_PER_CLUSTER)
+                        clusterLights[tile * MAX_LIGHTS_PER_CLUSTER + counts[tile]++] = (unsigned short)i;
+                }
+            }
+        }
+    }
+}
+
+unsigned LightClusters::GetSlice(float depth) const
+{
+    return (unsigned)Clamp((int)floorf(Ln(depth) * sliceScale_ + sliceBias_), 0, (int)CLUSTER_SLICES - 1);
+}
+
+LightClusters::LightBounds LightClusters::GetLightBounds(Light* light) const
+{
+    LightBounds bounds{0, CLUSTER_TILES_X - 1, 0, CLUSTER_TILES_Y - 1, 1, 0};
+
+    BoundingBox worldBox;
+    if (light->GetLightType() == LIGHT_SPOT)
+        worldBox.Define(light->GetFrustum());
+    else
+        worldBox.Define(Sphere(light->GetNode()->GetWorldPosition(), light->GetRange()));
+
+    BoundingBox viewBox = worldBox.Transformed(view_);
+    if (viewBox.max_.z_ < nearClip_ || viewBox.min_.z_ > farClip_)
+        return bounds;
+
+    bounds.minSlice_ = GetSlice(Max(viewBox.min_.z_, nearClip_));
+    bounds.maxSlice_ = GetSlice(Min(viewBox.max_.z_, farClip_));
+
+    // A light volume crossing the near plane can not be projected, so it covers the whole screen
+    if (viewBox.min_.z_ > nearClip_)
+    {
+        Vector2 ndcMin(M_INFINITY, M_INFINITY);
+        Vector2 ndcMax(-M_INFINITY, -M_INFINITY);
+        for (unsigned i = 0; i < 8; ++i)
+        {
+            Vector3 corner((i & 1u) ? viewBox.max_.x_ : viewBox.min_.x_, (i & 2u) ? viewBox.max_.y_ : viewBox.min_.y_,
+                (i & 4u) ? viewBox.max_.z_ : viewBox.min_.z_);
+            Vector3 ndc = projection_ * corner;
+            ndcMin.x_ = Min(ndcMin.x_, ndc.x_);
+            ndcMin.y_ = Min(ndcMin.y_, ndc.y_);
+            ndcMax.x_ = Max(ndcMax.x_, ndc.x_);
+            ndcMax.y_ = Max(ndcMax.y_, ndc.y_);
+        }
+
+        if (ndcMax.x_ < -1.0f || ndcMin.x_ > 1.0f || ndcMax.y_ < -1.0f || ndcMin.y_ > 1.0f)
+        {
+            bounds.minSlice_ = 1;
+            bounds.maxSlice_ = 0;
+            return bounds;
+        }
+
+        bounds.minX_ = GetTile(ndcMin.x_, CLUSTER_TILES_X);
+        bounds.maxX_ = GetTile(ndcMax.x_, CLUSTER_TILES_X);
+        bounds.minY_ = GetTile(ndcMin.y_, CLUSTER_TILES_Y);
+        bounds.maxY_ = GetTile(ndcMax.y_, CLUSTER_TILES_Y);
+    }
+
+    return bounds;
+}
+
+}
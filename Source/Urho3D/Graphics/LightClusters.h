@@ -0,0 +1,143 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Core/Object.h"
+#include "../Math/Matrix3x4.h"
+#include "../Math/Vector4.h"
+
+namespace Urho3D
+{
+
+class Camera;
+class Light;
+class Texture2D;
+
+static const unsigned CLUSTER_TILES_X = 16;
+static const unsigned CLUSTER_TILES_Y = 8;
+static const unsigned CLUSTER_SLICES = 24;
+static const unsigned NUM_CLUSTERS = CLUSTER_TILES_X * CLUSTER_TILES_Y * CLUSTER_SLICES;
+static const unsigned MAX_CLUSTERED_LIGHTS = 256;
+static const unsigned MAX_LIGHTS_PER_CLUSTER = 32;
+static const unsigned CLUSTER_TEXTURE_WIDTH = 1024;
+static const unsigned CLUSTER_TEXTURE_HEIGHT = 64;
+/// Texels of light data per light: the same layout as the vertex lights shader parameter, followed by the specular intensity.
+static const unsigned CLUSTER_LIGHT_TEXELS = 4;
+/// First texel of the cluster headers in the cluster texture, after the light data row.
+static const unsigned CLUSTER_HEADER_START = CLUSTER_TEXTURE_WIDTH;
+/// First texel of the cluster light indices in the cluster texture.
+static const unsigned CLUSTER_INDEX_START = CLUSTER_HEADER_START + NUM_CLUSTERS;
+
+/// Assigns point and spot lights to the clusters of a view frustum, which are tiles of the screen split into exponential depth slices. The resulting light lists are uploaded to a float texture, which forward shaders use to light a pixel with all lights of its cluster in a single pass.
+class URHO3D_API LightClusters : public Object
+{
+    URHO3D_OBJECT(LightClusters, Object);
+
+public:
+    /// Construct.
+    explicit LightClusters(Context* context);
+    /// Destruct.
+    ~LightClusters() override;
+
+    /// Assign lights to the clusters of a perspective camera's view. Lights past the maximum clustered light count are ignored. The clusters are filled in worker threads, a range of depth slices per thread.
+    void Build(Camera* camera, const PODVector<Light*>& lights);
+    /// Upload the light data and the cluster light lists to the cluster texture. Must be called from the main thread.
+    void UpdateTexture();
+
+    /// Return number of assigned lights.
+    unsigned GetNumLights() const { return lights_.Size(); }
+
+    /// Return an assigned light by index.
+    Light* GetLight(unsigned index) const { return index < lights_.Size() ? lights_[index] : nullptr; }
+
+    /// Return total number of light indices in the clusters, excluding indices which did not fit the cluster texture.
+    unsigned GetNumLightIndices() const { return numLightIndices_; }
+
+    /// Return the cluster which contains a world space position, or M_MAX_UNSIGNED if outside the view.
+    unsigned GetCluster(const Vector3& worldPos) const;
+    /// Return number of lights in a cluster.
+    unsigned GetNumClusterLights(unsigned cluster) const;
+    /// Return index of a light in a cluster.
+    unsigned GetClusterLight(unsigned cluster, unsigned index) const;
+
+    /// Return the shader parameter which maps clip space positions to clusters, taking the vertical flip of the rendering camera into account.
+    Vector4 GetShaderParameter(bool flipVertical) const;
+
+    /// Return the cluster texture, or null if not updated yet.
+    Texture2D* GetTexture() const { return texture_; }
+
+    /// Assign lights to the clusters of a range of depth slices. Called internally.
+    void AssignSlices(unsigned begin, unsigned end);
+
+private:
+    /// Cluster range of a light.
+    struct LightBounds
+    {
+        /// Tile range on X axis.
+        unsigned minX_, maxX_;
+        /// Tile range on Y axis.
+        unsigned minY_, maxY_;
+        /// Depth slice range. Empty if minimum is greater than maximum.
+        unsigned minSlice_, maxSlice_;
+    };
+
+    /// Return depth slice of a view space depth.
+    unsigned GetSlice(float depth) const;
+    /// Calculate the cluster range of a light.
+    LightBounds GetLightBounds(Light* light) const;
+
+    /// Cluster texture.
+    SharedPtr<Texture2D> texture_;
+    /// Assigned lights.
+    PODVector<Light*> lights_;
+    /// Cluster ranges of the assigned lights.
+    PODVector<LightBounds> lightBounds_;
+    /// Light indices of each cluster, MAX_LIGHTS_PER_CLUSTER per cluster.
+    PODVector<unsigned short> clusterLights_;
+    /// Number of lights in each cluster.
+    PODVector<unsigned char> clusterCounts_;
+    /// Cluster texture data.
+    PODVector<Vector4> textureData_;
+    /// Camera view transform.
+    Matrix3x4 view_;
+    /// Camera projection.
+    Matrix4 projection_;
+    /// Camera near clip distance.
+    float nearClip_{};
+    /// Camera far clip distance.
+    float farClip_{};
+    /// Scale from natural logarithm of depth to depth slice.
+    float sliceScale_{};
+    /// Bias from natural logarithm of depth to depth slice.
+    float sliceBias_{};
+    /// Whether the camera projection was flipped vertically during build.
+    bool flipVertical_{};
+    /// Total number of light indices written to the texture data.
+    unsigned numLightIndices_{};
+    /// Number of texture rows used by the texture data.
+    unsigned numRows_{};
+};
+
+}
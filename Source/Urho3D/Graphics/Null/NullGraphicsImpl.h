@@ -0,0 +1,143 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../../Graphics/GraphicsDefs.h"
+#include "../../Graphics/ShaderProgram.h"
+
+namespace Urho3D
+{
+
+using ShaderProgramMap = HashMap<Pair<ShaderVariation*, ShaderVariation*>, SharedPtr<ShaderProgram> >;
+
+/// Texture formats of the null graphics API. Only used to tell formats apart, no texel data is stored.
+enum NullTextureFormat
+{
+    NULL_FORMAT_UNKNOWN = 0,
+    NULL_FORMAT_A8,
+    NULL_FORMAT_R8,
+    NULL_FORMAT_RG8,
+    NULL_FORMAT_RGBA8,
+    NULL_FORMAT_RGBA16,
+    NULL_FORMAT_RGBA16F,
+    NULL_FORMAT_RGBA32F,
+    NULL_FORMAT_RG16,
+    NULL_FORMAT_RG16F,
+    NULL_FORMAT_RG32F,
+    NULL_FORMAT_R16F,
+    NULL_FORMAT_R32F,
+    NULL_FORMAT_D16,
+    NULL_FORMAT_D24S8,
+    NULL_FORMAT_D32,
+    NULL_FORMAT_DXT1,
+    NULL_FORMAT_DXT3,
+    NULL_FORMAT_DXT5
+};
+
+/// Work submitted to the null graphics API.
+struct NullGraphicsStats
+{
+    /// Non-instanced draw calls.
+    unsigned draws_{};
+    /// Instanced draw calls.
+    unsigned instancedDraws_{};
+    /// Instances drawn by instanced draw calls.
+    unsigned instances_{};
+    /// Primitives drawn.
+    unsigned primitives_{};
+    /// Shader program changes.
+    unsigned shaderChanges_{};
+    /// Texture binding changes applied at draw time.
+    unsigned textureChanges_{};
+    /// Rendertarget changes applied at draw time.
+    unsigned renderTargetChanges_{};
+    /// Vertex input, blend, depth, rasterizer and scissor state changes applied at draw time.
+    unsigned stateChanges_{};
+    /// Shader parameter updates.
+    unsigned parameterUpdates_{};
+    /// Clears.
+    unsigned clears_{};
+    /// Bytes written to vertex, index and constant buffers.
+    unsigned long long bufferUploadBytes_{};
+    /// Bytes written to textures.
+    unsigned long long textureUploadBytes_{};
+};
+
+/// %Graphics implementation. Records the submitted work instead of talking to a graphics API.
+class URHO3D_API GraphicsImpl
+{
+    friend class Graphics;
+
+public:
+    /// Construct.
+    GraphicsImpl();
+
+    /// Return work submitted since the last EndFrame().
+    const NullGraphicsStats& GetStats() const { return stats_; }
+
+    /// Return work submitted during the last completed frame.
+    const NullGraphicsStats& GetFrameStats() const { return frameStats_; }
+
+    /// Record bytes written to a buffer.
+    void RecordBufferUpload(unsigned bytes) { stats_.bufferUploadBytes_ += bytes; }
+
+    /// Record bytes written to a texture.
+    void RecordTextureUpload(unsigned bytes) { stats_.textureUploadBytes_ += bytes; }
+
+    /// Record a shader parameter update if the shader program in use has the parameter.
+    void RecordParameterUpdate(StringHash param)
+    {
+        if (shaderProgram_ && shaderProgram_->parameters_.Contains(param))
+            ++stats_.parameterUpdates_;
+    }
+
+private:
+    /// Initialized flag, set by the first successful screen mode change.
+    bool initialized_;
+    /// Rendertargets dirty flag.
+    bool renderTargetsDirty_;
+    /// Textures dirty flag.
+    bool texturesDirty_;
+    /// Vertex input dirty flag.
+    bool vertexDeclarationDirty_;
+    /// Blend state dirty flag.
+    bool blendStateDirty_;
+    /// Depth state dirty flag.
+    bool depthStateDirty_;
+    /// Rasterizer state dirty flag.
+    bool rasterizerStateDirty_;
+    /// Scissor rect dirty flag.
+    bool scissorRectDirty_;
+    /// Vertex buffer offsets, which change between instancing batches.
+    unsigned vertexOffsets_[MAX_VERTEX_STREAMS];
+    /// Shader programs.
+    ShaderProgramMap shaderPrograms_;
+    /// Shader program in use.
+    ShaderProgram* shaderProgram_;
+    /// Work submitted since the last EndFrame().
+    NullGraphicsStats stats_;
+    /// Work submitted during the last completed frame.
+    NullGraphicsStats frameStats_;
+};
+
+}
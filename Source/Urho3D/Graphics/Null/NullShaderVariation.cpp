@@ -0,0 +1,487 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../../Precompiled.h"
+
+#include "../../Graphics/Graphics.h"
+#include "../../Graphics/GraphicsImpl.h"
+#include "../../Graphics/Shader.h"
+#include "../../Graphics/ShaderVariation.h"
+#include "../../IO/Log.h"
+
+#include "../../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Return whether a character can be part of an identifier or a number.
+static bool IsIdentifierChar(char c)
+{
+    return IsAlpha((unsigned)c) || IsDigit((unsigned)c) || c == '_';
+}
+
+/// Split text into identifier, number and operator tokens.
+static void Tokenize(const String& text, Vector<String>& tokens)
+{
+    tokens.Clear();
+
+    unsigned i = 0;
+    while (i < text.Length())
+    {
+        char c = text[i];
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+            ++i;
+        else if (IsIdentifierChar(c))
+        {
+            unsigned start = i;
+            while (i < text.Length() && IsIdentifierChar(text[i]))
+                ++i;
+            tokens.Push(text.Substring(start, i - start));
+        }
+        else
+        {
+            String op(c);
+            if (i + 1 < text.Length())
+            {
+                char next = text[i + 1];
+                if ((c == '&' && next == '&') || (c == '|' && next == '|') || (next == '=' && (c == '=' || c == '!' || c == '<' ||
+                    c == '>')))
+                    op += next;
+            }
+            tokens.Push(op);
+            i += op.Length();
+        }
+    }
+}
+
+/// Replace comments in shader source with whitespace, keeping the line breaks.
+static String StripComments(const String& source)
+{
+    String result;
+    result.Reserve(source.Length());
+
+    unsigned i = 0;
+    while (i < source.Length())
+    {
+        if (source[i] == '/' && i + 1 < source.Length() && source[i + 1] == '/')
+        {
+            while (i < source.Length() && source[i] != '\n')
+                ++i;
+        }
+        else if (source[i] == '/' && i + 1 < source.Length() && source[i + 1] == '*')
+        {
+            i += 2;
+            while (i < source.Length() && !(source[i] == '*' && i + 1 < source.Length() && source[i + 1] == '/'))
+            {
+                if (source[i] == '\n')
+                    result += '\n';
+                ++i;
+            }
+            i += 2;
+        }
+        else
+            result += source[i++];
+    }
+
+    return result;
+}
+
+/// Minimal preprocessor which resolves conditional blocks of shader source. Macros are recorded for conditions but not expanded.
+class NullShaderPreprocessor
+{
+public:
+    /// Construct with defines in NAME or NAME=VALUE form.
+    explicit NullShaderPreprocessor(const Vector<String>& defines)
+    {
+        for (unsigned i = 0; i < defines.Size(); ++i)
+        {
+            if (defines[i].Empty())
+                continue;
+
+            unsigned equalsPos = defines[i].Find('=');
+            if (equalsPos != String::NPOS)
+                defines_[defines[i].Substring(0, equalsPos)] = defines[i].Substring(equalsPos + 1);
+            else
+                defines_[defines[i]] = "1";
+        }
+    }
+
+    /// Return the source lines which are active with the current defines. Directive lines are removed, except that the replacement text of macros is kept so that the names used through macros count as referenced.
+    String Process(const String& source)
+    {
+        struct Block
+        {
+            bool parentActive_;
+            bool taken_;
+        };
+
+        PODVector<Block> blocks;
+        bool active = true;
+        String result;
+        result.Reserve(source.Length());
+
+        Vector<String> lines = source.Split('\n', true);
+        for (unsigned i = 0; i < lines.Size(); ++i)
+        {
+            String line = lines[i].Trimmed();
+            if (!line.StartsWith("#"))
+            {
+                if (active)
+                {
+                    result += lines[i];
+                    result += '\n';
+                }
+                continue;
+            }
+
+            String directive = line.Substring(1).Trimmed();
+            unsigned keywordEnd = 0;
+            while (keywordEnd < directive.Length() && IsIdentifierChar(directive[keywordEnd]))
+                ++keywordEnd;
+            String keyword = directive.Substring(0, keywordEnd);
+            String argument = directive.Substring(keywordEnd).Trimmed();
+
+            if (keyword == "ifdef" || keyword == "ifndef" || keyword == "if")
+            {
+                bool condition = false;
+                if (active)
+                {
+                    if (keyword == "if")
+                        condition = Evaluate(argument);
+                    else
+                        condition = defines_.Contains(argument) == (keyword == "ifdef");
+                }
+                blocks.Push(Block{active, condition});
+                active = condition;
+            }
+            else if (keyword == "elif" && blocks.Size())
+            {
+                Block& block = blocks.Back();
+                active = block.parentActive_ && !block.taken_ && Evaluate(argument);
+                block.taken_ |= active;
+            }
+            else if (keyword == "else" && blocks.Size())
+            {
+                Block& block = blocks.Back();
+                active = block.parentActive_ && !block.taken_;
+                block.taken_ = true;
+            }
+            else if (keyword == "endif" && blocks.Size())
+            {
+                active = blocks.Back().parentActive_;
+                blocks.Pop();
+            }
+            else if (keyword == "define" && active)
+            {
+                unsigned nameEnd = 0;
+                while (nameEnd < argument.Length() && IsIdentifierChar(argument[nameEnd]))
+                    ++nameEnd;
+                String value = argument.Substring(nameEnd).Trimmed();
+                defines_[argument.Substring(0, nameEnd)] = value.Empty() ? String("1") : value;
+                result += value;
+                result += '\n';
+            }
+            else if (keyword == "undef" && active)
+                defines_.Erase(argument);
+        }
+
+        return result;
+    }
+
+private:
+    /// Evaluate a conditional expression.
+    bool Evaluate(const String& expression)
+    {
+        Tokenize(expression, tokens_);
+        position_ = 0;
+        return ParseOr() != 0;
+    }
+
+    /// Parse logical or.
+    int ParseOr()
+    {
+        int value = ParseAnd();
+        while (Accept("||"))
+        {
+            int rhs = ParseAnd();
+            value = (value || rhs) ? 1 : 0;
+        }
+        return value;
+    }
+
+    /// Parse logical and.
+    int ParseAnd()
+    {
+        int value = ParseCompare();
+        while (Accept("&&"))
+        {
+            int rhs = ParseCompare();
+            value = (value && rhs) ? 1 : 0;
+        }
+        return value;
+    }
+
+    /// Parse a comparison.
+    int ParseCompare()
+    {
+        int value = ParseUnary();
+        if (Accept("=="))
+            return value == ParseUnary() ? 1 : 0;
+        if (Accept("!="))
+            return value != ParseUnary() ? 1 : 0;
+        if (Accept("<="))
+            return value <= ParseUnary() ? 1 : 0;
+        if (Accept(">="))
+            return value >= ParseUnary() ? 1 : 0;
+        if (Accept("<"))
+            return value < ParseUnary() ? 1 : 0;
+        if (Accept(">"))
+            return value > ParseUnary() ? 1 : 0;
+        return value;
+    }
+
+    /// Parse negation, defined(), parentheses, numbers and macro values.
+    int ParseUnary()
+    {
+        if (position_ >= tokens_.Size())
+            return 0;
+
+        const String& token = tokens_[position_++];
+        if (token == "!")
+            return ParseUnary() ? 0 : 1;
+
+        if (token == "(")
+        {
+            int value = ParseOr();
+            Accept(")");
+            return value;
+        }
+
+        if (token == "defined")
+        {
+            bool parenthesized = Accept("(");
+            bool isDefined = position_ < tokens_.Size() && defines_.Contains(tokens_[position_]);
+            ++position_;
+            if (parenthesized)
+                Accept(")");
+            return isDefined ? 1 : 0;
+        }
+
+        if (IsDigit((unsigned)token[0]))
+            return ToInt(token);
+
+        HashMap<String, String>::ConstIterator i = defines_.Find(token);
+        return i != defines_.End() ? ToInt(i->second_) : 0;
+    }
+
+    /// Skip the next token if it matches.
+    bool Accept(const char* token)
+    {
+        if (position_ < tokens_.Size() && tokens_[position_] == token)
+        {
+            ++position_;
+            return true;
+        }
+        else
+            return false;
+    }
+
+    /// Defined macros and their values.
+    HashMap<String, String> defines_;
+    /// Tokens of the expression being evaluated.
+    Vector<String> tokens_;
+    /// Current token.
+    unsigned position_{};
+};
+
+void ShaderVariation::OnDeviceLost()
+{
+    // No-op on the null graphics API
+}
+
+bool ShaderVariation::Create()
+{
+    Release();
+
+    if (!graphics_)
+        return false;
+
+    if (!owner_)
+    {
+        compilerOutput_ = "Owner shader has expired";
+        return false;
+    }
+
+    if (!Compile())
+        return false;
+
+    // There is no API object; the object pointer only marks the shader as created
+    object_.ptr_ = this;
+    return true;
+}
+
+void ShaderVariation::Release()
+{
+    if (object_.ptr_ && graphics_)
+    {
+        graphics_->CleanupShaderPrograms(this);
+
+        if (type_ == VS)
+        {
+            if (graphics_->GetVertexShader() == this)
+                graphics_->SetShaders(nullptr, nullptr);
+        }
+        else
+        {
+            if (graphics_->GetPixelShader() == this)
+                graphics_->SetShaders(nullptr, nullptr);
+        }
+    }
+
+    object_.ptr_ = nullptr;
+
+    compilerOutput_.Clear();
+
+    for (unsigned i = 0; i < MAX_TEXTURE_UNITS; ++i)
+        useTextureUnits_[i] = false;
+    parameters_.Clear();
+}
+
+void ShaderVariation::SetDefines(const String& defines)
+{
+    defines_ = defines;
+}
+
+bool ShaderVariation::LoadByteCode(const String& binaryShaderName)
+{
+    // Not used on the null graphics API
+    return false;
+}
+
+bool ShaderVariation::Compile()
+{
+    const String& sourceCode = owner_->GetSourceCode(type_);
+    Vector<String> defines = defines_.Split(' ');
+    defines.Push(type_ == VS ? "COMPILEVS" : "COMPILEPS");
+    defines.Push("MAXBONES=" + String(Graphics::GetMaxBones()));
+
+    // Instead of compiling, resolve the conditional blocks and inspect the remaining code
+    NullShaderPreprocessor preprocessor(defines);
+    String code = preprocessor.Process(StripComments(sourceCode));
+    if (code.Trimmed().Empty())
+    {
+        compilerOutput_ = "No shader code remains after preprocessing";
+        return false;
+    }
+
+    if (type_ == VS)
+        URHO3D_LOGDEBUG("Scanned vertex shader " + GetFullName());
+    else
+        URHO3D_LOGDEBUG("Scanned pixel shader " + GetFullName());
+
+    ParseParameters((unsigned char*)code.CString(), code.Length());
+    return true;
+}
+
+void ShaderVariation::ParseParameters(unsigned char* bufData, unsigned bufSize)
+{
+    String code((const char*)bufData, bufSize);
+    Vector<String> tokens;
+
+    // Count the references to each identifier. A declaration alone does not make a parameter used, like in a compiled shader
+    HashMap<String, unsigned> references;
+    Tokenize(code, tokens);
+    for (unsigned i = 0; i < tokens.Size(); ++i)
+    {
+        if (IsAlpha((unsigned)tokens[i][0]) || tokens[i][0] == '_')
+            ++references[tokens[i]];
+    }
+
+    unsigned reg = 0;
+    Vector<String> lines = code.Split('\n');
+    for (unsigned i = 0; i < lines.Size(); ++i)
+    {
+        Tokenize(lines[i], tokens);
+        if (tokens.Size() < 3)
+            continue;
+
+        if (tokens[0] == "uniform")
+        {
+            const String& name = tokens[2];
+            if (name[0] != 'c' || references[name] < 2)
+                continue;
+
+            // Matrices take one register per column
+            unsigned columnsPos = tokens[1].Find('x');
+            unsigned regCount = columnsPos != String::NPOS ? ToUInt(tokens[1].Substring(columnsPos + 1)) : 1;
+            if (tokens.Size() > 4 && tokens[3] == "[")
+            {
+                unsigned arraySize = 1;
+                for (unsigned j = 4; j < tokens.Size() && tokens[j] != "]"; ++j)
+                {
+                    if (tokens[j] == "MAXBONES")
+                        arraySize *= Graphics::GetMaxBones();
+                    else if (IsDigit((unsigned)tokens[j][0]))
+                        arraySize *= ToUInt(tokens[j]);
+                }
+                regCount *= arraySize;
+            }
+
+            String paramName = name.Substring(1);
+            parameters_[StringHash(paramName)] = ShaderParameter{type_, paramName, reg, regCount};
+            reg += regCount;
+        }
+        else if (tokens[1][0] == 's' && tokens.Contains("register"))
+        {
+            // Samplers are referenced through the sampling macros by their name without the prefix
+            const String& name = tokens[1];
+            String unitName = name.Substring(1);
+            if (references[name] < 2 && !references.Contains(unitName))
+                continue;
+
+            for (unsigned j = 0; j + 2 < tokens.Size(); ++j)
+            {
+                if (tokens[j] == "register" && tokens[j + 1] == "(" && tokens[j + 2][0] == 's')
+                {
+                    // Skip if it's a G-buffer sampler, which are aliases for the standard texture units
+                    unsigned unit = ToUInt(tokens[j + 2].Substring(1));
+                    if (unit < MAX_TEXTURE_UNITS && unitName != "AlbedoBuffer" && unitName != "NormalBuffer" &&
+                        unitName != "DepthBuffer" && unitName != "LightBuffer")
+                        useTextureUnits_[unit] = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void ShaderVariation::SaveByteCode(const String& binaryShaderName)
+{
+    // Not used on the null graphics API
+}
+
+void ShaderVariation::CalculateConstantBufferSizes()
+{
+    // Not used on the null graphics API
+}
+
+}
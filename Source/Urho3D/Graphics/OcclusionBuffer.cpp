@@ -28,6 +28,11 @@
 #include "../Graphics/OcclusionBuffer.h"
 #include "../IO/Log.h"
 
+#if defined(URHO3D_SSE) || defined(__SSE2__) || defined(_M_X64)
+#define URHO3D_OCCLUSION_SSE2
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -44,11 +49,33 @@ enum ClipMask : unsigned
 };
 URHO3D_FLAGSET(ClipMask, ClipMaskFlags);
 
-void DrawOcclusionBatchWork(const WorkItem* item, unsigned threadIndex)
+/// Write the smaller of the stepped depth and the buffer depth to a row of pixels.
+inline void DrawSpan(int* dest, int* end, int invZ, int dInvZdX)
 {
-    auto* buffer = reinterpret_cast<OcclusionBuffer*>(item->aux_);
-    OcclusionBatch& batch = *reinterpret_cast<OcclusionBatch*>(item->start_);
-    buffer->DrawBatch(batch, threadIndex);
+#ifdef URHO3D_OCCLUSION_SSE2
+    if (end - dest >= 4)
+    {
+        __m128i z = _mm_setr_epi32(invZ, invZ + dInvZdX, invZ + 2 * dInvZdX, invZ + 3 * dInvZdX);
+        const __m128i step = _mm_set1_epi32(4 * dInvZdX);
+        for (; dest + 4 <= end; dest += 4)
+        {
+            // SSE2 has no 32-bit integer minimum, so select by comparison
+            __m128i old = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest));
+            __m128i closer = _mm_cmplt_epi32(z, old);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_or_si128(_mm_and_si128(closer, z), _mm_andnot_si128(closer, old)));
+            z = _mm_add_epi32(z, step);
+        }
+        invZ = _mm_cvtsi128_si32(z);
+    }
+#endif
+
+    while (dest < end)
+    {
+        if (invZ < *dest)
+            *dest = invZ;
+        invZ += dInvZdX;
+        ++dest;
+    }
 }
 
 OcclusionBuffer::OcclusionBuffer(Context* context) :
@@ -79,17 +106,16 @@ bool OcclusionBuffer::SetSize(int width, int height, bool threaded)
     width_ = width;
     height_ = height;
 
-    // Build work buffers for threading
-    unsigned numThreadBuffers = threaded ? GetSubsystem<WorkQueue>()->GetNumThreads() + 1 : 1;
-    buffers_.Resize(numThreadBuffers);
-    for (unsigned i = 0; i < numThreadBuffers; ++i)
-    {
-        // Reserve extra memory in case 3D clipping is not exact
-        OcclusionBufferData& buffer = buffers_[i];
-        buffer.dataWithSafety_ = new int[width * (height + 2) + 2];
-        buffer.data_ = buffer.dataWithSafety_.Get() + width + 1;
-        buffer.used_ = false;
-    }
+    // Reserve extra memory in case 3D clipping is not exact
+    buffers_.Resize(1);
+    OcclusionBufferData& buffer = buffers_[0];
+    buffer.dataWithSafety_ = new int[width * (height + 2) + 2];
+    buffer.data_ = buffer.dataWithSafety_.Get() + width + 1;
+
+    // Threads set up and bin triangles separately, but rasterize into the same buffer
+    unsigned numThreads = threaded ? GetSubsystem<WorkQueue>()->GetNumThreads() + 1 : 1;
+    threaded_ = numThreads > 1;
+    threadData_.Resize(numThreads);
 
     mipBuffers_.Clear();
 
@@ -106,7 +132,7 @@ bool OcclusionBuffer::SetSize(int width, int height, bool threaded)
     }
 
     URHO3D_LOGDEBUG("Set occlusion buffer size " + String(width_) + "x" + String(height_) + " with " +
-             String(mipBuffers_.Size()) + " mip levels and " + String(numThreadBuffers) + " thread buffers");
+             String(mipBuffers_.Size()) + " mip levels and " + String(numThreads) + " threads");
 
     CalculateViewport();
     return true;
@@ -152,12 +178,7 @@ void OcclusionBuffer::Reset()
 void OcclusionBuffer::Clear()
 {
     Reset();
-
-    // Only clear the main thread buffer. Rest are cleared on-demand when drawing the first batch
-    ClearBuffer(0);
-    for (unsigned i = 1; i < buffers_.Size(); ++i)
-        buffers_[i].used_ = false;
-
+    ClearBuffer();
     depthHierarchyDirty_ = true;
 }
 
@@ -199,38 +220,73 @@ bool OcclusionBuffer::AddTriangles(const Matrix3x4& model, const void* vertexDat
 
 void OcclusionBuffer::DrawTriangles()
 {
-    if (buffers_.Size() == 1)
+    if (buffers_.Empty())
     {
-        // Not threaded
+        batches_.Clear();
+        return;
+    }
+
+    if (!threaded_)
+    {
+        threadData_[0].numDrawn_ = 0;
         for (Vector<OcclusionBatch>::Iterator i = batches_.Begin(); i != batches_.End(); ++i)
             DrawBatch(*i, 0);
-
-        depthHierarchyDirty_ = true;
     }
-    else if (buffers_.Size() > 1)
+    else
     {
-        // Threaded
         auto* queue = GetSubsystem<WorkQueue>();
+        const unsigned numBands = (unsigned)((height_ + OCCLUSION_BAND_HEIGHT - 1) / OCCLUSION_BAND_HEIGHT);
 
-        for (Vector<OcclusionBatch>::Iterator i = batches_.Begin(); i != batches_.End(); ++i)
+        for (Vector<OcclusionThreadData>::Iterator i = threadData_.Begin(); i != threadData_.End(); ++i)
         {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = DrawOcclusionBatchWork;
-            item->aux_ = this;
-            item->start_ = &(*i);
-            queue->AddWorkItem(item);
+            i->triangles_.Clear();
+            i->bins_.Resize(numBands);
+            for (unsigned j = 0; j < numBands; ++j)
+                i->bins_[j].Clear();
+            i->numDrawn_ = 0;
         }
 
-        queue->Complete(M_MAX_UNSIGNED);
+        // Transform, clip and project the batches, with each thread binning the triangles into its own lists
+        binning_ = true;
+        const OcclusionBatch* batches = batches_.Buffer();
+        queue->ParallelFor(batches_.Size(), 0, [this, batches](unsigned begin, unsigned end, unsigned threadIndex)
+        {
+            for (unsigned i = begin; i < end; ++i)
+                DrawBatch(batches[i], threadIndex);
+        });
+        binning_ = false;
 
-        MergeBuffers();
-        depthHierarchyDirty_ = true;
+        // Each band of rows is rasterized by one thread only, so the threads can share the buffer without merging
+        queue->ParallelFor(numBands, 1, [this](unsigned begin, unsigned end, unsigned /*threadIndex*/)
+        {
+            for (unsigned i = begin; i < end; ++i)
+                DrawBand(i);
+        });
     }
 
+    for (Vector<OcclusionThreadData>::ConstIterator i = threadData_.Begin(); i != threadData_.End(); ++i)
+        numTriangles_ += i->numDrawn_;
+
+    depthHierarchyDirty_ = true;
     batches_.Clear();
 }
 
+void OcclusionBuffer::DrawBand(unsigned band)
+{
+    const int minY = (int)band * OCCLUSION_BAND_HEIGHT;
+    const int maxY = Min(minY + OCCLUSION_BAND_HEIGHT, height_);
+
+    for (Vector<OcclusionThreadData>::ConstIterator i = threadData_.Begin(); i != threadData_.End(); ++i)
+    {
+        const PODVector<unsigned>& bin = i->bins_[band];
+        for (PODVector<unsigned>::ConstIterator j = bin.Begin(); j != bin.End(); ++j)
+        {
+            const OcclusionTriangle& triangle = i->triangles_[*j];
+            DrawTriangle2D(triangle.vertices_, triangle.clockwise_, minY, maxY);
+        }
+    }
+}
+
 void OcclusionBuffer::BuildDepthHierarchy()
 {
     if (buffers_.Empty() || !depthHierarchyDirty_)
@@ -379,6 +435,96 @@ bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
         if (projected.z_ < minZ) minZ = projected.z_;
     }
 
+    return IsVisible(minX, minY, maxX, maxY, minZ);
+}
+
+void OcclusionBuffer::IsVisible(const BoundingBox* worldSpaceBoxes, unsigned count, bool* visible) const
+{
+    if (buffers_.Empty())
+    {
+        for (unsigned i = 0; i < count; ++i)
+            visible[i] = true;
+        return;
+    }
+
+#ifdef URHO3D_OCCLUSION_SSE2
+    // Transform the 8 corners of a box as 2 vectors of 4 corners per coordinate. Uses the same operations as the one box test
+    const Matrix4& m = viewProj_;
+    const __m128 m00 = _mm_set1_ps(m.m00_), m01 = _mm_set1_ps(m.m01_), m02 = _mm_set1_ps(m.m02_), m03 = _mm_set1_ps(m.m03_);
+    const __m128 m10 = _mm_set1_ps(m.m10_), m11 = _mm_set1_ps(m.m11_), m12 = _mm_set1_ps(m.m12_), m13 = _mm_set1_ps(m.m13_);
+    const __m128 m20 = _mm_set1_ps(m.m20_), m21 = _mm_set1_ps(m.m21_), m22 = _mm_set1_ps(m.m22_), m23 = _mm_set1_ps(m.m23_);
+    const __m128 m30 = _mm_set1_ps(m.m30_), m31 = _mm_set1_ps(m.m31_), m32 = _mm_set1_ps(m.m32_), m33 = _mm_set1_ps(m.m33_);
+    const __m128 scaleX = _mm_set1_ps(scaleX_), scaleY = _mm_set1_ps(scaleY_), scaleZ = _mm_set1_ps(OCCLUSION_Z_SCALE);
+    const __m128 offsetX = _mm_set1_ps(offsetX_), offsetY = _mm_set1_ps(offsetY_), bias = _mm_set1_ps(OCCLUSION_RELATIVE_BIAS);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        const BoundingBox& box = worldSpaceBoxes[i];
+        const __m128 x = _mm_setr_ps(box.min_.x_, box.max_.x_, box.min_.x_, box.max_.x_);
+        const __m128 y = _mm_setr_ps(box.min_.y_, box.min_.y_, box.max_.y_, box.max_.y_);
+        __m128 minX, maxX, minY, maxY, minZ;
+        bool crossesNearPlane = false;
+
+        for (unsigned j = 0; j < 2; ++j)
+        {
+            const __m128 z = _mm_set1_ps(j ? box.max_.z_ : box.min_.z_);
+            const __m128 clipX = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m01, y)), _mm_mul_ps(m02, z)), m03);
+            const __m128 clipY = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m10, x), _mm_mul_ps(m11, y)), _mm_mul_ps(m12, z)), m13);
+            const __m128 clipZ = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m20, x), _mm_mul_ps(m21, y)),
+                _mm_mul_ps(m22, z)), m23), bias);
+            const __m128 clipW = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m30, x), _mm_mul_ps(m31, y)), _mm_mul_ps(m32, z)), m33);
+
+            if (_mm_movemask_ps(_mm_cmple_ps(clipZ, _mm_setzero_ps())))
+            {
+                crossesNearPlane = true;
+                break;
+            }
+
+            const __m128 invW = _mm_div_ps(one, clipW);
+            const __m128 projX = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(invW, clipX), scaleX), offsetX);
+            const __m128 projY = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(invW, clipY), scaleY), offsetY);
+            const __m128 projZ = _mm_mul_ps(_mm_mul_ps(invW, clipZ), scaleZ);
+            if (!j)
+            {
+                minX = maxX = projX;
+                minY = maxY = projY;
+                minZ = projZ;
+            }
+            else
+            {
+                minX = _mm_min_ps(minX, projX);
+                maxX = _mm_max_ps(maxX, projX);
+                minY = _mm_min_ps(minY, projY);
+                maxY = _mm_max_ps(maxY, projY);
+                minZ = _mm_min_ps(minZ, projZ);
+            }
+        }
+
+        if (crossesNearPlane)
+        {
+            visible[i] = true;
+            continue;
+        }
+
+        float minXs[4], maxXs[4], minYs[4], maxYs[4], minZs[4];
+        _mm_storeu_ps(minXs, minX);
+        _mm_storeu_ps(maxXs, maxX);
+        _mm_storeu_ps(minYs, minY);
+        _mm_storeu_ps(maxYs, maxY);
+        _mm_storeu_ps(minZs, minZ);
+        visible[i] = IsVisible(Min(Min(minXs[0], minXs[1]), Min(minXs[2], minXs[3])), Min(Min(minYs[0], minYs[1]), Min(minYs[2], minYs[3])),
+            Max(Max(maxXs[0], maxXs[1]), Max(maxXs[2], maxXs[3])), Max(Max(maxYs[0], maxYs[1]), Max(maxYs[2], maxYs[3])),
+            Min(Min(minZs[0], minZs[1]), Min(minZs[2], minZs[3])));
+    }
+#else
+    for (unsigned i = 0; i < count; ++i)
+        visible[i] = IsVisible(worldSpaceBoxes[i]);
+#endif
+}
+
+bool OcclusionBuffer::IsVisible(float minX, float minY, float maxX, float maxY, float minZ) const
+{
     // Expand the bounding box 1 pixel in each direction to be conservative and correct rasterization offset
     IntRect rect((int)(minX - 1.5f), (int)(minY - 1.5f), RoundToInt(maxX), RoundToInt(maxY));
 
@@ -463,13 +609,6 @@ unsigned OcclusionBuffer::GetUseTimer()
 
 void OcclusionBuffer::DrawBatch(const OcclusionBatch& batch, unsigned threadIndex)
 {
-    // If buffer not yet used, clear it
-    if (threadIndex > 0 && !buffers_[threadIndex].used_)
-    {
-        ClearBuffer(threadIndex);
-        buffers_[threadIndex].used_ = true;
-    }
-
     Matrix4 modelViewProj = viewProj_ * batch.model_;
 
     // Theoretical max. amount of vertices if each of the 6 clipping planes doubles the triangle count
@@ -633,7 +772,7 @@ void OcclusionBuffer::DrawTriangle(Vector4* vertices, unsigned threadIndex)
         bool clockwise = SignedArea(projected[0], projected[1], projected[2]) < 0.0f;
         if (cullMode_ == CULL_NONE || (cullMode_ == CULL_CCW && clockwise) || (cullMode_ == CULL_CW && !clockwise))
         {
-            DrawTriangle2D(projected, clockwise, threadIndex);
+            SubmitTriangle2D(projected, clockwise, threadIndex);
             drawOk = true;
         }
     }
@@ -671,7 +810,7 @@ void OcclusionBuffer::DrawTriangle(Vector4* vertices, unsigned threadIndex)
                 bool clockwise = SignedArea(projected[0], projected[1], projected[2]) < 0.0f;
                 if (cullMode_ == CULL_NONE || (cullMode_ == CULL_CCW && clockwise) || (cullMode_ == CULL_CW && !clockwise))
                 {
-                    DrawTriangle2D(projected, clockwise, threadIndex);
+                    SubmitTriangle2D(projected, clockwise, threadIndex);
                     drawOk = true;
                 }
             }
@@ -679,7 +818,7 @@ void OcclusionBuffer::DrawTriangle(Vector4* vertices, unsigned threadIndex)
     }
 
     if (drawOk)
-        ++numTriangles_;
+        ++threadData_[threadIndex].numDrawn_;
 }
 
 void OcclusionBuffer::ClipVertices(const Vector4& plane, Vector4* vertices, bool* triangles, unsigned& numTriangles)
@@ -812,7 +951,60 @@ struct Edge
     int invZStep_;
 };
 
-void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise, unsigned threadIndex)
+/// Draw the rows [startY, endY) between a left and a right edge, clipped to the rows [minY, maxY).
+inline void DrawRows(int* bufferData, int width, Edge& left, Edge& right, int startY, int endY, int minY, int maxY, int dInvZdX)
+{
+    // Step the edges over the clipped rows at once. This is exact, as the edges step in fixed point
+    const int skip = Clamp(minY - startY, 0, endY - startY);
+    left.x_ += skip * left.xStep_;
+    left.invZ_ += skip * left.invZStep_;
+    right.x_ += skip * right.xStep_;
+
+    int* row = bufferData + (startY + skip) * width;
+    int* endRow = bufferData + Min(endY, maxY) * width;
+    while (row < endRow)
+    {
+        DrawSpan(row + (left.x_ >> 16u), row + (right.x_ >> 16u), left.invZ_, dInvZdX);
+
+        left.x_ += left.xStep_;
+        left.invZ_ += left.invZStep_;
+        right.x_ += right.xStep_;
+        row += width;
+    }
+}
+
+void OcclusionBuffer::SubmitTriangle2D(const Vector3* vertices, bool clockwise, unsigned threadIndex)
+{
+    if (!binning_)
+    {
+        DrawTriangle2D(vertices, clockwise, 0, height_);
+        return;
+    }
+
+    // Bin by the rows the triangle covers. As when drawing, vertex Y coordinates are truncated and the bottom row is excluded
+    const auto topY = (int)Min(Min(vertices[0].y_, vertices[1].y_), vertices[2].y_);
+    const auto bottomY = (int)Max(Max(vertices[0].y_, vertices[1].y_), vertices[2].y_);
+    if (topY == bottomY)
+        return;
+
+    OcclusionThreadData& data = threadData_[threadIndex];
+    const int lastBand = (int)data.bins_.Size() - 1;
+    const int firstBand = Clamp(topY / OCCLUSION_BAND_HEIGHT, 0, lastBand);
+    const int endBand = Clamp((bottomY - 1) / OCCLUSION_BAND_HEIGHT, 0, lastBand) + 1;
+    const unsigned index = data.triangles_.Size();
+
+    data.triangles_.Resize(index + 1);
+    OcclusionTriangle& triangle = data.triangles_.Back();
+    triangle.vertices_[0] = vertices[0];
+    triangle.vertices_[1] = vertices[1];
+    triangle.vertices_[2] = vertices[2];
+    triangle.clockwise_ = clockwise;
+
+    for (int i = firstBand; i < endBand; ++i)
+        data.bins_[i].Push(index);
+}
+
+void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise, int minY, int maxY)
 {
     int top, middle, bottom;
     bool middleIsRight;
@@ -875,8 +1067,8 @@ void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise, un
     auto middleY = (int)vertices[middle].y_;
     auto bottomY = (int)vertices[bottom].y_;
 
-    // Check for degenerate triangle
-    if (topY == bottomY)
+    // Check for degenerate triangle, or a triangle outside the rows to draw
+    if (topY == bottomY || topY >= maxY || bottomY <= minY)
         return;
 
     // Reverse middleIsRight test if triangle is counterclockwise
@@ -889,7 +1081,7 @@ void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise, un
     Gradients gradients(vertices);
     Edge topToBottom(gradients, vertices[top], vertices[bottom], topY);
 
-    int* bufferData = buffers_[threadIndex].data_;
+    int* bufferData = buffers_[0].data_;
 
     if (middleIsRight)
     {
@@ -897,52 +1089,14 @@ void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise, un
         if (!topDegenerate)
         {
             Edge topToMiddle(gradients, vertices[top], vertices[middle], topY);
-            int* row = bufferData + topY * width_;
-            int* endRow = bufferData + middleY * width_;
-            while (row < endRow)
-            {
-                int invZ = topToBottom.invZ_;
-                int* dest = row + (topToBottom.x_ >> 16u);
-                int* end = row + (topToMiddle.x_ >> 16u);
-                while (dest < end)
-                {
-                    if (invZ < *dest)
-                        *dest = invZ;
-                    invZ += gradients.dInvZdXInt_;
-                    ++dest;
-                }
-
-                topToBottom.x_ += topToBottom.xStep_;
-                topToBottom.invZ_ += topToBottom.invZStep_;
-                topToMiddle.x_ += topToMiddle.xStep_;
-                row += width_;
-            }
+            DrawRows(bufferData, width_, topToBottom, topToMiddle, topY, middleY, minY, maxY, gradients.dInvZdXInt_);
         }
 
         // Bottom half
         if (!bottomDegenerate)
         {
             Edge middleToBottom(gradients, vertices[middle], vertices[bottom], middleY);
-            int* row = bufferData + middleY * width_;
-            int* endRow = bufferData + bottomY * width_;
-            while (row < endRow)
-            {
-                int invZ = topToBottom.invZ_;
-                int* dest = row + (topToBottom.x_ >> 16u);
-                int* end = row + (middleToBottom.x_ >> 16u);
-                while (dest < end)
-                {
-                    if (invZ < *dest)
-                        *dest = invZ;
-                    invZ += gradients.dInvZdXInt_;
-                    ++dest;
-                }
-
-                topToBottom.x_ += topToBottom.xStep_;
-                topToBottom.invZ_ += topToBottom.invZStep_;
-                middleToBottom.x_ += middleToBottom.xStep_;
-                row += width_;
-            }
+            DrawRows(bufferData, width_, topToBottom, middleToBottom, middleY, bottomY, minY, maxY, gradients.dInvZdXInt_);
         }
     }
     else
@@ -951,86 +1105,24 @@ void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise, un
         if (!topDegenerate)
         {
             Edge topToMiddle(gradients, vertices[top], vertices[middle], topY);
-            int* row = bufferData + topY * width_;
-            int* endRow = bufferData + middleY * width_;
-            while (row < endRow)
-            {
-                int invZ = topToMiddle.invZ_;
-                int* dest = row + (topToMiddle.x_ >> 16u);
-                int* end = row + (topToBottom.x_ >> 16u);
-                while (dest < end)
-                {
-                    if (invZ < *dest)
-                        *dest = invZ;
-                    invZ += gradients.dInvZdXInt_;
-                    ++dest;
-                }
-
-                topToMiddle.x_ += topToMiddle.xStep_;
-                topToMiddle.invZ_ += topToMiddle.invZStep_;
-                topToBottom.x_ += topToBottom.xStep_;
-                row += width_;
-            }
+            DrawRows(bufferData, width_, topToMiddle, topToBottom, topY, middleY, minY, maxY, gradients.dInvZdXInt_);
         }
 
         // Bottom half
         if (!bottomDegenerate)
         {
             Edge middleToBottom(gradients, vertices[middle], vertices[bottom], middleY);
-            int* row = bufferData + middleY * width_;
-            int* endRow = bufferData + bottomY * width_;
-            while (row < endRow)
-            {
-                int invZ = middleToBottom.invZ_;
-                int* dest = row + (middleToBottom.x_ >> 16u);
-                int* end = row + (topToBottom.x_ >> 16u);
-                while (dest < end)
-                {
-                    if (invZ < *dest)
-                        *dest = invZ;
-                    invZ += gradients.dInvZdXInt_;
-                    ++dest;
-                }
-
-                middleToBottom.x_ += middleToBottom.xStep_;
-                middleToBottom.invZ_ += middleToBottom.invZStep_;
-                topToBottom.x_ += topToBottom.xStep_;
-                row += width_;
-            }
+            DrawRows(bufferData, width_, middleToBottom, topToBottom, middleY, bottomY, minY, maxY, gradients.dInvZdXInt_);
         }
     }
 }
 
-void OcclusionBuffer::MergeBuffers()
+void OcclusionBuffer::ClearBuffer()
 {
-    URHO3D_PROFILE(MergeBuffers);
-
-    for (unsigned i = 1; i < buffers_.Size(); ++i)
-    {
-        if (!buffers_[i].used_)
-            continue;
-
-        int* src = buffers_[i].data_;
-        int* dest = buffers_[0].data_;
-        int count = width_ * height_;
-
-        while (count--)
-        {
-            // If thread buffer's depth value is closer, overwrite the original
-            if (*src < *dest)
-                *dest = *src;
-            ++src;
-            ++dest;
-        }
-    }
-}
-
-void OcclusionBuffer::ClearBuffer(unsigned threadIndex)
-{
-    if (threadIndex >= buffers_.Size())
+    if (buffers_.Empty())
         return;
 
-    int* dest = buffers_[threadIndex].data_;
+    int* dest = buffers_[0].data_;
     int count = width_ * height_;
     auto fillValue = (int)OCCLUSION_Z_SCALE;
 
@@ -50,15 +50,33 @@ struct DepthValue
     int max_;
 };
 
-/// Per-thread occlusion buffer data.
+/// Occlusion buffer data.
 struct OcclusionBufferData
 {
     /// Full buffer data with safety padding.
     SharedArrayPtr<int> dataWithSafety_;
     /// Buffer data.
     int* data_;
-    /// Use flag.
-    bool used_;
+};
+
+/// Screen space triangle stored for threaded rasterization.
+struct OcclusionTriangle
+{
+    /// Vertices in buffer coordinates, with depth in Z.
+    Vector3 vertices_[3];
+    /// Clockwise flag.
+    bool clockwise_;
+};
+
+/// Per-thread triangle setup results of threaded occlusion rendering.
+struct OcclusionThreadData
+{
+    /// Triangles set up by the thread.
+    PODVector<OcclusionTriangle> triangles_;
+    /// Indices of the triangles overlapping each horizontal band of the buffer.
+    Vector<PODVector<unsigned> > bins_;
+    /// Number of triangles drawn.
+    unsigned numDrawn_;
 };
 
 /// Stored occlusion render job.
@@ -81,6 +99,8 @@ struct OcclusionBatch
 };
 
 static const int OCCLUSION_MIN_SIZE = 8;
+static const int OCCLUSION_BAND_HEIGHT = 8;
+static const unsigned OCCLUSION_TEST_BATCH_SIZE = 64;
 static const int OCCLUSION_DEFAULT_MAX_TRIANGLES = 5000;
 static const float OCCLUSION_RELATIVE_BIAS = 0.00001f;
 static const int OCCLUSION_FIXED_BIAS = 16;
@@ -115,7 +135,7 @@ public:
     /// Submit a triangle mesh to the buffer using indexed geometry. Return true if did not overflow the allowed triangle count.
     bool AddTriangles(const Matrix3x4& model, const void* vertexData, unsigned vertexSize, const void* indexData, unsigned indexSize,
         unsigned indexStart, unsigned indexCount);
-    /// Draw submitted batches. Uses worker threads if enabled during SetSize().
+    /// Draw submitted batches. If threading was enabled during SetSize(), the batches are set up in worker threads, and the triangles binned into horizontal bands of the buffer which are then rasterized in worker threads.
     void DrawTriangles();
     /// Build reduced size mip levels.
     void BuildDepthHierarchy();
@@ -147,15 +167,19 @@ public:
     CullMode GetCullMode() const { return cullMode_; }
 
     /// Return whether is using threads to speed up rendering.
-    bool IsThreaded() const { return buffers_.Size() > 1; }
+    bool IsThreaded() const { return threaded_; }
 
     /// Test a bounding box for visibility. For best performance, build depth hierarchy first.
     bool IsVisible(const BoundingBox& worldSpaceBox) const;
+    /// Test bounding boxes for visibility and write a result for each. Faster than testing the boxes one at a time.
+    void IsVisible(const BoundingBox* worldSpaceBoxes, unsigned count, bool* visible) const;
     /// Return time since last use in milliseconds.
     unsigned GetUseTimer();
 
-    /// Draw a batch. Called internally.
+    /// Draw a batch, or bin its triangles when drawing threaded. Called internally.
     void DrawBatch(const OcclusionBatch& batch, unsigned threadIndex);
+    /// Rasterize the binned triangles overlapping a horizontal band of the buffer. Called internally.
+    void DrawBand(unsigned band);
 
 private:
     /// Apply modelview transform to vertex.
@@ -172,15 +196,19 @@ private:
     void DrawTriangle(Vector4* vertices, unsigned threadIndex);
     /// Clip vertices against a plane.
     void ClipVertices(const Vector4& plane, Vector4* vertices, bool* triangles, unsigned& numTriangles);
-    /// Draw a clipped triangle.
-    void DrawTriangle2D(const Vector3* vertices, bool clockwise, unsigned threadIndex);
-    /// Clear a thread work buffer.
-    void ClearBuffer(unsigned threadIndex);
-    /// Merge thread work buffers into the first buffer.
-    void MergeBuffers();
-
-    /// Highest-level buffer data per thread.
+    /// Draw a clipped triangle, or bin it when drawing threaded.
+    void SubmitTriangle2D(const Vector3* vertices, bool clockwise, unsigned threadIndex);
+    /// Draw the rows of a clipped triangle within [minY, maxY).
+    void DrawTriangle2D(const Vector3* vertices, bool clockwise, int minY, int maxY);
+    /// Test the screen space bounds of a box for visibility.
+    bool IsVisible(float minX, float minY, float maxX, float maxY, float minZ) const;
+    /// Clear the buffer data.
+    void ClearBuffer();
+
+    /// Highest-level buffer data.
     Vector<OcclusionBufferData> buffers_;
+    /// Per-thread triangle setup results.
+    Vector<OcclusionThreadData> threadData_;
     /// Reduced size depth buffers.
     Vector<SharedArrayPtr<DepthValue> > mipBuffers_;
     /// Submitted render jobs.
@@ -197,6 +225,10 @@ private:
     CullMode cullMode_{CULL_CCW};
     /// Depth hierarchy needs update flag.
     bool depthHierarchyDirty_{true};
+    /// Threaded drawing flag.
+    bool threaded_{};
+    /// Binning triangles for threaded drawing flag.
+    bool binning_{};
     /// Culling reverse flag.
     bool reverseCulling_{};
     /// View transform matrix.
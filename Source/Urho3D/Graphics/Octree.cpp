@@ -24,9 +24,11 @@
 
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
+#include "../Core/FrameAllocator.h"
 #include "../Core/Profiler.h"
 #include "../Core/Thread.h"
 #include "../Core/WorkQueue.h"
+#include "../Graphics/AnimationScheduler.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/Octree.h"
@@ -46,14 +48,19 @@ namespace Urho3D
 static const float DEFAULT_OCTREE_SIZE = 1000.0f;
 static const int DEFAULT_OCTREE_LEVELS = 8;
 
-extern const char* SUBSYSTEM_CATEGORY;
+static const unsigned AABB_TREE_BATCH_SIZE = 64;
 
-void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex)
+static const char* spatialIndexNames[] =
 {
-    const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
-    auto** start = reinterpret_cast<Drawable**>(item->start_);
-    auto** end = reinterpret_cast<Drawable**>(item->end_);
+    "Octree",
+    "AABB Tree",
+    nullptr
+};
+
+extern const char* SUBSYSTEM_CATEGORY;
 
+void UpdateDrawablesWork(const FrameInfo& frame, Drawable** start, Drawable** end)
+{
     while (start != end)
     {
         Drawable* drawable = *start;
@@ -81,14 +88,17 @@ Octant::~Octant()
 {
     if (root_)
     {
-        // Remove the drawables (if any) from this octant to the root octant
+        // Remove the drawables (if any) from this octant to the root octant. Do not queue drawables twice, as they would be
+        // reinserted twice
         for (PODVector<Drawable*>::Iterator i = drawables_.Begin(); i != drawables_.End(); ++i)
         {
-            (*i)->SetOctant(root_);
-            root_->drawables_.Push(*i);
-            root_->QueueUpdate(*i);
+            root_->PushDrawable(*i);
+            if (!(*i)->updateQueued_)
+                root_->QueueUpdate(*i);
         }
         drawables_.Clear();
+        packedBounds_.Clear();
+        hasPackedBounds_ = false;
         numDrawables_ = 0;
     }
 
@@ -124,6 +134,41 @@ Octant* Octant::GetOrCreateChild(unsigned index)
     return children_[index];
 }
 
+void Octant::RemoveDrawableAt(unsigned index, Drawable* drawable, bool resetOctant)
+{
+    if (index >= drawables_.Size() || drawables_[index] != drawable)
+        return;
+
+    if (drawable->aabbTreeProxy_ != NULL_AABB_NODE && root_)
+        root_->DestroyAabbTreeProxy(drawable);
+
+    // Swap the last drawable in place to keep the removal constant time and the packed bounds parallel
+    drawables_.EraseSwap(index);
+    if (hasPackedBounds_)
+    {
+        packedBounds_.EraseSwap(index);
+        if (drawables_.Size() < PACKED_BOUNDS_THRESHOLD / 2)
+        {
+            packedBounds_.Clear();
+            hasPackedBounds_ = false;
+        }
+    }
+    if (index < drawables_.Size())
+        drawables_[index]->octantIndex_ = index;
+
+    if (resetOctant)
+        drawable->SetOctant(nullptr);
+    DecDrawableCount();
+}
+
+void Octant::CreatePackedBounds()
+{
+    packedBounds_.Clear();
+    for (PODVector<Drawable*>::ConstIterator i = drawables_.Begin(); i != drawables_.End(); ++i)
+        PushPackedBounds(*i);
+    hasPackedBounds_ = true;
+}
+
 void Octant::DeleteChild(unsigned index)
 {
     assert(index < NUM_OCTANTS);
@@ -149,9 +194,10 @@ void Octant::InsertDrawable(Drawable* drawable)
         if (oldOctant != this)
         {
             // Add first, then remove, because drawable count going to zero deletes the octree branch in question
+            unsigned oldIndex = drawable->octantIndex_;
             AddDrawable(drawable);
             if (oldOctant)
-                oldOctant->RemoveDrawable(drawable, false);
+                oldOctant->RemoveDrawableAt(oldIndex, drawable, false);
         }
     }
     else
@@ -243,8 +289,10 @@ void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
     if (drawables_.Size())
     {
         auto** start = const_cast<Drawable**>(&drawables_[0]);
-        Drawable** end = start + drawables_.Size();
-        query.TestDrawables(start, end, inside);
+        if (hasPackedBounds_)
+            query.TestPackedDrawables(start, packedBounds_, inside);
+        else
+            query.TestDrawables(start, start + drawables_.Size(), inside);
     }
 
     for (auto child : children_)
@@ -311,8 +359,12 @@ void Octant::GetDrawablesOnlyInternal(RayOctreeQuery& query, PODVector<Drawable*
 Octree::Octree(Context* context) :
     Component(context),
     Octant(BoundingBox(-DEFAULT_OCTREE_SIZE, DEFAULT_OCTREE_SIZE), 0, nullptr, this),
-    numLevels_(DEFAULT_OCTREE_LEVELS)
+    numLevels_(DEFAULT_OCTREE_LEVELS),
+    aabbTreeOctant_(BoundingBox(-DEFAULT_OCTREE_SIZE, DEFAULT_OCTREE_SIZE), 0, this, this)
 {
+    // The AABB tree culls its drawables, so their octant has no use for packed bounds
+    aabbTreeOctant_.packedBoundsAllowed_ = false;
+
     // If the engine is running headless, subscribe to RenderUpdate events for manually updating the octree
     // to allow raycasts and animation update
     if (!GetSubsystem<Graphics>())
@@ -321,9 +373,16 @@ Octree::Octree(Context* context) :
 
 Octree::~Octree()
 {
+    // Worker threads may still be culling a snapshot
+    WaitForSnapshotReaders();
+    ClearSnapshots();
+
     // Reset root pointer from all child octants now so that they do not move their drawables to root
     drawableUpdates_.Clear();
     ResetRoot();
+    for (PODVector<Drawable*>::Iterator i = aabbTreeOctant_.drawables_.Begin(); i != aabbTreeOctant_.drawables_.End(); ++i)
+        (*i)->aabbTreeProxy_ = NULL_AABB_NODE;
+    aabbTreeOctant_.ResetRoot();
 }
 
 void Octree::RegisterObject(Context* context)
@@ -336,6 +395,9 @@ void Octree::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE_EX("Bounding Box Min", Vector3, worldBoundingBox_.min_, UpdateOctreeSize, defaultBoundsMin, AM_DEFAULT);
     URHO3D_ATTRIBUTE_EX("Bounding Box Max", Vector3, worldBoundingBox_.max_, UpdateOctreeSize, defaultBoundsMax, AM_DEFAULT);
     URHO3D_ATTRIBUTE_EX("Number of Levels", int, numLevels_, UpdateOctreeSize, DEFAULT_OCTREE_LEVELS, AM_DEFAULT);
+    URHO3D_ENUM_ACCESSOR_ATTRIBUTE("Spatial Index", GetSpatialIndex, SetSpatialIndex, SpatialIndex, spatialIndexNames,
+        SPATIAL_INDEX_OCTREE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Animation Budget", GetAnimationBudget, SetAnimationBudget, float, 0.0f, AM_DEFAULT);
 }
 
 void Octree::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
@@ -345,6 +407,13 @@ void Octree::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
         URHO3D_PROFILE(OctreeDrawDebug);
 
         Octant::DrawDebugGeometry(debug, depthTest);
+
+        for (unsigned i = 0; i < aabbTree_.GetNumNodeSlots(); ++i)
+        {
+            const DynamicAabbTree::Node& node = aabbTree_.GetNode(i);
+            if (node.height_ > 0 && debug->IsInside(node.box_))
+                debug->AddBoundingBox(node.box_, Color(0.25f, 0.25f, 0.25f), depthTest);
+        }
     }
 }
 
@@ -357,10 +426,73 @@ void Octree::SetSize(const BoundingBox& box, unsigned numLevels)
         DeleteChild(i);
 
     Initialize(box);
-    numDrawables_ = drawables_.Size();
+    numDrawables_ = drawables_.Size() + aabbTreeOctant_.numDrawables_;
     numLevels_ = Max(numLevels, 1U);
 }
 
+void Octree::SetSpatialIndex(SpatialIndex index)
+{
+    if (index == spatialIndex_)
+        return;
+
+    URHO3D_PROFILE(ChangeSpatialIndex);
+
+    // Move all drawables to the root. Drawables moved from child octants are queued for update by the octants
+    for (unsigned i = 0; i < NUM_OCTANTS; ++i)
+        DeleteChild(i);
+
+    for (PODVector<Drawable*>::Iterator i = aabbTreeOctant_.drawables_.Begin(); i != aabbTreeOctant_.drawables_.End(); ++i)
+    {
+        (*i)->aabbTreeProxy_ = NULL_AABB_NODE;
+        PushDrawable(*i);
+    }
+    aabbTreeOctant_.drawables_.Clear();
+    aabbTreeOctant_.packedBounds_.Clear();
+    aabbTreeOctant_.hasPackedBounds_ = false;
+    aabbTreeOctant_.numDrawables_ = 0;
+    aabbTree_.Clear();
+
+    spatialIndex_ = index;
+
+    // Reinsert everything on the next update
+    for (PODVector<Drawable*>::Iterator i = drawables_.Begin(); i != drawables_.End(); ++i)
+    {
+        if (!(*i)->updateQueued_)
+            QueueUpdate(*i);
+    }
+}
+
+void Octree::InsertDrawable(Drawable* drawable)
+{
+    if (spatialIndex_ != SPATIAL_INDEX_AABB_TREE)
+    {
+        Octant::InsertDrawable(drawable);
+        return;
+    }
+
+    const BoundingBox& box = drawable->GetWorldBoundingBox();
+
+    // Keep non-occludees in the root octant, so that occlusion of tree nodes does not hide them
+    Octant* octant = drawable->IsOccludee() ? &aabbTreeOctant_ : this;
+    Octant* oldOctant = drawable->octant_;
+    if (oldOctant != octant)
+    {
+        // Removing from the tree octant also destroys the proxy
+        unsigned oldIndex = drawable->octantIndex_;
+        octant->AddDrawable(drawable);
+        if (oldOctant)
+            oldOctant->RemoveDrawableAt(oldIndex, drawable, false);
+    }
+
+    if (octant == &aabbTreeOctant_)
+    {
+        if (drawable->aabbTreeProxy_ == NULL_AABB_NODE)
+            drawable->aabbTreeProxy_ = aabbTree_.CreateProxy(box, drawable);
+        else
+            aabbTree_.MoveProxy(drawable->aabbTreeProxy_, box);
+    }
+}
+
 void Octree::Update(const FrameInfo& frame)
 {
     if (!Thread::IsMainThread())
@@ -369,6 +501,11 @@ void Octree::Update(const FrameInfo& frame)
         return;
     }
 
+    // Bring world transforms up to date in one batched pass, if the scene uses the transform hierarchy
+    Scene* scene = GetScene();
+    if (scene)
+        scene->UpdateTransformHierarchy();
+
     // Let drawables update themselves before reinsertion. This can be used for animation
     if (!drawableUpdates_.Empty())
     {
@@ -376,34 +513,16 @@ void Octree::Update(const FrameInfo& frame)
 
         // Perform updates in worker threads. Notify the scene that a threaded update is going on and components
         // (for example physics objects) should not perform non-threadsafe work when marked dirty
-        Scene* scene = GetScene();
         auto* queue = GetSubsystem<WorkQueue>();
+        animationScheduler_.Reserve(drawableUpdates_.Size());
         scene->BeginThreadedUpdate();
 
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = Max((int)(drawableUpdates_.Size() / numWorkItems), 1);
-
-        PODVector<Drawable*>::Iterator start = drawableUpdates_.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
+        Drawable** drawables = drawableUpdates_.Buffer();
+        queue->ParallelFor(drawableUpdates_.Size(), 0, [&frame, drawables](unsigned begin, unsigned end, unsigned /*threadIndex*/)
         {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = UpdateDrawablesWork;
-            item->aux_ = const_cast<FrameInfo*>(&frame);
-
-            PODVector<Drawable*>::Iterator end = drawableUpdates_.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
+            UpdateDrawablesWork(frame, drawables + begin, drawables + end);
+        });
 
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
         scene->EndThreadedUpdate();
     }
 
@@ -412,6 +531,7 @@ void Octree::Update(const FrameInfo& frame)
     {
         URHO3D_PROFILE(UpdateDrawablesQueuedDuringUpdate);
 
+        animationScheduler_.Reserve(threadedDrawableUpdates_.Size());
         for (PODVector<Drawable*>::ConstIterator i = threadedDrawableUpdates_.Begin(); i != threadedDrawableUpdates_.End(); ++i)
         {
             Drawable* drawable = *i;
@@ -425,8 +545,27 @@ void Octree::Update(const FrameInfo& frame)
         threadedDrawableUpdates_.Clear();
     }
 
+    // Evaluate the animation poses queued by the drawable update. Writing the bone nodes queues the drawables attached to
+    // them, which are then updated from the main thread, possibly queueing more poses
+    {
+        URHO3D_PROFILE(UpdateAnimationPoses);
+
+        auto* queue = GetSubsystem<WorkQueue>();
+        unsigned numUpdated = drawableUpdates_.Size();
+        animationScheduler_.Update(frame, queue);
+        while (numUpdated < drawableUpdates_.Size())
+        {
+            const unsigned numQueued = drawableUpdates_.Size();
+            animationScheduler_.Reserve(numQueued - numUpdated);
+            for (unsigned i = numUpdated; i < numQueued; ++i)
+                drawableUpdates_[i]->Update(frame);
+            numUpdated = numQueued;
+            if (animationScheduler_.HasQueued())
+                animationScheduler_.Update(frame, queue);
+        }
+    }
+
     // Notify drawable update being finished. Custom animation (eg. IK) can be done at this point
-    Scene* scene = GetScene();
     if (scene)
     {
         using namespace SceneDrawableUpdateFinished;
@@ -443,26 +582,66 @@ void Octree::Update(const FrameInfo& frame)
     {
         URHO3D_PROFILE(ReinsertToOctree);
 
+        // Update the bounding boxes and drop the drawables which still fit their place in worker threads, as that does not
+        // modify the spatial index. Only the remaining drawables are reinserted from the main thread
+        auto* queue = GetSubsystem<WorkQueue>();
+        Drawable** drawables = drawableUpdates_.Buffer();
+
+        // Pending snapshot queries test the updated drawables again, as their bounds may have changed
+        if (snapshotEnabled_)
+        {
+            for (PODVector<Drawable*>::ConstIterator i = drawableUpdates_.Begin(); i != drawableUpdates_.End(); ++i)
+            {
+                const unsigned index = (*i)->snapshotIndex_;
+                if (index != M_MAX_UNSIGNED)
+                    MarkSnapshotEntryChanged(index);
+            }
+        }
+
+        // Record the updated bounding boxes as changes, written by index from the worker threads
+        BoundingBox* changes = nullptr;
+        const unsigned numChanges = pendingChanges_.Size();
+        if (!pendingChangeOverflow_ && numChanges + drawableUpdates_.Size() <= MAX_OCTREE_CHANGES)
+        {
+            pendingChanges_.Resize(numChanges + drawableUpdates_.Size());
+            changes = pendingChanges_.Buffer() + numChanges;
+        }
+        else
+            pendingChangeOverflow_ = true;
+
+        queue->ParallelFor(drawableUpdates_.Size(), 0, [this, drawables, changes](unsigned begin, unsigned end, unsigned /*threadIndex*/)
+        {
+            for (unsigned i = begin; i < end; ++i)
+            {
+                Drawable* drawable = drawables[i];
+                drawable->updateQueued_ = false;
+                const bool reinsert = NeedsReinsertion(drawable);
+                if (changes)
+                    changes[i] = drawable->GetWorldBoundingBox();
+                const unsigned snapshotIndex = drawable->snapshotIndex_;
+                if (snapshotIndex != M_MAX_UNSIGNED)
+                {
+                    snapshotTable_.boundingBoxes_[snapshotIndex] = drawable->GetWorldBoundingBox();
+                    snapshotTable_.viewMasks_[snapshotIndex] = drawable->viewMask_;
+                }
+                if (!reinsert)
+                    drawables[i] = nullptr;
+            }
+        });
+
         for (PODVector<Drawable*>::Iterator i = drawableUpdates_.Begin(); i != drawableUpdates_.End(); ++i)
         {
             Drawable* drawable = *i;
-            drawable->updateQueued_ = false;
-            Octant* octant = drawable->GetOctant();
-            const BoundingBox& box = drawable->GetWorldBoundingBox();
-
-            // Skip if no octant or does not belong to this octree anymore
-            if (!octant || octant->GetRoot() != this)
-                continue;
-            // Skip if still fits the current octant
-            if (drawable->IsOccludee() && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
+            if (!drawable)
                 continue;
 
             InsertDrawable(drawable);
 
 #ifdef _DEBUG
             // Verify that the drawable will be culled correctly
-            octant = drawable->GetOctant();
-            if (octant != this && octant->GetCullingBox().IsInside(box) != INSIDE)
+            Octant* octant = drawable->GetOctant();
+            const BoundingBox& box = drawable->GetWorldBoundingBox();
+            if (octant != this && octant != &aabbTreeOctant_ && octant->GetCullingBox().IsInside(box) != INSIDE)
             {
                 URHO3D_LOGERROR("Drawable is not fully inside its octant's culling bounds: drawable box " + box.ToString() +
                          " octant box " + octant->GetCullingBox().ToString());
@@ -472,6 +651,60 @@ void Octree::Update(const FrameInfo& frame)
     }
 
     drawableUpdates_.Clear();
+
+    // Publish the changes for caches of query results, which check them after the update
+    changedBoxes_.Swap(pendingChanges_);
+    pendingChanges_.Clear();
+    changeOverflow_ = pendingChangeOverflow_;
+    pendingChangeOverflow_ = false;
+    if (changeOverflow_)
+        changedBoxes_.Clear();
+    ++numUpdates_;
+
+    if (snapshotEnabled_)
+        TakeSnapshot(frame);
+}
+
+bool Octree::NeedsReinsertion(Drawable* drawable)
+{
+    Octant* octant = drawable->GetOctant();
+    const BoundingBox& box = drawable->GetWorldBoundingBox();
+
+    // Skip if no octant or does not belong to this octree anymore
+    if (!octant || octant->GetRoot() != this)
+        return false;
+
+    if (spatialIndex_ == SPATIAL_INDEX_AABB_TREE)
+    {
+        // Skip if still fits the fattened box of its proxy
+        if (octant == &aabbTreeOctant_)
+            return !drawable->IsOccludee() || !aabbTree_.Fits(drawable->aabbTreeProxy_, box);
+        else
+            return octant != this || drawable->IsOccludee();
+    }
+
+    // Skip if still fits the current octant
+    return !(drawable->IsOccludee() && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box));
+}
+
+void Octree::SetSnapshotEnabled(bool enable)
+{
+    if (enable == snapshotEnabled_)
+        return;
+
+    WaitForSnapshotReaders();
+    ClearSnapshots();
+    snapshotEnabled_ = enable;
+
+    // Fill the snapshot table with the drawables already in the octree. From now on it is kept up to date incrementally
+    if (enable)
+    {
+        PODVector<Drawable*> drawables;
+        AllContentOctreeQuery query(drawables, DRAWABLE_ANY, DEFAULT_VIEWMASK);
+        GetDrawables(query);
+        for (PODVector<Drawable*>::ConstIterator i = drawables.Begin(); i != drawables.End(); ++i)
+            AddSnapshotEntry(*i);
+    }
 }
 
 void Octree::AddManualDrawable(Drawable* drawable)
@@ -479,7 +712,12 @@ void Octree::AddManualDrawable(Drawable* drawable)
     if (!drawable || drawable->GetOctant())
         return;
 
-    AddDrawable(drawable);
+    if (spatialIndex_ == SPATIAL_INDEX_AABB_TREE)
+        InsertDrawable(drawable);
+    else
+        AddDrawable(drawable);
+    MarkChanged(drawable->GetWorldBoundingBox());
+    AddToSnapshots(drawable);
 }
 
 void Octree::RemoveManualDrawable(Drawable* drawable)
@@ -489,13 +727,19 @@ void Octree::RemoveManualDrawable(Drawable* drawable)
 
     Octant* octant = drawable->GetOctant();
     if (octant && octant->GetRoot() == this)
+    {
+        RemoveFromSnapshots(drawable);
+        MarkChanged(drawable->worldBoundingBox_);
         octant->RemoveDrawable(drawable);
+    }
 }
 
 void Octree::GetDrawables(OctreeQuery& query) const
 {
     query.result_.Clear();
     GetDrawablesInternal(query, false);
+    if (aabbTreeOctant_.numDrawables_)
+        GetDrawablesFromAabbTree(query);
 }
 
 void Octree::Raycast(RayOctreeQuery& query) const
@@ -504,6 +748,8 @@ void Octree::Raycast(RayOctreeQuery& query) const
 
     query.result_.Clear();
     GetDrawablesInternal(query);
+    if (aabbTreeOctant_.numDrawables_)
+        GetDrawablesFromAabbTree(query, nullptr);
     Sort(query.result_.Begin(), query.result_.End(), CompareRayQueryResults);
 }
 
@@ -514,6 +760,8 @@ void Octree::RaycastSingle(RayOctreeQuery& query) const
     query.result_.Clear();
     rayQueryDrawables_.Clear();
     GetDrawablesOnlyInternal(query, rayQueryDrawables_);
+    if (aabbTreeOctant_.numDrawables_)
+        GetDrawablesFromAabbTree(query, &rayQueryDrawables_);
 
     // Sort by increasing hit distance to AABB
     for (PODVector<Drawable*>::Iterator i = rayQueryDrawables_.Begin(); i != rayQueryDrawables_.End(); ++i)
@@ -549,18 +797,38 @@ void Octree::RaycastSingle(RayOctreeQuery& query) const
 
 void Octree::QueueUpdate(Drawable* drawable)
 {
+    // The drawable's bounding box is already marked dirty, but still holds what culling saw before the change
     Scene* scene = GetScene();
     if (scene && scene->IsThreadedUpdate())
     {
         MutexLock lock(octreeMutex_);
         threadedDrawableUpdates_.Push(drawable);
+        MarkChanged(drawable->worldBoundingBox_);
     }
     else
+    {
         drawableUpdates_.Push(drawable);
+        MarkChanged(drawable->worldBoundingBox_);
+    }
 
     drawable->updateQueued_ = true;
 }
 
+void Octree::MarkChanged(const BoundingBox& box)
+{
+    // A drawable which has never had its bounding box calculated can not be in any query results yet
+    if (!box.Defined() || pendingChangeOverflow_)
+        return;
+
+    if (pendingChanges_.Size() < MAX_OCTREE_CHANGES)
+        pendingChanges_.Push(box);
+    else
+    {
+        pendingChangeOverflow_ = true;
+        pendingChanges_.Clear();
+    }
+}
+
 void Octree::CancelUpdate(Drawable* drawable)
 {
     // This doesn't have to take into account scene being in threaded update, because it is called only
@@ -575,6 +843,192 @@ void Octree::DrawDebugGeometry(bool depthTest)
     DrawDebugGeometry(debug, depthTest);
 }
 
+void Octree::TakeSnapshot(const FrameInfo& frame)
+{
+    URHO3D_PROFILE(TakeOctreeSnapshot);
+
+    // Write to the older slot. A query started last frame may still be reading it
+    OctreeSnapshot& snapshot = snapshots_[snapshotIndex_ ^ 1];
+    auto* queue = GetSubsystem<WorkQueue>();
+    if (snapshot.numReaders_.load(std::memory_order_acquire))
+        queue->WaitForCounter(snapshot.numReaders_);
+
+    // The snapshot table is up to date after reinsertion, so this is a plain copy
+    const unsigned numEntries = snapshotTable_.drawables_.Size();
+    snapshot.drawables_ = snapshotTable_.drawables_;
+    snapshot.boundingBoxes_ = snapshotTable_.boundingBoxes_;
+    snapshot.drawableFlags_ = snapshotTable_.drawableFlags_;
+    snapshot.viewMasks_ = snapshotTable_.viewMasks_;
+    snapshot.changed_.Resize(numEntries);
+    if (numEntries)
+        memset(snapshot.changed_.Buffer(), 0, numEntries);
+    snapshot.changedIndices_.Clear();
+
+    snapshot.frameNumber_ = Max(frame.frameNumber_, 1U);
+    snapshotIndex_ ^= 1;
+}
+
+void Octree::WaitForSnapshotReaders()
+{
+    for (auto& snapshot : snapshots_)
+    {
+        if (snapshot.numReaders_.load(std::memory_order_acquire))
+            GetSubsystem<WorkQueue>()->WaitForCounter(snapshot.numReaders_);
+    }
+}
+
+void Octree::AddSnapshotEntry(Drawable* drawable)
+{
+    if (drawable->snapshotIndex_ != M_MAX_UNSIGNED)
+        return;
+
+    unsigned index;
+    if (freeSnapshotIndices_.Size())
+    {
+        index = freeSnapshotIndices_.Back();
+        freeSnapshotIndices_.Pop();
+    }
+    else
+    {
+        index = snapshotTable_.drawables_.Size();
+        snapshotTable_.drawables_.Resize(index + 1);
+        snapshotTable_.boundingBoxes_.Resize(index + 1);
+        snapshotTable_.drawableFlags_.Resize(index + 1);
+        snapshotTable_.viewMasks_.Resize(index + 1);
+    }
+
+    drawable->snapshotIndex_ = index;
+    snapshotTable_.drawables_[index] = drawable;
+    snapshotTable_.boundingBoxes_[index] = drawable->GetWorldBoundingBox();
+    snapshotTable_.drawableFlags_[index] = drawable->GetDrawableFlags();
+    snapshotTable_.viewMasks_[index] = drawable->GetViewMask();
+    MarkSnapshotEntryChanged(index);
+}
+
+void Octree::RemoveSnapshotEntry(Drawable* drawable)
+{
+    const unsigned index = drawable->snapshotIndex_;
+    if (index == M_MAX_UNSIGNED)
+        return;
+
+    // Zero flags keep the free slot out of all query results
+    drawable->snapshotIndex_ = M_MAX_UNSIGNED;
+    snapshotTable_.drawables_[index] = nullptr;
+    snapshotTable_.drawableFlags_[index] = 0;
+    snapshotTable_.viewMasks_[index] = 0;
+    freeSnapshotIndices_.Push(index);
+    MarkSnapshotEntryChanged(index);
+}
+
+void Octree::MarkSnapshotEntryChanged(unsigned index)
+{
+    for (auto& snapshot : snapshots_)
+    {
+        if (index >= snapshot.changed_.Size())
+            snapshot.changed_.Resize(index + 1, 0);
+        if (!snapshot.changed_[index])
+        {
+            snapshot.changed_[index] = 1;
+            snapshot.changedIndices_.Push(index);
+        }
+    }
+}
+
+void Octree::ClearSnapshots()
+{
+    for (PODVector<Drawable*>::ConstIterator i = snapshotTable_.drawables_.Begin(); i != snapshotTable_.drawables_.End(); ++i)
+    {
+        if (*i)
+            (*i)->snapshotIndex_ = M_MAX_UNSIGNED;
+    }
+
+    snapshotTable_.drawables_.Clear();
+    snapshotTable_.boundingBoxes_.Clear();
+    snapshotTable_.drawableFlags_.Clear();
+    snapshotTable_.viewMasks_.Clear();
+    freeSnapshotIndices_.Clear();
+
+    for (auto& snapshot : snapshots_)
+    {
+        snapshot.drawables_.Clear();
+        snapshot.boundingBoxes_.Clear();
+        snapshot.drawableFlags_.Clear();
+        snapshot.viewMasks_.Clear();
+        snapshot.changed_.Clear();
+        snapshot.changedIndices_.Clear();
+        snapshot.frameNumber_ = 0;
+    }
+}
+
+void Octree::GetDrawablesFromAabbTree(OctreeQuery& query) const
+{
+    // Gather the leaves' drawables into batches, one for drawables inside the query volume and one for drawables to test
+    Drawable* insideBatch[AABB_TREE_BATCH_SIZE];
+    Drawable* testBatch[AABB_TREE_BATCH_SIZE];
+    unsigned numInside = 0;
+    unsigned numTest = 0;
+
+    auto nodeTest = [&query](const BoundingBox& box, bool inside)
+    {
+        return query.TestOctant(box, inside);
+    };
+    auto leafFunc = [&](unsigned proxy, bool inside)
+    {
+        auto* drawable = static_cast<Drawable*>(aabbTree_.GetUserData(proxy));
+        if (inside)
+        {
+            insideBatch[numInside++] = drawable;
+            if (numInside == AABB_TREE_BATCH_SIZE)
+            {
+                query.TestDrawables(insideBatch, insideBatch + numInside, true);
+                numInside = 0;
+            }
+        }
+        else
+        {
+            testBatch[numTest++] = drawable;
+            if (numTest == AABB_TREE_BATCH_SIZE)
+            {
+                query.TestDrawables(testBatch, testBatch + numTest, false);
+                numTest = 0;
+            }
+        }
+    };
+    aabbTree_.Traverse(nodeTest, leafFunc);
+
+    if (numInside)
+        query.TestDrawables(insideBatch, insideBatch + numInside, true);
+    if (numTest)
+        query.TestDrawables(testBatch, testBatch + numTest, false);
+}
+
+void Octree::GetDrawablesFromAabbTree(RayOctreeQuery& query, PODVector<Drawable*>* drawables) const
+{
+    auto nodeTest = [&query](const BoundingBox& box, bool /*inside*/)
+    {
+        return query.ray_.HitDistance(box) < query.maxDistance_ ? INTERSECTS : OUTSIDE;
+    };
+    auto leafFunc = [&](unsigned proxy, bool /*inside*/)
+    {
+        auto* drawable = static_cast<Drawable*>(aabbTree_.GetUserData(proxy));
+        if ((drawable->GetDrawableFlags() & query.drawableFlags_) && (drawable->GetViewMask() & query.viewMask_) &&
+            query.ray_.HitDistance(aabbTree_.GetFatBox(proxy)) < query.maxDistance_)
+        {
+            if (drawables)
+                drawables->Push(drawable);
+            else
+                drawable->ProcessRayQuery(query, query.result_);
+        }
+    };
+    aabbTree_.Traverse(nodeTest, leafFunc);
+}
+
+void Octree::DestroyAabbTreeProxy(Drawable* drawable)
+{
+    aabbTree_.DestroyProxy(drawable->aabbTreeProxy_);
+    drawable->aabbTreeProxy_ = NULL_AABB_NODE;
+}
+
 void Octree::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
 {
     // When running in headless mode, update the Octree manually during the RenderUpdate event
@@ -588,6 +1042,7 @@ void Octree::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
     frame.frameNumber_ = GetSubsystem<Time>()->GetFrameNumber();
     frame.timeStep_ = eventData[P_TIMESTEP].GetFloat();
     frame.camera_ = nullptr;
+    frame.allocator_ = GetSubsystem<FrameAllocator>();
 
     Update(frame);
 }
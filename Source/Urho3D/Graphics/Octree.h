@@ -24,8 +24,12 @@
 
 #include "../Container/List.h"
 #include "../Core/Mutex.h"
+#include "../Graphics/AnimationScheduler.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/OctreeQuery.h"
+#include "../Graphics/OctreeSnapshot.h"
+#include "../Graphics/PackedDrawableBounds.h"
+#include "../Math/DynamicAabbTree.h"
 
 namespace Urho3D
 {
@@ -34,11 +38,26 @@ class Octree;
 
 static const int NUM_OCTANTS = 8;
 static const unsigned ROOT_INDEX = M_MAX_UNSIGNED;
+/// Number of drawables at which an octant starts keeping packed bounds. Octants of deep octrees mostly hold a few drawables, which the packed culling does not speed up.
+static const unsigned PACKED_BOUNDS_THRESHOLD = 32;
+/// Maximum number of changed drawable bounding boxes recorded per update. If exceeded, everything is considered changed.
+static const unsigned MAX_OCTREE_CHANGES = 1024;
+
+/// Spatial index used by the octree component.
+enum SpatialIndex
+{
+    /// Fixed-depth octree of loose octants.
+    SPATIAL_INDEX_OCTREE = 0,
+    /// Dynamic AABB tree with fattened drawable boxes, which need reinsertion only when a drawable leaves its fattened box.
+    SPATIAL_INDEX_AABB_TREE
+};
 
 /// %Octree octant.
 /// @nobind
 class URHO3D_API Octant
 {
+    friend class Octree;
+
 public:
     /// Construct.
     Octant(const BoundingBox& box, unsigned level, Octant* parent, Octree* root, unsigned index = ROOT_INDEX);
@@ -57,20 +76,38 @@ public:
     /// Add a drawable object to this octant.
     void AddDrawable(Drawable* drawable)
     {
-        drawable->SetOctant(this);
-        drawables_.Push(drawable);
+        PushDrawable(drawable);
         IncDrawableCount();
     }
 
     /// Remove a drawable object from this octant.
     void RemoveDrawable(Drawable* drawable, bool resetOctant = true)
     {
-        if (drawables_.Remove(drawable))
-        {
-            if (resetOctant)
-                drawable->SetOctant(nullptr);
-            DecDrawableCount();
-        }
+        unsigned index = drawable->octant_ == this ? drawable->octantIndex_ : drawables_.IndexOf(drawable);
+        RemoveDrawableAt(index, drawable, resetOctant);
+    }
+
+    /// Copy a drawable object's recalculated world bounding box and view mask to the packed bounds, if kept. Called by the drawable, possibly from worker threads.
+    void UpdateDrawableBounds(Drawable* drawable)
+    {
+        if (!hasPackedBounds_)
+            return;
+        packedBounds_.SetBox(drawable->octantIndex_, drawable->worldBoundingBox_);
+        packedBounds_.SetViewMask(drawable->octantIndex_, drawable->viewMask_);
+    }
+
+    /// Mark a drawable object's packed bounds out of date, if kept. Called by the drawable, possibly from worker threads.
+    void InvalidateDrawableBounds(Drawable* drawable)
+    {
+        if (hasPackedBounds_)
+            packedBounds_.Invalidate(drawable->octantIndex_);
+    }
+
+    /// Copy a drawable object's view mask to the packed bounds, if kept. Called by the drawable.
+    void UpdateDrawableViewMask(Drawable* drawable)
+    {
+        if (hasPackedBounds_)
+            packedBounds_.SetViewMask(drawable->octantIndex_, drawable->viewMask_);
     }
 
     /// Return world-space bounding box.
@@ -92,6 +129,9 @@ public:
     /// Return number of drawables.
     unsigned GetNumDrawables() const { return numDrawables_; }
 
+    /// Return whether keeps packed bounds of its own drawables for culling.
+    bool HasPackedBounds() const { return hasPackedBounds_; }
+
     /// Return true if there are no drawable objects in this octant and child octants.
     bool IsEmpty() { return numDrawables_ == 0; }
 
@@ -111,6 +151,31 @@ protected:
     /// Return drawable objects only for a threaded ray query, called internally.
     void GetDrawablesOnlyInternal(RayOctreeQuery& query, PODVector<Drawable*>& drawables) const;
 
+    /// Append a drawable object to the drawable list and packed bounds without changing the drawable counts.
+    void PushDrawable(Drawable* drawable)
+    {
+        drawable->SetOctant(this);
+        drawable->octantIndex_ = drawables_.Size();
+        drawables_.Push(drawable);
+        if (hasPackedBounds_)
+            PushPackedBounds(drawable);
+        else if (drawables_.Size() >= PACKED_BOUNDS_THRESHOLD && packedBoundsAllowed_)
+            CreatePackedBounds();
+    }
+
+    /// Append a drawable object's entry to the packed bounds.
+    void PushPackedBounds(Drawable* drawable)
+    {
+        packedBounds_.Push(drawable->worldBoundingBoxDirty_ ? nullptr : &drawable->worldBoundingBox_, drawable->drawableFlags_,
+            drawable->viewMask_);
+    }
+
+    /// Start keeping packed bounds of the drawable objects.
+    void CreatePackedBounds();
+
+    /// Remove a drawable object at an index of the drawable list, if it is found there.
+    void RemoveDrawableAt(unsigned index, Drawable* drawable, bool resetOctant);
+
     /// Increase drawable object count recursively.
     void IncDrawableCount()
     {
@@ -127,7 +192,7 @@ protected:
         --numDrawables_;
         if (!numDrawables_)
         {
-            if (parent)
+            if (parent && index_ < NUM_OCTANTS)
                 parent->DeleteChild(index_);
         }
 
@@ -141,6 +206,8 @@ protected:
     BoundingBox cullingBox_;
     /// Drawable objects.
     PODVector<Drawable*> drawables_;
+    /// Packed bounds, flags and view masks of the drawable objects, in the same order. Only kept while there are at least half of PACKED_BOUNDS_THRESHOLD drawables, so that an octant near the threshold does not create and drop them repeatedly.
+    PackedDrawableBounds packedBounds_;
     /// Child octants.
     Octant* children_[NUM_OCTANTS]{};
     /// World bounding box center.
@@ -157,12 +224,17 @@ protected:
     Octree* root_;
     /// Octant index relative to its siblings or ROOT_INDEX for root octant.
     unsigned index_;
+    /// Packed bounds kept flag.
+    bool hasPackedBounds_{};
+    /// Packed bounds allowed flag. False for octants which are not culled by traversal.
+    bool packedBoundsAllowed_{true};
 };
 
 /// %Octree component. Should be added only to the root scene node.
 class URHO3D_API Octree : public Component, public Octant
 {
     URHO3D_OBJECT(Octree, Component);
+    friend class Octant;
 
 public:
     /// Construct.
@@ -178,12 +250,22 @@ public:
 
     /// Set size and maximum subdivision levels. If octree is not empty, drawable objects will be temporarily moved to the root.
     void SetSize(const BoundingBox& box, unsigned numLevels);
+    /// Set spatial index. Drawable objects are moved to the root and reinserted into the new index on the next update.
+    /// @property
+    void SetSpatialIndex(SpatialIndex index);
+    /// Insert a drawable object into the spatial index.
+    void InsertDrawable(Drawable* drawable);
     /// Update and reinsert drawable objects.
     void Update(const FrameInfo& frame);
     /// Add a drawable manually.
     void AddManualDrawable(Drawable* drawable);
     /// Remove a manually added drawable.
     void RemoveManualDrawable(Drawable* drawable);
+    /// Set whether to take a snapshot of drawable bounds at the end of each update for asynchronous culling.
+    void SetSnapshotEnabled(bool enable);
+    /// Set time budget in milliseconds for evaluating pose buffers of far animation LOD models per frame. Zero is unlimited.
+    /// @property
+    void SetAnimationBudget(float budget) { animationScheduler_.SetFarBudget(budget); }
 
     /// Return drawable objects by a query.
     /// @nobind
@@ -196,30 +278,120 @@ public:
     /// Return subdivision levels.
     /// @property
     unsigned GetNumLevels() const { return numLevels_; }
+    /// Return spatial index.
+    /// @property
+    SpatialIndex GetSpatialIndex() const { return spatialIndex_; }
+    /// Return the dynamic AABB tree. Empty unless the AABB tree spatial index is used.
+    /// @nobind
+    const DynamicAabbTree& GetAabbTree() const { return aabbTree_; }
+    /// Return whether snapshots are taken.
+    bool GetSnapshotEnabled() const { return snapshotEnabled_; }
+    /// Return time budget in milliseconds for evaluating pose buffers of far animation LOD models per frame.
+    /// @property
+    float GetAnimationBudget() const { return animationScheduler_.GetFarBudget(); }
+    /// Return the scheduler which evaluates animated model pose buffers after the drawable update.
+    /// @nobind
+    AnimationScheduler* GetAnimationScheduler() { return &animationScheduler_; }
+    /// Return the latest snapshot, or null if snapshots are disabled or none has been taken yet.
+    /// @nobind
+    OctreeSnapshot* GetSnapshot() { return snapshotEnabled_ && snapshots_[snapshotIndex_].frameNumber_ ? &snapshots_[snapshotIndex_] : nullptr; }
+    /// Return the snapshot table, which holds the current bounds and masks of the drawables while snapshots are enabled. Indexed like the snapshots.
+    /// @nobind
+    const OctreeSnapshot& GetSnapshotTable() const { return snapshotTable_; }
 
     /// Mark drawable object as requiring an update and a reinsertion.
     void QueueUpdate(Drawable* drawable);
     /// Cancel drawable object's update.
     void CancelUpdate(Drawable* drawable);
+    /// Remove a drawable leaving the octree from the snapshot table, so that pending snapshot queries do not return it.
+    void RemoveFromSnapshots(Drawable* drawable)
+    {
+        if (snapshotEnabled_)
+            RemoveSnapshotEntry(drawable);
+    }
+    /// Add a drawable entering the octree to the snapshot table, so that pending snapshot queries test it with its current bounds.
+    void AddToSnapshots(Drawable* drawable)
+    {
+        if (snapshotEnabled_)
+            AddSnapshotEntry(drawable);
+    }
+    /// Record a world bounding box as changed during the next update. Called when a drawable object moves, enters or leaves the octree, or changes how it is culled.
+    void MarkChanged(const BoundingBox& box);
     /// Visualize the component as debug geometry.
     void DrawDebugGeometry(bool depthTest);
 
+    /// Return world bounding boxes of drawable objects before and after they changed during the last update, for caches of query results. Empty when the changes overflowed.
+    /// @nobind
+    const PODVector<BoundingBox>& GetChangedBoxes() const { return changedBoxes_; }
+    /// Return whether the last update had more changes than are recorded, so that everything should be considered changed.
+    bool HasChangeOverflow() const { return changeOverflow_; }
+    /// Return number of updates so far. Caches of query results use it to detect updates whose changes they did not see.
+    unsigned GetNumUpdates() const { return numUpdates_; }
+
 private:
     /// Handle render update in case of headless execution.
     void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
     /// Update octree size.
     void UpdateOctreeSize() { SetSize(worldBoundingBox_, numLevels_); }
+    /// Take a snapshot of drawable bounds into the slot not being read.
+    void TakeSnapshot(const FrameInfo& frame);
+    /// Wait until no queries read the snapshots.
+    void WaitForSnapshotReaders();
+    /// Add a drawable to the snapshot table, reusing a free slot if possible.
+    void AddSnapshotEntry(Drawable* drawable);
+    /// Free a drawable's slot in the snapshot table.
+    void RemoveSnapshotEntry(Drawable* drawable);
+    /// Flag a slot of the snapshot table as changed in both snapshots.
+    void MarkSnapshotEntryChanged(unsigned index);
+    /// Clear the snapshot table and the snapshots.
+    void ClearSnapshots();
+    /// Return whether a drawable object which was marked for update must be reinserted. Brings its world bounding box up to date. Called from worker threads.
+    bool NeedsReinsertion(Drawable* drawable);
+    /// Return drawable objects from the AABB tree by a query.
+    void GetDrawablesFromAabbTree(OctreeQuery& query) const;
+    /// Return drawable objects from the AABB tree by a ray query. If a drawable list is given, only collect the drawables whose boxes the ray hits.
+    void GetDrawablesFromAabbTree(RayOctreeQuery& query, PODVector<Drawable*>* drawables) const;
+    /// Destroy a drawable object's AABB tree proxy.
+    void DestroyAabbTreeProxy(Drawable* drawable);
 
     /// Drawable objects that require update.
     PODVector<Drawable*> drawableUpdates_;
     /// Drawable objects that were inserted during threaded update phase.
     PODVector<Drawable*> threadedDrawableUpdates_;
+    /// Scheduler for animated model pose evaluation.
+    AnimationScheduler animationScheduler_;
     /// Mutex for octree reinsertions.
     Mutex octreeMutex_;
     /// Ray query temporary list of drawables.
     mutable PODVector<Drawable*> rayQueryDrawables_;
     /// Subdivision level.
     unsigned numLevels_;
+    /// Spatial index.
+    SpatialIndex spatialIndex_{};
+    /// Dynamic AABB tree of the occludee drawable objects when the AABB tree spatial index is used.
+    DynamicAabbTree aabbTree_;
+    /// Holder of the drawable objects in the AABB tree. Not a child octant, so it is skipped by the octant traversal.
+    Octant aabbTreeOctant_;
+    /// Double-buffered snapshots. One can be culled by worker threads while the other is written.
+    OctreeSnapshot snapshots_[2];
+    /// Drawable bounds and masks kept up to date while snapshots are enabled, and copied into a snapshot at the end of each update. Drawables store their slot, which stays the same while they are in the octree.
+    OctreeSnapshot snapshotTable_;
+    /// Free slots of the snapshot table.
+    PODVector<unsigned> freeSnapshotIndices_;
+    /// Index of the latest snapshot.
+    unsigned snapshotIndex_{};
+    /// Snapshot enabled flag.
+    bool snapshotEnabled_{};
+    /// Changed bounding boxes recorded since the last update.
+    PODVector<BoundingBox> pendingChanges_;
+    /// Changed bounding boxes of the last update.
+    PODVector<BoundingBox> changedBoxes_;
+    /// Overflow flag of the changes recorded since the last update.
+    bool pendingChangeOverflow_{};
+    /// Overflow flag of the changes of the last update.
+    bool changeOverflow_{};
+    /// Number of updates.
+    unsigned numUpdates_{};
 };
 
 }
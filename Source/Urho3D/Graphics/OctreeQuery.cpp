@@ -117,6 +117,41 @@ void FrustumOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool in
     }
 }
 
+void FrustumOctreeQuery::TestPackedDrawables(Drawable** drawables, const PackedDrawableBounds& bounds, bool inside)
+{
+    static const unsigned BATCH_SIZE = 256;
+    static const unsigned MIN_PACKED_DRAWABLES = 8;
+
+    // When the octant is inside, or holds too few drawables to fill the SIMD lanes, the per-drawable test is as fast
+    const unsigned numDrawables = bounds.Size();
+    if (inside || numDrawables < MIN_PACKED_DRAWABLES)
+    {
+        TestDrawables(drawables, drawables + numDrawables, inside);
+        return;
+    }
+
+    unsigned indices[BATCH_SIZE];
+    Drawable* survivors[BATCH_SIZE];
+
+    for (unsigned start = 0; start < numDrawables; start += BATCH_SIZE)
+    {
+        const unsigned end = Min(start + BATCH_SIZE, numDrawables);
+        const unsigned count = bounds.Cull(start, end, frustum_, drawableFlags_, viewMask_, indices);
+        unsigned numSurvivors = 0;
+
+        for (unsigned i = 0; i < count; ++i)
+        {
+            Drawable* drawable = drawables[indices[i]];
+            // A box which was out of date always passes, so test it exactly. This also brings the packed bounds up to date
+            if (bounds.IsInvalid(indices[i]) && !frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
+                continue;
+            survivors[numSurvivors++] = drawable;
+        }
+
+        if (numSurvivors)
+            TestDrawables(survivors, survivors + numSurvivors, true);
+    }
+}
 
 Intersection AllContentOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
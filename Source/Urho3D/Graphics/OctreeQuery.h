@@ -25,6 +25,7 @@
 #pragma once
 
 #include "../Graphics/Drawable.h"
+#include "../Graphics/PackedDrawableBounds.h"
 #include "../Math/BoundingBox.h"
 #include "../Math/Frustum.h"
 #include "../Math/Ray.h"
@@ -60,6 +61,11 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside) = 0;
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside) = 0;
+    /// Intersection test for the drawables of an octant which keeps packed bounds, given in the same order. Octants below PACKED_BOUNDS_THRESHOLD drawables call TestDrawables() instead. By default tests the drawables one at a time.
+    virtual void TestPackedDrawables(Drawable** drawables, const PackedDrawableBounds& bounds, bool inside)
+    {
+        TestDrawables(drawables, drawables + bounds.Size(), inside);
+    }
 
     /// Result vector reference.
     PODVector<Drawable*>& result_;
@@ -152,6 +158,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Intersection test for an octant's drawables using their packed bounds, several boxes at a time. The drawables which pass are then given to TestDrawables() as inside, so that subclasses can apply further tests.
+    void TestPackedDrawables(Drawable** drawables, const PackedDrawableBounds& bounds, bool inside) override;
 
     /// Frustum.
     Frustum frustum_;
@@ -0,0 +1,139 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Graphics/Octree.h"
+#include "../Graphics/OctreeSnapshot.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+SnapshotFrustumQuery::SnapshotFrustumQuery(WorkQueue* queue) :
+    queue_(queue),
+    graph_(queue)
+{
+}
+
+SnapshotFrustumQuery::~SnapshotFrustumQuery()
+{
+    graph_.Wait();
+}
+
+bool SnapshotFrustumQuery::Start(Octree* octree, const Frustum& frustum, unsigned char drawableFlags, unsigned viewMask)
+{
+    assert(!snapshot_);
+
+    OctreeSnapshot* snapshot = octree ? octree->GetSnapshot() : nullptr;
+    if (!snapshot)
+        return false;
+
+    octree_ = octree;
+    snapshot_ = snapshot;
+    frameNumber_ = snapshot->frameNumber_;
+    frustum_ = frustum;
+    drawableFlags_ = drawableFlags;
+    viewMask_ = viewMask;
+
+    // Make a few chunks per thread, so that stealing can balance the load with the main thread's own work
+    const unsigned numDrawables = snapshot->drawables_.Size();
+    const unsigned numChunks = numDrawables ? Min((queue_->GetNumThreads() + 1) * 4, numDrawables) : 0;
+    chunkResults_.Resize(numChunks);
+
+    graph_.Clear();
+    snapshot->numReaders_.fetch_add(numChunks, std::memory_order_relaxed);
+    for (unsigned i = 0; i < numChunks; ++i)
+        graph_.AddTask(CullWork, this, reinterpret_cast<void*>((size_t)i), reinterpret_cast<void*>((size_t)numChunks));
+
+    graph_.Start();
+    return true;
+}
+
+bool SnapshotFrustumQuery::Finish(Octree* octree, PODVector<Drawable*>& result)
+{
+    if (!snapshot_)
+        return false;
+
+    graph_.Wait();
+
+    OctreeSnapshot* snapshot = snapshot_;
+    snapshot_ = nullptr;
+    if (octree_.Expired() || octree_ != octree || snapshot->frameNumber_ != frameNumber_)
+        return false;
+
+    // Exclude the slots which changed since the snapshot. Their snapshot entries may refer to drawables which have left the
+    // octree and been destroyed
+    const unsigned char* changed = snapshot->changed_.Buffer();
+    for (unsigned i = 0; i < chunkResults_.Size(); ++i)
+    {
+        const PODVector<unsigned>& indices = chunkResults_[i];
+        for (unsigned j = 0; j < indices.Size(); ++j)
+        {
+            const unsigned index = indices[j];
+            if (!changed[index])
+                result.Push(snapshot->drawables_[index]);
+        }
+    }
+
+    // Test the drawables which now occupy the changed slots with their current bounds instead
+    const OctreeSnapshot& table = octree->GetSnapshotTable();
+    for (PODVector<unsigned>::ConstIterator i = snapshot->changedIndices_.Begin(); i != snapshot->changedIndices_.End(); ++i)
+    {
+        const unsigned index = *i;
+        if ((table.drawableFlags_[index] & drawableFlags_) && (table.viewMasks_[index] & viewMask_) &&
+            frustum_.IsInsideFast(table.boundingBoxes_[index]) != OUTSIDE)
+            result.Push(table.drawables_[index]);
+    }
+
+    return true;
+}
+
+void SnapshotFrustumQuery::CullWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* query = reinterpret_cast<SnapshotFrustumQuery*>(item->start_);
+    auto chunk = (unsigned)reinterpret_cast<size_t>(item->end_);
+    auto numChunks = (unsigned)reinterpret_cast<size_t>(item->aux_);
+    OctreeSnapshot* snapshot = query->snapshot_;
+
+    const unsigned numDrawables = snapshot->drawables_.Size();
+    const unsigned begin = (unsigned)((unsigned long long)numDrawables * chunk / numChunks);
+    const unsigned end = (unsigned)((unsigned long long)numDrawables * (chunk + 1) / numChunks);
+
+    const BoundingBox* boxes = snapshot->boundingBoxes_.Buffer();
+    const unsigned char* flags = snapshot->drawableFlags_.Buffer();
+    const unsigned* viewMasks = snapshot->viewMasks_.Buffer();
+    const Frustum& frustum = query->frustum_;
+
+    PODVector<unsigned>& result = query->chunkResults_[chunk];
+    result.Clear();
+    for (unsigned i = begin; i < end; ++i)
+    {
+        if ((flags[i] & query->drawableFlags_) && (viewMasks[i] & query->viewMask_) && frustum.IsInsideFast(boxes[i]) != OUTSIDE)
+            result.Push(i);
+    }
+
+    snapshot->numReaders_.fetch_sub(1, std::memory_order_release);
+}
+
+}
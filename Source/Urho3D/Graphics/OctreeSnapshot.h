@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../Core/TaskGraph.h"
+#include "../Math/BoundingBox.h"
+#include "../Math/Frustum.h"
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+class Drawable;
+class Octree;
+
+/// Immutable copy of an octree's drawable bounds and masks for one frame. Worker threads cull it while the scene advances, which lets view preparation of one frame overlap the next frame's scene update.
+struct URHO3D_API OctreeSnapshot
+{
+    /// Drawables, null for free slots. Dereferenced only by the main thread when a query finishes.
+    PODVector<Drawable*> drawables_;
+    /// World-space bounding boxes.
+    PODVector<BoundingBox> boundingBoxes_;
+    /// Drawable flags, zero for free slots.
+    PODVector<unsigned char> drawableFlags_;
+    /// View masks.
+    PODVector<unsigned> viewMasks_;
+    /// Per-slot flags of the drawables which have entered, moved within or left the octree since the snapshot was taken. Query results exclude their snapshot entries.
+    PODVector<unsigned char> changed_;
+    /// Slots flagged as changed, in order. Query results test their current drawables against their current bounds instead.
+    PODVector<unsigned> changedIndices_;
+    /// Frame number when taken.
+    unsigned frameNumber_{};
+    /// Number of query tasks still reading the snapshot.
+    std::atomic<unsigned> numReaders_{};
+};
+
+/// Frustum query against an octree snapshot, executed asynchronously by the work queue.
+class URHO3D_API SnapshotFrustumQuery
+{
+public:
+    /// Construct.
+    explicit SnapshotFrustumQuery(WorkQueue* queue);
+    /// Destruct. Wait for a running query.
+    ~SnapshotFrustumQuery();
+
+    /// Start culling the octree's latest snapshot in worker threads and return immediately. Return false if the octree has no snapshot.
+    bool Start(Octree* octree, const Frustum& frustum, unsigned char drawableFlags, unsigned viewMask);
+    /// Wait for the query and append the surviving drawables which are still in the octree to the result. Drawables which entered or moved within the octree since the snapshot are tested again with their current bounds. Return false if no query against this octree was started, or the snapshot has been retaken since.
+    bool Finish(Octree* octree, PODVector<Drawable*>& result);
+
+    /// Return whether a query has been started and not yet finished.
+    bool IsStarted() const { return snapshot_ != nullptr; }
+    /// Return frame number of the snapshot being culled.
+    unsigned GetFrameNumber() const { return frameNumber_; }
+    /// Return the frustum of the last started query.
+    const Frustum& GetFrustum() const { return frustum_; }
+    /// Return the view mask of the last started query.
+    unsigned GetViewMask() const { return viewMask_; }
+
+private:
+    /// Work function: cull one chunk of the snapshot.
+    static void CullWork(const WorkItem* item, unsigned threadIndex);
+
+    /// Work queue.
+    WorkQueue* queue_;
+    /// Task graph holding the chunk tasks.
+    TaskGraph graph_;
+    /// Octree being queried.
+    WeakPtr<Octree> octree_;
+    /// Snapshot being culled.
+    OctreeSnapshot* snapshot_{};
+    /// Frame number of the snapshot when started.
+    unsigned frameNumber_{};
+    /// Query frustum.
+    Frustum frustum_;
+    /// Drawable flags to include.
+    unsigned char drawableFlags_{};
+    /// Drawable view mask.
+    unsigned viewMask_{};
+    /// Surviving snapshot indices per chunk.
+    Vector<PODVector<unsigned> > chunkResults_;
+};
+
+}
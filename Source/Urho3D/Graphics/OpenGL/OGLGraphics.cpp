@@ -2748,6 +2748,7 @@ void Graphics::CheckFeatureSupport()
     {
         // Work around GLEW failure to check extensions properly from a GL3 context
         instancingSupport_ = glDrawElementsInstanced != nullptr && glVertexAttribDivisor != nullptr;
+        vertexTextureSupport_ = true;
         dxtTextureSupport_ = true;
         anisotropySupport_ = true;
         sRGBSupport_ = true;
@@ -3257,6 +3258,8 @@ void Graphics::SetTextureUnitMappings()
     textureUnits_["LightBuffer"] = TU_LIGHTBUFFER;
     textureUnits_["ZoneCubeMap"] = TU_ZONE;
     textureUnits_["ZoneVolumeMap"] = TU_ZONE;
+    textureUnits_["ClusterMap"] = TU_LIGHTCLUSTERS;
+    textureUnits_["SkinMap"] = TU_SKINMATRICES;
 #endif
 }
 
@@ -0,0 +1,165 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Graphics/PackedDrawableBounds.h"
+#include "../Math/Frustum.h"
+
+#if defined(URHO3D_SSE) || defined(__SSE2__) || defined(_M_X64)
+#define URHO3D_CULL_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+unsigned PackedDrawableBounds::Cull(unsigned start, unsigned end, const Frustum& frustum, unsigned char drawableFlags,
+    unsigned viewMask, unsigned* indices) const
+{
+    unsigned count = 0;
+
+    const float* centerX = centerX_.Buffer();
+    const float* centerY = centerY_.Buffer();
+    const float* centerZ = centerZ_.Buffer();
+    const float* halfSizeX = halfSizeX_.Buffer();
+    const float* halfSizeY = halfSizeY_.Buffer();
+    const float* halfSizeZ = halfSizeZ_.Buffer();
+    const Plane* planes = frustum.planes_;
+    unsigned i = start;
+
+#ifdef __AVX__
+    // Test 8 boxes at a time against each plane, with the plane broadcast to all lanes
+    for (; i + 8 <= end; i += 8)
+    {
+        const __m256 cx = _mm256_loadu_ps(centerX + i);
+        const __m256 cy = _mm256_loadu_ps(centerY + i);
+        const __m256 cz = _mm256_loadu_ps(centerZ + i);
+        const __m256 hx = _mm256_loadu_ps(halfSizeX + i);
+        const __m256 hy = _mm256_loadu_ps(halfSizeY + i);
+        const __m256 hz = _mm256_loadu_ps(halfSizeZ + i);
+        __m256 outside = _mm256_setzero_ps();
+
+        for (unsigned j = 0; j < NUM_FRUSTUM_PLANES; ++j)
+        {
+            const Plane& plane = planes[j];
+            __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.normal_.x_), cx),
+                _mm256_mul_ps(_mm256_set1_ps(plane.normal_.y_), cy)), _mm256_mul_ps(_mm256_set1_ps(plane.normal_.z_), cz)),
+                _mm256_set1_ps(plane.d_));
+            __m256 absDist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.absNormal_.x_), hx),
+                _mm256_mul_ps(_mm256_set1_ps(plane.absNormal_.y_), hy)), _mm256_mul_ps(_mm256_set1_ps(plane.absNormal_.z_), hz));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, _mm256_sub_ps(_mm256_setzero_ps(), absDist), _CMP_LT_OQ));
+        }
+
+        const unsigned outsideMask = (unsigned)_mm256_movemask_ps(outside);
+        if (outsideMask == 0xffu)
+            continue;
+
+        for (unsigned k = 0; k < 8; ++k)
+        {
+            const unsigned index = i + k;
+            if (!(outsideMask & (1u << k)) && (drawableFlags_[index] & drawableFlags) && (viewMasks_[index] & viewMask))
+                indices[count++] = index;
+        }
+    }
+#endif
+
+#ifdef URHO3D_CULL_SSE2
+    // Test 4 boxes at a time against each plane, with the plane broadcast to all lanes
+    __m128 normalX[NUM_FRUSTUM_PLANES], normalY[NUM_FRUSTUM_PLANES], normalZ[NUM_FRUSTUM_PLANES], d[NUM_FRUSTUM_PLANES];
+    __m128 absNormalX[NUM_FRUSTUM_PLANES], absNormalY[NUM_FRUSTUM_PLANES], absNormalZ[NUM_FRUSTUM_PLANES];
+    for (unsigned j = 0; j < NUM_FRUSTUM_PLANES; ++j)
+    {
+        normalX[j] = _mm_set1_ps(planes[j].normal_.x_);
+        normalY[j] = _mm_set1_ps(planes[j].normal_.y_);
+        normalZ[j] = _mm_set1_ps(planes[j].normal_.z_);
+        d[j] = _mm_set1_ps(planes[j].d_);
+        absNormalX[j] = _mm_set1_ps(planes[j].absNormal_.x_);
+        absNormalY[j] = _mm_set1_ps(planes[j].absNormal_.y_);
+        absNormalZ[j] = _mm_set1_ps(planes[j].absNormal_.z_);
+    }
+
+    for (; i + 4 <= end; i += 4)
+    {
+        const __m128 cx = _mm_loadu_ps(centerX + i);
+        const __m128 cy = _mm_loadu_ps(centerY + i);
+        const __m128 cz = _mm_loadu_ps(centerZ + i);
+        const __m128 hx = _mm_loadu_ps(halfSizeX + i);
+        const __m128 hy = _mm_loadu_ps(halfSizeY + i);
+        const __m128 hz = _mm_loadu_ps(halfSizeZ + i);
+        __m128 outside = _mm_setzero_ps();
+
+        for (unsigned j = 0; j < NUM_FRUSTUM_PLANES; ++j)
+        {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX[j], cx), _mm_mul_ps(normalY[j], cy)),
+                _mm_mul_ps(normalZ[j], cz)), d[j]);
+            __m128 absDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absNormalX[j], hx), _mm_mul_ps(absNormalY[j], hy)),
+                _mm_mul_ps(absNormalZ[j], hz));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, _mm_sub_ps(_mm_setzero_ps(), absDist)));
+        }
+
+        const unsigned outsideMask = (unsigned)_mm_movemask_ps(outside);
+        if (outsideMask == 0xfu)
+            continue;
+
+        for (unsigned k = 0; k < 4; ++k)
+        {
+            const unsigned index = i + k;
+            if (!(outsideMask & (1u << k)) && (drawableFlags_[index] & drawableFlags) && (viewMasks_[index] & viewMask))
+                indices[count++] = index;
+        }
+    }
+#endif
+
+    // Remainder, or all boxes without SIMD
+    for (; i < end; ++i)
+    {
+        if (!(drawableFlags_[i] & drawableFlags) || !(viewMasks_[i] & viewMask))
+            continue;
+
+        bool outside = false;
+        for (unsigned j = 0; j < NUM_FRUSTUM_PLANES; ++j)
+        {
+            const Plane& plane = planes[j];
+            float dist = plane.normal_.x_ * centerX[i] + plane.normal_.y_ * centerY[i] + plane.normal_.z_ * centerZ[i] + plane.d_;
+            float absDist = plane.absNormal_.x_ * halfSizeX[i] + plane.absNormal_.y_ * halfSizeY[i] +
+                plane.absNormal_.z_ * halfSizeZ[i];
+            if (dist < -absDist)
+            {
+                outside = true;
+                break;
+            }
+        }
+
+        if (!outside)
+            indices[count++] = i;
+    }
+
+    return count;
+}
+
+}
@@ -0,0 +1,133 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Math/BoundingBox.h"
+
+namespace Urho3D
+{
+
+class Frustum;
+
+/// Packed structure-of-arrays copy of the world bounding boxes, flags and view masks of an octant's drawables, kept parallel to the octant's drawable list so that culling can test several boxes at once without touching the drawables. Boxes are stored as center and half size. A box which has not been recalculated since the drawable was marked dirty is stored as invalid, which never culls.
+/// @nobind
+struct URHO3D_API PackedDrawableBounds
+{
+    /// Append an entry. Pass null box if the drawable's world bounding box is not up to date.
+    void Push(const BoundingBox* box, unsigned char drawableFlags, unsigned viewMask)
+    {
+        centerX_.Push(0.0f);
+        centerY_.Push(0.0f);
+        centerZ_.Push(0.0f);
+        halfSizeX_.Push(0.0f);
+        halfSizeY_.Push(0.0f);
+        halfSizeZ_.Push(0.0f);
+        drawableFlags_.Push(drawableFlags);
+        viewMasks_.Push(viewMask);
+
+        const unsigned index = Size() - 1;
+        if (box)
+            SetBox(index, *box);
+        else
+            Invalidate(index);
+    }
+
+    /// Remove an entry by moving the last entry in its place.
+    void EraseSwap(unsigned index)
+    {
+        centerX_.EraseSwap(index);
+        centerY_.EraseSwap(index);
+        centerZ_.EraseSwap(index);
+        halfSizeX_.EraseSwap(index);
+        halfSizeY_.EraseSwap(index);
+        halfSizeZ_.EraseSwap(index);
+        drawableFlags_.EraseSwap(index);
+        viewMasks_.EraseSwap(index);
+    }
+
+    /// Update the box of an entry.
+    void SetBox(unsigned index, const BoundingBox& box)
+    {
+        // Same arithmetic as Frustum::IsInsideFast() so that both paths agree exactly
+        const Vector3 center = box.Center();
+        const Vector3 halfSize = center - box.min_;
+        centerX_[index] = center.x_;
+        centerY_[index] = center.y_;
+        centerZ_[index] = center.z_;
+        halfSizeX_[index] = halfSize.x_;
+        halfSizeY_[index] = halfSize.y_;
+        halfSizeZ_[index] = halfSize.z_;
+    }
+
+    /// Mark the box of an entry out of date.
+    void Invalidate(unsigned index)
+    {
+        centerX_[index] = centerY_[index] = centerZ_[index] = 0.0f;
+        halfSizeX_[index] = halfSizeY_[index] = halfSizeZ_[index] = M_LARGE_VALUE;
+    }
+
+    /// Update the view mask of an entry.
+    void SetViewMask(unsigned index, unsigned viewMask) { viewMasks_[index] = viewMask; }
+
+    /// Remove all entries.
+    void Clear()
+    {
+        centerX_.Clear();
+        centerY_.Clear();
+        centerZ_.Clear();
+        halfSizeX_.Clear();
+        halfSizeY_.Clear();
+        halfSizeZ_.Clear();
+        drawableFlags_.Clear();
+        viewMasks_.Clear();
+    }
+
+    /// Return number of entries.
+    unsigned Size() const { return viewMasks_.Size(); }
+
+    /// Return whether the box of an entry is out of date, or too large to be told apart from one.
+    bool IsInvalid(unsigned index) const { return halfSizeX_[index] >= M_LARGE_VALUE; }
+
+    /// Test entries [start, end) against the flags, view mask and frustum. Write the indices of the entries which pass to the output, which must have room for end - start indices, and return their count. Invalid boxes always pass the frustum test.
+    unsigned Cull(unsigned start, unsigned end, const Frustum& frustum, unsigned char drawableFlags, unsigned viewMask, unsigned* indices) const;
+
+    /// Box center X coordinates.
+    PODVector<float> centerX_;
+    /// Box center Y coordinates.
+    PODVector<float> centerY_;
+    /// Box center Z coordinates.
+    PODVector<float> centerZ_;
+    /// Box half sizes on the X axis.
+    PODVector<float> halfSizeX_;
+    /// Box half sizes on the Y axis.
+    PODVector<float> halfSizeY_;
+    /// Box half sizes on the Z axis.
+    PODVector<float> halfSizeZ_;
+    /// Drawable flags.
+    PODVector<unsigned char> drawableFlags_;
+    /// View masks.
+    PODVector<unsigned> viewMasks_;
+};
+
+}
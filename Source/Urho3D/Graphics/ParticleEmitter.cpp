@@ -72,6 +72,7 @@ void ParticleEmitter::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Draw Distance", GetDrawDistance, SetDrawDistance, float, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Shadow Distance", GetShadowDistance, SetShadowDistance, float, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Animation LOD Bias", GetAnimationLodBias, SetAnimationLodBias, float, 1.0f, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Hardware Instancing", IsInstanced, SetInstanced, bool, false, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Is Emitting", bool, emitting_, true, AM_FILE);
     URHO3D_ATTRIBUTE("Period Timer", float, periodTimer_, 0.0f, AM_FILE | AM_NOEDIT);
     URHO3D_ATTRIBUTE("Emission Timer", float, emissionTimer_, 0.0f, AM_FILE | AM_NOEDIT);
@@ -79,7 +80,7 @@ void ParticleEmitter::RegisterObject(Context* context)
     URHO3D_COPY_BASE_ATTRIBUTES(Drawable);
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Particles", GetParticlesAttr, SetParticlesAttr, VariantVector, Variant::emptyVariantVector,
         AM_FILE | AM_NOEDIT);
-    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Billboards", GetParticleBillboardsAttr, SetBillboardsAttr, VariantVector, Variant::emptyVariantVector,
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Billboards", GetParticleBillboardsAttr, SetParticleBillboardsAttr, VariantVector, Variant::emptyVariantVector,
         AM_FILE | AM_NOEDIT);
     URHO3D_ATTRIBUTE("Serialize Particles", bool, serializeParticles_, true, AM_FILE);
 }
@@ -108,10 +109,13 @@ void ParticleEmitter::Update(const FrameInfo& frame)
         return;
 
     // If there is an amount mismatch between particles and billboards, correct it
-    if (particles_.Size() != billboards_.Size())
-        SetNumBillboards(particles_.Size());
+    const unsigned numParticles = particles_.GetCapacity();
+    if (numParticles != billboards_.Size())
+        SetNumBillboards(numParticles);
 
-    bool needCommit = false;
+    // Billboards of the previously active particles are enabled
+    const unsigned numEnabled = particles_.numActive_;
+    bool needCommit = numEnabled > 0;
 
     // Check active/inactive period switching
     periodTimer_ += lastTimeStep_;
@@ -138,7 +142,7 @@ void ParticleEmitter::Update(const FrameInfo& frame)
             periodTimer_ = 0.0f;
     }
 
-    // Check for emitting new particles
+    // Check for emitting new particles. They are created in one batch after the active ones
     if (emitting_)
     {
         emissionTimer_ += lastTimeStep_;
@@ -150,110 +154,87 @@ void ParticleEmitter::Update(const FrameInfo& frame)
         if (emissionTimer_ < -intervalMax)
             emissionTimer_ = -intervalMax;
 
-        unsigned counter = MAX_PARTICLES_IN_FRAME;
+        // Allow at least the maximum emission rate's worth of particles per frame, so that large effects can keep up
+        const unsigned maxNew = Max(MAX_PARTICLES_IN_FRAME, (unsigned)(effect_->GetMaxEmissionRate() * lastTimeStep_) + 1);
+        const unsigned numFree = numParticles - particles_.numActive_;
+        unsigned numNew = 0;
 
-        while (emissionTimer_ > 0.0f && counter)
+        while (emissionTimer_ > 0.0f && numNew < maxNew)
         {
             emissionTimer_ -= Lerp(intervalMin, intervalMax, Random(1.0f));
-            if (EmitNewParticle())
-            {
-                --counter;
-                needCommit = true;
-            }
-            else
+            if (numNew == numFree)
                 break;
+            ++numNew;
+        }
+
+        if (numNew)
+        {
+            EmitNewParticles(numNew);
+            needCommit = true;
         }
     }
 
     // Update existing particles
-    Vector3 relativeConstantForce = node_->GetWorldRotation().Inverse() * effect_->GetConstantForce();
+    particles_.RemoveExpired();
+
+    const Vector3& constantForce = effect_->GetConstantForce();
+    const Vector3 force = relative_ ? node_->GetWorldRotation().Inverse() * constantForce : constantForce;
     // If billboards are not relative, apply scaling to the position update
     Vector3 scaleVector = Vector3::ONE;
     if (scaled_ && !relative_)
         scaleVector = node_->GetWorldScale();
 
-    for (unsigned i = 0; i < particles_.Size(); ++i)
-    {
-        Particle& particle = particles_[i];
-        Billboard& billboard = billboards_[i];
-
-        if (billboard.enabled_)
-        {
-            needCommit = true;
+    particles_.Integrate(lastTimeStep_, force, effect_->GetDampingForce(), scaleVector, effect_->GetSizeAdd(), effect_->GetSizeMul());
 
-            // Time to live
-            if (particle.timer_ >= particle.timeToLive_)
-            {
-                billboard.enabled_ = false;
-                continue;
-            }
-            particle.timer_ += lastTimeStep_;
+    // Copy the particles to the billboards, with color and texture animation
+    const Vector<ColorFrame>& colorFrames = effect_->GetColorFrames();
+    const Vector<TextureFrame>& textureFrames = effect_->GetTextureFrames();
+    const unsigned numActive = particles_.numActive_;
 
-            // Velocity & position
-            const Vector3& constantForce = effect_->GetConstantForce();
-            if (constantForce != Vector3::ZERO)
-            {
-                if (relative_)
-                    particle.velocity_ += lastTimeStep_ * relativeConstantForce;
-                else
-                    particle.velocity_ += lastTimeStep_ * constantForce;
-            }
-
-            float dampingForce = effect_->GetDampingForce();
-            if (dampingForce != 0.0f)
-            {
-                Vector3 force = -dampingForce * particle.velocity_;
-                particle.velocity_ += lastTimeStep_ * force;
-            }
-            billboard.position_ += lastTimeStep_ * particle.velocity_ * scaleVector;
-            billboard.direction_ = particle.velocity_.Normalized();
-
-            // Rotation
-            billboard.rotation_ += lastTimeStep_ * particle.rotationSpeed_;
+    for (unsigned i = 0; i < numActive; ++i)
+    {
+        Billboard& billboard = billboards_[i];
+        const float timer = particles_.timer_[i];
 
-            // Scaling
-            float sizeAdd = effect_->GetSizeAdd();
-            float sizeMul = effect_->GetSizeMul();
-            if (sizeAdd != 0.0f || sizeMul != 1.0f)
-            {
-                particle.scale_ += lastTimeStep_ * sizeAdd;
-                if (particle.scale_ < 0.0f)
-                    particle.scale_ = 0.0f;
-                if (sizeMul != 1.0f)
-                    particle.scale_ *= (lastTimeStep_ * (sizeMul - 1.0f)) + 1.0f;
-                billboard.size_ = particle.size_ * particle.scale_;
-            }
+        billboard.position_ = Vector3(particles_.positionX_[i], particles_.positionY_[i], particles_.positionZ_[i]);
+        billboard.direction_ = Vector3(particles_.directionX_[i], particles_.directionY_[i], particles_.directionZ_[i]);
+        billboard.size_ = Vector2(particles_.sizeX_[i], particles_.sizeY_[i]) * particles_.scale_[i];
+        billboard.rotation_ = particles_.rotation_[i];
+        billboard.enabled_ = true;
 
-            // Color interpolation
-            unsigned& index = particle.colorIndex_;
-            const Vector<ColorFrame>& colorFrames_ = effect_->GetColorFrames();
-            if (index < colorFrames_.Size())
+        // Color interpolation
+        unsigned& index = particles_.colorIndex_[i];
+        if (index < colorFrames.Size())
+        {
+            if (index < colorFrames.Size() - 1)
             {
-                if (index < colorFrames_.Size() - 1)
-                {
-                    if (particle.timer_ >= colorFrames_[index + 1].time_)
-                        ++index;
-                }
-                if (index < colorFrames_.Size() - 1)
-                    billboard.color_ = colorFrames_[index].Interpolate(colorFrames_[index + 1], particle.timer_);
-                else
-                    billboard.color_ = colorFrames_[index].color_;
+                if (timer >= colorFrames[index + 1].time_)
+                    ++index;
             }
+            if (index < colorFrames.Size() - 1)
+                billboard.color_ = colorFrames[index].Interpolate(colorFrames[index + 1], timer);
+            else
+                billboard.color_ = colorFrames[index].color_;
+        }
+        else
+            billboard.color_ = Color();
 
-            // Texture animation
-            unsigned& texIndex = particle.texIndex_;
-            const Vector<TextureFrame>& textureFrames_ = effect_->GetTextureFrames();
-            if (textureFrames_.Size() && texIndex < textureFrames_.Size() - 1)
-            {
-                if (particle.timer_ >= textureFrames_[texIndex + 1].time_)
-                {
-                    billboard.uv_ = textureFrames_[texIndex + 1].uv_;
-                    ++texIndex;
-                }
-            }
+        // Texture animation
+        unsigned& texIndex = particles_.texIndex_[i];
+        if (textureFrames.Size())
+        {
+            if (texIndex < textureFrames.Size() - 1 && timer >= textureFrames[texIndex + 1].time_)
+                ++texIndex;
+            billboard.uv_ = textureFrames[texIndex].uv_;
         }
+        else
+            billboard.uv_ = Rect::POSITIVE;
     }
 
+    // Disable the billboards of expired particles
+    for (unsigned i = numActive; i < numEnabled; ++i)
+        billboards_[i].enabled_ = false;
+
     if (needCommit)
         Commit();
 
@@ -288,6 +269,10 @@ void ParticleEmitter::SetNumParticles(unsigned num)
 
     particles_.Resize(num);
     SetNumBillboards(num);
+
+    // Billboards of particles that no longer fit are disabled
+    for (unsigned i = particles_.numActive_; i < billboards_.Size(); ++i)
+        billboards_[i].enabled_ = false;
 }
 
 void ParticleEmitter::SetEmitting(bool enable)
@@ -322,6 +307,7 @@ void ParticleEmitter::ResetEmissionTimer()
 
 void ParticleEmitter::RemoveAllParticles()
 {
+    particles_.numActive_ = 0;
     for (PODVector<Billboard>::Iterator i = billboards_.Begin(); i != billboards_.End(); ++i)
         i->enabled_ = false;
 
@@ -371,44 +357,86 @@ void ParticleEmitter::SetParticlesAttr(const VariantVector& value)
     unsigned index = 0;
     SetNumParticles(index < value.Size() ? value[index++].GetUInt() : 0);
 
-    for (PODVector<Particle>::Iterator i = particles_.Begin(); i != particles_.End() && index < value.Size(); ++i)
+    // Which particles are active is known from the billboards attribute, which is set after this one
+    particles_.numActive_ = 0;
+
+    for (unsigned i = 0; i < particles_.GetCapacity() && index < value.Size(); ++i)
     {
-        i->velocity_ = value[index++].GetVector3();
-        i->size_ = value[index++].GetVector2();
-        i->timer_ = value[index++].GetFloat();
-        i->timeToLive_ = value[index++].GetFloat();
-        i->scale_ = value[index++].GetFloat();
-        i->rotationSpeed_ = value[index++].GetFloat();
-        i->colorIndex_ = (unsigned)value[index++].GetInt();
-        i->texIndex_ = (unsigned)value[index++].GetInt();
+        const Vector3 velocity = value[index++].GetVector3();
+        particles_.velocityX_[i] = velocity.x_;
+        particles_.velocityY_[i] = velocity.y_;
+        particles_.velocityZ_[i] = velocity.z_;
+        const Vector2 size = value[index++].GetVector2();
+        particles_.sizeX_[i] = size.x_;
+        particles_.sizeY_[i] = size.y_;
+        particles_.timer_[i] = value[index++].GetFloat();
+        particles_.timeToLive_[i] = value[index++].GetFloat();
+        particles_.scale_[i] = value[index++].GetFloat();
+        particles_.rotationSpeed_[i] = value[index++].GetFloat();
+        particles_.colorIndex_[i] = (unsigned)value[index++].GetInt();
+        particles_.texIndex_[i] = (unsigned)value[index++].GetInt();
     }
 }
 
 VariantVector ParticleEmitter::GetParticlesAttr() const
 {
     VariantVector ret;
+    const unsigned numParticles = particles_.GetCapacity();
     if (!serializeParticles_)
     {
-        ret.Push(particles_.Size());
+        ret.Push(numParticles);
         return ret;
     }
 
-    ret.Reserve(particles_.Size() * 8 + 1);
-    ret.Push(particles_.Size());
-    for (PODVector<Particle>::ConstIterator i = particles_.Begin(); i != particles_.End(); ++i)
+    ret.Reserve(numParticles * 8 + 1);
+    ret.Push(numParticles);
+    for (unsigned i = 0; i < numParticles; ++i)
     {
-        ret.Push(i->velocity_);
-        ret.Push(i->size_);
-        ret.Push(i->timer_);
-        ret.Push(i->timeToLive_);
-        ret.Push(i->scale_);
-        ret.Push(i->rotationSpeed_);
-        ret.Push(i->colorIndex_);
-        ret.Push(i->texIndex_);
+        ret.Push(Vector3(particles_.velocityX_[i], particles_.velocityY_[i], particles_.velocityZ_[i]));
+        ret.Push(Vector2(particles_.sizeX_[i], particles_.sizeY_[i]));
+        ret.Push(particles_.timer_[i]);
+        ret.Push(particles_.timeToLive_[i]);
+        ret.Push(particles_.scale_[i]);
+        ret.Push(particles_.rotationSpeed_[i]);
+        ret.Push(particles_.colorIndex_[i]);
+        ret.Push(particles_.texIndex_[i]);
     }
     return ret;
 }
 
+void ParticleEmitter::SetParticleBillboardsAttr(const VariantVector& value)
+{
+    SetBillboardsAttr(value);
+
+    // Pack the particles of the enabled billboards to the front, and take their positions and rotations from the billboards
+    unsigned numActive = 0;
+    const unsigned numParticles = Min(particles_.GetCapacity(), billboards_.Size());
+    for (unsigned i = 0; i < numParticles; ++i)
+    {
+        if (!billboards_[i].enabled_)
+            continue;
+
+        if (i != numActive)
+        {
+            particles_.Move(numActive, i);
+            billboards_[numActive] = billboards_[i];
+            billboards_[i].enabled_ = false;
+        }
+
+        const Billboard& billboard = billboards_[numActive];
+        particles_.positionX_[numActive] = billboard.position_.x_;
+        particles_.positionY_[numActive] = billboard.position_.y_;
+        particles_.positionZ_[numActive] = billboard.position_.z_;
+        particles_.directionX_[numActive] = billboard.direction_.x_;
+        particles_.directionY_[numActive] = billboard.direction_.y_;
+        particles_.directionZ_[numActive] = billboard.direction_.z_;
+        particles_.rotation_[numActive] = billboard.rotation_;
+        ++numActive;
+    }
+
+    particles_.numActive_ = numActive;
+}
+
 VariantVector ParticleEmitter::GetParticleBillboardsAttr() const
 {
     VariantVector ret;
@@ -447,129 +475,124 @@ void ParticleEmitter::OnSceneSet(Scene* scene)
 
 bool ParticleEmitter::EmitNewParticle()
 {
-    unsigned index = GetFreeParticle();
-    if (index == M_MAX_UNSIGNED)
-        return false;
-    assert(index < particles_.Size());
-    Particle& particle = particles_[index];
-    Billboard& billboard = billboards_[index];
+    return EmitNewParticles(1) == 1;
+}
 
-    Vector3 startDir;
-    Vector3 startPos;
+unsigned ParticleEmitter::EmitNewParticles(unsigned count)
+{
+    const unsigned first = particles_.numActive_;
+    count = particles_.Emit(count);
 
-    startDir = effect_->GetRandomDirection();
-    startDir.Normalize();
+    const EmitterType emitterType = effect_->GetEmitterType();
+    const Vector3& emitterSize = effect_->GetEmitterSize();
+    const Matrix3x4& worldTransform = node_->GetWorldTransform();
+    const Quaternion worldRotation = node_->GetWorldRotation();
 
-    switch (effect_->GetEmitterType())
+    for (unsigned index = first; index < first + count; ++index)
     {
-    case EMITTER_SPHERE:
-        {
-            Vector3 dir(
-                Random(2.0f) - 1.0f,
-                Random(2.0f) - 1.0f,
-                Random(2.0f) - 1.0f
-            );
-            dir.Normalize();
-            startPos = effect_->GetEmitterSize() * dir * 0.5f;
-        }
-        break;
+        Vector3 startDir;
+        Vector3 startPos;
 
-    case EMITTER_BOX:
-        {
-            const Vector3& emitterSize = effect_->GetEmitterSize();
-            startPos = Vector3(
-                Random(emitterSize.x_) - emitterSize.x_ * 0.5f,
-                Random(emitterSize.y_) - emitterSize.y_ * 0.5f,
-                Random(emitterSize.z_) - emitterSize.z_ * 0.5f
-            );
-        }
-        break;
+        startDir = effect_->GetRandomDirection();
+        startDir.Normalize();
 
-    case EMITTER_SPHEREVOLUME:
+        switch (emitterType)
         {
-            Vector3 dir(
-                Random(2.0f) - 1.0f,
-                Random(2.0f) - 1.0f,
-                Random(2.0f) - 1.0f
-            );
-            dir.Normalize();
-            startPos = effect_->GetEmitterSize() * dir * Pow(Random(), 1.0f / 3.0f) * 0.5f;
+        case EMITTER_SPHERE:
+            {
+                Vector3 dir(
+                    Random(2.0f) - 1.0f,
+                    Random(2.0f) - 1.0f,
+                    Random(2.0f) - 1.0f
+                );
+                dir.Normalize();
+                startPos = emitterSize * dir * 0.5f;
+            }
+            break;
+
+        case EMITTER_BOX:
+            {
+                startPos = Vector3(
+                    Random(emitterSize.x_) - emitterSize.x_ * 0.5f,
+                    Random(emitterSize.y_) - emitterSize.y_ * 0.5f,
+                    Random(emitterSize.z_) - emitterSize.z_ * 0.5f
+                );
+            }
+            break;
+
+        case EMITTER_SPHEREVOLUME:
+            {
+                Vector3 dir(
+                    Random(2.0f) - 1.0f,
+                    Random(2.0f) - 1.0f,
+                    Random(2.0f) - 1.0f
+                );
+                dir.Normalize();
+                startPos = emitterSize * dir * Pow(Random(), 1.0f / 3.0f) * 0.5f;
+            }
+            break;
+
+        case EMITTER_CYLINDER:
+            {
+                float angle = Random(360.0f);
+                float radius = Sqrt(Random()) * 0.5f;
+                startPos = Vector3(Cos(angle) * radius, Random() - 0.5f, Sin(angle) * radius) * emitterSize;
+            }
+            break;
+
+        case EMITTER_RING:
+            {
+                float angle = Random(360.0f);
+                startPos = Vector3(Cos(angle), Random(2.0f) - 1.0f, Sin(angle)) * emitterSize * 0.5f;
+            }
+            break;
         }
-        break;
 
-    case EMITTER_CYLINDER:
+        const Vector2 size = effect_->GetRandomSize();
+        particles_.sizeX_[index] = size.x_;
+        particles_.sizeY_[index] = size.y_;
+        particles_.timer_[index] = 0.0f;
+        particles_.timeToLive_[index] = effect_->GetRandomTimeToLive();
+        particles_.scale_[index] = 1.0f;
+        particles_.rotationSpeed_[index] = effect_->GetRandomRotationSpeed();
+        particles_.colorIndex_[index] = 0;
+        particles_.texIndex_[index] = 0;
+
+        if (faceCameraMode_ == FC_DIRECTION)
         {
-            float angle = Random(360.0f);
-            float radius = Sqrt(Random()) * 0.5f;
-            startPos = Vector3(Cos(angle) * radius, Random() - 0.5f, Sin(angle) * radius) * effect_->GetEmitterSize();
+            startPos += startDir * size.y_;
         }
-        break;
 
-    case EMITTER_RING:
+        if (!relative_)
         {
-            float angle = Random(360.0f);
-            startPos = Vector3(Cos(angle), Random(2.0f) - 1.0f, Sin(angle)) * effect_->GetEmitterSize() * 0.5f;
+            startPos = worldTransform * startPos;
+            startDir = worldRotation * startDir;
         }
-        break;
-    }
 
-    particle.size_ = effect_->GetRandomSize();
-    particle.timer_ = 0.0f;
-    particle.timeToLive_ = effect_->GetRandomTimeToLive();
-    particle.scale_ = 1.0f;
-    particle.rotationSpeed_ = effect_->GetRandomRotationSpeed();
-    particle.colorIndex_ = 0;
-    particle.texIndex_ = 0;
-
-    if (faceCameraMode_ == FC_DIRECTION)
-    {
-        startPos += startDir * particle.size_.y_;
+        const Vector3 velocity = effect_->GetRandomVelocity() * startDir;
+        particles_.velocityX_[index] = velocity.x_;
+        particles_.velocityY_[index] = velocity.y_;
+        particles_.velocityZ_[index] = velocity.z_;
+        particles_.positionX_[index] = startPos.x_;
+        particles_.positionY_[index] = startPos.y_;
+        particles_.positionZ_[index] = startPos.z_;
+        particles_.directionX_[index] = startDir.x_;
+        particles_.directionY_[index] = startDir.y_;
+        particles_.directionZ_[index] = startDir.z_;
+        particles_.rotation_[index] = effect_->GetRandomRotation();
     }
 
-    if (!relative_)
-    {
-        startPos = node_->GetWorldTransform() * startPos;
-        startDir = node_->GetWorldRotation() * startDir;
-    };
-
-    particle.velocity_ = effect_->GetRandomVelocity() * startDir;
-
-    billboard.position_ = startPos;
-    billboard.size_ = particles_[index].size_;
-    const Vector<TextureFrame>& textureFrames_ = effect_->GetTextureFrames();
-    billboard.uv_ = textureFrames_.Size() ? textureFrames_[0].uv_ : Rect::POSITIVE;
-    billboard.rotation_ = effect_->GetRandomRotation();
-    const Vector<ColorFrame>& colorFrames_ = effect_->GetColorFrames();
-    billboard.color_ = colorFrames_.Size() ? colorFrames_[0].color_ : Color();
-    billboard.enabled_ = true;
-    billboard.direction_ = startDir;
-
-    return true;
+    return count;
 }
 
 unsigned ParticleEmitter::GetFreeParticle() const
 {
-    for (unsigned i = 0; i < billboards_.Size(); ++i)
-    {
-        if (!billboards_[i].enabled_)
-            return i;
-    }
-
-    return M_MAX_UNSIGNED;
+    return particles_.numActive_ < particles_.GetCapacity() ? particles_.numActive_ : M_MAX_UNSIGNED;
 }
 
 bool ParticleEmitter::CheckActiveParticles() const
 {
-    for (unsigned i = 0; i < billboards_.Size(); ++i)
-    {
-        if (billboards_[i].enabled_)
-        {
-            return true;
-            break;
-        }
-    }
-
-    return false;
+    return particles_.numActive_ > 0;
 }
 
 void ParticleEmitter::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
@@ -23,33 +23,13 @@
 #pragma once
 
 #include "../Graphics/BillboardSet.h"
+#include "../Graphics/ParticleStore.h"
 
 namespace Urho3D
 {
 
 class ParticleEffect;
 
-/// One particle in the particle system.
-struct Particle
-{
-    /// Velocity.
-    Vector3 velocity_;
-    /// Original billboard size.
-    Vector2 size_;
-    /// Time elapsed from creation.
-    float timer_;
-    /// Lifetime.
-    float timeToLive_;
-    /// Size scaling value.
-    float scale_;
-    /// Rotation speed.
-    float rotationSpeed_;
-    /// Current color animation index.
-    unsigned colorIndex_;
-    /// Current texture animation index.
-    unsigned texIndex_;
-};
-
 /// %Particle emitter component.
 class URHO3D_API ParticleEmitter : public BillboardSet
 {
@@ -99,7 +79,10 @@ public:
 
     /// Return maximum number of particles.
     /// @property
-    unsigned GetNumParticles() const { return particles_.Size(); }
+    unsigned GetNumParticles() const { return particles_.GetCapacity(); }
+
+    /// Return number of currently active particles.
+    unsigned GetNumActiveParticles() const { return particles_.numActive_; }
 
     /// Return whether is currently emitting.
     /// @property
@@ -121,6 +104,8 @@ public:
     void SetParticlesAttr(const VariantVector& value);
     /// Return particles attribute. Returns particle amount only if particles are not to be serialized.
     VariantVector GetParticlesAttr() const;
+    /// Set billboards attribute. Packs the active particles to the front.
+    void SetParticleBillboardsAttr(const VariantVector& value);
     /// Return billboards attribute. Returns billboard amount only if particles are not to be serialized.
     VariantVector GetParticleBillboardsAttr() const;
 
@@ -130,6 +115,8 @@ protected:
 
     /// Create a new particle. Return true if there was room.
     bool EmitNewParticle();
+    /// Create new particles after the active ones. Return the number created.
+    unsigned EmitNewParticles(unsigned count);
     /// Return a free particle index.
     unsigned GetFreeParticle() const;
     /// Return whether has active particles.
@@ -144,7 +131,7 @@ private:
     /// Particle effect.
     SharedPtr<ParticleEffect> effect_;
     /// Particles.
-    PODVector<Particle> particles_;
+    ParticleStore particles_;
     /// Active/inactive period timer.
     float periodTimer_;
     /// New particle emission timer.
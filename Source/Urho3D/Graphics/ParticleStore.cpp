@@ -0,0 +1,194 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Graphics/ParticleStore.h"
+
+#if defined(URHO3D_SSE) || defined(__SSE2__) || defined(_M_X64)
+#define URHO3D_PARTICLES_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+void ParticleStore::Resize(unsigned capacity)
+{
+    positionX_.Resize(capacity);
+    positionY_.Resize(capacity);
+    positionZ_.Resize(capacity);
+    velocityX_.Resize(capacity);
+    velocityY_.Resize(capacity);
+    velocityZ_.Resize(capacity);
+    directionX_.Resize(capacity);
+    directionY_.Resize(capacity);
+    directionZ_.Resize(capacity);
+    sizeX_.Resize(capacity);
+    sizeY_.Resize(capacity);
+    scale_.Resize(capacity);
+    timer_.Resize(capacity);
+    timeToLive_.Resize(capacity);
+    rotation_.Resize(capacity);
+    rotationSpeed_.Resize(capacity);
+    colorIndex_.Resize(capacity);
+    texIndex_.Resize(capacity);
+    numActive_ = Min(numActive_, capacity);
+}
+
+unsigned ParticleStore::Emit(unsigned count)
+{
+    count = Min(count, GetCapacity() - numActive_);
+    numActive_ += count;
+    return count;
+}
+
+void ParticleStore::Move(unsigned dest, unsigned src)
+{
+    positionX_[dest] = positionX_[src];
+    positionY_[dest] = positionY_[src];
+    positionZ_[dest] = positionZ_[src];
+    velocityX_[dest] = velocityX_[src];
+    velocityY_[dest] = velocityY_[src];
+    velocityZ_[dest] = velocityZ_[src];
+    directionX_[dest] = directionX_[src];
+    directionY_[dest] = directionY_[src];
+    directionZ_[dest] = directionZ_[src];
+    sizeX_[dest] = sizeX_[src];
+    sizeY_[dest] = sizeY_[src];
+    scale_[dest] = scale_[src];
+    timer_[dest] = timer_[src];
+    timeToLive_[dest] = timeToLive_[src];
+    rotation_[dest] = rotation_[src];
+    rotationSpeed_[dest] = rotationSpeed_[src];
+    colorIndex_[dest] = colorIndex_[src];
+    texIndex_[dest] = texIndex_[src];
+}
+
+void ParticleStore::RemoveExpired()
+{
+    unsigned i = 0;
+    while (i < numActive_)
+    {
+        if (timer_[i] >= timeToLive_[i])
+        {
+            --numActive_;
+            if (i < numActive_)
+                Move(i, numActive_);
+        }
+        else
+            ++i;
+    }
+}
+
+void ParticleStore::Integrate(float timeStep, const Vector3& force, float damping, const Vector3& positionScale, float sizeAdd,
+    float sizeMul)
+{
+    const Vector3 velocityAdd = timeStep * force;
+    const float velocityMul = 1.0f - timeStep * damping;
+    const Vector3 positionMul = timeStep * positionScale;
+    const bool scaleSize = sizeAdd != 0.0f || sizeMul != 1.0f;
+    const float scaleAdd = timeStep * sizeAdd;
+    const float scaleMul = timeStep * (sizeMul - 1.0f) + 1.0f;
+    unsigned i = 0;
+
+#ifdef URHO3D_PARTICLES_SSE2
+    const __m128 timeStepVec = _mm_set1_ps(timeStep);
+    const __m128 velocityAddX = _mm_set1_ps(velocityAdd.x_);
+    const __m128 velocityAddY = _mm_set1_ps(velocityAdd.y_);
+    const __m128 velocityAddZ = _mm_set1_ps(velocityAdd.z_);
+    const __m128 velocityMulVec = _mm_set1_ps(velocityMul);
+    const __m128 positionMulX = _mm_set1_ps(positionMul.x_);
+    const __m128 positionMulY = _mm_set1_ps(positionMul.y_);
+    const __m128 positionMulZ = _mm_set1_ps(positionMul.z_);
+    const __m128 scaleAddVec = _mm_set1_ps(scaleAdd);
+    const __m128 scaleMulVec = _mm_set1_ps(scaleMul);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (; i + 4 <= numActive_; i += 4)
+    {
+        _mm_storeu_ps(&timer_[i], _mm_add_ps(_mm_loadu_ps(&timer_[i]), timeStepVec));
+
+        const __m128 vx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velocityX_[i]), velocityAddX), velocityMulVec);
+        const __m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velocityY_[i]), velocityAddY), velocityMulVec);
+        const __m128 vz = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velocityZ_[i]), velocityAddZ), velocityMulVec);
+        _mm_storeu_ps(&velocityX_[i], vx);
+        _mm_storeu_ps(&velocityY_[i], vy);
+        _mm_storeu_ps(&velocityZ_[i], vz);
+
+        _mm_storeu_ps(&positionX_[i], _mm_add_ps(_mm_loadu_ps(&positionX_[i]), _mm_mul_ps(vx, positionMulX)));
+        _mm_storeu_ps(&positionY_[i], _mm_add_ps(_mm_loadu_ps(&positionY_[i]), _mm_mul_ps(vy, positionMulY)));
+        _mm_storeu_ps(&positionZ_[i], _mm_add_ps(_mm_loadu_ps(&positionZ_[i]), _mm_mul_ps(vz, positionMulZ)));
+
+        // Zero velocities keep a zero direction
+        const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+        const __m128 nonZero = _mm_cmpgt_ps(lengthSquared, zero);
+        const __m128 invLength = _mm_and_ps(nonZero, _mm_div_ps(one, _mm_sqrt_ps(lengthSquared)));
+        _mm_storeu_ps(&directionX_[i], _mm_mul_ps(vx, invLength));
+        _mm_storeu_ps(&directionY_[i], _mm_mul_ps(vy, invLength));
+        _mm_storeu_ps(&directionZ_[i], _mm_mul_ps(vz, invLength));
+
+        _mm_storeu_ps(&rotation_[i], _mm_add_ps(_mm_loadu_ps(&rotation_[i]), _mm_mul_ps(_mm_loadu_ps(&rotationSpeed_[i]),
+            timeStepVec)));
+
+        if (scaleSize)
+        {
+            const __m128 scale = _mm_max_ps(_mm_add_ps(_mm_loadu_ps(&scale_[i]), scaleAddVec), zero);
+            _mm_storeu_ps(&scale_[i], _mm_mul_ps(scale, scaleMulVec));
+        }
+    }
+#endif
+
+    // Remainder, or all particles without SIMD
+    for (; i < numActive_; ++i)
+    {
+        timer_[i] += timeStep;
+
+        const float vx = (velocityX_[i] + velocityAdd.x_) * velocityMul;
+        const float vy = (velocityY_[i] + velocityAdd.y_) * velocityMul;
+        const float vz = (velocityZ_[i] + velocityAdd.z_) * velocityMul;
+        velocityX_[i] = vx;
+        velocityY_[i] = vy;
+        velocityZ_[i] = vz;
+
+        positionX_[i] += vx * positionMul.x_;
+        positionY_[i] += vy * positionMul.y_;
+        positionZ_[i] += vz * positionMul.z_;
+
+        const float lengthSquared = vx * vx + vy * vy + vz * vz;
+        const float invLength = lengthSquared > 0.0f ? 1.0f / sqrtf(lengthSquared) : 0.0f;
+        directionX_[i] = vx * invLength;
+        directionY_[i] = vy * invLength;
+        directionZ_[i] = vz * invLength;
+
+        rotation_[i] += rotationSpeed_[i] * timeStep;
+
+        if (scaleSize)
+            scale_[i] = Max(scale_[i] + scaleAdd, 0.0f) * scaleMul;
+    }
+}
+
+}
@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Math/Vector3.h"
+
+namespace Urho3D
+{
+
+/// Structure-of-arrays simulation state of a particle emitter, so that the particles can be integrated several at a time. Active particles are kept packed at the front; emission appends to them and expiry moves the last active particle into the freed slot.
+/// @nobind
+struct URHO3D_API ParticleStore
+{
+    /// Set the number of particle slots. Active particles beyond it are dropped.
+    void Resize(unsigned capacity);
+    /// Activate up to the given number of particles after the current ones and return how many fit. The caller initializes them.
+    unsigned Emit(unsigned count);
+    /// Copy a particle from one slot to another.
+    void Move(unsigned dest, unsigned src);
+    /// Remove the active particles whose time to live has elapsed.
+    void RemoveExpired();
+    /// Advance the active particles by a time step: apply the force and damping to the velocities, move the positions by the velocities multiplied with the position scale, update the directions, rotations and size scaling. Size scaling is skipped if the size add is zero and the size multiplier one.
+    void Integrate(float timeStep, const Vector3& force, float damping, const Vector3& positionScale, float sizeAdd, float sizeMul);
+
+    /// Return number of particle slots.
+    unsigned GetCapacity() const { return timer_.Size(); }
+
+    /// Position X coordinates.
+    PODVector<float> positionX_;
+    /// Position Y coordinates.
+    PODVector<float> positionY_;
+    /// Position Z coordinates.
+    PODVector<float> positionZ_;
+    /// Velocity X components.
+    PODVector<float> velocityX_;
+    /// Velocity Y components.
+    PODVector<float> velocityY_;
+    /// Velocity Z components.
+    PODVector<float> velocityZ_;
+    /// Normalized velocity X components.
+    PODVector<float> directionX_;
+    /// Normalized velocity Y components.
+    PODVector<float> directionY_;
+    /// Normalized velocity Z components.
+    PODVector<float> directionZ_;
+    /// Original billboard widths.
+    PODVector<float> sizeX_;
+    /// Original billboard heights.
+    PODVector<float> sizeY_;
+    /// Size scaling values.
+    PODVector<float> scale_;
+    /// Times elapsed from creation.
+    PODVector<float> timer_;
+    /// Lifetimes.
+    PODVector<float> timeToLive_;
+    /// Billboard rotations.
+    PODVector<float> rotation_;
+    /// Rotation speeds.
+    PODVector<float> rotationSpeed_;
+    /// Current color animation indices.
+    PODVector<unsigned> colorIndex_;
+    /// Current texture animation indices.
+    PODVector<unsigned> texIndex_;
+    /// Number of active particles.
+    unsigned numActive_{};
+};
+
+}
@@ -153,6 +153,8 @@ void RenderPathCommand::Load(const XMLElement& element)
             markToStencil_ = element.GetBool("marktostencil");
         if (element.HasAttribute("vertexlights"))
             vertexLights_ = element.GetBool("vertexlights");
+        if (element.HasAttribute("clusteredlights"))
+            clusteredLights_ = element.GetBool("clusteredlights");
         break;
 
     case CMD_FORWARDLIGHTS:
@@ -194,6 +194,8 @@ struct URHO3D_API RenderPathCommand
     bool useLitBase_{true};
     /// Vertex lights flag.
     bool vertexLights_{};
+    /// Clustered lights flag. Affects scenepass command only.
+    bool clusteredLights_{};
     /// Event name.
     String eventName_;
 };
@@ -23,6 +23,7 @@
 #include "../Precompiled.h"
 
 #include "../Core/CoreEvents.h"
+#include "../Core/FrameAllocator.h"
 #include "../Core/Profiler.h"
 #include "../Graphics/Camera.h"
 #include "../Graphics/DebugRenderer.h"
@@ -183,7 +184,9 @@ static const char* geometryVSVariations[] =
     "BILLBOARD ",
     "DIRBILLBOARD ",
     "TRAILFACECAM ",
-    "TRAILBONE "
+    "TRAILBONE ",
+    "SKINNED INSTANCED ",
+    "BILLBOARD INSTANCED "
 };
 
 static const char* lightVSVariations[] =
@@ -660,6 +663,7 @@ void Renderer::Update(float timeStep)
     frame_.frameNumber_ = GetSubsystem<Time>()->GetFrameNumber();
     frame_.timeStep_ = timeStep;
     frame_.camera_ = nullptr;
+    frame_.allocator_ = GetSubsystem<FrameAllocator>();
     numShadowCameras_ = 0;
     numOcclusionBuffers_ = 0;
     updatedOctrees_.Clear();
@@ -833,6 +837,55 @@ Geometry* Renderer::GetQuadGeometry()
     return dirLightGeometry_;
 }
 
+bool Renderer::UpdateSkinMatrixTexture(const PODVector<Matrix3x4>& skinMatrices)
+{
+    const unsigned numTexels = skinMatrices.Size() * 3;
+    const unsigned numRows = (numTexels + SKIN_MATRIX_TEXTURE_WIDTH - 1) / SKIN_MATRIX_TEXTURE_WIDTH;
+    if (!numRows)
+        return true;
+
+    unsigned height = skinMatrixTexture_ ? (unsigned)skinMatrixTexture_->GetHeight() : 0;
+    if (numRows > height)
+    {
+        if (numRows > SKIN_MATRIX_TEXTURE_MAX_HEIGHT)
+        {
+            URHO3D_LOGERROR("Too many instanced skin matrices for the skin matrix texture");
+            return false;
+        }
+
+        height = Max(height, 16u);
+        while (height < numRows)
+            height <<= 1;
+
+        // Not a dynamic texture, as a dynamic texture update may discard the rest of the texture when the data is uploaded in parts
+        if (!skinMatrixTexture_)
+        {
+            skinMatrixTexture_ = new Texture2D(context_);
+            skinMatrixTexture_->SetNumLevels(1);
+            skinMatrixTexture_->SetFilterMode(FILTER_NEAREST);
+        }
+        if (!skinMatrixTexture_->SetSize(SKIN_MATRIX_TEXTURE_WIDTH, height, Graphics::GetRGBAFloat32Format()))
+        {
+            URHO3D_LOGERROR("Failed to resize skin matrix texture to " + String(height) + " rows");
+            skinMatrixTexture_.Reset();
+            return false;
+        }
+
+        URHO3D_LOGDEBUG("Resized skin matrix texture to " + String(height) + " rows");
+    }
+
+    // Each matrix row is one texel, so a matrix may continue on the next texture row. Upload the full rows first
+    const auto* data = reinterpret_cast<const float*>(skinMatrices.Buffer());
+    const unsigned numFullRows = numTexels / SKIN_MATRIX_TEXTURE_WIDTH;
+    const unsigned lastRowTexels = numTexels - numFullRows * SKIN_MATRIX_TEXTURE_WIDTH;
+    if (numFullRows)
+        skinMatrixTexture_->SetData(0, 0, 0, SKIN_MATRIX_TEXTURE_WIDTH, numFullRows, data);
+    if (lastRowTexels)
+        skinMatrixTexture_->SetData(0, 0, numFullRows, lastRowTexels, 1, data + numFullRows * SKIN_MATRIX_TEXTURE_WIDTH * 4);
+
+    return true;
+}
+
 Texture2D* Renderer::GetShadowMap(Light* light, Camera* camera, unsigned viewWidth, unsigned viewHeight)
 {
     LightType type = light->GetLightType();
@@ -1182,6 +1235,8 @@ void Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows,
         // If instancing is not supported, but was requested, choose static geometry vertex shader instead
         if (batch.geometryType_ == GEOM_INSTANCED && !GetDynamicInstancing())
             batch.geometryType_ = GEOM_STATIC;
+        else if (batch.geometryType_ == GEOM_SKINNED_INSTANCED && !GetDynamicInstancing())
+            batch.geometryType_ = GEOM_SKINNED;
 
         if (batch.geometryType_ == GEOM_STATIC_NOINSTANCING)
             batch.geometryType_ = GEOM_STATIC;
@@ -1810,6 +1865,38 @@ void Renderer::CreateGeometries()
     pointLightGeometry_->SetIndexBuffer(plib);
     pointLightGeometry_->SetDrawRange(TRIANGLE_LIST, 0, plib->GetIndexCount());
 
+    // Instanced billboards are expanded from a quad with the corner UV in the first and the size direction in the second texcoord
+    if (graphics_->GetInstancingSupport())
+    {
+        static const float billboardCorners[] =
+        {
+            0.0f, 0.0f, -1.0f, 1.0f,
+            1.0f, 0.0f, 1.0f, 1.0f,
+            1.0f, 1.0f, 1.0f, -1.0f,
+            0.0f, 1.0f, -1.0f, -1.0f
+        };
+
+        float billboardVertexData[4 * 8];
+        float* dest = billboardVertexData;
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            dest[0] = dest[1] = dest[2] = 0.0f;
+            ((unsigned&)dest[3]) = Color::WHITE.ToUInt();
+            memcpy(dest + 4, billboardCorners + i * 4, 4 * sizeof(float));
+            dest += 8;
+        }
+
+        SharedPtr<VertexBuffer> bbvb(new VertexBuffer(context_));
+        bbvb->SetShadowed(true);
+        bbvb->SetSize(4, MASK_POSITION | MASK_COLOR | MASK_TEXCOORD1 | MASK_TEXCOORD2);
+        bbvb->SetData(billboardVertexData);
+
+        billboardGeometry_ = new Geometry(context_);
+        billboardGeometry_->SetVertexBuffer(0, bbvb);
+        billboardGeometry_->SetIndexBuffer(dlib);
+        billboardGeometry_->SetDrawRange(TRIANGLE_LIST, 0, dlib->GetIndexCount());
+    }
+
 #if !defined(URHO3D_OPENGL) || !defined(GL_ES_VERSION_2_0)
     if (graphics_->GetShadowMapFormat())
     {
@@ -58,6 +58,9 @@ struct BatchQueue;
 
 static const int SHADOW_MIN_PIXELS = 64;
 static const int INSTANCING_BUFFER_DEFAULT_SIZE = 1024;
+static const int SKIN_MATRIX_TEXTURE_WIDTH = 1024;
+static const int SKIN_MATRIX_TEXTURE_MAX_HEIGHT = 4096;
+static const unsigned MAX_INSTANCED_SKIN_MATRICES = SKIN_MATRIX_TEXTURE_WIDTH * SKIN_MATRIX_TEXTURE_MAX_HEIGHT / 3;
 
 /// Light vertex shader variations.
 enum LightVSVariation
@@ -242,6 +245,12 @@ public:
     /// Set maximum number of shadow maps created for one resolution. Only has effect if reuse of shadow maps is disabled.
     /// @property
     void SetMaxShadowMaps(int shadowMaps);
+    /// Set whether views cache the shadow casters of each light over frames, and cull them again only when the light, the camera or geometry within the light's reach changes. Default false.
+    /// @property
+    void SetShadowCasterCaching(bool enable) { shadowCasterCaching_ = enable; }
+    /// Set whether directional light cascades beyond the first reuse their cached shadow casters while the camera moves, so that only one of them is culled again per frame. Only has effect if shadow caster caching is enabled. Default false.
+    /// @property
+    void SetRoundRobinCascades(bool enable) { roundRobinCascades_ = enable; }
     /// Set dynamic instancing on/off. When on (default), drawables using the same static-type geometry and material will be automatically combined to an instanced draw call.
     /// @property
     void SetDynamicInstancing(bool enable);
@@ -266,6 +275,9 @@ public:
     /// Set whether to thread occluder rendering. Default false.
     /// @property
     void SetThreadedOcclusion(bool enable);
+    /// Set whether to cull geometries and lights against the previous frame's octree snapshot in worker threads while the scene updates. Trades one frame of visibility latency for overlap. Default false.
+    /// @property
+    void SetPipelinedRendering(bool enable) { pipelinedRendering_ = enable; }
     /// Set shadow depth bias multiplier for mobile platforms to counteract possible worse shadow map precision. Default 1.0 (no effect).
     /// @property
     void SetMobileShadowBiasMul(float mul);
@@ -353,6 +365,14 @@ public:
     /// @property
     int GetMaxShadowMaps() const { return maxShadowMaps_; }
 
+    /// Return whether shadow casters are cached over frames.
+    /// @property
+    bool GetShadowCasterCaching() const { return shadowCasterCaching_; }
+
+    /// Return whether directional light cascades are culled in turn while the camera moves.
+    /// @property
+    bool GetRoundRobinCascades() const { return roundRobinCascades_; }
+
     /// Return whether dynamic instancing is in use.
     /// @property
     bool GetDynamicInstancing() const { return dynamicInstancing_; }
@@ -385,6 +405,10 @@ public:
     /// @property
     bool GetThreadedOcclusion() const { return threadedOcclusion_; }
 
+    /// Return whether culling is pipelined over frames.
+    /// @property
+    bool GetPipelinedRendering() const { return pipelinedRendering_; }
+
     /// Return shadow depth bias multiplier for mobile platforms.
     /// @property
     float GetMobileShadowBiasMul() const { return mobileShadowBiasMul_; }
@@ -447,9 +471,18 @@ public:
     /// Return the instancing vertex buffer.
     VertexBuffer* GetInstancingBuffer() const { return dynamicInstancing_ ? instancingBuffer_.Get() : nullptr; }
 
+    /// Return the skin matrix texture of instanced skinned models, or null if not created yet.
+    Texture2D* GetSkinMatrixTexture() const { return skinMatrixTexture_; }
+
+    /// Return the quad geometry drawn for each billboard of instanced billboard sets, or null if instancing is not supported.
+    Geometry* GetBillboardGeometry() const { return billboardGeometry_; }
+
     /// Return the frame update parameters.
     const FrameInfo& GetFrameInfo() const { return frame_; }
 
+    /// Return the frame number when shaders were last changed, which releases the shaders of all passes.
+    unsigned GetShadersChangedFrameNumber() const { return shadersChangedFrameNumber_; }
+
     /// Update for rendering. Called by HandleRenderUpdate().
     void Update(float timeStep);
     /// Render. Called by Engine.
@@ -465,6 +498,8 @@ public:
     Geometry* GetLightGeometry(Light* light);
     /// Return quad geometry used in postprocessing.
     Geometry* GetQuadGeometry();
+    /// Upload the skin matrices of instanced skinned models to the skin matrix texture. Return true on success.
+    bool UpdateSkinMatrixTexture(const PODVector<Matrix3x4>& skinMatrices);
     /// Allocate a shadow map. If shadow map reuse is disabled, a different map is returned each time.
     Texture2D* GetShadowMap(Light* light, Camera* camera, unsigned viewWidth, unsigned viewHeight);
     /// Allocate a rendertarget or depth-stencil texture for deferred rendering or postprocessing. Should only be called during actual rendering, not before.
@@ -555,6 +590,10 @@ private:
     SharedPtr<Geometry> pointLightGeometry_;
     /// Instance stream vertex buffer.
     SharedPtr<VertexBuffer> instancingBuffer_;
+    /// Skin matrices of instanced skinned models, three texels per matrix.
+    SharedPtr<Texture2D> skinMatrixTexture_;
+    /// Instanced billboard quad geometry.
+    SharedPtr<Geometry> billboardGeometry_;
     /// Default material.
     SharedPtr<Material> defaultMaterial_;
     /// Default range attenuation texture.
@@ -659,12 +698,18 @@ private:
     bool drawShadows_{true};
     /// Shadow map reuse flag.
     bool reuseShadowMaps_{true};
+    /// Shadow caster caching flag.
+    bool shadowCasterCaching_{};
+    /// Round-robin cascade culling flag.
+    bool roundRobinCascades_{};
     /// Dynamic instancing flag.
     bool dynamicInstancing_{true};
     /// Number of extra instancing data elements.
     int numExtraInstancingBufferElements_{};
     /// Threaded occlusion rendering flag.
     bool threadedOcclusion_{};
+    /// Pipelined culling flag.
+    bool pipelinedRendering_{};
     /// Shaders need reloading flag.
     bool shadersDirty_{true};
     /// Initialized flag.
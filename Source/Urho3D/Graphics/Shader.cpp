@@ -64,7 +64,8 @@ void CommentOutFunction(String& code, const String& signature)
 Shader::Shader(Context* context) :
     Resource(context),
     timeStamp_(0),
-    numVariations_(0)
+    numVariations_(0),
+    clusteredLights_(false)
 {
     RefreshMemoryUse();
 }
@@ -89,6 +90,7 @@ bool Shader::BeginLoad(Deserializer& source)
 
     // Load the shader source code and resolve any includes
     timeStamp_ = 0;
+    clusteredLights_ = false;
     String shaderCode;
     if (!ProcessSource(shaderCode, source))
         return false;
@@ -188,6 +190,10 @@ bool Shader::ProcessSource(String& code, Deserializer& source)
             if (!includeFile)
                 return false;
 
+            // Shaders opt in to shading the light clusters by including the clustered lighting functions
+            if (GetFileName(includeFileName) == "ClusteredLighting")
+                clusteredLights_ = true;
+
             // Add the include file into the current code recursively
             if (!ProcessSource(code, *includeFile))
                 return false;
@@ -60,6 +60,9 @@ public:
     /// Return the latest timestamp of the shader code and its includes.
     unsigned GetTimeStamp() const { return timeStamp_; }
 
+    /// Return whether the shader shades the clustered lights in its scene passes, which it does by including ClusteredLighting.
+    bool GetClusteredLights() const { return clusteredLights_; }
+
 private:
     /// Process source code and include files. Return true if successful.
     bool ProcessSource(String& code, Deserializer& source);
@@ -80,6 +83,8 @@ private:
     unsigned timeStamp_;
     /// Number of unique variations so far.
     unsigned numVariations_;
+    /// Clustered lights shading flag.
+    bool clusteredLights_;
 };
 
 }
@@ -83,6 +83,18 @@ struct Bone
     WeakPtr<Node> node_;
 };
 
+/// Local transform of a bone in a pose buffer.
+/// @nocount
+struct BonePose
+{
+    /// Position relative to the parent bone.
+    Vector3 position_;
+    /// Rotation relative to the parent bone.
+    Quaternion rotation_;
+    /// Scale relative to the parent bone.
+    Vector3 scale_;
+};
+
 /// Hierarchical collection of bones.
 /// @nocount
 class URHO3D_API Skeleton
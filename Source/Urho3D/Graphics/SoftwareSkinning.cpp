@@ -0,0 +1,136 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Graphics/SoftwareSkinning.h"
+
+#if defined(URHO3D_SSE) || defined(__SSE2__) || defined(_M_X64)
+#define URHO3D_SKINNING_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <cstring>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+#ifdef URHO3D_SKINNING_SSE2
+/// Load three floats into the low lanes, without reading past them.
+static inline __m128 LoadVector3(const float* src)
+{
+    return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)src), _mm_load_ss(src + 2));
+}
+
+/// Store the three low lanes, without writing past them.
+static inline void StoreVector3(float* dest, __m128 value)
+{
+    _mm_storel_pi((__m64*)dest, value);
+    _mm_store_ss(dest + 2, _mm_movehl_ps(value, value));
+}
+#endif
+
+void SkinPositions(const unsigned char* positionData, unsigned positionStride, const unsigned char* blendWeightData,
+    const unsigned char* blendIndexData, unsigned skinningStride, const Matrix3x4* skinMatrices, unsigned numSkinMatrices,
+    unsigned count, Vector3* dest)
+{
+    for (unsigned i = 0; i < count; ++i)
+    {
+        const auto* position = (const float*)(positionData + i * positionStride);
+        const auto* weights = (const float*)(blendWeightData + i * skinningStride);
+        const unsigned char* indices = blendIndexData + i * skinningStride;
+
+#ifdef URHO3D_SKINNING_SSE2
+        // Blend the rows of the influencing matrices, then transform the position as (x, y, z, 1) with a transpose
+        __m128 row0 = _mm_setzero_ps();
+        __m128 row1 = _mm_setzero_ps();
+        __m128 row2 = _mm_setzero_ps();
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            const float weight = weights[j];
+            if (weight == 0.0f || indices[j] >= numSkinMatrices)
+                continue;
+
+            const float* matrix = skinMatrices[indices[j]].Data();
+            const __m128 w = _mm_set1_ps(weight);
+            row0 = _mm_add_ps(row0, _mm_mul_ps(w, _mm_loadu_ps(matrix)));
+            row1 = _mm_add_ps(row1, _mm_mul_ps(w, _mm_loadu_ps(matrix + 4)));
+            row2 = _mm_add_ps(row2, _mm_mul_ps(w, _mm_loadu_ps(matrix + 8)));
+        }
+
+        __m128 row3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+        const __m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(position[0]), row0),
+            _mm_mul_ps(_mm_set1_ps(position[1]), row1)), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(position[2]), row2), row3));
+        StoreVector3(&dest[i].x_, result);
+#else
+        float blended[12] = {};
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            const float weight = weights[j];
+            if (weight == 0.0f || indices[j] >= numSkinMatrices)
+                continue;
+
+            const float* matrix = skinMatrices[indices[j]].Data();
+            for (unsigned k = 0; k < 12; ++k)
+                blended[k] += weight * matrix[k];
+        }
+
+        dest[i] = Matrix3x4(blended) * Vector3(position);
+#endif
+    }
+}
+
+void ApplyVertexMorph(unsigned char* vertexData, unsigned vertexSize, unsigned vertexStart, const unsigned char* morphData,
+    unsigned morphVertexCount, const unsigned* elementOffsets, unsigned numElements, float weight)
+{
+#ifdef URHO3D_SKINNING_SSE2
+    const __m128 w = _mm_set1_ps(weight);
+#endif
+
+    while (morphVertexCount--)
+    {
+        unsigned vertexIndex;
+        memcpy(&vertexIndex, morphData, sizeof(unsigned));
+        morphData += sizeof(unsigned);
+        unsigned char* vertex = vertexData + (vertexIndex - vertexStart) * vertexSize;
+
+        for (unsigned i = 0; i < numElements; ++i)
+        {
+            auto* dest = (float*)(vertex + elementOffsets[i]);
+            const auto* src = (const float*)morphData;
+#ifdef URHO3D_SKINNING_SSE2
+            StoreVector3(dest, _mm_add_ps(LoadVector3(dest), _mm_mul_ps(LoadVector3(src), w)));
+#else
+            dest[0] += src[0] * weight;
+            dest[1] += src[1] * weight;
+            dest[2] += src[2] * weight;
+#endif
+            morphData += 3 * sizeof(float);
+        }
+    }
+}
+
+}
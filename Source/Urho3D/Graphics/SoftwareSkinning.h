@@ -0,0 +1,40 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Math/Matrix3x4.h"
+
+namespace Urho3D
+{
+
+/// Skin vertex positions on the CPU with up to four bone influences per vertex, blending the skin matrices before transforming. Blend weights are four floats and blend indices four bytes per vertex, sharing the skinning stride. Influences with zero weight or an out of range index are skipped. Thread-safe.
+URHO3D_API void SkinPositions(const unsigned char* positionData, unsigned positionStride, const unsigned char* blendWeightData,
+    const unsigned char* blendIndexData, unsigned skinningStride, const Matrix3x4* skinMatrices, unsigned numSkinMatrices,
+    unsigned count, Vector3* dest);
+
+/// Add a weighted vertex morph to vertex data. The morph data is packed as in VertexBufferMorph: a vertex index followed by three floats for each of the elements. Element offsets give the destination of each element within the vertex. Thread-safe.
+URHO3D_API void ApplyVertexMorph(unsigned char* vertexData, unsigned vertexSize, unsigned vertexStart, const unsigned char* morphData,
+    unsigned morphVertexCount, const unsigned* elementOffsets, unsigned numElements, float weight);
+
+}
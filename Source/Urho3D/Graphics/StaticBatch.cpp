@@ -0,0 +1,157 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Graphics/Batch.h"
+#include "../Graphics/Geometry.h"
+#include "../Graphics/Material.h"
+#include "../Graphics/OcclusionBuffer.h"
+#include "../Graphics/OctreeQuery.h"
+#include "../Graphics/StaticBatch.h"
+#include "../Graphics/StaticModel.h"
+#include "../Graphics/VertexBuffer.h"
+#include "../Scene/Node.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* GEOMETRY_CATEGORY;
+
+StaticBatch::StaticBatch(Context* context) :
+    Drawable(context, DRAWABLE_GEOMETRY)
+{
+    batches_.Resize(1);
+}
+
+StaticBatch::~StaticBatch() = default;
+
+void StaticBatch::RegisterObject(Context* context)
+{
+    context->RegisterFactory<StaticBatch>(GEOMETRY_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, bool, true, AM_DEFAULT);
+}
+
+void StaticBatch::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQueryResult>& results)
+{
+    // The merged geometry has no per-source identity, so test the original models instead. They are out of the octree,
+    // but keep their transforms and geometry. A model split to several batches is only reported once
+    for (unsigned i = 0; i < sources_.Size(); ++i)
+    {
+        StaticModel* source = sources_[i];
+        if (!source || !source->IsEnabledEffective())
+            continue;
+
+        bool reported = false;
+        for (unsigned j = 0; j < results.Size(); ++j)
+        {
+            if (results[j].drawable_ == source)
+            {
+                reported = true;
+                break;
+            }
+        }
+
+        if (!reported && query.ray_.HitDistance(source->GetWorldBoundingBox()) < query.maxDistance_)
+            source->ProcessRayQuery(query, results);
+    }
+}
+
+unsigned StaticBatch::GetNumOccluderTriangles()
+{
+    // Check that the material is suitable for occlusion (default material always is)
+    Material* material = batches_[0].material_;
+    if (!geometry_ || (material && !material->GetOcclusion()))
+        return 0;
+
+    return geometry_->GetIndexCount() / 3;
+}
+
+bool StaticBatch::DrawOcclusion(OcclusionBuffer* buffer)
+{
+    if (!geometry_)
+        return true;
+
+    // Check that the material is suitable for occlusion (default material always is) and set culling mode
+    Material* material = batches_[0].material_;
+    if (material)
+    {
+        if (!material->GetOcclusion())
+            return true;
+        buffer->SetCullMode(material->GetCullMode());
+    }
+    else
+        buffer->SetCullMode(CULL_CCW);
+
+    const unsigned char* vertexData;
+    unsigned vertexSize;
+    const unsigned char* indexData;
+    unsigned indexSize;
+    const PODVector<VertexElement>* elements;
+
+    geometry_->GetRawData(vertexData, vertexSize, indexData, indexSize, elements);
+    // Check for valid geometry data
+    if (!vertexData || !indexData || !elements || VertexBuffer::GetElementOffset(*elements, TYPE_VECTOR3, SEM_POSITION) != 0)
+        return true;
+
+    return buffer->AddTriangles(node_->GetWorldTransform(), vertexData, vertexSize, indexData, indexSize,
+        geometry_->GetIndexStart(), geometry_->GetIndexCount());
+}
+
+void StaticBatch::SetGeometry(Geometry* geometry, Material* material, const BoundingBox& box)
+{
+    geometry_ = geometry;
+    batches_[0].geometry_ = geometry;
+    batches_[0].geometryType_ = GEOM_STATIC;
+    batches_[0].material_ = material;
+    if (node_)
+        batches_[0].worldTransform_ = &node_->GetWorldTransform();
+
+    boundingBox_ = box;
+    OnMarkedDirty(node_);
+}
+
+void StaticBatch::AddSource(StaticModel* source)
+{
+    sources_.Push(WeakPtr<StaticModel>(source));
+}
+
+Material* StaticBatch::GetMaterial() const
+{
+    return batches_[0].material_;
+}
+
+StaticModel* StaticBatch::GetSource(unsigned index) const
+{
+    return index < sources_.Size() ? sources_[index] : nullptr;
+}
+
+void StaticBatch::OnWorldBoundingBoxUpdate()
+{
+    worldBoundingBox_ = boundingBox_.Transformed(node_->GetWorldTransform());
+}
+
+}
@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Graphics/Drawable.h"
+
+namespace Urho3D
+{
+
+class StaticModel;
+
+/// One merged chunk of static model geometry sharing a material, created by StaticBatcher. Raycasts are forwarded to the original static models.
+class URHO3D_API StaticBatch : public Drawable
+{
+    URHO3D_OBJECT(StaticBatch, Drawable);
+
+public:
+    /// Construct.
+    explicit StaticBatch(Context* context);
+    /// Destruct.
+    ~StaticBatch() override;
+    /// Register object factory. Drawable must be registered first.
+    /// @nobind
+    static void RegisterObject(Context* context);
+
+    /// Process octree raycast. May be called from a worker thread.
+    void ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQueryResult>& results) override;
+    /// Return number of occlusion geometry triangles.
+    unsigned GetNumOccluderTriangles() override;
+    /// Draw to occlusion buffer. Return true if did not run out of triangles.
+    bool DrawOcclusion(OcclusionBuffer* buffer) override;
+
+    /// Set merged geometry, its material and local-space bounding box.
+    void SetGeometry(Geometry* geometry, Material* material, const BoundingBox& box);
+    /// Add a static model whose geometry has been merged into this batch.
+    void AddSource(StaticModel* source);
+
+    /// Return merged geometry.
+    Geometry* GetGeometry() const { return geometry_; }
+
+    /// Return material.
+    Material* GetMaterial() const;
+
+    /// Return number of source static models.
+    unsigned GetNumSources() const { return sources_.Size(); }
+
+    /// Return source static model by index.
+    StaticModel* GetSource(unsigned index) const;
+
+protected:
+    /// Recalculate the world-space bounding box.
+    void OnWorldBoundingBoxUpdate() override;
+
+private:
+    /// Merged geometry.
+    SharedPtr<Geometry> geometry_;
+    /// Static models whose geometry has been merged.
+    Vector<WeakPtr<StaticModel> > sources_;
+};
+
+}
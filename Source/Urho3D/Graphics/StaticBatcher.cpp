@@ -0,0 +1,439 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Graphics/Geometry.h"
+#include "../Graphics/IndexBuffer.h"
+#include "../Graphics/Material.h"
+#include "../Graphics/StaticBatch.h"
+#include "../Graphics/StaticBatcher.h"
+#include "../Graphics/StaticModel.h"
+#include "../Graphics/VertexBuffer.h"
+#include "../IO/Log.h"
+#include "../Math/Vector4.h"
+#include "../Scene/Node.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* GEOMETRY_CATEGORY;
+
+static const float DEFAULT_CHUNK_SIZE = 64.0f;
+static const unsigned DEFAULT_MAX_VERTICES = 65535;
+static const unsigned MIN_MAX_VERTICES = 1024;
+
+/// Static model geometry to merge, with its transform into the batcher node's space.
+struct StaticBatchPart
+{
+    /// Source static model.
+    StaticModel* model_;
+    /// Source geometry.
+    Geometry* geometry_;
+    /// Transform from the model's space to the batcher node's space.
+    Matrix3x4 transform_;
+};
+
+/// Identifies parts that can be merged into the same batch.
+struct StaticBatchKey
+{
+    /// Test for equality with another key.
+    bool operator ==(const StaticBatchKey& rhs) const
+    {
+        return material_ == rhs.material_ && elementHash_ == rhs.elementHash_ && cell_ == rhs.cell_ &&
+            viewMask_ == rhs.viewMask_ && lightMask_ == rhs.lightMask_ && shadowMask_ == rhs.shadowMask_ &&
+            zoneMask_ == rhs.zoneMask_ && maxLights_ == rhs.maxLights_ && drawDistance_ == rhs.drawDistance_ &&
+            shadowDistance_ == rhs.shadowDistance_ && flags_ == rhs.flags_;
+    }
+
+    /// Return hash value for the HashMap.
+    unsigned ToHash() const
+    {
+        unsigned hash = (unsigned)(size_t)material_ / sizeof(Material);
+        hash = hash * 31 + (unsigned)elementHash_;
+        hash = hash * 31 + cell_.ToHash();
+        hash = hash * 31 + viewMask_;
+        hash = hash * 31 + lightMask_;
+        hash = hash * 31 + flags_;
+        return hash;
+    }
+
+    /// Material.
+    Material* material_;
+    /// Vertex element hash.
+    unsigned long long elementHash_;
+    /// Chunk cell.
+    IntVector3 cell_;
+    /// View mask.
+    unsigned viewMask_;
+    /// Light mask.
+    unsigned lightMask_;
+    /// Shadow mask.
+    unsigned shadowMask_;
+    /// Zone mask.
+    unsigned zoneMask_;
+    /// Maximum per-pixel lights.
+    unsigned maxLights_;
+    /// Draw distance.
+    float drawDistance_;
+    /// Shadow distance.
+    float shadowDistance_;
+    /// Shadowcaster, occluder and occludee flags.
+    unsigned flags_;
+};
+
+/// Return whether all the first LOD level geometries of a static model can be merged.
+static bool CanBatch(StaticModel* model)
+{
+    if (!model->GetModel() || !model->GetNumGeometries())
+        return false;
+
+    for (unsigned i = 0; i < model->GetNumGeometries(); ++i)
+    {
+        Geometry* geometry = model->GetLodGeometry(i, 0);
+        if (!geometry || geometry->GetPrimitiveType() != TRIANGLE_LIST || geometry->GetNumVertexBuffers() != 1)
+            return false;
+
+        VertexBuffer* vertexBuffer = geometry->GetVertexBuffer(0);
+        if (!vertexBuffer || !vertexBuffer->GetShadowData() ||
+            vertexBuffer->GetElementOffset(TYPE_VECTOR3, SEM_POSITION) != 0)
+            return false;
+
+        IndexBuffer* indexBuffer = geometry->GetIndexBuffer();
+        if (indexBuffer && !indexBuffer->GetShadowData())
+            return false;
+    }
+
+    return true;
+}
+
+/// Copy and transform part vertices to the destination, expanding the bounding box.
+static void CopyVertices(const StaticBatchPart& part, unsigned char* dest, BoundingBox& box)
+{
+    Geometry* geometry = part.geometry_;
+    VertexBuffer* vertexBuffer = geometry->GetVertexBuffer(0);
+    unsigned vertexSize = vertexBuffer->GetVertexSize();
+    unsigned vertexCount = geometry->GetVertexCount();
+    memcpy(dest, vertexBuffer->GetShadowData() + geometry->GetVertexStart() * vertexSize, vertexCount * vertexSize);
+
+    unsigned normalOffset = vertexBuffer->GetElementOffset(TYPE_VECTOR3, SEM_NORMAL);
+    unsigned tangentOffset = vertexBuffer->GetElementOffset(TYPE_VECTOR4, SEM_TANGENT);
+    Matrix3 rotation = part.transform_.ToMatrix3();
+    Matrix3 normalTransform = rotation.Inverse().Transpose();
+
+    for (unsigned i = 0; i < vertexCount; ++i)
+    {
+        unsigned char* vertex = dest + i * vertexSize;
+
+        auto& position = *reinterpret_cast<Vector3*>(vertex);
+        position = part.transform_ * position;
+        box.Merge(position);
+
+        if (normalOffset != M_MAX_UNSIGNED)
+        {
+            auto& normal = *reinterpret_cast<Vector3*>(vertex + normalOffset);
+            normal = (normalTransform * normal).Normalized();
+        }
+        if (tangentOffset != M_MAX_UNSIGNED)
+        {
+            auto& tangent = *reinterpret_cast<Vector4*>(vertex + tangentOffset);
+            Vector3 direction = (rotation * Vector3(tangent.x_, tangent.y_, tangent.z_)).Normalized();
+            tangent = Vector4(direction, tangent.w_);
+        }
+    }
+}
+
+/// Copy part indices to the destination, offset by the base vertex and with winding flipped if the transform mirrors.
+template <class T> static void CopyIndices(const StaticBatchPart& part, unsigned baseVertex, T* dest)
+{
+    Geometry* geometry = part.geometry_;
+    IndexBuffer* indexBuffer = geometry->GetIndexBuffer();
+    unsigned indexCount = indexBuffer ? geometry->GetIndexCount() : geometry->GetVertexCount();
+    const Matrix3 rotation = part.transform_.ToMatrix3();
+    const float determinant = rotation.m00_ * (rotation.m11_ * rotation.m22_ - rotation.m12_ * rotation.m21_) -
+        rotation.m01_ * (rotation.m10_ * rotation.m22_ - rotation.m12_ * rotation.m20_) +
+        rotation.m02_ * (rotation.m10_ * rotation.m21_ - rotation.m11_ * rotation.m20_);
+
+    for (unsigned i = 0; i < indexCount; ++i)
+    {
+        unsigned index;
+        if (!indexBuffer)
+            index = i;
+        else if (indexBuffer->GetIndexSize() == sizeof(unsigned))
+            index = reinterpret_cast<const unsigned*>(indexBuffer->GetShadowData())[geometry->GetIndexStart() + i] -
+                geometry->GetVertexStart();
+        else
+            index = reinterpret_cast<const unsigned short*>(indexBuffer->GetShadowData())[geometry->GetIndexStart() + i] -
+                geometry->GetVertexStart();
+
+        dest[i] = (T)(index + baseVertex);
+    }
+
+    if (determinant < 0.0f)
+    {
+        for (unsigned i = 0; i + 2 < indexCount; i += 3)
+        {
+            T temp = dest[i + 1];
+            dest[i + 1] = dest[i + 2];
+            dest[i + 2] = temp;
+        }
+    }
+}
+
+StaticBatcher::StaticBatcher(Context* context) :
+    Component(context),
+    chunkSize_(DEFAULT_CHUNK_SIZE),
+    maxVertices_(DEFAULT_MAX_VERTICES),
+    batchOnLoad_(true)
+{
+}
+
+StaticBatcher::~StaticBatcher() = default;
+
+void StaticBatcher::RegisterObject(Context* context)
+{
+    context->RegisterFactory<StaticBatcher>(GEOMETRY_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, bool, true, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Batch On Load", bool, batchOnLoad_, true, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Chunk Size", GetChunkSize, SetChunkSize, float, DEFAULT_CHUNK_SIZE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Max Vertices", GetMaxVertices, SetMaxVertices, unsigned, DEFAULT_MAX_VERTICES, AM_DEFAULT);
+}
+
+void StaticBatcher::ApplyAttributes()
+{
+    if (batchOnLoad_ && batches_.Empty() && IsEnabledEffective())
+        Build();
+}
+
+unsigned StaticBatcher::Build()
+{
+    Clear();
+
+    if (!node_)
+    {
+        URHO3D_LOGERROR("Can not build static batches while batcher component is not attached to a scene node");
+        return 0;
+    }
+
+    URHO3D_PROFILE(BuildStaticBatches);
+
+    PODVector<StaticModel*> models;
+    node_->GetComponents<StaticModel>(models, true);
+
+    // Group the geometries by material, vertex format, spatial cell and drawable settings, retaining scene order
+    const Matrix3x4 inverseWorld = node_->GetWorldTransform().Inverse();
+    HashMap<StaticBatchKey, unsigned> groupIndices;
+    Vector<PODVector<StaticBatchPart> > groups;
+
+    for (unsigned i = 0; i < models.Size(); ++i)
+    {
+        StaticModel* model = models[i];
+        if (!model->IsEnabledEffective() || model->IsBatched() || !CanBatch(model))
+            continue;
+
+        StaticBatchKey key;
+        key.viewMask_ = model->GetViewMask();
+        key.lightMask_ = model->GetLightMask();
+        key.shadowMask_ = model->GetShadowMask();
+        key.zoneMask_ = model->GetZoneMask();
+        key.maxLights_ = model->GetMaxLights();
+        key.drawDistance_ = model->GetDrawDistance();
+        key.shadowDistance_ = model->GetShadowDistance();
+        key.flags_ = (model->GetCastShadows() ? 1u : 0u) | (model->IsOccluder() ? 2u : 0u) | (model->IsOccludee() ? 4u : 0u);
+
+        const Vector3 center = inverseWorld * model->GetWorldBoundingBox().Center();
+        key.cell_ = chunkSize_ > 0.0f ? VectorFloorToInt(center / chunkSize_) : IntVector3::ZERO;
+
+        StaticBatchPart part;
+        part.model_ = model;
+        part.transform_ = inverseWorld * model->GetNode()->GetWorldTransform();
+
+        for (unsigned j = 0; j < model->GetNumGeometries(); ++j)
+        {
+            part.geometry_ = model->GetLodGeometry(j, 0);
+            key.material_ = model->GetMaterial(j);
+            key.elementHash_ = part.geometry_->GetVertexBuffer(0)->GetBufferHash(0);
+
+            HashMap<StaticBatchKey, unsigned>::Iterator k = groupIndices.Find(key);
+            if (k == groupIndices.End())
+            {
+                k = groupIndices.Insert(MakePair(key, groups.Size()));
+                groups.Resize(groups.Size() + 1);
+            }
+            groups[k->second_].Push(part);
+        }
+
+        sources_.Push(WeakPtr<StaticModel>(model));
+    }
+
+    // Merge each group into as many batches as the vertex limit requires
+    PODVector<unsigned char> vertexData;
+    PODVector<unsigned char> indexData;
+
+    for (HashMap<StaticBatchKey, unsigned>::ConstIterator i = groupIndices.Begin(); i != groupIndices.End(); ++i)
+    {
+        const PODVector<StaticBatchPart>& parts = groups[i->second_];
+        unsigned first = 0;
+
+        while (first < parts.Size())
+        {
+            // Take at least one part, even if alone it exceeds the limit
+            unsigned last = first;
+            unsigned vertexCount = 0;
+            unsigned indexCount = 0;
+            while (last < parts.Size())
+            {
+                Geometry* geometry = parts[last].geometry_;
+                unsigned partVertices = geometry->GetVertexCount();
+                if (last > first && vertexCount + partVertices > maxVertices_)
+                    break;
+                vertexCount += partVertices;
+                indexCount += geometry->GetIndexBuffer() ? geometry->GetIndexCount() : partVertices;
+                ++last;
+            }
+
+            VertexBuffer* firstVertexBuffer = parts[first].geometry_->GetVertexBuffer(0);
+            const unsigned vertexSize = firstVertexBuffer->GetVertexSize();
+            const bool largeIndices = vertexCount > 65535;
+            vertexData.Resize(vertexCount * vertexSize);
+            indexData.Resize(indexCount * (largeIndices ? sizeof(unsigned) : sizeof(unsigned short)));
+
+            BoundingBox box;
+            unsigned baseVertex = 0;
+            unsigned baseIndex = 0;
+            for (unsigned j = first; j < last; ++j)
+            {
+                const StaticBatchPart& part = parts[j];
+                CopyVertices(part, &vertexData[baseVertex * vertexSize], box);
+                if (largeIndices)
+                    CopyIndices(part, baseVertex, reinterpret_cast<unsigned*>(&indexData[0]) + baseIndex);
+                else
+                    CopyIndices(part, baseVertex, reinterpret_cast<unsigned short*>(&indexData[0]) + baseIndex);
+
+                baseVertex += part.geometry_->GetVertexCount();
+                baseIndex += part.geometry_->GetIndexBuffer() ? part.geometry_->GetIndexCount() :
+                    part.geometry_->GetVertexCount();
+            }
+
+            SharedPtr<VertexBuffer> vertexBuffer(new VertexBuffer(context_));
+            vertexBuffer->SetShadowed(true);
+            vertexBuffer->SetSize(vertexCount, firstVertexBuffer->GetElements());
+            vertexBuffer->SetData(&vertexData[0]);
+
+            SharedPtr<IndexBuffer> indexBuffer(new IndexBuffer(context_));
+            indexBuffer->SetShadowed(true);
+            indexBuffer->SetSize(indexCount, largeIndices);
+            indexBuffer->SetData(&indexData[0]);
+
+            SharedPtr<Geometry> geometry(new Geometry(context_));
+            geometry->SetVertexBuffer(0, vertexBuffer);
+            geometry->SetIndexBuffer(indexBuffer);
+            geometry->SetDrawRange(TRIANGLE_LIST, 0, indexCount);
+
+            // Batches share the batcher's transform, as the vertices are in its space
+            const StaticBatchKey& key = i->first_;
+            Node* batchNode = node_->CreateTemporaryChild("StaticBatch", LOCAL);
+            auto* batch = batchNode->CreateComponent<StaticBatch>();
+            batch->SetGeometry(geometry, key.material_, box);
+            batch->SetViewMask(key.viewMask_);
+            batch->SetLightMask(key.lightMask_);
+            batch->SetShadowMask(key.shadowMask_);
+            batch->SetZoneMask(key.zoneMask_);
+            batch->SetMaxLights(key.maxLights_);
+            batch->SetDrawDistance(key.drawDistance_);
+            batch->SetShadowDistance(key.shadowDistance_);
+            batch->SetCastShadows((key.flags_ & 1u) != 0);
+            batch->SetOccluder((key.flags_ & 2u) != 0);
+            batch->SetOccludee((key.flags_ & 4u) != 0);
+
+            for (unsigned j = first; j < last; ++j)
+            {
+                if (j == first || parts[j].model_ != parts[j - 1].model_)
+                    batch->AddSource(parts[j].model_);
+            }
+
+            batches_.Push(WeakPtr<StaticBatch>(batch));
+            first = last;
+        }
+    }
+
+    // Take the originals out of rendering only now, as their world bounding boxes were needed above
+    for (unsigned i = 0; i < sources_.Size(); ++i)
+        sources_[i]->SetBatched(true);
+
+    URHO3D_LOGDEBUGF("Merged %u static models into %u static batches", sources_.Size(), batches_.Size());
+    return batches_.Size();
+}
+
+void StaticBatcher::Clear()
+{
+    for (unsigned i = 0; i < sources_.Size(); ++i)
+    {
+        if (sources_[i])
+            sources_[i]->SetBatched(false);
+    }
+
+    for (unsigned i = 0; i < batches_.Size(); ++i)
+    {
+        if (batches_[i] && batches_[i]->GetNode())
+            batches_[i]->GetNode()->Remove();
+    }
+
+    sources_.Clear();
+    batches_.Clear();
+}
+
+void StaticBatcher::SetBatchOnLoad(bool enable)
+{
+    batchOnLoad_ = enable;
+    MarkNetworkUpdate();
+}
+
+void StaticBatcher::SetChunkSize(float size)
+{
+    chunkSize_ = Max(size, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void StaticBatcher::SetMaxVertices(unsigned num)
+{
+    maxVertices_ = Max(num, MIN_MAX_VERTICES);
+    MarkNetworkUpdate();
+}
+
+StaticBatch* StaticBatcher::GetBatch(unsigned index) const
+{
+    return index < batches_.Size() ? batches_[index] : nullptr;
+}
+
+void StaticBatcher::OnNodeSet(Node* node)
+{
+    if (!node)
+        Clear();
+}
+
+}
@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Scene/Component.h"
+
+namespace Urho3D
+{
+
+class StaticBatch;
+class StaticModel;
+
+/// Merges the static models of its node subtree into chunked combined geometries per material to reduce draw calls. The original static models are kept out of the octree while batched, but remain for raycasts and physics. Only the first LOD level is merged, and batched models should not move or change afterward.
+class URHO3D_API StaticBatcher : public Component
+{
+    URHO3D_OBJECT(StaticBatcher, Component);
+
+public:
+    /// Construct.
+    explicit StaticBatcher(Context* context);
+    /// Destruct. Restore the original static models.
+    ~StaticBatcher() override;
+    /// Register object factory.
+    /// @nobind
+    static void RegisterObject(Context* context);
+
+    /// Apply attribute changes that can not be applied immediately. Called after scene load or a network update.
+    void ApplyAttributes() override;
+
+    /// Merge the static models of the node subtree. Any previous batches are cleared first. Return number of batches created.
+    unsigned Build();
+    /// Remove the batches and restore the original static models.
+    void Clear();
+
+    /// Set whether to build automatically after scene load.
+    /// @property
+    void SetBatchOnLoad(bool enable);
+    /// Set size of the cubic cells geometry is grouped into, in the node's local space. Zero puts all geometry sharing a material into the same chunk.
+    /// @property
+    void SetChunkSize(float size);
+    /// Set maximum number of vertices in one batch.
+    /// @property
+    void SetMaxVertices(unsigned num);
+
+    /// Return whether builds automatically after scene load.
+    /// @property
+    bool GetBatchOnLoad() const { return batchOnLoad_; }
+
+    /// Return chunk cell size.
+    /// @property
+    float GetChunkSize() const { return chunkSize_; }
+
+    /// Return maximum number of vertices in one batch.
+    /// @property
+    unsigned GetMaxVertices() const { return maxVertices_; }
+
+    /// Return number of batches.
+    /// @property
+    unsigned GetNumBatches() const { return batches_.Size(); }
+
+    /// Return batch by index.
+    StaticBatch* GetBatch(unsigned index) const;
+
+    /// Return number of static models merged into the batches.
+    /// @property
+    unsigned GetNumSources() const { return sources_.Size(); }
+
+protected:
+    /// Handle node being assigned.
+    void OnNodeSet(Node* node) override;
+
+private:
+    /// Batch drawables, each in its own temporary child node.
+    Vector<WeakPtr<StaticBatch> > batches_;
+    /// Static models that have been batched.
+    Vector<WeakPtr<StaticModel> > sources_;
+    /// Chunk cell size.
+    float chunkSize_;
+    /// Maximum vertices per batch.
+    unsigned maxVertices_;
+    /// Build after scene load flag.
+    bool batchOnLoad_;
+};
+
+}
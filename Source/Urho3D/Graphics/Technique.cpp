@@ -32,11 +32,16 @@
 #include "../Resource/ResourceCache.h"
 #include "../Resource/XMLFile.h"
 
+#include <atomic>
+
 #include "../DebugNew.h"
 
 namespace Urho3D
 {
 
+/// Number of pass changes in all techniques.
+static std::atomic<unsigned> passChanges{};
+
 extern const char* cullModeNames[];
 
 const char* blendModeNames[] =
@@ -114,6 +119,7 @@ void Pass::SetDepthTestMode(CompareMode mode)
 void Pass::SetLightingMode(PassLightingMode mode)
 {
     lightingMode_ = mode;
+    ++passChanges;
 }
 
 void Pass::SetDepthWrite(bool enable)
@@ -130,6 +136,7 @@ void Pass::SetAlphaToCoverage(bool enable)
 void Pass::SetIsDesktop(bool enable)
 {
     isDesktop_ = enable;
+    ++passChanges;
 }
 
 void Pass::SetVertexShader(const String& name)
@@ -174,6 +181,7 @@ void Pass::ReleaseShaders()
     pixelShaders_.Clear();
     extraVertexShaders_.Clear();
     extraPixelShaders_.Clear();
+    ++passChanges;
 }
 
 void Pass::MarkShadersLoaded(unsigned frameNumber)
@@ -259,6 +267,7 @@ bool Technique::BeginLoad(Deserializer& source)
 {
     passes_.Clear();
     cloneTechniques_.Clear();
+    ++passChanges;
 
     SetMemoryUse(sizeof(Technique));
 
@@ -361,6 +370,7 @@ bool Technique::BeginLoad(Deserializer& source)
 void Technique::SetIsDesktop(bool enable)
 {
     isDesktop_ = enable;
+    ++passChanges;
 }
 
 void Technique::ReleaseShaders()
@@ -416,6 +426,7 @@ Pass* Technique::CreatePass(const String& name)
     if (passIndex >= passes_.Size())
         passes_.Resize(passIndex + 1);
     passes_[passIndex] = newPass;
+    ++passChanges;
 
     // Calculate memory use now
     SetMemoryUse((unsigned)(sizeof(Technique) + GetNumPasses() * sizeof(Pass)));
@@ -431,6 +442,7 @@ void Technique::RemovePass(const String& name)
     else if (i->second_ < passes_.Size() && passes_[i->second_].Get())
     {
         passes_[i->second_].Reset();
+        ++passChanges;
         SetMemoryUse((unsigned)(sizeof(Technique) + GetNumPasses() * sizeof(Pass)));
     }
 }
@@ -553,4 +565,9 @@ unsigned Technique::GetPassIndex(const String& passName)
     }
 }
 
+unsigned Technique::GetPassChanges()
+{
+    return passChanges.load(std::memory_order_relaxed);
+}
+
 }
@@ -288,6 +288,8 @@ public:
 
     /// Return a pass type index by name. Allocate new if not used yet.
     static unsigned GetPassIndex(const String& passName);
+    /// Return a counter of pass changes in all techniques: passes created, removed or reloaded, or their shaders, lighting mode or desktop requirement changed. Used by views to invalidate batches kept over frames.
+    static unsigned GetPassChanges();
 
     /// Index for base pass. Initialized once GetPassIndex() has been called for the first time.
     static unsigned basePassIndex;
@@ -22,7 +22,9 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/FrameAllocator.h"
 #include "../Core/Profiler.h"
+#include "../Core/TaskGraph.h"
 #include "../Core/WorkQueue.h"
 #include "../Graphics/Camera.h"
 #include "../Graphics/DebugRenderer.h"
@@ -30,11 +32,13 @@
 #include "../Graphics/Graphics.h"
 #include "../Graphics/GraphicsEvents.h"
 #include "../Graphics/GraphicsImpl.h"
+#include "../Graphics/LightClusters.h"
 #include "../Graphics/Material.h"
 #include "../Graphics/OcclusionBuffer.h"
 #include "../Graphics/Octree.h"
 #include "../Graphics/Renderer.h"
 #include "../Graphics/RenderPath.h"
+#include "../Graphics/Shader.h"
 #include "../Graphics/ShaderVariation.h"
 #include "../Graphics/Skybox.h"
 #include "../Graphics/Technique.h"
@@ -55,6 +59,9 @@
 namespace Urho3D
 {
 
+/// Minimum number of drawables per threaded geometry update task, so that small views are not split into tasks of one drawable.
+static const unsigned MIN_GEOMETRIES_PER_TASK = 16;
+
 /// %Frustum octree query for shadowcasters.
 class ShadowCasterOctreeQuery : public FrustumOctreeQuery
 {
@@ -157,11 +164,8 @@ public:
     OcclusionBuffer* buffer_;
 };
 
-void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
+void CheckVisibilityWork(View* view, Drawable** start, Drawable** end, unsigned threadIndex)
 {
-    auto* view = reinterpret_cast<View*>(item->aux_);
-    auto** start = reinterpret_cast<Drawable**>(item->start_);
-    auto** end = reinterpret_cast<Drawable**>(item->end_);
     OcclusionBuffer* buffer = view->occlusionBuffer_;
     const Matrix3x4& viewMatrix = view->cullCamera_->GetView();
     Vector3 viewZ = Vector3(viewMatrix.m20_, viewMatrix.m21_, viewMatrix.m22_);
@@ -170,12 +174,31 @@ void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
     bool cameraZoneOverride = view->cameraZoneOverride_;
     PerThreadSceneResult& result = view->sceneResults_[threadIndex];
 
+    // Test occludees against the occlusion buffer in small batches, which is faster than one at a time
+    BoundingBox boxes[OCCLUSION_TEST_BATCH_SIZE];
+    bool visible[OCCLUSION_TEST_BATCH_SIZE];
+
     while (start != end)
     {
-        Drawable* drawable = *start++;
+        Drawable** batchEnd = start + Min((unsigned)(end - start), OCCLUSION_TEST_BATCH_SIZE);
+        unsigned numBoxes = 0;
+        if (buffer)
+        {
+            for (Drawable** i = start; i != batchEnd; ++i)
+            {
+                if ((*i)->IsOccludee())
+                    boxes[numBoxes++] = (*i)->GetWorldBoundingBox();
+            }
+            buffer->IsVisible(boxes, numBoxes, visible);
+        }
 
-        if (!buffer || !drawable->IsOccludee() || buffer->IsVisible(drawable->GetWorldBoundingBox()))
+        unsigned boxIndex = 0;
+        while (start != batchEnd)
         {
+            Drawable* drawable = *start++;
+            if (buffer && drawable->IsOccludee() && !visible[boxIndex++])
+                continue;
+
             drawable->UpdateBatches(view->frame_);
             // If draw distance non-zero, update and check it
             float maxDistance = drawable->GetDrawDistance();
@@ -234,6 +257,15 @@ void ProcessLightWork(const WorkItem* item, unsigned threadIndex)
     view->ProcessLight(*query, threadIndex);
 }
 
+void ProcessShadowSplitWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* view = reinterpret_cast<View*>(item->aux_);
+    auto* query = reinterpret_cast<LightQueryResult*>(item->start_);
+    auto splitIndex = (unsigned)reinterpret_cast<size_t>(item->end_);
+
+    view->ProcessShadowSplit(*query, splitIndex, threadIndex);
+}
+
 void UpdateDrawableGeometriesWork(const WorkItem* item, unsigned threadIndex)
 {
     const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
@@ -277,6 +309,17 @@ void SortShadowQueueWork(const WorkItem* item, unsigned threadIndex)
         start->shadowSplits_[i].shadowBatches_.SortFrontToBack();
 }
 
+/// Return whether two frusta have the same vertices, and therefore the same planes.
+bool SameFrustum(const Frustum& lhs, const Frustum& rhs)
+{
+    for (unsigned i = 0; i < NUM_FRUSTUM_VERTICES; ++i)
+    {
+        if (lhs.vertices_[i] != rhs.vertices_[i])
+            return false;
+    }
+    return true;
+}
+
 StringHash ParseTextureTypeXml(ResourceCache* cache, const String& filename);
 
 View::View(Context* context) :
@@ -288,8 +331,11 @@ View::View(Context* context) :
     unsigned numThreads = GetSubsystem<WorkQueue>()->GetNumThreads() + 1; // Worker threads + main thread
     tempDrawables_.Resize(numThreads);
     sceneResults_.Resize(numThreads);
+    taskGraph_ = new TaskGraph(GetSubsystem<WorkQueue>());
 }
 
+View::~View() = default;
+
 bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
 {
     sourceView_ = nullptr;
@@ -344,6 +390,7 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
             useLitBase_ = sourceView_->useLitBase_;
             hasScenePasses_ = sourceView_->hasScenePasses_;
             noStencil_ = sourceView_->noStencil_;
+            clusteredLights_ = sourceView_->clusteredLights_;
             lightVolumeCommand_ = sourceView_->lightVolumeCommand_;
             forwardLightsCommand_ = sourceView_->forwardLightsCommand_;
             octree_ = sourceView_->octree_;
@@ -369,6 +416,8 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
     useLitBase_ = false;
     hasScenePasses_ = false;
     noStencil_ = false;
+    clusteredLights_ = false;
+    clusteredPassIndices_.Clear();
     lightVolumeCommand_ = nullptr;
     forwardLightsCommand_ = nullptr;
 
@@ -413,6 +462,14 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
             info.allowInstancing_ = command.sortMode_ != SORT_BACKTOFRONT;
             info.markToStencil_ = !noStencil_ && command.markToStencil_;
             info.vertexLights_ = command.vertexLights_;
+            // The light cluster texture is bound to a light unit, which only exists separately on desktop graphics
+#if defined(DESKTOP_GRAPHICS) && !defined(GL_ES_VERSION_2_0)
+            if (command.clusteredLights_)
+            {
+                clusteredLights_ = true;
+                clusteredPassIndices_.Push(command.passIndex_);
+            }
+#endif
 
             // Check scenepass metadata for defining custom passes which interact with lighting
             if (!command.metadata_.Empty())
@@ -492,6 +549,10 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
         }
     }
 
+    // Lit base batches would replace the base pass batches which shade the clustered lights
+    if (clusteredLights_)
+        useLitBase_ = false;
+
     drawShadows_ = renderer_->GetDrawShadows();
     materialQuality_ = renderer_->GetMaterialQuality();
     maxOccluderTriangles_ = renderer_->GetMaxOccluderTriangles();
@@ -515,6 +576,11 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
     return true;
 }
 
+FrameArena* View::GetFrameArena(unsigned threadIndex) const
+{
+    return frame_.allocator_ ? frame_.allocator_->GetArena(threadIndex) : nullptr;
+}
+
 void View::Update(const FrameInfo& frame)
 {
     // No need to update if using another prepared view
@@ -525,6 +591,7 @@ void View::Update(const FrameInfo& frame)
     frame_.timeStep_ = frame.timeStep_;
     frame_.frameNumber_ = frame.frameNumber_;
     frame_.viewSize_ = viewSize_;
+    frame_.allocator_ = frame.allocator_;
 
     using namespace BeginViewUpdate;
 
@@ -540,8 +607,10 @@ void View::Update(const FrameInfo& frame)
     occluders_.Clear();
     activeOccluders_ = 0;
     vertexLightQueues_.Clear();
+    numInstancedSkinMatrices_ = 0;
+    // Scene pass queues keep their instancing groups, as these mostly stay the same from frame to frame
     for (HashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
-        i->second_.Clear(maxSortedInstances);
+        i->second_.ClearInstances(maxSortedInstances);
 
     if (hasScenePasses_ && (!cullCamera_ || !octree_))
     {
@@ -686,6 +755,13 @@ View* View::GetSourceView() const
     return sourceView_;
 }
 
+LightClusters* View::GetLightClusters() const
+{
+    if (!clusteredLights_)
+        return nullptr;
+    return sourceView_ ? sourceView_->lightClusters_.Get() : lightClusters_.Get();
+}
+
 void View::SetGlobalShaderParameters()
 {
     graphics_->SetShaderParameter(VSP_DELTATIME, frame_.timeStep_);
@@ -755,6 +831,10 @@ void View::SetCameraShaderParameters(Camera* camera)
 
     graphics_->SetShaderParameter(VSP_VIEWPROJ, projection * camera->GetView());
 
+    LightClusters* lightClusters = GetLightClusters();
+    if (lightClusters)
+        graphics_->SetShaderParameter(PSP_CLUSTERPARAMS, lightClusters->GetShaderParameter(camera->GetFlipVertical()));
+
     // If in a scene pass and the command defines shader parameters, set them now
     if (passCommand_)
         SetCommandShaderParameters(*passCommand_);
@@ -869,17 +949,58 @@ void View::GetDrawables()
     else
         occluders_.Clear();
 
-    // Get lights and geometries. Coarse occlusion for octants is used at this point
-    if (occlusionBuffer_)
+    // Get lights and geometries. When pipelined, use the snapshot query started during the previous frame if the camera has not
+    // moved, rotated or changed its projection since, as objects entering the view would be missed otherwise. The query tests
+    // drawables which moved or entered the octree after the snapshot again with their current bounds
+    const bool pipelined = renderer_->GetPipelinedRendering();
+    const Frustum& cullFrustum = cullCamera_->GetFrustum();
+    const bool sameView = pipelinedCamera_ == cullCamera_ && pipelinedViewMask_ == cullCamera_->GetViewMask() &&
+        SameFrustum(pipelinedFrustum_, cullFrustum);
+    bool pipelinedResult = false;
+    if (pipelinedQuery_ && pipelinedQuery_->IsStarted())
     {
-        OccludedFrustumOctreeQuery query
-            (tempDrawables, cullCamera_->GetFrustum(), occlusionBuffer_, DRAWABLE_GEOMETRY | DRAWABLE_LIGHT, cullCamera_->GetViewMask());
-        octree_->GetDrawables(query);
+        tempDrawables.Clear();
+        pipelinedResult = pipelinedQuery_->Finish(octree_, tempDrawables) && pipelined && sameView;
     }
-    else
+
+    // Otherwise query the live octree. Coarse occlusion for octants is used at this point
+    if (!pipelinedResult)
     {
-        FrustumOctreeQuery query(tempDrawables, cullCamera_->GetFrustum(), DRAWABLE_GEOMETRY | DRAWABLE_LIGHT, cullCamera_->GetViewMask());
-        octree_->GetDrawables(query);
+        if (occlusionBuffer_)
+        {
+            OccludedFrustumOctreeQuery query
+                (tempDrawables, cullFrustum, occlusionBuffer_, DRAWABLE_GEOMETRY | DRAWABLE_LIGHT, cullCamera_->GetViewMask());
+            octree_->GetDrawables(query);
+        }
+        else
+        {
+            FrustumOctreeQuery query(tempDrawables, cullFrustum, DRAWABLE_GEOMETRY | DRAWABLE_LIGHT, cullCamera_->GetViewMask());
+            octree_->GetDrawables(query);
+        }
+    }
+
+    if (pipelined)
+    {
+        if (!pipelinedQuery_)
+            pipelinedQuery_ = new SnapshotFrustumQuery(queue);
+
+        // Start culling the latest snapshot for the next frame only while the camera stands still, as the result is thrown away
+        // if it moves. It runs in worker threads during the rest of this frame and the next scene update. The snapshots stay
+        // enabled meanwhile, as other views may share the octree and enabling them again walks the whole octree
+        octree_->SetSnapshotEnabled(true);
+        if (sameView)
+            pipelinedQuery_->Start(octree_, cullFrustum, DRAWABLE_GEOMETRY | DRAWABLE_LIGHT, cullCamera_->GetViewMask());
+
+        pipelinedCamera_ = cullCamera_;
+        pipelinedFrustum_ = cullFrustum;
+        pipelinedViewMask_ = cullCamera_->GetViewMask();
+    }
+    else if (pipelinedQuery_)
+    {
+        // Pipelining was turned off: stop the octree taking snapshots which nobody culls anymore
+        pipelinedQuery_.Reset();
+        pipelinedCamera_.Reset();
+        octree_->SetSnapshotEnabled(false);
     }
 
     // Check drawable occlusion, find zones for moved drawables and collect geometries & lights in worker threads
@@ -894,30 +1015,11 @@ void View::GetDrawables()
             result.maxZ_ = 0.0f;
         }
 
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = tempDrawables.Size() / numWorkItems;
-
-        PODVector<Drawable*>::Iterator start = tempDrawables.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
+        Drawable** drawables = tempDrawables.Buffer();
+        queue->ParallelFor(tempDrawables.Size(), 0, [this, drawables](unsigned begin, unsigned end, unsigned threadIndex)
         {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = CheckVisibilityWork;
-            item->aux_ = this;
-
-            PODVector<Drawable*>::Iterator end = tempDrawables.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
+            CheckVisibilityWork(this, drawables + begin, drawables + end, threadIndex);
+        });
     }
 
     // Combine lights, geometries & scene Z range from the threads
@@ -970,6 +1072,7 @@ void View::GetBatches()
     threadedGeometries_.Clear();
 
     ProcessLights();
+    BuildLightClusters();
     GetLightBatches();
     GetBaseBatches();
 }
@@ -979,25 +1082,66 @@ void View::ProcessLights()
     // Process lit geometries and shadow casters for each light
     URHO3D_PROFILE(ProcessLights);
 
-    auto* queue = GetSubsystem<WorkQueue>();
     lightQueryResults_.Resize(lights_.Size());
+    UpdateShadowCasterCaches();
+    taskGraph_->Clear();
+    clusteredLightList_.Clear();
+    GetUnclusteredGeometries();
 
     for (unsigned i = 0; i < lightQueryResults_.Size(); ++i)
     {
-        SharedPtr<WorkItem> item = queue->GetFreeItem();
-        item->priority_ = M_MAX_UNSIGNED;
-        item->workFunction_ = ProcessLightWork;
-        item->aux_ = this;
-
         LightQueryResult& query = lightQueryResults_[i];
-        query.light_ = lights_[i];
+        Light* light = lights_[i];
+        query.light_ = light;
+        query.clustered_ = false;
+
+        // Clustered lights are shaded in the scene passes, so they need lit geometries and light queues only for the
+        // materials whose shaders do not read the light clusters
+        if (clusteredLights_ && clusteredLightList_.Size() < MAX_CLUSTERED_LIGHTS && IsClusteredLight(light))
+        {
+            clusteredLightList_.Push(light);
+            query.clustered_ = true;
+            query.numSplits_ = 0;
+            if (unclusteredGeometries_.Empty())
+                query.litGeometries_.Reset(nullptr);
+            else
+                taskGraph_->AddTask(ProcessLightWork, &query, nullptr, this);
+            continue;
+        }
+
+        unsigned lightTask = taskGraph_->AddTask(ProcessLightWork, &query, nullptr, this);
+
+        // Shadow splits are culled in their own tasks once the light's shadow cameras are set up, so that shadow caster
+        // queries of one light overlap with the lit geometry queries of the others
+        if (!drawShadows_ || !light->GetCastShadows() || light->GetPerVertex())
+            continue;
+
+        unsigned maxSplits = 1;
+        if (light->GetLightType() == LIGHT_DIRECTIONAL)
+            maxSplits = MAX_CASCADE_SPLITS;
+        else if (light->GetLightType() == LIGHT_POINT)
+            maxSplits = MAX_LIGHT_SPLITS;
 
-        item->start_ = &query;
-        queue->AddWorkItem(item);
+        for (unsigned j = 0; j < maxSplits; ++j)
+        {
+            unsigned splitTask = taskGraph_->AddTask(ProcessShadowSplitWork, &query, reinterpret_cast<void*>((size_t)j), this);
+            taskGraph_->AddDependency(splitTask, lightTask);
+        }
     }
 
     // Ensure all lights have been processed before proceeding
-    queue->Complete(M_MAX_UNSIGNED);
+    taskGraph_->Run();
+}
+
+void View::BuildLightClusters()
+{
+    if (!clusteredLights_)
+        return;
+
+    if (!lightClusters_)
+        lightClusters_ = new LightClusters(context_);
+    lightClusters_->Build(camera_, clusteredLightList_);
+    lightClusters_->UpdateTexture();
 }
 
 void View::GetLightBatches()
@@ -1034,13 +1178,23 @@ void View::GetLightBatches()
             // Per-pixel light
             if (!light->GetPerVertex())
             {
+                // If no shadow casters, the light can be rendered unshadowed. At this point we have not allocated a shadow map yet,
+                // so the only cost has been the shadow camera setup & queries
                 unsigned shadowSplits = query.numSplits_;
+                bool hasShadowCasters = false;
+                for (unsigned j = 0; j < shadowSplits; ++j)
+                    hasShadowCasters |= !query.shadowCasters_[j].Empty();
+                if (!hasShadowCasters)
+                    shadowSplits = 0;
 
-                // Initialize light queue and store it to the light so that it can be found later
+                // Initialize light queue and store it to the light so that it can be found later. If the queue had the same light
+                // last frame, its shadow batch groups are likely to be needed again, so they are kept with their memory
                 LightBatchQueue& lightQueue = lightQueues_[usedLightQueues++];
+                const bool sameLight = lightQueue.light_ == light;
                 light->SetLightQueue(&lightQueue);
                 lightQueue.light_ = light;
                 lightQueue.negative_ = light->IsNegative();
+                lightQueue.clustered_ = query.clustered_;
                 lightQueue.shadowMap_ = nullptr;
                 lightQueue.litBaseBatches_.Clear(maxSortedInstances);
                 lightQueue.litBatches_.Clear(maxSortedInstances);
@@ -1074,15 +1228,17 @@ void View::GetLightBatches()
                     shadowQueue.shadowCamera_ = shadowCamera;
                     shadowQueue.nearSplit_ = query.shadowNearSplits_[j];
                     shadowQueue.farSplit_ = query.shadowFarSplits_[j];
-                    shadowQueue.shadowBatches_.Clear(maxSortedInstances);
+                    if (sameLight)
+                        shadowQueue.shadowBatches_.ClearInstances(maxSortedInstances);
+                    else
+                        shadowQueue.shadowBatches_.Clear(maxSortedInstances);
 
                     // Setup the shadow split viewport and finalize shadow camera parameters
                     shadowQueue.shadowViewport_ = GetShadowMapViewport(light, j, lightQueue.shadowMap_);
                     FinalizeShadowCamera(shadowCamera, light, shadowQueue.shadowViewport_, query.shadowCasterBox_[j]);
 
                     // Loop through shadow casters
-                    for (PODVector<Drawable*>::ConstIterator k = query.shadowCasters_.Begin() + query.shadowCasterBegin_[j];
-                         k < query.shadowCasters_.Begin() + query.shadowCasterEnd_[j]; ++k)
+                    for (FramePODVector<Drawable*>::ConstIterator k = query.shadowCasters_[j].Begin(); k != query.shadowCasters_[j].End(); ++k)
                     {
                         Drawable* drawable = *k;
                         // If drawable is not in actual view frustum, mark it in view here and check its geometry update type
@@ -1118,10 +1274,12 @@ void View::GetLightBatches()
                             AddBatchToQueue(shadowQueue.shadowBatches_, destBatch, tech);
                         }
                     }
+
+                    shadowQueue.shadowBatches_.RemoveEmptyGroups();
                 }
 
                 // Process lit geometries
-                for (PODVector<Drawable*>::ConstIterator j = query.litGeometries_.Begin(); j != query.litGeometries_.End(); ++j)
+                for (FramePODVector<Drawable*>::ConstIterator j = query.litGeometries_.Begin(); j != query.litGeometries_.End(); ++j)
                 {
                     Drawable* drawable = *j;
                     drawable->AddLight(light);
@@ -1157,7 +1315,7 @@ void View::GetLightBatches()
             else
             {
                 // Add the vertex light to lit drawables. It will be processed later during base pass batch generation
-                for (PODVector<Drawable*>::ConstIterator j = query.litGeometries_.Begin(); j != query.litGeometries_.End(); ++j)
+                for (FramePODVector<Drawable*>::ConstIterator j = query.litGeometries_.Begin(); j != query.litGeometries_.End(); ++j)
                 {
                     Drawable* drawable = *j;
                     drawable->AddVertexLight(light);
@@ -1193,6 +1351,29 @@ void View::GetBaseBatches()
 {
     URHO3D_PROFILE(GetBaseBatches);
 
+    // Cached scene pass batches refer to the scene passes, queues and shaders they were built with
+    unsigned cacheHash = renderer_->GetShadersChangedFrameNumber();
+    CombineHash(cacheHash, Technique::GetPassChanges());
+    CombineHash(cacheHash, renderer_->GetDynamicInstancing() ? 1u : 0u);
+    CombineHash(cacheHash, MakeHash(renderer_->GetDefaultMaterial()));
+    CombineHash(cacheHash, basePassIndex_);
+    for (PODVector<ScenePassInfo>::ConstIterator i = scenePasses_.Begin(); i != scenePasses_.End(); ++i)
+    {
+        CombineHash(cacheHash, i->passIndex_);
+        CombineHash(cacheHash, (i->allowInstancing_ ? 1u : 0u) | (i->markToStencil_ ? 2u : 0u) | (i->vertexLights_ ? 4u : 0u));
+        CombineHash(cacheHash, MakeHash(i->batchQueue_));
+        if (i->batchQueue_->hasExtraDefines_)
+        {
+            CombineHash(cacheHash, i->batchQueue_->vsExtraDefinesHash_.Value());
+            CombineHash(cacheHash, i->batchQueue_->psExtraDefinesHash_.Value());
+        }
+    }
+    if (cacheHash != batchCacheHash_)
+    {
+        batchCaches_.Clear();
+        batchCacheHash_ = cacheHash;
+    }
+
     for (PODVector<Drawable*>::ConstIterator i = geometries_.Begin(); i != geometries_.End(); ++i)
     {
         Drawable* drawable = *i;
@@ -1202,78 +1383,203 @@ void View::GetBaseBatches()
         else if (type == UPDATE_WORKER_THREAD)
             threadedGeometries_.Push(drawable);
 
-        const Vector<SourceBatch>& batches = drawable->GetBatches();
-        bool vertexLightsProcessed = false;
+        // Check here if the material refers to a rendertarget texture with camera(s) attached
+        // Only check this for backbuffer views (null rendertarget)
+        if (!renderTarget_)
+        {
+            const Vector<SourceBatch>& batches = drawable->GetBatches();
+            for (Vector<SourceBatch>::ConstIterator j = batches.Begin(); j != batches.End(); ++j)
+            {
+                if (j->material_ && j->material_->GetAuxViewFrameNumber() != frame_.frameNumber_)
+                    CheckMaterialForAuxView(j->material_);
+            }
+        }
 
-        for (unsigned j = 0; j < batches.Size(); ++j)
+        // Sort the batches into the scene passes again only if the drawable has changed
+        DrawableBatchCache& cache = batchCaches_[drawable];
+        if (!IsBatchCacheValid(drawable, cache))
+            BuildBatchCache(drawable, cache);
+        cache.frameNumber_ = frame_.frameNumber_;
+        AddCachedBatches(drawable, cache);
+    }
+
+    // Drop the caches of drawables which have left the view once they outnumber the visible ones
+    if (batchCaches_.Size() > 2 * geometries_.Size())
+    {
+        for (HashMap<Drawable*, DrawableBatchCache>::Iterator i = batchCaches_.Begin(); i != batchCaches_.End();)
         {
-            const SourceBatch& srcBatch = batches[j];
+            if (i->second_.frameNumber_ != frame_.frameNumber_)
+                i = batchCaches_.Erase(i);
+            else
+                ++i;
+        }
+    }
 
-            // Check here if the material refers to a rendertarget texture with camera(s) attached
-            // Only check this for backbuffer views (null rendertarget)
-            if (srcBatch.material_ && srcBatch.material_->GetAuxViewFrameNumber() != frame_.frameNumber_ && !renderTarget_)
-                CheckMaterialForAuxView(srcBatch.material_);
+    // Scene pass queues are complete now, so drop the instancing groups which were not needed this frame
+    for (PODVector<ScenePassInfo>::ConstIterator i = scenePasses_.Begin(); i != scenePasses_.End(); ++i)
+        i->batchQueue_->RemoveEmptyGroups();
+}
 
-            Technique* tech = GetTechnique(drawable, srcBatch.material_);
-            if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
+bool View::IsBatchCacheValid(Drawable* drawable, const DrawableBatchCache& cache)
+{
+    Zone* zone = GetZone(drawable);
+    if (cache.zone_ != zone || cache.zoneLightMask_ != zone->GetLightMask() || cache.heightFog_ != zone->GetHeightFog() ||
+        cache.lightMask_ != GetLightMask(drawable) || cache.basePassFlags_ != drawable->GetBasePassFlags())
+        return false;
+
+    const Vector<SourceBatch>& batches = drawable->GetBatches();
+    if (cache.sourceBatches_.Size() != batches.Size())
+        return false;
+
+    for (unsigned i = 0; i < batches.Size(); ++i)
+    {
+        const SourceBatch& srcBatch = batches[i];
+        const CachedSourceBatch& cachedBatch = cache.sourceBatches_[i];
+        if (cachedBatch.material_ != srcBatch.material_.Get() || cachedBatch.geometry_ != srcBatch.geometry_ ||
+            cachedBatch.geometryType_ != srcBatch.geometryType_ || cachedBatch.hasTransforms_ != (srcBatch.numWorldTransforms_ != 0) ||
+            cachedBatch.technique_ != GetTechnique(drawable, srcBatch.material_))
+            return false;
+    }
+
+    return true;
+}
+
+void View::BuildBatchCache(Drawable* drawable, DrawableBatchCache& cache)
+{
+    Zone* zone = GetZone(drawable);
+    cache.zone_ = zone;
+    cache.zoneLightMask_ = zone->GetLightMask();
+    cache.heightFog_ = zone->GetHeightFog();
+    cache.lightMask_ = GetLightMask(drawable);
+    cache.basePassFlags_ = drawable->GetBasePassFlags();
+    cache.sourceBatches_.Clear();
+    cache.sceneBatches_.Clear();
+
+    const Vector<SourceBatch>& batches = drawable->GetBatches();
+
+    for (unsigned j = 0; j < batches.Size(); ++j)
+    {
+        const SourceBatch& srcBatch = batches[j];
+
+        CachedSourceBatch sourceBatch;
+        sourceBatch.material_ = srcBatch.material_;
+        sourceBatch.geometry_ = srcBatch.geometry_;
+        sourceBatch.technique_ = GetTechnique(drawable, srcBatch.material_);
+        sourceBatch.geometryType_ = srcBatch.geometryType_;
+        sourceBatch.hasTransforms_ = srcBatch.numWorldTransforms_ != 0;
+        cache.sourceBatches_.Push(sourceBatch);
+
+        Technique* tech = sourceBatch.technique_;
+        if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
+            continue;
+
+        // Check each of the scene passes
+        for (unsigned k = 0; k < scenePasses_.Size(); ++k)
+        {
+            ScenePassInfo& info = scenePasses_[k];
+            // Skip forward base pass if the corresponding litbase pass already exists
+            if (info.passIndex_ == basePassIndex_ && j < 32 && drawable->HasBasePass(j))
                 continue;
 
-            // Check each of the scene passes
-            for (unsigned k = 0; k < scenePasses_.Size(); ++k)
-            {
-                ScenePassInfo& info = scenePasses_[k];
-                // Skip forward base pass if the corresponding litbase pass already exists
-                if (info.passIndex_ == basePassIndex_ && j < 32 && drawable->HasBasePass(j))
-                    continue;
+            Pass* pass = tech->GetSupportedPass(info.passIndex_);
+            if (!pass)
+                continue;
 
-                Pass* pass = tech->GetSupportedPass(info.passIndex_);
-                if (!pass)
-                    continue;
+            CachedSceneBatch sceneBatch;
+            sceneBatch.sourceIndex_ = j;
+            sceneBatch.scenePassIndex_ = k;
+            sceneBatch.pass_ = pass;
+            sceneBatch.allowInstancing_ = info.allowInstancing_;
+            if (sceneBatch.allowInstancing_ && info.markToStencil_ && (cache.lightMask_ & 0xffu) != (cache.zoneLightMask_ & 0xffu))
+                sceneBatch.allowInstancing_ = false;
+            // Shaders are chosen when the batch is first added to a queue
+            sceneBatch.shadedGeometryType_ = MAX_GEOMETRYTYPES;
+            sceneBatch.geometryType_ = srcBatch.geometryType_;
+            sceneBatch.vertexShader_ = nullptr;
+            sceneBatch.pixelShader_ = nullptr;
+            sceneBatch.sortKey_ = 0;
+            cache.sceneBatches_.Push(sceneBatch);
+        }
+    }
+}
 
-                Batch destBatch(srcBatch);
-                destBatch.pass_ = pass;
-                destBatch.zone_ = GetZone(drawable);
-                destBatch.isBase_ = true;
-                destBatch.lightMask_ = (unsigned char)GetLightMask(drawable);
+void View::AddCachedBatches(Drawable* drawable, DrawableBatchCache& cache)
+{
+    const Vector<SourceBatch>& batches = drawable->GetBatches();
+    const PODVector<Light*>& drawableVertexLights = drawable->GetVertexLights();
+    bool vertexLightsProcessed = false;
 
-                if (info.vertexLights_)
-                {
-                    const PODVector<Light*>& drawableVertexLights = drawable->GetVertexLights();
-                    if (drawableVertexLights.Size() && !vertexLightsProcessed)
-                    {
-                        // Limit vertex lights. If this is a deferred opaque batch, remove converted per-pixel lights,
-                        // as they will be rendered as light volumes in any case, and drawing them also as vertex lights
-                        // would result in double lighting
-                        drawable->LimitVertexLights(deferred_ && destBatch.pass_->GetBlendMode() == BLEND_REPLACE);
-                        vertexLightsProcessed = true;
-                    }
+    for (PODVector<CachedSceneBatch>::Iterator i = cache.sceneBatches_.Begin(); i != cache.sceneBatches_.End(); ++i)
+    {
+        ScenePassInfo& info = scenePasses_[i->scenePassIndex_];
+        Technique* tech = cache.sourceBatches_[i->sourceIndex_].technique_;
 
-                    if (drawableVertexLights.Size())
-                    {
-                        // Find a vertex light queue. If not found, create new
-                        unsigned long long hash = GetVertexLightQueueHash(drawableVertexLights);
-                        HashMap<unsigned long long, LightBatchQueue>::Iterator i = vertexLightQueues_.Find(hash);
-                        if (i == vertexLightQueues_.End())
-                        {
-                            i = vertexLightQueues_.Insert(MakePair(hash, LightBatchQueue()));
-                            i->second_.light_ = nullptr;
-                            i->second_.shadowMap_ = nullptr;
-                            i->second_.vertexLights_ = drawableVertexLights;
-                        }
+        Batch destBatch(batches[i->sourceIndex_]);
+        destBatch.pass_ = i->pass_;
+        destBatch.zone_ = cache.zone_;
+        destBatch.isBase_ = true;
+        destBatch.lightMask_ = (unsigned char)cache.lightMask_;
 
-                        destBatch.lightQueue_ = &(i->second_);
-                    }
+        // Vertex lights change from frame to frame, so they are not cached
+        if (info.vertexLights_)
+        {
+            if (drawableVertexLights.Size() && !vertexLightsProcessed)
+            {
+                // Limit vertex lights. If this is a deferred opaque batch, remove converted per-pixel lights,
+                // as they will be rendered as light volumes in any case, and drawing them also as vertex lights
+                // would result in double lighting
+                drawable->LimitVertexLights(deferred_ && destBatch.pass_->GetBlendMode() == BLEND_REPLACE);
+                vertexLightsProcessed = true;
+            }
+
+            if (drawableVertexLights.Size())
+            {
+                // Find a vertex light queue. If not found, create new
+                unsigned long long hash = GetVertexLightQueueHash(drawableVertexLights);
+                HashMap<unsigned long long, LightBatchQueue>::Iterator j = vertexLightQueues_.Find(hash);
+                if (j == vertexLightQueues_.End())
+                {
+                    j = vertexLightQueues_.Insert(MakePair(hash, LightBatchQueue()));
+                    j->second_.light_ = nullptr;
+                    j->second_.shadowMap_ = nullptr;
+                    j->second_.vertexLights_ = drawableVertexLights;
                 }
-                else
-                    destBatch.lightQueue_ = nullptr;
 
-                bool allowInstancing = info.allowInstancing_;
-                if (allowInstancing && info.markToStencil_ && destBatch.lightMask_ != (destBatch.zone_->GetLightMask() & 0xffu))
-                    allowInstancing = false;
+                destBatch.lightQueue_ = &(j->second_);
+            }
+        }
+
+        if (!destBatch.material_)
+            destBatch.material_ = renderer_->GetDefaultMaterial();
 
-                AddBatchToQueue(*info.batchQueue_, destBatch, tech, allowInstancing);
+        BatchQueue& queue = *info.batchQueue_;
+        if (AddBatchToGroup(queue, destBatch, tech, i->allowInstancing_, true))
+            continue;
+
+        // Reuse the shaders chosen on an earlier frame unless the batch is vertex lit
+        if (destBatch.lightQueue_ || i->shadedGeometryType_ != destBatch.geometryType_)
+        {
+            GeometryType shadedGeometryType = destBatch.geometryType_;
+            renderer_->SetBatchShaders(destBatch, tech, true, queue);
+            destBatch.CalculateSortKey();
+            if (!destBatch.lightQueue_)
+            {
+                i->shadedGeometryType_ = shadedGeometryType;
+                i->geometryType_ = destBatch.geometryType_;
+                i->vertexShader_ = destBatch.vertexShader_;
+                i->pixelShader_ = destBatch.pixelShader_;
+                i->sortKey_ = destBatch.sortKey_;
             }
         }
+        else
+        {
+            destBatch.geometryType_ = i->geometryType_;
+            destBatch.vertexShader_ = i->vertexShader_;
+            destBatch.pixelShader_ = i->pixelShader_;
+            destBatch.sortKey_ = i->sortKey_;
+        }
+
+        PushBatch(queue, destBatch);
     }
 }
 
@@ -1289,6 +1595,7 @@ void View::UpdateGeometries()
     URHO3D_PROFILE(SortAndUpdateGeometry);
 
     auto* queue = GetSubsystem<WorkQueue>();
+    taskGraph_->Clear();
 
     // Sort batches
     {
@@ -1300,31 +1607,16 @@ void View::UpdateGeometries()
 
             if (command.type_ == CMD_SCENEPASS)
             {
-                SharedPtr<WorkItem> item = queue->GetFreeItem();
-                item->priority_ = M_MAX_UNSIGNED;
-                item->workFunction_ =
-                    command.sortMode_ == SORT_FRONTTOBACK ? SortBatchQueueFrontToBackWork : SortBatchQueueBackToFrontWork;
-                item->start_ = &batchQueues_[command.passIndex_];
-                queue->AddWorkItem(item);
+                taskGraph_->AddTask(command.sortMode_ == SORT_FRONTTOBACK ? SortBatchQueueFrontToBackWork :
+                    SortBatchQueueBackToFrontWork, &batchQueues_[command.passIndex_]);
             }
         }
 
         for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
         {
-            SharedPtr<WorkItem> lightItem = queue->GetFreeItem();
-            lightItem->priority_ = M_MAX_UNSIGNED;
-            lightItem->workFunction_ = SortLightQueueWork;
-            lightItem->start_ = &(*i);
-            queue->AddWorkItem(lightItem);
-
+            taskGraph_->AddTask(SortLightQueueWork, &(*i));
             if (i->shadowSplits_.Size())
-            {
-                SharedPtr<WorkItem> shadowItem = queue->GetFreeItem();
-                shadowItem->priority_ = M_MAX_UNSIGNED;
-                shadowItem->workFunction_ = SortShadowQueueWork;
-                shadowItem->start_ = &(*i);
-                queue->AddWorkItem(shadowItem);
-            }
+                taskGraph_->AddTask(SortShadowQueueWork, &(*i));
         }
     }
 
@@ -1344,35 +1636,26 @@ void View::UpdateGeometries()
                 }
             }
 
-            int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-            int drawablesPerItem = threadedGeometries_.Size() / numWorkItems;
+            // Make a few chunks per thread so that stealing can balance the uneven update costs
+            unsigned numChunks = (queue->GetNumThreads() + 1) * 4;
+            unsigned drawablesPerChunk = Max(threadedGeometries_.Size() / numChunks, MIN_GEOMETRIES_PER_TASK);
+            Drawable** buffer = threadedGeometries_.Buffer();
 
-            PODVector<Drawable*>::Iterator start = threadedGeometries_.Begin();
-            for (int i = 0; i < numWorkItems; ++i)
+            for (unsigned start = 0; start < threadedGeometries_.Size(); start += drawablesPerChunk)
             {
-                PODVector<Drawable*>::Iterator end = threadedGeometries_.End();
-                if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                    end = start + drawablesPerItem;
-
-                SharedPtr<WorkItem> item = queue->GetFreeItem();
-                item->priority_ = M_MAX_UNSIGNED;
-                item->workFunction_ = UpdateDrawableGeometriesWork;
-                item->aux_ = const_cast<FrameInfo*>(&frame_);
-                item->start_ = &(*start);
-                item->end_ = &(*end);
-                queue->AddWorkItem(item);
-
-                start = end;
+                unsigned end = Min(start + drawablesPerChunk, threadedGeometries_.Size());
+                taskGraph_->AddTask(UpdateDrawableGeometriesWork, buffer + start, buffer + end, const_cast<FrameInfo*>(&frame_));
             }
         }
 
-        // While the work queue is processed, update non-threaded geometries
+        // While the sorts and threaded updates are processed, update non-threaded geometries
+        taskGraph_->Start();
         for (PODVector<Drawable*>::ConstIterator i = nonThreadedGeometries_.Begin(); i != nonThreadedGeometries_.End(); ++i)
             (*i)->UpdateGeometry(frame_);
     }
 
     // Finally ensure all threaded work has completed
-    queue->Complete(M_MAX_UNSIGNED);
+    taskGraph_->Wait();
     geometriesUpdated_ = true;
 }
 
@@ -1397,6 +1680,9 @@ void View::GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQ
         // Do not create pixel lit forward passes for materials that render into the G-buffer
         if (gBufferPassIndex_ != M_MAX_UNSIGNED && tech->HasPass(gBufferPassIndex_))
             continue;
+        // Nor for materials which shade the light from the clusters already
+        if (lightQueue.clustered_ && IsClusteredTechnique(tech))
+            continue;
 
         Batch destBatch(srcBatch);
         bool isLitAlpha = false;
@@ -1750,7 +2036,7 @@ void View::SetRenderTargets(RenderPathCommand& command)
             {
                 useColorWrite = false;
                 useCustomDepth = true;
-#if !defined(URHO3D_OPENGL) && !defined(URHO3D_D3D11)
+#if !defined(URHO3D_OPENGL) && !defined(URHO3D_D3D11) && !defined(URHO3D_NULL)
                 // On D3D9 actual depth-only rendering is illegal, we need a color rendertarget
                 if (!depthOnlyDummyTexture_)
                 {
@@ -2273,12 +2559,141 @@ void View::DrawOccluders(OcclusionBuffer* buffer, const PODVector<Drawable*>& oc
     buffer->BuildDepthHierarchy();
 }
 
+void View::UpdateShadowCasterCaches()
+{
+    if (!renderer_->GetShadowCasterCaching() || !drawShadows_)
+    {
+        shadowCasterCaches_.Clear();
+        for (unsigned i = 0; i < lightQueryResults_.Size(); ++i)
+            lightQueryResults_[i].shadowCache_ = nullptr;
+        return;
+    }
+
+    URHO3D_PROFILE(UpdateShadowCasterCaches);
+
+    // The caches can only be kept if they see the changes of every octree update. Otherwise they may hold destroyed drawables
+    const unsigned numUpdates = octree_->GetNumUpdates();
+    const bool newUpdate = numUpdates == shadowCacheOctreeUpdates_ + 1;
+    if (shadowCacheOctree_ != octree_ || (numUpdates != shadowCacheOctreeUpdates_ && (!newUpdate || octree_->HasChangeOverflow())))
+        shadowCasterCaches_.Clear();
+    shadowCacheOctree_ = octree_;
+    shadowCacheOctreeUpdates_ = numUpdates;
+
+    for (unsigned i = 0; i < lightQueryResults_.Size(); ++i)
+    {
+        Light* light = lights_[i];
+        ShadowCasterCache& cache = shadowCasterCaches_[light];
+        if (cache.light_.Get() != light)
+        {
+            cache = ShadowCasterCache();
+            cache.light_ = light;
+        }
+        cache.frameNumber_ = frame_.frameNumber_;
+        lightQueryResults_[i].shadowCache_ = &cache;
+    }
+
+    // Drop the caches of lights which are no longer visible, then invalidate what moved drawables touch
+    const PODVector<BoundingBox>& changes = octree_->GetChangedBoxes();
+    for (HashMap<Light*, ShadowCasterCache>::Iterator i = shadowCasterCaches_.Begin(); i != shadowCasterCaches_.End();)
+    {
+        ShadowCasterCache& cache = i->second_;
+        if (cache.frameNumber_ != frame_.frameNumber_)
+        {
+            i = shadowCasterCaches_.Erase(i);
+            continue;
+        }
+
+        if (newUpdate)
+        {
+            for (PODVector<BoundingBox>::ConstIterator j = changes.Begin(); j != changes.End(); ++j)
+            {
+                if (cache.lightDrawablesValid_ && cache.lightVolume_.IsInsideFast(*j) != OUTSIDE)
+                    cache.lightDrawablesValid_ = false;
+                for (unsigned k = 0; k < cache.numSplits_; ++k)
+                {
+                    if (cache.splits_[k].valid_ && cache.splits_[k].volume_.IsInsideFast(*j) != OUTSIDE)
+                        cache.splits_[k].valid_ = false;
+                }
+            }
+        }
+        ++i;
+    }
+}
+
+bool View::IsClusteredLight(Light* light) const
+{
+    // Clusters are sliced by perspective depth, so orthographic views use light queues for all lights
+    if (camera_->IsOrthographic() || light->GetLightType() == LIGHT_DIRECTIONAL || light->GetPerVertex() || light->IsNegative())
+        return false;
+    if ((drawShadows_ && light->GetCastShadows()) || light->GetRampTexture() || light->GetShapeTexture())
+        return false;
+    return light->GetLightMask() == DEFAULT_LIGHTMASK;
+}
+
+bool View::IsClusteredPass(Pass* pass)
+{
+    HashMap<Pass*, bool>::ConstIterator i = clusteredPasses_.Find(pass);
+    if (i != clusteredPasses_.End())
+        return i->second_;
+
+    ShaderVariation* pixelShader = graphics_->GetShader(PS, pass->GetPixelShader());
+    const bool clustered = pixelShader && pixelShader->GetOwner() && pixelShader->GetOwner()->GetClusteredLights();
+    clusteredPasses_[pass] = clustered;
+    return clustered;
+}
+
+bool View::IsClusteredTechnique(Technique* tech)
+{
+    for (unsigned i = 0; i < clusteredPassIndices_.Size(); ++i)
+    {
+        Pass* pass = tech->GetSupportedPass(clusteredPassIndices_[i]);
+        if (pass && IsClusteredPass(pass))
+            return true;
+    }
+    return false;
+}
+
+void View::GetUnclusteredGeometries()
+{
+    unclusteredGeometries_.Clear();
+    clusteredPasses_.Clear();
+    if (!clusteredLights_)
+        return;
+
+    URHO3D_PROFILE(GetUnclusteredGeometries);
+
+    for (PODVector<Drawable*>::ConstIterator i = geometries_.Begin(); i != geometries_.End(); ++i)
+    {
+        Drawable* drawable = *i;
+        const Vector<SourceBatch>& batches = drawable->GetBatches();
+
+        for (unsigned j = 0; j < batches.Size(); ++j)
+        {
+            const SourceBatch& srcBatch = batches[j];
+            Technique* tech = GetTechnique(drawable, srcBatch.material_);
+            if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
+                continue;
+
+            // Only materials which receive per-pixel light in the forward light passes
+            if (!tech->HasPass(lightPassIndex_) && !tech->HasPass(litAlphaPassIndex_))
+                continue;
+            if (gBufferPassIndex_ != M_MAX_UNSIGNED && tech->HasPass(gBufferPassIndex_))
+                continue;
+
+            if (!IsClusteredTechnique(tech))
+            {
+                unclusteredGeometries_.Insert(drawable);
+                break;
+            }
+        }
+    }
+}
+
 void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
 {
     Light* light = query.light_;
     LightType type = light->GetLightType();
     unsigned lightMask = light->GetLightMask();
-    const Frustum& frustum = cullCamera_->GetFrustum();
 
     // Check if light should be shadowed
     bool isShadowed = drawShadows_ && light->GetCastShadows() && !light->GetPerVertex() && light->GetShadowIntensity() < 1.0f;
@@ -2290,9 +2705,15 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
     if (isShadowed && type == LIGHT_POINT)
         isShadowed = false;
 #endif
-    // Get lit geometries. They must match the light mask and be inside the main camera frustum to be considered
-    PODVector<Drawable*>& tempDrawables = tempDrawables_[threadIndex];
-    query.litGeometries_.Clear();
+    // Get lit geometries. They must match the light mask and be inside the main camera frustum to be considered.
+    // The light volume query result is kept in the query or the light's cache, as the shadow split tasks may run in other threads
+    PODVector<Drawable*>& lightDrawables = query.shadowCache_ ? query.shadowCache_->lightDrawables_ : query.lightDrawables_;
+    // Results from the previous frame live in arenas which have been reset since, so drop them without reading
+    query.litGeometries_.Reset(GetFrameArena(threadIndex));
+    for (unsigned i = 0; i < MAX_LIGHT_SPLITS; ++i)
+        query.shadowCasters_[i].Reset(nullptr);
+    // Check the light against its cache also for directional lights, whose cached shadow casters are invalid once it turns
+    const bool lightVolumeCached = IsLightVolumeCached(query);
 
     switch (type)
     {
@@ -2306,26 +2727,38 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
 
     case LIGHT_SPOT:
         {
-            FrustumOctreeQuery octreeQuery(tempDrawables, light->GetFrustum(), DRAWABLE_GEOMETRY,
-                cullCamera_->GetViewMask());
-            octree_->GetDrawables(octreeQuery);
-            for (unsigned i = 0; i < tempDrawables.Size(); ++i)
+            if (!lightVolumeCached)
             {
-                if (tempDrawables[i]->IsInView(frame_) && (GetLightMask(tempDrawables[i]) & lightMask))
-                    query.litGeometries_.Push(tempDrawables[i]);
+                const Frustum& frustum = light->GetFrustum();
+                FrustumOctreeQuery octreeQuery(lightDrawables, frustum, DRAWABLE_GEOMETRY, cullCamera_->GetViewMask());
+                octree_->GetDrawables(octreeQuery);
+                if (query.shadowCache_)
+                    query.shadowCache_->lightVolume_ = BoundingBox(frustum);
+            }
+            for (unsigned i = 0; i < lightDrawables.Size(); ++i)
+            {
+                if (lightDrawables[i]->IsInView(frame_) && (GetLightMask(lightDrawables[i]) & lightMask) &&
+                    (!query.clustered_ || unclusteredGeometries_.Contains(lightDrawables[i])))
+                    query.litGeometries_.Push(lightDrawables[i]);
             }
         }
         break;
 
     case LIGHT_POINT:
         {
-            SphereOctreeQuery octreeQuery(tempDrawables, Sphere(light->GetNode()->GetWorldPosition(), light->GetRange()),
-                DRAWABLE_GEOMETRY, cullCamera_->GetViewMask());
-            octree_->GetDrawables(octreeQuery);
-            for (unsigned i = 0; i < tempDrawables.Size(); ++i)
+            if (!lightVolumeCached)
             {
-                if (tempDrawables[i]->IsInView(frame_) && (GetLightMask(tempDrawables[i]) & lightMask))
-                    query.litGeometries_.Push(tempDrawables[i]);
+                Sphere sphere(light->GetNode()->GetWorldPosition(), light->GetRange());
+                SphereOctreeQuery octreeQuery(lightDrawables, sphere, DRAWABLE_GEOMETRY, cullCamera_->GetViewMask());
+                octree_->GetDrawables(octreeQuery);
+                if (query.shadowCache_)
+                    query.shadowCache_->lightVolume_ = BoundingBox(sphere);
+            }
+            for (unsigned i = 0; i < lightDrawables.Size(); ++i)
+            {
+                if (lightDrawables[i]->IsInView(frame_) && (GetLightMask(lightDrawables[i]) & lightMask) &&
+                    (!query.clustered_ || unclusteredGeometries_.Contains(lightDrawables[i])))
+                    query.litGeometries_.Push(lightDrawables[i]);
             }
         }
         break;
@@ -2338,45 +2771,135 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
         return;
     }
 
-    // Determine number of shadow cameras and setup their initial positions
+    // Determine number of shadow cameras and setup their initial positions. The splits are then processed by their own tasks
     SetupShadowCameras(query);
 
-    // Process each split for shadow casters
-    query.shadowCasters_.Clear();
-    for (unsigned i = 0; i < query.numSplits_; ++i)
+    ShadowCasterCache* cache = query.shadowCache_;
+    if (cache && cache->numSplits_ != query.numSplits_)
     {
-        Camera* shadowCamera = query.shadowCameras_[i];
-        const Frustum& shadowCameraFrustum = shadowCamera->GetFrustum();
-        query.shadowCasterBegin_[i] = query.shadowCasterEnd_[i] = query.shadowCasters_.Size();
+        for (unsigned i = 0; i < MAX_LIGHT_SPLITS; ++i)
+            cache->splits_[i].valid_ = false;
+        cache->numSplits_ = query.numSplits_;
+    }
+}
 
-        // For point light check that the face is visible: if not, can skip the split
-        if (type == LIGHT_POINT && frustum.IsInsideFast(BoundingBox(shadowCameraFrustum)) == OUTSIDE)
-            continue;
+bool View::IsLightVolumeCached(LightQueryResult& query)
+{
+    ShadowCasterCache* cache = query.shadowCache_;
+    if (!cache)
+        return false;
 
-        // For directional light check that the split is inside the visible scene: if not, can skip the split
-        if (type == LIGHT_DIRECTIONAL)
-        {
-            if (minZ_ > query.shadowFarSplits_[i])
-                continue;
-            if (maxZ_ < query.shadowNearSplits_[i])
-                continue;
+    Light* light = query.light_;
+    const Matrix3x4& transform = light->GetNode()->GetWorldTransform();
+    const Vector3 shape(light->GetRange(), light->GetFov(), light->GetAspectRatio());
+    const unsigned viewMask = cullCamera_->GetViewMask();
+    if (cache->lightType_ != light->GetLightType() || cache->viewMask_ != viewMask || cache->lightTransform_ != transform ||
+        cache->lightShape_ != shape)
+    {
+        // The light has changed, so neither the light volume query nor the shadow casters culled from it can be reused
+        cache->lightType_ = light->GetLightType();
+        cache->viewMask_ = viewMask;
+        cache->lightTransform_ = transform;
+        cache->lightShape_ = shape;
+        cache->lightDrawablesValid_ = false;
+        for (unsigned i = 0; i < MAX_LIGHT_SPLITS; ++i)
+            cache->splits_[i].valid_ = false;
+    }
+
+    const bool cached = cache->lightDrawablesValid_;
+    // The query is made now if it was not cached, and is valid from then on
+    cache->lightDrawablesValid_ = true;
+    return cached;
+}
 
-            // Reuse lit geometry query for all except directional lights
-            ShadowCasterOctreeQuery query(tempDrawables, shadowCameraFrustum, DRAWABLE_GEOMETRY, cullCamera_->GetViewMask());
-            octree_->GetDrawables(query);
+void View::ProcessShadowSplit(LightQueryResult& query, unsigned splitIndex, unsigned threadIndex)
+{
+    if (splitIndex >= query.numSplits_)
+        return;
+
+    LightType type = query.light_->GetLightType();
+    Camera* shadowCamera = query.shadowCameras_[splitIndex];
+    const Frustum& shadowCameraFrustum = shadowCamera->GetFrustum();
+
+    // For point light check that the face is visible: if not, can skip the split
+    if (type == LIGHT_POINT && cullCamera_->GetFrustum().IsInsideFast(BoundingBox(shadowCameraFrustum)) == OUTSIDE)
+        return;
+
+    // For directional light check that the split is inside the visible scene: if not, can skip the split
+    if (type == LIGHT_DIRECTIONAL && (minZ_ > query.shadowFarSplits_[splitIndex] || maxZ_ < query.shadowNearSplits_[splitIndex]))
+        return;
+
+    // Reuse the cached shadow casters if the split is culled the same way as when they were cached
+    ShadowCasterCache* cache = query.shadowCache_;
+    if (cache && IsShadowSplitCached(query, splitIndex))
+    {
+        const ShadowSplitCache& split = cache->splits_[splitIndex];
+        FramePODVector<Drawable*>& shadowCasters = query.shadowCasters_[splitIndex];
+        shadowCasters.Reset(GetFrameArena(threadIndex));
+        shadowCasters.Push(split.casters_.Buffer(), split.casters_.Size());
+        query.shadowCasterBox_[splitIndex] = split.casterBox_;
+        for (unsigned i = 0; i < split.casters_.Size(); ++i)
+        {
+            if (!split.casters_[i]->IsInView(frame_, true))
+                split.casters_[i]->UpdateBatches(frame_);
         }
+        return;
+    }
 
-        // Check which shadow casters actually contribute to the shadowing
-        ProcessShadowCasters(query, tempDrawables, i);
+    // Reuse lit geometry query for all except directional lights
+    const PODVector<Drawable*>* drawables = cache ? &cache->lightDrawables_ : &query.lightDrawables_;
+    if (type == LIGHT_DIRECTIONAL)
+    {
+        PODVector<Drawable*>& tempDrawables = tempDrawables_[threadIndex];
+        ShadowCasterOctreeQuery octreeQuery(tempDrawables, shadowCameraFrustum, DRAWABLE_GEOMETRY, cullCamera_->GetViewMask());
+        octree_->GetDrawables(octreeQuery);
+        drawables = &tempDrawables;
+    }
+
+    // Check which shadow casters actually contribute to the shadowing
+    ProcessShadowCasters(query, *drawables, splitIndex, threadIndex);
+
+    if (cache)
+    {
+        ShadowSplitCache& split = cache->splits_[splitIndex];
+        const FramePODVector<Drawable*>& shadowCasters = query.shadowCasters_[splitIndex];
+        split.shadowView_ = shadowCamera->GetView();
+        split.shadowProjection_ = shadowCamera->GetProjection();
+        split.cullView_ = cullCamera_->GetView();
+        split.cullProjection_ = cullCamera_->GetProjection();
+        split.minZ_ = minZ_;
+        split.maxZ_ = maxZ_;
+        split.nearSplit_ = query.shadowNearSplits_[splitIndex];
+        split.farSplit_ = query.shadowFarSplits_[splitIndex];
+        // Casters of directional lights were queried by the split frustum. Those of other lights are a subset of the light volume
+        split.volume_ = type == LIGHT_DIRECTIONAL ? BoundingBox(shadowCameraFrustum) : cache->lightVolume_;
+        split.casterBox_ = query.shadowCasterBox_[splitIndex];
+        split.casters_.Resize(shadowCasters.Size());
+        for (unsigned i = 0; i < shadowCasters.Size(); ++i)
+            split.casters_[i] = shadowCasters[i];
+        split.valid_ = true;
     }
+}
 
-    // If no shadow casters, the light can be rendered unshadowed. At this point we have not allocated a shadow map yet, so the
-    // only cost has been the shadow camera setup & queries
-    if (query.shadowCasters_.Empty())
-        query.numSplits_ = 0;
+bool View::IsShadowSplitCached(LightQueryResult& query, unsigned splitIndex) const
+{
+    const ShadowSplitCache& split = query.shadowCache_->splits_[splitIndex];
+    if (!split.valid_)
+        return false;
+
+    // With round-robin cascades, all but the first and one other directional light split reuse their casters whatever the camera does
+    if (renderer_->GetRoundRobinCascades() && query.light_->GetLightType() == LIGHT_DIRECTIONAL && splitIndex > 0 &&
+        splitIndex != 1 + frame_.frameNumber_ % (query.numSplits_ - 1))
+        return true;
+
+    const Camera* shadowCamera = query.shadowCameras_[splitIndex];
+    return split.shadowView_ == shadowCamera->GetView() && split.shadowProjection_ == shadowCamera->GetProjection() &&
+        split.cullView_ == cullCamera_->GetView() && split.cullProjection_ == cullCamera_->GetProjection() &&
+        split.minZ_ == minZ_ && split.maxZ_ == maxZ_ && split.nearSplit_ == query.shadowNearSplits_[splitIndex] &&
+        split.farSplit_ == query.shadowFarSplits_[splitIndex];
 }
 
-void View::ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawable*>& drawables, unsigned splitIndex)
+void View::ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawable*>& drawables, unsigned splitIndex, unsigned threadIndex)
 {
     Light* light = query.light_;
     unsigned lightMask = light->GetLightMask();
@@ -2388,6 +2911,7 @@ void View::ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawabl
     LightType type = light->GetLightType();
 
     query.shadowCasterBox_[splitIndex].Clear();
+    query.shadowCasters_[splitIndex].Reset(GetFrameArena(threadIndex));
 
     // Transform scene frustum into shadow camera's view space for shadow caster visibility check. For point & spot lights,
     // we can use the whole scene frustum. For directional lights, use the intersection of the scene frustum and the split
@@ -2445,11 +2969,9 @@ void View::ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawabl
                 lightProjBox = lightViewBox.Projected(lightProj);
                 query.shadowCasterBox_[splitIndex].Merge(lightProjBox);
             }
-            query.shadowCasters_.Push(drawable);
+            query.shadowCasters_[splitIndex].Push(drawable);
         }
     }
-
-    query.shadowCasterEnd_[splitIndex] = query.shadowCasters_.Size();
 }
 
 bool View::IsShadowCasterVisible(Drawable* drawable, BoundingBox lightViewBox, Camera* shadowCamera, const Matrix3x4& lightView,
@@ -2882,6 +3404,11 @@ void View::SetQueueShaderDefines(BatchQueue& queue, const RenderPathCommand& com
 {
     String vsDefines = command.vertexShaderDefines_.Trimmed();
     String psDefines = command.pixelShaderDefines_.Trimmed();
+    if (clusteredLights_ && command.clusteredLights_)
+    {
+        vsDefines = (vsDefines + " CLUSTERED").Trimmed();
+        psDefines = (psDefines + " CLUSTERED").Trimmed();
+    }
     if (vsDefines.Length() || psDefines.Length())
     {
         queue.hasExtraDefines_ = true;
@@ -2899,56 +3426,82 @@ void View::AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, boo
     if (!batch.material_)
         batch.material_ = renderer_->GetDefaultMaterial();
 
-    // Convert to instanced if possible
-    if (allowInstancing && batch.geometryType_ == GEOM_STATIC && batch.geometry_->GetIndexBuffer())
-        batch.geometryType_ = GEOM_INSTANCED;
+    if (AddBatchToGroup(queue, batch, tech, allowInstancing, allowShadows))
+        return;
 
-    if (batch.geometryType_ == GEOM_INSTANCED)
-    {
-        BatchGroupKey key(batch);
+    renderer_->SetBatchShaders(batch, tech, allowShadows, queue);
+    batch.CalculateSortKey();
+    PushBatch(queue, batch);
+}
 
-        HashMap<BatchGroupKey, BatchGroup>::Iterator i = queue.batchGroups_.Find(key);
-        if (i == queue.batchGroups_.End())
+bool View::AddBatchToGroup(BatchQueue& queue, Batch& batch, Technique* tech, bool allowInstancing, bool allowShadows)
+{
+    // Convert to instanced if possible. Skinned instances read their skin matrices from a texture in the vertex shader
+    if (allowInstancing && batch.geometry_->GetIndexBuffer())
+    {
+        if (batch.geometryType_ == GEOM_STATIC)
+            batch.geometryType_ = GEOM_INSTANCED;
+        else if (batch.geometryType_ == GEOM_SKINNED && graphics_->GetVertexTextureSupport() &&
+            numInstancedSkinMatrices_ + batch.numWorldTransforms_ <= MAX_INSTANCED_SKIN_MATRICES)
         {
-            // Create a new group based on the batch
-            // In case the group remains below the instancing limit, do not enable instancing shaders yet
-            BatchGroup newGroup(batch);
-            newGroup.geometryType_ = GEOM_STATIC;
-            renderer_->SetBatchShaders(newGroup, tech, allowShadows, queue);
-            newGroup.CalculateSortKey();
-            i = queue.batchGroups_.Insert(MakePair(key, newGroup));
+            // Beyond what the skin matrix texture can hold, skinned batches are drawn individually
+            batch.geometryType_ = GEOM_SKINNED_INSTANCED;
+            numInstancedSkinMatrices_ += batch.numWorldTransforms_;
         }
+    }
 
-        int oldSize = i->second_.instances_.Size();
-        i->second_.AddTransforms(batch);
-        // Convert to using instancing shaders when the instancing limit is reached
-        if (oldSize < minInstances_ && (int)i->second_.instances_.Size() >= minInstances_)
-        {
-            i->second_.geometryType_ = GEOM_INSTANCED;
-            renderer_->SetBatchShaders(i->second_, tech, allowShadows, queue);
-            i->second_.CalculateSortKey();
-        }
+    if (batch.geometryType_ != GEOM_INSTANCED && batch.geometryType_ != GEOM_SKINNED_INSTANCED &&
+        (!allowInstancing || batch.geometryType_ != GEOM_BILLBOARD_INSTANCED))
+        return false;
+
+    BatchGroup& group = queue.GetGroup(BatchGroupKey(batch));
+    if (group.instances_.Empty())
+    {
+        // Set up a new group, or a group kept from the previous frame, based on the batch
+        // In case the group remains below the instancing limit, do not enable instancing shaders yet. Instanced
+        // billboards have no other shaders to use
+        static_cast<Batch&>(group) = batch;
+        if (batch.geometryType_ == GEOM_INSTANCED)
+            group.geometryType_ = GEOM_STATIC;
+        else if (batch.geometryType_ == GEOM_SKINNED_INSTANCED)
+            group.geometryType_ = GEOM_SKINNED;
+        group.startIndex_ = M_MAX_UNSIGNED;
+        renderer_->SetBatchShaders(group, tech, allowShadows, queue);
+        group.CalculateSortKey();
     }
-    else
+
+    int oldSize = group.instances_.Size();
+    group.AddTransforms(batch);
+    // Convert to using instancing shaders when the instancing limit is reached
+    if (group.geometryType_ != batch.geometryType_ && oldSize < minInstances_ && (int)group.instances_.Size() >= minInstances_)
     {
-        renderer_->SetBatchShaders(batch, tech, allowShadows, queue);
-        batch.CalculateSortKey();
+        // Keep the individual skinned shader in case the skin matrix texture fails to update
+        if (batch.geometryType_ == GEOM_SKINNED_INSTANCED)
+            group.skinnedVertexShader_ = group.vertexShader_;
+        group.geometryType_ = batch.geometryType_;
+        renderer_->SetBatchShaders(group, tech, allowShadows, queue);
+        group.CalculateSortKey();
+    }
+
+    return true;
+}
 
-        // If batch is static with multiple world transforms and cannot instance, we must push copies of the batch individually
-        if (batch.geometryType_ == GEOM_STATIC && batch.numWorldTransforms_ > 1)
+void View::PushBatch(BatchQueue& queue, Batch& batch)
+{
+    // If batch is static with multiple world transforms and cannot instance, we must push copies of the batch individually
+    if (batch.geometryType_ == GEOM_STATIC && batch.numWorldTransforms_ > 1)
+    {
+        unsigned numTransforms = batch.numWorldTransforms_;
+        batch.numWorldTransforms_ = 1;
+        for (unsigned i = 0; i < numTransforms; ++i)
         {
-            unsigned numTransforms = batch.numWorldTransforms_;
-            batch.numWorldTransforms_ = 1;
-            for (unsigned i = 0; i < numTransforms; ++i)
-            {
-                // Move the transform pointer to generate copies of the batch which only refer to 1 world transform
-                queue.batches_.Push(batch);
-                ++batch.worldTransform_;
-            }
-        }
-        else
+            // Move the transform pointer to generate copies of the batch which only refer to 1 world transform
             queue.batches_.Push(batch);
+            ++batch.worldTransform_;
+        }
     }
+    else
+        queue.batches_.Push(batch);
 }
 
 void View::PrepareInstancingBuffer()
@@ -2976,28 +3529,50 @@ void View::PrepareInstancingBuffer()
         totalInstances += i->litBatches_.GetNumInstances();
     }
 
-    if (!totalInstances || !renderer_->ResizeInstancingBuffer(totalInstances))
+    if (!totalInstances)
         return;
 
-    VertexBuffer* instancingBuffer = renderer_->GetInstancingBuffer();
-    unsigned freeIndex = 0;
-    void* dest = instancingBuffer->Lock(0, totalInstances, true);
+    VertexBuffer* instancingBuffer = renderer_->ResizeInstancingBuffer(totalInstances) ? renderer_->GetInstancingBuffer() : nullptr;
+    void* dest = instancingBuffer ? instancingBuffer->Lock(0, totalInstances, true) : nullptr;
     if (!dest)
+    {
+        DisableSkinnedInstancing();
         return;
+    }
+
+    unsigned freeIndex = 0;
 
     const unsigned stride = instancingBuffer->GetVertexSize();
+    skinMatrices_.Clear();
     for (HashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
-        i->second_.SetInstancingData(dest, stride, freeIndex);
+        i->second_.SetInstancingData(dest, stride, freeIndex, skinMatrices_);
 
     for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
     {
         for (unsigned j = 0; j < i->shadowSplits_.Size(); ++j)
-            i->shadowSplits_[j].shadowBatches_.SetInstancingData(dest, stride, freeIndex);
-        i->litBaseBatches_.SetInstancingData(dest, stride, freeIndex);
-        i->litBatches_.SetInstancingData(dest, stride, freeIndex);
+            i->shadowSplits_[j].shadowBatches_.SetInstancingData(dest, stride, freeIndex, skinMatrices_);
+        i->litBaseBatches_.SetInstancingData(dest, stride, freeIndex, skinMatrices_);
+        i->litBatches_.SetInstancingData(dest, stride, freeIndex, skinMatrices_);
     }
 
     instancingBuffer->Unlock();
+
+    if (skinMatrices_.Size() && !renderer_->UpdateSkinMatrixTexture(skinMatrices_))
+        DisableSkinnedInstancing();
+}
+
+void View::DisableSkinnedInstancing()
+{
+    for (HashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
+        i->second_.DisableSkinnedInstancing();
+
+    for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
+    {
+        for (unsigned j = 0; j < i->shadowSplits_.Size(); ++j)
+            i->shadowSplits_[j].shadowBatches_.DisableSkinnedInstancing();
+        i->litBaseBatches_.DisableSkinnedInstancing();
+        i->litBatches_.DisableSkinnedInstancing();
+    }
 }
 
 void View::SetupLightVolumeBatch(Batch& batch)
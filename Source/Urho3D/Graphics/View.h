@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Container/FramePODVector.h"
 #include "../Container/HashSet.h"
 #include "../Container/List.h"
 #include "../Core/Object.h"
@@ -38,11 +39,14 @@ class DebugRenderer;
 class Light;
 class Drawable;
 class Graphics;
+class LightClusters;
 class OcclusionBuffer;
 class Octree;
 class Renderer;
 class RenderPath;
 class RenderSurface;
+class SnapshotFrustumQuery;
+class TaskGraph;
 class Technique;
 class Texture;
 class Texture2D;
@@ -51,21 +55,77 @@ class Zone;
 struct RenderPathCommand;
 struct WorkItem;
 
+/// Shadow casters of one shadow split cached over frames.
+struct ShadowSplitCache
+{
+    /// Shadow camera view when the casters were culled.
+    Matrix3x4 shadowView_;
+    /// Shadow camera projection when the casters were culled.
+    Matrix4 shadowProjection_;
+    /// Culling camera view when the casters were culled.
+    Matrix3x4 cullView_;
+    /// Culling camera projection when the casters were culled.
+    Matrix4 cullProjection_;
+    /// Scene minimum Z value when the casters were culled.
+    float minZ_;
+    /// Scene maximum Z value when the casters were culled.
+    float maxZ_;
+    /// Shadow camera near split when the casters were culled (directional lights only).
+    float nearSplit_;
+    /// Shadow camera far split when the casters were culled (directional lights only).
+    float farSplit_;
+    /// World bounding box of the volume the casters were taken from. Changes within it invalidate the casters.
+    BoundingBox volume_;
+    /// Combined bounding box of the casters in light projection space.
+    BoundingBox casterBox_;
+    /// Shadow casters.
+    PODVector<Drawable*> casters_;
+    /// Valid flag.
+    bool valid_{};
+};
+
+/// Light volume query and shadow casters of a light cached over frames, so that static lights in a static scene skip the octree queries and the shadow caster culling.
+struct ShadowCasterCache
+{
+    /// Light, to detect a destroyed light whose address has been reused.
+    WeakPtr<Light> light_;
+    /// Frame number when last used.
+    unsigned frameNumber_{};
+    /// Light type when the light volume was queried.
+    LightType lightType_{};
+    /// Culling camera view mask when the light volume was queried.
+    unsigned viewMask_{};
+    /// Light world transform when the light volume was queried.
+    Matrix3x4 lightTransform_;
+    /// Light range, field of view and aspect ratio when the light volume was queried.
+    Vector3 lightShape_;
+    /// World bounding box of the light volume. Changes within it invalidate the light volume query.
+    BoundingBox lightVolume_;
+    /// Drawables inside the light volume (point and spot lights only).
+    PODVector<Drawable*> lightDrawables_;
+    /// Light volume query valid flag.
+    bool lightDrawablesValid_{};
+    /// Number of shadow splits when the casters were culled.
+    unsigned numSplits_{};
+    /// Shadow casters per split.
+    ShadowSplitCache splits_[MAX_LIGHT_SPLITS];
+};
+
 /// Intermediate light processing result.
 struct LightQueryResult
 {
     /// Light.
     Light* light_;
-    /// Lit geometries.
-    PODVector<Drawable*> litGeometries_;
-    /// Shadow casters.
-    PODVector<Drawable*> shadowCasters_;
+    /// Lit geometries. Taken from the frame arena of the thread which processes the light.
+    FramePODVector<Drawable*> litGeometries_;
+    /// Drawables inside the light volume, reused as shadow caster candidates for point and spot lights.
+    PODVector<Drawable*> lightDrawables_;
+    /// Shadow caster cache of the light, or null if caching is disabled. Used instead of the light volume query when valid.
+    ShadowCasterCache* shadowCache_;
+    /// Shadow casters per split. Filled by separate tasks so that splits are processed in parallel, each from its own thread's frame arena.
+    FramePODVector<Drawable*> shadowCasters_[MAX_LIGHT_SPLITS];
     /// Shadow cameras.
     Camera* shadowCameras_[MAX_LIGHT_SPLITS];
-    /// Shadow caster start indices.
-    unsigned shadowCasterBegin_[MAX_LIGHT_SPLITS];
-    /// Shadow caster end indices.
-    unsigned shadowCasterEnd_[MAX_LIGHT_SPLITS];
     /// Combined bounding box of shadow casters in light projection space. Only used for focused spot lights.
     BoundingBox shadowCasterBox_[MAX_LIGHT_SPLITS];
     /// Shadow camera near splits (directional lights only).
@@ -74,6 +134,8 @@ struct LightQueryResult
     float shadowFarSplits_[MAX_LIGHT_SPLITS];
     /// Shadow map split count.
     unsigned numSplits_;
+    /// Whether the light is shaded from the light clusters, so that it only lights geometries whose materials do not shade them.
+    bool clustered_;
 };
 
 /// Scene render pass info.
@@ -91,6 +153,65 @@ struct ScenePassInfo
     BatchQueue* batchQueue_;
 };
 
+/// Source batch state which a drawable's cached scene pass batches were built from.
+struct CachedSourceBatch
+{
+    /// Material.
+    Material* material_;
+    /// Geometry.
+    Geometry* geometry_;
+    /// Technique chosen for the material, which also reflects the material LOD.
+    Technique* technique_;
+    /// Geometry type.
+    GeometryType geometryType_;
+    /// Whether has world transforms.
+    bool hasTransforms_;
+};
+
+/// Scene pass batch of a drawable cached over frames.
+struct CachedSceneBatch
+{
+    /// Index of the source batch.
+    unsigned sourceIndex_;
+    /// Index of the scene pass.
+    unsigned scenePassIndex_;
+    /// Material pass.
+    Pass* pass_;
+    /// Allow instancing flag.
+    bool allowInstancing_;
+    /// Geometry type the shaders were chosen for, or MAX_GEOMETRYTYPES if not chosen yet.
+    GeometryType shadedGeometryType_;
+    /// Geometry type after choosing the shaders.
+    GeometryType geometryType_;
+    /// Vertex shader.
+    ShaderVariation* vertexShader_;
+    /// Pixel shader.
+    ShaderVariation* pixelShader_;
+    /// State sorting key.
+    unsigned long long sortKey_;
+};
+
+/// Scene pass batches of a drawable cached over frames, so that only drawables whose materials, geometries, LODs, zone or lights changed are sorted into the scene passes again.
+struct DrawableBatchCache
+{
+    /// Frame number when last used.
+    unsigned frameNumber_{};
+    /// Zone when the batches were built.
+    Zone* zone_{};
+    /// Zone light mask when the batches were built.
+    unsigned zoneLightMask_{};
+    /// Zone height fog flag when the batches were built.
+    bool heightFog_{};
+    /// Light mask when the batches were built.
+    unsigned lightMask_{};
+    /// Base pass flags when the batches were built.
+    unsigned basePassFlags_{};
+    /// Source batches.
+    PODVector<CachedSourceBatch> sourceBatches_;
+    /// Scene pass batches.
+    PODVector<CachedSceneBatch> sceneBatches_;
+};
+
 /// Per-thread geometry, light and scene range collection structure.
 struct PerThreadSceneResult
 {
@@ -109,8 +230,9 @@ static const unsigned MAX_VIEWPORT_TEXTURES = 2;
 /// Internal structure for 3D rendering work. Created for each backbuffer and texture viewport, but not for shadow cameras.
 class URHO3D_API View : public Object
 {
-    friend void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex);
+    friend void CheckVisibilityWork(View* view, Drawable** start, Drawable** end, unsigned threadIndex);
     friend void ProcessLightWork(const WorkItem* item, unsigned threadIndex);
+    friend void ProcessShadowSplitWork(const WorkItem* item, unsigned threadIndex);
 
     URHO3D_OBJECT(View, Object);
 
@@ -118,7 +240,7 @@ public:
     /// Construct.
     explicit View(Context* context);
     /// Destruct.
-    ~View() override = default;
+    ~View() override;
 
     /// Define with rendertarget and viewport. Return true if successful.
     bool Define(RenderSurface* renderTarget, Viewport* viewport);
@@ -147,6 +269,9 @@ public:
     /// Return information of the frame being rendered.
     const FrameInfo& GetFrameInfo() const { return frame_; }
 
+    /// Return the frame arena of a work queue thread index, or null if there is no frame allocator.
+    FrameArena* GetFrameArena(unsigned threadIndex = 0) const;
+
     /// Return the rendertarget. 0 if using the backbuffer.
     RenderSurface* GetRenderTarget() const { return renderTarget_; }
 
@@ -174,6 +299,9 @@ public:
     /// Return the last used software occlusion buffer.
     OcclusionBuffer* GetOcclusionBuffer() const { return occlusionBuffer_; }
 
+    /// Return the light clusters of the view, or null if the renderpath has no clustered light passes.
+    LightClusters* GetLightClusters() const;
+
     /// Return number of occluders that were actually rendered. Occluders may be rejected if running out of triangles or if behind other occluders.
     unsigned GetNumActiveOccluders() const { return activeOccluders_; }
 
@@ -202,10 +330,18 @@ private:
     void GetBatches();
     /// Get lit geometries and shadowcasters for visible lights.
     void ProcessLights();
+    /// Assign the clustered lights to the light clusters and update the cluster texture.
+    void BuildLightClusters();
     /// Get batches from lit geometries and shadowcasters.
     void GetLightBatches();
     /// Get unlit batches.
     void GetBaseBatches();
+    /// Return whether the cached scene pass batches of a drawable are still valid.
+    bool IsBatchCacheValid(Drawable* drawable, const DrawableBatchCache& cache);
+    /// Sort the batches of a drawable into the scene passes and cache the result.
+    void BuildBatchCache(Drawable* drawable, DrawableBatchCache& cache);
+    /// Add the cached scene pass batches of a drawable to the scene pass queues.
+    void AddCachedBatches(Drawable* drawable, DrawableBatchCache& cache);
     /// Update geometries and sort batches.
     void UpdateGeometries();
     /// Get pixel lit batches for a certain light and drawable.
@@ -234,10 +370,26 @@ private:
     void UpdateOccluders(PODVector<Drawable*>& occluders, Camera* camera);
     /// Draw occluders to occlusion buffer.
     void DrawOccluders(OcclusionBuffer* buffer, const PODVector<Drawable*>& occluders);
-    /// Query for lit geometries and shadow casters for a light.
+    /// Assign shadow caster caches to the light query results and invalidate the caches which scene changes affect.
+    void UpdateShadowCasterCaches();
+    /// Check a light against its shadow caster cache and return whether the cached light volume query can be used. Invalidates the cache if the light has changed.
+    bool IsLightVolumeCached(LightQueryResult& query);
+    /// Return whether the cached shadow casters of a light's shadow split can be used.
+    bool IsShadowSplitCached(LightQueryResult& query, unsigned splitIndex) const;
+    /// Return whether a light can be shaded from the light clusters: an unshadowed per-pixel point or spot light without custom textures, which lights all geometry.
+    bool IsClusteredLight(Light* light) const;
+    /// Return whether a material pass shades the clustered lights, as its shader includes the clustered lighting functions.
+    bool IsClusteredPass(Pass* pass);
+    /// Return whether a technique shades the clustered lights in one of the clustered scene passes.
+    bool IsClusteredTechnique(Technique* tech);
+    /// Find the visible geometries which need per-light batches for the clustered lights, because some of their lit materials do not shade the light clusters.
+    void GetUnclusteredGeometries();
+    /// Query for lit geometries and set up shadow cameras for a light.
     void ProcessLight(LightQueryResult& query, unsigned threadIndex);
+    /// Query for shadow casters of a light's shadow split. Does nothing if the light ended up with fewer splits.
+    void ProcessShadowSplit(LightQueryResult& query, unsigned splitIndex, unsigned threadIndex);
     /// Process shadow casters' visibilities and build their combined view- or projection-space bounding box.
-    void ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawable*>& drawables, unsigned splitIndex);
+    void ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawable*>& drawables, unsigned splitIndex, unsigned threadIndex);
     /// Set up initial shadow camera view(s).
     void SetupShadowCameras(LightQueryResult& query);
     /// Set up a directional light shadow camera.
@@ -263,8 +415,14 @@ private:
     void SetQueueShaderDefines(BatchQueue& queue, const RenderPathCommand& command);
     /// Choose shaders for a batch and add it to queue.
     void AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, bool allowInstancing = true, bool allowShadows = true);
+    /// Add a batch to an instancing group if it can be instanced. Return true if added.
+    bool AddBatchToGroup(BatchQueue& queue, Batch& batch, Technique* tech, bool allowInstancing, bool allowShadows);
+    /// Add a non-instanced batch with shaders chosen to a batch queue.
+    void PushBatch(BatchQueue& queue, Batch& batch);
     /// Prepare instancing buffer by filling it with all instance transforms.
     void PrepareInstancingBuffer();
+    /// Draw instanced skinned batch groups individually, when their instance data or skin matrices could not be uploaded.
+    void DisableSkinnedInstancing();
     /// Set up a light volume rendering batch.
     void SetupLightVolumeBatch(Batch& batch);
     /// Check whether a light queue needs shadow rendering.
@@ -380,12 +538,24 @@ private:
     bool hasScenePasses_{};
     /// Whether is using a custom readable depth texture without a stencil channel.
     bool noStencil_{};
+    /// Whether the renderpath has scene passes which shade clustered lights.
+    bool clusteredLights_{};
     /// Draw debug geometry flag. Copied from the viewport.
     bool drawDebug_{};
     /// Renderpath.
     RenderPath* renderPath_{};
     /// Per-thread octree query results.
     Vector<PODVector<Drawable*> > tempDrawables_;
+    /// Task graph for light processing and geometry update work.
+    UniquePtr<TaskGraph> taskGraph_;
+    /// Snapshot query started during the previous frame for pipelined rendering.
+    UniquePtr<SnapshotFrustumQuery> pipelinedQuery_;
+    /// Culling camera of the previous frame when pipelined.
+    WeakPtr<Camera> pipelinedCamera_;
+    /// Culling frustum of the previous frame when pipelined.
+    Frustum pipelinedFrustum_;
+    /// Culling camera view mask of the previous frame when pipelined.
+    unsigned pipelinedViewMask_{};
     /// Per-thread geometries, lights and Z range collection results.
     Vector<PerThreadSceneResult> sceneResults_;
     /// Visible zones.
@@ -409,14 +579,38 @@ private:
     HashMap<StringHash, Texture*> renderTargets_;
     /// Intermediate light processing results.
     Vector<LightQueryResult> lightQueryResults_;
+    /// Lights which are shaded from the light clusters instead of light queues.
+    PODVector<Light*> clusteredLightList_;
+    /// Indices of the scene passes which shade clustered lights.
+    PODVector<unsigned> clusteredPassIndices_;
+    /// Whether material passes shade the clustered lights, by pass. Cleared each frame, as shaders may be reloaded.
+    HashMap<Pass*, bool> clusteredPasses_;
+    /// Visible geometries that get per-light batches also from the clustered lights.
+    HashSet<Drawable*> unclusteredGeometries_;
+    /// Light clusters. Created when the renderpath first uses clustered lights.
+    SharedPtr<LightClusters> lightClusters_;
+    /// Shadow caster caches by light.
+    HashMap<Light*, ShadowCasterCache> shadowCasterCaches_;
+    /// Octree whose changes the shadow caster caches have seen.
+    WeakPtr<Octree> shadowCacheOctree_;
+    /// Octree update count when the shadow caster caches were last checked.
+    unsigned shadowCacheOctreeUpdates_{};
     /// Info for scene render passes defined by the renderpath.
     PODVector<ScenePassInfo> scenePasses_;
+    /// Scene pass batches cached over frames by drawable.
+    HashMap<Drawable*, DrawableBatchCache> batchCaches_;
+    /// Hash of the scene passes and shaders the cached scene pass batches were built with.
+    unsigned batchCacheHash_{};
     /// Per-pixel light queues.
     Vector<LightBatchQueue> lightQueues_;
     /// Per-vertex light queues.
     HashMap<unsigned long long, LightBatchQueue> vertexLightQueues_;
     /// Batch queues by pass index.
     HashMap<unsigned, BatchQueue> batchQueues_;
+    /// Skin matrices of instanced skinned models, gathered while filling the instancing buffer.
+    PODVector<Matrix3x4> skinMatrices_;
+    /// Number of skin matrices queued for instanced skinned batch groups this frame.
+    unsigned numInstancedSkinMatrices_{};
     /// Index of the GBuffer pass.
     unsigned gBufferPassIndex_{};
     /// Index of the opaque forward base pass.
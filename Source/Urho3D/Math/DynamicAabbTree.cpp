@@ -0,0 +1,428 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Math/DynamicAabbTree.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const float DEFAULT_RELATIVE_MARGIN = 0.5f;
+static const float DEFAULT_MARGIN = 0.1f;
+static const float DISPLACEMENT_PREDICTION = 2.0f;
+
+static inline float SurfaceArea(const BoundingBox& box)
+{
+    Vector3 size = box.Size();
+    return 2.0f * (size.x_ * size.y_ + size.y_ * size.z_ + size.z_ * size.x_);
+}
+
+static inline BoundingBox Union(const BoundingBox& lhs, const BoundingBox& rhs)
+{
+    BoundingBox ret(lhs);
+    ret.Merge(rhs);
+    return ret;
+}
+
+DynamicAabbTree::DynamicAabbTree() :
+    root_(NULL_AABB_NODE),
+    freeList_(NULL_AABB_NODE),
+    numProxies_(0),
+    relativeMargin_(DEFAULT_RELATIVE_MARGIN),
+    margin_(DEFAULT_MARGIN)
+{
+}
+
+unsigned DynamicAabbTree::CreateProxy(const BoundingBox& box, void* userData)
+{
+    unsigned proxy = AllocateNode();
+    Node& node = nodes_[proxy];
+    node.box_ = Fatten(box);
+    node.userData_ = userData;
+    node.height_ = 0;
+
+    InsertLeaf(proxy);
+    ++numProxies_;
+    return proxy;
+}
+
+void DynamicAabbTree::DestroyProxy(unsigned proxy)
+{
+    assert(proxy < nodes_.Size() && nodes_[proxy].IsLeaf() && nodes_[proxy].height_ == 0);
+
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    --numProxies_;
+}
+
+bool DynamicAabbTree::MoveProxy(unsigned proxy, const BoundingBox& box)
+{
+    assert(proxy < nodes_.Size() && nodes_[proxy].IsLeaf() && nodes_[proxy].height_ == 0);
+
+    if (Fits(proxy, box))
+        return false;
+
+    // Extend the new fattened box in the direction of movement, as the proxy is likely to keep moving that way
+    BoundingBox fatBox = Fatten(box);
+    Vector3 displacement = (box.Center() - nodes_[proxy].box_.Center()) * DISPLACEMENT_PREDICTION;
+    if (displacement.x_ < 0.0f)
+        fatBox.min_.x_ += displacement.x_;
+    else
+        fatBox.max_.x_ += displacement.x_;
+    if (displacement.y_ < 0.0f)
+        fatBox.min_.y_ += displacement.y_;
+    else
+        fatBox.max_.y_ += displacement.y_;
+    if (displacement.z_ < 0.0f)
+        fatBox.min_.z_ += displacement.z_;
+    else
+        fatBox.max_.z_ += displacement.z_;
+
+    RemoveLeaf(proxy);
+    nodes_[proxy].box_ = fatBox;
+    InsertLeaf(proxy);
+    return true;
+}
+
+void DynamicAabbTree::Clear()
+{
+    nodes_.Clear();
+    root_ = NULL_AABB_NODE;
+    freeList_ = NULL_AABB_NODE;
+    numProxies_ = 0;
+}
+
+void DynamicAabbTree::SetMargin(float relativeMargin, float margin)
+{
+    relativeMargin_ = Max(relativeMargin, 0.0f);
+    margin_ = Max(margin, 0.0f);
+}
+
+bool DynamicAabbTree::Validate() const
+{
+    if (root_ == NULL_AABB_NODE)
+        return numProxies_ == 0;
+
+    if (ValidateNode(root_, NULL_AABB_NODE) < 0)
+        return false;
+
+    // Every slot must be either in the tree or on the free list
+    unsigned numFree = 0;
+    for (unsigned index = freeList_; index != NULL_AABB_NODE; index = nodes_[index].parent_)
+    {
+        if (nodes_[index].height_ != -1)
+            return false;
+        ++numFree;
+    }
+
+    return numFree + 2 * numProxies_ - 1 == nodes_.Size();
+}
+
+unsigned DynamicAabbTree::AllocateNode()
+{
+    unsigned index;
+    if (freeList_ != NULL_AABB_NODE)
+    {
+        index = freeList_;
+        freeList_ = nodes_[index].parent_;
+    }
+    else
+    {
+        index = nodes_.Size();
+        nodes_.Resize(index + 1);
+    }
+
+    Node& node = nodes_[index];
+    node.box_.Clear();
+    node.userData_ = nullptr;
+    node.parent_ = NULL_AABB_NODE;
+    node.child1_ = NULL_AABB_NODE;
+    node.child2_ = NULL_AABB_NODE;
+    node.height_ = 0;
+    return index;
+}
+
+void DynamicAabbTree::FreeNode(unsigned index)
+{
+    Node& node = nodes_[index];
+    node.parent_ = freeList_;
+    node.height_ = -1;
+    freeList_ = index;
+}
+
+void DynamicAabbTree::InsertLeaf(unsigned leaf)
+{
+    if (root_ == NULL_AABB_NODE)
+    {
+        root_ = leaf;
+        nodes_[leaf].parent_ = NULL_AABB_NODE;
+        return;
+    }
+
+    // Descend towards the sibling whose union with the leaf costs least in surface area, accounting for the growth
+    // of the ancestors' boxes on the way
+    const BoundingBox leafBox = nodes_[leaf].box_;
+    unsigned index = root_;
+    while (!nodes_[index].IsLeaf())
+    {
+        const Node& node = nodes_[index];
+        const float area = SurfaceArea(node.box_);
+        const float combinedArea = SurfaceArea(Union(node.box_, leafBox));
+
+        // Cost of making a new parent for this node and the leaf
+        const float cost = 2.0f * combinedArea;
+        // Minimum cost of pushing the leaf further down
+        const float inheritanceCost = 2.0f * (combinedArea - area);
+
+        const Node& child1 = nodes_[node.child1_];
+        float cost1 = SurfaceArea(Union(child1.box_, leafBox)) + inheritanceCost;
+        if (!child1.IsLeaf())
+            cost1 -= SurfaceArea(child1.box_);
+
+        const Node& child2 = nodes_[node.child2_];
+        float cost2 = SurfaceArea(Union(child2.box_, leafBox)) + inheritanceCost;
+        if (!child2.IsLeaf())
+            cost2 -= SurfaceArea(child2.box_);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+
+        index = cost1 < cost2 ? node.child1_ : node.child2_;
+    }
+
+    const unsigned sibling = index;
+    const unsigned oldParent = nodes_[sibling].parent_;
+    const unsigned newParent = AllocateNode();
+    Node& parentNode = nodes_[newParent];
+    parentNode.parent_ = oldParent;
+    parentNode.box_ = Union(leafBox, nodes_[sibling].box_);
+    parentNode.height_ = nodes_[sibling].height_ + 1;
+    parentNode.child1_ = sibling;
+    parentNode.child2_ = leaf;
+    nodes_[sibling].parent_ = newParent;
+    nodes_[leaf].parent_ = newParent;
+
+    if (oldParent != NULL_AABB_NODE)
+    {
+        if (nodes_[oldParent].child1_ == sibling)
+            nodes_[oldParent].child1_ = newParent;
+        else
+            nodes_[oldParent].child2_ = newParent;
+    }
+    else
+        root_ = newParent;
+
+    RefitAncestors(newParent);
+}
+
+void DynamicAabbTree::RemoveLeaf(unsigned leaf)
+{
+    if (leaf == root_)
+    {
+        root_ = NULL_AABB_NODE;
+        return;
+    }
+
+    const unsigned parent = nodes_[leaf].parent_;
+    const unsigned grandParent = nodes_[parent].parent_;
+    const unsigned sibling = nodes_[parent].child1_ == leaf ? nodes_[parent].child2_ : nodes_[parent].child1_;
+
+    // Replace the parent with the sibling
+    if (grandParent != NULL_AABB_NODE)
+    {
+        if (nodes_[grandParent].child1_ == parent)
+            nodes_[grandParent].child1_ = sibling;
+        else
+            nodes_[grandParent].child2_ = sibling;
+        nodes_[sibling].parent_ = grandParent;
+        FreeNode(parent);
+        RefitAncestors(grandParent);
+    }
+    else
+    {
+        root_ = sibling;
+        nodes_[sibling].parent_ = NULL_AABB_NODE;
+        FreeNode(parent);
+    }
+}
+
+void DynamicAabbTree::RefitAncestors(unsigned index)
+{
+    while (index != NULL_AABB_NODE)
+    {
+        index = Balance(index);
+
+        Node& node = nodes_[index];
+        const Node& child1 = nodes_[node.child1_];
+        const Node& child2 = nodes_[node.child2_];
+        node.height_ = 1 + Max(child1.height_, child2.height_);
+        node.box_ = Union(child1.box_, child2.box_);
+
+        index = node.parent_;
+    }
+}
+
+unsigned DynamicAabbTree::Balance(unsigned iA)
+{
+    Node& a = nodes_[iA];
+    if (a.IsLeaf() || a.height_ < 2)
+        return iA;
+
+    const unsigned iB = a.child1_;
+    const unsigned iC = a.child2_;
+    Node& b = nodes_[iB];
+    Node& c = nodes_[iC];
+    const int balance = c.height_ - b.height_;
+
+    // Rotate C up
+    if (balance > 1)
+    {
+        const unsigned iF = c.child1_;
+        const unsigned iG = c.child2_;
+        Node& f = nodes_[iF];
+        Node& g = nodes_[iG];
+
+        // Swap A and C
+        c.child1_ = iA;
+        c.parent_ = a.parent_;
+        a.parent_ = iC;
+
+        // A's old parent should point to C
+        if (c.parent_ != NULL_AABB_NODE)
+        {
+            if (nodes_[c.parent_].child1_ == iA)
+                nodes_[c.parent_].child1_ = iC;
+            else
+                nodes_[c.parent_].child2_ = iC;
+        }
+        else
+            root_ = iC;
+
+        // Keep the higher grandchild under C
+        if (f.height_ > g.height_)
+        {
+            c.child2_ = iF;
+            a.child2_ = iG;
+            g.parent_ = iA;
+            a.box_ = Union(b.box_, g.box_);
+            c.box_ = Union(a.box_, f.box_);
+            a.height_ = 1 + Max(b.height_, g.height_);
+            c.height_ = 1 + Max(a.height_, f.height_);
+        }
+        else
+        {
+            c.child2_ = iG;
+            a.child2_ = iF;
+            f.parent_ = iA;
+            a.box_ = Union(b.box_, f.box_);
+            c.box_ = Union(a.box_, g.box_);
+            a.height_ = 1 + Max(b.height_, f.height_);
+            c.height_ = 1 + Max(a.height_, g.height_);
+        }
+
+        return iC;
+    }
+
+    // Rotate B up
+    if (balance < -1)
+    {
+        const unsigned iD = b.child1_;
+        const unsigned iE = b.child2_;
+        Node& d = nodes_[iD];
+        Node& e = nodes_[iE];
+
+        // Swap A and B
+        b.child1_ = iA;
+        b.parent_ = a.parent_;
+        a.parent_ = iB;
+
+        // A's old parent should point to B
+        if (b.parent_ != NULL_AABB_NODE)
+        {
+            if (nodes_[b.parent_].child1_ == iA)
+                nodes_[b.parent_].child1_ = iB;
+            else
+                nodes_[b.parent_].child2_ = iB;
+        }
+        else
+            root_ = iB;
+
+        // Keep the higher grandchild under B
+        if (d.height_ > e.height_)
+        {
+            b.child2_ = iD;
+            a.child1_ = iE;
+            e.parent_ = iA;
+            a.box_ = Union(c.box_, e.box_);
+            b.box_ = Union(a.box_, d.box_);
+            a.height_ = 1 + Max(c.height_, e.height_);
+            b.height_ = 1 + Max(a.height_, d.height_);
+        }
+        else
+        {
+            b.child2_ = iE;
+            a.child1_ = iD;
+            d.parent_ = iA;
+            a.box_ = Union(c.box_, d.box_);
+            b.box_ = Union(a.box_, e.box_);
+            a.height_ = 1 + Max(c.height_, d.height_);
+            b.height_ = 1 + Max(a.height_, e.height_);
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
+
+BoundingBox DynamicAabbTree::Fatten(const BoundingBox& box) const
+{
+    Vector3 margin = box.Size() * relativeMargin_ + Vector3(margin_, margin_, margin_);
+    return BoundingBox(box.min_ - margin, box.max_ + margin);
+}
+
+int DynamicAabbTree::ValidateNode(unsigned index, unsigned parent) const
+{
+    const Node& node = nodes_[index];
+    if (node.parent_ != parent || node.height_ < 0)
+        return -1;
+
+    if (node.IsLeaf())
+        return node.child2_ == NULL_AABB_NODE && node.height_ == 0 ? 0 : -1;
+
+    const int height1 = ValidateNode(node.child1_, index);
+    const int height2 = ValidateNode(node.child2_, index);
+    if (height1 < 0 || height2 < 0 || node.height_ != 1 + Max(height1, height2))
+        return -1;
+
+    const BoundingBox& box1 = nodes_[node.child1_].box_;
+    const BoundingBox& box2 = nodes_[node.child2_].box_;
+    if (node.box_.IsInside(box1) != INSIDE || node.box_.IsInside(box2) != INSIDE)
+        return -1;
+
+    return node.height_;
+}
+
+}
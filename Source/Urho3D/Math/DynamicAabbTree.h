@@ -0,0 +1,161 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Math/BoundingBox.h"
+
+#include <cassert>
+
+namespace Urho3D
+{
+
+/// Null node index of a dynamic AABB tree.
+static const unsigned NULL_AABB_NODE = M_MAX_UNSIGNED;
+
+/// Dynamic bounding volume hierarchy of axis-aligned boxes. Each proxy is a leaf holding a fattened copy of its box, so that a proxy which moves a little does not need to be reinserted. Internal nodes are kept balanced by tree rotations.
+class URHO3D_API DynamicAabbTree
+{
+public:
+    /// Tree node.
+    struct Node
+    {
+        /// Return whether is a leaf.
+        bool IsLeaf() const { return child1_ == NULL_AABB_NODE; }
+
+        /// Fattened box of a leaf, or the union of the children's boxes.
+        BoundingBox box_;
+        /// User data of a leaf.
+        void* userData_;
+        /// Parent node index, or next free node index when on the free list.
+        unsigned parent_;
+        /// First child node index.
+        unsigned child1_;
+        /// Second child node index.
+        unsigned child2_;
+        /// Height of the subtree: 0 for a leaf, -1 for a free node.
+        int height_;
+    };
+
+    /// Construct empty.
+    DynamicAabbTree();
+
+    /// Create a proxy for a box and return its index.
+    unsigned CreateProxy(const BoundingBox& box, void* userData);
+    /// Destroy a proxy.
+    void DestroyProxy(unsigned proxy);
+    /// Update a proxy's box. Return true if it no longer fitted its fattened box and was reinserted.
+    bool MoveProxy(unsigned proxy, const BoundingBox& box);
+    /// Remove all proxies.
+    void Clear();
+    /// Set the margin added to each side of a proxy's box, relative to the box size and in world units.
+    void SetMargin(float relativeMargin, float margin);
+
+    /// Return whether a box still fits a proxy's fattened box, so that moving the proxy to it needs no reinsertion. Safe to call from worker threads while the tree is not modified.
+    bool Fits(unsigned proxy, const BoundingBox& box) const { return nodes_[proxy].box_.IsInside(box) == INSIDE; }
+    /// Return a proxy's fattened box.
+    const BoundingBox& GetFatBox(unsigned proxy) const { return nodes_[proxy].box_; }
+    /// Return a proxy's user data.
+    void* GetUserData(unsigned proxy) const { return nodes_[proxy].userData_; }
+    /// Return root node index, or NULL_AABB_NODE if empty.
+    unsigned GetRoot() const { return root_; }
+    /// Return a node.
+    const Node& GetNode(unsigned index) const { return nodes_[index]; }
+    /// Return number of allocated node slots, including free ones.
+    unsigned GetNumNodeSlots() const { return nodes_.Size(); }
+    /// Return number of proxies.
+    unsigned GetNumProxies() const { return numProxies_; }
+    /// Return height of the tree.
+    unsigned GetHeight() const { return root_ != NULL_AABB_NODE ? (unsigned)nodes_[root_].height_ : 0; }
+    /// Check the links, heights and boxes of the whole tree. Return true if valid.
+    bool Validate() const;
+
+    /// Traverse the tree. The node test is called as nodeTest(const BoundingBox& box, bool inside) for each internal node reached, with inside true if an ancestor was fully inside, and returns OUTSIDE to skip the subtree, INSIDE if it is fully inside, or INTERSECTS. The leaf function is called as leafFunc(unsigned proxy, bool inside) for each leaf reached.
+    template <class NodeTest, class LeafFunc> void Traverse(NodeTest& nodeTest, LeafFunc& leafFunc) const
+    {
+        if (root_ == NULL_AABB_NODE)
+            return;
+
+        // Balanced tree height stays far below this, and a node is pushed only after popping its parent
+        static const unsigned MAX_STACK_SIZE = 256;
+        unsigned stack[MAX_STACK_SIZE];
+        unsigned stackSize = 0;
+        stack[stackSize++] = root_ << 1u;
+
+        while (stackSize)
+        {
+            const unsigned entry = stack[--stackSize];
+            const unsigned index = entry >> 1u;
+            bool inside = (entry & 1u) != 0;
+            const Node& node = nodes_[index];
+
+            if (node.IsLeaf())
+            {
+                leafFunc(index, inside);
+                continue;
+            }
+
+            Intersection res = nodeTest(node.box_, inside);
+            if (res == OUTSIDE)
+                continue;
+            inside = res == INSIDE;
+
+            assert(stackSize + 2 <= MAX_STACK_SIZE);
+            stack[stackSize++] = node.child2_ << 1u | (unsigned)inside;
+            stack[stackSize++] = node.child1_ << 1u | (unsigned)inside;
+        }
+    }
+
+private:
+    /// Allocate a node from the free list.
+    unsigned AllocateNode();
+    /// Return a node to the free list.
+    void FreeNode(unsigned index);
+    /// Insert a leaf next to the sibling which increases the surface area least.
+    void InsertLeaf(unsigned leaf);
+    /// Remove a leaf and its parent.
+    void RemoveLeaf(unsigned leaf);
+    /// Refit boxes and heights from a node up to the root, rebalancing on the way.
+    void RefitAncestors(unsigned index);
+    /// Rotate a subtree if it is unbalanced. Return the index of the node now at its place.
+    unsigned Balance(unsigned index);
+    /// Return a fattened copy of a box.
+    BoundingBox Fatten(const BoundingBox& box) const;
+    /// Validate a subtree recursively. Return its height, or -1 if invalid.
+    int ValidateNode(unsigned index, unsigned parent) const;
+
+    /// Nodes, including free ones.
+    PODVector<Node> nodes_;
+    /// Root node index.
+    unsigned root_;
+    /// First free node index.
+    unsigned freeList_;
+    /// Number of proxies.
+    unsigned numProxies_;
+    /// Margin relative to box size.
+    float relativeMargin_;
+    /// Margin in world units.
+    float margin_;
+};
+
+}
@@ -27,6 +27,10 @@
 namespace Urho3D
 {
 
+class Node;
+class PhysicsWorld;
+class RigidBody;
+
 /// Physics world is about to be stepped.
 URHO3D_EVENT(E_PHYSICSPRESTEP, PhysicsPreStep)
 {
@@ -65,6 +69,30 @@ URHO3D_EVENT(E_PHYSICSCOLLISION, PhysicsCollision)
     URHO3D_PARAM(P_CONTACTS, Contacts);            // Buffer containing position (Vector3), normal (Vector3), distance (float), impulse (float) for each contact
 }
 
+/// Typed payload of E_PHYSICSCOLLISION.
+struct URHO3D_API PhysicsCollisionEvent
+{
+    /// Return event type.
+    static StringHash GetEventTypeStatic() { return E_PHYSICSCOLLISION; }
+    /// Fill parameters for VariantMap handlers.
+    void ToVariantMap(VariantMap& eventData) const;
+
+    /// Physics world.
+    PhysicsWorld* world_;
+    /// First node.
+    Node* nodeA_;
+    /// Second node.
+    Node* nodeB_;
+    /// First rigid body.
+    RigidBody* bodyA_;
+    /// Second rigid body.
+    RigidBody* bodyB_;
+    /// Whether either body is a trigger.
+    bool trigger_;
+    /// Contact data in the same layout as the P_CONTACTS buffer. Valid only during the handler. Null when the payload fills the parameters of E_PHYSICSCOLLISIONEND.
+    const PODVector<unsigned char>* contacts_;
+};
+
 /// Physics collision ended. Global event sent by the PhysicsWorld.
 URHO3D_EVENT(E_PHYSICSCOLLISIONEND, PhysicsCollisionEnd)
 {
@@ -96,6 +124,26 @@ URHO3D_EVENT(E_NODECOLLISION, NodeCollision)
     URHO3D_PARAM(P_CONTACTS, Contacts);            // Buffer containing position (Vector3), normal (Vector3), distance (float), impulse (float) for each contact
 }
 
+/// Typed payload of E_NODECOLLISION. Sent by the node, so subscribe with the node as the sender.
+struct URHO3D_API NodeCollisionEvent
+{
+    /// Return event type.
+    static StringHash GetEventTypeStatic() { return E_NODECOLLISION; }
+    /// Fill parameters for VariantMap handlers.
+    void ToVariantMap(VariantMap& eventData) const;
+
+    /// Rigid body of the sending node.
+    RigidBody* body_;
+    /// Other node.
+    Node* otherNode_;
+    /// Other rigid body.
+    RigidBody* otherBody_;
+    /// Whether either body is a trigger.
+    bool trigger_;
+    /// Contact data in the same layout as the P_CONTACTS buffer, with normals facing the sending node. Valid only during the handler. Null when the payload fills the parameters of E_NODECOLLISIONEND.
+    const PODVector<unsigned char>* contacts_;
+};
+
 /// Node's physics collision ended. Sent by scene nodes participating in a collision.
 URHO3D_EVENT(E_NODECOLLISIONEND, NodeCollisionEnd)
 {
@@ -799,6 +799,11 @@ void PhysicsWorld::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap&
 
 void PhysicsWorld::PreStep(float timeStep)
 {
+    // Update fixed timestep logic, unless another physics world of the scene drives it
+    Scene* scene = GetScene();
+    if (scene && GetFixedUpdateSource() == this)
+        scene->UpdateLogicComponents(LOGIC_FIXEDUPDATE, timeStep);
+
     // Send pre-step event
     using namespace PhysicsPreStep;
 
@@ -825,6 +830,10 @@ void PhysicsWorld::PostStep(float timeStep)
 
     SendCollisionEvents();
 
+    Scene* scene = GetScene();
+    if (scene && GetFixedUpdateSource() == this)
+        scene->UpdateLogicComponents(LOGIC_FIXEDPOSTUPDATE, timeStep);
+
     // Send post-step event
     using namespace PhysicsPostStep;
 
@@ -834,20 +843,38 @@ void PhysicsWorld::PostStep(float timeStep)
     SendEvent(E_PHYSICSPOSTSTEP, eventData);
 }
 
+void PhysicsCollisionEvent::ToVariantMap(VariantMap& eventData) const
+{
+    eventData[PhysicsCollision::P_WORLD] = world_;
+    eventData[PhysicsCollision::P_NODEA] = nodeA_;
+    eventData[PhysicsCollision::P_NODEB] = nodeB_;
+    eventData[PhysicsCollision::P_BODYA] = bodyA_;
+    eventData[PhysicsCollision::P_BODYB] = bodyB_;
+    eventData[PhysicsCollision::P_TRIGGER] = trigger_;
+    if (contacts_)
+        eventData[PhysicsCollision::P_CONTACTS] = *contacts_;
+}
+
+void NodeCollisionEvent::ToVariantMap(VariantMap& eventData) const
+{
+    eventData[NodeCollision::P_BODY] = body_;
+    eventData[NodeCollision::P_OTHERNODE] = otherNode_;
+    eventData[NodeCollision::P_OTHERBODY] = otherBody_;
+    eventData[NodeCollision::P_TRIGGER] = trigger_;
+    if (contacts_)
+        eventData[NodeCollision::P_CONTACTS] = *contacts_;
+}
+
 void PhysicsWorld::SendCollisionEvents()
 {
     URHO3D_PROFILE(SendCollisionEvents);
 
     currentCollisions_.Clear();
-    physicsCollisionData_.Clear();
-    nodeCollisionData_.Clear();
 
     int numManifolds = collisionDispatcher_->getNumManifolds();
 
     if (numManifolds)
     {
-        physicsCollisionData_[PhysicsCollision::P_WORLD] = this;
-
         for (int i = 0; i < numManifolds; ++i)
         {
             btPersistentManifold* contactManifold = collisionDispatcher_->getManifoldByIndexInternal(i);
@@ -907,12 +934,6 @@ void PhysicsWorld::SendCollisionEvents()
             bool trigger = bodyA->IsTrigger() || bodyB->IsTrigger();
             bool newCollision = !previousCollisions_.Contains(i->first_);
 
-            physicsCollisionData_[PhysicsCollision::P_NODEA] = nodeA;
-            physicsCollisionData_[PhysicsCollision::P_NODEB] = nodeB;
-            physicsCollisionData_[PhysicsCollision::P_BODYA] = bodyA;
-            physicsCollisionData_[PhysicsCollision::P_BODYB] = bodyB;
-            physicsCollisionData_[PhysicsCollision::P_TRIGGER] = trigger;
-
             contacts_.Clear();
 
             // "Pointers not flipped"-manifold, send unmodified normals
@@ -942,36 +963,31 @@ void PhysicsWorld::SendCollisionEvents()
                 }
             }
 
-            physicsCollisionData_[PhysicsCollision::P_CONTACTS] = contacts_.GetBuffer();
-
-            // Send separate collision start event if collision is new
+            // Send separate collision start event if collision is new. The start events have the parameters of the ongoing
+            // collision events and are filled from the same payloads only if they have subscribers
+            PhysicsCollisionEvent collisionEvent{this, nodeA, nodeB, bodyA, bodyB, trigger, &contacts_.GetBuffer()};
             if (newCollision)
             {
-                SendEvent(E_PHYSICSCOLLISIONSTART, physicsCollisionData_);
+                SendEventFromPayload(E_PHYSICSCOLLISIONSTART, collisionEvent);
                 // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
                 if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                     continue;
             }
 
             // Then send the ongoing collision event
-            SendEvent(E_PHYSICSCOLLISION, physicsCollisionData_);
+            SendTypedEvent(collisionEvent);
             if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                 continue;
 
-            nodeCollisionData_[NodeCollision::P_BODY] = bodyA;
-            nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeB;
-            nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyB;
-            nodeCollisionData_[NodeCollision::P_TRIGGER] = trigger;
-            nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
-
+            NodeCollisionEvent nodeCollisionEventA{bodyA, nodeB, bodyB, trigger, &contacts_.GetBuffer()};
             if (newCollision)
             {
-                nodeA->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
+                nodeA->SendEventFromPayload(E_NODECOLLISIONSTART, nodeCollisionEventA);
                 if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                     continue;
             }
 
-            nodeA->SendEvent(E_NODECOLLISION, nodeCollisionData_);
+            nodeA->SendTypedEvent(nodeCollisionEventA);
             if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                 continue;
 
@@ -1002,26 +1018,20 @@ void PhysicsWorld::SendCollisionEvents()
                 }
             }
 
-            nodeCollisionData_[NodeCollision::P_BODY] = bodyB;
-            nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeA;
-            nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyA;
-            nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
-
+            NodeCollisionEvent nodeCollisionEventB{bodyB, nodeA, bodyA, trigger, &contacts_.GetBuffer()};
             if (newCollision)
             {
-                nodeB->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
+                nodeB->SendEventFromPayload(E_NODECOLLISIONSTART, nodeCollisionEventB);
                 if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                     continue;
             }
 
-            nodeB->SendEvent(E_NODECOLLISION, nodeCollisionData_);
+            nodeB->SendTypedEvent(nodeCollisionEventB);
         }
     }
 
-    // Send collision end events as applicable
+    // Send collision end events as applicable. They have the parameters of the ongoing collision events without the contacts
     {
-        physicsCollisionData_[PhysicsCollisionEnd::P_WORLD] = this;
-
         for (HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair>::Iterator
                  i = previousCollisions_.Begin(); i != previousCollisions_.End(); ++i)
         {
@@ -1048,31 +1058,16 @@ void PhysicsWorld::SendCollisionEvents()
                 WeakPtr<Node> nodeWeakA(nodeA);
                 WeakPtr<Node> nodeWeakB(nodeB);
 
-                physicsCollisionData_[PhysicsCollisionEnd::P_BODYA] = bodyA;
-                physicsCollisionData_[PhysicsCollisionEnd::P_BODYB] = bodyB;
-                physicsCollisionData_[PhysicsCollisionEnd::P_NODEA] = nodeA;
-                physicsCollisionData_[PhysicsCollisionEnd::P_NODEB] = nodeB;
-                physicsCollisionData_[PhysicsCollisionEnd::P_TRIGGER] = trigger;
-
-                SendEvent(E_PHYSICSCOLLISIONEND, physicsCollisionData_);
+                SendEventFromPayload(E_PHYSICSCOLLISIONEND, PhysicsCollisionEvent{this, nodeA, nodeB, bodyA, bodyB, trigger, nullptr});
                 // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
                 if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                     continue;
 
-                nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyA;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeB;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyB;
-                nodeCollisionData_[NodeCollisionEnd::P_TRIGGER] = trigger;
-
-                nodeA->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
+                nodeA->SendEventFromPayload(E_NODECOLLISIONEND, NodeCollisionEvent{bodyA, nodeB, bodyB, trigger, nullptr});
                 if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                     continue;
 
-                nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyB;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeA;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyA;
-
-                nodeB->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
+                nodeB->SendEventFromPayload(E_NODECOLLISIONEND, NodeCollisionEvent{bodyB, nodeA, bodyA, trigger, nullptr});
             }
         }
     }
@@ -347,10 +347,6 @@ private:
     CollisionGeometryDataCache convexCache_;
     /// Cache for GImpact trimesh geometry data by model and LOD level.
     CollisionGeometryDataCache gimpactTrimeshCache_;
-    /// Preallocated event data map for physics collision events.
-    VariantMap physicsCollisionData_;
-    /// Preallocated event data map for node collision events.
-    VariantMap nodeCollisionData_;
     /// Preallocated buffer for physics collision contact data.
     VectorBuffer contacts_;
     /// Simulation substeps per second.
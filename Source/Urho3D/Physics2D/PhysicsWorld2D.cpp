@@ -280,6 +280,12 @@ void PhysicsWorld2D::Update(float timeStep)
 {
     URHO3D_PROFILE(UpdatePhysics2D);
 
+    // Update fixed timestep logic, unless another physics world of the scene drives it
+    Scene* scene = GetScene();
+    const bool updateLogic = scene && GetFixedUpdateSource() == this;
+    if (updateLogic)
+        scene->UpdateLogicComponents(LOGIC_FIXEDUPDATE, timeStep);
+
     using namespace PhysicsPreStep;
 
     VariantMap& eventData = GetEventDataMap();
@@ -328,6 +334,15 @@ void PhysicsWorld2D::Update(float timeStep)
     SendBeginContactEvents();
     SendEndContactEvents();
 
+    if (updateLogic)
+    {
+        scene->UpdateLogicComponents(LOGIC_FIXEDPOSTUPDATE, timeStep);
+
+        // The event data map may have been reused by events sent from the logic components
+        eventData[P_WORLD] = this;
+        eventData[P_TIMESTEP] = timeStep;
+    }
+
     using namespace PhysicsPostStep;
     SendEvent(E_PHYSICSPOSTSTEP, eventData);
 }
@@ -23,12 +23,8 @@
 #include "../Precompiled.h"
 
 #include "../IO/Log.h"
-#if defined(URHO3D_PHYSICS) || defined(URHO3D_PHYSICS2D)
-#include "../Physics/PhysicsEvents.h"
-#endif
 #include "../Scene/LogicComponent.h"
 #include "../Scene/Scene.h"
-#include "../Scene/SceneEvents.h"
 
 namespace Urho3D
 {
@@ -37,8 +33,15 @@ LogicComponent::LogicComponent(Context* context) :
     Component(context),
     updateEventMask_(USE_UPDATE | USE_POSTUPDATE | USE_FIXEDUPDATE | USE_FIXEDPOSTUPDATE),
     currentEventMask_(0),
-    delayedStartCalled_(false)
+    delayedStartCalled_(false),
+    threadSafeUpdate_(false),
+    updateScene_(nullptr)
 {
+    for (unsigned i = 0; i < MAX_LOGIC_UPDATE_PHASES; ++i)
+    {
+        updateGroups_[i] = M_MAX_UNSIGNED;
+        updateIndices_[i] = M_MAX_UNSIGNED;
+    }
 }
 
 LogicComponent::~LogicComponent() = default;
@@ -73,6 +76,20 @@ void LogicComponent::SetUpdateEventMask(UpdateEventFlags mask)
     }
 }
 
+void LogicComponent::SetThreadSafeUpdate(bool enable)
+{
+    if (enable == threadSafeUpdate_)
+        return;
+
+    // Move to the group matching the new threading mode
+    const UpdateEventFlags variableMask = currentEventMask_ & (USE_UPDATE | USE_POSTUPDATE);
+    SetUpdatePhase(LOGIC_UPDATE, USE_UPDATE, false);
+    SetUpdatePhase(LOGIC_POSTUPDATE, USE_POSTUPDATE, false);
+    threadSafeUpdate_ = enable;
+    SetUpdatePhase(LOGIC_UPDATE, USE_UPDATE, variableMask & USE_UPDATE);
+    SetUpdatePhase(LOGIC_POSTUPDATE, USE_POSTUPDATE, variableMask & USE_POSTUPDATE);
+}
+
 void LogicComponent::OnNodeSet(Node* node)
 {
     if (node)
@@ -90,138 +107,112 @@ void LogicComponent::OnNodeSet(Node* node)
 void LogicComponent::OnSceneSet(Scene* scene)
 {
     if (scene)
+    {
+        if (scene != updateScene_)
+        {
+            SetUpdatePhase(LOGIC_UPDATE, USE_UPDATE, false);
+            SetUpdatePhase(LOGIC_POSTUPDATE, USE_POSTUPDATE, false);
+            SetUpdatePhase(LOGIC_FIXEDUPDATE, USE_FIXEDUPDATE, false);
+            SetUpdatePhase(LOGIC_FIXEDPOSTUPDATE, USE_FIXEDPOSTUPDATE, false);
+            updateScene_ = scene;
+        }
         UpdateEventSubscription();
+    }
     else
     {
-        UnsubscribeFromEvent(E_SCENEUPDATE);
-        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
-#if defined(URHO3D_PHYSICS) || defined(URHO3D_PHYSICS2D)
-        UnsubscribeFromEvent(E_PHYSICSPRESTEP);
-        UnsubscribeFromEvent(E_PHYSICSPOSTSTEP);
-#endif
-        currentEventMask_ = USE_NO_EVENT;
+        SetUpdatePhase(LOGIC_UPDATE, USE_UPDATE, false);
+        SetUpdatePhase(LOGIC_POSTUPDATE, USE_POSTUPDATE, false);
+        SetUpdatePhase(LOGIC_FIXEDUPDATE, USE_FIXEDUPDATE, false);
+        SetUpdatePhase(LOGIC_FIXEDPOSTUPDATE, USE_FIXEDPOSTUPDATE, false);
+        updateScene_ = nullptr;
     }
 }
 
 void LogicComponent::UpdateEventSubscription()
 {
-    Scene* scene = GetScene();
-    if (!scene)
+    if (!updateScene_)
         return;
 
     bool enabled = IsEnabledEffective();
 
     bool needUpdate = enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_);
-    if (needUpdate && !(currentEventMask_ & USE_UPDATE))
-    {
-        SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_HANDLER(LogicComponent, HandleSceneUpdate));
-        currentEventMask_ |= USE_UPDATE;
-    }
-    else if (!needUpdate && (currentEventMask_ & USE_UPDATE))
-    {
-        UnsubscribeFromEvent(scene, E_SCENEUPDATE);
-        currentEventMask_ &= ~USE_UPDATE;
-    }
+    SetUpdatePhase(LOGIC_UPDATE, USE_UPDATE, needUpdate);
 
     bool needPostUpdate = enabled && (updateEventMask_ & USE_POSTUPDATE);
-    if (needPostUpdate && !(currentEventMask_ & USE_POSTUPDATE))
-    {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(LogicComponent, HandleScenePostUpdate));
-        currentEventMask_ |= USE_POSTUPDATE;
-    }
-    else if (!needPostUpdate && (currentEventMask_ & USE_POSTUPDATE))
-    {
-        UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
-        currentEventMask_ &= ~USE_POSTUPDATE;
-    }
-
-#if defined(URHO3D_PHYSICS) || defined(URHO3D_PHYSICS2D)
-    Component* world = GetFixedUpdateSource();
-    if (!world)
-        return;
+    SetUpdatePhase(LOGIC_POSTUPDATE, USE_POSTUPDATE, needPostUpdate);
 
+    // The fixed timestep lists are run by the scene's physics world, if there is one
     bool needFixedUpdate = enabled && (updateEventMask_ & USE_FIXEDUPDATE);
-    if (needFixedUpdate && !(currentEventMask_ & USE_FIXEDUPDATE))
-    {
-        SubscribeToEvent(world, E_PHYSICSPRESTEP, URHO3D_HANDLER(LogicComponent, HandlePhysicsPreStep));
-        currentEventMask_ |= USE_FIXEDUPDATE;
-    }
-    else if (!needFixedUpdate && (currentEventMask_ & USE_FIXEDUPDATE))
-    {
-        UnsubscribeFromEvent(world, E_PHYSICSPRESTEP);
-        currentEventMask_ &= ~USE_FIXEDUPDATE;
-    }
+    SetUpdatePhase(LOGIC_FIXEDUPDATE, USE_FIXEDUPDATE, needFixedUpdate);
 
     bool needFixedPostUpdate = enabled && (updateEventMask_ & USE_FIXEDPOSTUPDATE);
-    if (needFixedPostUpdate && !(currentEventMask_ & USE_FIXEDPOSTUPDATE))
+    SetUpdatePhase(LOGIC_FIXEDPOSTUPDATE, USE_FIXEDPOSTUPDATE, needFixedPostUpdate);
+}
+
+void LogicComponent::SetUpdatePhase(LogicUpdatePhase phase, UpdateEvent flag, bool enable)
+{
+    if (enable && !(currentEventMask_ & flag))
     {
-        SubscribeToEvent(world, E_PHYSICSPOSTSTEP, URHO3D_HANDLER(LogicComponent, HandlePhysicsPostStep));
-        currentEventMask_ |= USE_FIXEDPOSTUPDATE;
+        if (updateScene_)
+        {
+            updateScene_->AddLogicComponent(this, phase);
+            currentEventMask_ |= flag;
+        }
     }
-    else if (!needFixedPostUpdate && (currentEventMask_ & USE_FIXEDPOSTUPDATE))
+    else if (!enable && (currentEventMask_ & flag))
     {
-        UnsubscribeFromEvent(world, E_PHYSICSPOSTSTEP);
-        currentEventMask_ &= ~USE_FIXEDPOSTUPDATE;
+        updateScene_->RemoveLogicComponent(this, phase);
+        currentEventMask_ &= ~flag;
     }
-#endif
 }
 
-void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+bool LogicComponent::ExecuteDelayedStart()
 {
-    using namespace SceneUpdate;
+    DelayedStart();
+    delayedStartCalled_ = true;
 
-    // Execute user-defined delayed start function before first update
-    if (!delayedStartCalled_)
+    // If did not need actual update events, stop updating now
+    if (!(updateEventMask_ & USE_UPDATE))
     {
-        DelayedStart();
-        delayedStartCalled_ = true;
-
-        // If did not need actual update events, unsubscribe now
-        if (!(updateEventMask_ & USE_UPDATE))
-        {
-            UnsubscribeFromEvent(GetScene(), E_SCENEUPDATE);
-            currentEventMask_ &= ~USE_UPDATE;
-            return;
-        }
+        SetUpdatePhase(LOGIC_UPDATE, USE_UPDATE, false);
+        return false;
     }
 
-    // Then execute user-defined update function
-    Update(eventData[P_TIMESTEP].GetFloat());
+    return true;
 }
 
-void LogicComponent::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::ApplyUpdate(LogicUpdatePhase phase, float timeStep)
 {
-    using namespace ScenePostUpdate;
+    switch (phase)
+    {
+    case LOGIC_UPDATE:
+        // Execute user-defined delayed start function before first update
+        if (!delayedStartCalled_ && !ExecuteDelayedStart())
+            return;
+        Update(timeStep);
+        break;
 
-    // Execute user-defined post-update function
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
-}
+    case LOGIC_POSTUPDATE:
+        PostUpdate(timeStep);
+        break;
 
-#if defined(URHO3D_PHYSICS) || defined(URHO3D_PHYSICS2D)
+    case LOGIC_FIXEDUPDATE:
+        // Execute user-defined delayed start function before first fixed update if not called yet
+        if (!delayedStartCalled_)
+        {
+            DelayedStart();
+            delayedStartCalled_ = true;
+        }
+        FixedUpdate(timeStep);
+        break;
 
-void LogicComponent::HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData)
-{
-    using namespace PhysicsPreStep;
+    case LOGIC_FIXEDPOSTUPDATE:
+        FixedPostUpdate(timeStep);
+        break;
 
-    // Execute user-defined delayed start function before first fixed update if not called yet
-    if (!delayedStartCalled_)
-    {
-        DelayedStart();
-        delayedStartCalled_ = true;
+    default:
+        break;
     }
-
-    // Execute user-defined fixed update function
-    FixedUpdate(eventData[P_TIMESTEP].GetFloat());
 }
 
-void LogicComponent::HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData)
-{
-    using namespace PhysicsPostStep;
-
-    // Execute user-defined fixed post-update function
-    FixedPostUpdate(eventData[P_TIMESTEP].GetFloat());
-}
-
-#endif
-
 }
@@ -26,6 +26,7 @@
 
 #include "../Container/FlagSet.h"
 #include "../Scene/Component.h"
+#include "../Scene/LogicUpdateList.h"
 
 namespace Urho3D
 {
@@ -45,11 +46,13 @@ enum UpdateEvent : unsigned
 };
 URHO3D_FLAGSET(UpdateEvent, UpdateEventFlags);
 
-/// Helper base class for user-defined game logic components that hooks up to update events and forwards them to virtual functions similar to ScriptInstance class.
+/// Helper base class for user-defined game logic components that hooks up to update events and forwards them to virtual functions similar to ScriptInstance class. The scene updates the components directly from per-phase lists grouped by type, rather than through one event dispatch per component.
 class URHO3D_API LogicComponent : public Component
 {
     URHO3D_OBJECT(LogicComponent, Component);
 
+    friend class LogicUpdateList;
+
     /// Construct.
     explicit LogicComponent(Context* context);
     /// Destruct.
@@ -82,6 +85,12 @@ class URHO3D_API LogicComponent : public Component
     /// Return what update events are subscribed to.
     UpdateEventFlags GetUpdateEventMask() const { return updateEventMask_; }
 
+    /// Set whether Update() and PostUpdate() are thread-safe and may be called in parallel with other components of the same type on worker threads. They must then not create or remove nodes or components, send events or modify state shared with other components. DelayedStart() and the fixed timestep updates are always called on the main thread.
+    void SetThreadSafeUpdate(bool enable);
+
+    /// Return whether Update() and PostUpdate() may be called on worker threads.
+    bool IsThreadSafeUpdate() const { return threadSafeUpdate_; }
+
     /// Return whether the DelayedStart() function has been called.
     bool IsDelayedStartCalled() const { return delayedStartCalled_; }
 
@@ -92,24 +101,29 @@ protected:
     void OnSceneSet(Scene* scene) override;
 
 private:
-    /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
+    /// Add to/remove from the scene's update lists based on current enabled state and update event mask.
     void UpdateEventSubscription();
-    /// Handle scene update event.
-    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
-    /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
-#if defined(URHO3D_PHYSICS) || defined(URHO3D_PHYSICS2D)
-    /// Handle physics pre-step event.
-    void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
-    /// Handle physics post-step event.
-    void HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData);
-#endif
+    /// Add to or remove from one update list of the scene.
+    void SetUpdatePhase(LogicUpdatePhase phase, UpdateEvent flag, bool enable);
+    /// Call DelayedStart() before the first update. Return false if the component stopped updating as it does not need actual update events.
+    bool ExecuteDelayedStart();
+    /// Execute an update phase on the main thread. Called by LogicUpdateList.
+    void ApplyUpdate(LogicUpdatePhase phase, float timeStep);
+
     /// Requested event subscription mask.
     UpdateEventFlags updateEventMask_;
     /// Current event subscription mask.
     UpdateEventFlags currentEventMask_;
     /// Flag for delayed start.
     bool delayedStartCalled_;
+    /// Thread-safe update flag.
+    bool threadSafeUpdate_;
+    /// Scene whose update lists the component is in.
+    Scene* updateScene_;
+    /// Group index in each update list, or M_MAX_UNSIGNED if not in the list.
+    unsigned updateGroups_[MAX_LOGIC_UPDATE_PHASES];
+    /// Index within the group in each update list.
+    unsigned updateIndices_[MAX_LOGIC_UPDATE_PHASES];
 };
 
 }
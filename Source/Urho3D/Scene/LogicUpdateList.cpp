@@ -0,0 +1,185 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/WorkQueue.h"
+#include "../Scene/LogicComponent.h"
+#include "../Scene/LogicUpdateList.h"
+#include "../Scene/Scene.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Minimum number of components per parallel update work item.
+static const unsigned LOGIC_UPDATE_GRAIN_SIZE = 16;
+
+LogicUpdateList::LogicUpdateList() :
+    numComponents_(0),
+    running_(false),
+    dirty_(false)
+{
+}
+
+void LogicUpdateList::Add(LogicComponent* component, LogicUpdatePhase phase)
+{
+    assert(component->updateGroups_[phase] == M_MAX_UNSIGNED);
+
+    const StringHash type = component->GetType();
+    // Fixed timestep updates typically touch physics objects, so they are always serial
+    const bool parallel = component->IsThreadSafeUpdate() && phase <= LOGIC_POSTUPDATE;
+
+    unsigned groupIndex = 0;
+    while (groupIndex < groups_.Size() && (groups_[groupIndex].type_ != type || groups_[groupIndex].parallel_ != parallel))
+        ++groupIndex;
+
+    if (groupIndex == groups_.Size())
+    {
+        groups_.Resize(groupIndex + 1);
+        groups_[groupIndex].type_ = type;
+        groups_[groupIndex].parallel_ = parallel;
+    }
+
+    PODVector<LogicComponent*>& components = groups_[groupIndex].components_;
+    component->updateGroups_[phase] = groupIndex;
+    component->updateIndices_[phase] = components.Size();
+    components.Push(component);
+    ++numComponents_;
+}
+
+void LogicUpdateList::Remove(LogicComponent* component, LogicUpdatePhase phase)
+{
+    const unsigned groupIndex = component->updateGroups_[phase];
+    const unsigned index = component->updateIndices_[phase];
+    if (groupIndex >= groups_.Size())
+        return;
+
+    PODVector<LogicComponent*>& components = groups_[groupIndex].components_;
+    assert(index < components.Size() && components[index] == component);
+
+    if (running_)
+    {
+        components[index] = nullptr;
+        dirty_ = true;
+    }
+    else
+    {
+        // Erase-swap; the order within a group does not matter
+        LogicComponent* last = components.Back();
+        components[index] = last;
+        last->updateIndices_[phase] = index;
+        components.Pop();
+    }
+
+    component->updateGroups_[phase] = M_MAX_UNSIGNED;
+    component->updateIndices_[phase] = M_MAX_UNSIGNED;
+    --numComponents_;
+}
+
+void LogicUpdateList::Run(LogicUpdatePhase phase, float timeStep, Scene* scene)
+{
+    if (running_ || !numComponents_)
+        return;
+
+    WorkQueue* workQueue = scene->GetSubsystem<WorkQueue>();
+    running_ = true;
+
+    // Groups and components added during the run are updated on the next run
+    const unsigned numGroups = groups_.Size();
+    for (unsigned i = 0; i < numGroups; ++i)
+    {
+        const unsigned numComponents = groups_[i].components_.Size();
+
+        if (groups_[i].parallel_ && workQueue && numComponents > LOGIC_UPDATE_GRAIN_SIZE)
+        {
+            // Delayed start may create or remove components, so it runs on the main thread before the parallel update
+            if (phase == LOGIC_UPDATE)
+            {
+                for (unsigned j = 0; j < numComponents; ++j)
+                {
+                    LogicComponent* component = groups_[i].components_[j];
+                    if (component && !component->IsDelayedStartCalled())
+                        component->ExecuteDelayedStart();
+                }
+            }
+
+            // Components may move their nodes. In threaded update mode the dirty marking of their drawables is
+            // synchronized or deferred to the main thread
+            scene->BeginThreadedUpdate();
+            LogicComponent** components = groups_[i].components_.Buffer();
+            workQueue->ParallelFor(numComponents, LOGIC_UPDATE_GRAIN_SIZE,
+                [components, phase, timeStep](unsigned begin, unsigned end, unsigned /*threadIndex*/)
+            {
+                for (unsigned j = begin; j < end; ++j)
+                {
+                    LogicComponent* component = components[j];
+                    if (!component)
+                        continue;
+                    if (phase == LOGIC_UPDATE)
+                        component->Update(timeStep);
+                    else
+                        component->PostUpdate(timeStep);
+                }
+            });
+            scene->EndThreadedUpdate();
+        }
+        else
+        {
+            // The group may be reallocated by components added during the update, so index it on each iteration
+            for (unsigned j = 0; j < numComponents; ++j)
+            {
+                LogicComponent* component = groups_[i].components_[j];
+                if (component)
+                    component->ApplyUpdate(phase, timeStep);
+            }
+        }
+    }
+
+    running_ = false;
+
+    if (dirty_)
+        Compact(phase);
+}
+
+void LogicUpdateList::Compact(LogicUpdatePhase phase)
+{
+    for (unsigned i = 0; i < groups_.Size(); ++i)
+    {
+        PODVector<LogicComponent*>& components = groups_[i].components_;
+        unsigned dest = 0;
+        for (unsigned j = 0; j < components.Size(); ++j)
+        {
+            LogicComponent* component = components[j];
+            if (!component)
+                continue;
+            component->updateIndices_[phase] = dest;
+            components[dest++] = component;
+        }
+        components.Resize(dest);
+    }
+
+    dirty_ = false;
+}
+
+}
@@ -0,0 +1,92 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Math/StringHash.h"
+
+namespace Urho3D
+{
+
+class LogicComponent;
+class Scene;
+
+/// Logic component update phase.
+enum LogicUpdatePhase
+{
+    /// Variable timestep update.
+    LOGIC_UPDATE = 0,
+    /// Variable timestep post-update.
+    LOGIC_POSTUPDATE,
+    /// Fixed timestep update before the physics step.
+    LOGIC_FIXEDUPDATE,
+    /// Fixed timestep update after the physics step.
+    LOGIC_FIXEDPOSTUPDATE,
+    MAX_LOGIC_UPDATE_PHASES
+};
+
+/// Dense list of logic components to update in one phase, grouped by component type. The scene iterates it directly instead of sending an event to each component.
+class URHO3D_API LogicUpdateList
+{
+public:
+    /// Construct.
+    LogicUpdateList();
+
+    /// Add a component. A component added during Run() is first updated on the next run.
+    void Add(LogicComponent* component, LogicUpdatePhase phase);
+    /// Remove a component. Leaves a hole when called during Run().
+    void Remove(LogicComponent* component, LogicUpdatePhase phase);
+    /// Update the components of a scene. Components which have opted in to thread-safe updates are updated in parallel through the work queue, inside the scene's threaded update.
+    void Run(LogicUpdatePhase phase, float timeStep, Scene* scene);
+
+    /// Return number of components.
+    unsigned GetNumComponents() const { return numComponents_; }
+
+private:
+    /// Components of one type and threading mode.
+    struct Group
+    {
+        /// Component type.
+        StringHash type_;
+        /// Whether the components are updated in parallel.
+        bool parallel_;
+        /// Components. May contain holes during Run().
+        PODVector<LogicComponent*> components_;
+    };
+
+    /// Remove holes left by removals during Run().
+    void Compact(LogicUpdatePhase phase);
+
+    /// Groups in order of creation.
+    Vector<Group> groups_;
+    /// Number of components.
+    unsigned numComponents_;
+    /// Run() in progress flag.
+    bool running_;
+    /// Holes to remove flag.
+    bool dirty_;
+};
+
+}
@@ -742,6 +742,13 @@ void Node::SetOwner(Connection* owner)
 
 void Node::MarkDirty()
 {
+    // With the transform hierarchy the subtree is marked dirty as a linear range
+    if (transforms_)
+    {
+        transforms_->MarkDirty(this);
+        return;
+    }
+
     Node *cur = this;
     for (;;)
     {
@@ -757,21 +764,7 @@ void Node::MarkDirty()
         cur->dirty_ = true;
 
         // Notify listener components first, then mark child nodes
-        for (Vector<WeakPtr<Component> >::Iterator i = cur->listeners_.Begin(); i != cur->listeners_.End();)
-        {
-            Component *c = *i;
-            if (c)
-            {
-                c->OnMarkedDirty(cur);
-                ++i;
-            }
-            // If listener has expired, erase from list (swap with the last element to avoid O(n^2) behavior)
-            else
-            {
-                *i = cur->listeners_.Back();
-                cur->listeners_.Pop();
-            }
-        }
+        cur->NotifyListeners();
 
         // Tail call optimization: Don't recurse to mark the first child dirty, but
         // instead process it in the context of the current function. If there are more
@@ -834,6 +827,8 @@ void Node::AddChild(Node* node, unsigned index)
             }
 
             oldParent->children_.Remove(nodeShared);
+            if (node->transforms_)
+                node->transforms_->MarkStructureDirty();
         }
     }
 
@@ -843,6 +838,8 @@ void Node::AddChild(Node* node, unsigned index)
         scene_->NodeAdded(node);
 
     node->parent_ = this;
+    if (node->transforms_)
+        node->transforms_->MarkStructureDirty();
     node->MarkDirty();
     node->MarkNetworkUpdate();
     // If the child node has components, also mark network update on them to ensure they have a valid NetworkState
@@ -1162,8 +1159,10 @@ void Node::AddListener(Component* component)
     }
 
     listeners_.Push(WeakPtr<Component>(component));
+    if (transforms_)
+        transforms_->SetHasListeners(transformIndex_);
     // If the node is currently dirty, notify immediately
-    if (dirty_)
+    if (IsDirty())
         component->OnMarkedDirty(this);
 }
 
@@ -1181,10 +1180,7 @@ void Node::RemoveListener(Component* component)
 
 Vector3 Node::GetSignedWorldScale() const
 {
-    if (dirty_)
-        UpdateWorldTransform();
-
-    return worldTransform_.SignedScale(worldRotation_.RotationMatrix());
+    return GetWorldTransform().SignedScale(GetWorldRotation().RotationMatrix());
 }
 
 Vector3 Node::LocalToWorld(const Vector3& position) const
@@ -1443,7 +1439,17 @@ void Node::SetID(unsigned id)
 
 void Node::SetScene(Scene* scene)
 {
+    if (transforms_)
+        transforms_->RemoveNode(this);
+
     scene_ = scene;
+
+    if (scene_)
+    {
+        TransformHierarchy* transforms = scene_->GetTransformHierarchy();
+        if (transforms)
+            transforms->AddNode(this);
+    }
 }
 
 void Node::ResetScene()
@@ -1896,6 +1902,8 @@ void Node::SetTransformSilent(const Vector3& position, const Quaternion& rotatio
     position_ = position;
     rotation_ = rotation;
     scale_ = scale;
+    if (transforms_)
+        transforms_->SetLocalTransform(transformIndex_, position, rotation, scale);
 }
 
 void Node::OnAttributeAnimationAdded()
@@ -2103,6 +2111,25 @@ void Node::UpdateWorldTransform() const
     dirty_ = false;
 }
 
+void Node::NotifyListeners()
+{
+    for (Vector<WeakPtr<Component> >::Iterator i = listeners_.Begin(); i != listeners_.End();)
+    {
+        Component *c = *i;
+        if (c)
+        {
+            c->OnMarkedDirty(this);
+            ++i;
+        }
+        // If listener has expired, erase from list (swap with the last element to avoid O(n^2) behavior)
+        else
+        {
+            *i = listeners_.Back();
+            listeners_.Pop();
+        }
+    }
+}
+
 void Node::RemoveChild(Vector<SharedPtr<Node> >::Iterator i)
 {
     // Keep a shared pointer to the child about to be removed, to make sure the erase from container completes first. Otherwise
@@ -2124,6 +2151,8 @@ void Node::RemoveChild(Vector<SharedPtr<Node> >::Iterator i)
     }
 
     child->parent_ = nullptr;
+    if (child->transforms_)
+        child->transforms_->MarkStructureDirty();
     child->MarkDirty();
     child->MarkNetworkUpdate();
     if (scene_)
@@ -27,6 +27,7 @@
 #include "../IO/VectorBuffer.h"
 #include "../Math/Matrix3x4.h"
 #include "../Scene/Animatable.h"
+#include "../Scene/TransformHierarchy.h"
 
 namespace Urho3D
 {
@@ -77,6 +78,7 @@ class URHO3D_API Node : public Animatable
     URHO3D_OBJECT(Node, Animatable);
 
     friend class Connection;
+    friend class TransformHierarchy;
 
 public:
     /// Construct.
@@ -445,10 +447,7 @@ public:
     /// @property
     Vector3 GetWorldPosition() const
     {
-        if (dirty_)
-            UpdateWorldTransform();
-
-        return worldTransform_.Translation();
+        return GetWorldTransform().Translation();
     }
 
     /// Return position in world space (for Urho2D).
@@ -463,6 +462,9 @@ public:
     /// @property
     Quaternion GetWorldRotation() const
     {
+        if (transforms_)
+            return transforms_->GetWorldRotation(transformIndex_);
+
         if (dirty_)
             UpdateWorldTransform();
 
@@ -480,40 +482,28 @@ public:
     /// @property
     Vector3 GetWorldDirection() const
     {
-        if (dirty_)
-            UpdateWorldTransform();
-
-        return worldRotation_ * Vector3::FORWARD;
+        return GetWorldRotation() * Vector3::FORWARD;
     }
 
     /// Return node's up vector in world space.
     /// @property
     Vector3 GetWorldUp() const
     {
-        if (dirty_)
-            UpdateWorldTransform();
-
-        return worldRotation_ * Vector3::UP;
+        return GetWorldRotation() * Vector3::UP;
     }
 
     /// Return node's right vector in world space.
     /// @property
     Vector3 GetWorldRight() const
     {
-        if (dirty_)
-            UpdateWorldTransform();
-
-        return worldRotation_ * Vector3::RIGHT;
+        return GetWorldRotation() * Vector3::RIGHT;
     }
 
     /// Return scale in world space.
     /// @property
     Vector3 GetWorldScale() const
     {
-        if (dirty_)
-            UpdateWorldTransform();
-
-        return worldTransform_.Scale();
+        return GetWorldTransform().Scale();
     }
 
     /// Return signed scale in world space. Utilized for Urho2D physics.
@@ -532,7 +522,10 @@ public:
     /// @property
     const Matrix3x4& GetWorldTransform() const
     {
-        if (dirty_)
+        // The transform hierarchy mirrors the world transform to the node, so the returned reference stays valid
+        if (transforms_)
+            transforms_->UpdateIfDirty(transformIndex_);
+        else if (dirty_)
             UpdateWorldTransform();
 
         return worldTransform_;
@@ -552,7 +545,7 @@ public:
     Vector2 WorldToLocal2D(const Vector2& vector) const;
 
     /// Return whether transform has changed and world transform needs recalculation.
-    bool IsDirty() const { return dirty_; }
+    bool IsDirty() const { return transforms_ ? transforms_->IsDirty(transformIndex_) : dirty_; }
 
     /// Return number of child scene nodes.
     unsigned GetNumChildren(bool recursive = false) const;
@@ -674,13 +667,28 @@ public:
     unsigned GetNumPersistentComponents() const;
 
     /// Set position in parent space silently without marking the node & child nodes dirty. Used by animation code.
-    void SetPositionSilent(const Vector3& position) { position_ = position; }
+    void SetPositionSilent(const Vector3& position)
+    {
+        position_ = position;
+        if (transforms_)
+            transforms_->SetPosition(transformIndex_, position);
+    }
 
     /// Set position in parent space silently without marking the node & child nodes dirty. Used by animation code.
-    void SetRotationSilent(const Quaternion& rotation) { rotation_ = rotation; }
+    void SetRotationSilent(const Quaternion& rotation)
+    {
+        rotation_ = rotation;
+        if (transforms_)
+            transforms_->SetRotation(transformIndex_, rotation);
+    }
 
     /// Set scale in parent space silently without marking the node & child nodes dirty. Used by animation code.
-    void SetScaleSilent(const Vector3& scale) { scale_ = scale; }
+    void SetScaleSilent(const Vector3& scale)
+    {
+        scale_ = scale;
+        if (transforms_)
+            transforms_->SetScale(transformIndex_, scale);
+    }
 
     /// Set local transform silently without marking the node & child nodes dirty. Used by animation code.
     void SetTransformSilent(const Vector3& position, const Quaternion& rotation, const Vector3& scale);
@@ -700,6 +708,8 @@ private:
     Component* SafeCreateComponent(const String& typeName, StringHash type, CreateMode mode, unsigned id);
     /// Recalculate the world transform.
     void UpdateWorldTransform() const;
+    /// Notify listener components that the world transform has changed, removing expired listeners.
+    void NotifyListeners();
     /// Remove child node by iterator.
     void RemoveChild(Vector<SharedPtr<Node> >::Iterator i);
     /// Return child nodes recursively.
@@ -753,6 +763,10 @@ private:
     Vector<WeakPtr<Component> > listeners_;
     /// Pointer to implementation.
     UniquePtr<NodeImpl> impl_;
+    /// Scene transform hierarchy holding the world transform, or null if the node has its own.
+    TransformHierarchy* transforms_{};
+    /// Slot in the transform hierarchy.
+    unsigned transformIndex_{M_MAX_UNSIGNED};
 
 protected:
     /// User variables.
@@ -163,7 +163,7 @@ struct URHO3D_API NodeReplicationState : public ReplicationState
     DirtyBits dirtyAttributes_;
     /// Dirty user vars.
     HashSet<StringHash> dirtyVars_;
-    /// Components by ID.
+    /// Components by ID. Node-based because components hold pointers to their replication states.
     HashMap<unsigned, ComponentReplicationState> componentStates_;
     /// Interest management priority accumulator.
     float priorityAcc_{};
@@ -84,10 +84,11 @@ Scene::~Scene()
     // Remove root-level components first, so that scene subsystems such as the octree destroy themselves. This will speed up
     // the removal of child nodes' components
     RemoveAllComponents();
+    transformHierarchy_.Reset();
     RemoveAllChildren();
 
     // Remove scene reference and owner from all nodes that still exist
-    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         i->second_->ResetScene();
     for (HashMap<unsigned, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
         i->second_->ResetScene();
@@ -210,7 +211,7 @@ void Scene::AddReplicationState(NodeReplicationState* state)
     Node::AddReplicationState(state);
 
     // This is the first update for a new connection. Mark all replicated nodes dirty
-    for (HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         state->sceneState_->dirtyNodes_.Insert(i->first_);
 }
 
@@ -707,7 +708,7 @@ Node* Scene::GetNode(unsigned id) const
 {
     if (IsReplicatedID(id))
     {
-        HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Find(id);
         return i != replicatedNodes_.End() ? i->second_ : nullptr;
     }
     else
@@ -734,7 +735,7 @@ Component* Scene::GetComponent(unsigned id) const
 {
     if (IsReplicatedID(id))
     {
-        HashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Find(id);
         return i != replicatedComponents_.End() ? i->second_ : nullptr;
     }
     else
@@ -757,6 +758,18 @@ const String& Scene::GetVarName(StringHash hash) const
     return i != varNames_.End() ? i->second_ : String::EMPTY;
 }
 
+void SceneUpdateEvent::ToVariantMap(VariantMap& eventData) const
+{
+    eventData[SceneUpdate::P_SCENE] = scene_;
+    eventData[SceneUpdate::P_TIMESTEP] = timeStep_;
+}
+
+void ScenePostUpdateEvent::ToVariantMap(VariantMap& eventData) const
+{
+    eventData[ScenePostUpdate::P_SCENE] = scene_;
+    eventData[ScenePostUpdate::P_TIMESTEP] = timeStep_;
+}
+
 void Scene::Update(float timeStep)
 {
     if (asyncLoading_)
@@ -771,15 +784,17 @@ void Scene::Update(float timeStep)
 
     timeStep *= timeScale_;
 
+    // Update variable timestep logic
+    UpdateLogicComponents(LOGIC_UPDATE, timeStep);
+    SceneUpdateEvent updateEvent{this, timeStep};
+    SendTypedEvent(updateEvent);
+
     using namespace SceneUpdate;
 
     VariantMap& eventData = GetEventDataMap();
     eventData[P_SCENE] = this;
     eventData[P_TIMESTEP] = timeStep;
 
-    // Update variable timestep logic
-    SendEvent(E_SCENEUPDATE, eventData);
-
     // Update scene attribute animation.
     SendEvent(E_ATTRIBUTEANIMATIONUPDATE, eventData);
 
@@ -793,15 +808,16 @@ void Scene::Update(float timeStep)
         float constant = 1.0f - Clamp(powf(2.0f, -timeStep * smoothingConstant_), 0.0f, 1.0f);
         float squaredSnapThreshold = snapThreshold_ * snapThreshold_;
 
-        using namespace UpdateSmoothing;
-
-        smoothingData_[P_CONSTANT] = constant;
-        smoothingData_[P_SQUAREDSNAPTHRESHOLD] = squaredSnapThreshold;
-        SendEvent(E_UPDATESMOOTHING, smoothingData_);
+        UpdateSmoothingEvent smoothingEvent{constant, squaredSnapThreshold};
+        SendTypedEvent(smoothingEvent);
     }
 
     // Post-update variable timestep logic
-    SendEvent(E_SCENEPOSTUPDATE, eventData);
+    UpdateLogicComponents(LOGIC_POSTUPDATE, timeStep);
+    ScenePostUpdateEvent postUpdateEvent{this, timeStep};
+    SendTypedEvent(postUpdateEvent);
+
+    UpdateTransformHierarchy();
 
     // Note: using a float for elapsed time accumulation is inherently inaccurate. The purpose of this value is
     // primarily to update material animation effects, as it is available to shaders. It can be reset by calling
@@ -809,6 +825,46 @@ void Scene::Update(float timeStep)
     elapsedTime_ += timeStep;
 }
 
+void Scene::UpdateLogicComponents(LogicUpdatePhase phase, float timeStep)
+{
+    LogicUpdateList& list = logicUpdateLists_[phase];
+    if (!list.GetNumComponents())
+        return;
+
+    URHO3D_PROFILE(UpdateLogicComponents);
+
+    list.Run(phase, timeStep, this);
+}
+
+void Scene::SetTransformHierarchyEnabled(bool enable)
+{
+    if (enable == (transformHierarchy_.Get() != nullptr))
+        return;
+
+    if (!enable)
+    {
+        transformHierarchy_.Reset();
+        return;
+    }
+
+    transformHierarchy_ = new TransformHierarchy(this);
+
+    PODVector<Node*> nodes;
+    GetChildren(nodes, true);
+    for (unsigned i = 0; i < nodes.Size(); ++i)
+        transformHierarchy_->AddNode(nodes[i]);
+}
+
+void Scene::UpdateTransformHierarchy()
+{
+    if (!transformHierarchy_ || (!transformHierarchy_->HasDirtyTransforms() && !transformHierarchy_->IsStructureDirty()))
+        return;
+
+    URHO3D_PROFILE(UpdateTransformHierarchy);
+
+    transformHierarchy_->Update(GetSubsystem<WorkQueue>());
+}
+
 void Scene::BeginThreadedUpdate()
 {
     // Check the work queue subsystem whether it actually has created worker threads. If not, do not enter threaded mode.
@@ -926,7 +982,7 @@ void Scene::NodeAdded(Node* node)
     // If node with same ID exists, remove the scene reference from it and overwrite with the new node
     if (IsReplicatedID(id))
     {
-        HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(id);
         if (i != replicatedNodes_.End() && i->second_ != node)
         {
             URHO3D_LOGWARNING("Overwriting node with ID " + String(id));
@@ -1025,7 +1081,7 @@ void Scene::ComponentAdded(Component* component)
 
     if (IsReplicatedID(id))
     {
-        HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Find(id);
         if (i != replicatedComponents_.End() && i->second_ != component)
         {
             URHO3D_LOGWARNING("Overwriting component with ID " + String(id));
@@ -1112,10 +1168,10 @@ void Scene::CleanupConnection(Connection* connection)
 {
     Node::CleanupConnection(connection);
 
-    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         i->second_->CleanupConnection(connection);
 
-    for (HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
+    for (FlatHashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
         i->second_->CleanupConnection(connection);
 }
 
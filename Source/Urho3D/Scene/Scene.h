@@ -24,10 +24,12 @@
 
 #pragma once
 
+#include "../Container/FlatHashMap.h"
 #include "../Container/HashSet.h"
 #include "../Core/Mutex.h"
 #include "../Resource/XMLElement.h"
 #include "../Resource/JSONFile.h"
+#include "../Scene/LogicUpdateList.h"
 #include "../Scene/Node.h"
 #include "../Scene/SceneResolver.h"
 
@@ -247,6 +249,22 @@ public:
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
 
+    /// Add a logic component to an update phase list. Called by LogicComponent.
+    void AddLogicComponent(LogicComponent* component, LogicUpdatePhase phase) { logicUpdateLists_[phase].Add(component, phase); }
+    /// Remove a logic component from an update phase list. Called by LogicComponent.
+    void RemoveLogicComponent(LogicComponent* component, LogicUpdatePhase phase) { logicUpdateLists_[phase].Remove(component, phase); }
+    /// Update the logic components of a phase. Called by Update() for the variable timestep phases and by the physics world for the fixed timestep phases.
+    void UpdateLogicComponents(LogicUpdatePhase phase, float timeStep);
+    /// Return number of logic components in an update phase list.
+    unsigned GetNumLogicComponents(LogicUpdatePhase phase) const { return logicUpdateLists_[phase].GetNumComponents(); }
+
+    /// Enable or disable the structure-of-arrays transform hierarchy, which keeps node transforms in contiguous storage and updates world transforms in one batched pass per frame.
+    void SetTransformHierarchyEnabled(bool enable);
+    /// Recalculate all dirty world transforms of the transform hierarchy. Called at the end of Update() and before the octree update.
+    void UpdateTransformHierarchy();
+    /// Return the transform hierarchy, or null if not enabled.
+    TransformHierarchy* GetTransformHierarchy() const { return transformHierarchy_.Get(); }
+
     /// Get free node ID, either non-local or local.
     unsigned GetFreeNodeID(CreateMode mode);
     /// Get free component ID, either non-local or local.
@@ -304,11 +322,11 @@ private:
     void PreloadResourcesJSON(const JSONValue& value);
 
     /// Replicated scene nodes by ID.
-    HashMap<unsigned, Node*> replicatedNodes_;
+    FlatHashMap<unsigned, Node*> replicatedNodes_;
     /// Local scene nodes by ID.
     HashMap<unsigned, Node*> localNodes_;
     /// Replicated components by ID.
-    HashMap<unsigned, Component*> replicatedComponents_;
+    FlatHashMap<unsigned, Component*> replicatedComponents_;
     /// Local components by ID.
     HashMap<unsigned, Component*> localComponents_;
     /// Cached tagged nodes by tag.
@@ -327,12 +345,14 @@ private:
     HashSet<unsigned> networkUpdateNodes_;
     /// Components to check for attribute changes on the next network update.
     HashSet<unsigned> networkUpdateComponents_;
+    /// Logic component update lists per phase.
+    LogicUpdateList logicUpdateLists_[MAX_LOGIC_UPDATE_PHASES];
+    /// Transform hierarchy.
+    UniquePtr<TransformHierarchy> transformHierarchy_;
     /// Delayed dirty notification queue for components.
     PODVector<Component*> delayedDirtyComponents_;
     /// Mutex for the delayed dirty notification queue.
     Mutex sceneMutex_;
-    /// Preallocated event data map for smoothing update events.
-    VariantMap smoothingData_;
     /// Next free non-local node ID.
     unsigned replicatedNodeID_;
     /// Next free non-local component ID.
@@ -27,6 +27,8 @@
 namespace Urho3D
 {
 
+class Scene;
+
 /// Variable timestep scene update.
 URHO3D_EVENT(E_SCENEUPDATE, SceneUpdate)
 {
@@ -34,6 +36,20 @@ URHO3D_EVENT(E_SCENEUPDATE, SceneUpdate)
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed payload of E_SCENEUPDATE.
+struct URHO3D_API SceneUpdateEvent
+{
+    /// Return event type.
+    static StringHash GetEventTypeStatic() { return E_SCENEUPDATE; }
+    /// Fill parameters for VariantMap handlers.
+    void ToVariantMap(VariantMap& eventData) const;
+
+    /// Scene.
+    Scene* scene_;
+    /// Time step.
+    float timeStep_;
+};
+
 /// Scene subsystem update.
 URHO3D_EVENT(E_SCENESUBSYSTEMUPDATE, SceneSubsystemUpdate)
 {
@@ -48,6 +64,24 @@ URHO3D_EVENT(E_UPDATESMOOTHING, UpdateSmoothing)
     URHO3D_PARAM(P_SQUAREDSNAPTHRESHOLD, SquaredSnapThreshold);  // float
 }
 
+/// Typed payload of E_UPDATESMOOTHING.
+struct URHO3D_API UpdateSmoothingEvent
+{
+    /// Return event type.
+    static StringHash GetEventTypeStatic() { return E_UPDATESMOOTHING; }
+    /// Fill parameters for VariantMap handlers.
+    void ToVariantMap(VariantMap& eventData) const
+    {
+        eventData[UpdateSmoothing::P_CONSTANT] = constant_;
+        eventData[UpdateSmoothing::P_SQUAREDSNAPTHRESHOLD] = squaredSnapThreshold_;
+    }
+
+    /// Smoothing constant.
+    float constant_;
+    /// Squared snap threshold.
+    float squaredSnapThreshold_;
+};
+
 /// Scene drawable update finished. Custom animation (eg. IK) can be done at this point.
 URHO3D_EVENT(E_SCENEDRAWABLEUPDATEFINISHED, SceneDrawableUpdateFinished)
 {
@@ -93,6 +127,20 @@ URHO3D_EVENT(E_SCENEPOSTUPDATE, ScenePostUpdate)
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed payload of E_SCENEPOSTUPDATE.
+struct URHO3D_API ScenePostUpdateEvent
+{
+    /// Return event type.
+    static StringHash GetEventTypeStatic() { return E_SCENEPOSTUPDATE; }
+    /// Fill parameters for VariantMap handlers.
+    void ToVariantMap(VariantMap& eventData) const;
+
+    /// Scene.
+    Scene* scene_;
+    /// Time step.
+    float timeStep_;
+};
+
 /// Asynchronous scene loading progress.
 URHO3D_EVENT(E_ASYNCLOADPROGRESS, AsyncLoadProgress)
 {
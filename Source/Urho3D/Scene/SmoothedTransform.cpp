@@ -91,7 +91,7 @@ void SmoothedTransform::Update(float constant, float squaredSnapThreshold)
     // If smoothing has completed, unsubscribe from the update event
     if (!smoothingMask_)
     {
-        UnsubscribeFromEvent(GetScene(), E_UPDATESMOOTHING);
+        UnsubscribeFromTypedEvent<UpdateSmoothingEvent>(GetScene());
         subscribed_ = false;
     }
 }
@@ -104,7 +104,7 @@ void SmoothedTransform::SetTargetPosition(const Vector3& position)
     // Subscribe to smoothing update if not yet subscribed
     if (!subscribed_)
     {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, URHO3D_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
+        SubscribeToTypedEvent<UpdateSmoothingEvent>(GetScene(), URHO3D_TYPED_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
         subscribed_ = true;
     }
 
@@ -118,7 +118,7 @@ void SmoothedTransform::SetTargetRotation(const Quaternion& rotation)
 
     if (!subscribed_)
     {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, URHO3D_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
+        SubscribeToTypedEvent<UpdateSmoothingEvent>(GetScene(), URHO3D_TYPED_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
         subscribed_ = true;
     }
 
@@ -167,13 +167,9 @@ void SmoothedTransform::OnNodeSet(Node* node)
     }
 }
 
-void SmoothedTransform::HandleUpdateSmoothing(StringHash eventType, VariantMap& eventData)
+void SmoothedTransform::HandleUpdateSmoothing(UpdateSmoothingEvent& event)
 {
-    using namespace UpdateSmoothing;
-
-    float constant = eventData[P_CONSTANT].GetFloat();
-    float squaredSnapThreshold = eventData[P_SQUAREDSNAPTHRESHOLD].GetFloat();
-    Update(constant, squaredSnapThreshold);
+    Update(event.constant_, event.squaredSnapThreshold_);
 }
 
 }
@@ -29,6 +29,8 @@
 namespace Urho3D
 {
 
+struct UpdateSmoothingEvent;
+
 enum SmoothingType : unsigned
 {
     /// No ongoing smoothing.
@@ -94,7 +96,7 @@ protected:
 
 private:
     /// Handle smoothing update event.
-    void HandleUpdateSmoothing(StringHash eventType, VariantMap& eventData);
+    void HandleUpdateSmoothing(UpdateSmoothingEvent& event);
 
     /// Target position.
     Vector3 targetPosition_;
@@ -0,0 +1,345 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/WorkQueue.h"
+#include "../Scene/Node.h"
+#include "../Scene/Scene.h"
+#include "../Scene/TransformHierarchy.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Minimum number of nodes for a parallel batched update.
+static const unsigned PARALLEL_TRANSFORM_THRESHOLD = 4096;
+
+TransformHierarchy::TransformHierarchy(Scene* scene) :
+    scene_(scene),
+    numNodes_(0),
+    anyDirty_(false),
+    structureDirty_(false)
+{
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+    for (unsigned i = 0; i < nodes_.Size(); ++i)
+    {
+        Node* node = nodes_[i];
+        if (!node)
+            continue;
+
+        node->worldRotation_ = worldRotations_[i];
+        node->dirty_ = dirty_[i] != 0;
+        node->transforms_ = nullptr;
+        node->transformIndex_ = M_MAX_UNSIGNED;
+    }
+}
+
+void TransformHierarchy::AddNode(Node* node)
+{
+    if (node == scene_ || node->transforms_ == this)
+        return;
+
+    // The parent is not known yet when the node is added to the scene, so the rebuild assigns it
+    const unsigned index = AddSlot(node, M_MAX_UNSIGNED);
+    node->transforms_ = this;
+    node->transformIndex_ = index;
+    ++numNodes_;
+    anyDirty_.store(true, std::memory_order_relaxed);
+    structureDirty_ = true;
+}
+
+void TransformHierarchy::RemoveNode(Node* node)
+{
+    const unsigned index = node->transformIndex_;
+    if (node->transforms_ != this || index >= nodes_.Size())
+        return;
+
+    // Hand the world transform back, so that the node continues to work without the hierarchy. The matrix is already mirrored
+    node->worldRotation_ = worldRotations_[index];
+    node->dirty_ = dirty_[index] != 0;
+    node->transforms_ = nullptr;
+    node->transformIndex_ = M_MAX_UNSIGNED;
+
+    nodes_[index] = nullptr;
+    --numNodes_;
+    structureDirty_ = true;
+}
+
+void TransformHierarchy::MarkDirty(Node* node)
+{
+    // The node's local transform has changed
+    const unsigned index = node->transformIndex_;
+    SetLocalTransform(index, node->position_, node->rotation_, node->scale_);
+
+    // Whenever a node is dirty, its whole subtree is dirty as well
+    if (dirty_[index])
+        return;
+    anyDirty_.store(true, std::memory_order_relaxed);
+
+    if (structureDirty_)
+    {
+        MarkDirtyRecursive(node);
+        return;
+    }
+
+    const unsigned end = subtreeEnds_[index];
+    for (unsigned i = index; i < end;)
+    {
+        if (dirty_[i])
+        {
+            i = subtreeEnds_[i];
+            continue;
+        }
+
+        dirty_[i] = 1;
+        if (hasListeners_[i] && nodes_[i])
+            nodes_[i]->NotifyListeners();
+        ++i;
+    }
+}
+
+void TransformHierarchy::Update(WorkQueue* workQueue)
+{
+    if (structureDirty_)
+        Rebuild();
+    if (!anyDirty_.load(std::memory_order_relaxed))
+        return;
+
+    // Parents precede children, so a forward pass over a subtree range sees the parent world transforms already updated
+    auto updateRange = [this](unsigned begin, unsigned end)
+    {
+        for (unsigned i = begin; i < end; ++i)
+        {
+            if (!dirty_[i])
+                continue;
+
+            const Matrix3x4 transform(positions_[i], rotations_[i], scales_[i]);
+            const unsigned parent = parents_[i];
+            if (parent == M_MAX_UNSIGNED)
+            {
+                worldTransforms_[i] = transform;
+                worldRotations_[i] = rotations_[i];
+            }
+            else
+            {
+                worldTransforms_[i] = worldTransforms_[parent] * transform;
+                worldRotations_[i] = worldRotations_[parent] * rotations_[i];
+            }
+            if (nodes_[i])
+                nodes_[i]->worldTransform_ = worldTransforms_[i];
+            dirty_[i] = 0;
+        }
+    };
+
+    if (workQueue && roots_.Size() > 1 && nodes_.Size() >= PARALLEL_TRANSFORM_THRESHOLD)
+    {
+        workQueue->ParallelFor(roots_.Size(), 0, [this, &updateRange](unsigned begin, unsigned end, unsigned /*threadIndex*/)
+        {
+            updateRange(roots_[begin], end < roots_.Size() ? roots_[end] : nodes_.Size());
+        });
+    }
+    else
+        updateRange(0, nodes_.Size());
+
+    anyDirty_.store(false, std::memory_order_relaxed);
+}
+
+void TransformHierarchy::UpdateWorldTransform(unsigned index)
+{
+    const Matrix3x4 transform(positions_[index], rotations_[index], scales_[index]);
+
+    // Assume the root node (scene) has identity transform
+    Node* parent = nodes_[index]->parent_;
+    if (parent == scene_ || !parent)
+    {
+        worldTransforms_[index] = transform;
+        worldRotations_[index] = rotations_[index];
+    }
+    else
+    {
+        worldTransforms_[index] = parent->GetWorldTransform() * transform;
+        worldRotations_[index] = parent->GetWorldRotation() * rotations_[index];
+    }
+
+    nodes_[index]->worldTransform_ = worldTransforms_[index];
+    dirty_[index] = 0;
+}
+
+void TransformHierarchy::MarkDirtyRecursive(Node* node)
+{
+    const unsigned index = node->transformIndex_;
+    if (node->transforms_ == this)
+    {
+        if (dirty_[index])
+            return;
+        dirty_[index] = 1;
+    }
+
+    node->NotifyListeners();
+
+    const Vector<SharedPtr<Node> >& children = node->GetChildren();
+    for (unsigned i = 0; i < children.Size(); ++i)
+        MarkDirtyRecursive(children[i]);
+}
+
+void TransformHierarchy::Rebuild()
+{
+    PODVector<Node*> oldNodes;
+    PODVector<Matrix3x4> oldWorldTransforms;
+    PODVector<Quaternion> oldWorldRotations;
+    PODVector<unsigned char> oldDirty;
+    oldNodes.Swap(nodes_);
+    oldWorldTransforms.Swap(worldTransforms_);
+    oldWorldRotations.Swap(worldRotations_);
+    oldDirty.Swap(dirty_);
+
+    parents_.Clear();
+    subtreeEnds_.Clear();
+    positions_.Clear();
+    rotations_.Clear();
+    scales_.Clear();
+    hasListeners_.Clear();
+    roots_.Clear();
+
+    const unsigned capacity = numNodes_;
+    nodes_.Reserve(capacity);
+    parents_.Reserve(capacity);
+    subtreeEnds_.Reserve(capacity);
+    positions_.Reserve(capacity);
+    rotations_.Reserve(capacity);
+    scales_.Reserve(capacity);
+    worldTransforms_.Reserve(capacity);
+    worldRotations_.Reserve(capacity);
+    dirty_.Reserve(capacity);
+    hasListeners_.Reserve(capacity);
+
+    // Depth-first traversal of a subtree, emitting nodes in pre-order. Old slot indices are still stored in the nodes
+    PODVector<Node*> stack;
+    auto addSubtree = [&](Node* top)
+    {
+        stack.Push(top);
+        while (!stack.Empty())
+        {
+            Node* node = stack.Back();
+            stack.Pop();
+            if (node->transforms_ != this)
+                continue;
+
+            const unsigned oldIndex = node->transformIndex_;
+            Node* parent = node->parent_;
+            const unsigned parentIndex = parent && parent != scene_ && parent->transforms_ == this ? parent->transformIndex_ :
+                M_MAX_UNSIGNED;
+            const unsigned index = AddSlot(node, parentIndex);
+            if (parentIndex == M_MAX_UNSIGNED)
+                roots_.Push(index);
+
+            worldTransforms_[index] = oldWorldTransforms[oldIndex];
+            worldRotations_[index] = oldWorldRotations[oldIndex];
+            dirty_[index] = oldDirty[oldIndex];
+            oldNodes[oldIndex] = nullptr;
+            node->transformIndex_ = index;
+
+            const Vector<SharedPtr<Node> >& children = node->GetChildren();
+            for (unsigned i = children.Size() - 1; i < children.Size(); --i)
+                stack.Push(children[i]);
+        }
+    };
+
+    const Vector<SharedPtr<Node> >& sceneChildren = scene_->GetChildren();
+    for (unsigned i = 0; i < sceneChildren.Size(); ++i)
+        addSubtree(sceneChildren[i]);
+
+    // Nodes which belong to the scene but could not be reached, for example during reparenting, are added as subtrees from
+    // their topmost ancestor in the hierarchy, so that children still follow their parents. If that ancestor has a parent
+    // outside the hierarchy, the batched update can not see the parent's world transform, so the subtree falls back to the
+    // nodes' own transform update instead
+    for (unsigned i = 0; i < oldNodes.Size(); ++i)
+    {
+        Node* node = oldNodes[i];
+        if (!node)
+            continue;
+
+        Node* top = node;
+        while (top->parent_ && top->parent_ != scene_ && top->parent_->transforms_ == this)
+            top = top->parent_;
+
+        if (!top->parent_ || top->parent_ == scene_)
+            addSubtree(top);
+        else
+        {
+            stack.Push(top);
+            while (!stack.Empty())
+            {
+                Node* detached = stack.Back();
+                stack.Pop();
+                if (detached->transforms_ != this)
+                    continue;
+
+                const unsigned oldIndex = detached->transformIndex_;
+                detached->worldTransform_ = oldWorldTransforms[oldIndex];
+                detached->worldRotation_ = oldWorldRotations[oldIndex];
+                detached->dirty_ = true;
+                detached->transforms_ = nullptr;
+                detached->transformIndex_ = M_MAX_UNSIGNED;
+                oldNodes[oldIndex] = nullptr;
+
+                const Vector<SharedPtr<Node> >& children = detached->GetChildren();
+                for (unsigned j = 0; j < children.Size(); ++j)
+                    stack.Push(children[j]);
+            }
+        }
+    }
+
+    // Extend each subtree to cover its descendants, which follow it in pre-order
+    for (unsigned i = nodes_.Size() - 1; i < nodes_.Size(); --i)
+    {
+        const unsigned parent = parents_[i];
+        if (parent != M_MAX_UNSIGNED)
+            subtreeEnds_[parent] = Max(subtreeEnds_[parent], subtreeEnds_[i]);
+    }
+
+    numNodes_ = nodes_.Size();
+    structureDirty_ = false;
+}
+
+unsigned TransformHierarchy::AddSlot(Node* node, unsigned parent)
+{
+    const unsigned index = nodes_.Size();
+    nodes_.Push(node);
+    parents_.Push(parent);
+    subtreeEnds_.Push(index + 1);
+    positions_.Push(node->position_);
+    rotations_.Push(node->rotation_);
+    scales_.Push(node->scale_);
+    worldTransforms_.Push(Matrix3x4::IDENTITY);
+    worldRotations_.Push(Quaternion::IDENTITY);
+    dirty_.Push(1);
+    hasListeners_.Push(node->listeners_.Empty() ? 0 : 1);
+    return index;
+}
+
+}
@@ -0,0 +1,144 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Math/Matrix3x4.h"
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+class Node;
+class Scene;
+class WorkQueue;
+
+/// Contiguous structure-of-arrays storage for the transforms of a scene's nodes. Slots are kept in hierarchy pre-order, so that every parent precedes its children and every subtree is one contiguous range. Marking a subtree dirty is then a linear pass over its range, and world transforms are recalculated in one batched pass per frame, in parallel over the top-level subtrees. The pass computes one node at a time, so it is not vectorized across nodes beyond the SSE matrix math where enabled. Recalculated world transforms are mirrored to the nodes, so that references returned by Node::GetWorldTransform() stay valid when the slots are reallocated or reordered. The mirror writes are scattered over the node objects, and the node getters read the mirror rather than the arrays. Enable with Scene::SetTransformHierarchyEnabled().
+class URHO3D_API TransformHierarchy
+{
+public:
+    /// Construct for a scene.
+    explicit TransformHierarchy(Scene* scene);
+    /// Destruct. Hands the world transforms back to the nodes.
+    ~TransformHierarchy();
+    /// Prevent copy construction.
+    TransformHierarchy(const TransformHierarchy& rhs) = delete;
+    /// Prevent assignment.
+    TransformHierarchy& operator =(const TransformHierarchy& rhs) = delete;
+
+    /// Add a node. Called when the node is assigned to the scene.
+    void AddNode(Node* node);
+    /// Remove a node, handing its world transform back to it. Called when the node is removed from the scene.
+    void RemoveNode(Node* node);
+    /// Mark that nodes have been reparented or reordered. The pre-order is rebuilt on the next batched update.
+    void MarkStructureDirty() { structureDirty_ = true; }
+    /// Mark a node and its subtree dirty and notify their listeners.
+    void MarkDirty(Node* node);
+    /// Recalculate all dirty world transforms. Uses the work queue if given.
+    void Update(WorkQueue* workQueue);
+
+    /// Set local transform of a slot.
+    void SetLocalTransform(unsigned index, const Vector3& position, const Quaternion& rotation, const Vector3& scale)
+    {
+        positions_[index] = position;
+        rotations_[index] = rotation;
+        scales_[index] = scale;
+    }
+    /// Set local position of a slot.
+    void SetPosition(unsigned index, const Vector3& position) { positions_[index] = position; }
+    /// Set local rotation of a slot.
+    void SetRotation(unsigned index, const Quaternion& rotation) { rotations_[index] = rotation; }
+    /// Set local scale of a slot.
+    void SetScale(unsigned index, const Vector3& scale) { scales_[index] = scale; }
+    /// Mark that a slot's node has listeners.
+    void SetHasListeners(unsigned index) { hasListeners_[index] = 1; }
+
+    /// Return whether a slot's world transform needs recalculation.
+    bool IsDirty(unsigned index) const { return dirty_[index] != 0; }
+    /// Recalculate world transform of a slot if dirty.
+    void UpdateIfDirty(unsigned index)
+    {
+        if (dirty_[index])
+            UpdateWorldTransform(index);
+    }
+    /// Return world rotation of a slot, recalculating it if dirty.
+    Quaternion GetWorldRotation(unsigned index)
+    {
+        if (dirty_[index])
+            UpdateWorldTransform(index);
+        return worldRotations_[index];
+    }
+
+    /// Return number of nodes.
+    unsigned GetNumNodes() const { return numNodes_; }
+    /// Return whether any world transform is dirty.
+    bool HasDirtyTransforms() const { return anyDirty_.load(std::memory_order_relaxed); }
+    /// Return whether the pre-order needs to be rebuilt.
+    bool IsStructureDirty() const { return structureDirty_; }
+
+private:
+    /// Recalculate world transform of a slot and its dirty ancestors, and mirror it to the node.
+    void UpdateWorldTransform(unsigned index);
+    /// Mark a subtree dirty by following the nodes' child pointers. Used while the pre-order is out of date.
+    void MarkDirtyRecursive(Node* node);
+    /// Rebuild the slots in hierarchy pre-order, dropping removed nodes.
+    void Rebuild();
+    /// Append a slot for a node.
+    unsigned AddSlot(Node* node, unsigned parent);
+
+    /// Scene.
+    Scene* scene_;
+    /// Nodes. Null for removed nodes until the next rebuild.
+    PODVector<Node*> nodes_;
+    /// Parent slots. M_MAX_UNSIGNED for the children of the scene.
+    PODVector<unsigned> parents_;
+    /// One past the last slot of each subtree.
+    PODVector<unsigned> subtreeEnds_;
+    /// Local positions.
+    PODVector<Vector3> positions_;
+    /// Local rotations.
+    PODVector<Quaternion> rotations_;
+    /// Local scales.
+    PODVector<Vector3> scales_;
+    /// World transforms.
+    PODVector<Matrix3x4> worldTransforms_;
+    /// World rotations.
+    PODVector<Quaternion> worldRotations_;
+    /// World transform dirty flags.
+    PODVector<unsigned char> dirty_;
+    /// Listener flags. Only nodes with listeners are touched when marking a subtree dirty.
+    PODVector<unsigned char> hasListeners_;
+    /// First slots of the top-level subtrees.
+    PODVector<unsigned> roots_;
+    /// Number of nodes.
+    unsigned numNodes_;
+    /// Any world transform dirty flag. Atomic, as nodes may be marked dirty from threaded drawable updates.
+    std::atomic<bool> anyDirty_;
+    /// Pre-order out of date flag.
+    bool structureDirty_;
+};
+
+}
@@ -24,6 +24,8 @@
 
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
+#include "../Core/FrameAllocator.h"
+#include "../Container/FramePODVector.h"
 #include "../Container/HashSet.h"
 #include "../Container/Sort.h"
 #include "../IO/Log.h"
@@ -1100,11 +1102,16 @@ void UIElement::UpdateLayout()
     // Prevent further updates while this update happens
     DisableLayoutUpdate();
 
-    PODVector<int> positions;
-    PODVector<int> sizes;
-    PODVector<int> minSizes;
-    PODVector<int> maxSizes;
-    PODVector<float> flexScales;
+    // Scratch arrays come from the frame arena and are released when the update returns. Nested updates of child
+    // layouts allocate and release after this one, so the arena behaves as a stack
+    auto* allocator = GetSubsystem<FrameAllocator>();
+    FrameArena* arena = allocator ? allocator->GetArena() : nullptr;
+    FrameArenaScope arenaScope(arena);
+    FramePODVector<int> positions(arena);
+    FramePODVector<int> sizes(arena);
+    FramePODVector<int> minSizes(arena);
+    FramePODVector<int> maxSizes(arena);
+    FramePODVector<float> flexScales(arena);
 
     int baseIndentWidth = GetIndentWidth();
 
@@ -2073,7 +2080,7 @@ void UIElement::ApplyStyleRecursive(UIElement* element)
     }
 }
 
-int UIElement::CalculateLayoutParentSize(const PODVector<int>& sizes, int begin, int end, int spacing)
+int UIElement::CalculateLayoutParentSize(const FramePODVector<int>& sizes, int begin, int end, int spacing)
 {
     int width = begin + end;
     if (sizes.Empty())
@@ -2090,8 +2097,8 @@ int UIElement::CalculateLayoutParentSize(const PODVector<int>& sizes, int begin,
     return width - spacing;
 }
 
-void UIElement::CalculateLayout(PODVector<int>& positions, PODVector<int>& sizes, const PODVector<int>& minSizes,
-    const PODVector<int>& maxSizes, const PODVector<float>& flexScales, int targetSize, int begin, int end, int spacing)
+void UIElement::CalculateLayout(FramePODVector<int>& positions, FramePODVector<int>& sizes, const FramePODVector<int>& minSizes,
+    const FramePODVector<int>& maxSizes, const FramePODVector<float>& flexScales, int targetSize, int begin, int end, int spacing)
 {
     unsigned numChildren = sizes.Size();
     if (!numChildren)
@@ -2133,7 +2140,7 @@ void UIElement::CalculateLayout(PODVector<int>& positions, PODVector<int>& sizes
             break;
 
         // Check which of the children can be resized to correct the error. If none, must break
-        PODVector<unsigned> resizable;
+        FramePODVector<unsigned> resizable(sizes.GetArena());
         for (unsigned i = 0; i < numChildren; ++i)
         {
             if (error < 0 && sizes[i] > minSizes[i])
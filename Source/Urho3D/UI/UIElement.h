@@ -117,6 +117,7 @@ URHO3D_FLAGSET(DragAndDropMode, DragAndDropModeFlags);
 class Cursor;
 class ResourceCache;
 class Texture2D;
+template <class T> class FramePODVector;
 
 /// Base class for %UI elements.
 class URHO3D_API UIElement : public Animatable
@@ -865,11 +866,11 @@ private:
     /// Recursively apply style to a child element hierarchy when adding to an element.
     void ApplyStyleRecursive(UIElement* element);
     /// Calculate layout width for resizing the parent element.
-    int CalculateLayoutParentSize(const PODVector<int>& sizes, int begin, int end, int spacing);
+    int CalculateLayoutParentSize(const FramePODVector<int>& sizes, int begin, int end, int spacing);
     /// Calculate child widths/positions in the layout.
     void CalculateLayout
-        (PODVector<int>& positions, PODVector<int>& sizes, const PODVector<int>& minSizes, const PODVector<int>& maxSizes,
-            const PODVector<float>& flexScales, int targetSize, int begin, int end, int spacing);
+        (FramePODVector<int>& positions, FramePODVector<int>& sizes, const FramePODVector<int>& minSizes,
+            const FramePODVector<int>& maxSizes, const FramePODVector<float>& flexScales, int targetSize, int begin, int end, int spacing);
     /// Get child element constant position in a layout.
     IntVector2 GetLayoutChildPosition(UIElement* child);
     /// Detach from parent.
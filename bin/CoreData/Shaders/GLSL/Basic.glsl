@@ -19,7 +19,7 @@ void VS()
         vTexCoord = iTexCoord;
     #endif
     #ifdef VERTEXCOLOR
-        vColor = iColor;
+        vColor = GetVertexColor(iColor);
     #endif
 }
 
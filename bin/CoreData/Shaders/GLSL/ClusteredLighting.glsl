@@ -0,0 +1,61 @@
+// Shaders which include this file shade the clustered point and spot lights in their scene passes. Other shaders get
+// the clustered lights as per-light batches instead
+
+#ifdef CLUSTERED
+
+// Cluster grid and cluster texture layout, see LightClusters.h
+#define CLUSTER_TILES_X 16.0
+#define CLUSTER_TILES_Y 8.0
+#define CLUSTER_SLICES 24.0
+#define MAX_LIGHTS_PER_CLUSTER 32
+#define CLUSTER_TEXTURE_WIDTH 1024.0
+#define CLUSTER_TEXTURE_HEIGHT 64.0
+#define CLUSTER_HEADER_START 1024.0
+
+vec4 GetClusterTexel(float index)
+{
+    vec2 texCoord = vec2((mod(index, CLUSTER_TEXTURE_WIDTH) + 0.5) / CLUSTER_TEXTURE_WIDTH,
+        (floor(index / CLUSTER_TEXTURE_WIDTH) + 0.5) / CLUSTER_TEXTURE_HEIGHT);
+    #ifdef GL3
+        return texture2DLod(sClusterMap, texCoord, 0.0);
+    #else
+        return texture2D(sClusterMap, texCoord);
+    #endif
+}
+
+vec3 GetClusteredLight(vec3 clusterPos, vec3 worldPos, vec3 normal, vec3 diffColor, vec3 specColor, float specularPower)
+{
+    // The cluster is found from the clip space XY and the view depth, which is clip space W
+    vec2 tile = clamp(floor(clusterPos.xy / clusterPos.z * cClusterParams.xy + abs(cClusterParams.xy)), vec2(0.0, 0.0),
+        vec2(CLUSTER_TILES_X - 1.0, CLUSTER_TILES_Y - 1.0));
+    float slice = clamp(floor(log(clusterPos.z) * cClusterParams.z + cClusterParams.w), 0.0, CLUSTER_SLICES - 1.0);
+    vec4 cluster = GetClusterTexel(CLUSTER_HEADER_START + (slice * CLUSTER_TILES_Y + tile.y) * CLUSTER_TILES_X + tile.x);
+
+    vec3 eyeVec = cCameraPosPS - worldPos;
+    vec3 lightColor = vec3(0.0, 0.0, 0.0);
+    for (int i = 0; i < MAX_LIGHTS_PER_CLUSTER; ++i)
+    {
+        if (float(i) >= cluster.y)
+            break;
+
+        // Light data is laid out as the vertex lights, followed by the specular intensity
+        float lightStart = GetClusterTexel(cluster.x + float(i)).r * 4.0;
+        vec4 lightColorRange = GetClusterTexel(lightStart);
+        vec4 lightDirCutoff = GetClusterTexel(lightStart + 1.0);
+        vec4 lightPosInvCutoff = GetClusterTexel(lightStart + 2.0);
+        float specIntensity = GetClusterTexel(lightStart + 3.0).r;
+
+        vec3 lightVec = (lightPosInvCutoff.xyz - worldPos) * lightColorRange.w;
+        float lightDist = length(lightVec);
+        vec3 lightDir = lightVec / lightDist;
+        float atten = clamp(1.0 - lightDist * lightDist, 0.0, 1.0);
+        float spotAtten = clamp((dot(lightDir, lightDirCutoff.xyz) - lightDirCutoff.w) * lightPosInvCutoff.w, 0.0, 1.0);
+        float diff = max(dot(normal, lightDir), 0.0) * atten * spotAtten;
+        float spec = GetSpecular(normal, eyeVec, lightDir, specularPower);
+        lightColor += diff * lightColorRange.rgb * (diffColor + spec * specColor * specIntensity);
+    }
+
+    return lightColor;
+}
+
+#endif
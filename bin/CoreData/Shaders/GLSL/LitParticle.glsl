@@ -45,7 +45,7 @@ void VS()
     #endif
 
     #ifdef VERTEXCOLOR
-        vColor = iColor;
+        vColor = GetVertexColor(iColor);
     #endif
 
     #ifdef PERPIXEL
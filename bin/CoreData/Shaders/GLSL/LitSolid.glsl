@@ -3,6 +3,7 @@
 #include "Transform.glsl"
 #include "ScreenPos.glsl"
 #include "Lighting.glsl"
+#include "ClusteredLighting.glsl"
 #include "Fog.glsl"
 
 #ifdef NORMALMAP
@@ -33,6 +34,9 @@ varying vec4 vWorldPos;
 #else
     varying vec3 vVertexLight;
     varying vec4 vScreenPos;
+    #ifdef CLUSTERED
+        varying vec3 vClusterPos;
+    #endif
     #ifdef ENVCUBEMAP
         varying vec3 vReflectionVec;
     #endif
@@ -50,7 +54,7 @@ void VS()
     vWorldPos = vec4(worldPos, GetDepth(gl_Position));
 
     #ifdef VERTEXCOLOR
-        vColor = iColor;
+        vColor = GetVertexColor(iColor);
     #endif
 
     #ifdef NORMALMAP
@@ -98,6 +102,10 @@ void VS()
         
         vScreenPos = GetScreenPos(gl_Position);
 
+        #ifdef CLUSTERED
+            vClusterPos = gl_Position.xyw;
+        #endif
+
         #ifdef ENVCUBEMAP
             vReflectionVec = worldPos - cCameraPos;
         #endif
@@ -218,6 +226,11 @@ void PS()
             // If using AO, the vertex light ambient is black, calculate occluded ambient here
             finalColor += texture2D(sEmissiveMap, vTexCoord2).rgb * cAmbientColor.rgb * diffColor.rgb;
         #endif
+
+        #ifdef CLUSTERED
+            // Add the per-pixel lights of the pixel's light cluster
+            finalColor += GetClusteredLight(vClusterPos, vWorldPos.xyz, normal, diffColor.rgb, specColor, cMatSpecColor.a);
+        #endif
         
         #ifdef MATERIAL
             // Add light pre-pass accumulation result
@@ -54,7 +54,7 @@ void VS()
     vWorldPos = vec4(worldPos, GetDepth(gl_Position));
 
     #ifdef VERTEXCOLOR
-        vColor = iColor;
+        vColor = GetVertexColor(iColor);
     #endif
 
     #if defined(NORMALMAP) || defined(DIRBILLBOARD)
@@ -24,6 +24,7 @@ uniform samplerCube sLightCubeMap;
     uniform samplerCube sIndirectionCubeMap;
     uniform samplerCube sZoneCubeMap;
     uniform sampler3D sZoneVolumeMap;
+    uniform sampler2D sClusterMap;
 #else
     uniform highp sampler2D sShadowMap;
 #endif
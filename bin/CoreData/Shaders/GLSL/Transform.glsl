@@ -27,7 +27,25 @@ attribute vec4 iCubeTexCoord1;
 #endif
 attribute float iObjectIndex;
 
-#ifdef SKINNED
+#if defined(SKINNED) && defined(INSTANCED)
+// Skin matrices of all instances are in a texture 1024 texels wide, the instance's first texel is in iTexCoord4.x
+uniform sampler2D sSkinMap;
+
+vec4 GetSkinMatrixRow(int texel)
+{
+    return texelFetch(sSkinMap, ivec2(texel % 1024, texel / 1024), 0);
+}
+
+mat4 GetSkinMatrix(vec4 blendWeights, vec4 blendIndices)
+{
+    ivec4 idx = int(iTexCoord4.x) + ivec4(blendIndices) * 3;
+    const vec4 lastColumn = vec4(0.0, 0.0, 0.0, 1.0);
+    return mat4(GetSkinMatrixRow(idx.x), GetSkinMatrixRow(idx.x + 1), GetSkinMatrixRow(idx.x + 2), lastColumn) * blendWeights.x +
+        mat4(GetSkinMatrixRow(idx.y), GetSkinMatrixRow(idx.y + 1), GetSkinMatrixRow(idx.y + 2), lastColumn) * blendWeights.y +
+        mat4(GetSkinMatrixRow(idx.z), GetSkinMatrixRow(idx.z + 1), GetSkinMatrixRow(idx.z + 2), lastColumn) * blendWeights.z +
+        mat4(GetSkinMatrixRow(idx.w), GetSkinMatrixRow(idx.w + 1), GetSkinMatrixRow(idx.w + 2), lastColumn) * blendWeights.w;
+}
+#elif defined(SKINNED)
 mat4 GetSkinMatrix(vec4 blendWeights, vec4 blendIndices)
 {
     ivec4 idx = ivec4(blendIndices) * 3;
@@ -54,6 +72,9 @@ mat3 GetNormalMatrix(mat4 modelMatrix)
 
 vec2 GetTexCoord(vec2 texCoord)
 {
+    #if defined(BILLBOARD) && defined(INSTANCED)
+        texCoord = mix(iTexCoord6.xy, iTexCoord6.zw, texCoord);
+    #endif
     return vec2(dot(texCoord, cUOffset.xy) + cUOffset.w, dot(texCoord, cVOffset.xy) + cVOffset.w);
 }
 
@@ -79,11 +100,32 @@ float GetDepth(vec4 clipPos)
     return dot(clipPos.zw, cDepthMode.zw);
 }
 
-#ifdef BILLBOARD
+#if defined(BILLBOARD) && defined(INSTANCED)
+// Instanced billboards have world position and red & green color in iTexCoord4, size, rotation and blue & alpha color
+// in iTexCoord5 and UV coordinates in iTexCoord6. The vertex size is the direction of the quad corner
+vec3 GetBillboardPos(vec4 iPos, vec2 iSize, mat4 modelMatrix)
+{
+    vec2 size = iSize * iTexCoord5.xy;
+    float s = sin(iTexCoord5.z);
+    float c = cos(iTexCoord5.z);
+    return iTexCoord4.xyz + vec3(size.x * c + size.y * s, size.y * c - size.x * s, 0.0) * cBillboardRot;
+}
+
+vec4 GetBillboardColor()
+{
+    vec2 colors = vec2(iTexCoord4.w, iTexCoord5.w);
+    vec2 high = floor(colors / 4096.0);
+    vec2 low = colors - high * 4096.0;
+    return vec4(high.x, low.x, high.y, low.y) / 4095.0;
+}
+#elif defined(BILLBOARD)
 vec3 GetBillboardPos(vec4 iPos, vec2 iSize, mat4 modelMatrix)
 {
     return (iPos * modelMatrix).xyz + vec3(iSize.x, iSize.y, 0.0) * cBillboardRot;
 }
+#endif
+
+#ifdef BILLBOARD
 
 vec3 GetBillboardNormal()
 {
@@ -148,6 +190,12 @@ vec3 GetTrailNormal(vec4 iPos, vec3 iParentPos, vec3 iForward)
 }
 #endif
 
+#if defined(BILLBOARD) && defined(INSTANCED)
+    #define GetVertexColor(color) GetBillboardColor()
+#else
+    #define GetVertexColor(color) color
+#endif
+
 #if defined(SKINNED)
     #define iModelMatrix GetSkinMatrix(iBlendWeights, iBlendIndices)
 #elif defined(INSTANCED)
@@ -54,6 +54,7 @@ uniform mat4 cZone;
 
 uniform vec4 cAmbientColor;
 uniform vec3 cCameraPosPS;
+uniform vec4 cClusterParams;
 uniform float cDeltaTimePS;
 uniform vec4 cDepthReconstruct;
 uniform float cElapsedTimePS;
@@ -167,6 +168,7 @@ uniform FramePS
 uniform CameraPS
 {
     vec3 cCameraPosPS;
+    vec4 cClusterParams;
     vec4 cDepthReconstruct;
     vec2 cGBufferInvSize;
     float cNearClipPS;
@@ -27,7 +27,7 @@ void VS()
     #endif
 
     #ifdef VERTEXCOLOR
-        vColor = iColor;
+        vColor = GetVertexColor(iColor);
     #endif
 
 }
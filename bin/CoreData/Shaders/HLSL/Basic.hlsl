@@ -45,7 +45,7 @@ void VS(float4 iPos : POSITION,
     #endif
 
     #ifdef VERTEXCOLOR
-        oColor = iColor;
+        oColor = GetVertexColor(iColor);
     #endif
     #ifdef DIFFMAP
         oTexCoord = iTexCoord;
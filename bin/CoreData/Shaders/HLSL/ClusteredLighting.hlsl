@@ -0,0 +1,57 @@
+// Shaders which include this file shade the clustered point and spot lights in their scene passes. Other shaders get
+// the clustered lights as per-light batches instead
+
+#ifdef CLUSTERED
+
+// Cluster grid and cluster texture layout, see LightClusters.h
+#define CLUSTER_TILES_X 16.0
+#define CLUSTER_TILES_Y 8.0
+#define CLUSTER_SLICES 24.0
+#define MAX_LIGHTS_PER_CLUSTER 32
+#define CLUSTER_TEXTURE_WIDTH 1024.0
+#define CLUSTER_TEXTURE_HEIGHT 64.0
+#define CLUSTER_HEADER_START 1024.0
+
+float4 GetClusterTexel(float index)
+{
+    float2 texCoord = float2((fmod(index, CLUSTER_TEXTURE_WIDTH) + 0.5) / CLUSTER_TEXTURE_WIDTH,
+        (floor(index / CLUSTER_TEXTURE_WIDTH) + 0.5) / CLUSTER_TEXTURE_HEIGHT);
+    return Sample2DLod0(ClusterMap, texCoord);
+}
+
+float3 GetClusteredLight(float3 clusterPos, float3 worldPos, float3 normal, float3 diffColor, float3 specColor, float specularPower)
+{
+    // The cluster is found from the clip space XY and the view depth, which is clip space W
+    float2 tile = clamp(floor(clusterPos.xy / clusterPos.z * cClusterParams.xy + abs(cClusterParams.xy)), 0.0,
+        float2(CLUSTER_TILES_X - 1.0, CLUSTER_TILES_Y - 1.0));
+    float slice = clamp(floor(log(clusterPos.z) * cClusterParams.z + cClusterParams.w), 0.0, CLUSTER_SLICES - 1.0);
+    float4 cluster = GetClusterTexel(CLUSTER_HEADER_START + (slice * CLUSTER_TILES_Y + tile.y) * CLUSTER_TILES_X + tile.x);
+
+    float3 eyeVec = cCameraPosPS - worldPos;
+    float3 lightColor = 0.0;
+    for (int i = 0; i < MAX_LIGHTS_PER_CLUSTER; ++i)
+    {
+        if (i >= cluster.y)
+            break;
+
+        // Light data is laid out as the vertex lights, followed by the specular intensity
+        float lightStart = GetClusterTexel(cluster.x + i).r * 4.0;
+        float4 lightColorRange = GetClusterTexel(lightStart);
+        float4 lightDirCutoff = GetClusterTexel(lightStart + 1.0);
+        float4 lightPosInvCutoff = GetClusterTexel(lightStart + 2.0);
+        float specIntensity = GetClusterTexel(lightStart + 3.0).r;
+
+        float3 lightVec = (lightPosInvCutoff.xyz - worldPos) * lightColorRange.w;
+        float lightDist = length(lightVec);
+        float3 lightDir = lightVec / lightDist;
+        float atten = saturate(1.0 - lightDist * lightDist);
+        float spotAtten = saturate((dot(lightDir, lightDirCutoff.xyz) - lightDirCutoff.w) * lightPosInvCutoff.w);
+        float diff = saturate(dot(normal, lightDir)) * atten * spotAtten;
+        float spec = GetSpecular(normal, eyeVec, lightDir, specularPower);
+        lightColor += diff * lightColorRange.rgb * (diffColor + spec * specColor * specIntensity);
+    }
+
+    return lightColor;
+}
+
+#endif
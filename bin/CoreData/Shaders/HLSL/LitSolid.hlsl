@@ -3,6 +3,7 @@
 #include "Transform.hlsl"
 #include "ScreenPos.hlsl"
 #include "Lighting.hlsl"
+#include "ClusteredLighting.hlsl"
 #include "Fog.hlsl"
 
 void VS(float4 iPos : POSITION,
@@ -52,6 +53,9 @@ void VS(float4 iPos : POSITION,
     #else
         out float3 oVertexLight : TEXCOORD4,
         out float4 oScreenPos : TEXCOORD5,
+        #ifdef CLUSTERED
+            out float3 oClusterPos : TEXCOORD8,
+        #endif
         #ifdef ENVCUBEMAP
             out float3 oReflectionVec : TEXCOORD6,
         #endif
@@ -83,7 +87,7 @@ void VS(float4 iPos : POSITION,
     #endif
 
     #ifdef VERTEXCOLOR
-        oColor = iColor;
+        oColor = GetVertexColor(iColor);
     #endif
 
     #ifdef NORMALMAP
@@ -130,6 +134,10 @@ void VS(float4 iPos : POSITION,
         
         oScreenPos = GetScreenPos(oPos);
 
+        #ifdef CLUSTERED
+            oClusterPos = oPos.xyw;
+        #endif
+
         #ifdef ENVCUBEMAP
             oReflectionVec = worldPos - cCameraPos;
         #endif
@@ -158,6 +166,9 @@ void PS(
     #else
         float3 iVertexLight : TEXCOORD4,
         float4 iScreenPos : TEXCOORD5,
+        #ifdef CLUSTERED
+            float3 iClusterPos : TEXCOORD8,
+        #endif
         #ifdef ENVCUBEMAP
             float3 iReflectionVec : TEXCOORD6,
         #endif
@@ -293,6 +304,11 @@ void PS(
             finalColor += Sample2D(EmissiveMap, iTexCoord2).rgb * cAmbientColor.rgb * diffColor.rgb;
         #endif
 
+        #ifdef CLUSTERED
+            // Add the per-pixel lights of the pixel's light cluster
+            finalColor += GetClusteredLight(iClusterPos, iWorldPos.xyz, normal, diffColor.rgb, specColor, cMatSpecColor.a);
+        #endif
+
         #ifdef MATERIAL
             // Add light pre-pass accumulation result
             // Lights are accumulated at half intensity. Bring back to full intensity now
@@ -86,7 +86,7 @@ void VS(float4 iPos : POSITION,
     #endif
 
     #ifdef VERTEXCOLOR
-        oColor = iColor;
+        oColor = GetVertexColor(iColor);
     #endif
 
     #if defined(NORMALMAP)
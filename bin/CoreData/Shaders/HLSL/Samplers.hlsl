@@ -34,6 +34,7 @@ sampler2D sDepthBuffer : register(s13);
 sampler2D sLightBuffer : register(s14);
 samplerCUBE sZoneCubeMap : register(s15);
 sampler3D sZoneVolumeMap : register(s15);
+sampler2D sClusterMap : register(s8);
 
 #define Sample2D(tex, uv) tex2D(s##tex, uv)
 #define Sample2DProj(tex, uv) tex2Dproj(s##tex, uv)
@@ -67,6 +68,7 @@ Texture2D tDepthBuffer : register(t13);
 Texture2D tLightBuffer : register(t14);
 TextureCube tZoneCubeMap : register(t15);
 Texture3D tZoneVolumeMap : register(t15);
+Texture2D tClusterMap : register(t8);
 
 SamplerState sDiffMap : register(s0);
 SamplerState sDiffCubeMap : register(s0);
@@ -93,6 +95,7 @@ SamplerState sDepthBuffer : register(s13);
 SamplerState sLightBuffer : register(s14);
 SamplerState sZoneCubeMap : register(s15);
 SamplerState sZoneVolumeMap : register(s15);
+SamplerState sClusterMap : register(s8);
 
 #endif
 
@@ -16,11 +16,37 @@ float4x3 GetSkinMatrix(float4 blendWeights, int4 blendIndices)
 }
 #endif
 
+#if defined(SKINNED) && defined(INSTANCED) && defined(D3D11)
+// Skin matrices of all instances are in a texture 1024 texels wide, the instance's first texel is in the instance data
+Texture2D tSkinMap : register(t13);
+
+float4x3 GetTexelSkinMatrix(int texel)
+{
+    float4 row0 = tSkinMap.Load(int3(texel % 1024, texel / 1024, 0));
+    float4 row1 = tSkinMap.Load(int3((texel + 1) % 1024, (texel + 1) / 1024, 0));
+    float4 row2 = tSkinMap.Load(int3((texel + 2) % 1024, (texel + 2) / 1024, 0));
+    return transpose(float3x4(row0, row1, row2));
+}
+
+float4x3 GetInstanceSkinMatrix(float4 blendWeights, int4 blendIndices, int firstTexel)
+{
+    int4 idx = firstTexel + blendIndices * 3;
+    return GetTexelSkinMatrix(idx.x) * blendWeights.x +
+        GetTexelSkinMatrix(idx.y) * blendWeights.y +
+        GetTexelSkinMatrix(idx.z) * blendWeights.z +
+        GetTexelSkinMatrix(idx.w) * blendWeights.w;
+}
+#endif
+
 float2 GetTexCoord(float2 iTexCoord)
 {
     return float2(dot(iTexCoord, cUOffset.xy) + cUOffset.w, dot(iTexCoord, cVOffset.xy) + cVOffset.w);
 };
 
+#if defined(BILLBOARD) && defined(INSTANCED)
+    #define GetTexCoord(texCoord) GetTexCoord(lerp(transpose(iModelInstance)[2].xy, transpose(iModelInstance)[2].zw, texCoord))
+#endif
+
 float4 GetClipPos(float3 worldPos)
 {
     return mul(float4(worldPos, 1.0), cViewProj);
@@ -36,6 +62,28 @@ float GetDepth(float4 clipPos)
     return dot(clipPos.zw, cDepthMode.zw);
 }
 
+#if defined(BILLBOARD) && defined(INSTANCED)
+// Instanced billboards have world position and red & green color in the first instance data row, size, rotation and
+// blue & alpha color in the second and UV coordinates in the third. The vertex size is the direction of the quad corner
+float3 GetInstancedBillboardPos(float2 iSize, float4x3 instance)
+{
+    float3x4 data = transpose(instance);
+    float2 size = iSize * data[1].xy;
+    float s, c;
+    sincos(data[1].z, s, c);
+    return data[0].xyz + mul(float3(size.x * c + size.y * s, size.y * c - size.x * s, 0.0), cBillboardRot);
+}
+
+float4 GetInstancedBillboardColor(float4x3 instance)
+{
+    float3x4 data = transpose(instance);
+    float2 colors = float2(data[0].w, data[1].w);
+    float2 high = floor(colors / 4096.0);
+    float2 low = colors - high * 4096.0;
+    return float4(high.x, low.x, high.y, low.y) / 4095.0;
+}
+#endif
+
 #ifdef BILLBOARD
 float3 GetBillboardPos(float4 iPos, float2 iSize, float4x3 modelMatrix)
 {
@@ -105,7 +153,9 @@ float3 GetTrailNormal(float4 iPos, float3 iParentPos, float3 iForward)
 }
 #endif
 
-#if defined(SKINNED)
+#if defined(SKINNED) && defined(INSTANCED) && defined(D3D11)
+    #define iModelMatrix GetInstanceSkinMatrix(iBlendWeights, iBlendIndices, (int)iModelInstance[0][0])
+#elif defined(SKINNED)
     #define iModelMatrix GetSkinMatrix(iBlendWeights, iBlendIndices)
 #elif defined(INSTANCED)
     #define iModelMatrix iModelInstance
@@ -113,7 +163,9 @@ float3 GetTrailNormal(float4 iPos, float3 iParentPos, float3 iForward)
     #define iModelMatrix cModel
 #endif
 
-#if defined(BILLBOARD)
+#if defined(BILLBOARD) && defined(INSTANCED)
+    #define GetWorldPos(modelMatrix) GetInstancedBillboardPos(iSize, iModelInstance)
+#elif defined(BILLBOARD)
     #define GetWorldPos(modelMatrix) GetBillboardPos(iPos, iSize, modelMatrix)
 #elif defined(DIRBILLBOARD)
     #define GetWorldPos(modelMatrix) GetBillboardPos(iPos, iSize, iNormal, modelMatrix)
@@ -145,6 +197,12 @@ float3 GetTrailNormal(float4 iPos, float3 iParentPos, float3 iForward)
     #define GetWorldTangent(modelMatrix) float4(normalize(mul(iTangent.xyz, (float3x3)modelMatrix)), iTangent.w)
 #endif
 
+#if defined(BILLBOARD) && defined(INSTANCED)
+    #define GetVertexColor(color) GetInstancedBillboardColor(iModelInstance)
+#else
+    #define GetVertexColor(color) color
+#endif
+
 #endif
 
 #ifdef COMPILEPS
@@ -43,6 +43,7 @@ uniform float4x3 cZone;
 // Pixel shader uniforms
 uniform float4 cAmbientColor;
 uniform float3 cCameraPosPS;
+uniform float4 cClusterParams;
 uniform float cDeltaTimePS;
 uniform float4 cDepthReconstruct;
 uniform float cElapsedTimePS;
@@ -156,6 +157,7 @@ cbuffer FramePS : register(b0)
 cbuffer CameraPS : register(b1)
 {
     float3 cCameraPosPS;
+    float4 cClusterParams;
     float4 cDepthReconstruct;
     float2 cGBufferInvSize;
     float cNearClipPS;
@@ -52,7 +52,7 @@ void VS(float4 iPos : POSITION,
     #endif
     
     #ifdef VERTEXCOLOR
-        oColor = iColor;
+        oColor = GetVertexColor(iColor);
     #endif
 }
 